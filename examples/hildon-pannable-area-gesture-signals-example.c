@@ -81,6 +81,23 @@ vertical_movement (HildonPannableArea *area,
   g_print ("vertical_movement: %lf, %lf\n", x, y);
 }
 
+static void
+gesture_begin (HildonPannableArea *area,
+               HildonMovementDirection direction,
+               gdouble velocity,
+               gpointer user_data)
+{
+  g_print ("gesture_begin: direction %d, %lf px/s\n", direction, velocity);
+}
+
+static void
+gesture_cancel (HildonPannableArea *area,
+                HildonMovementDirection direction,
+                gpointer user_data)
+{
+  g_print ("gesture_cancel: direction %d\n", direction);
+}
+
 static void
 get_sawtooth_label (gchar **label, guint num)
 {
@@ -170,6 +187,8 @@ main (int argc, char **argv)
 
     g_signal_connect (G_OBJECT (panarea), "horizontal_movement", G_CALLBACK (horizontal_movement), col);
     g_signal_connect (G_OBJECT (panarea), "vertical_movement", G_CALLBACK (vertical_movement), NULL);
+    g_signal_connect (G_OBJECT (panarea), "gesture-begin", G_CALLBACK (gesture_begin), NULL);
+    g_signal_connect (G_OBJECT (panarea), "gesture-cancel", G_CALLBACK (gesture_cancel), NULL);
 
     gtk_widget_show_all (GTK_WIDGET (window));
 
@@ -0,0 +1,125 @@
+/*
+ * This file is a part of hildon examples
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include                                        <hildon/hildon.h>
+
+#define                                         N_ROWS 10000
+
+enum
+{
+    NAME_COLUMN,
+    ACTIVE_COLUMN
+};
+
+/* The check buttons show a different row each time they are bound, so
+ * their state is kept in the model */
+static void
+button_toggled_cb                               (HildonCheckButton *button,
+                                                 GtkListStore      *store)
+{
+    GtkTreeIter iter;
+    gint row = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (button), "row"));
+
+    if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, row))
+        gtk_list_store_set (store, &iter,
+                            ACTIVE_COLUMN, hildon_check_button_get_active (button),
+                            -1);
+}
+
+static GtkWidget *
+create_row                                      (HildonRecyclerList *list,
+                                                 gpointer            data)
+{
+    GtkWidget *button = hildon_check_button_new (HILDON_SIZE_FINGER_HEIGHT);
+
+    g_signal_connect (button, "toggled", G_CALLBACK (button_toggled_cb), data);
+
+    return button;
+}
+
+static void
+bind_row                                        (HildonRecyclerList *list,
+                                                 GtkWidget          *row,
+                                                 GtkTreeModel       *model,
+                                                 GtkTreeIter        *iter,
+                                                 gpointer            data)
+{
+    GtkTreePath *path = gtk_tree_model_get_path (model, iter);
+    gchar *name;
+    gboolean active;
+
+    gtk_tree_model_get (model, iter, NAME_COLUMN, &name, ACTIVE_COLUMN, &active, -1);
+
+    g_signal_handlers_block_by_func (row, button_toggled_cb, data);
+    g_object_set_data (G_OBJECT (row), "row",
+                       GINT_TO_POINTER (gtk_tree_path_get_indices (path)[0]));
+    gtk_button_set_label (GTK_BUTTON (row), name);
+    hildon_check_button_set_active (HILDON_CHECK_BUTTON (row), active);
+    g_signal_handlers_unblock_by_func (row, button_toggled_cb, data);
+
+    g_free (name);
+    gtk_tree_path_free (path);
+}
+
+int
+main                                            (int    argc,
+                                                 char **argv)
+{
+    GtkWidget *window;
+    GtkWidget *area;
+    GtkWidget *list;
+    GtkListStore *store;
+    int i;
+
+    hildon_gtk_init (&argc, &argv);
+
+    store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_BOOLEAN);
+    for (i = 0; i < N_ROWS; i++) {
+        gchar *name = g_strdup_printf ("Option %d", i + 1);
+        gtk_list_store_insert_with_values (store, NULL, i,
+                                           NAME_COLUMN, name,
+                                           ACTIVE_COLUMN, i % 3 == 0,
+                                           -1);
+        g_free (name);
+    }
+
+    window = hildon_stackable_window_new ();
+    gtk_window_set_title (GTK_WINDOW (window), "Hildon recycler list example");
+
+    list = hildon_recycler_list_new (GTK_TREE_MODEL (store), 70);
+    hildon_recycler_list_set_row_funcs (HILDON_RECYCLER_LIST (list),
+                                        create_row, bind_row, store, NULL);
+
+    area = hildon_pannable_area_new ();
+    gtk_container_add (GTK_CONTAINER (area), list);
+    gtk_container_add (GTK_CONTAINER (window), area);
+
+    g_signal_connect (window, "delete_event", G_CALLBACK (gtk_main_quit), NULL);
+
+    gtk_widget_show_all (window);
+
+    gtk_main ();
+
+    g_object_unref (store);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * This file is a part of hildon examples
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Usage: hildon-tile-grid-example [DIRECTORY]
+ *
+ * Shows N_ITEMS tiles, with thumbnails of the files of DIRECTORY
+ * repeated over the grid if one is given.
+ */
+
+#include                                        <hildon/hildon.h>
+
+#define                                         N_ITEMS 20000
+
+enum
+{
+    NAME_COLUMN,
+    FILENAME_COLUMN
+};
+
+static void
+item_activated_cb                               (HildonTileGrid *grid,
+                                                 GtkTreePath    *path,
+                                                 gpointer        data)
+{
+    g_print ("Item %d activated\n", gtk_tree_path_get_indices (path)[0]);
+}
+
+static GPtrArray *
+list_files                                      (const gchar *dirname)
+{
+    GPtrArray *files = g_ptr_array_new_with_free_func (g_free);
+    const gchar *name;
+    GDir *dir;
+
+    dir = g_dir_open (dirname, 0, NULL);
+    if (dir == NULL)
+        return files;
+
+    while ((name = g_dir_read_name (dir)) != NULL)
+        g_ptr_array_add (files, g_build_filename (dirname, name, NULL));
+
+    g_dir_close (dir);
+
+    return files;
+}
+
+int
+main                                            (int    argc,
+                                                 char **argv)
+{
+    GtkWidget *window;
+    GtkWidget *area;
+    GtkWidget *grid;
+    GtkListStore *store;
+    HildonThumbnailLoader *loader;
+    GPtrArray *files;
+    int i;
+
+    hildon_gtk_init (&argc, &argv);
+
+    files = argc > 1 ? list_files (argv[1]) : g_ptr_array_new ();
+
+    store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
+    for (i = 0; i < N_ITEMS; i++) {
+        gchar *name = g_strdup_printf ("Item %d", i + 1);
+        gtk_list_store_insert_with_values (store, NULL, i,
+                                           NAME_COLUMN, name,
+                                           FILENAME_COLUMN, files->len > 0 ?
+                                               g_ptr_array_index (files, i % files->len) : NULL,
+                                           -1);
+        g_free (name);
+    }
+    g_ptr_array_free (files, TRUE);
+
+    window = hildon_stackable_window_new ();
+    gtk_window_set_title (GTK_WINDOW (window), "Hildon tile grid example");
+
+    loader = hildon_thumbnail_loader_new (120, 8 * 1024 * 1024);
+
+    grid = hildon_tile_grid_new (GTK_TREE_MODEL (store), 160, 160);
+    hildon_tile_grid_set_text_column (HILDON_TILE_GRID (grid), NAME_COLUMN);
+    hildon_tile_grid_set_filename_column (HILDON_TILE_GRID (grid), FILENAME_COLUMN);
+    hildon_tile_grid_set_thumbnail_loader (HILDON_TILE_GRID (grid), loader);
+    g_signal_connect (grid, "item-activated", G_CALLBACK (item_activated_cb), NULL);
+
+    area = hildon_pannable_area_new ();
+    gtk_container_add (GTK_CONTAINER (area), grid);
+    gtk_container_add (GTK_CONTAINER (window), area);
+    hildon_thumbnail_loader_set_pannable_area (loader, HILDON_PANNABLE_AREA (area));
+
+    g_signal_connect (window, "delete_event", G_CALLBACK (gtk_main_quit), NULL);
+
+    gtk_widget_show_all (window);
+
+    gtk_main ();
+
+    g_object_unref (loader);
+    g_object_unref (store);
+
+    return 0;
+}
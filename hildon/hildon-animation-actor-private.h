@@ -33,6 +33,21 @@ typedef struct                                  _HildonAnimationActorPrivate Hil
                                                 (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
                                                 HILDON_TYPE_ANIMATION_ACTOR, HildonAnimationActorPrivate));
 
+/* Messages whose last sent arguments are remembered, so that
+ * resending the same values can be skipped */
+typedef enum
+{
+    HILDON_AA_SENT_SHOW,
+    HILDON_AA_SENT_POSITION,
+    HILDON_AA_SENT_ROTATION_X,
+    HILDON_AA_SENT_ROTATION_Y,
+    HILDON_AA_SENT_ROTATION_Z,
+    HILDON_AA_SENT_SCALE,
+    HILDON_AA_SENT_ANCHOR,
+    HILDON_AA_SENT_PARENT,
+    HILDON_AA_N_SENT
+} HildonAnimationActorSentMessage;
+
 struct                                          _HildonAnimationActorPrivate
 {
     guint      ready : 1;
@@ -44,6 +59,8 @@ struct                                          _HildonAnimationActorPrivate
     guint      set_anchor : 1;
     guint      set_parent : 1;
 
+    guint      batch_depth;
+
     gboolean   show;
     guint      opacity;
 
@@ -73,9 +90,20 @@ struct                                          _HildonAnimationActorPrivate
     GtkWindow *parent;
     gulong     parent_map_event_cb_id;
 
-    gulong     map_event_cb_id;
+    guint32    sent[HILDON_AA_N_SENT][5];
+    guint      sent_valid;
+    guint      threaded;
+
+    GArray    *keyframes;
+    HildonAnimationActorKeyframe timeline_origin;
+    GtkWidget *timeline_widget;
+    guint      timeline_tick_id;
+    gint64     timeline_start;
 };
 
+gboolean
+hildon_animation_actor_commit_update_unflushed (HildonAnimationActor *self);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_ANIMATION_ACTOR_PRIVATE_H__ */
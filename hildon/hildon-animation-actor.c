@@ -68,49 +68,22 @@
  * transformed by the window manager using ClientMessage X11
  * events. It tries to minimize the amount of such events and couples
  * conceptually related parameters (visibility and opacity, position
- * and depth) to the same message.  The API, however, offers
+ * and depth) to the same message, and does not resend a setting the
+ * window manager already has.  The API, however, offers
  * convenience functions for the programmer to be able to modify every
  * parameter individually.
  *
  * <example>
  * <title>Basic HildonAnimationActor example</title>
  * <programlisting>
- * static void
- * animation_cb (void *obj)
- * {
- *     HildonAnimationActor *actor = HILDON_ANIMATION_ACTOR (obj);
- * <!-- -->
- *     static int x_inc = 1;
- *     static int y_inc = 1;
- *     static int x = 0;
- *     static int y = 0;
- *     static int r = 0;
- * <!-- -->
- *     if (((x_inc > 0) && (x > 800)) ||
- *         ((x_inc < 0) && (x < 1)))
- *         x_inc = -x_inc;
- *     if (((y_inc > 0) && (y > 480)) ||
- *         ((y_inc < 0) && (y < 1)))
- *         y_inc = -y_inc;
- * <!-- -->
- *     x += x_inc;
- *     y += y_inc;
- *     r ++;
- * <!-- -->
- *     // Set animation actor position and rotation
- *     hildon_animation_actor_set_position (actor, x, y);
- *     hildon_animation_actor_set_rotation (actor,
- *                                          HILDON_AA_Z_AXIS,
- *                                          r,
- *                                          0, 0, 0);
- * }
- * <!-- -->
  * int
  * main (int argc, char **argv)
  * {
  *     GtkWidget *win;
  *     GtkWidget *image;
  *     GtkWidget *actor;
+ *     HildonAnimationActorKeyframe move = { 0 };
+ *     HildonAnimationActorKeyframe fade = { 0 };
  * <!-- -->
  *     gtk_init (&amp;argc, &amp;argv);
  * <!-- -->
@@ -134,8 +107,22 @@
  * <!-- -->
  *     gtk_widget_show_all (actor);
  * <!-- -->
- *     // Set up animation
- *     g_timeout_add (100, (GSourceFunc)animation_cb, actor);
+ *     // Set up animation: move across the window while spinning,
+ *     // then fade out
+ *     move.time = 2000;
+ *     move.flags = HILDON_AA_KEYFRAME_POSITION | HILDON_AA_KEYFRAME_ROTATION_Z;
+ *     move.easing = HILDON_AA_EASE_IN_OUT;
+ *     move.x = 800;
+ *     move.y = 480;
+ *     move.rotation[HILDON_AA_Z_AXIS] = 360;
+ *     hildon_animation_actor_add_keyframe (HILDON_ANIMATION_ACTOR (actor), &amp;move);
+ * <!-- -->
+ *     fade.time = 2500;
+ *     fade.flags = HILDON_AA_KEYFRAME_OPACITY;
+ *     fade.opacity = 0;
+ *     hildon_animation_actor_add_keyframe (HILDON_ANIMATION_ACTOR (actor), &amp;fade);
+ * <!-- -->
+ *     hildon_animation_actor_start_timeline (HILDON_ANIMATION_ACTOR (actor));
  * <!-- -->
  *     gtk_main ();
  * <!-- -->
@@ -147,18 +134,25 @@
 
 #include                                        <gdk/gdkx.h>
 #include                                        <X11/Xatom.h>
+#include                                        <math.h>
 
 #include                                        "hildon-animation-actor.h"
 #include                                        "hildon-animation-actor-private.h"
+#include                                        "hildon-private.h"
 
 G_DEFINE_TYPE (HildonAnimationActor, hildon_animation_actor, GTK_TYPE_WINDOW);
 
-static GdkFilterReturn
-hildon_animation_actor_event_filter (GdkXEvent *xevent,
-                                     GdkEvent *event,
-                                     gpointer data);
+enum
+{
+    TIMELINE_FINISHED,
+    LAST_SIGNAL
+};
+
+static guint actor_signals[LAST_SIGNAL] = { 0 };
+
 static void
-hildon_animation_actor_update_ready (HildonAnimationActor *self);
+hildon_animation_actor_ready_changed (GtkWidget *widget,
+                                      gboolean ready);
 static void
 hildon_animation_actor_send_pending_messages (HildonAnimationActor *self);
 static void
@@ -167,10 +161,10 @@ static gboolean
 hildon_animation_actor_parent_map_event (GtkWidget *parent,
 					 GdkEvent *event,
 					 gpointer user_data);
-static gboolean
-hildon_animation_actor_map_event (GtkWidget *widget,
-				  GdkEvent *event,
-				  gpointer user_data);
+static void
+hildon_animation_actor_timeline_attach (HildonAnimationActor *self);
+static void
+hildon_animation_actor_timeline_detach (HildonAnimationActor *self);
 
 static guint32 show_atom;
 static guint32 position_atom;
@@ -178,7 +172,6 @@ static guint32 rotation_atom;
 static guint32 scale_atom;
 static guint32 anchor_atom;
 static guint32 parent_atom;
-static guint32 ready_atom;
 
 static gboolean atoms_initialized = FALSE;
 
@@ -225,9 +218,6 @@ hildon_animation_actor_realize                 (GtkWidget *widget)
 	parent_atom =
 	    gdk_x11_get_xatom_by_name_for_display
 	    (display, "_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT");
-	ready_atom =
-	    gdk_x11_get_xatom_by_name_for_display
-	    (display, "_HILDON_ANIMATION_CLIENT_READY");
 #if 0
 	g_debug ("show atom = %lu\n", show_atom);
 	g_debug ("position atom = %lu\n", position_atom);
@@ -235,7 +225,6 @@ hildon_animation_actor_realize                 (GtkWidget *widget)
 	g_debug ("scale atom = %lu\n", scale_atom);
 	g_debug ("anchor atom = %lu\n", anchor_atom);
 	g_debug ("parent atom = %lu\n", parent_atom);
-	g_debug ("ready atom = %lu\n", ready_atom);
 #endif
 
 	atoms_initialized = TRUE;
@@ -243,17 +232,20 @@ hildon_animation_actor_realize                 (GtkWidget *widget)
 
     /* Wait for a ready message */
 
-    gdk_window_add_filter (gtk_widget_get_window (widget),
-			   hildon_animation_actor_event_filter,
-			   widget);
+    hildon_watch_ready (widget, "_HILDON_ANIMATION_CLIENT_READY",
+			hildon_animation_actor_ready_changed);
 }
 
 static void
 hildon_animation_actor_unrealize               (GtkWidget *widget)
 {
-    gdk_window_remove_filter (gtk_widget_get_window (widget),
-			      hildon_animation_actor_event_filter,
-			      widget);
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (widget);
+
+    priv->sent_valid = 0;
+    priv->threaded = 0;
+
+    hildon_unwatch_ready (widget);
 
     GTK_WIDGET_CLASS (hildon_animation_actor_parent_class)->unrealize (widget);
 }
@@ -283,6 +275,9 @@ hildon_animation_actor_finalize                (GObject *object)
     HildonAnimationActorPrivate
 	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
 
+    hildon_animation_actor_timeline_detach (self);
+    g_array_free (priv->keyframes, TRUE);
+
     if (priv->parent)
     {
 	if (priv->parent_map_event_cb_id)
@@ -308,6 +303,24 @@ hildon_animation_actor_class_init              (HildonAnimationActorClass *klass
     widget_class->show              = hildon_animation_actor_show;
     widget_class->hide              = hildon_animation_actor_hide;
 
+    /**
+     * HildonAnimationActor::timeline-finished:
+     * @actor: the #HildonAnimationActor that received the signal
+     *
+     * Emitted when the timeline started with
+     * hildon_animation_actor_start_timeline() has reached its last
+     * keyframe.
+     *
+     * Since: 3.0
+     */
+    actor_signals[TIMELINE_FINISHED] =
+	g_signal_new ("timeline-finished",
+		      G_TYPE_FROM_CLASS (klass),
+		      G_SIGNAL_RUN_LAST,
+		      0, NULL, NULL,
+		      g_cclosure_marshal_VOID__VOID,
+		      G_TYPE_NONE, 0);
+
     g_type_class_add_private (klass, sizeof (HildonAnimationActorPrivate));
 }
 
@@ -322,6 +335,9 @@ hildon_animation_actor_init                    (HildonAnimationActor *self)
     priv->scale_x = 1 << 16;
     priv->scale_y = 1 << 16;
     priv->opacity = 0xff;
+
+    priv->keyframes = g_array_new (FALSE, FALSE,
+				   sizeof (HildonAnimationActorKeyframe));
 }
 
 /**
@@ -344,76 +360,19 @@ hildon_animation_actor_new                     (void)
 }
 
 /*
- * An filter for GDK X11 events, waiting for PropertyNotify (window property
- * changes) events, keeping track of animation actor ready atom.
- * Having the ready atom set on the window by the window manager will trigger
- * updates of actor parameters (position/rotation/etc...) to be sent off
- * to the window manager for processing.
- */
-static GdkFilterReturn
-hildon_animation_actor_event_filter             (GdkXEvent *xevent,
-						 GdkEvent *event,
-						 gpointer data)
-{
-    HildonAnimationActor *self = HILDON_ANIMATION_ACTOR (data);
-    XAnyEvent *any = xevent;
-
-    if (any->type == PropertyNotify)
-    {
-	XPropertyEvent *property = xevent;
-
-	if (property->atom == ready_atom)
-	{
-	    hildon_animation_actor_update_ready (self);
-	}
-    }
-
-    return GDK_FILTER_CONTINUE;
-}
-
-/*
- * Check for the ready atom on the animation actor X11 window.
- * If present, send all pending animation actor messages to the
- * window manager.
+ * Called with the state of the ready property, which the window manager
+ * sets on the animation actor window once it is ready for its messages.
+ * Becoming ready sends off all the pending messages.
  */
 static void
-hildon_animation_actor_update_ready (HildonAnimationActor *self)
+hildon_animation_actor_ready_changed (GtkWidget *widget,
+                                      gboolean ready)
 {
+    HildonAnimationActor *self = HILDON_ANIMATION_ACTOR (widget);
     HildonAnimationActorPrivate
 	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
-    GtkWidget          *widget = GTK_WIDGET (self);
-    Display            *display = GDK_WINDOW_XDISPLAY (gtk_widget_get_window (widget));
-    Window              window = GDK_WINDOW_XID (gtk_widget_get_window (widget));
-
-    int status;
-    gint xerror;
-
-    Atom actual_type;
-    int  actual_format;
-    unsigned long nitems, bytes_after;
-    unsigned char *prop = NULL;
-
-    /* Check for the "ready" property */
-
-    gdk_error_trap_push ();
-    status = XGetWindowProperty (display, window,
-				 ready_atom, 0, 32,
-				 False, XA_ATOM,
-				 &actual_type, &actual_format,
-				 &nitems, &bytes_after, &prop);
-    xerror = gdk_error_trap_pop();
-
-    if (prop)
-    {
-	/* We do not actually use the property value for anything,
-	 * it is enough that the property is set. */
-
-	XFree (prop);
-    }
 
-    if (xerror ||
-	(status != Success) || (actual_type != XA_ATOM) ||
-       	(actual_format != 32) || (nitems != 1))
+    if (!ready)
     {
 	priv->ready = 0;
 	return;
@@ -422,26 +381,17 @@ hildon_animation_actor_update_ready (HildonAnimationActor *self)
     if (priv->ready)
     {
 	/* The ready flag has been set once already. This means that
-	 * the WM has restarted. Trigger re-mapping of the widget to
-	 * update the texture actor first. Then push all animation
-	 * actor settings anew. */
+	 * the WM has restarted and lost the state of the animation actor:
+	 * push all of its settings anew. */
 
-	priv->map_event_cb_id =
-	    g_signal_connect (G_OBJECT (self),
-			      "map-event",
-			      G_CALLBACK(hildon_animation_actor_map_event),
-			      self);
-
-	if (gtk_widget_get_mapped (GTK_WIDGET (self)))
-	{
-	    gtk_widget_unmap (GTK_WIDGET (self));
-	    gtk_widget_map (GTK_WIDGET (self));
-	}
+	hildon_queue_resync (widget,
+			     (HildonResyncFunc) hildon_animation_actor_send_all_messages);
 
 	return;
     }
 
     priv->ready = 1;
+    priv->sent_valid = 0;
 
     /* Send all pending messages */
 
@@ -515,6 +465,10 @@ hildon_animation_actor_send_all_messages (HildonAnimationActor *self)
     HildonAnimationActorPrivate
 	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
 
+    /* The window manager lost the state of the actor, resend everything */
+
+    priv->sent_valid = 0;
+
     priv->set_anchor = 1;
     priv->set_position = 1;
     priv->set_rotation = (1 << HILDON_AA_X_AXIS) |
@@ -529,6 +483,40 @@ hildon_animation_actor_send_all_messages (HildonAnimationActor *self)
 
 /* ------------------------------------------------------------- */
 
+/* Messages setting a state give its @slot, or -1, so that the next
+ * message for the same state replaces them, see hildon_compositor_send() */
+static void
+hildon_animation_actor_queue_message (HildonAnimationActor *self,
+                                     guint32 message_type,
+                                     gint slot,
+                                     guint32 l0,
+                                     guint32 l1,
+                                     guint32 l2,
+                                     guint32 l3,
+                                     guint32 l4)
+{
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    HILDON_PERF (ANIMATION_ACTOR_MESSAGES);
+
+    /* Until the window manager was told to show or hide the window,
+     * its messages go out on the connection of GDK, after the requests
+     * that create and map the windows they refer to, and in order with
+     * each other, so that the first frame has the whole state. Later
+     * ones may go through the compositor thread */
+    if (priv->threaded) {
+        hildon_compositor_send (GTK_WIDGET (self), message_type, slot,
+                                l0, l1, l2, l3, l4);
+        return;
+    }
+
+    hildon_compositor_send_direct (GTK_WIDGET (self), message_type,
+                                   l0, l1, l2, l3, l4);
+    if (slot == HILDON_AA_SENT_SHOW)
+        priv->threaded = 1;
+}
+
 /**
  * hildon_animation_actor_send_message:
  * @self: A #HildonAnimationActor
@@ -557,45 +545,41 @@ hildon_animation_actor_send_message (HildonAnimationActor *self,
                                      guint32 l3,
                                      guint32 l4)
 {
-    GtkWidget          *widget = GTK_WIDGET (self);
-    Display            *display = GDK_WINDOW_XDISPLAY (gtk_widget_get_window (widget));
-    Window              window = GDK_WINDOW_XID (gtk_widget_get_window (widget));
-#if 0
-    XClientMessageEvent event;
-
-    event.type = ClientMessage;
-    event.window = window;
-    event.message_type = (Atom)message_type;
-    event.format = 32;
-    event.data.l[0] = l0;
-    event.data.l[1] = l1;
-    event.data.l[2] = l2;
-    event.data.l[3] = l3;
-    event.data.l[4] = l4;
-#else
-    XEvent event = { 0 };
-
-    event.xclient.type = ClientMessage;
-    event.xclient.window = window;
-    event.xclient.message_type = (Atom)message_type;
-    event.xclient.format = 32;
-    event.xclient.data.l[0] = l0;
-    event.xclient.data.l[1] = l1;
-    event.xclient.data.l[2] = l2;
-    event.xclient.data.l[3] = l3;
-    event.xclient.data.l[4] = l4;
-#endif
+    hildon_animation_actor_queue_message (self, message_type, -1, l0, l1, l2, l3, l4);
+}
 
-#if 0
-    g_debug ("%lu (%lu %lu %lu %lu %lu) -> %lu\n",
-             message_type,
-             l0, l1, l2, l3, l4,
-             window);
-#endif
+/*
+ * Sends a message to the window manager, unless @slot holds the same
+ * arguments from the previous message of that kind: the window manager
+ * already has that state, and resending it would only cost X traffic.
+ */
+static void
+hildon_animation_actor_send_property (HildonAnimationActor *self,
+                                      HildonAnimationActorSentMessage slot,
+                                      guint32 message_type,
+                                      guint32 l0,
+                                      guint32 l1,
+                                      guint32 l2,
+                                      guint32 l3,
+                                      guint32 l4)
+{
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+    guint32 *sent = priv->sent[slot];
 
-    XSendEvent (display, window, True,
-                StructureNotifyMask,
-                (XEvent *)&event);
+    if ((priv->sent_valid & (1 << slot)) &&
+	sent[0] == l0 && sent[1] == l1 && sent[2] == l2 &&
+	sent[3] == l3 && sent[4] == l4)
+	return;
+
+    sent[0] = l0;
+    sent[1] = l1;
+    sent[2] = l2;
+    sent[3] = l3;
+    sent[4] = l4;
+    priv->sent_valid |= 1 << slot;
+
+    hildon_animation_actor_queue_message (self, message_type, slot, l0, l1, l2, l3, l4);
 }
 
 /**
@@ -641,7 +625,7 @@ hildon_animation_actor_set_show_full (HildonAnimationActor *self,
     priv->opacity = opacity;
     priv->set_show = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
 	/* Defer show messages until the animation actor is parented
 	 * and the parent window is mapped */
@@ -649,10 +633,10 @@ hildon_animation_actor_set_show_full (HildonAnimationActor *self,
 	if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
 	    return;
 
-	hildon_animation_actor_send_message (self,
-					     show_atom,
-					     show, opacity,
-					     0, 0, 0);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_SHOW,
+					      show_atom,
+					      show, opacity,
+					      0, 0, 0);
 	priv->set_show = 0;
     }
 }
@@ -751,12 +735,12 @@ hildon_animation_actor_set_position_full (HildonAnimationActor *self,
     priv->depth = depth;
     priv->set_position = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
-	hildon_animation_actor_send_message (self,
-					     position_atom,
-					     x, y, depth,
-					     0, 0);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_POSITION,
+					      position_atom,
+					      x, y, depth,
+					      0, 0);
 	priv->set_position = 0;
     }
 }
@@ -831,12 +815,12 @@ hildon_animation_actor_set_scalex (HildonAnimationActor *self,
     priv->scale_y = y_scale;
     priv->set_scale = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
-	hildon_animation_actor_send_message (self,
-					     scale_atom,
-					     x_scale, y_scale,
-					     0, 0, 0);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_SCALE,
+					      scale_atom,
+					      x_scale, y_scale,
+					      0, 0, 0);
 	priv->set_scale = 0;
     }
 }
@@ -925,11 +909,11 @@ hildon_animation_actor_set_rotationx (HildonAnimationActor     *self,
 
     priv->set_rotation |= mask;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
-	hildon_animation_actor_send_message (self,
-					     rotation_atom,
-					     axis, degrees, x, y, z);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_ROTATION_X + axis,
+					      rotation_atom,
+					      axis, degrees, x, y, z);
 	priv->set_rotation &= ~mask;
     }
 }
@@ -998,12 +982,12 @@ hildon_animation_actor_set_anchor (HildonAnimationActor *self,
     priv->anchor_y = y;
     priv->set_anchor = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
-	hildon_animation_actor_send_message (self,
-					     anchor_atom,
-					     0, x, y,
-					     0, 0);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_ANCHOR,
+					      anchor_atom,
+					      0, x, y,
+					      0, 0);
 	priv->set_anchor = 0;
     }
 }
@@ -1035,12 +1019,12 @@ hildon_animation_actor_set_anchor_from_gravity (HildonAnimationActor *self,
     priv->gravity = gravity;
     priv->set_anchor = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
-	hildon_animation_actor_send_message (self,
-					     anchor_atom,
-					     gravity, 0, 0,
-					     0, 0);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_ANCHOR,
+					      anchor_atom,
+					      gravity, 0, 0,
+					      0, 0);
 	priv->set_anchor = 0;
     }
 }
@@ -1061,36 +1045,6 @@ hildon_animation_actor_parent_map_event (GtkWidget *parent,
     return FALSE;
 }
 
-/*
- * This callback will be triggered by the widget re-mapping
- * itself in case of WM restarting. The point is to push all
- * animation actor parameters anew to the WM.
- */
-static gboolean
-hildon_animation_actor_map_event (GtkWidget *widget,
-				  GdkEvent *event,
-				  gpointer user_data)
-{
-    HildonAnimationActor
-	               *self = HILDON_ANIMATION_ACTOR (user_data);
-    HildonAnimationActorPrivate
-	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
-
-    hildon_animation_actor_send_all_messages (self);
-
-    /* Disconnect the "map-event" handler after the "emergency resend all
-     * actor parameters" drill is over. */
-
-    if (priv->map_event_cb_id)
-    {
-	g_signal_handler_disconnect (self,
-				     priv->map_event_cb_id);
-	priv->map_event_cb_id = 0;
-    }
-
-    return FALSE;
-}
-
 /**
  * hildon_animation_actor_set_parent:
  * @self: A #HildonAnimationActor
@@ -1144,6 +1098,14 @@ hildon_animation_actor_set_parent (HildonAnimationActor *self,
 	priv->parent = parent;
 	priv->set_parent = 1;
 
+	/* Follow the new parent's frame clock */
+
+	if (priv->timeline_tick_id)
+	{
+	    hildon_animation_actor_timeline_detach (self);
+	    hildon_animation_actor_timeline_attach (self);
+	}
+
 	if (parent != 0)
 	{
 	    /* The widget is being (re)parented, not unparented. */
@@ -1162,7 +1124,7 @@ hildon_animation_actor_set_parent (HildonAnimationActor *self,
 	}
     }
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
 	Window win = 0;
 
@@ -1171,10 +1133,10 @@ hildon_animation_actor_set_parent (HildonAnimationActor *self,
 
 	if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
 	{
-	    hildon_animation_actor_send_message (self,
-						 show_atom,
-						 0, priv->opacity,
-						 0, 0, 0);
+	    hildon_animation_actor_send_property (self, HILDON_AA_SENT_SHOW,
+						  show_atom,
+						  0, priv->opacity,
+						  0, 0, 0);
 	}
 
 	/* If the widget is being parented (parent != 0), only proceed when
@@ -1191,20 +1153,601 @@ hildon_animation_actor_set_parent (HildonAnimationActor *self,
 	    win = GDK_WINDOW_XID (gdk);
 	}
 
-	hildon_animation_actor_send_message (self,
-					     parent_atom,
-					     win,
-					     0, 0, 0, 0);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_PARENT,
+					      parent_atom,
+					      win,
+					      0, 0, 0, 0);
 	priv->set_parent = 0;
 
 	/* Set animation actor visibility to desired value (in case it was
 	 * forced off when the actor was parented into an unmapped widget). */
 
-	hildon_animation_actor_send_message (self,
-					     show_atom,
-					     priv->show, priv->opacity,
-					     0, 0, 0);
+	hildon_animation_actor_send_property (self, HILDON_AA_SENT_SHOW,
+					      show_atom,
+					      priv->show, priv->opacity,
+					      0, 0, 0);
 	priv->set_show = 0;
     }
 }
 
+/**
+ * hildon_animation_actor_begin_update:
+ * @self: A #HildonAnimationActor
+ *
+ * Starts a batch of changes to the animation actor. Until the matching
+ * hildon_animation_actor_commit_update(), the setters only record the new
+ * values; nothing is sent to the window manager. This lets several
+ * properties be changed together without the compositor picking up a
+ * frame in which only some of them have been applied.
+ *
+ * Calls may be nested; the changes are sent when the outermost batch
+ * is committed.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_actor_begin_update (HildonAnimationActor *self)
+{
+    HildonAnimationActorPrivate
+	               *priv;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (self));
+
+    priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    priv->batch_depth++;
+}
+
+/**
+ * hildon_animation_actor_commit_update:
+ * @self: A #HildonAnimationActor
+ *
+ * Ends a batch of changes started with hildon_animation_actor_begin_update().
+ * When the outermost batch is committed, every property changed since
+ * it began is sent to the window manager in one go, and the X
+ * connection is flushed once.
+ *
+ * If the animation actor WM-counterpart is not ready, the messages
+ * will be queued until the WM is ready for them.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_actor_commit_update (HildonAnimationActor *self)
+{
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (self));
+
+    if (hildon_animation_actor_commit_update_unflushed (self))
+	hildon_compositor_flush (gtk_widget_get_display (GTK_WIDGET (self)));
+}
+
+/*
+ * Like hildon_animation_actor_commit_update(), but leaves the X
+ * connection alone, so that a #HildonAnimationGroup can flush once for
+ * all of its actors. Returns %TRUE if messages may have been queued.
+ */
+gboolean
+hildon_animation_actor_commit_update_unflushed (HildonAnimationActor *self)
+{
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+    GtkWidget          *widget = GTK_WIDGET (self);
+
+    g_return_val_if_fail (priv->batch_depth > 0, FALSE);
+
+    if (--priv->batch_depth > 0)
+	return FALSE;
+
+    if (gtk_widget_get_mapped (widget) && priv->ready)
+    {
+	hildon_animation_actor_send_pending_messages (self);
+	return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * hildon_animation_actor_set_transform:
+ * @self: A #HildonAnimationActor
+ * @transform: The new geometry of the actor.
+ *
+ * Sets the position, depth, scale factors, rotations and anchor point
+ * of the animation actor at once. This is meant for code that
+ * recomputes the whole transform of an actor every frame: the
+ * components that did not change since the last call are not sent
+ * again, and the rest are sent to the window manager as a single
+ * batch, as if wrapped in hildon_animation_actor_begin_update() and
+ * hildon_animation_actor_commit_update().
+ *
+ * The rotation around each axis uses the two coordinates of the
+ * rotation center that are meaningful for that axis, as described in
+ * hildon_animation_actor_set_rotation().
+ *
+ * If the animation actor WM-counterpart is not ready, the messages
+ * will be queued until the WM is ready for them.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_actor_set_transform (HildonAnimationActor *self,
+                                      const HildonAnimationActorTransform *transform)
+{
+    HildonAnimationActorPrivate
+	               *priv;
+    gint32 f_x_scale, f_y_scale;
+    gint32 f_angle;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (self));
+    g_return_if_fail (transform != NULL);
+
+    priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    hildon_animation_actor_begin_update (self);
+
+    if (priv->gravity != 0 ||
+	transform->anchor_x != (gint) priv->anchor_x ||
+	transform->anchor_y != (gint) priv->anchor_y)
+	hildon_animation_actor_set_anchor (self,
+					   transform->anchor_x,
+					   transform->anchor_y);
+
+    if (transform->x != (gint) priv->position_x ||
+	transform->y != (gint) priv->position_y ||
+	transform->depth != (gint) priv->depth)
+	hildon_animation_actor_set_position_full (self,
+						  transform->x, transform->y,
+						  transform->depth);
+
+    f_x_scale = transform->x_scale * (1 << 16);
+    f_y_scale = transform->y_scale * (1 << 16);
+    if (f_x_scale != (gint32) priv->scale_x ||
+	f_y_scale != (gint32) priv->scale_y)
+	hildon_animation_actor_set_scalex (self, f_x_scale, f_y_scale);
+
+    f_angle = transform->rotation[HILDON_AA_X_AXIS] * (1 << 16);
+    if (f_angle != (gint32) priv->x_rotation_angle ||
+	transform->center_y != (gint) priv->x_rotation_y ||
+	transform->center_z != (gint) priv->x_rotation_z)
+	hildon_animation_actor_set_rotationx (self, HILDON_AA_X_AXIS,
+					      f_angle, 0,
+					      transform->center_y,
+					      transform->center_z);
+
+    f_angle = transform->rotation[HILDON_AA_Y_AXIS] * (1 << 16);
+    if (f_angle != (gint32) priv->y_rotation_angle ||
+	transform->center_x != (gint) priv->y_rotation_x ||
+	transform->center_z != (gint) priv->y_rotation_z)
+	hildon_animation_actor_set_rotationx (self, HILDON_AA_Y_AXIS,
+					      f_angle,
+					      transform->center_x, 0,
+					      transform->center_z);
+
+    f_angle = transform->rotation[HILDON_AA_Z_AXIS] * (1 << 16);
+    if (f_angle != (gint32) priv->z_rotation_angle ||
+	transform->center_x != (gint) priv->z_rotation_x ||
+	transform->center_y != (gint) priv->z_rotation_y)
+	hildon_animation_actor_set_rotationx (self, HILDON_AA_Z_AXIS,
+					      f_angle,
+					      transform->center_x,
+					      transform->center_y, 0);
+
+    hildon_animation_actor_commit_update (self);
+}
+
+static double
+hildon_animation_actor_ease (HildonAnimationActorEasing easing,
+			     double t)
+{
+    switch (easing)
+    {
+	case HILDON_AA_EASE_IN:
+	    return t * t * t;
+	case HILDON_AA_EASE_OUT:
+	    t = 1.0 - t;
+	    return 1.0 - t * t * t;
+	case HILDON_AA_EASE_IN_OUT:
+	    return t * t * (3.0 - 2.0 * t);
+	default:
+	    return t;
+    }
+}
+
+/*
+ * Interpolates the properties in @flag between the keyframes @a and @b,
+ * @t being the eased fraction of the way from @a to @b, and stores the
+ * result in @out.
+ */
+static void
+hildon_animation_actor_keyframe_lerp (const HildonAnimationActorKeyframe *a,
+				      const HildonAnimationActorKeyframe *b,
+				      HildonAnimationActorKeyframeFlags flag,
+				      double t,
+				      HildonAnimationActorKeyframe *out)
+{
+#define LERP(field) (a->field + (b->field - a->field) * t)
+    switch (flag)
+    {
+	case HILDON_AA_KEYFRAME_POSITION:
+	    out->x = floor (LERP (x) + 0.5);
+	    out->y = floor (LERP (y) + 0.5);
+	    break;
+	case HILDON_AA_KEYFRAME_DEPTH:
+	    out->depth = floor (LERP (depth) + 0.5);
+	    break;
+	case HILDON_AA_KEYFRAME_SCALE:
+	    out->x_scale = LERP (x_scale);
+	    out->y_scale = LERP (y_scale);
+	    break;
+	case HILDON_AA_KEYFRAME_ROTATION_X:
+	    out->rotation[HILDON_AA_X_AXIS] = LERP (rotation[HILDON_AA_X_AXIS]);
+	    break;
+	case HILDON_AA_KEYFRAME_ROTATION_Y:
+	    out->rotation[HILDON_AA_Y_AXIS] = LERP (rotation[HILDON_AA_Y_AXIS]);
+	    break;
+	case HILDON_AA_KEYFRAME_ROTATION_Z:
+	    out->rotation[HILDON_AA_Z_AXIS] = LERP (rotation[HILDON_AA_Z_AXIS]);
+	    break;
+	case HILDON_AA_KEYFRAME_OPACITY:
+	    out->opacity = floor (LERP (opacity) + 0.5);
+	    break;
+	default:
+	    break;
+    }
+#undef LERP
+}
+
+/*
+ * Computes the state of every animated property @time milliseconds into
+ * the timeline. Properties are interpolated independently, between the
+ * last keyframe setting them at or before @time (or the state the actor
+ * had when the timeline started) and the next keyframe setting them.
+ */
+static void
+hildon_animation_actor_timeline_sample (HildonAnimationActor *self,
+					double time,
+					HildonAnimationActorKeyframe *out)
+{
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+    guint flag;
+
+    *out = priv->timeline_origin;
+    out->flags = 0;
+
+    for (flag = HILDON_AA_KEYFRAME_POSITION;
+	 flag <= HILDON_AA_KEYFRAME_OPACITY;
+	 flag <<= 1)
+    {
+	const HildonAnimationActorKeyframe *prev = &priv->timeline_origin;
+	const HildonAnimationActorKeyframe *next = NULL;
+	double t = 1.0;
+	guint i;
+
+	for (i = 0; i < priv->keyframes->len; i++)
+	{
+	    const HildonAnimationActorKeyframe *k =
+		&g_array_index (priv->keyframes, HildonAnimationActorKeyframe, i);
+
+	    if (!(k->flags & flag))
+		continue;
+
+	    out->flags |= flag;
+
+	    if (k->time <= time)
+	    {
+		prev = k;
+	    }
+	    else
+	    {
+		next = k;
+		break;
+	    }
+	}
+
+	if (!(out->flags & flag))
+	    continue;
+
+	if (next)
+	{
+	    t = (time - prev->time) / (double) (next->time - prev->time);
+	    t = hildon_animation_actor_ease (next->easing, CLAMP (t, 0.0, 1.0));
+	}
+	else
+	{
+	    next = prev;
+	}
+
+	hildon_animation_actor_keyframe_lerp (prev, next, flag, t, out);
+    }
+}
+
+/*
+ * Sends the properties of @state that differ from the actor's current
+ * ones, as a single batch.
+ */
+static void
+hildon_animation_actor_timeline_apply (HildonAnimationActor *self,
+				       const HildonAnimationActorKeyframe *state)
+{
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+    gint32 f_x_scale, f_y_scale;
+    gint32 f_x_angle, f_y_angle, f_z_angle;
+
+    hildon_animation_actor_begin_update (self);
+
+    if (state->flags & (HILDON_AA_KEYFRAME_POSITION | HILDON_AA_KEYFRAME_DEPTH))
+    {
+	if (state->x != (gint) priv->position_x ||
+	    state->y != (gint) priv->position_y ||
+	    state->depth != (gint) priv->depth)
+	    hildon_animation_actor_set_position_full (self,
+						      state->x, state->y,
+						      state->depth);
+    }
+
+    if (state->flags & HILDON_AA_KEYFRAME_SCALE)
+    {
+	f_x_scale = state->x_scale * (1 << 16);
+	f_y_scale = state->y_scale * (1 << 16);
+
+	if (f_x_scale != (gint32) priv->scale_x ||
+	    f_y_scale != (gint32) priv->scale_y)
+	    hildon_animation_actor_set_scalex (self, f_x_scale, f_y_scale);
+    }
+
+    f_x_angle = state->rotation[HILDON_AA_X_AXIS] * (1 << 16);
+    if ((state->flags & HILDON_AA_KEYFRAME_ROTATION_X) &&
+	f_x_angle != (gint32) priv->x_rotation_angle)
+	hildon_animation_actor_set_rotationx (self, HILDON_AA_X_AXIS,
+					      f_x_angle, 0,
+					      priv->x_rotation_y,
+					      priv->x_rotation_z);
+
+    f_y_angle = state->rotation[HILDON_AA_Y_AXIS] * (1 << 16);
+    if ((state->flags & HILDON_AA_KEYFRAME_ROTATION_Y) &&
+	f_y_angle != (gint32) priv->y_rotation_angle)
+	hildon_animation_actor_set_rotationx (self, HILDON_AA_Y_AXIS,
+					      f_y_angle,
+					      priv->y_rotation_x, 0,
+					      priv->y_rotation_z);
+
+    f_z_angle = state->rotation[HILDON_AA_Z_AXIS] * (1 << 16);
+    if ((state->flags & HILDON_AA_KEYFRAME_ROTATION_Z) &&
+	f_z_angle != (gint32) priv->z_rotation_angle)
+	hildon_animation_actor_set_rotationx (self, HILDON_AA_Z_AXIS,
+					      f_z_angle,
+					      priv->z_rotation_x,
+					      priv->z_rotation_y, 0);
+
+    if ((state->flags & HILDON_AA_KEYFRAME_OPACITY) &&
+	(guint) CLAMP (state->opacity, 0, 255) != priv->opacity)
+	hildon_animation_actor_set_show_full (self, priv->show,
+					      CLAMP (state->opacity, 0, 255));
+
+    hildon_animation_actor_commit_update (self);
+}
+
+static gboolean
+hildon_animation_actor_timeline_tick (GtkWidget *widget,
+				      GdkFrameClock *frame_clock,
+				      gpointer user_data)
+{
+    HildonAnimationActor *self = HILDON_ANIMATION_ACTOR (user_data);
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+    HildonAnimationActorKeyframe state;
+    const HildonAnimationActorKeyframe *last;
+    gint64 frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+    double time;
+
+    if (priv->timeline_start == 0)
+	priv->timeline_start = frame_time;
+
+    time = (frame_time - priv->timeline_start) / 1000.0;
+
+    hildon_animation_actor_timeline_sample (self, time, &state);
+    hildon_animation_actor_timeline_apply (self, &state);
+
+    last = &g_array_index (priv->keyframes, HildonAnimationActorKeyframe,
+			   priv->keyframes->len - 1);
+
+    if (time >= last->time)
+    {
+	priv->timeline_tick_id = 0;
+	priv->timeline_widget = NULL;
+
+	g_signal_emit (self, actor_signals[TIMELINE_FINISHED], 0);
+
+	return G_SOURCE_REMOVE;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/*
+ * The timeline runs on the frame clock of the parent window, which is
+ * the one the actor is composited with; unparented actors use their own.
+ */
+static void
+hildon_animation_actor_timeline_attach (HildonAnimationActor *self)
+{
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    priv->timeline_widget = priv->parent ?
+	GTK_WIDGET (priv->parent) : GTK_WIDGET (self);
+    priv->timeline_tick_id =
+	gtk_widget_add_tick_callback (priv->timeline_widget,
+				      hildon_animation_actor_timeline_tick,
+				      self, NULL);
+}
+
+static void
+hildon_animation_actor_timeline_detach (HildonAnimationActor *self)
+{
+    HildonAnimationActorPrivate
+	               *priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    if (priv->timeline_tick_id)
+    {
+	gtk_widget_remove_tick_callback (priv->timeline_widget,
+					 priv->timeline_tick_id);
+	priv->timeline_tick_id = 0;
+	priv->timeline_widget = NULL;
+    }
+}
+
+/**
+ * hildon_animation_actor_add_keyframe:
+ * @self: A #HildonAnimationActor
+ * @keyframe: The keyframe to add. It is copied.
+ *
+ * Adds a keyframe to the timeline of the animation actor. Only the
+ * properties named in the keyframe's flags are animated by it; each
+ * of them moves from the value set by the previous keyframe (or the
+ * value the actor had when the timeline was started) to the value
+ * given here, following the keyframe's easing curve.
+ *
+ * Keyframes may be added in any order, they are kept sorted by time.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_actor_add_keyframe (HildonAnimationActor *self,
+				     const HildonAnimationActorKeyframe *keyframe)
+{
+    HildonAnimationActorPrivate
+	               *priv;
+    guint i;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (self));
+    g_return_if_fail (keyframe != NULL);
+
+    priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    for (i = 0; i < priv->keyframes->len; i++)
+	if (g_array_index (priv->keyframes, HildonAnimationActorKeyframe,
+			   i).time > keyframe->time)
+	    break;
+
+    g_array_insert_val (priv->keyframes, i, *keyframe);
+}
+
+/**
+ * hildon_animation_actor_clear_keyframes:
+ * @self: A #HildonAnimationActor
+ *
+ * Removes all the keyframes of the animation actor, stopping its
+ * timeline if it is running. The actor keeps its current state.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_actor_clear_keyframes (HildonAnimationActor *self)
+{
+    HildonAnimationActorPrivate
+	               *priv;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (self));
+
+    priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    hildon_animation_actor_timeline_detach (self);
+    g_array_set_size (priv->keyframes, 0);
+}
+
+/**
+ * hildon_animation_actor_start_timeline:
+ * @self: A #HildonAnimationActor
+ *
+ * Plays the keyframes added with hildon_animation_actor_add_keyframe()
+ * from the beginning, starting from the current state of the actor.
+ *
+ * The properties are interpolated once per frame of the parent
+ * window's #GdkFrameClock, and only the ones that changed since the
+ * previous frame are sent to the window manager. This replaces driving
+ * the actor with a timeout, which isn't synchronized with the display.
+ *
+ * #HildonAnimationActor::timeline-finished is emitted when the last
+ * keyframe is reached.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_actor_start_timeline (HildonAnimationActor *self)
+{
+    HildonAnimationActorPrivate
+	               *priv;
+    HildonAnimationActorKeyframe *origin;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (self));
+
+    priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    hildon_animation_actor_timeline_detach (self);
+
+    if (priv->keyframes->len == 0)
+	return;
+
+    origin = &priv->timeline_origin;
+    origin->time = 0;
+    origin->x = priv->position_x;
+    origin->y = priv->position_y;
+    origin->depth = priv->depth;
+    origin->x_scale = (gint32) priv->scale_x / (double) (1 << 16);
+    origin->y_scale = (gint32) priv->scale_y / (double) (1 << 16);
+    origin->rotation[HILDON_AA_X_AXIS] =
+	(gint32) priv->x_rotation_angle / (double) (1 << 16);
+    origin->rotation[HILDON_AA_Y_AXIS] =
+	(gint32) priv->y_rotation_angle / (double) (1 << 16);
+    origin->rotation[HILDON_AA_Z_AXIS] =
+	(gint32) priv->z_rotation_angle / (double) (1 << 16);
+    origin->opacity = priv->opacity;
+
+    priv->timeline_start = 0;
+
+    hildon_animation_actor_timeline_attach (self);
+}
+
+/**
+ * hildon_animation_actor_stop_timeline:
+ * @self: A #HildonAnimationActor
+ *
+ * Stops the timeline of the animation actor, leaving the actor in the
+ * state of the last frame. #HildonAnimationActor::timeline-finished is
+ * not emitted.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_actor_stop_timeline (HildonAnimationActor *self)
+{
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (self));
+
+    hildon_animation_actor_timeline_detach (self);
+}
+
+/**
+ * hildon_animation_actor_get_timeline_playing:
+ * @self: A #HildonAnimationActor
+ *
+ * Returns whether the timeline of the animation actor is running.
+ *
+ * Returns: %TRUE if the timeline is running.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_animation_actor_get_timeline_playing (HildonAnimationActor *self)
+{
+    HildonAnimationActorPrivate
+	               *priv;
+
+    g_return_val_if_fail (HILDON_IS_ANIMATION_ACTOR (self), FALSE);
+
+    priv = HILDON_ANIMATION_ACTOR_GET_PRIVATE (self);
+
+    return priv->timeline_tick_id != 0;
+}
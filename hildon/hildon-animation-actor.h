@@ -116,6 +116,125 @@ typedef enum
     HILDON_AA_CENTER_GRAVITY
 } HildonAnimationActorGravity;
 
+/**
+ * HildonAnimationActorEasing:
+ * @HILDON_AA_EASE_LINEAR: constant speed.
+ * @HILDON_AA_EASE_IN: starts slowly and accelerates.
+ * @HILDON_AA_EASE_OUT: starts quickly and decelerates.
+ * @HILDON_AA_EASE_IN_OUT: accelerates, then decelerates.
+ *
+ * Used to specify how a keyframe is approached from the previous one.
+ *
+ * Since: 3.0
+ */
+typedef enum
+{
+    HILDON_AA_EASE_LINEAR,
+    HILDON_AA_EASE_IN,
+    HILDON_AA_EASE_OUT,
+    HILDON_AA_EASE_IN_OUT
+} HildonAnimationActorEasing;
+
+/**
+ * HildonAnimationActorKeyframeFlags:
+ * @HILDON_AA_KEYFRAME_POSITION: the keyframe sets the X and Y coordinates.
+ * @HILDON_AA_KEYFRAME_DEPTH: the keyframe sets the depth.
+ * @HILDON_AA_KEYFRAME_SCALE: the keyframe sets the scale factors.
+ * @HILDON_AA_KEYFRAME_ROTATION_X: the keyframe sets the rotation around the X axis.
+ * @HILDON_AA_KEYFRAME_ROTATION_Y: the keyframe sets the rotation around the Y axis.
+ * @HILDON_AA_KEYFRAME_ROTATION_Z: the keyframe sets the rotation around the Z axis.
+ * @HILDON_AA_KEYFRAME_OPACITY: the keyframe sets the opacity.
+ *
+ * Used to specify which fields of a #HildonAnimationActorKeyframe are
+ * meaningful. Properties not set by a keyframe are interpolated between
+ * the keyframes around it that do set them.
+ *
+ * Since: 3.0
+ */
+typedef enum
+{
+    HILDON_AA_KEYFRAME_POSITION   = 1 << 0,
+    HILDON_AA_KEYFRAME_DEPTH      = 1 << 1,
+    HILDON_AA_KEYFRAME_SCALE      = 1 << 2,
+    HILDON_AA_KEYFRAME_ROTATION_X = 1 << 3,
+    HILDON_AA_KEYFRAME_ROTATION_Y = 1 << 4,
+    HILDON_AA_KEYFRAME_ROTATION_Z = 1 << 5,
+    HILDON_AA_KEYFRAME_OPACITY    = 1 << 6
+} HildonAnimationActorKeyframeFlags;
+
+/**
+ * HildonAnimationActorKeyframe:
+ * @time: Time of the keyframe, in milliseconds from the start of the timeline.
+ * @flags: Which of the following fields are set.
+ * @easing: How the properties set by this keyframe are approached.
+ * @x: X coordinate.
+ * @y: Y coordinate.
+ * @depth: Window depth (Z coordinate).
+ * @x_scale: Scale factor along the X-axis.
+ * @y_scale: Scale factor along the Y-axis.
+ * @rotation: Rotation angles in degrees, indexed by #HildonAnimationActorAxis.
+ * @opacity: Opacity, from 0 to 255.
+ *
+ * A keyframe of an animation actor timeline. See
+ * hildon_animation_actor_add_keyframe().
+ *
+ * Since: 3.0
+ */
+typedef struct
+{
+    guint time;
+    HildonAnimationActorKeyframeFlags flags;
+    HildonAnimationActorEasing easing;
+
+    gint x;
+    gint y;
+    gint depth;
+
+    double x_scale;
+    double y_scale;
+
+    double rotation[3];
+
+    gint opacity;
+} HildonAnimationActorKeyframe;
+
+/**
+ * HildonAnimationActorTransform:
+ * @x: X coordinate.
+ * @y: Y coordinate.
+ * @depth: Window depth (Z coordinate).
+ * @x_scale: Scale factor along the X-axis.
+ * @y_scale: Scale factor along the Y-axis.
+ * @rotation: Rotation angles in degrees, indexed by #HildonAnimationActorAxis.
+ * @center_x: Center of the rotations, X coordinate.
+ * @center_y: Center of the rotations, Y coordinate.
+ * @center_z: Center of the rotations, Z coordinate.
+ * @anchor_x: The X coordinate of the anchor point.
+ * @anchor_y: The Y coordinate of the anchor point.
+ *
+ * The complete geometry of an animation actor. See
+ * hildon_animation_actor_set_transform().
+ *
+ * Since: 3.0
+ */
+typedef struct
+{
+    gint x;
+    gint y;
+    gint depth;
+
+    double x_scale;
+    double y_scale;
+
+    double rotation[3];
+    gint center_x;
+    gint center_y;
+    gint center_z;
+
+    gint anchor_x;
+    gint anchor_y;
+} HildonAnimationActorTransform;
+
 GType
 hildon_animation_actor_get_type                (void) G_GNUC_CONST;
 
@@ -186,6 +305,32 @@ void
 hildon_animation_actor_set_parent (HildonAnimationActor *self,
 				   GtkWindow *parent);
 
+void
+hildon_animation_actor_begin_update (HildonAnimationActor *self);
+
+void
+hildon_animation_actor_commit_update (HildonAnimationActor *self);
+
+void
+hildon_animation_actor_set_transform (HildonAnimationActor *self,
+                                      const HildonAnimationActorTransform *transform);
+
+void
+hildon_animation_actor_add_keyframe (HildonAnimationActor *self,
+                                     const HildonAnimationActorKeyframe *keyframe);
+
+void
+hildon_animation_actor_clear_keyframes (HildonAnimationActor *self);
+
+void
+hildon_animation_actor_start_timeline (HildonAnimationActor *self);
+
+void
+hildon_animation_actor_stop_timeline (HildonAnimationActor *self);
+
+gboolean
+hildon_animation_actor_get_timeline_playing (HildonAnimationActor *self);
+
 G_END_DECLS
 
 #endif                                 /* __HILDON_ANIMATION_ACTOR_H__ */
@@ -0,0 +1,545 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-animation-group
+ * @short_description: A set of animation actors updated together.
+ * @see_also: #HildonAnimationActor
+ *
+ * The #HildonAnimationGroup lets an application that drives many
+ * #HildonAnimationActor<!-- -->s at once, like a home screen widget
+ * made of sprites, change all of them as a single batch.
+ *
+ * Between hildon_animation_group_begin_update() and
+ * hildon_animation_group_commit_update(), the setters of every actor in
+ * the group only record the new values. The commit then sends the
+ * properties that changed for all the actors and flushes the X
+ * connection once, instead of once per actor, and the compositor never
+ * picks up a frame in which only some of the actors have moved.
+ *
+ * <example>
+ * <title>Moving several actors in one frame</title>
+ * <programlisting>
+ * hildon_animation_group_begin_update (group);
+ * <!-- -->
+ * for (i = 0; i < n_sprites; i++)
+ *     hildon_animation_actor_set_position (sprites[i], x[i], y[i]);
+ * <!-- -->
+ * hildon_animation_group_commit_update (group);
+ * </programlisting>
+ * </example>
+ *
+ * The group holds a reference on its actors. An actor that is destroyed
+ * is removed from the group automatically.
+ *
+ * Overlays that belong to scrolling content, like badges or selection
+ * highlights, can be bound to a #HildonPannableArea with
+ * hildon_animation_group_set_pannable_area(). The actors given a content
+ * position with hildon_animation_group_set_content_position() are then
+ * moved along with the content, in one batch on the next frame tick
+ * after the area scrolled.
+ */
+
+#include                                        <gdk/gdkx.h>
+
+#include                                        "hildon-animation-group.h"
+#include                                        "hildon-animation-actor-private.h"
+#include                                        "hildon-private.h"
+
+struct                                          _HildonAnimationGroupPrivate
+{
+    GPtrArray *actors;
+    guint      batch_depth;
+
+    HildonPannableArea *area;
+    GHashTable *content_positions;
+    guint      scroll_tick_id;
+};
+
+/* Where an actor bound to the content of the pannable area is */
+typedef struct
+{
+    gint x;
+    gint y;
+} HildonAnimationGroupPosition;
+
+#define                                         HILDON_ANIMATION_GROUP_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj),\
+                                                HILDON_TYPE_ANIMATION_GROUP, HildonAnimationGroupPrivate))
+
+G_DEFINE_TYPE (HildonAnimationGroup, hildon_animation_group, G_TYPE_OBJECT);
+
+static gboolean
+hildon_animation_group_contains                 (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor)
+{
+    guint i;
+
+    for (i = 0; i < group->priv->actors->len; i++)
+        if (g_ptr_array_index (group->priv->actors, i) == actor)
+            return TRUE;
+
+    return FALSE;
+}
+
+static void
+hildon_animation_group_actor_destroyed          (GtkWidget *actor,
+                                                 gpointer   data)
+{
+    hildon_animation_group_remove (HILDON_ANIMATION_GROUP (data),
+                                   HILDON_ANIMATION_ACTOR (actor));
+}
+
+static void
+hildon_animation_group_position_free            (gpointer data)
+{
+    g_slice_free (HildonAnimationGroupPosition, data);
+}
+
+/* Moves the actors bound to the content to where it scrolled to */
+static void
+hildon_animation_group_follow_content           (HildonAnimationGroup *group)
+{
+    HildonAnimationGroupPrivate *priv = group->priv;
+    GtkWidget *area = GTK_WIDGET (priv->area);
+    GtkWidget *toplevel = gtk_widget_get_toplevel (area);
+    gint origin_x = 0, origin_y = 0;
+    gint dx, dy;
+    guint i;
+
+    if (g_hash_table_size (priv->content_positions) == 0)
+        return;
+
+    if (gtk_widget_is_toplevel (toplevel))
+        gtk_widget_translate_coordinates (area, toplevel, 0, 0, &origin_x, &origin_y);
+
+    dx = origin_x - (gint) gtk_adjustment_get_value (hildon_pannable_area_get_hadjustment (priv->area));
+    dy = origin_y - (gint) gtk_adjustment_get_value (hildon_pannable_area_get_vadjustment (priv->area));
+
+    hildon_animation_group_begin_update (group);
+
+    for (i = 0; i < priv->actors->len; i++)
+    {
+        HildonAnimationActor *actor = g_ptr_array_index (priv->actors, i);
+        HildonAnimationGroupPosition *position;
+
+        position = g_hash_table_lookup (priv->content_positions, actor);
+        if (position)
+            hildon_animation_actor_set_position (actor, position->x + dx, position->y + dy);
+    }
+
+    hildon_animation_group_commit_update (group);
+}
+
+static gboolean
+hildon_animation_group_scroll_tick              (GtkWidget     *widget,
+                                                 GdkFrameClock *frame_clock,
+                                                 gpointer       data)
+{
+    HildonAnimationGroup *group = HILDON_ANIMATION_GROUP (data);
+
+    group->priv->scroll_tick_id = 0;
+    hildon_animation_group_follow_content (group);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* However many times the area scrolls in a frame, the actors are only
+ * moved once, on the next frame tick */
+static void
+hildon_animation_group_content_moved            (HildonAnimationGroup *group)
+{
+    HildonAnimationGroupPrivate *priv = group->priv;
+
+    if (priv->scroll_tick_id == 0)
+        priv->scroll_tick_id =
+            gtk_widget_add_tick_callback (GTK_WIDGET (priv->area),
+                                          hildon_animation_group_scroll_tick,
+                                          group, NULL);
+}
+
+static void
+hildon_animation_group_dispose                  (GObject *object)
+{
+    HildonAnimationGroup *group = HILDON_ANIMATION_GROUP (object);
+    HildonAnimationGroupPrivate *priv = group->priv;
+
+    /* Changes left in an open batch are still sent */
+    if (priv->batch_depth > 0)
+    {
+        priv->batch_depth = 1;
+        hildon_animation_group_commit_update (group);
+    }
+
+    hildon_animation_group_set_pannable_area (group, NULL);
+
+    while (priv->actors->len > 0)
+        hildon_animation_group_remove (group,
+                                       g_ptr_array_index (priv->actors,
+                                                          priv->actors->len - 1));
+
+    G_OBJECT_CLASS (hildon_animation_group_parent_class)->dispose (object);
+}
+
+static void
+hildon_animation_group_finalize                 (GObject *object)
+{
+    HildonAnimationGroupPrivate *priv = HILDON_ANIMATION_GROUP (object)->priv;
+
+    g_ptr_array_free (priv->actors, TRUE);
+    g_hash_table_destroy (priv->content_positions);
+
+    G_OBJECT_CLASS (hildon_animation_group_parent_class)->finalize (object);
+}
+
+static void
+hildon_animation_group_class_init               (HildonAnimationGroupClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+    gobject_class->dispose = hildon_animation_group_dispose;
+    gobject_class->finalize = hildon_animation_group_finalize;
+
+    g_type_class_add_private (klass, sizeof (HildonAnimationGroupPrivate));
+}
+
+static void
+hildon_animation_group_init                     (HildonAnimationGroup *self)
+{
+    HildonAnimationGroupPrivate *priv;
+
+    self->priv = priv = HILDON_ANIMATION_GROUP_GET_PRIVATE (self);
+
+    priv->actors = g_ptr_array_new ();
+    priv->batch_depth = 0;
+    priv->content_positions = g_hash_table_new_full (NULL, NULL, NULL,
+                                                     hildon_animation_group_position_free);
+}
+
+/**
+ * hildon_animation_group_new:
+ *
+ * Creates a new, empty #HildonAnimationGroup.
+ *
+ * Return value: A new #HildonAnimationGroup
+ *
+ * Since: 3.0
+ **/
+HildonAnimationGroup *
+hildon_animation_group_new                      (void)
+{
+    return g_object_new (HILDON_TYPE_ANIMATION_GROUP, NULL);
+}
+
+/**
+ * hildon_animation_group_add:
+ * @group: A #HildonAnimationGroup
+ * @actor: A #HildonAnimationActor
+ *
+ * Adds @actor to @group. If a batch of changes is open on @group, the
+ * changes to @actor made from now on become part of it.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_group_add                      (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor)
+{
+    HildonAnimationGroupPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_GROUP (group));
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (actor));
+
+    priv = group->priv;
+
+    g_return_if_fail (!hildon_animation_group_contains (group, actor));
+
+    g_ptr_array_add (priv->actors, g_object_ref (actor));
+    g_signal_connect (actor, "destroy",
+                      G_CALLBACK (hildon_animation_group_actor_destroyed),
+                      group);
+
+    if (priv->batch_depth > 0)
+        hildon_animation_actor_begin_update (actor);
+}
+
+/**
+ * hildon_animation_group_remove:
+ * @group: A #HildonAnimationGroup
+ * @actor: A #HildonAnimationActor in @group
+ *
+ * Removes @actor from @group. If a batch of changes is open on @group,
+ * the pending changes to @actor are sent right away.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_group_remove                   (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor)
+{
+    HildonAnimationGroupPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_GROUP (group));
+    g_return_if_fail (HILDON_IS_ANIMATION_ACTOR (actor));
+
+    priv = group->priv;
+
+    if (!g_ptr_array_remove (priv->actors, actor))
+        return;
+
+    g_signal_handlers_disconnect_by_func (actor,
+                                          hildon_animation_group_actor_destroyed,
+                                          group);
+    g_hash_table_remove (priv->content_positions, actor);
+
+    if (priv->batch_depth > 0)
+        hildon_animation_actor_commit_update (actor);
+
+    g_object_unref (actor);
+}
+
+/**
+ * hildon_animation_group_get_actors:
+ * @group: A #HildonAnimationGroup
+ *
+ * Returns the actors in @group, in the order they were added.
+ *
+ * Return value: (element-type HildonAnimationActor) (transfer container):
+ * a newly allocated list of #HildonAnimationActor<!-- -->s. Free it
+ * with g_list_free().
+ *
+ * Since: 3.0
+ **/
+GList *
+hildon_animation_group_get_actors               (HildonAnimationGroup *group)
+{
+    GList *actors = NULL;
+    guint i;
+
+    g_return_val_if_fail (HILDON_IS_ANIMATION_GROUP (group), NULL);
+
+    for (i = group->priv->actors->len; i > 0; i--)
+        actors = g_list_prepend (actors,
+                                 g_ptr_array_index (group->priv->actors, i - 1));
+
+    return actors;
+}
+
+/**
+ * hildon_animation_group_begin_update:
+ * @group: A #HildonAnimationGroup
+ *
+ * Starts a batch of changes to all the actors in @group, as if
+ * hildon_animation_actor_begin_update() had been called on each of them.
+ * Nothing is sent to the window manager until the matching
+ * hildon_animation_group_commit_update().
+ *
+ * Calls may be nested; the changes are sent when the outermost batch
+ * is committed.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_group_begin_update             (HildonAnimationGroup *group)
+{
+    HildonAnimationGroupPrivate *priv;
+    guint i;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_GROUP (group));
+
+    priv = group->priv;
+
+    if (priv->batch_depth++ > 0)
+        return;
+
+    for (i = 0; i < priv->actors->len; i++)
+        hildon_animation_actor_begin_update (g_ptr_array_index (priv->actors, i));
+}
+
+/**
+ * hildon_animation_group_commit_update:
+ * @group: A #HildonAnimationGroup
+ *
+ * Ends a batch of changes started with
+ * hildon_animation_group_begin_update(). When the outermost batch is
+ * committed, the properties changed on every actor of @group are sent
+ * to the window manager, and the X connection is flushed once for the
+ * whole group.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_group_commit_update            (HildonAnimationGroup *group)
+{
+    HildonAnimationGroupPrivate *priv;
+    GdkDisplay *display = NULL;
+    guint i;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_GROUP (group));
+
+    priv = group->priv;
+
+    g_return_if_fail (priv->batch_depth > 0);
+
+    if (--priv->batch_depth > 0)
+        return;
+
+    for (i = 0; i < priv->actors->len; i++)
+    {
+        GtkWidget *actor = g_ptr_array_index (priv->actors, i);
+        GdkDisplay *actor_display;
+
+        if (!hildon_animation_actor_commit_update_unflushed (HILDON_ANIMATION_ACTOR (actor)))
+            continue;
+
+        actor_display = gtk_widget_get_display (actor);
+
+        if (display != NULL && display != actor_display)
+            hildon_compositor_flush (display);
+
+        display = actor_display;
+    }
+
+    if (display != NULL)
+        hildon_compositor_flush (display);
+}
+
+/**
+ * hildon_animation_group_set_pannable_area:
+ * @group: A #HildonAnimationGroup
+ * @area: (allow-none): A #HildonPannableArea, or %NULL
+ *
+ * Binds the actors of @group that have a content position to the
+ * content of @area. Whenever @area scrolls or is moved, those actors are
+ * repositioned in one batch, once per frame, so that they stay over the
+ * same part of the content. Their positions are relative to the
+ * toplevel window of @area, which should be the parent of the actors.
+ *
+ * Passing %NULL unbinds @group from the area set before.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_group_set_pannable_area        (HildonAnimationGroup *group,
+                                                 HildonPannableArea   *area)
+{
+    HildonAnimationGroupPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_GROUP (group));
+    g_return_if_fail (area == NULL || HILDON_IS_PANNABLE_AREA (area));
+
+    priv = group->priv;
+
+    if (priv->area == area)
+        return;
+
+    if (priv->area)
+    {
+        if (priv->scroll_tick_id)
+            gtk_widget_remove_tick_callback (GTK_WIDGET (priv->area), priv->scroll_tick_id);
+        priv->scroll_tick_id = 0;
+
+        g_signal_handlers_disconnect_by_func (hildon_pannable_area_get_hadjustment (priv->area),
+                                              hildon_animation_group_content_moved, group);
+        g_signal_handlers_disconnect_by_func (hildon_pannable_area_get_vadjustment (priv->area),
+                                              hildon_animation_group_content_moved, group);
+        g_signal_handlers_disconnect_by_func (priv->area,
+                                              hildon_animation_group_content_moved, group);
+        g_object_unref (priv->area);
+    }
+
+    priv->area = area;
+
+    if (area == NULL)
+        return;
+
+    g_object_ref (area);
+    g_signal_connect_swapped (hildon_pannable_area_get_hadjustment (area), "value-changed",
+                              G_CALLBACK (hildon_animation_group_content_moved), group);
+    g_signal_connect_swapped (hildon_pannable_area_get_vadjustment (area), "value-changed",
+                              G_CALLBACK (hildon_animation_group_content_moved), group);
+    g_signal_connect_swapped (area, "size-allocate",
+                              G_CALLBACK (hildon_animation_group_content_moved), group);
+
+    hildon_animation_group_content_moved (group);
+}
+
+/**
+ * hildon_animation_group_set_content_position:
+ * @group: A #HildonAnimationGroup
+ * @actor: A #HildonAnimationActor in @group
+ * @x: X coordinate in the content of the pannable area
+ * @y: Y coordinate in the content of the pannable area
+ *
+ * Ties @actor to the point (@x, @y) of the content scrolled by the
+ * pannable area of @group, see hildon_animation_group_set_pannable_area().
+ * hildon_animation_group_unset_content_position() lets the application
+ * position @actor by itself again.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_group_set_content_position     (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor,
+                                                 gint                  x,
+                                                 gint                  y)
+{
+    HildonAnimationGroupPrivate *priv;
+    HildonAnimationGroupPosition *position;
+
+    g_return_if_fail (HILDON_IS_ANIMATION_GROUP (group));
+    g_return_if_fail (hildon_animation_group_contains (group, actor));
+
+    priv = group->priv;
+
+    position = g_hash_table_lookup (priv->content_positions, actor);
+    if (position == NULL)
+    {
+        position = g_slice_new (HildonAnimationGroupPosition);
+        g_hash_table_insert (priv->content_positions, actor, position);
+    }
+
+    position->x = x;
+    position->y = y;
+
+    if (priv->area)
+        hildon_animation_group_content_moved (group);
+}
+
+/**
+ * hildon_animation_group_unset_content_position:
+ * @group: A #HildonAnimationGroup
+ * @actor: A #HildonAnimationActor in @group
+ *
+ * Stops moving @actor along with the content of the pannable area of
+ * @group. The actor stays where it was last put.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_animation_group_unset_content_position   (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor)
+{
+    g_return_if_fail (HILDON_IS_ANIMATION_GROUP (group));
+
+    g_hash_table_remove (group->priv->content_positions, actor);
+}
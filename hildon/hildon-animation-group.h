@@ -0,0 +1,119 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_ANIMATION_GROUP_H__
+#define                                         __HILDON_ANIMATION_GROUP_H__
+
+#include                                        "hildon-animation-actor.h"
+#include                                        "hildon-pannable-area.h"
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_ANIMATION_GROUP \
+                                                (hildon_animation_group_get_type())
+
+#define                                         HILDON_ANIMATION_GROUP(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_ANIMATION_GROUP, \
+                                                HildonAnimationGroup))
+
+#define                                         HILDON_ANIMATION_GROUP_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                                HILDON_TYPE_ANIMATION_GROUP, \
+                                                HildonAnimationGroupClass))
+
+#define                                         HILDON_IS_ANIMATION_GROUP(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                                                HILDON_TYPE_ANIMATION_GROUP))
+
+#define                                         HILDON_IS_ANIMATION_GROUP_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+                                                HILDON_TYPE_ANIMATION_GROUP))
+
+#define                                         HILDON_ANIMATION_GROUP_GET_CLASS(obj) \
+                                                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                                HILDON_TYPE_ANIMATION_GROUP, \
+                                                HildonAnimationGroupClass))
+
+typedef struct                                  _HildonAnimationGroup HildonAnimationGroup;
+typedef struct                                  _HildonAnimationGroupClass HildonAnimationGroupClass;
+typedef struct                                  _HildonAnimationGroupPrivate HildonAnimationGroupPrivate;
+
+struct                                          _HildonAnimationGroup
+{
+    GObject parent;
+
+    /* private */
+    HildonAnimationGroupPrivate *priv;
+};
+
+struct                                          _HildonAnimationGroupClass
+{
+    GObjectClass parent_class;
+
+    /* Padding for future extension */
+    void (*_hildon_reserved1)(void);
+    void (*_hildon_reserved2)(void);
+    void (*_hildon_reserved3)(void);
+    void (*_hildon_reserved4)(void);
+};
+
+GType
+hildon_animation_group_get_type                 (void) G_GNUC_CONST;
+
+HildonAnimationGroup *
+hildon_animation_group_new                      (void);
+
+void
+hildon_animation_group_add                      (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor);
+
+void
+hildon_animation_group_remove                   (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor);
+
+GList *
+hildon_animation_group_get_actors               (HildonAnimationGroup *group);
+
+void
+hildon_animation_group_begin_update             (HildonAnimationGroup *group);
+
+void
+hildon_animation_group_commit_update            (HildonAnimationGroup *group);
+
+void
+hildon_animation_group_set_pannable_area        (HildonAnimationGroup *group,
+                                                 HildonPannableArea   *area);
+
+void
+hildon_animation_group_set_content_position     (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor,
+                                                 gint                  x,
+                                                 gint                  y);
+
+void
+hildon_animation_group_unset_content_position   (HildonAnimationGroup *group,
+                                                 HildonAnimationActor *actor);
+
+G_END_DECLS
+
+#endif /* __HILDON_ANIMATION_GROUP_H__ */
@@ -25,6 +25,8 @@ G_BEGIN_DECLS
                                                 (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
                                                 HILDON_TYPE_APP_MENU, HildonAppMenuPrivate));
 
+typedef struct                                  _HildonAppMenuSection HildonAppMenuSection;
+
 struct                                          _HildonAppMenuPrivate
 {
     GtkBox *filters_hbox;
@@ -41,6 +43,13 @@ struct                                          _HildonAppMenuPrivate
     gint width_request;
     guint find_intruder_idle_id;
     guint hide_idle_id;
+    guint repack_idle_id;
+    gint nrows;
+    GMenuModel *model;
+    HildonAppMenuSection *model_section;        /* NULL until first needed */
+    GList *model_buttons;                       /* items made for the model */
+    GList *model_filters;                       /* filters made for the model */
+    GList *button_pool;                         /* unused items, for reuse */
 };
 
 void G_GNUC_INTERNAL
@@ -41,6 +41,11 @@
  * presses the window title bar. Alternatively, you can show it by
  * hand using hildon_app_menu_popup().
  *
+ * The items can also come from a #GMenuModel, see
+ * hildon_app_menu_new_from_model(). The buttons are then only created
+ * when the menu is first needed, so applications can define menus for
+ * all their windows at startup without paying for their widgets.
+ *
  * The menu will be automatically hidden when one of its buttons is
  * clicked. Use g_signal_connect_after() when connecting callbacks to
  * buttons to make sure that they're called after the menu
@@ -105,10 +110,13 @@
 #include                                        "hildon-window.h"
 #include                                        "hildon-banner.h"
 #include                                        "hildon-animation-actor.h"
+#include                                        "hildon-private.h"
+
+static void
+hildon_app_menu_repack_items                    (HildonAppMenu *menu);
 
 static void
-hildon_app_menu_repack_items                    (HildonAppMenu *menu,
-                                                 gint           start_from);
+hildon_app_menu_queue_repack_items              (HildonAppMenu *menu);
 
 static void
 hildon_app_menu_repack_filters                  (HildonAppMenu *menu);
@@ -195,7 +203,7 @@ hildon_app_menu_insert                          (HildonAppMenu *menu,
     g_object_ref_sink (item);
     priv->buttons = g_list_insert (priv->buttons, item, position);
     if (gtk_widget_get_visible (GTK_WIDGET (item)))
-        hildon_app_menu_repack_items (menu, position);
+        hildon_app_menu_queue_repack_items (menu);
 
     /* Enable accelerators */
     g_signal_connect (item, "can-activate-accel", G_CALLBACK (can_activate_accel), NULL);
@@ -274,7 +282,7 @@ hildon_app_menu_reorder_child                   (HildonAppMenu *menu,
     priv->buttons = g_list_remove (priv->buttons, item);
     priv->buttons = g_list_insert (priv->buttons, item, position);
 
-    hildon_app_menu_repack_items (menu, MIN (old_position, position));
+    hildon_app_menu_queue_repack_items (menu);
 }
 
 /**
@@ -321,6 +329,396 @@ hildon_app_menu_add_filter                      (HildonAppMenu *menu,
     g_signal_emit (menu, app_menu_signals[CHANGED], 0);
 }
 
+/*
+ * Menu models.
+ *
+ * Each model shown by the menu, the main one or one of its sections,
+ * has a HildonAppMenuSection with one entry per item: either the
+ * button made for it or, for sections of the main model, the
+ * HildonAppMenuSection of the section. The entries follow
+ * GMenuModel::items-changed, so only the buttons of the items that
+ * changed are made again. Buttons of removed items are kept in a pool
+ * and given to the next items, of the same model or of a new one.
+ */
+struct                                          _HildonAppMenuSection
+{
+    HildonAppMenu *menu;
+    GMenuModel *model;
+    gulong items_changed_id;
+    gboolean is_toplevel;
+    gboolean filters;                           /* its items are filters */
+    GArray *entries;
+};
+
+typedef struct
+{
+    GtkWidget *button;
+    HildonAppMenuSection *section;
+} HildonAppMenuEntry;
+
+static HildonAppMenuSection *
+hildon_app_menu_section_new                     (HildonAppMenu *menu,
+                                                 GMenuModel    *model,
+                                                 gboolean       is_toplevel,
+                                                 gboolean       filters);
+
+static void
+hildon_app_menu_section_free                    (HildonAppMenuSection *section);
+
+static GtkWidget *
+hildon_app_menu_model_button_new                (HildonAppMenu *menu,
+                                                 GMenuModel    *model,
+                                                 gint           position,
+                                                 gboolean       filter)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+    GtkWidget *button;
+    gchar *label = NULL;
+    gchar *action = NULL;
+    GVariant *target;
+
+    g_menu_model_get_item_attribute (model, position, G_MENU_ATTRIBUTE_LABEL, "s", &label);
+    g_menu_model_get_item_attribute (model, position, G_MENU_ATTRIBUTE_ACTION, "s", &action);
+    target = g_menu_model_get_item_attribute_value (model, position,
+                                                    G_MENU_ATTRIBUTE_TARGET, NULL);
+
+    if (!filter && priv->button_pool != NULL) {
+        button = priv->button_pool->data;
+        priv->button_pool = g_list_delete_link (priv->button_pool, priv->button_pool);
+    } else {
+        button = filter ? gtk_toggle_button_new () : gtk_button_new ();
+        gtk_button_set_use_underline (GTK_BUTTON (button), TRUE);
+        hildon_gtk_widget_set_theme_size (button, filter ?
+                                          HILDON_SIZE_FINGER_HEIGHT | HILDON_SIZE_AUTO_WIDTH :
+                                          HILDON_SIZE_FINGER_HEIGHT);
+        g_object_ref_sink (button);
+
+        /* Close the menu when the button is clicked */
+        g_signal_connect_swapped (button, "clicked", G_CALLBACK (gtk_widget_hide), menu);
+    }
+
+    gtk_button_set_label (GTK_BUTTON (button), label);
+    gtk_actionable_set_action_name (GTK_ACTIONABLE (button), action);
+    gtk_actionable_set_action_target_value (GTK_ACTIONABLE (button), target);
+    gtk_widget_show (button);
+
+    g_free (label);
+    g_free (action);
+    if (target)
+        g_variant_unref (target);
+
+    return button;
+}
+
+/* Takes @button out of the menu, items go to the pool */
+static void
+hildon_app_menu_model_button_release            (HildonAppMenu *menu,
+                                                 GtkWidget     *button,
+                                                 gboolean       filter)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+    GtkWidget *parent = gtk_widget_get_parent (button);
+
+    /* The container owns the buttons that are packed */
+    if (parent) {
+        g_object_ref (button);
+        gtk_container_remove (GTK_CONTAINER (parent), button);
+    }
+
+    if (filter) {
+        g_object_unref (button);
+    } else {
+        gtk_actionable_set_action_name (GTK_ACTIONABLE (button), NULL);
+        priv->button_pool = g_list_prepend (priv->button_pool, button);
+    }
+}
+
+static void
+hildon_app_menu_section_insert                  (HildonAppMenuSection *section,
+                                                 gint                  position,
+                                                 gint                  n_items)
+{
+    gint i;
+
+    for (i = position; i < position + n_items; i++) {
+        HildonAppMenuEntry entry = { NULL, NULL };
+        GMenuModel *link = NULL;
+
+        /* Sections are only looked for in the main model */
+        if (section->is_toplevel)
+            link = g_menu_model_get_item_link (section->model, i, G_MENU_LINK_SECTION);
+
+        if (link) {
+            gchar *hint = NULL;
+
+            g_menu_model_get_item_attribute (section->model, i, "display-hint", "s", &hint);
+            entry.section = hildon_app_menu_section_new (section->menu, link, FALSE,
+                                                         g_strcmp0 (hint, "filters") == 0);
+            g_free (hint);
+            g_object_unref (link);
+        } else {
+            entry.button = hildon_app_menu_model_button_new (section->menu, section->model,
+                                                             i, section->filters);
+        }
+
+        g_array_insert_val (section->entries, i, entry);
+    }
+}
+
+static void
+hildon_app_menu_section_remove                  (HildonAppMenuSection *section,
+                                                 gint                  position,
+                                                 gint                  n_items)
+{
+    gint i;
+
+    for (i = position; i < position + n_items; i++) {
+        HildonAppMenuEntry *entry = &g_array_index (section->entries, HildonAppMenuEntry, i);
+
+        if (entry->section)
+            hildon_app_menu_section_free (entry->section);
+        else
+            hildon_app_menu_model_button_release (section->menu, entry->button,
+                                                  section->filters);
+    }
+
+    g_array_remove_range (section->entries, position, n_items);
+}
+
+static void
+hildon_app_menu_section_collect                 (HildonAppMenuSection *section,
+                                                 GList               **buttons,
+                                                 GList               **filters)
+{
+    guint i;
+
+    for (i = 0; i < section->entries->len; i++) {
+        HildonAppMenuEntry *entry = &g_array_index (section->entries, HildonAppMenuEntry, i);
+
+        if (entry->section)
+            hildon_app_menu_section_collect (entry->section, buttons, filters);
+        else if (section->filters)
+            *filters = g_list_prepend (*filters, entry->button);
+        else
+            *buttons = g_list_prepend (*buttons, entry->button);
+    }
+}
+
+/* Updates the lists of buttons after the entries changed, repacking
+ * only moves the buttons whose cell changed */
+static void
+hildon_app_menu_model_update                    (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+    GList *buttons = NULL;
+    GList *filters = NULL;
+    gboolean filters_changed;
+
+    if (priv->model_section)
+        hildon_app_menu_section_collect (priv->model_section, &buttons, &filters);
+
+    buttons = g_list_reverse (buttons);
+    filters = g_list_reverse (filters);
+    filters_changed = filters != NULL || priv->model_filters != NULL;
+
+    g_list_free (priv->model_buttons);
+    g_list_free (priv->model_filters);
+    priv->model_buttons = buttons;
+    priv->model_filters = filters;
+
+    hildon_app_menu_queue_repack_items (menu);
+    if (filters_changed)
+        hildon_app_menu_repack_filters (menu);
+}
+
+static void
+hildon_app_menu_section_items_changed           (GMenuModel           *model,
+                                                 gint                  position,
+                                                 gint                  removed,
+                                                 gint                  added,
+                                                 HildonAppMenuSection *section)
+{
+    HildonAppMenu *menu = section->menu;
+
+    hildon_app_menu_section_remove (section, position, removed);
+    hildon_app_menu_section_insert (section, position, added);
+
+    hildon_app_menu_model_update (menu);
+    g_signal_emit (menu, app_menu_signals[CHANGED], 0);
+}
+
+static HildonAppMenuSection *
+hildon_app_menu_section_new                     (HildonAppMenu *menu,
+                                                 GMenuModel    *model,
+                                                 gboolean       is_toplevel,
+                                                 gboolean       filters)
+{
+    HildonAppMenuSection *section = g_slice_new (HildonAppMenuSection);
+
+    section->menu = menu;
+    section->model = g_object_ref (model);
+    section->is_toplevel = is_toplevel;
+    section->filters = filters;
+    section->entries = g_array_new (FALSE, FALSE, sizeof (HildonAppMenuEntry));
+    section->items_changed_id =
+        g_signal_connect (model, "items-changed",
+                          G_CALLBACK (hildon_app_menu_section_items_changed), section);
+
+    hildon_app_menu_section_insert (section, 0, g_menu_model_get_n_items (model));
+
+    return section;
+}
+
+static void
+hildon_app_menu_section_free                    (HildonAppMenuSection *section)
+{
+    hildon_app_menu_section_remove (section, 0, section->entries->len);
+    g_array_free (section->entries, TRUE);
+
+    g_signal_handler_disconnect (section->model, section->items_changed_id);
+    g_object_unref (section->model);
+
+    g_slice_free (HildonAppMenuSection, section);
+}
+
+/* Makes the buttons of the model, if they aren't made yet */
+static void
+hildon_app_menu_ensure_model                    (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    if (priv->model == NULL || priv->model_section != NULL)
+        return;
+
+    priv->model_section = hildon_app_menu_section_new (menu, priv->model, TRUE, FALSE);
+    hildon_app_menu_model_update (menu);
+}
+
+/* Whether @model has something to show, without making any button */
+static gboolean
+hildon_app_menu_model_has_items                 (GMenuModel *model)
+{
+    gint i, n_items;
+    gboolean has_items = FALSE;
+
+    n_items = g_menu_model_get_n_items (model);
+    for (i = 0; i < n_items && !has_items; i++) {
+        GMenuModel *link = g_menu_model_get_item_link (model, i, G_MENU_LINK_SECTION);
+
+        if (link) {
+            has_items = g_menu_model_get_n_items (link) > 0;
+            g_object_unref (link);
+        } else {
+            has_items = TRUE;
+        }
+    }
+
+    return has_items;
+}
+
+/**
+ * hildon_app_menu_new_from_model:
+ * @model: a #GMenuModel
+ *
+ * Creates a new #HildonAppMenu showing the items of @model, see
+ * hildon_app_menu_set_menu_model().
+ *
+ * Return value: A #HildonAppMenu.
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_app_menu_new_from_model                  (GMenuModel *model)
+{
+    GtkWidget *menu;
+
+    g_return_val_if_fail (G_IS_MENU_MODEL (model), NULL);
+
+    menu = hildon_app_menu_new ();
+    hildon_app_menu_set_menu_model (HILDON_APP_MENU (menu), model);
+
+    return menu;
+}
+
+/**
+ * hildon_app_menu_set_menu_model:
+ * @menu: a #HildonAppMenu
+ * @model: (allow-none): a #GMenuModel, or %NULL
+ *
+ * Makes @menu show the items of @model, before the ones added with
+ * hildon_app_menu_append() and friends. Each item of @model becomes a
+ * button activating the action of the item, and the items of its
+ * sections follow in order. The items of a section with a
+ * "display-hint" attribute of "filters" become filters: toggle buttons
+ * showing the state of their action.
+ *
+ * The actions are looked up in the action groups of @menu, add them
+ * with gtk_widget_insert_action_group().
+ *
+ * The buttons are only made when @menu is first shown or prepared, see
+ * hildon_app_menu_prepare(). After that, when @model changes only the
+ * buttons of the changed items are made again, reusing the buttons of
+ * the items that went away.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_app_menu_set_menu_model                  (HildonAppMenu *menu,
+                                                 GMenuModel    *model)
+{
+    HildonAppMenuPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_APP_MENU (menu));
+    g_return_if_fail (model == NULL || G_IS_MENU_MODEL (model));
+
+    priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    if (model == priv->model)
+        return;
+
+    if (model)
+        g_object_ref (model);
+
+    /* The buttons stay in the pool for the new model */
+    if (priv->model_section) {
+        hildon_app_menu_section_free (priv->model_section);
+        priv->model_section = NULL;
+        hildon_app_menu_model_update (menu);
+    }
+
+    if (priv->model)
+        g_object_unref (priv->model);
+    priv->model = model;
+
+    /* Don't wait for the next popup if the menu was already set up */
+    if (gtk_widget_get_realized (GTK_WIDGET (menu)))
+        hildon_app_menu_ensure_model (menu);
+
+    g_signal_emit (menu, app_menu_signals[CHANGED], 0);
+}
+
+/**
+ * hildon_app_menu_get_menu_model:
+ * @menu: a #HildonAppMenu
+ *
+ * Gets the model set with hildon_app_menu_set_menu_model().
+ *
+ * Returns: (transfer none): the #GMenuModel of @menu, or %NULL
+ *
+ * Since: 3.0
+ **/
+GMenuModel *
+hildon_app_menu_get_menu_model                  (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv;
+
+    g_return_val_if_fail (HILDON_IS_APP_MENU (menu), NULL);
+
+    priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    return priv->model;
+}
+
 static void
 hildon_app_menu_set_columns                     (HildonAppMenu *menu,
                                                  guint          columns)
@@ -334,7 +732,7 @@ hildon_app_menu_set_columns                     (HildonAppMenu *menu,
 
     if (columns != priv->columns) {
         priv->columns = columns;
-        hildon_app_menu_repack_items (menu, 0);
+        hildon_app_menu_queue_repack_items (menu);
     }
 }
 
@@ -396,12 +794,14 @@ hildon_app_menu_get_parent_window              (HildonAppMenu *self)
 }
 
 static void
-screen_size_changed                            (GdkScreen     *screen,
-                                                HildonAppMenu *menu)
+screen_size_changed                            (GtkWidget                  *widget,
+                                                const HildonScreenGeometry *geometry)
 {
-    hildon_app_menu_apply_style (GTK_WIDGET (menu));
+    HildonAppMenu *menu = HILDON_APP_MENU (widget);
 
-    if (gdk_screen_get_width (screen) > gdk_screen_get_height (screen)) {
+    hildon_app_menu_apply_style (widget);
+
+    if (!geometry->portrait) {
         hildon_app_menu_set_columns (menu, 2);
     } else {
         hildon_app_menu_set_columns (menu, 1);
@@ -424,7 +824,7 @@ item_visibility_changed                         (GtkWidget     *item,
     HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
 
     if (! priv->inhibit_repack)
-        hildon_app_menu_repack_items (menu, g_list_index (priv->buttons, item));
+        hildon_app_menu_queue_repack_items (menu);
     g_signal_emit (menu, app_menu_signals[CHANGED], 0);
 }
 
@@ -468,11 +868,66 @@ hildon_app_menu_show_all                        (GtkWidget *widget)
 
     priv->inhibit_repack = FALSE;
 
-    hildon_app_menu_repack_items (menu, 0);
+    hildon_app_menu_queue_repack_items (menu);
     hildon_app_menu_repack_filters (menu);
 }
 
 
+/* Windows that could come between a menu and its parent window:
+ * mapped modal windows and banners */
+static gboolean
+is_intruder_candidate                           (GtkWidget *widget)
+{
+    return GTK_IS_WINDOW (widget) && gtk_widget_get_mapped (widget) &&
+        (HILDON_IS_BANNER (widget) || gtk_window_get_modal (GTK_WINDOW (widget)));
+}
+
+static void
+hildon_app_menu_queue_find_intruder             (HildonAppMenu *menu);
+
+static void
+intruder_candidate_changed                      (GtkWidget     *window,
+                                                 HildonAppMenu *menu)
+{
+    if (is_intruder_candidate (window))
+        hildon_app_menu_queue_find_intruder (menu);
+}
+
+static void
+intruder_candidate_modal_notify                 (GtkWidget     *window,
+                                                 GParamSpec    *pspec,
+                                                 HildonAppMenu *menu)
+{
+    intruder_candidate_changed (window, menu);
+}
+
+/* While @menu is shown, the toplevels that become modal or get mapped
+ * are checked again. Only the toplevels of the process are watched,
+ * and only for as long as the menu is mapped */
+static void
+watch_intruder_candidates                       (HildonAppMenu *menu,
+                                                 gboolean       watch)
+{
+    GList *toplevels, *l;
+
+    toplevels = gtk_window_list_toplevels ();
+    for (l = toplevels; l != NULL; l = l->next) {
+        if (l->data == (gpointer) menu)
+            continue;
+
+        if (watch) {
+            g_signal_connect_object (l->data, "notify::modal",
+                                     G_CALLBACK (intruder_candidate_modal_notify), menu, 0);
+            g_signal_connect_object (l->data, "map",
+                                     G_CALLBACK (intruder_candidate_changed), menu, 0);
+        } else {
+            g_signal_handlers_disconnect_by_func (l->data, intruder_candidate_modal_notify, menu);
+            g_signal_handlers_disconnect_by_func (l->data, intruder_candidate_changed, menu);
+        }
+    }
+    g_list_free (toplevels);
+}
+
 /*
  * There's a race condition that can freeze the UI if a dialog appears
  * between a HildonAppMenu and its parent window, see NB#100468
@@ -488,14 +943,27 @@ hildon_app_menu_find_intruder                   (gpointer data)
     /* If there's a modal window between the menu and its parent window, hide the menu */
     if (priv->parent_window) {
         gboolean intruder_found = FALSE;
-        GdkScreen *screen = gtk_widget_get_screen (widget);
-        GList *stack = gdk_screen_get_window_stack (screen);
-        GList *parent_pos = g_list_find (stack, gtk_widget_get_window (GTK_WIDGET (priv->parent_window)));
-        GList *toplevels = gtk_window_list_toplevels ();
+        GList *candidates = NULL;
+        GList *toplevels;
         GList *i;
 
-        for (i = toplevels; i != NULL && !intruder_found; i = i->next) {
-            if (i->data != widget && i->data != priv->parent_window) {
+        /* Only windows that could be intruders need the stacking
+         * order, which takes a round trip to the X server; usually
+         * there are none */
+        toplevels = gtk_window_list_toplevels ();
+        for (i = toplevels; i != NULL; i = i->next) {
+            if (i->data != (gpointer) widget && i->data != (gpointer) priv->parent_window &&
+                is_intruder_candidate (i->data))
+                candidates = g_list_prepend (candidates, i->data);
+        }
+        g_list_free (toplevels);
+
+        if (candidates) {
+            GdkScreen *screen = gtk_widget_get_screen (widget);
+            GList *stack = gdk_screen_get_window_stack (screen);
+            GList *parent_pos = g_list_find (stack, gtk_widget_get_window (GTK_WIDGET (priv->parent_window)));
+
+            for (i = candidates; i != NULL && !intruder_found; i = i->next) {
                 if (g_list_find (parent_pos, gtk_widget_get_window (GTK_WIDGET (i->data)))) {
                     /* HildonBanners are not closed automatically when
                      * a new window appears, so we must close them by
@@ -503,16 +971,16 @@ hildon_app_menu_find_intruder                   (gpointer data)
                      * Yes, this is a hack. See NB#111027 */
                     if (HILDON_IS_BANNER (i->data)) {
                         gtk_widget_hide (i->data);
-                    } else if (GTK_IS_WINDOW (i->data)) {
-                        intruder_found = gtk_window_get_modal (i->data);
+                    } else {
+                        intruder_found = TRUE;
                     }
                 }
             }
-        }
 
-        g_list_foreach (stack, (GFunc) g_object_unref, NULL);
-        g_list_free (stack);
-        g_list_free (toplevels);
+            g_list_foreach (stack, (GFunc) g_object_unref, NULL);
+            g_list_free (stack);
+            g_list_free (candidates);
+        }
 
         if (intruder_found)
             gtk_widget_hide (widget);
@@ -522,16 +990,31 @@ hildon_app_menu_find_intruder                   (gpointer data)
 }
 
 static void
-hildon_app_menu_map                             (GtkWidget *widget)
+hildon_app_menu_queue_find_intruder             (HildonAppMenu *menu)
 {
-    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE(widget);
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    if (priv->find_intruder_idle_id == 0)
+        priv->find_intruder_idle_id = hildon_job_add (
+            GTK_WIDGET (menu), HILDON_JOB_PRIORITY_HIGH, 100, hildon_app_menu_find_intruder,
+            g_object_ref (menu), g_object_unref);
+}
 
+static void
+hildon_app_menu_map                             (GtkWidget *widget)
+{
     GTK_WIDGET_CLASS (hildon_app_menu_parent_class)->map (widget);
 
-    if (priv->find_intruder_idle_id == 0)
-        priv->find_intruder_idle_id = gdk_threads_add_timeout_full (
-            G_PRIORITY_DEFAULT_IDLE, 100, hildon_app_menu_find_intruder,
-            g_object_ref (widget), g_object_unref);
+    watch_intruder_candidates (HILDON_APP_MENU (widget), TRUE);
+    hildon_app_menu_queue_find_intruder (HILDON_APP_MENU (widget));
+}
+
+static void
+hildon_app_menu_unmap                           (GtkWidget *widget)
+{
+    watch_intruder_candidates (HILDON_APP_MENU (widget), FALSE);
+
+    GTK_WIDGET_CLASS (hildon_app_menu_parent_class)->unmap (widget);
 }
 
 static void
@@ -603,7 +1086,9 @@ hildon_app_menu_key_press                       (GtkWidget   *widget,
 
             if (gtk_accel_group_query (accel_group, accel_key, accel_mods, NULL)) {
                 gtk_window_activate_key (parent_window, event);
-                priv->hide_idle_id = gdk_threads_add_idle (hildon_app_menu_hide_idle, widget);
+                if (priv->hide_idle_id == 0)
+                    priv->hide_idle_id = hildon_job_add (widget, HILDON_JOB_PRIORITY_HIGH, 0,
+                                                         hildon_app_menu_hide_idle, widget, NULL);
                 break;
             }
         }
@@ -637,7 +1122,8 @@ hildon_app_menu_realize                         (GtkWidget *widget)
     Atom property, window_type;
     Display *xdisplay;
     GdkDisplay *gdkdisplay;
-    GdkScreen *screen;
+
+    hildon_trace_begin ("app-menu-realize");
 
     GTK_WIDGET_CLASS (hildon_app_menu_parent_class)->realize (widget);
 
@@ -646,25 +1132,25 @@ hildon_app_menu_realize                         (GtkWidget *widget)
     gdkdisplay = gdk_window_get_display (gtk_widget_get_window (widget));
     xdisplay = GDK_WINDOW_XDISPLAY (gtk_widget_get_window (widget));
 
-    property = gdk_x11_get_xatom_by_name_for_display (gdkdisplay, "_NET_WM_WINDOW_TYPE");
-    window_type = XInternAtom (xdisplay, "_HILDON_WM_WINDOW_TYPE_APP_MENU", False);
+    property = hildon_get_xatom (gdkdisplay, HILDON_ATOM_NET_WM_WINDOW_TYPE);
+    window_type = hildon_get_xatom (gdkdisplay, HILDON_ATOM_HILDON_WM_WINDOW_TYPE_APP_MENU);
     XChangeProperty (xdisplay, GDK_WINDOW_XID (gtk_widget_get_window (widget)), property,
                      XA_ATOM, 32, PropModeReplace, (guchar *) &window_type, 1);
 
     /* Detect any screen changes */
-    screen = gtk_widget_get_screen (widget);
-    g_signal_connect (screen, "size-changed", G_CALLBACK (screen_size_changed), widget);
+    hildon_watch_screen (widget, screen_size_changed);
 
     /* Force menu to set the initial layout */
-    screen_size_changed (screen, HILDON_APP_MENU (widget));
+    screen_size_changed (widget, hildon_get_screen_geometry (gtk_widget_get_screen (widget)));
+
+    hildon_trace_end ("app-menu-realize");
 }
 
 static void
 hildon_app_menu_unrealize                       (GtkWidget *widget)
 {
-    GdkScreen *screen = gtk_widget_get_screen (widget);
-    /* Disconnect "size-changed" signal handler */
-    g_signal_handlers_disconnect_by_func (screen, G_CALLBACK (screen_size_changed), widget);
+    /* Stop following screen changes */
+    hildon_unwatch_screen (widget);
 
     GTK_WIDGET_CLASS (hildon_app_menu_parent_class)->unrealize (widget);
 }
@@ -672,7 +1158,7 @@ hildon_app_menu_unrealize                       (GtkWidget *widget)
 static void
 hildon_app_menu_apply_style                     (GtkWidget *widget)
 {
-    GdkScreen *screen;
+    const HildonScreenGeometry *geometry;
     gint filter_group_width;
     guint horizontal_spacing, vertical_spacing, filter_vertical_spacing;
     guint inner_border, external_border;
@@ -701,11 +1187,11 @@ hildon_app_menu_apply_style                     (GtkWidget *widget)
     gtk_widget_set_size_request (GTK_WIDGET (priv->filters_hbox), filter_group_width, -1);
 
     /* Compute width request */
-    screen = gtk_widget_get_screen (widget);
-    if (gdk_screen_get_width (screen) < gdk_screen_get_height (screen)) {
+    geometry = hildon_get_screen_geometry (gtk_widget_get_screen (widget));
+    if (geometry->portrait) {
         external_border = 0;
     }
-    priv->width_request = gdk_screen_get_width (screen) - external_border * 2;
+    priv->width_request = geometry->width - external_border * 2;
 
     if (gtk_widget_get_window (widget))
       gdk_window_move_resize (gtk_widget_get_window (widget),
@@ -727,24 +1213,36 @@ static void
 hildon_app_menu_repack_filters                  (HildonAppMenu *menu)
 {
     HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE(menu);
+    GList *lists[2];
     GList *iter;
+    guint i;
 
-    for (iter = priv->filters; iter != NULL; iter = iter->next) {
-        GtkWidget *filter = GTK_WIDGET (iter->data);
-        GtkWidget *parent = gtk_widget_get_parent (filter);
-        if (parent) {
-            g_object_ref (filter);
-            gtk_container_remove (GTK_CONTAINER (parent), filter);
+    HILDON_PERF (APP_MENU_REPACKS);
+
+    /* The filters of the model come first */
+    lists[0] = priv->model_filters;
+    lists[1] = priv->filters;
+
+    for (i = 0; i < G_N_ELEMENTS (lists); i++) {
+        for (iter = lists[i]; iter != NULL; iter = iter->next) {
+            GtkWidget *filter = GTK_WIDGET (iter->data);
+            GtkWidget *parent = gtk_widget_get_parent (filter);
+            if (parent) {
+                g_object_ref (filter);
+                gtk_container_remove (GTK_CONTAINER (parent), filter);
+            }
         }
     }
 
-    for (iter = priv->filters; iter != NULL; iter = iter->next) {
-        GtkWidget *filter = GTK_WIDGET (iter->data);
-        if (gtk_widget_get_visible (filter)) {
-            gtk_box_pack_start (GTK_BOX (priv->filters_hbox), filter, TRUE, TRUE, 0);
-            g_object_unref (filter);
-            /* GtkButton must be realized for accelerators to work */
-            gtk_widget_realize (filter);
+    for (i = 0; i < G_N_ELEMENTS (lists); i++) {
+        for (iter = lists[i]; iter != NULL; iter = iter->next) {
+            GtkWidget *filter = GTK_WIDGET (iter->data);
+            if (gtk_widget_get_visible (filter)) {
+                gtk_box_pack_start (GTK_BOX (priv->filters_hbox), filter, TRUE, TRUE, 0);
+                g_object_unref (filter);
+                /* GtkButton must be realized for accelerators to work */
+                gtk_widget_realize (filter);
+            }
         }
     }
 }
@@ -752,51 +1250,56 @@ hildon_app_menu_repack_filters                  (HildonAppMenu *menu)
 /*
  * When items displayed in the menu change (e.g, a new item is added,
  * an item is hidden or the list is reordered), the layout must be
- * updated. To do this we repack all items starting from a given one.
+ * updated. Items that are already in the grid are only moved if their
+ * cell changes, and hidden items stay where they are (the grid
+ * ignores them), so that showing them again is cheap.
  */
 static void
-hildon_app_menu_repack_items                    (HildonAppMenu *menu,
-                                                 gint           start_from)
+hildon_app_menu_repack_items                    (HildonAppMenu *menu)
 {
     HildonAppMenuPrivate *priv;
-    gint row, col, nvisible, i;
+    gint row, col, nvisible, nrows;
+    GList *lists[2];
     GList *iter;
+    guint i;
 
     priv = HILDON_APP_MENU_GET_PRIVATE(menu);
 
-    i = nvisible = 0;
-    for (iter = priv->buttons; iter != NULL; iter = iter->next) {
-        /* Count number of visible items */
-        if (gtk_widget_get_visible (iter->data))
-            nvisible++;
-        /* Remove buttons from their parent */
-        if (start_from != -1 && i >= start_from) {
-            GtkWidget *item = GTK_WIDGET (iter->data);
-            GtkWidget *parent = gtk_widget_get_parent (item);
-            if (parent) {
-                g_object_ref (item);
-                gtk_container_remove (GTK_CONTAINER (parent), item);
-            }
-        }
-        i++;
-    }
+    HILDON_PERF (APP_MENU_REPACKS);
 
-    /* If items have been removed, recalculate the size of the menu */
-    if (start_from != -1)
-        gtk_window_resize (GTK_WINDOW (menu), 1, 1);
+    if (priv->repack_idle_id) {
+        g_source_remove (priv->repack_idle_id);
+        priv->repack_idle_id = 0;
+    }
 
-    /* Add buttons */
     row = col = 1;
-    for (iter = priv->buttons; iter != NULL; iter = iter->next) {
-        GtkWidget *item = GTK_WIDGET (iter->data);
-        if (gtk_widget_get_visible (item)) {
-            /* Don't add an item to the grid if it's already there */
+    nvisible = 0;
+    /* The items of the model come first */
+    lists[0] = priv->model_buttons;
+    lists[1] = priv->buttons;
+
+    for (i = 0; i < G_N_ELEMENTS (lists); i++) {
+        for (iter = lists[i]; iter != NULL; iter = iter->next) {
+            GtkWidget *item = GTK_WIDGET (iter->data);
+
+            if (!gtk_widget_get_visible (item))
+                continue;
+
             if (gtk_widget_get_parent (item) == NULL) {
                 gtk_grid_attach (priv->grid, item, col, row, 1, 1);
                 g_object_unref (item);
                 /* GtkButton must be realized for accelerators to work */
                 gtk_widget_realize (item);
+            } else {
+                gint left, top;
+                gtk_container_child_get (GTK_CONTAINER (priv->grid), item,
+                                         "left-attach", &left, "top-attach", &top, NULL);
+                if (left != col || top != row)
+                    gtk_container_child_set (GTK_CONTAINER (priv->grid), item,
+                                             "left-attach", col, "top-attach", row, NULL);
             }
+
+            nvisible++;
             if (++col == priv->columns+1) {
                 col = 1;
                 row++;
@@ -804,7 +1307,35 @@ hildon_app_menu_repack_items                    (HildonAppMenu *menu,
         }
     }
 
-    gtk_widget_queue_draw (GTK_WIDGET (menu));
+    /* If the number of rows has changed, recalculate the size of the menu */
+    nrows = (nvisible + priv->columns - 1) / priv->columns;
+    if (nrows != priv->nrows) {
+        priv->nrows = nrows;
+        gtk_window_resize (GTK_WINDOW (menu), 1, 1);
+    }
+}
+
+static gboolean
+hildon_app_menu_repack_idle                     (gpointer menu)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    priv->repack_idle_id = 0;
+    hildon_app_menu_repack_items (HILDON_APP_MENU (menu));
+    return FALSE;
+}
+
+/* Changes to the items are often done in bursts, so the grid is only
+ * updated once, before the next relayout of the menu */
+static void
+hildon_app_menu_queue_repack_items              (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    if (priv->repack_idle_id == 0)
+        priv->repack_idle_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                                          hildon_app_menu_repack_idle,
+                                                          menu, NULL);
 }
 
 /**
@@ -828,6 +1359,16 @@ hildon_app_menu_has_visible_children (HildonAppMenu *menu)
 
     priv = HILDON_APP_MENU_GET_PRIVATE (menu);
 
+    /* The buttons of the model may not be made yet */
+    if (priv->model_section == NULL && priv->model != NULL)
+        show_menu = hildon_app_menu_model_has_items (priv->model);
+
+    for (i = priv->model_buttons; i && !show_menu; i = i->next)
+        show_menu = gtk_widget_get_visible (i->data);
+
+    for (i = priv->model_filters; i && !show_menu; i = i->next)
+        show_menu = gtk_widget_get_visible (i->data);
+
     /* Don't show menu if it doesn't contain visible items */
     for (i = priv->buttons; i && !show_menu; i = i->next)
         show_menu = gtk_widget_get_visible (i->data);
@@ -855,14 +1396,63 @@ hildon_app_menu_popup                           (HildonAppMenu *menu,
     g_return_if_fail (HILDON_IS_APP_MENU (menu));
     g_return_if_fail (GTK_IS_WINDOW (parent_window));
 
+    HILDON_PROBE1 (app_menu__popup__start, menu);
+    HILDON_WATCH_ENTER ("app-menu-popup");
+
     if (hildon_app_menu_has_visible_children (menu)) {
+        HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
         GtkWindowGroup *group;
+        /* The window is sized right away when shown, so the grid must
+         * be up to date */
+        hildon_app_menu_ensure_model (menu);
+        if (priv->repack_idle_id)
+            hildon_app_menu_repack_items (menu);
         hildon_app_menu_set_parent_window (menu, parent_window);
         group = gtk_window_get_group (parent_window);
         gtk_window_group_add_window (group, GTK_WINDOW (menu));
         gtk_widget_show (GTK_WIDGET (menu));
     }
 
+    HILDON_WATCH_LEAVE ("app-menu-popup");
+    HILDON_PROBE1 (app_menu__popup__end, menu);
+}
+
+/**
+ * hildon_app_menu_prepare:
+ * @menu: a #HildonAppMenu
+ *
+ * Does in advance the work needed to show @menu: its window is
+ * realized, its items are laid out and buttons and styles are set up.
+ * A #HildonAppMenu is not unrealized when it is hidden, so this is only
+ * needed once. Applications can call this function from an idle
+ * handler after startup, so that the first hildon_app_menu_popup()
+ * has nothing left to do but to map the menu.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_app_menu_prepare                         (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_APP_MENU (menu));
+
+    priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    hildon_trace_begin ("app-menu-prepare");
+
+    /* Realizing sets the initial layout for the screen size */
+    gtk_widget_realize (GTK_WIDGET (menu));
+
+    hildon_app_menu_ensure_model (menu);
+
+    if (priv->repack_idle_id)
+        hildon_app_menu_repack_items (menu);
+
+    /* Compute the size now, so styles and size requests are cached */
+    gtk_widget_get_preferred_size (GTK_WIDGET (menu), NULL, NULL);
+
+    hildon_trace_end ("app-menu-prepare");
 }
 
 /**
@@ -870,7 +1460,8 @@ hildon_app_menu_popup                           (HildonAppMenu *menu,
  * @menu: a #HildonAppMenu
  *
  * Returns a list of all items (regular items, not filters) contained
- * in @menu.
+ * in @menu. The items made for the model of @menu, if any, come first,
+ * see hildon_app_menu_set_menu_model().
  *
  * Returns: a newly-allocated list containing the items in @menu
  *
@@ -885,14 +1476,17 @@ hildon_app_menu_get_items                       (HildonAppMenu *menu)
 
     priv = HILDON_APP_MENU_GET_PRIVATE (menu);
 
-    return g_list_copy (priv->buttons);
+    hildon_app_menu_ensure_model (menu);
+
+    return g_list_concat (g_list_copy (priv->model_buttons), g_list_copy (priv->buttons));
 }
 
 /**
  * hildon_app_menu_get_filters:
  * @menu: a #HildonAppMenu
  *
- * Returns a list of all filters contained in @menu.
+ * Returns a list of all filters contained in @menu. The filters made
+ * for the model of @menu, if any, come first.
  *
  * Returns: a newly-allocated list containing the filters in @menu
  *
@@ -907,7 +1501,9 @@ hildon_app_menu_get_filters                     (HildonAppMenu *menu)
 
     priv = HILDON_APP_MENU_GET_PRIVATE (menu);
 
-    return g_list_copy (priv->filters);
+    hildon_app_menu_ensure_model (menu);
+
+    return g_list_concat (g_list_copy (priv->model_filters), g_list_copy (priv->filters));
 }
 
 static void
@@ -927,6 +1523,13 @@ hildon_app_menu_init                            (HildonAppMenu *menu)
     priv->width_request = -1;
     priv->find_intruder_idle_id = 0;
     priv->hide_idle_id = 0;
+    priv->repack_idle_id = 0;
+    priv->nrows = 0;
+    priv->model = NULL;
+    priv->model_section = NULL;
+    priv->model_buttons = NULL;
+    priv->model_filters = NULL;
+    priv->button_pool = NULL;
 
     /* Create boxes and grids */
     priv->filters_hbox = GTK_BOX (gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0));
@@ -971,6 +1574,31 @@ hildon_app_menu_dispose                         (GObject *object)
     g_list_foreach (priv->buttons, (GFunc) disconnect_weak_refs, object);
     g_list_foreach (priv->filters, (GFunc) disconnect_weak_refs, object);
 
+    /* The buttons of the model must be out of the grid before it is
+       destroyed */
+    if (priv->model_section) {
+        hildon_app_menu_section_free (priv->model_section);
+        priv->model_section = NULL;
+    }
+
+    g_list_free (priv->model_buttons);
+    g_list_free (priv->model_filters);
+    priv->model_buttons = NULL;
+    priv->model_filters = NULL;
+
+    g_list_free_full (priv->button_pool, g_object_unref);
+    priv->button_pool = NULL;
+
+    if (priv->model) {
+        g_object_unref (priv->model);
+        priv->model = NULL;
+    }
+
+    if (priv->repack_idle_id) {
+        g_source_remove (priv->repack_idle_id);
+        priv->repack_idle_id = 0;
+    }
+
     G_OBJECT_CLASS (hildon_app_menu_parent_class)->dispose (object);
 }
 
@@ -980,12 +1608,12 @@ hildon_app_menu_finalize                        (GObject *object)
     HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE(object);
 
     if (priv->find_intruder_idle_id) {
-        g_source_remove (priv->find_intruder_idle_id);
+        hildon_job_remove (priv->find_intruder_idle_id);
         priv->find_intruder_idle_id = 0;
     }
 
     if (priv->hide_idle_id) {
-        g_source_remove (priv->hide_idle_id);
+        hildon_job_remove (priv->hide_idle_id);
         priv->hide_idle_id = 0;
     }
 
@@ -1017,6 +1645,7 @@ hildon_app_menu_class_init                      (HildonAppMenuClass *klass)
     gobject_class->finalize = hildon_app_menu_finalize;
     widget_class->show_all = hildon_app_menu_show_all;
     widget_class->map = hildon_app_menu_map;
+    widget_class->unmap = hildon_app_menu_unmap;
     widget_class->realize = hildon_app_menu_realize;
     widget_class->unrealize = hildon_app_menu_unrealize;
     widget_class->grab_notify = hildon_app_menu_grab_notify;
@@ -66,6 +66,16 @@ hildon_app_menu_get_type                        (void) G_GNUC_CONST;
 GtkWidget *
 hildon_app_menu_new                             (void);
 
+GtkWidget *
+hildon_app_menu_new_from_model                  (GMenuModel *model);
+
+void
+hildon_app_menu_set_menu_model                  (HildonAppMenu *menu,
+                                                 GMenuModel    *model);
+
+GMenuModel *
+hildon_app_menu_get_menu_model                  (HildonAppMenu *menu);
+
 void
 hildon_app_menu_append                          (HildonAppMenu *menu,
                                                  GtkButton     *item);
@@ -92,6 +102,9 @@ void
 hildon_app_menu_popup                           (HildonAppMenu *menu,
                                                  GtkWindow     *parent_window);
 
+void
+hildon_app_menu_prepare                         (HildonAppMenu *menu);
+
 GList *
 hildon_app_menu_get_items                       (HildonAppMenu *menu);
 
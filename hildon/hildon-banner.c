@@ -43,16 +43,17 @@
  * Please, take into account that this is only for important information.
  *
  *
- * Two more kinds of banners are maintained for backward compatibility
- * but are no longer recommended in Hildon 2.2. These are the animated
- * banner (created with hildon_banner_show_animation()) and the
- * progress banner (created with hildon_banner_show_progress()). See
- * hildon_gtk_window_set_progress_indicator() for the preferred way of
- * showing progress notifications in Hildon 2.2.
+ * There are no animated or progress banners. Use
+ * hildon_gtk_window_set_progress_indicator() to show that a window is
+ * busy: the indicator is drawn by the window manager, so it costs the
+ * application nothing while it spins.
  *
  * Information banners are automatically destroyed after a certain
  * period. This is stored in the #HildonBanner:timeout property (in
  * miliseconds), and can be changed using hildon_banner_set_timeout().
+ * The banner is hidden first, and only destroyed a few seconds later,
+ * so that a new information for the same window shown in between
+ * reuses it while it is still realized.
  *
  * Note that #HildonBanner<!-- -->s should only be used to display
  * non-critical pieces of information.
@@ -94,17 +95,13 @@
 
 #define                                         HILDON_BANNER_DEFAULT_TIMEOUT 3000
 
-/* default icons */
+/* how long a hidden information banner is kept for the next one, in seconds */
 
-#define                                         HILDON_BANNER_DEFAULT_PROGRESS_ANIMATION "indicator_update"
+#define                                         HILDON_BANNER_REUSE_TIMEOUT 5
 
-/* animation related stuff */
+/* minimum time between two updates of an information banner */
 
-#define                                         HILDON_BANNER_ANIMATION_FRAMERATE ((float)1000/150)
-
-#define                                         HILDON_BANNER_ANIMATION_TMPL "indicator_update%d"
-
-#define                                         HILDON_BANNER_ANIMATION_NFRAMES 8
+#define                                         HILDON_BANNER_MIN_UPDATE_INTERVAL 500
 
 enum 
 {
@@ -188,6 +185,9 @@ hildon_banner_get_instance_for_widget           (GtkWidget *widget,
 static void
 hildon_banner_set_override_flag                 (HildonBanner *banner);
 
+static void
+hildon_banner_forget_message                    (HildonBanner *banner);
+
 static void
 reshow_banner                                   (HildonBanner *banner);
 
@@ -213,6 +213,12 @@ struct                                          _HildonBannerPrivate
     const gchar *name_suffix;
     guint        timeout;
     guint        timeout_id;
+    guint        reuse_id;
+    gchar       *message;
+    guint        message_count;
+    guint        update_id;
+    gint64       last_update;
+    guint        message_is_markup    : 1;
     guint        is_timed             : 1;
     guint        require_override_dnd : 1;
     guint        overrides_dnd        : 1;
@@ -235,18 +241,22 @@ hildon_banner_bind_style                  (HildonBanner *self)
 {
     HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (self);
     GdkScreen *screen = gtk_widget_get_screen (GTK_WIDGET (self));
-    gboolean portrait = gdk_screen_get_width (screen) < gdk_screen_get_height (screen);
+    gboolean portrait = hildon_get_screen_geometry (screen)->portrait;
     const gchar *portrait_suffix = portrait ? "-portrait" : NULL;
     gchar *name;
 
     g_assert (priv);
 
+    /* Banners are reused, and setting the same name again would
+     * still restyle them */
     name = g_strconcat ("HildonBannerLabel-", priv->name_suffix, NULL);
-    gtk_widget_set_name (priv->label, name);
+    if (g_strcmp0 (gtk_widget_get_name (priv->label), name) != 0)
+        gtk_widget_set_name (priv->label, name);
     g_free (name);
 
     name = g_strconcat ("HildonBanner-", priv->name_suffix, portrait_suffix, NULL);
-    gtk_widget_set_name (GTK_WIDGET (self), name);
+    if (g_strcmp0 (gtk_widget_get_name (GTK_WIDGET (self)), name) != 0)
+        gtk_widget_set_name (GTK_WIDGET (self), name);
     g_free (name);
 }
 
@@ -281,6 +291,17 @@ hildon_banner_get_preferred_width               (GtkWidget *self,
     *natural_width = gdk_screen_get_width (gtk_widget_get_screen (self));
 }
 
+static gboolean
+hildon_banner_reuse_timeout                     (gpointer data)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (data);
+
+    priv->reuse_id = 0;
+    gtk_widget_destroy (GTK_WIDGET (data));
+
+    return FALSE;
+}
+
 static gboolean 
 hildon_banner_timeout                           (gpointer data)
 {
@@ -300,7 +321,18 @@ hildon_banner_timeout                           (gpointer data)
             g_source_remove (priv->timeout_id);
             priv->timeout_id = 0;
         }
-        gtk_widget_destroy (widget);
+        /* Timed banners are singletons, so a burst of information
+         * reuses the same window instead of creating a new one each
+         * time. It is still destroyed once the burst is over. */
+        if (priv->is_timed) {
+            gtk_widget_hide (widget);
+            if (priv->reuse_id == 0)
+                priv->reuse_id = gdk_threads_add_timeout_seconds (HILDON_BANNER_REUSE_TIMEOUT,
+                                                                  hildon_banner_reuse_timeout,
+                                                                  widget);
+        } else {
+            gtk_widget_destroy (widget);
+        }
     }
 
     g_object_unref (widget);
@@ -433,6 +465,12 @@ hildon_banner_destroy                           (GtkWidget *object)
     }
 
     (void) hildon_banner_clear_timeout (self);
+    hildon_banner_forget_message (self);
+
+    if (priv->reuse_id) {
+        g_source_remove (priv->reuse_id);
+        priv->reuse_id = 0;
+    }
 
     if (GTK_WIDGET_CLASS (hildon_banner_parent_class)->destroy)
         GTK_WIDGET_CLASS (hildon_banner_parent_class)->destroy (object);
@@ -507,6 +545,16 @@ hildon_banner_constructor                       (GType type,
            assertion `nqueue->freeze_count > 0' failed */
 
         g_object_freeze_notify (banner);
+
+        /* A hidden banner is being reused for a new information */
+        if (timed && !gtk_widget_get_visible (GTK_WIDGET (banner))) {
+            HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+            priv->timeout = HILDON_BANNER_DEFAULT_TIMEOUT;
+            if (priv->reuse_id) {
+                g_source_remove (priv->reuse_id);
+                priv->reuse_id = 0;
+            }
+        }
     }
 
     /* We restart possible timeouts for each new timed banner request */
@@ -538,6 +586,8 @@ hildon_banner_finalize                          (GObject *object)
         g_object_remove_weak_pointer(G_OBJECT (priv->parent), (gpointer) &priv->parent);
     }
 
+    g_free (priv->message);
+
     G_OBJECT_CLASS (hildon_banner_parent_class)->finalize (object);
 }
 
@@ -550,9 +600,9 @@ hildon_banner_button_press_event                (GtkWidget* widget,
     if (!result) {
         /* signal emission not stopped - basically behave like
          * gtk_main_do_event() for a delete event, but just hide the
-         * banner instead of destroying it, as it is already meant to
-         * be destroyed by hildon_banner_timeout() (if it's timed) or
-         * the application (if it's not). */
+         * banner instead of destroying it, as it is kept for reuse
+         * (if it's timed) or meant to be destroyed by the application
+         * (if it's not). */
         gtk_widget_hide (widget);
     }
 
@@ -583,6 +633,12 @@ banner_do_set_text                              (HildonBanner *banner,
 
     priv = HILDON_BANNER_GET_PRIVATE (banner);
 
+    /* Setting the same text again would throw away the layout the
+     * label has measured, and shape it again on the next show */
+    if (!gtk_label_get_use_markup (GTK_LABEL (priv->label)) == !is_markup &&
+        g_strcmp0 (gtk_label_get_label (GTK_LABEL (priv->label)), text) == 0)
+        return;
+
     if (is_markup) {
         gtk_label_set_markup (GTK_LABEL (priv->label), text);
     } else {
@@ -593,7 +649,7 @@ banner_do_set_text                              (HildonBanner *banner,
 static void
 banner_set_label_size_request                   (HildonBanner *banner)
 {
-    int width;
+    int width, current;
     HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
 
     if (priv->is_timed) {
@@ -603,6 +659,11 @@ banner_set_label_size_request                   (HildonBanner *banner)
         width = HILDON_BANNER_LABEL_MAX_PROGRESS;
     }
 
+    /* The label keeps its measurements as long as the width stays */
+    gtk_widget_get_size_request (priv->label, &current, NULL);
+    if (current == width)
+        return;
+
     /* Force the label to compute its layout using the maximum
      * available width rather than its default one.
      */
@@ -610,8 +671,8 @@ banner_set_label_size_request                   (HildonBanner *banner)
 }
 
 static void
-screen_size_changed                            (GdkScreen *screen,
-                                                GtkWindow *banner)
+screen_size_changed                            (GtkWidget                  *banner,
+                                                const HildonScreenGeometry *geometry)
 
 {
     HildonBanner *hbanner = HILDON_BANNER (banner);
@@ -626,7 +687,6 @@ static void
 hildon_banner_realize                           (GtkWidget *widget)
 {
     GdkWindow *gdkwin;
-    GdkScreen *screen;
     GdkAtom atom;
     guint32 portrait = 1;
     const gchar *notification_type = "_HILDON_NOTIFICATION_TYPE_BANNER";
@@ -640,6 +700,8 @@ hildon_banner_realize                           (GtkWidget *widget)
     /* We use special hint to turn the banner into information notification. */
     gdk_window_set_type_hint (gtk_widget_get_window (widget), GDK_WINDOW_TYPE_HINT_NOTIFICATION);
     gtk_window_set_transient_for (GTK_WINDOW (widget), (GtkWindow *) priv->parent);
+    /* Timed banners outlive their timeout, but not their window */
+    gtk_window_set_destroy_with_parent (GTK_WINDOW (widget), priv->is_timed);
 
     gdkwin = gtk_widget_get_window (widget);
 
@@ -659,8 +721,7 @@ hildon_banner_realize                           (GtkWidget *widget)
         priv->overrides_dnd = TRUE;
     }
 
-    screen = gtk_widget_get_screen (widget);
-    g_signal_connect (screen, "size-changed", G_CALLBACK (screen_size_changed), widget);
+    hildon_watch_screen (widget, screen_size_changed);
 
     banner_set_label_size_request (HILDON_BANNER (widget));
 }
@@ -668,8 +729,7 @@ hildon_banner_realize                           (GtkWidget *widget)
 static void
 hildon_banner_unrealize                         (GtkWidget *widget)
 {
-    GdkScreen *screen = gtk_widget_get_screen (widget);
-    g_signal_handlers_disconnect_by_func (screen, G_CALLBACK (screen_size_changed), widget);
+    hildon_unwatch_screen (widget);
 
     GTK_WIDGET_CLASS (hildon_banner_parent_class)->unrealize (widget);
 }
@@ -757,6 +817,10 @@ hildon_banner_init                              (HildonBanner *self)
     priv->require_override_dnd = FALSE;
     priv->name_suffix = NULL;
     priv->main_item = NULL;
+    priv->message = NULL;
+    priv->message_count = 0;
+    priv->update_id = 0;
+    priv->last_update = 0;
 
     /* Initialize the common layout inside banner */
     priv->layout = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, HILDON_MARGIN_DEFAULT);
@@ -809,6 +873,12 @@ hildon_banner_get_instance_for_widget           (GtkWidget *widget,
  * before the earlier one has timed out, the previous one will be
  * replaced.
  *
+ * To avoid flooding the screen, a banner that is already visible is
+ * updated at most twice per second; only the last message requested
+ * in between is displayed. A message that is requested again while
+ * it is being displayed is shown once, followed by the number of
+ * times it was requested.
+ *
  * Returns: The newly created banner
  *
  */
@@ -877,6 +947,96 @@ unpack_main_widget_pack_label                   (HildonBanner *banner)
     }
 }
 
+/* Displays the last queued message, with the number of times it was
+ * repeated */
+static void
+hildon_banner_show_message                      (HildonBanner *banner)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+
+    priv->last_update = g_get_monotonic_time ();
+
+    unpack_main_widget_pack_label (banner);
+    if (priv->message_count > 1) {
+        gchar *text = g_strdup_printf ("%s (%u)", priv->message, priv->message_count);
+        banner_do_set_text (banner, text, priv->message_is_markup);
+        g_free (text);
+    } else {
+        banner_do_set_text (banner, priv->message, priv->message_is_markup);
+    }
+    hildon_banner_bind_style (banner);
+
+    /* Show the banner, since caller cannot do that */
+    reshow_banner (banner);
+}
+
+static gboolean
+hildon_banner_update_timeout                    (gpointer data)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (data);
+
+    priv->update_id = 0;
+    hildon_banner_show_message (HILDON_BANNER (data));
+
+    return FALSE;
+}
+
+static void
+hildon_banner_forget_message                    (HildonBanner *banner)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+
+    if (priv->update_id) {
+        hildon_job_remove (priv->update_id);
+        priv->update_id = 0;
+    }
+
+    g_free (priv->message);
+    priv->message = NULL;
+    priv->message_count = 0;
+}
+
+/* Information banners are often requested in bursts. Repeated messages
+ * are coalesced into one, showing how many times it was repeated, and
+ * the banner is updated at most once every
+ * HILDON_BANNER_MIN_UPDATE_INTERVAL; messages replaced in between are
+ * never displayed. */
+static void
+hildon_banner_queue_message                     (HildonBanner *banner,
+                                                 const gchar  *text,
+                                                 gboolean      is_markup)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+    gint64 elapsed;
+
+    /* Once the user has seen a message, start counting again */
+    if (!gtk_widget_get_visible (GTK_WIDGET (banner)) && priv->update_id == 0)
+        hildon_banner_forget_message (banner);
+
+    if (priv->message && !priv->message_is_markup == !is_markup &&
+        strcmp (priv->message, text) == 0) {
+        priv->message_count++;
+    } else {
+        g_free (priv->message);
+        priv->message = g_strdup (text);
+        priv->message_is_markup = is_markup;
+        priv->message_count = 1;
+    }
+
+    if (priv->update_id != 0)
+        return;
+
+    elapsed = (g_get_monotonic_time () - priv->last_update) / 1000;
+    if (!gtk_widget_get_visible (GTK_WIDGET (banner)) ||
+        elapsed >= HILDON_BANNER_MIN_UPDATE_INTERVAL) {
+        hildon_banner_show_message (banner);
+    } else {
+        priv->update_id = hildon_job_add (GTK_WIDGET (banner), HILDON_JOB_PRIORITY_DEFAULT,
+                                          HILDON_BANNER_MIN_UPDATE_INTERVAL - elapsed,
+                                          hildon_banner_update_timeout, banner, NULL);
+    }
+}
+
 static GtkWidget*
 hildon_banner_real_show_information             (GtkWidget *widget,
                                                  const gchar *text,
@@ -887,22 +1047,32 @@ hildon_banner_real_show_information             (GtkWidget *widget,
 
     g_return_val_if_fail (text != NULL, NULL);
 
+    HILDON_PROBE2 (banner__show__information__start, widget, text);
+    HILDON_WATCH_ENTER ("banner-show");
+
     /* Prepare banner */
     banner = hildon_banner_get_instance_for_widget (widget, TRUE);
     priv = HILDON_BANNER_GET_PRIVATE (banner);
 
     priv->name_suffix = "information";
-    unpack_main_widget_pack_label (banner);
-    banner_do_set_text (banner, text, FALSE);
-    hildon_banner_bind_style (banner);
 
-    if (override_dnd) {
-      /* so on the realize it will set the property */
-      priv->require_override_dnd = TRUE;
+    /* A reused banner may be realized already, and may have been
+     * shown before with a different override flag */
+    priv->require_override_dnd = override_dnd;
+    if (gtk_widget_get_realized (GTK_WIDGET (banner)) &&
+        !priv->overrides_dnd != !override_dnd) {
+        if (override_dnd)
+            hildon_banner_set_override_flag (banner);
+        else
+            gdk_property_delete (gtk_widget_get_window (GTK_WIDGET (banner)),
+                                 gdk_atom_intern_static_string ("_HILDON_DO_NOT_DISTURB_OVERRIDE"));
+        priv->overrides_dnd = override_dnd;
     }
 
-    /* Show the banner, since caller cannot do that */
-    reshow_banner (banner);
+    hildon_banner_queue_message (banner, text, FALSE);
+
+    HILDON_WATCH_LEAVE ("banner-show");
+    HILDON_PROBE1 (banner__show__information__end, banner);
 
     return GTK_WIDGET (banner);
 }
@@ -955,7 +1125,8 @@ hildon_banner_show_informationf                 (GtkWidget *widget,
  * hildon_banner_set_timeout()). For each window in your application
  * there can only be one timed banner, so if you spawn a new banner
  * before the earlier one has timed out, the previous one will be
- * replaced.
+ * replaced. Like with hildon_banner_show_information(), updates
+ * are rate limited and repeated messages are coalesced.
  *
  * Returns: the newly created banner
  *
@@ -976,11 +1147,7 @@ hildon_banner_show_information_with_markup      (GtkWidget *widget,
     priv = HILDON_BANNER_GET_PRIVATE (banner);
 
     priv->name_suffix = "information";
-    banner_do_set_text (banner, markup, TRUE);
-    hildon_banner_bind_style (banner);
-
-    /* Show the banner, since caller cannot do that */
-    reshow_banner (banner);
+    hildon_banner_queue_message (banner, markup, TRUE);
 
     return (GtkWidget *) banner;
 }
@@ -1013,6 +1180,8 @@ hildon_banner_show_custom_widget                (GtkWidget *widget,
     g_return_val_if_fail (gtk_widget_get_parent (custom_widget) == NULL ||
                           priv->main_item == custom_widget, NULL);
 
+    hildon_banner_forget_message (banner);
+
     if (priv->main_item == NULL) {
         gtk_container_remove (GTK_CONTAINER (priv->layout), priv->label);
     }
@@ -1056,6 +1225,7 @@ hildon_banner_set_text                          (HildonBanner *self,
 {
     g_return_if_fail (HILDON_IS_BANNER (self));
 
+    hildon_banner_forget_message (self);
     banner_do_set_text (self, text, FALSE);
 
     if (gtk_widget_get_visible (GTK_WIDGET (self)))
@@ -1076,6 +1246,7 @@ hildon_banner_set_markup                        (HildonBanner *self,
 {
     g_return_if_fail (HILDON_IS_BANNER (self));
 
+    hildon_banner_forget_message (self);
     banner_do_set_text (self, markup, TRUE);
 
     if (gtk_widget_get_visible (GTK_WIDGET (self)))
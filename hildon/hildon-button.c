@@ -97,6 +97,7 @@
 #include                                        "hildon-button.h"
 #include                                        "hildon-enum-types.h"
 #include                                        "hildon-gtk.h"
+#include                                        "hildon-private.h"
 
 G_DEFINE_TYPE                                   (HildonButton, hildon_button, GTK_TYPE_BUTTON);
 
@@ -106,6 +107,16 @@ G_DEFINE_TYPE                                   (HildonButton, hildon_button, GT
 
 typedef struct                                  _HildonButtonPrivate HildonButtonPrivate;
 
+/* Settings few buttons change, allocated the first time one of them
+ * is, see hildon_button_get_extra() */
+typedef struct
+{
+    gfloat image_xalign;
+    gfloat image_yalign;
+} HildonButtonExtra;
+
+/* Forms create buttons by the hundred, so the small settings are kept
+ * in bitfields and the rarely used ones out of line */
 struct                                          _HildonButtonPrivate
 {
     GtkLabel *title;
@@ -114,14 +125,47 @@ struct                                          _HildonButtonPrivate
     GtkWidget *label_box;
     GtkWidget *alignment;
     GtkWidget *image;
-    GtkPositionType image_position;
-    gfloat image_xalign;
-    gfloat image_yalign;
-    HildonButtonStyle style;
-    HildonSizeType size;
+    const gchar *style_class;
+    HildonButtonExtra *extra;
+    guint image_position : 2;   /* GtkPositionType */
+    guint style : 2;            /* HildonButtonStyle */
+    guint size : 4;             /* HildonSizeType */
     guint setting_style : 1;
 };
 
+static HildonButtonExtra *
+hildon_button_get_extra                         (HildonButtonPrivate *priv)
+{
+    if (G_UNLIKELY (priv->extra == NULL)) {
+        priv->extra = g_slice_new (HildonButtonExtra);
+        priv->extra->image_xalign = 0.5;
+        priv->extra->image_yalign = 0.5;
+    }
+
+    return priv->extra;
+}
+
+/* Style parameters resolved once for every style context, as told
+ * apart by its widget path and state: the path holds the name set for
+ * the button type and size (see hildon_gtk_widget_set_theme_size()),
+ * the style classes and the ancestors the theme can match on. They are
+ * kept per screen and dropped when the theme changes. */
+typedef struct
+{
+    guint horizontal_spacing;
+    guint vertical_spacing;
+    gint image_spacing;
+    gboolean color_found[2];
+    GdkRGBA color[2];
+}                                               HildonButtonStyleParams;
+
+typedef struct
+{
+    GHashTable *params;
+    PangoFontDescription *small_font;
+    gboolean small_font_resolved;
+}                                               HildonButtonStyleCache;
+
 enum {
     PROP_TITLE = 1,
     PROP_VALUE,
@@ -195,23 +239,123 @@ hildon_button_get_property                      (GObject    *object,
     }
 }
 
+static void
+hildon_button_style_cache_clear                 (HildonButtonStyleCache *cache)
+{
+    g_hash_table_remove_all (cache->params);
+
+    if (cache->small_font)
+        pango_font_description_free (cache->small_font);
+    cache->small_font = NULL;
+    cache->small_font_resolved = FALSE;
+}
+
+static void
+hildon_button_style_cache_free                  (HildonButtonStyleCache *cache)
+{
+    hildon_button_style_cache_clear (cache);
+    g_hash_table_destroy (cache->params);
+    g_slice_free (HildonButtonStyleCache, cache);
+}
+
+static void
+theme_changed                                   (GtkSettings            *settings,
+                                                 GParamSpec             *pspec,
+                                                 HildonButtonStyleCache *cache)
+{
+    hildon_button_style_cache_clear (cache);
+}
+
+static void
+params_free                                     (gpointer data)
+{
+    g_slice_free (HildonButtonStyleParams, data);
+}
+
+static HildonButtonStyleCache *
+get_style_cache                                 (GtkWidget *widget)
+{
+    static GQuark quark = 0;
+    GdkScreen *screen = gtk_widget_get_screen (widget);
+    HildonButtonStyleCache *cache;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-button-style-cache");
+
+    cache = g_object_get_qdata (G_OBJECT (screen), quark);
+    if (cache == NULL) {
+        cache = g_slice_new0 (HildonButtonStyleCache);
+        cache->params = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, params_free);
+        g_object_set_qdata_full (G_OBJECT (screen), quark, cache,
+                                 (GDestroyNotify) hildon_button_style_cache_free);
+        g_signal_connect (gtk_settings_get_for_screen (screen), "notify::gtk-theme-name",
+                          G_CALLBACK (theme_changed), cache);
+    }
+
+    return cache;
+}
+
+static const HildonButtonStyleParams *
+get_style_params                                (GtkWidget *widget)
+{
+    HildonButtonStyleCache *cache = get_style_cache (widget);
+    GtkStyleContext *context = gtk_widget_get_style_context (widget);
+    HildonButtonStyleParams *params;
+    gchar *path;
+    gchar *key;
+
+    path = gtk_widget_path_to_string (gtk_style_context_get_path (context));
+    key = g_strdup_printf ("%s:%x", path, gtk_style_context_get_state (context));
+    g_free (path);
+
+    params = g_hash_table_lookup (cache->params, key);
+    if (params != NULL) {
+        g_free (key);
+        return params;
+    }
+
+    params = g_slice_new (HildonButtonStyleParams);
+    gtk_widget_style_get (widget,
+                          "horizontal-spacing", &params->horizontal_spacing,
+                          "vertical-spacing", &params->vertical_spacing,
+                          "image-spacing", &params->image_spacing,
+                          NULL);
+
+    params->color_found[HILDON_BUTTON_STYLE_NORMAL] =
+        gtk_style_context_lookup_color (context, "SecondaryTextColor",
+                                        &params->color[HILDON_BUTTON_STYLE_NORMAL]);
+    params->color_found[HILDON_BUTTON_STYLE_PICKER] =
+        gtk_style_context_lookup_color (context, "ActiveTextColor",
+                                        &params->color[HILDON_BUTTON_STYLE_PICKER]);
+
+    g_hash_table_insert (cache->params, key, params);
+
+    return params;
+}
+
 static void
 set_logical_font                                (GtkWidget *button)
 {
     HildonButtonPrivate *priv = HILDON_BUTTON_GET_PRIVATE (button);
+    HildonButtonStyleCache *cache;
 
     /* In buttons with vertical arrangement, the 'value' label uses a
      * different font */
     if (gtk_orientable_get_orientation(GTK_ORIENTABLE(priv->label_box)) == GTK_ORIENTATION_VERTICAL) {
-        GtkStyle *style = gtk_rc_get_style_by_paths (
-            gtk_settings_get_default (), "SmallSystemFont", NULL, G_TYPE_NONE);
-        if (style != NULL) {
-            PangoFontDescription *font_desc = style->font_desc;
-            if (font_desc != NULL) {
-                priv->setting_style = TRUE;
-                gtk_widget_override_font (GTK_WIDGET (priv->value), font_desc);
-                priv->setting_style = FALSE;
-            }
+        cache = get_style_cache (button);
+        if (!cache->small_font_resolved) {
+            GtkStyle *style = gtk_rc_get_style_by_paths (
+                gtk_settings_get_for_screen (gtk_widget_get_screen (button)),
+                "SmallSystemFont", NULL, G_TYPE_NONE);
+            if (style != NULL && style->font_desc != NULL)
+                cache->small_font = pango_font_description_copy (style->font_desc);
+            cache->small_font_resolved = TRUE;
+        }
+
+        if (cache->small_font != NULL) {
+            priv->setting_style = TRUE;
+            gtk_widget_override_font (GTK_WIDGET (priv->value), cache->small_font);
+            priv->setting_style = FALSE;
         }
     }
 }
@@ -219,29 +363,17 @@ set_logical_font                                (GtkWidget *button)
 static void
 set_logical_color                               (GtkWidget *button)
 {
-    GdkRGBA color;
-    const gchar *colorname;
     HildonButtonPrivate *priv = HILDON_BUTTON_GET_PRIVATE (button);
     GtkWidget *label = GTK_WIDGET (priv->value);
-    gboolean found;
-    GtkStyleContext *context;
+    const HildonButtonStyleParams *params;
 
-    switch (priv->style) {
-    case HILDON_BUTTON_STYLE_NORMAL:
-        colorname = "SecondaryTextColor";
-        break;
-    case HILDON_BUTTON_STYLE_PICKER:
-        colorname = "ActiveTextColor";
-        break;
-    default:
-        g_return_if_reached ();
-    }
+    g_return_if_fail (priv->style == HILDON_BUTTON_STYLE_NORMAL ||
+                      priv->style == HILDON_BUTTON_STYLE_PICKER);
 
-    context = gtk_widget_get_style_context (button);
-    found = gtk_style_context_lookup_color (context, colorname, &color);
-    if (found) {
+    params = get_style_params (button);
+    if (params->color_found[priv->style]) {
         priv->setting_style = TRUE;
-        gtk_widget_override_color(label, GTK_STATE_FLAG_NORMAL, &color);
+        gtk_widget_override_color(label, GTK_STATE_FLAG_NORMAL, &params->color[priv->style]);
         priv->setting_style = FALSE;
     }
 }
@@ -249,7 +381,7 @@ set_logical_color                               (GtkWidget *button)
 static void
 hildon_button_style_updated                        (GtkWidget *widget)
 {
-    guint horizontal_spacing, vertical_spacing, image_spacing;
+    const HildonButtonStyleParams *params;
     HildonButtonPrivate *priv = HILDON_BUTTON_GET_PRIVATE (widget);
 
     /* Prevent infinite recursion when calling set_logical_font() and
@@ -257,30 +389,25 @@ hildon_button_style_updated                        (GtkWidget *widget)
     if (priv->setting_style)
         return;
 
-    gtk_widget_style_get (widget,
-                          "horizontal-spacing", &horizontal_spacing,
-                          "vertical-spacing", &vertical_spacing,
-                          "image-spacing", &image_spacing,
-                          NULL);
+    if (G_UNLIKELY (priv->label_box == NULL))
+        return;
+
+    params = get_style_params (widget);
 
     if (gtk_orientable_get_orientation(GTK_ORIENTABLE(priv->label_box)) == GTK_ORIENTATION_HORIZONTAL) {
-        gtk_box_set_spacing (GTK_BOX (priv->label_box), horizontal_spacing);
+        gtk_box_set_spacing (GTK_BOX (priv->label_box), params->horizontal_spacing);
     } else {
-        gtk_box_set_spacing (GTK_BOX (priv->label_box), vertical_spacing);
+        gtk_box_set_spacing (GTK_BOX (priv->label_box), params->vertical_spacing);
     }
 
     if (GTK_IS_BOX (priv->box)) {
-        gtk_box_set_spacing (priv->box, image_spacing);
+        gtk_box_set_spacing (priv->box, params->image_spacing);
     }
 
     set_logical_font (widget);
     set_logical_color (widget);
 }
 
-#define HILDON_HEIGHT_FINGER    70
-
-#define HILDON_HEIGHT_THUMB     105
-
 #define HILDON_WIDTH_FULLSCREEN (gdk_screen_get_width (gdk_screen_get_default ()))
 
 #define HILDON_WIDTH_HALFSCREEN (HILDON_WIDTH_FULLSCREEN / 2)
@@ -331,6 +458,9 @@ hildon_button_finalize                          (GObject *object)
     g_object_unref (priv->alignment);
     g_object_unref (priv->label_box);
 
+    if (priv->extra)
+        g_slice_free (HildonButtonExtra, priv->extra);
+
     G_OBJECT_CLASS (hildon_button_parent_class)->finalize (object);
 }
 
@@ -432,11 +562,11 @@ hildon_button_init                              (HildonButton *self)
     priv->alignment = gtk_alignment_new (0.5, 0.5, 0, 0);
     priv->image = NULL;
     priv->image_position = GTK_POS_LEFT;
-    priv->image_xalign = 0.5;
-    priv->image_yalign = 0.5;
+    priv->extra = NULL;
     priv->box = NULL;
     priv->label_box = NULL;
     priv->style = HILDON_BUTTON_STYLE_NORMAL;
+    priv->style_class = NULL;
     priv->setting_style = FALSE;
 
     gtk_widget_set_name (GTK_WIDGET (priv->title), "hildon-button-title");
@@ -1014,17 +1144,22 @@ hildon_button_set_image_alignment               (HildonButton *button,
                                                  gfloat        yalign)
 {
     HildonButtonPrivate *priv;
+    HildonButtonExtra *extra;
 
     g_return_if_fail (HILDON_IS_BUTTON (button));
 
     priv = HILDON_BUTTON_GET_PRIVATE (button);
 
     /* Return if there's nothing to do */
-    if (priv->image_xalign == xalign && priv->image_yalign == yalign)
+    if (priv->extra == NULL && xalign == 0.5 && yalign == 0.5)
+        return;
+
+    extra = hildon_button_get_extra (priv);
+    if (extra->image_xalign == xalign && extra->image_yalign == yalign)
         return;
 
-    priv->image_xalign = xalign;
-    priv->image_yalign = yalign;
+    extra->image_xalign = xalign;
+    extra->image_yalign = yalign;
 
     hildon_button_construct_child (button);
 }
@@ -1081,11 +1216,31 @@ hildon_button_get_style                         (HildonButton *button)
     return priv->style;
 }
 
+/* Changing the style classes restyles the button, so only touch them
+ * when the class actually changes */
 static void
-hildon_button_construct_child                   (HildonButton *button)
+set_style_class                                 (HildonButton *button,
+                                                 const gchar  *style_class)
 {
     HildonButtonPrivate *priv = HILDON_BUTTON_GET_PRIVATE (button);
     GtkStyleContext *context;
+
+    if (priv->style_class == style_class)
+        return;
+
+    context = gtk_widget_get_style_context (GTK_WIDGET (button));
+    if (priv->style_class)
+        gtk_style_context_remove_class (context, priv->style_class);
+    if (style_class)
+        gtk_style_context_add_class (context, style_class);
+
+    priv->style_class = style_class;
+}
+
+static void
+hildon_button_construct_child                   (HildonButton *button)
+{
+    HildonButtonPrivate *priv = HILDON_BUTTON_GET_PRIVATE (button);
     GtkWidget *child;
     GtkWidget *box;
     GtkWidget *align;
@@ -1094,23 +1249,21 @@ hildon_button_construct_child                   (HildonButton *button)
     GtkWidget *image = NULL;
     GtkWidget *lb_parent;
 
-    context = gtk_widget_get_style_context (GTK_WIDGET (button));
-    gtk_style_context_remove_class (context, "image-button");
-    gtk_style_context_remove_class (context, "text-button");
-
     /* Don't do anything if the button is not constructed yet */
-    if (G_UNLIKELY (priv->label_box == NULL))
+    if (G_UNLIKELY (priv->label_box == NULL)) {
+        set_style_class (button, NULL);
         return;
+    }
 
     /* Don't do anything if the button has no contents */
     title = gtk_label_get_text (priv->title);
     value = gtk_label_get_text (priv->value);
-    if (!priv->image && !title[0] && !value[0])
+    if (!priv->image && !title[0] && !value[0]) {
+        set_style_class (button, NULL);
         return;
+    }
 
-    gtk_style_context_get_style (context,
-                                 "image-spacing", &image_spacing,
-                                 NULL);
+    image_spacing = get_style_params (GTK_WIDGET (button))->image_spacing;
 
     /* Save a ref to the image, and remove it from its container if necessary */
     if (priv->image) {
@@ -1175,10 +1328,11 @@ hildon_button_construct_child                   (HildonButton *button)
 	        gtk_box_pack_start (GTK_BOX (box), priv->label_box, TRUE, TRUE, 0);
 	    else
 	        gtk_box_pack_end (GTK_BOX (box), priv->label_box, TRUE, TRUE, 0);
+            set_style_class (button, NULL);
 	}
         else
         {
-            gtk_style_context_add_class (context, "image-button");
+            set_style_class (button, "image-button");
         }
 
         gtk_container_add (GTK_CONTAINER (priv->alignment), box);
@@ -1192,5 +1346,5 @@ hildon_button_construct_child                   (HildonButton *button)
     gtk_widget_set_valign (priv->label_box, GTK_ALIGN_BASELINE);
     gtk_container_add (GTK_CONTAINER (priv->alignment), priv->label_box);
 
-    gtk_style_context_add_class (context, "text-button");
+    set_style_class (button, "text-button");
 }
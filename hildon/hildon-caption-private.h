@@ -38,14 +38,20 @@ struct                                          _HildonCaptionPrivate
     GtkWidget *caption_area;
     GtkWidget *label;
     GtkWidget *icon;
-    GtkWidget *icon_align; /* Arbitrary icon widgets do not support alignment */
+    GtkWidget *icon_align; /* Arbitrary icon widgets do not support alignment,
+                              created with the first icon */
     GtkSizeGroup *group;
     gchar *text;
     gchar *separator;
     guint is_focused : 1;
     guint expand : 1;
-    HildonCaptionStatus status;
-    HildonCaptionIconPosition icon_position;
+    guint padding_valid : 1;
+    guint caption_size_valid : 1;
+    guint status : 1;           /* HildonCaptionStatus */
+    guint icon_position : 1;    /* HildonCaptionIconPosition */
+    GtkBorder padding;
+    GtkRequisition caption_minimal;
+    GtkRequisition caption_natural;
 };
 
 G_END_DECLS
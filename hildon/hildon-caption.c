@@ -77,6 +77,21 @@ hildon_caption_forall                           (GtkContainer *container,
                                                  GtkCallback callback, 
                                                  gpointer data );
 
+static void
+hildon_caption_style_updated                    (GtkWidget *widget);
+
+static void
+hildon_caption_invalidate_caption_size          (HildonCaptionPrivate *priv);
+
+static void
+hildon_caption_icon_notify                      (GObject    *icon,
+                                                 GParamSpec *pspec,
+                                                 HildonCaptionPrivate *priv);
+
+static void
+hildon_caption_state_flags_changed              (GtkWidget *widget,
+                                                 GtkStateFlags previous_state);
+
 static void
 hildon_caption_hierarchy_changed                (GtkWidget *widget,
                                                  GtkWidget *previous_toplevel);
@@ -115,6 +130,9 @@ static void
 hildon_caption_set_label_text                   (HildonCaptionPrivate *priv, 
                                                  gboolean markup);
 
+static GtkWidget *
+hildon_caption_get_icon_align                   (HildonCaptionPrivate *priv);
+
 static void 
 hildon_caption_set_child_property               (GtkContainer *container,
                                                  GtkWidget *child,
@@ -205,6 +223,8 @@ hildon_caption_class_init                       (HildonCaptionClass *caption_cla
     widget_class->get_preferred_width           = hildon_caption_get_preferred_width;
     widget_class->get_preferred_height          = hildon_caption_get_preferred_height;
     widget_class->size_allocate                 = hildon_caption_size_allocate;
+    widget_class->style_updated                 = hildon_caption_style_updated;
+    widget_class->state_flags_changed           = hildon_caption_state_flags_changed;
     widget_class->button_press_event            = hildon_caption_button_press;
     widget_class->grab_focus                    = hildon_caption_grab_focus;
     widget_class->destroy                       = hildon_caption_destroy;
@@ -319,8 +339,24 @@ hildon_caption_destroy                          (GtkWidget *self)
     /* Free our internal child */
     if (priv && priv->caption_area)
     {
+        /* The other captions of the group may have been sized for us */
+        if (priv->group)
+        {
+            hildon_caption_invalidate_caption_size (priv);
+            gtk_size_group_remove_widget (priv->group, priv->caption_area);
+            priv->group = NULL;
+        }
+
+        if (priv->icon)
+        {
+            g_signal_handlers_disconnect_by_func (priv->icon,
+                                                  hildon_caption_icon_notify, priv);
+            priv->icon = NULL;
+        }
+
         gtk_widget_unparent (priv->caption_area);
         priv->caption_area = NULL;
+        priv->icon_align = NULL;
     }
 
     /* Free user provided strings */
@@ -384,15 +420,23 @@ hildon_caption_set_property                     (GObject *object,
         case PROP_ICON:
             /* Remove old icon */
             if (priv->icon)
+            {
+                g_signal_handlers_disconnect_by_func (priv->icon,
+                                                      hildon_caption_icon_notify, priv);
                 gtk_container_remove (GTK_CONTAINER (priv->icon_align), priv->icon);
+            }
 
             /* Pack and display new icon */
             priv->icon = g_value_get_object (value);
             if (priv->icon)
             {
-                gtk_container_add (GTK_CONTAINER (priv->icon_align), priv->icon);
+                gtk_container_add (GTK_CONTAINER (hildon_caption_get_icon_align (priv)),
+                                   priv->icon);
                 gtk_widget_show_all (priv->caption_area);
+                g_signal_connect (priv->icon, "notify",
+                                  G_CALLBACK (hildon_caption_icon_notify), priv);
             }
+            hildon_caption_invalidate_caption_size (priv);
             break;
 
         case PROP_STATUS:
@@ -402,13 +446,17 @@ hildon_caption_set_property                     (GObject *object,
         case PROP_SIZE_GROUP:
             /* Detach from previous size group */
             if (priv->group)
+            {
+                hildon_caption_invalidate_caption_size (priv);
                 gtk_size_group_remove_widget (priv->group, priv->caption_area);
+            }
 
             priv->group = g_value_get_object (value);
 
             /* Attach to new size group */
             if (priv->group)
                 gtk_size_group_add_widget (priv->group, priv->caption_area);
+            hildon_caption_invalidate_caption_size (priv);
 
             gtk_widget_queue_draw (GTK_WIDGET(object));
             break;
@@ -525,6 +573,35 @@ hildon_caption_button_press                     (GtkWidget *widget,
     return FALSE;
 }
 
+static gint
+icon_align_order                                (HildonCaptionPrivate *priv)
+{
+    return (priv->icon_position == HILDON_CAPTION_POSITION_LEFT) ? -1 : 0;
+}
+
+/* Most captions never have an icon, so its alignment is only created
+ * when the first one is set */
+static GtkWidget *
+hildon_caption_get_icon_align                   (HildonCaptionPrivate *priv)
+{
+    gfloat yalign;
+
+    if (priv->icon_align)
+        return priv->icon_align;
+
+    g_object_get (priv->label, "yalign", &yalign, NULL);
+
+    gtk_widget_push_composite_child ();
+    priv->icon_align = gtk_alignment_new (0.5f, yalign, 0.0f, 0.0f);
+    gtk_widget_pop_composite_child ();
+
+    gtk_box_pack_end (GTK_BOX (priv->caption_area), priv->icon_align, FALSE, FALSE, 0);
+    gtk_box_reorder_child (GTK_BOX (priv->caption_area), priv->icon_align,
+                           icon_align_order (priv));
+
+    return priv->icon_align;
+}
+
 static void 
 hildon_caption_init                             (HildonCaption *caption)
 {
@@ -538,6 +615,8 @@ hildon_caption_init                             (HildonCaption *caption)
     priv->group = NULL;
     priv->is_focused = FALSE;
     priv->text = NULL;
+    priv->padding_valid = FALSE;
+    priv->caption_size_valid = FALSE;
 
     priv->separator = g_strdup(_("ecdg_ti_caption_separator"));
 
@@ -546,7 +625,7 @@ hildon_caption_init                             (HildonCaption *caption)
     /* Create caption text */
     priv->caption_area = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, HILDON_CAPTION_SPACING); 
     priv->label = gtk_label_new (NULL);
-    priv->icon_align = gtk_alignment_new (0.5f, 0.5f, 0.0f, 0.0f);
+    priv->icon_align = NULL;
     priv->icon_position = HILDON_CAPTION_POSITION_RIGHT;
 
     /* We want to receive button presses for child widget activation */
@@ -554,7 +633,6 @@ hildon_caption_init                             (HildonCaption *caption)
     gtk_widget_add_events (GTK_WIDGET (caption), GDK_BUTTON_PRESS_MASK);
 
     /* Pack text label caption layout */
-    gtk_box_pack_end (GTK_BOX (priv->caption_area), priv->icon_align, FALSE, FALSE, 0);
     gtk_box_pack_end (GTK_BOX (priv->caption_area), priv->label, FALSE, FALSE, 0);
     gtk_widget_set_parent (priv->caption_area, GTK_WIDGET (caption));
 
@@ -625,28 +703,122 @@ hildon_caption_hierarchy_changed                (GtkWidget *widget,
                 G_CALLBACK (hildon_caption_set_focus), widget );
 }
 
+/* The caption area is measured once and the result kept until its
+ * text, icon or style changes. The captions sharing a size group are
+ * invalidated together, since the group width depends on all of them,
+ * also when one joins or leaves the group. Changes in the captioned
+ * child don't touch this at all. */
+static void
+hildon_caption_invalidate_caption_size          (HildonCaptionPrivate *priv)
+{
+    GSList *widgets, *iter;
+
+    if (priv->caption_area == NULL)
+        return;
+
+    if (priv->group == NULL) {
+        priv->caption_size_valid = FALSE;
+        gtk_widget_queue_resize (priv->caption_area);
+        return;
+    }
+
+    widgets = gtk_size_group_get_widgets (priv->group);
+    for (iter = widgets; iter != NULL; iter = iter->next) {
+        GtkWidget *parent = gtk_widget_get_parent (iter->data);
+        HildonCaptionPrivate *member;
+
+        if (HILDON_IS_CAPTION (parent))
+        {
+            member = HILDON_CAPTION_GET_PRIVATE (parent);
+            member->caption_size_valid = FALSE;
+        }
+    }
+
+    /* The size group queues a resize on all its members */
+    gtk_widget_queue_resize (priv->caption_area);
+}
+
+/* Any property of the icon, such as its image, size or visibility,
+ * can change the caption size */
+static void
+hildon_caption_icon_notify                      (GObject    *icon,
+                                                 GParamSpec *pspec,
+                                                 HildonCaptionPrivate *priv)
+{
+    hildon_caption_invalidate_caption_size (priv);
+}
+
+static void
+hildon_caption_get_caption_size                 (HildonCaptionPrivate *priv,
+                                                 GtkRequisition *minimal,
+                                                 GtkRequisition *natural)
+{
+    if (! priv->caption_size_valid)
+    {
+        gtk_widget_get_preferred_size (priv->caption_area,
+                                       &priv->caption_minimal, &priv->caption_natural);
+        priv->caption_size_valid = TRUE;
+    }
+
+    if (minimal)
+        *minimal = priv->caption_minimal;
+    if (natural)
+        *natural = priv->caption_natural;
+}
+
+static void
+hildon_caption_style_updated                    (GtkWidget *widget)
+{
+    HildonCaptionPrivate *priv = HILDON_CAPTION_GET_PRIVATE (widget);
+
+    if (GTK_WIDGET_CLASS (parent_class)->style_updated)
+        GTK_WIDGET_CLASS (parent_class)->style_updated (widget);
+
+    priv->padding_valid = FALSE;
+    hildon_caption_invalidate_caption_size (priv);
+}
+
+static void
+hildon_caption_state_flags_changed              (GtkWidget *widget,
+                                                 GtkStateFlags previous_state)
+{
+    HildonCaptionPrivate *priv = HILDON_CAPTION_GET_PRIVATE (widget);
+
+    if (GTK_WIDGET_CLASS (parent_class)->state_flags_changed)
+        GTK_WIDGET_CLASS (parent_class)->state_flags_changed (widget, previous_state);
+
+    /* The padding is looked up for the current state */
+    priv->padding_valid = FALSE;
+}
+
 static void
 hildon_caption_get_preferred_height             (GtkWidget *widget,
                                                  gint      *minimal_height,
                                                  gint      *natural_height)
 {
+    GtkRequisition minimal, natural;
     gint caption_minimal, caption_natural;
     HildonCaptionPrivate *priv = NULL;
-    GtkStyleContext *context;
-    GtkBorder padding;
     gint ythickness;
     g_return_if_fail (HILDON_IS_CAPTION(widget));
 
     priv = HILDON_CAPTION_GET_PRIVATE (widget);
 
     /* Use the height for the main box of the caption */
-    gtk_widget_get_preferred_height (priv->caption_area, &caption_minimal, &caption_natural);
+    hildon_caption_get_caption_size (priv, &minimal, &natural);
+    caption_minimal = minimal.height;
+    caption_natural = natural.height;
 
     if (GTK_WIDGET_CLASS (parent_class)->get_preferred_height)
         GTK_WIDGET_CLASS (parent_class)->get_preferred_height (widget, minimal_height, natural_height);
 
-    gtk_style_context_get_padding (gtk_widget_get_style_context (widget), gtk_widget_get_state_flags (widget), &padding);
-    ythickness = padding.top + padding.bottom;
+    if (! priv->padding_valid)
+    {
+        gtk_style_context_get_padding (gtk_widget_get_style_context (widget),
+                                       gtk_widget_get_state_flags (widget), &priv->padding);
+        priv->padding_valid = TRUE;
+    }
+    ythickness = priv->padding.top + priv->padding.bottom;
 
     if ((caption_minimal + (2 * ythickness)) > *minimal_height)
         *minimal_height = caption_minimal + (2 * ythickness);
@@ -659,6 +831,7 @@ hildon_caption_get_preferred_width              (GtkWidget *widget,
                                                  gint      *minimal_width,
                                                  gint      *natural_width)
 {
+    GtkRequisition minimal, natural;
     gint caption_minimal, caption_natural;
     HildonCaptionPrivate *priv = NULL;
     g_return_if_fail (HILDON_IS_CAPTION(widget));
@@ -666,7 +839,9 @@ hildon_caption_get_preferred_width              (GtkWidget *widget,
     priv = HILDON_CAPTION_GET_PRIVATE (widget);
 
     /* Use the width for the main box of the caption */
-    gtk_widget_get_preferred_width (priv->caption_area, &caption_minimal, &caption_natural);
+    hildon_caption_get_caption_size (priv, &minimal, &natural);
+    caption_minimal = minimal.width;
+    caption_natural = natural.width;
 
     if (GTK_WIDGET_CLASS (parent_class)->get_preferred_width)
         GTK_WIDGET_CLASS (parent_class)->get_preferred_width (widget, minimal_width, natural_width);
@@ -710,7 +885,7 @@ hildon_caption_size_allocate                    (GtkWidget *widget,
         gtk_widget_get_preferred_size (child, &child_req, NULL);
 
     gtk_widget_size_allocate (widget, allocation);
-    gtk_widget_get_preferred_size (priv->caption_area, &req, NULL);
+    hildon_caption_get_caption_size (priv, &req, NULL);
 
     child_alloc.height = caption_alloc.height = allocation->height;
     child_alloc.width  = caption_alloc.width  = allocation->width;
@@ -907,10 +1082,12 @@ hildon_caption_set_icon_position                (HildonCaption *caption,
 
     g_return_if_fail (priv->caption_area != NULL);
     
-    int order = (pos == HILDON_CAPTION_POSITION_LEFT) ? -1 : 0;
-    gtk_box_reorder_child (GTK_BOX (priv->caption_area), priv->icon_align, order);
-
     priv->icon_position = pos;
+    if (priv->icon_align)
+        gtk_box_reorder_child (GTK_BOX (priv->caption_area), priv->icon_align,
+                               icon_align_order (priv));
+
+    hildon_caption_invalidate_caption_size (priv);
 }
 
 /**
@@ -1222,6 +1399,8 @@ hildon_caption_set_label_text                   (HildonCaptionPrivate *priv,
         else
             gtk_label_set_text (GTK_LABEL (priv->label), "" );
     }
+
+    hildon_caption_invalidate_caption_size (priv);
 }
 
 /**
@@ -1245,7 +1424,8 @@ hildon_caption_set_label_alignment              (HildonCaption *caption,
     priv = HILDON_CAPTION_GET_PRIVATE (caption);
 
     g_object_set (priv->label, "yalign", alignment, NULL);
-    g_object_set (priv->icon_align, "yalign", alignment, NULL);
+    if (priv->icon_align)
+        g_object_set (priv->icon_align, "yalign", alignment, NULL);
 
 }
 
@@ -0,0 +1,712 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-cell-renderer-button
+ * @short_description: Cell renderer that looks like a #HildonButton
+ *
+ * #HildonCellRendererButton draws a title, a value and an optional
+ * icon with the same layout and colors as a #HildonButton. It is meant
+ * for long lists of buttons: instead of creating one #HildonButton
+ * (with its labels, boxes and image) per entry, the entries are kept
+ * in a #GtkTreeModel and drawn by a single renderer in a #GtkTreeView,
+ * so each row only costs its model data.
+ *
+ * The easiest way to use it is hildon_cell_renderer_button_append_column(),
+ * which adds a column showing the given model columns.
+ *
+ * <example>
+ * <title>A list of buttons in a tree view</title>
+ * <programlisting>
+ * GtkWidget *
+ * create_list (GtkTreeModel *model)
+ * {
+ *     GtkWidget *treeview;
+ *     GtkWidget *area;
+ * <!-- -->
+ *     treeview = hildon_gtk_tree_view_new_with_model (HILDON_UI_MODE_NORMAL, model);
+ *     hildon_cell_renderer_button_append_column (GTK_TREE_VIEW (treeview),
+ *                                                HILDON_SIZE_FINGER_HEIGHT,
+ *                                                HILDON_BUTTON_ARRANGEMENT_VERTICAL,
+ *                                                TITLE_COLUMN, VALUE_COLUMN, -1);
+ * <!-- -->
+ *     area = hildon_pannable_area_new ();
+ *     gtk_container_add (GTK_CONTAINER (area), treeview);
+ * <!-- -->
+ *     return area;
+ * }
+ * </programlisting>
+ * </example>
+ */
+
+#include                                        "hildon-cell-renderer-button.h"
+#include                                        "hildon-enum-types.h"
+#include                                        "hildon-defines.h"
+#include                                        "hildon-private.h"
+
+enum {
+    PROP_TITLE = 1,
+    PROP_VALUE,
+    PROP_ICON_NAME,
+    PROP_SIZE,
+    PROP_ARRANGEMENT,
+    PROP_STYLE
+};
+
+G_DEFINE_TYPE                                   (HildonCellRendererButton, hildon_cell_renderer_button, GTK_TYPE_CELL_RENDERER);
+
+#define                                         HILDON_CELL_RENDERER_BUTTON_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
+                                                HILDON_TYPE_CELL_RENDERER_BUTTON, HildonCellRendererButtonPrivate))
+
+struct                                          _HildonCellRendererButtonPrivate
+{
+    gchar *title;
+    gchar *value;
+    gchar *icon_name;
+    HildonSizeType size;
+    HildonButtonArrangement arrangement;
+    HildonButtonStyle style;
+
+    /* Reused for every row, see create_layouts() */
+    PangoLayout *title_layout;
+    PangoLayout *value_layout;
+    guint layout_serial;
+
+    /* Styled as a #HildonButton in the widget, for its spacings */
+    GtkStyleContext *button_context;
+    GtkStyleContext *button_context_parent;
+};
+
+typedef struct
+{
+    guint horizontal;
+    guint vertical;
+    gint image;
+} Spacing;
+
+static const gchar *
+get_value_color_name                            (HildonButtonStyle style)
+{
+    return (style == HILDON_BUTTON_STYLE_PICKER) ? "ActiveTextColor" : "SecondaryTextColor";
+}
+
+static void
+clear_layouts                                   (HildonCellRendererButtonPrivate *priv)
+{
+    g_clear_object (&priv->title_layout);
+    g_clear_object (&priv->value_layout);
+}
+
+/* Sets up the layouts for the current cell, or %NULL for the labels
+ * without text. The layouts are created once for @widget and only get
+ * their text set for each row, until the font or the widget change.
+ * The value layout uses the small system font in vertical buttons,
+ * like the value label of a #HildonButton. */
+static void
+create_layouts                                  (HildonCellRendererButton *self,
+                                                 GtkWidget                *widget,
+                                                 PangoLayout             **title,
+                                                 PangoLayout             **value)
+{
+    HildonCellRendererButtonPrivate *priv = self->priv;
+    PangoContext *context = gtk_widget_get_pango_context (widget);
+    guint serial = pango_context_get_serial (context);
+
+    if (priv->title_layout != NULL &&
+        (pango_layout_get_context (priv->title_layout) != context ||
+         priv->layout_serial != serial))
+        clear_layouts (priv);
+
+    if (priv->title_layout == NULL) {
+        priv->title_layout = gtk_widget_create_pango_layout (widget, NULL);
+        pango_layout_set_ellipsize (priv->title_layout, PANGO_ELLIPSIZE_END);
+
+        priv->value_layout = gtk_widget_create_pango_layout (widget, NULL);
+        pango_layout_set_ellipsize (priv->value_layout, PANGO_ELLIPSIZE_END);
+
+        if (priv->arrangement == HILDON_BUTTON_ARRANGEMENT_VERTICAL) {
+            GtkStyle *style = gtk_rc_get_style_by_paths (
+                gtk_settings_get_for_screen (gtk_widget_get_screen (widget)),
+                "SmallSystemFont", NULL, G_TYPE_NONE);
+            if (style != NULL && style->font_desc != NULL)
+                pango_layout_set_font_description (priv->value_layout, style->font_desc);
+        }
+
+        priv->layout_serial = serial;
+    }
+
+    *title = NULL;
+    *value = NULL;
+
+    if (priv->title && priv->title[0]) {
+        *title = priv->title_layout;
+        pango_layout_set_text (*title, priv->title, -1);
+        pango_layout_set_width (*title, -1);
+    }
+
+    if (priv->value && priv->value[0]) {
+        *value = priv->value_layout;
+        pango_layout_set_text (*value, priv->value, -1);
+        pango_layout_set_width (*value, -1);
+    }
+}
+
+/* Reads the spacing style properties of #HildonButton, as themed for
+ * a button inside @widget */
+static void
+get_spacing                                     (HildonCellRendererButton *self,
+                                                 GtkWidget                *widget,
+                                                 Spacing                  *spacing)
+{
+    HildonCellRendererButtonPrivate *priv = self->priv;
+    GtkStyleContext *parent = gtk_widget_get_style_context (widget);
+
+    if (priv->button_context_parent != parent) {
+        GtkWidgetPath *path;
+
+        g_clear_object (&priv->button_context);
+        priv->button_context = gtk_style_context_new ();
+        priv->button_context_parent = parent;
+
+        path = gtk_widget_path_copy (gtk_widget_get_path (widget));
+        gtk_widget_path_append_type (path, HILDON_TYPE_BUTTON);
+        gtk_style_context_set_path (priv->button_context, path);
+        gtk_style_context_set_parent (priv->button_context, parent);
+        gtk_style_context_set_screen (priv->button_context, gtk_widget_get_screen (widget));
+        gtk_widget_path_unref (path);
+    }
+
+    gtk_style_context_get_style (priv->button_context,
+                                 "horizontal-spacing", &spacing->horizontal,
+                                 "vertical-spacing", &spacing->vertical,
+                                 "image-spacing", &spacing->image,
+                                 NULL);
+}
+
+static void
+get_layout_size                                 (PangoLayout *layout,
+                                                 gint        *width,
+                                                 gint        *height)
+{
+    *width = 0;
+    *height = 0;
+
+    if (layout)
+        pango_layout_get_pixel_size (layout, width, height);
+}
+
+static GdkPixbuf *
+load_icon                                       (HildonCellRendererButton *self,
+                                                 GtkWidget                *widget)
+{
+    HildonCellRendererButtonPrivate *priv = self->priv;
+    GtkIconTheme *icon_theme;
+
+    if (priv->icon_name == NULL || priv->icon_name[0] == '\0')
+        return NULL;
+
+    /* The rows that share an icon share its pixbuf too */
+    icon_theme = gtk_icon_theme_get_for_screen (gtk_widget_get_screen (widget));
+
+    return hildon_load_icon (icon_theme, priv->icon_name,
+                             HILDON_ICON_PIXEL_SIZE_FINGER, 1);
+}
+
+static void
+get_content_size                                (HildonCellRendererButton *self,
+                                                 const Spacing            *spacing,
+                                                 PangoLayout              *title,
+                                                 PangoLayout              *value,
+                                                 GdkPixbuf                *icon,
+                                                 gint                     *width,
+                                                 gint                     *height)
+{
+    HildonCellRendererButtonPrivate *priv = self->priv;
+    gint title_w, title_h, value_w, value_h;
+
+    get_layout_size (title, &title_w, &title_h);
+    get_layout_size (value, &value_w, &value_h);
+
+    if (priv->arrangement == HILDON_BUTTON_ARRANGEMENT_VERTICAL) {
+        *width = MAX (title_w, value_w);
+        *height = title_h + value_h;
+        if (title && value)
+            *height += spacing->vertical;
+    } else {
+        *width = title_w + value_w;
+        *height = MAX (title_h, value_h);
+        if (title && value)
+            *width += spacing->horizontal;
+    }
+
+    if (icon) {
+        if (title || value)
+            *width += spacing->image;
+        *width += gdk_pixbuf_get_width (icon);
+        *height = MAX (*height, gdk_pixbuf_get_height (icon));
+    }
+}
+
+static void
+hildon_cell_renderer_button_get_preferred_width (GtkCellRenderer *cell,
+                                                 GtkWidget       *widget,
+                                                 gint            *minimum,
+                                                 gint            *natural)
+{
+    HildonCellRendererButton *self = HILDON_CELL_RENDERER_BUTTON (cell);
+    PangoLayout *title, *value;
+    GdkPixbuf *icon;
+    Spacing spacing;
+    gint xpad, width, height;
+
+    create_layouts (self, widget, &title, &value);
+    icon = load_icon (self, widget);
+    get_spacing (self, widget, &spacing);
+
+    get_content_size (self, &spacing, title, value, icon, &width, &height);
+    gtk_cell_renderer_get_padding (cell, &xpad, NULL);
+
+    /* Labels are ellipsized, so only the icon is really needed */
+    if (minimum)
+        *minimum = 2 * xpad + (icon ? gdk_pixbuf_get_width (icon) : 0);
+    if (natural)
+        *natural = 2 * xpad + width;
+
+    if (icon)
+        g_object_unref (icon);
+}
+
+static void
+hildon_cell_renderer_button_get_preferred_height (GtkCellRenderer *cell,
+                                                  GtkWidget       *widget,
+                                                  gint            *minimum,
+                                                  gint            *natural)
+{
+    HildonCellRendererButton *self = HILDON_CELL_RENDERER_BUTTON (cell);
+    HildonCellRendererButtonPrivate *priv = self->priv;
+    PangoLayout *title, *value;
+    GdkPixbuf *icon;
+    Spacing spacing;
+    gint ypad, width, height;
+
+    create_layouts (self, widget, &title, &value);
+    icon = load_icon (self, widget);
+    get_spacing (self, widget, &spacing);
+
+    get_content_size (self, &spacing, title, value, icon, &width, &height);
+    gtk_cell_renderer_get_padding (cell, NULL, &ypad);
+    height += 2 * ypad;
+
+    if (priv->size & HILDON_SIZE_FINGER_HEIGHT)
+        height = MAX (height, HILDON_HEIGHT_FINGER);
+    else if (priv->size & HILDON_SIZE_THUMB_HEIGHT)
+        height = MAX (height, HILDON_HEIGHT_THUMB);
+
+    if (minimum)
+        *minimum = height;
+    if (natural)
+        *natural = height;
+
+    if (icon)
+        g_object_unref (icon);
+}
+
+static void
+hildon_cell_renderer_button_render              (GtkCellRenderer      *cell,
+                                                 cairo_t              *cr,
+                                                 GtkWidget            *widget,
+                                                 const GdkRectangle   *background_area,
+                                                 const GdkRectangle   *cell_area,
+                                                 GtkCellRendererState  flags)
+{
+    HildonCellRendererButton *self = HILDON_CELL_RENDERER_BUTTON (cell);
+    HildonCellRendererButtonPrivate *priv = self->priv;
+    GtkStyleContext *context;
+    PangoLayout *title, *value;
+    GdkPixbuf *icon;
+    GdkRGBA color;
+    Spacing spacing;
+    gint xpad, ypad, width, height;
+    gint title_w, title_h, value_w, value_h;
+    gint x, y, avail_w, avail_h;
+    gfloat xalign, yalign;
+
+    gtk_cell_renderer_get_padding (cell, &xpad, &ypad);
+    gtk_cell_renderer_get_alignment (cell, &xalign, &yalign);
+
+    context = gtk_widget_get_style_context (widget);
+    gtk_style_context_save (context);
+    gtk_style_context_add_class (context, GTK_STYLE_CLASS_BUTTON);
+    gtk_style_context_set_state (context, gtk_cell_renderer_get_state (cell, widget, flags));
+
+    gtk_render_background (context, cr,
+                           background_area->x, background_area->y,
+                           background_area->width, background_area->height);
+    gtk_render_frame (context, cr,
+                      background_area->x, background_area->y,
+                      background_area->width, background_area->height);
+
+    create_layouts (self, widget, &title, &value);
+    icon = load_icon (self, widget);
+    get_spacing (self, widget, &spacing);
+
+    get_content_size (self, &spacing, title, value, icon, &width, &height);
+    get_layout_size (title, &title_w, &title_h);
+    get_layout_size (value, &value_w, &value_h);
+
+    avail_w = MAX (cell_area->width - 2 * xpad, 0);
+    avail_h = MAX (cell_area->height - 2 * ypad, 0);
+
+    x = cell_area->x + xpad + MAX ((avail_w - width) * xalign, 0);
+    y = cell_area->y + ypad;
+
+    cairo_save (cr);
+    gdk_cairo_rectangle (cr, cell_area);
+    cairo_clip (cr);
+
+    if (icon) {
+        gtk_render_icon (context, cr, icon, x,
+                         y + (avail_h - gdk_pixbuf_get_height (icon)) * yalign);
+        x += gdk_pixbuf_get_width (icon);
+        if (title || value)
+            x += spacing.image;
+    }
+
+    /* Whatever is left of the cell goes to the labels */
+    avail_w = MAX (cell_area->x + cell_area->width - xpad - x, 0);
+
+    if (priv->arrangement == HILDON_BUTTON_ARRANGEMENT_VERTICAL) {
+        gint labels_h = title_h + value_h;
+
+        if (title && value)
+            labels_h += spacing.vertical;
+        y += MAX ((avail_h - labels_h) * yalign, 0);
+
+        if (title) {
+            pango_layout_set_width (title, avail_w * PANGO_SCALE);
+            gtk_render_layout (context, cr, x, y, title);
+            y += title_h + spacing.vertical;
+        }
+        if (value)
+            pango_layout_set_width (value, avail_w * PANGO_SCALE);
+    } else {
+        if (title) {
+            /* The title gets its full width first, as in #HildonButton */
+            pango_layout_set_width (title, avail_w * PANGO_SCALE);
+            gtk_render_layout (context, cr, x,
+                               y + MAX ((avail_h - title_h) * yalign, 0), title);
+            x += title_w + spacing.horizontal;
+            avail_w = MAX (avail_w - title_w - (gint) spacing.horizontal, 0);
+        }
+        if (value) {
+            pango_layout_set_width (value, avail_w * PANGO_SCALE);
+            y += MAX ((avail_h - value_h) * yalign, 0);
+        }
+    }
+
+    if (value) {
+        if (gtk_style_context_lookup_color (context, get_value_color_name (priv->style), &color)) {
+            gdk_cairo_set_source_rgba (cr, &color);
+            cairo_move_to (cr, x, y);
+            pango_cairo_show_layout (cr, value);
+        } else {
+            gtk_render_layout (context, cr, x, y, value);
+        }
+    }
+
+    cairo_restore (cr);
+    gtk_style_context_restore (context);
+
+    if (icon)
+        g_object_unref (icon);
+}
+
+static void
+hildon_cell_renderer_button_set_property        (GObject      *object,
+                                                 guint         prop_id,
+                                                 const GValue *value,
+                                                 GParamSpec   *pspec)
+{
+    HildonCellRendererButtonPrivate *priv = HILDON_CELL_RENDERER_BUTTON (object)->priv;
+
+    switch (prop_id)
+    {
+    case PROP_TITLE:
+        g_free (priv->title);
+        priv->title = g_value_dup_string (value);
+        break;
+    case PROP_VALUE:
+        g_free (priv->value);
+        priv->value = g_value_dup_string (value);
+        break;
+    case PROP_ICON_NAME:
+        g_free (priv->icon_name);
+        priv->icon_name = g_value_dup_string (value);
+        break;
+    case PROP_SIZE:
+        priv->size = g_value_get_flags (value);
+        break;
+    case PROP_ARRANGEMENT:
+        priv->arrangement = g_value_get_enum (value);
+        /* The value font depends on the arrangement */
+        clear_layouts (priv);
+        break;
+    case PROP_STYLE:
+        priv->style = g_value_get_enum (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+hildon_cell_renderer_button_get_property        (GObject    *object,
+                                                 guint       prop_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonCellRendererButtonPrivate *priv = HILDON_CELL_RENDERER_BUTTON (object)->priv;
+
+    switch (prop_id)
+    {
+    case PROP_TITLE:
+        g_value_set_string (value, priv->title);
+        break;
+    case PROP_VALUE:
+        g_value_set_string (value, priv->value);
+        break;
+    case PROP_ICON_NAME:
+        g_value_set_string (value, priv->icon_name);
+        break;
+    case PROP_SIZE:
+        g_value_set_flags (value, priv->size);
+        break;
+    case PROP_ARRANGEMENT:
+        g_value_set_enum (value, priv->arrangement);
+        break;
+    case PROP_STYLE:
+        g_value_set_enum (value, priv->style);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+hildon_cell_renderer_button_finalize            (GObject *object)
+{
+    HildonCellRendererButtonPrivate *priv = HILDON_CELL_RENDERER_BUTTON (object)->priv;
+
+    g_free (priv->title);
+    g_free (priv->value);
+    g_free (priv->icon_name);
+    clear_layouts (priv);
+    g_clear_object (&priv->button_context);
+
+    G_OBJECT_CLASS (hildon_cell_renderer_button_parent_class)->finalize (object);
+}
+
+static void
+hildon_cell_renderer_button_class_init          (HildonCellRendererButtonClass *klass)
+{
+    GObjectClass *gobject_class = (GObjectClass *) klass;
+    GtkCellRendererClass *cell_class = (GtkCellRendererClass *) klass;
+
+    gobject_class->set_property = hildon_cell_renderer_button_set_property;
+    gobject_class->get_property = hildon_cell_renderer_button_get_property;
+    gobject_class->finalize = hildon_cell_renderer_button_finalize;
+
+    cell_class->get_preferred_width = hildon_cell_renderer_button_get_preferred_width;
+    cell_class->get_preferred_height = hildon_cell_renderer_button_get_preferred_height;
+    cell_class->render = hildon_cell_renderer_button_render;
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_TITLE,
+        g_param_spec_string (
+            "title",
+            "Title",
+            "Text of the title label",
+            NULL,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_VALUE,
+        g_param_spec_string (
+            "value",
+            "Value",
+            "Text of the value label",
+            NULL,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_ICON_NAME,
+        g_param_spec_string (
+            "icon-name",
+            "Icon name",
+            "Name of the themed icon shown next to the labels",
+            NULL,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_SIZE,
+        g_param_spec_flags (
+            "size",
+            "Size",
+            "Size request for the cell",
+            HILDON_TYPE_SIZE_TYPE,
+            HILDON_SIZE_AUTO,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_ARRANGEMENT,
+        g_param_spec_enum (
+            "arrangement",
+            "Arrangement",
+            "How the cell contents must be arranged",
+            HILDON_TYPE_BUTTON_ARRANGEMENT,
+            HILDON_BUTTON_ARRANGEMENT_HORIZONTAL,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_STYLE,
+        g_param_spec_enum (
+            "style",
+            "Style",
+            "Visual style of the cell",
+            HILDON_TYPE_BUTTON_STYLE,
+            HILDON_BUTTON_STYLE_NORMAL,
+            G_PARAM_READWRITE));
+
+    g_type_class_add_private (klass, sizeof (HildonCellRendererButtonPrivate));
+}
+
+static void
+hildon_cell_renderer_button_init                (HildonCellRendererButton *self)
+{
+    HildonCellRendererButtonPrivate *priv = HILDON_CELL_RENDERER_BUTTON_GET_PRIVATE (self);
+
+    self->priv = priv;
+
+    priv->title = NULL;
+    priv->value = NULL;
+    priv->icon_name = NULL;
+    priv->size = HILDON_SIZE_AUTO;
+    priv->arrangement = HILDON_BUTTON_ARRANGEMENT_HORIZONTAL;
+    priv->style = HILDON_BUTTON_STYLE_NORMAL;
+
+    gtk_cell_renderer_set_alignment (GTK_CELL_RENDERER (self), 0.5, 0.5);
+}
+
+/**
+ * hildon_cell_renderer_button_new:
+ * @size: Flags to set the height of the cells
+ * @arrangement: How the labels must be arranged
+ *
+ * Creates a new #HildonCellRendererButton. Its "title", "value" and
+ * "icon-name" properties are usually bound to model columns, see
+ * gtk_tree_view_column_add_attribute().
+ *
+ * Returns: a new #HildonCellRendererButton
+ *
+ * Since: 3.0
+ **/
+GtkCellRenderer *
+hildon_cell_renderer_button_new                 (HildonSizeType          size,
+                                                 HildonButtonArrangement arrangement)
+{
+    return g_object_new (HILDON_TYPE_CELL_RENDERER_BUTTON,
+                         "size", size,
+                         "arrangement", arrangement,
+                         NULL);
+}
+
+/**
+ * hildon_cell_renderer_button_append_column:
+ * @treeview: A #GtkTreeView
+ * @size: Flags to set the height of the cells
+ * @arrangement: How the labels must be arranged
+ * @title_column: model column with the titles, or -1
+ * @value_column: model column with the values, or -1
+ * @icon_name_column: model column with the icon names, or -1
+ *
+ * Appends to @treeview a column drawn by a new #HildonCellRendererButton,
+ * with its title, value and icon name taken from the given model
+ * columns. The column uses fixed sizing and, if all the other columns
+ * of @treeview do as well, fixed height mode is enabled so @treeview
+ * does not need to measure every row of the model.
+ *
+ * Returns: the new #GtkTreeViewColumn, owned by @treeview
+ *
+ * Since: 3.0
+ **/
+GtkTreeViewColumn *
+hildon_cell_renderer_button_append_column       (GtkTreeView             *treeview,
+                                                 HildonSizeType          size,
+                                                 HildonButtonArrangement arrangement,
+                                                 gint                    title_column,
+                                                 gint                    value_column,
+                                                 gint                    icon_name_column)
+{
+    GtkTreeViewColumn *column;
+    GtkCellRenderer *renderer;
+    GList *columns, *iter;
+
+    g_return_val_if_fail (GTK_IS_TREE_VIEW (treeview), NULL);
+
+    renderer = hildon_cell_renderer_button_new (size, arrangement);
+
+    column = gtk_tree_view_column_new ();
+    gtk_tree_view_column_pack_start (column, renderer, TRUE);
+    gtk_tree_view_column_set_expand (column, TRUE);
+
+    if (title_column >= 0)
+        gtk_tree_view_column_add_attribute (column, renderer, "title", title_column);
+    if (value_column >= 0)
+        gtk_tree_view_column_add_attribute (column, renderer, "value", value_column);
+    if (icon_name_column >= 0)
+        gtk_tree_view_column_add_attribute (column, renderer, "icon-name", icon_name_column);
+
+    /* All rows share the same height, so let the tree view skip the
+     * per-row measuring if no other column needs it */
+    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_append_column (treeview, column);
+
+    columns = gtk_tree_view_get_columns (treeview);
+    for (iter = columns; iter != NULL; iter = iter->next) {
+        if (gtk_tree_view_column_get_sizing (iter->data) != GTK_TREE_VIEW_COLUMN_FIXED)
+            break;
+    }
+    if (iter == NULL)
+        gtk_tree_view_set_fixed_height_mode (treeview, TRUE);
+    g_list_free (columns);
+
+    return column;
+}
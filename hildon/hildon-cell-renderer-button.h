@@ -0,0 +1,87 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_CELL_RENDERER_BUTTON_H__
+#define                                         __HILDON_CELL_RENDERER_BUTTON_H__
+
+#include                                        "hildon-button.h"
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_CELL_RENDERER_BUTTON \
+                                                (hildon_cell_renderer_button_get_type())
+
+#define                                         HILDON_CELL_RENDERER_BUTTON(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_CELL_RENDERER_BUTTON, HildonCellRendererButton))
+
+#define                                         HILDON_CELL_RENDERER_BUTTON_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                                HILDON_TYPE_CELL_RENDERER_BUTTON, HildonCellRendererButtonClass))
+
+#define                                         HILDON_IS_CELL_RENDERER_BUTTON(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HILDON_TYPE_CELL_RENDERER_BUTTON))
+
+#define                                         HILDON_IS_CELL_RENDERER_BUTTON_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_TYPE ((klass), HILDON_TYPE_CELL_RENDERER_BUTTON))
+
+#define                                         HILDON_CELL_RENDERER_BUTTON_GET_CLASS(obj) \
+                                                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                                HILDON_TYPE_CELL_RENDERER_BUTTON, HildonCellRendererButtonClass))
+
+typedef struct                                  _HildonCellRendererButton HildonCellRendererButton;
+
+typedef struct                                  _HildonCellRendererButtonClass HildonCellRendererButtonClass;
+
+typedef struct                                  _HildonCellRendererButtonPrivate HildonCellRendererButtonPrivate;
+
+struct                                          _HildonCellRendererButtonClass
+{
+    GtkCellRendererClass parent_class;
+};
+
+struct                                          _HildonCellRendererButton
+{
+    GtkCellRenderer parent;
+
+    /* private */
+    HildonCellRendererButtonPrivate *priv;
+};
+
+GType
+hildon_cell_renderer_button_get_type            (void) G_GNUC_CONST;
+
+GtkCellRenderer *
+hildon_cell_renderer_button_new                 (HildonSizeType          size,
+                                                 HildonButtonArrangement arrangement);
+
+GtkTreeViewColumn *
+hildon_cell_renderer_button_append_column       (GtkTreeView             *treeview,
+                                                 HildonSizeType          size,
+                                                 HildonButtonArrangement arrangement,
+                                                 gint                    title_column,
+                                                 gint                    value_column,
+                                                 gint                    icon_name_column);
+
+G_END_DECLS
+
+#endif /* __HILDON_CELL_RENDERER_BUTTON_H__ */
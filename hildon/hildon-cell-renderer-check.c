@@ -0,0 +1,653 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-cell-renderer-check
+ * @short_description: Cell renderer that looks like a #HildonCheckButton
+ *
+ * #HildonCellRendererCheck draws a check box and a label with the same
+ * layout as a #HildonCheckButton, and toggles when any part of its cell
+ * is tapped. It is meant for long lists of options: instead of creating
+ * one #HildonCheckButton (with its cell view, label and style context)
+ * per option, the options are kept in a #GtkTreeModel and drawn by a
+ * single renderer in a #GtkTreeView, so each row only costs its model
+ * data.
+ *
+ * Like #GtkCellRendererToggle, the renderer does not change the model
+ * itself: it emits #HildonCellRendererCheck::toggled with the path of
+ * the row, and the application updates the row. Columns added with
+ * hildon_cell_renderer_check_append_column() do that already for
+ * #GtkListStore and #GtkTreeStore models.
+ *
+ * <example>
+ * <title>A list of options in a tree view</title>
+ * <programlisting>
+ * GtkWidget *
+ * create_options (GtkListStore *store)
+ * {
+ *     GtkWidget *treeview;
+ *     GtkWidget *area;
+ * <!-- -->
+ *     treeview = hildon_gtk_tree_view_new_with_model (HILDON_UI_MODE_NORMAL,
+ *                                                     GTK_TREE_MODEL (store));
+ *     hildon_cell_renderer_check_append_column (GTK_TREE_VIEW (treeview),
+ *                                               HILDON_SIZE_FINGER_HEIGHT,
+ *                                               LABEL_COLUMN, ACTIVE_COLUMN);
+ * <!-- -->
+ *     area = hildon_pannable_area_new ();
+ *     gtk_container_add (GTK_CONTAINER (area), treeview);
+ * <!-- -->
+ *     return area;
+ * }
+ * </programlisting>
+ * </example>
+ */
+
+#include                                        "hildon-cell-renderer-check.h"
+#include                                        "hildon-enum-types.h"
+#include                                        "hildon-defines.h"
+#include                                        "hildon-check-button.h"
+#include                                        "hildon-private.h"
+
+enum {
+    TOGGLED,
+    LAST_SIGNAL
+};
+
+enum {
+    PROP_LABEL = 1,
+    PROP_ACTIVE,
+    PROP_ACTIVATABLE,
+    PROP_SIZE,
+    PROP_INDICATOR_SIZE
+};
+
+static guint                                    signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE                                   (HildonCellRendererCheck, hildon_cell_renderer_check, GTK_TYPE_CELL_RENDERER);
+
+#define                                         HILDON_CELL_RENDERER_CHECK_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
+                                                HILDON_TYPE_CELL_RENDERER_CHECK, HildonCellRendererCheckPrivate))
+
+struct                                          _HildonCellRendererCheckPrivate
+{
+    gchar *label;
+    HildonSizeType size;
+    gint indicator_size;
+    guint active : 1;
+    guint activatable : 1;
+
+    /* Reused for every row, see get_layout() */
+    PangoLayout *layout;
+    guint layout_serial;
+
+    /* Styled as a #HildonCheckButton in the widget, for its sizes */
+    GtkStyleContext *button_context;
+    GtkStyleContext *button_context_parent;
+};
+
+typedef struct
+{
+    gint indicator;
+    gint image_spacing;
+} Metrics;
+
+/* Sets up the layout for the label of the current cell, or returns
+ * %NULL if it has no text. The layout is created once for @widget and
+ * only gets its text set for each row, until the font or the widget
+ * change. */
+static PangoLayout *
+get_layout                                      (HildonCellRendererCheck *self,
+                                                 GtkWidget               *widget)
+{
+    HildonCellRendererCheckPrivate *priv = self->priv;
+    PangoContext *context = gtk_widget_get_pango_context (widget);
+    guint serial = pango_context_get_serial (context);
+
+    if (priv->label == NULL || priv->label[0] == '\0')
+        return NULL;
+
+    if (priv->layout != NULL &&
+        (pango_layout_get_context (priv->layout) != context ||
+         priv->layout_serial != serial))
+        g_clear_object (&priv->layout);
+
+    if (priv->layout == NULL) {
+        priv->layout = gtk_widget_create_pango_layout (widget, NULL);
+        pango_layout_set_ellipsize (priv->layout, PANGO_ELLIPSIZE_END);
+        priv->layout_serial = serial;
+    }
+
+    pango_layout_set_text (priv->layout, priv->label, -1);
+    pango_layout_set_width (priv->layout, -1);
+
+    return priv->layout;
+}
+
+/* Reads the check box size and image spacing style properties of
+ * #HildonCheckButton, as themed for a button inside @widget. An
+ * indicator size set on the renderer wins over the style. */
+static void
+get_metrics                                     (HildonCellRendererCheck *self,
+                                                 GtkWidget               *widget,
+                                                 Metrics                 *metrics)
+{
+    HildonCellRendererCheckPrivate *priv = self->priv;
+    GtkStyleContext *parent = gtk_widget_get_style_context (widget);
+    guint checkbox_size;
+
+    if (priv->button_context_parent != parent) {
+        GtkWidgetPath *path;
+
+        g_clear_object (&priv->button_context);
+        priv->button_context = gtk_style_context_new ();
+        priv->button_context_parent = parent;
+
+        path = gtk_widget_path_copy (gtk_widget_get_path (widget));
+        gtk_widget_path_append_type (path, HILDON_TYPE_CHECK_BUTTON);
+        gtk_style_context_set_path (priv->button_context, path);
+        gtk_style_context_set_parent (priv->button_context, parent);
+        gtk_style_context_set_screen (priv->button_context, gtk_widget_get_screen (widget));
+        gtk_widget_path_unref (path);
+    }
+
+    gtk_style_context_get_style (priv->button_context,
+                                 "checkbox-size", &checkbox_size,
+                                 "image-spacing", &metrics->image_spacing,
+                                 NULL);
+
+    metrics->indicator = priv->indicator_size >= 0 ? priv->indicator_size : (gint) checkbox_size;
+}
+
+static void
+get_content_size                                (const Metrics           *metrics,
+                                                 PangoLayout             *layout,
+                                                 gint                    *width,
+                                                 gint                    *height)
+{
+    gint label_w = 0, label_h = 0;
+
+    if (layout)
+        pango_layout_get_pixel_size (layout, &label_w, &label_h);
+
+    *width = metrics->indicator;
+    if (layout)
+        *width += metrics->image_spacing + label_w;
+    *height = MAX (metrics->indicator, label_h);
+}
+
+static void
+hildon_cell_renderer_check_get_preferred_width  (GtkCellRenderer *cell,
+                                                 GtkWidget       *widget,
+                                                 gint            *minimum,
+                                                 gint            *natural)
+{
+    HildonCellRendererCheck *self = HILDON_CELL_RENDERER_CHECK (cell);
+    PangoLayout *layout;
+    Metrics metrics;
+    gint xpad, width, height;
+
+    layout = get_layout (self, widget);
+    get_metrics (self, widget, &metrics);
+    get_content_size (&metrics, layout, &width, &height);
+    gtk_cell_renderer_get_padding (cell, &xpad, NULL);
+
+    /* The label is ellipsized, so only the check box is really needed */
+    if (minimum)
+        *minimum = 2 * xpad + metrics.indicator;
+    if (natural)
+        *natural = 2 * xpad + width;
+}
+
+static void
+hildon_cell_renderer_check_get_preferred_height (GtkCellRenderer *cell,
+                                                 GtkWidget       *widget,
+                                                 gint            *minimum,
+                                                 gint            *natural)
+{
+    HildonCellRendererCheck *self = HILDON_CELL_RENDERER_CHECK (cell);
+    HildonCellRendererCheckPrivate *priv = self->priv;
+    PangoLayout *layout;
+    Metrics metrics;
+    gint ypad, width, height;
+
+    layout = get_layout (self, widget);
+    get_metrics (self, widget, &metrics);
+    get_content_size (&metrics, layout, &width, &height);
+    gtk_cell_renderer_get_padding (cell, NULL, &ypad);
+    height += 2 * ypad;
+
+    /* The whole cell is the tap target, so it gets the button height */
+    if (priv->size & HILDON_SIZE_FINGER_HEIGHT)
+        height = MAX (height, HILDON_HEIGHT_FINGER);
+    else if (priv->size & HILDON_SIZE_THUMB_HEIGHT)
+        height = MAX (height, HILDON_HEIGHT_THUMB);
+
+    if (minimum)
+        *minimum = height;
+    if (natural)
+        *natural = height;
+}
+
+static void
+hildon_cell_renderer_check_render               (GtkCellRenderer      *cell,
+                                                 cairo_t              *cr,
+                                                 GtkWidget            *widget,
+                                                 const GdkRectangle   *background_area,
+                                                 const GdkRectangle   *cell_area,
+                                                 GtkCellRendererState  flags)
+{
+    HildonCellRendererCheck *self = HILDON_CELL_RENDERER_CHECK (cell);
+    HildonCellRendererCheckPrivate *priv = self->priv;
+    GtkStyleContext *context;
+    GtkStateFlags state;
+    PangoLayout *layout;
+    Metrics metrics;
+    gint xpad, ypad, width, height;
+    gint x, y, avail_w, avail_h;
+    gfloat xalign, yalign;
+
+    gtk_cell_renderer_get_padding (cell, &xpad, &ypad);
+    gtk_cell_renderer_get_alignment (cell, &xalign, &yalign);
+    state = gtk_cell_renderer_get_state (cell, widget, flags);
+
+    context = gtk_widget_get_style_context (widget);
+    gtk_style_context_save (context);
+    gtk_style_context_add_class (context, GTK_STYLE_CLASS_BUTTON);
+    gtk_style_context_set_state (context, state);
+
+    gtk_render_background (context, cr,
+                           background_area->x, background_area->y,
+                           background_area->width, background_area->height);
+    gtk_render_frame (context, cr,
+                      background_area->x, background_area->y,
+                      background_area->width, background_area->height);
+
+    layout = get_layout (self, widget);
+    get_metrics (self, widget, &metrics);
+    get_content_size (&metrics, layout, &width, &height);
+
+    avail_w = MAX (cell_area->width - 2 * xpad, 0);
+    avail_h = MAX (cell_area->height - 2 * ypad, 0);
+
+    x = cell_area->x + xpad + MAX ((avail_w - width) * xalign, 0);
+    y = cell_area->y + ypad;
+
+    cairo_save (cr);
+    gdk_cairo_rectangle (cr, cell_area);
+    cairo_clip (cr);
+
+    /* The check box, drawn as the toggle renderer inside
+     * #HildonCheckButton draws it */
+    gtk_style_context_save (context);
+    gtk_style_context_add_class (context, GTK_STYLE_CLASS_CHECK);
+    if (priv->active)
+        state |= GTK_STATE_FLAG_CHECKED;
+    gtk_style_context_set_state (context, state);
+    gtk_render_check (context, cr, x,
+                      y + MAX ((avail_h - metrics.indicator) * yalign, 0),
+                      metrics.indicator, metrics.indicator);
+    gtk_style_context_restore (context);
+
+    if (layout) {
+        gint label_w, label_h;
+
+        x += metrics.indicator + metrics.image_spacing;
+        avail_w = MAX (cell_area->x + cell_area->width - xpad - x, 0);
+
+        pango_layout_set_width (layout, avail_w * PANGO_SCALE);
+        pango_layout_get_pixel_size (layout, &label_w, &label_h);
+        gtk_render_layout (context, cr, x,
+                           y + MAX ((avail_h - label_h) * yalign, 0), layout);
+    }
+
+    cairo_restore (cr);
+    gtk_style_context_restore (context);
+}
+
+static gboolean
+hildon_cell_renderer_check_activate             (GtkCellRenderer      *cell,
+                                                 GdkEvent             *event,
+                                                 GtkWidget            *widget,
+                                                 const gchar          *path,
+                                                 const GdkRectangle   *background_area,
+                                                 const GdkRectangle   *cell_area,
+                                                 GtkCellRendererState  flags)
+{
+    HildonCellRendererCheck *self = HILDON_CELL_RENDERER_CHECK (cell);
+
+    /* Taps anywhere in the cell toggle, not only on the check box */
+    if (!self->priv->activatable)
+        return FALSE;
+
+    g_signal_emit (self, signals[TOGGLED], 0, path);
+
+    return TRUE;
+}
+
+static void
+hildon_cell_renderer_check_set_property         (GObject      *object,
+                                                 guint         prop_id,
+                                                 const GValue *value,
+                                                 GParamSpec   *pspec)
+{
+    HildonCellRendererCheckPrivate *priv = HILDON_CELL_RENDERER_CHECK (object)->priv;
+
+    switch (prop_id)
+    {
+    case PROP_LABEL:
+        g_free (priv->label);
+        priv->label = g_value_dup_string (value);
+        break;
+    case PROP_ACTIVE:
+        priv->active = g_value_get_boolean (value);
+        break;
+    case PROP_ACTIVATABLE:
+        priv->activatable = g_value_get_boolean (value);
+        g_object_set (object, "mode", priv->activatable ?
+                      GTK_CELL_RENDERER_MODE_ACTIVATABLE : GTK_CELL_RENDERER_MODE_INERT,
+                      NULL);
+        break;
+    case PROP_SIZE:
+        priv->size = g_value_get_flags (value);
+        break;
+    case PROP_INDICATOR_SIZE:
+        priv->indicator_size = g_value_get_int (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+hildon_cell_renderer_check_get_property         (GObject    *object,
+                                                 guint       prop_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonCellRendererCheckPrivate *priv = HILDON_CELL_RENDERER_CHECK (object)->priv;
+
+    switch (prop_id)
+    {
+    case PROP_LABEL:
+        g_value_set_string (value, priv->label);
+        break;
+    case PROP_ACTIVE:
+        g_value_set_boolean (value, priv->active);
+        break;
+    case PROP_ACTIVATABLE:
+        g_value_set_boolean (value, priv->activatable);
+        break;
+    case PROP_SIZE:
+        g_value_set_flags (value, priv->size);
+        break;
+    case PROP_INDICATOR_SIZE:
+        g_value_set_int (value, priv->indicator_size);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+hildon_cell_renderer_check_finalize             (GObject *object)
+{
+    HildonCellRendererCheckPrivate *priv = HILDON_CELL_RENDERER_CHECK (object)->priv;
+
+    g_free (priv->label);
+    g_clear_object (&priv->layout);
+    g_clear_object (&priv->button_context);
+
+    G_OBJECT_CLASS (hildon_cell_renderer_check_parent_class)->finalize (object);
+}
+
+static void
+hildon_cell_renderer_check_class_init           (HildonCellRendererCheckClass *klass)
+{
+    GObjectClass *gobject_class = (GObjectClass *) klass;
+    GtkCellRendererClass *cell_class = (GtkCellRendererClass *) klass;
+
+    gobject_class->set_property = hildon_cell_renderer_check_set_property;
+    gobject_class->get_property = hildon_cell_renderer_check_get_property;
+    gobject_class->finalize = hildon_cell_renderer_check_finalize;
+
+    cell_class->get_preferred_width = hildon_cell_renderer_check_get_preferred_width;
+    cell_class->get_preferred_height = hildon_cell_renderer_check_get_preferred_height;
+    cell_class->render = hildon_cell_renderer_check_render;
+    cell_class->activate = hildon_cell_renderer_check_activate;
+
+    klass->toggled = NULL;
+
+    /**
+     * HildonCellRendererCheck::toggled:
+     * @cell: the object which received the signal
+     * @path: string representation of the #GtkTreePath of the row
+     *
+     * Emitted when the cell is tapped. The application is expected to
+     * toggle the value of the row at @path.
+     *
+     * Since: 3.0
+     */
+    signals[TOGGLED] =
+        g_signal_new ("toggled",
+                      G_OBJECT_CLASS_TYPE (gobject_class),
+                      G_SIGNAL_RUN_LAST,
+                      G_STRUCT_OFFSET (HildonCellRendererCheckClass, toggled),
+                      NULL, NULL,
+                      g_cclosure_marshal_VOID__STRING,
+                      G_TYPE_NONE, 1, G_TYPE_STRING);
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_LABEL,
+        g_param_spec_string (
+            "label",
+            "Label",
+            "Text of the label next to the check box",
+            NULL,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_ACTIVE,
+        g_param_spec_boolean (
+            "active",
+            "Active",
+            "Whether the check box is checked",
+            FALSE,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_ACTIVATABLE,
+        g_param_spec_boolean (
+            "activatable",
+            "Activatable",
+            "Whether tapping the cell toggles it",
+            TRUE,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_SIZE,
+        g_param_spec_flags (
+            "size",
+            "Size",
+            "Size request for the cell",
+            HILDON_TYPE_SIZE_TYPE,
+            HILDON_SIZE_AUTO,
+            G_PARAM_READWRITE));
+
+    g_object_class_install_property (
+        gobject_class,
+        PROP_INDICATOR_SIZE,
+        g_param_spec_int (
+            "indicator-size",
+            "Indicator size",
+            "Size of the check box, or -1 to use the HildonCheckButton style",
+            -1, G_MAXINT, -1,
+            G_PARAM_READWRITE));
+
+    g_type_class_add_private (klass, sizeof (HildonCellRendererCheckPrivate));
+}
+
+static void
+hildon_cell_renderer_check_init                 (HildonCellRendererCheck *self)
+{
+    HildonCellRendererCheckPrivate *priv = HILDON_CELL_RENDERER_CHECK_GET_PRIVATE (self);
+
+    self->priv = priv;
+
+    priv->label = NULL;
+    priv->size = HILDON_SIZE_AUTO;
+    priv->indicator_size = -1;
+    priv->active = FALSE;
+    priv->activatable = TRUE;
+
+    /* Same as the xalign set by #HildonCheckButton */
+    gtk_cell_renderer_set_alignment (GTK_CELL_RENDERER (self), 0.0, 0.5);
+    g_object_set (self, "mode", GTK_CELL_RENDERER_MODE_ACTIVATABLE, NULL);
+}
+
+/**
+ * hildon_cell_renderer_check_new:
+ * @size: Flags to set the height of the cells
+ *
+ * Creates a new #HildonCellRendererCheck. Its "label" and "active"
+ * properties are usually bound to model columns, see
+ * gtk_tree_view_column_add_attribute().
+ *
+ * Returns: a new #HildonCellRendererCheck
+ *
+ * Since: 3.0
+ **/
+GtkCellRenderer *
+hildon_cell_renderer_check_new                  (HildonSizeType size)
+{
+    return g_object_new (HILDON_TYPE_CELL_RENDERER_CHECK,
+                         "size", size,
+                         NULL);
+}
+
+static GQuark
+active_column_quark                             (void)
+{
+    static GQuark quark = 0;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-cell-renderer-check-active-column");
+
+    return quark;
+}
+
+static void
+on_column_toggled                               (HildonCellRendererCheck *cell,
+                                                 const gchar             *path,
+                                                 GtkTreeView             *treeview)
+{
+    GtkTreeModel *model = gtk_tree_view_get_model (treeview);
+    gint column = GPOINTER_TO_INT (g_object_get_qdata (G_OBJECT (cell),
+                                                       active_column_quark ())) - 1;
+    GtkTreeIter iter;
+    gboolean active;
+
+    if (model == NULL || column < 0 ||
+        !(GTK_IS_LIST_STORE (model) || GTK_IS_TREE_STORE (model)) ||
+        !gtk_tree_model_get_iter_from_string (model, &iter, path))
+        return;
+
+    gtk_tree_model_get (model, &iter, column, &active, -1);
+
+    if (GTK_IS_LIST_STORE (model))
+        gtk_list_store_set (GTK_LIST_STORE (model), &iter, column, !active, -1);
+    else
+        gtk_tree_store_set (GTK_TREE_STORE (model), &iter, column, !active, -1);
+}
+
+/**
+ * hildon_cell_renderer_check_append_column:
+ * @treeview: A #GtkTreeView
+ * @size: Flags to set the height of the cells
+ * @label_column: model column with the labels, or -1
+ * @active_column: model column with the states, of type %G_TYPE_BOOLEAN
+ *
+ * Appends to @treeview a column drawn by a new #HildonCellRendererCheck,
+ * with its label and state taken from the given model columns. If the
+ * model of @treeview is a #GtkListStore or a #GtkTreeStore, tapping a
+ * row toggles @active_column in it; for other models, connect to
+ * #HildonCellRendererCheck::toggled.
+ *
+ * The column uses fixed sizing and, if all the other columns of
+ * @treeview do as well, fixed height mode is enabled so @treeview does
+ * not need to measure every row of the model.
+ *
+ * Returns: the new #GtkTreeViewColumn, owned by @treeview
+ *
+ * Since: 3.0
+ **/
+GtkTreeViewColumn *
+hildon_cell_renderer_check_append_column        (GtkTreeView    *treeview,
+                                                 HildonSizeType  size,
+                                                 gint            label_column,
+                                                 gint            active_column)
+{
+    GtkTreeViewColumn *column;
+    GtkCellRenderer *renderer;
+    GList *columns, *iter;
+
+    g_return_val_if_fail (GTK_IS_TREE_VIEW (treeview), NULL);
+    g_return_val_if_fail (active_column >= 0, NULL);
+
+    renderer = hildon_cell_renderer_check_new (size);
+
+    column = gtk_tree_view_column_new ();
+    gtk_tree_view_column_pack_start (column, renderer, TRUE);
+    gtk_tree_view_column_set_expand (column, TRUE);
+
+    if (label_column >= 0)
+        gtk_tree_view_column_add_attribute (column, renderer, "label", label_column);
+    gtk_tree_view_column_add_attribute (column, renderer, "active", active_column);
+
+    g_object_set_qdata (G_OBJECT (renderer), active_column_quark (),
+                        GINT_TO_POINTER (active_column + 1));
+    g_signal_connect_object (renderer, "toggled",
+                             G_CALLBACK (on_column_toggled), treeview, 0);
+
+    /* All rows share the same height, so let the tree view skip the
+     * per-row measuring if no other column needs it */
+    gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_append_column (treeview, column);
+
+    columns = gtk_tree_view_get_columns (treeview);
+    for (iter = columns; iter != NULL; iter = iter->next) {
+        if (gtk_tree_view_column_get_sizing (iter->data) != GTK_TREE_VIEW_COLUMN_FIXED)
+            break;
+    }
+    if (iter == NULL)
+        gtk_tree_view_set_fixed_height_mode (treeview, TRUE);
+    g_list_free (columns);
+
+    return column;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_CELL_RENDERER_CHECK_H__
+#define                                         __HILDON_CELL_RENDERER_CHECK_H__
+
+#include                                        "hildon-gtk.h"
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_CELL_RENDERER_CHECK \
+                                                (hildon_cell_renderer_check_get_type())
+
+#define                                         HILDON_CELL_RENDERER_CHECK(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_CELL_RENDERER_CHECK, HildonCellRendererCheck))
+
+#define                                         HILDON_CELL_RENDERER_CHECK_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                                HILDON_TYPE_CELL_RENDERER_CHECK, HildonCellRendererCheckClass))
+
+#define                                         HILDON_IS_CELL_RENDERER_CHECK(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HILDON_TYPE_CELL_RENDERER_CHECK))
+
+#define                                         HILDON_IS_CELL_RENDERER_CHECK_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_TYPE ((klass), HILDON_TYPE_CELL_RENDERER_CHECK))
+
+#define                                         HILDON_CELL_RENDERER_CHECK_GET_CLASS(obj) \
+                                                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                                HILDON_TYPE_CELL_RENDERER_CHECK, HildonCellRendererCheckClass))
+
+typedef struct                                  _HildonCellRendererCheck HildonCellRendererCheck;
+
+typedef struct                                  _HildonCellRendererCheckClass HildonCellRendererCheckClass;
+
+typedef struct                                  _HildonCellRendererCheckPrivate HildonCellRendererCheckPrivate;
+
+struct                                          _HildonCellRendererCheckClass
+{
+    GtkCellRendererClass parent_class;
+
+    void (*toggled)                             (HildonCellRendererCheck *cell,
+                                                 const gchar             *path);
+};
+
+struct                                          _HildonCellRendererCheck
+{
+    GtkCellRenderer parent;
+
+    /* private */
+    HildonCellRendererCheckPrivate *priv;
+};
+
+GType
+hildon_cell_renderer_check_get_type             (void) G_GNUC_CONST;
+
+GtkCellRenderer *
+hildon_cell_renderer_check_new                  (HildonSizeType size);
+
+GtkTreeViewColumn *
+hildon_cell_renderer_check_append_column        (GtkTreeView    *treeview,
+                                                 HildonSizeType  size,
+                                                 gint            label_column,
+                                                 gint            active_column);
+
+G_END_DECLS
+
+#endif /* __HILDON_CELL_RENDERER_CHECK_H__ */
@@ -48,6 +48,9 @@
 #include <langinfo.h>
 
 #include "hildon-date-selector.h"
+#include "hildon-touch-selector-private.h"
+#include "hildon-touch-selector-virtual-model-private.h"
+#include "hildon-private.h"
 
 #define HILDON_DATE_SELECTOR_GET_PRIVATE(obj)                           \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HILDON_TYPE_DATE_SELECTOR, HildonDateSelectorPrivate))
@@ -92,6 +95,11 @@ struct _HildonDateSelectorPrivate
   gint creation_month;
   gint creation_year;           /* date at creation time */
 
+  gint year;
+  gint month;
+  gint day;                     /* selected date, kept in sync with the
+                                 * columns by _manage_selector_change_cb() */
+
   gint current_num_days;
 
   gint min_year;
@@ -298,10 +306,30 @@ hildon_date_selector_construct_ui (HildonDateSelector *selector)
   GSList *iter = NULL;
   gint current_item = 0;
   HildonTouchSelectorColumn *column = NULL;
-
-  selector->priv->year_model = _create_year_model (selector);
-  selector->priv->month_model = _create_month_model (selector);
-  selector->priv->day_model = _create_day_model (selector);
+  gchar *key;
+
+  /* Years and months never change, so they are shared with the other
+     selectors using the same locale and range */
+  key = g_strdup_printf ("year:%s:%s:%d:%d", setlocale (LC_TIME, NULL), _("wdgt_va_year"),
+                         selector->priv->min_year, selector->priv->max_year);
+  selector->priv->year_model = hildon_touch_selector_get_shared_model
+    (key, (HildonTouchSelectorModelFunc) _create_year_model, selector);
+  g_free (key);
+
+  key = g_strdup_printf ("month:%s:%s", setlocale (LC_TIME, NULL), _("wdgt_va_month"));
+  selector->priv->month_model = hildon_touch_selector_get_shared_model
+    (key, (HildonTouchSelectorModelFunc) _create_month_model, selector);
+  g_free (key);
+
+  /* The days of the month are hidden by the column, not removed from
+     the model, so the day model can be shared too */
+  key = g_strdup_printf ("day:%s", _("wdgt_va_day_numeric"));
+  selector->priv->day_model = hildon_touch_selector_get_shared_model
+    (key, (HildonTouchSelectorModelFunc) _create_day_model, selector);
+  g_free (key);
+
+  /* The columns are only filled when the selector is shown */
+  hildon_touch_selector_set_lazy_columns (HILDON_TOUCH_SELECTOR (selector), TRUE);
 
   /* We add the columns, checking the locale order */
   iter = selector->priv->column_order;
@@ -411,10 +439,8 @@ static gchar *
 _custom_print_func (HildonTouchSelector * touch_selector, gpointer user_data)
 {
   HildonDateSelector *selector = NULL;
-  gchar *result = NULL;
   guint year, month, day;
   gint day_of_week = 0;
-  static gchar string[255];
   struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
   selector = HILDON_DATE_SELECTOR (touch_selector);
@@ -427,11 +453,7 @@ _custom_print_func (HildonTouchSelector * touch_selector, gpointer user_data)
   tm.tm_year = year - 1900;
   tm.tm_wday = day_of_week;
 
-  strftime (string, 255, _("wdgt_va_date_long"), &tm);
-
-  result = g_strdup (string);
-
-  return result;
+  return hildon_format_time (_("wdgt_va_date_long"), &tm);
 }
 
 /* This was copied from hildon-calendar */
@@ -443,14 +465,26 @@ _locales_init (HildonDateSelectorPrivate * priv)
    * The labels need to be instance variables as the startup wizard changes
    * locale on runtime.
    */
+  static gchar *format_locale = NULL;
+  static gchar *format = NULL;
+  const gchar *locale = setlocale (LC_MESSAGES, NULL);
   locale_t l;
 
-  l = newlocale (LC_TIME_MASK, setlocale (LC_MESSAGES, NULL), NULL);
+  /* Asking the locale is expensive, so the format is only looked up
+     again when the locale changes */
+  if (format == NULL || g_strcmp0 (locale, format_locale) != 0) {
+    l = newlocale (LC_TIME_MASK, locale, NULL);
 
-  priv->format = g_locale_to_utf8 (nl_langinfo_l (D_FMT, l),
-                                   -1, NULL, NULL, NULL);
+    g_free (format);
+    format = g_locale_to_utf8 (nl_langinfo_l (D_FMT, l),
+                               -1, NULL, NULL, NULL);
+    g_free (format_locale);
+    format_locale = g_strdup (locale);
 
-  freelocale (l);
+    freelocale (l);
+  }
+
+  priv->format = g_strdup (format);
 }
 
 static void
@@ -531,43 +565,44 @@ _create_day_model (HildonDateSelector * selector)
 {
   GtkListStore *store_days = NULL;
   gint i = 0;
-  gchar label[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
   GtkTreeIter iter;
+  gchar *label;
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
   store_days = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
   for (i = 1; i < 32; i++) {
     tm.tm_mday = i;
-    strftime (label, 255, _("wdgt_va_day_numeric"), &tm);
-
-    gtk_list_store_append (store_days, &iter);
-    gtk_list_store_set (store_days, &iter,
-                        COLUMN_STRING, label, COLUMN_INT, i, -1);
+    label = hildon_format_time (_("wdgt_va_day_numeric"), &tm);
+    gtk_list_store_insert_with_values (store_days, &iter, -1,
+                                       COLUMN_STRING, label, COLUMN_INT, i, -1);
+    g_free (label);
   }
 
   return GTK_TREE_MODEL (store_days);
 }
 
-static GtkTreeModel *
-_create_year_model (HildonDateSelector * selector)
+static gchar *
+_year_label (gint row, gpointer data)
 {
-  GtkListStore *store_years = NULL;
-  gint i = 0;
-  static gchar label[255];
   struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  GtkTreeIter iter;
 
-  store_years = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-  for (i = selector->priv->min_year; i < selector->priv->max_year + 1; i++) {
-    tm.tm_year = i - 1900;
-    strftime (label, 255, _("wdgt_va_year"), &tm);
+  tm.tm_year = GPOINTER_TO_INT (data) + row - 1900;
 
-    gtk_list_store_append (store_years, &iter);
-    gtk_list_store_set (store_years, &iter,
-                        COLUMN_STRING, label, COLUMN_INT, i, -1);
-  }
+  return hildon_format_time (_("wdgt_va_year"), &tm);
+}
 
-  return GTK_TREE_MODEL (store_years);
+/* Year ranges can be wide, so the rows are not stored: the year of a
+   row is computed from its index and the label is only formatted when
+   the row is displayed */
+static GtkTreeModel *
+_create_year_model (HildonDateSelector * selector)
+{
+  gint min_year = selector->priv->min_year;
+
+  return hildon_touch_selector_virtual_model_new_range (min_year, 1,
+                                                        selector->priv->max_year - min_year + 1,
+                                                        _year_label,
+                                                        GINT_TO_POINTER (min_year), NULL);
 }
 
 static GtkTreeModel *
@@ -576,77 +611,51 @@ _create_month_model (HildonDateSelector * selector)
   GtkTreeIter iter;
   gint i = 0;
   GtkListStore *store_months = NULL;
-  static gchar label[255];
+  gchar *label;
   struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
   store_months = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
   for (i = 0; i < 12; i++) {
     tm.tm_mon = i;
-    strftime (label, 255, _("wdgt_va_month"), &tm);
+    label = hildon_format_time (_("wdgt_va_month"), &tm);
 
     gtk_list_store_append (store_months, &iter);
     gtk_list_store_set (store_months, &iter, COLUMN_STRING, label,
                         COLUMN_INT, i,
                         -1);
+    g_free (label);
   }
 
   return GTK_TREE_MODEL (store_months);
 }
 
+/* All the days stay in the model, the ones that the month doesn't have
+   are just hidden in the column, so changing the month doesn't modify
+   the model nor lose the selected day when it still exists */
 static GtkTreeModel *
 _update_day_model (HildonDateSelector * selector)
 {
-  GtkListStore *store_days = NULL;
-  GtkTreePath *path = NULL;
-  gint i = 0;
-  GtkTreeIter iter;
-  static gchar label[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  guint current_day = 0;
-  guint current_year = 0;
-  guint current_month = 0;
+  HildonTouchSelectorColumn *column;
   gint num_days = 31;
 
-  hildon_date_selector_get_date (selector, &current_year, &current_month,
-                                 &current_day);
-
-  num_days = _month_days (current_month, current_year);
-  store_days = GTK_LIST_STORE (selector->priv->day_model);
+  num_days = _month_days (selector->priv->month, selector->priv->year);
 
   if (num_days == selector->priv->current_num_days) {
-    return GTK_TREE_MODEL (store_days);
+    return selector->priv->day_model;
   }
 
-  if (num_days > selector->priv->current_num_days) {
-    for (i = selector->priv->current_num_days + 1; i <= num_days; i++) {
-      tm.tm_mday = i;
-      strftime (label, 255, _("wdgt_va_day_numeric"), &tm);
-
-      gtk_list_store_append (store_days, &iter);
-      gtk_list_store_set (store_days, &iter,
-                          COLUMN_STRING, label, COLUMN_INT, i, -1);
-    }
-  } else {
-    path = gtk_tree_path_new_from_indices (num_days,
-                                           -1);
-    gtk_tree_model_get_iter (GTK_TREE_MODEL (store_days), &iter, path);
-    do {
-    }while (gtk_list_store_remove (store_days, &iter));
-
-    gtk_tree_path_free (path);
-  }
-
-
   selector->priv->current_num_days = num_days;
 
-  /* now we select a day */
-  if (current_day >= num_days) {
-    current_day = num_days;
-  }
+  column = hildon_touch_selector_get_column (HILDON_TOUCH_SELECTOR (selector),
+                                             selector->priv->day_column);
+  hildon_touch_selector_column_set_visible_rows (column, num_days);
 
-  hildon_date_selector_select_day (selector, current_day);
+  /* the selected day was hidden, select the last one */
+  if (selector->priv->day > num_days) {
+    hildon_date_selector_select_day (selector, num_days);
+  }
 
-  return GTK_TREE_MODEL (store_days);
+  return selector->priv->day_model;
 }
 
 
@@ -673,14 +682,39 @@ _get_real_date (gint * year, gint * month, gint * day)
 }
 
 
+static void
+_day_model_settled_cb (HildonTouchSelector * touch_selector, gpointer data)
+{
+  _update_day_model (HILDON_DATE_SELECTOR (touch_selector));
+}
+
 static void
 _manage_selector_change_cb (HildonTouchSelector * touch_selector,
                             gint num_column, gpointer data)
 {
   HildonDateSelector *selector = NULL;
+  HildonDateSelectorPrivate *priv;
+  gint index;
 
   g_return_if_fail (HILDON_IS_DATE_SELECTOR (touch_selector));
   selector = HILDON_DATE_SELECTOR (touch_selector);
+  priv = selector->priv;
+
+  /* Only the column which changed is read back, the rows of each
+     column are consecutive values */
+  if (num_column == priv->year_column) {
+    index = hildon_touch_selector_get_active (touch_selector, num_column);
+    if (index >= 0)
+      priv->year = priv->min_year + index;
+  } else if (num_column == priv->month_column) {
+    index = hildon_touch_selector_get_active (touch_selector, num_column);
+    if (index >= 0)
+      priv->month = index;
+  } else if (num_column == priv->day_column) {
+    index = hildon_touch_selector_get_active (touch_selector, num_column);
+    if (index >= 0)
+      priv->day = index + 1;
+  }
 
   if ((num_column == selector->priv->month_column) ||
       (num_column == selector->priv->year_column)) /* it is required to check that with
@@ -689,7 +723,10 @@ _manage_selector_change_cb (HildonTouchSelector * touch_selector,
                                                     * the number of days is different
                                                     */
   {
-    _update_day_model (selector);
+    /* Spinning through the months would hide and show days at every
+       step, they are only updated once the column comes to rest */
+    hildon_touch_selector_queue_settled (touch_selector, num_column,
+                                         _day_model_settled_cb, NULL);
   }
 }
 
@@ -782,11 +819,14 @@ gboolean
 hildon_date_selector_select_current_date (HildonDateSelector * selector,
                                           guint year, guint month, guint day)
 {
-  GtkTreeIter iter;
+  HildonTouchSelector *touch_selector;
+  HildonDateSelectorPrivate *priv;
   gint min_year = 0;
   gint max_year = 0;
   gint num_days = 0;
 
+  g_return_val_if_fail (HILDON_IS_DATE_SELECTOR (selector), FALSE);
+
   min_year = selector->priv->min_year;
   max_year = selector->priv->max_year;
 
@@ -796,24 +836,25 @@ hildon_date_selector_select_current_date (HildonDateSelector * selector,
   num_days = _month_days (month, year);
   g_return_val_if_fail (day > 0 && day <= num_days, FALSE);
 
+  touch_selector = HILDON_TOUCH_SELECTOR (selector);
+  priv = selector->priv;
+
+  priv->year = year;
+  priv->month = month;
+  priv->day = day;
+
+  /* The three columns change together, the listeners are only told
+     once they all show the new date */
+  hildon_touch_selector_freeze_changed (touch_selector);
 
-  gtk_tree_model_iter_nth_child (selector->priv->year_model, &iter, NULL,
-                                 year - min_year);
-  hildon_touch_selector_select_iter (HILDON_TOUCH_SELECTOR (selector),
-                                     selector->priv->year_column, &iter,
-                                     FALSE);
+  /* Show the days of the new month before selecting one of them */
+  _update_day_model (selector);
 
-  gtk_tree_model_iter_nth_child (selector->priv->month_model, &iter, NULL,
-                                 month);
-  hildon_touch_selector_select_iter (HILDON_TOUCH_SELECTOR (selector),
-                                     selector->priv->month_column, &iter,
-                                     FALSE);
+  hildon_touch_selector_set_active (touch_selector, priv->year_column, year - min_year);
+  hildon_touch_selector_set_active (touch_selector, priv->month_column, month);
+  hildon_touch_selector_set_active (touch_selector, priv->day_column, day - 1);
 
-  gtk_tree_model_iter_nth_child (selector->priv->day_model, &iter, NULL,
-                                 day - 1);
-  hildon_touch_selector_select_iter (HILDON_TOUCH_SELECTOR (selector),
-                                     selector->priv->day_column, &iter,
-                                     FALSE);
+  hildon_touch_selector_thaw_changed (touch_selector);
 
   return TRUE;
 }
@@ -834,32 +875,24 @@ void
 hildon_date_selector_get_date (HildonDateSelector * selector,
                                guint * year, guint * month, guint * day)
 {
-  GtkTreeIter iter;
+  HildonDateSelectorPrivate *priv;
 
-  if (year != NULL) {
-    if (hildon_touch_selector_get_selected (HILDON_TOUCH_SELECTOR (selector),
-                                            selector->priv->year_column, &iter))
-      gtk_tree_model_get (selector->priv->year_model,
-                          &iter, COLUMN_INT, year, -1);
-  }
+  g_return_if_fail (HILDON_IS_DATE_SELECTOR (selector));
 
-  if (month != NULL) {
-    if (hildon_touch_selector_get_selected (HILDON_TOUCH_SELECTOR (selector),
-                                            selector->priv->month_column, &iter))
-      gtk_tree_model_get (selector->priv->month_model,
-                          &iter, COLUMN_INT, month, -1);
-  }
+  priv = selector->priv;
 
-  if (day != NULL) {
-    if (hildon_touch_selector_get_selected (HILDON_TOUCH_SELECTOR (selector),
-                                            selector->priv->day_column, &iter))
-    {
-      gtk_tree_model_get (selector->priv->day_model,
-                          &iter, COLUMN_INT, day, -1);
-    }
-/*       *day = *day - 1;  */
-  }
+  /* The date is kept up to date as the columns change, reading it
+     doesn't need to look at the columns */
+  if (year != NULL)
+    *year = priv->year;
+
+  if (month != NULL)
+    *month = priv->month;
 
+  /* The day column may still show a day that the new month doesn't
+     have if it hasn't been updated yet */
+  if (day != NULL)
+    *day = MIN (priv->day, _month_days (priv->month, priv->year));
 }
 
 
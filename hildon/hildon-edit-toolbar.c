@@ -89,6 +89,9 @@ struct                                          _HildonEditToolbarPrivate
     GtkWidget *animation;
     GtkButton *button;
     GtkButton *arrow;
+    cairo_surface_t *background;
+    gint background_width;
+    gint background_height;
 };
 
 enum {
@@ -117,15 +120,87 @@ hildon_edit_toolbar_style_set                   (GtkWidget *widget,
     gtk_widget_set_size_request (GTK_WIDGET (priv->arrow), width, height);
 }
 
+static void
+hildon_edit_toolbar_clear_background            (HildonEditToolbarPrivate *priv)
+{
+    if (priv->background) {
+        cairo_surface_destroy (priv->background);
+        priv->background = NULL;
+    }
+}
+
+static void
+hildon_edit_toolbar_style_updated               (GtkWidget *widget)
+{
+    HildonEditToolbarPrivate *priv = HILDON_EDIT_TOOLBAR_GET_PRIVATE (widget);
+
+    GTK_WIDGET_CLASS (hildon_edit_toolbar_parent_class)->style_updated (widget);
+
+    hildon_edit_toolbar_clear_background (priv);
+}
+
+static void
+hildon_edit_toolbar_state_flags_changed         (GtkWidget     *widget,
+                                                 GtkStateFlags  previous_state)
+{
+    HildonEditToolbarPrivate *priv = HILDON_EDIT_TOOLBAR_GET_PRIVATE (widget);
+
+    if (GTK_WIDGET_CLASS (hildon_edit_toolbar_parent_class)->state_flags_changed)
+        GTK_WIDGET_CLASS (hildon_edit_toolbar_parent_class)->state_flags_changed (widget,
+                                                                                  previous_state);
+
+    /* The theme can style the background per state */
+    hildon_edit_toolbar_clear_background (priv);
+}
+
+static void
+hildon_edit_toolbar_unrealize                   (GtkWidget *widget)
+{
+    HildonEditToolbarPrivate *priv = HILDON_EDIT_TOOLBAR_GET_PRIVATE (widget);
+
+    /* The cached background is similar to the window being dropped */
+    hildon_edit_toolbar_clear_background (priv);
+
+    GTK_WIDGET_CLASS (hildon_edit_toolbar_parent_class)->unrealize (widget);
+}
+
+/* The toolbar stays on top of content that is scrolled in edit mode,
+ * so its background is rendered once, and then only blitted until the
+ * size or the theme change */
 static gboolean
 hildon_edit_toolbar_draw                        (GtkWidget *widget,
                                                  cairo_t   *cr)
 {
-    gtk_render_background (gtk_widget_get_style_context (widget),
-                           cr,
-                           0, 0,
-                           gtk_widget_get_allocated_width (widget),
-                           gtk_widget_get_allocated_height (widget));
+    HildonEditToolbarPrivate *priv = HILDON_EDIT_TOOLBAR_GET_PRIVATE (widget);
+    gint width = gtk_widget_get_allocated_width (widget);
+    gint height = gtk_widget_get_allocated_height (widget);
+
+    if (priv->background &&
+        (priv->background_width != width || priv->background_height != height))
+        hildon_edit_toolbar_clear_background (priv);
+
+    if (priv->background == NULL && width > 0 && height > 0) {
+        cairo_t *background_cr;
+
+        priv->background = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                                              CAIRO_CONTENT_COLOR_ALPHA,
+                                                              width, height);
+        priv->background_width = width;
+        priv->background_height = height;
+
+        background_cr = cairo_create (priv->background);
+        gtk_render_background (gtk_widget_get_style_context (widget),
+                               background_cr,
+                               0, 0, width, height);
+        cairo_destroy (background_cr);
+    }
+
+    if (priv->background) {
+        cairo_save (cr);
+        cairo_set_source_surface (cr, priv->background, 0, 0);
+        cairo_paint (cr);
+        cairo_restore (cr);
+    }
 
     if (GTK_WIDGET_CLASS (hildon_edit_toolbar_parent_class)->draw)
         return GTK_WIDGET_CLASS (hildon_edit_toolbar_parent_class)->draw (widget, cr);
@@ -140,6 +215,9 @@ hildon_edit_toolbar_class_init                  (HildonEditToolbarClass *klass)
     GtkWidgetClass *widget_class = (GtkWidgetClass *)klass;
 
     widget_class->style_set = hildon_edit_toolbar_style_set;
+    widget_class->style_updated = hildon_edit_toolbar_style_updated;
+    widget_class->state_flags_changed = hildon_edit_toolbar_state_flags_changed;
+    widget_class->unrealize = hildon_edit_toolbar_unrealize;
     widget_class->draw = hildon_edit_toolbar_draw;
 
     g_type_class_add_private (klass, sizeof (HildonEditToolbarPrivate));
@@ -43,17 +43,46 @@
  * }
  * </programlisting>
  * </example>
+ *
+ * Handlers that do expensive work for every change of the text, like
+ * database queries or validation, can connect to #HildonEntry::settled
+ * instead of #GtkEditable::changed. Once #HildonEntry:settle-delay is
+ * set, the signal is emitted only after typing pauses for that long,
+ * and fast input bursts cost a single emission. #HildonEntry:settle-max-wait
+ * bounds how long a continuous burst can postpone it.
  */
 
 #include                                        "hildon-entry.h"
 #include					"hildon-enum-types.h"
+#include                                        "hildon-private.h"
 
 G_DEFINE_TYPE                                   (HildonEntry, hildon_entry, GTK_TYPE_ENTRY);
 
+#define                                         HILDON_ENTRY_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
+                                                HILDON_TYPE_ENTRY, HildonEntryPrivate))
+
+struct                                          _HildonEntryPrivate
+{
+    guint settle_delay;
+    guint settle_max_wait;
+    guint settle_timeout_id;
+    gint64 first_change;
+};
+
+enum {
+    PROP_SIZE = 1,
+    PROP_SETTLE_DELAY,
+    PROP_SETTLE_MAX_WAIT
+};
+
 enum {
-    PROP_SIZE = 1
+    SETTLED,
+    LAST_SIGNAL
 };
 
+static guint                                    signals[LAST_SIGNAL] = { 0 };
+
 static void
 set_property                                    (GObject      *object,
                                                  guint         prop_id,
@@ -71,6 +100,38 @@ set_property                                    (GObject      *object,
 	  size |= HILDON_SIZE_FINGER_HEIGHT;
 	hildon_gtk_widget_set_theme_size (GTK_WIDGET (object), size);
         break;
+    case PROP_SETTLE_DELAY:
+        hildon_entry_set_settle_delay (HILDON_ENTRY (object),
+                                       g_value_get_uint (value),
+                                       HILDON_ENTRY (object)->priv->settle_max_wait);
+        break;
+    case PROP_SETTLE_MAX_WAIT:
+        hildon_entry_set_settle_delay (HILDON_ENTRY (object),
+                                       HILDON_ENTRY (object)->priv->settle_delay,
+                                       g_value_get_uint (value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+get_property                                    (GObject    *object,
+                                                 guint       prop_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonEntryPrivate *priv = HILDON_ENTRY (object)->priv;
+
+    switch (prop_id)
+    {
+    case PROP_SETTLE_DELAY:
+        g_value_set_uint (value, priv->settle_delay);
+        break;
+    case PROP_SETTLE_MAX_WAIT:
+        g_value_set_uint (value, priv->settle_max_wait);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -93,12 +154,161 @@ hildon_entry_new                                (HildonSizeType size)
     return g_object_new (HILDON_TYPE_ENTRY, "size", size, NULL);
 }
 
+static gboolean
+hildon_entry_settle_timeout                     (gpointer data)
+{
+    HildonEntry *entry = HILDON_ENTRY (data);
+
+    entry->priv->settle_timeout_id = 0;
+    g_signal_emit (entry, signals[SETTLED], 0);
+
+    return FALSE;
+}
+
+static void
+hildon_entry_changed                            (GtkEditable *editable,
+                                                 gpointer     user_data)
+{
+    HildonEntry *entry = HILDON_ENTRY (editable);
+    HildonEntryPrivate *priv = entry->priv;
+    guint wait;
+
+    if (priv->settle_timeout_id == 0)
+        priv->first_change = g_get_monotonic_time ();
+    else
+        g_source_remove (priv->settle_timeout_id);
+    priv->settle_timeout_id = 0;
+
+    wait = hildon_settle_wait (priv->first_change, priv->settle_delay,
+                               priv->settle_max_wait);
+    if (wait == 0) {
+        g_signal_emit (entry, signals[SETTLED], 0);
+        return;
+    }
+
+    priv->settle_timeout_id = gdk_threads_add_timeout (wait, hildon_entry_settle_timeout,
+                                                       entry);
+}
+
+/**
+ * hildon_entry_set_settle_delay:
+ * @entry: a #HildonEntry
+ * @delay: milliseconds of inactivity before #HildonEntry::settled is emitted
+ * @max_wait: maximum milliseconds a burst of changes can postpone the
+ * signal, or 0 for no limit
+ *
+ * Sets #HildonEntry:settle-delay and #HildonEntry:settle-max-wait. With a
+ * @delay of 0, the default, #HildonEntry::settled is emitted right after
+ * every #GtkEditable::changed.
+ *
+ * Since: 3.0
+ */
+void
+hildon_entry_set_settle_delay                   (HildonEntry *entry,
+                                                 guint        delay,
+                                                 guint        max_wait)
+{
+    HildonEntryPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_ENTRY (entry));
+
+    priv = entry->priv;
+
+    g_object_freeze_notify (G_OBJECT (entry));
+    if (priv->settle_delay != delay) {
+        priv->settle_delay = delay;
+        g_object_notify (G_OBJECT (entry), "settle-delay");
+    }
+    if (priv->settle_max_wait != max_wait) {
+        priv->settle_max_wait = max_wait;
+        g_object_notify (G_OBJECT (entry), "settle-max-wait");
+    }
+    g_object_thaw_notify (G_OBJECT (entry));
+
+    /* Don't leave a pending emission waiting for the old delay */
+    if (delay == 0)
+        hildon_entry_settle_now (entry);
+}
+
+/**
+ * hildon_entry_get_settle_delay:
+ * @entry: a #HildonEntry
+ * @max_wait: (out) (allow-none): location for the maximum wait, or %NULL
+ *
+ * Gets the values set with hildon_entry_set_settle_delay().
+ *
+ * Returns: the settle delay of @entry, in milliseconds
+ *
+ * Since: 3.0
+ */
+guint
+hildon_entry_get_settle_delay                   (HildonEntry *entry,
+                                                 guint       *max_wait)
+{
+    g_return_val_if_fail (HILDON_IS_ENTRY (entry), 0);
+
+    if (max_wait)
+        *max_wait = entry->priv->settle_max_wait;
+
+    return entry->priv->settle_delay;
+}
+
+/**
+ * hildon_entry_settle_now:
+ * @entry: a #HildonEntry
+ *
+ * Emits #HildonEntry::settled right away if changes of @entry are
+ * waiting for it, e.g. before using the text when the user presses a
+ * button. This is done by #HildonEntry itself on #GtkEntry::activate.
+ *
+ * Since: 3.0
+ */
+void
+hildon_entry_settle_now                         (HildonEntry *entry)
+{
+    g_return_if_fail (HILDON_IS_ENTRY (entry));
+
+    if (entry->priv->settle_timeout_id == 0)
+        return;
+
+    g_source_remove (entry->priv->settle_timeout_id);
+    hildon_entry_settle_timeout (entry);
+}
+
+static void
+hildon_entry_activate                           (GtkEntry *entry)
+{
+    hildon_entry_settle_now (HILDON_ENTRY (entry));
+
+    if (GTK_ENTRY_CLASS (hildon_entry_parent_class)->activate)
+        GTK_ENTRY_CLASS (hildon_entry_parent_class)->activate (entry);
+}
+
+static void
+hildon_entry_dispose                            (GObject *object)
+{
+    HildonEntryPrivate *priv = HILDON_ENTRY (object)->priv;
+
+    if (priv->settle_timeout_id) {
+        g_source_remove (priv->settle_timeout_id);
+        priv->settle_timeout_id = 0;
+    }
+
+    G_OBJECT_CLASS (hildon_entry_parent_class)->dispose (object);
+}
+
 static void
 hildon_entry_class_init                         (HildonEntryClass *klass)
 {
     GObjectClass *gobject_class = (GObjectClass *)klass;
+    GtkEntryClass *entry_class = (GtkEntryClass *)klass;
 
     gobject_class->set_property = set_property;
+    gobject_class->get_property = get_property;
+    gobject_class->dispose = hildon_entry_dispose;
+    entry_class->activate = hildon_entry_activate;
+
+    g_type_class_add_private (klass, sizeof (HildonEntryPrivate));
 
     g_object_class_install_property (
         gobject_class,
@@ -110,10 +320,66 @@ hildon_entry_class_init                         (HildonEntryClass *klass)
             HILDON_TYPE_SIZE_TYPE,
             HILDON_SIZE_AUTO_WIDTH | HILDON_SIZE_FINGER_HEIGHT,
             G_PARAM_CONSTRUCT | G_PARAM_WRITABLE));
+
+    /**
+     * HildonEntry:settle-delay:
+     *
+     * Milliseconds without changes after which #HildonEntry::settled is
+     * emitted. If 0, it is emitted after every change.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_SETTLE_DELAY,
+        g_param_spec_uint (
+            "settle-delay",
+            "Settle delay",
+            "Milliseconds without changes before the settled signal is emitted",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE));
+
+    /**
+     * HildonEntry:settle-max-wait:
+     *
+     * Maximum milliseconds that continuous changes can postpone
+     * #HildonEntry::settled, or 0 for no limit.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_SETTLE_MAX_WAIT,
+        g_param_spec_uint (
+            "settle-max-wait",
+            "Settle maximum wait",
+            "Maximum milliseconds changes can postpone the settled signal, or 0",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE));
+
+    /**
+     * HildonEntry::settled:
+     * @entry: the #HildonEntry that received the signal
+     *
+     * Emitted after the text of @entry changed and then stayed the same
+     * for #HildonEntry:settle-delay milliseconds.
+     *
+     * Since: 3.0
+     */
+    signals[SETTLED] =
+        g_signal_new ("settled",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST, 0,
+                      NULL, NULL,
+                      g_cclosure_marshal_VOID__VOID,
+                      G_TYPE_NONE, 0);
 }
 
 static void
 hildon_entry_init                               (HildonEntry *self)
 {
-    self->priv = NULL;
+    self->priv = HILDON_ENTRY_GET_PRIVATE (self);
+
+    g_signal_connect (self, "changed",
+                      G_CALLBACK (hildon_entry_changed), NULL);
 }
@@ -68,6 +68,18 @@ hildon_entry_get_type                           (void) G_GNUC_CONST;
 GtkWidget *
 hildon_entry_new                                (HildonSizeType size);
 
+void
+hildon_entry_set_settle_delay                   (HildonEntry *entry,
+                                                 guint        delay,
+                                                 guint        max_wait);
+
+guint
+hildon_entry_get_settle_delay                   (HildonEntry *entry,
+                                                 guint       *max_wait);
+
+void
+hildon_entry_settle_now                         (HildonEntry *entry);
+
 G_END_DECLS
 
 #endif /* __HILDON_ENTRY_H__ */
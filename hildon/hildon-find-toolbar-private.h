@@ -37,6 +37,28 @@ struct                                          _HildonFindToolbarPrivate
   GtkToolItem*		close_button;
 
   gint			history_limit;
+
+  /* the history list, with the number of rows and an index of its
+     strings, rebuilt when the list is changed by someone else */
+  GtkTreeModel*		history;
+  gint			history_total;
+  GHashTable*		history_index;
+  gint			history_index_column;
+  gboolean		history_updating;
+
+  /* the history file, rewritten from an idle after the searches,
+     unless it was not written by us */
+  gchar*		history_file;
+  gboolean		history_writable;
+  guint			history_save_id;
+  gint			history_save_column;
+
+  /* search as you type */
+  gint			search_delay;
+  guint			search_max_wait;
+  guint			search_timeout_id;
+  gint64		search_first_change;
+  GCancellable*		search_cancellable;
 };
 
 #define                                         HILDON_FIND_TOOLBAR_GET_PRIVATE(obj) \
@@ -46,6 +46,7 @@
 #include                                        "hildon-defines.h"
 #include                                        "hildon-find-toolbar-private.h"
 #include                                        "hildon-marshalers.h"
+#include                                        "hildon-private.h"
 
 #define                                         _(String) \
                                                 dgettext("hildon-libs", String)
@@ -58,6 +59,10 @@
 
 #define                                         FIND_LABEL_YPADDING 0
 
+/* The history file is this line followed by the searches, oldest
+   first, each one terminated by a NUL byte */
+#define                                         HISTORY_FILE_MAGIC "HILDON-FIND-HISTORY 1\n"
+
 static GtkTreeModel*
 hildon_find_toolbar_get_list_model              (HildonFindToolbarPrivate *priv);
 
@@ -73,6 +78,15 @@ static void
 hildon_find_toolbar_apply_filter                (HildonFindToolbar *self,  
                                                  GtkTreeModel *model);
 
+static void
+hildon_find_toolbar_stop_search                 (HildonFindToolbarPrivate *priv);
+
+static void
+hildon_find_toolbar_history_file_flush          (HildonFindToolbarPrivate *priv);
+
+static void
+hildon_find_toolbar_dispose                     (GObject *object);
+
 static void
 hildon_find_toolbar_get_property                (GObject *object,
                                                  guint prop_id,
@@ -115,6 +129,8 @@ enum
     CLOSE,
     INVALID_INPUT,
     HISTORY_APPEND,
+    INCREMENTAL_SEARCH,
+    SEARCH_FINISHED,
 
     LAST_SIGNAL
 };
@@ -127,7 +143,10 @@ enum
     PROP_LIST,
     PROP_COLUMN,
     PROP_MAX,
-    PROP_HISTORY_LIMIT
+    PROP_HISTORY_LIMIT,
+    PROP_SEARCH_DELAY,
+    PROP_SEARCH_MAX_WAIT,
+    PROP_HISTORY_FILE
 };
 
 static guint                                    HildonFindToolbar_signal [LAST_SIGNAL] = {0};
@@ -155,14 +174,12 @@ hildon_find_toolbar_filter                      (GtkTreeModel *model,
                                                  GtkTreeIter *iter,
                                                  gpointer self)
 {
+    HildonFindToolbarPrivate *priv = HILDON_FIND_TOOLBAR (self)->priv;
     GtkTreePath *path;
     const gint *indices;
     gint n;
-    gint limit;
-    gint total;
+    gint total = priv->history_total;
 
-    total = gtk_tree_model_iter_n_children (model, NULL);
-    g_object_get (self, "history_limit", &limit, NULL);
     path = gtk_tree_model_get_path (model, iter);
     indices = gtk_tree_path_get_indices (path);
 
@@ -172,12 +189,97 @@ hildon_find_toolbar_filter                      (GtkTreeModel *model,
 
     /*if the row is among the latest "history_limit" additions of the 
      * model, then we show it */
-    if( (total - limit <= n) && (n < total) )
+    if( (total - priv->history_limit <= n) && (n < total) )
         return TRUE;
     else
         return FALSE;
 }
 
+static void
+hildon_find_toolbar_invalidate_index            (HildonFindToolbarPrivate *priv)
+{
+    if (priv->history_index != NULL)
+    {
+        g_hash_table_destroy (priv->history_index);
+        priv->history_index = NULL;
+    }
+}
+
+static void
+hildon_find_toolbar_history_changed             (GtkTreeModel *model,
+                                                 GtkTreePath *path,
+                                                 GtkTreeIter *iter,
+                                                 HildonFindToolbarPrivate *priv)
+{
+    /* The strings were changed by someone else */
+    if (!priv->history_updating)
+        hildon_find_toolbar_invalidate_index (priv);
+}
+
+static void
+hildon_find_toolbar_history_inserted            (GtkTreeModel *model,
+                                                 GtkTreePath *path,
+                                                 GtkTreeIter *iter,
+                                                 HildonFindToolbarPrivate *priv)
+{
+    priv->history_total++;
+    hildon_find_toolbar_history_changed (model, path, iter, priv);
+}
+
+static void
+hildon_find_toolbar_history_deleted             (GtkTreeModel *model,
+                                                 GtkTreePath *path,
+                                                 HildonFindToolbarPrivate *priv)
+{
+    priv->history_total--;
+    hildon_find_toolbar_history_changed (model, path, NULL, priv);
+}
+
+static void
+hildon_find_toolbar_history_reordered           (GtkTreeModel *model,
+                                                 GtkTreePath *path,
+                                                 GtkTreeIter *iter,
+                                                 gpointer new_order,
+                                                 HildonFindToolbarPrivate *priv)
+{
+    hildon_find_toolbar_history_changed (model, path, iter, priv);
+}
+
+static void
+hildon_find_toolbar_set_history                 (HildonFindToolbarPrivate *priv,
+                                                 GtkTreeModel *model)
+{
+    if (priv->history == model)
+        return;
+
+    if (priv->history != NULL)
+    {
+        g_signal_handlers_disconnect_by_data (priv->history, priv);
+        g_object_unref (priv->history);
+    }
+
+    hildon_find_toolbar_invalidate_index (priv);
+    priv->history = model;
+    priv->history_total = 0;
+
+    if (model != NULL)
+    {
+        g_object_ref (model);
+        priv->history_total = gtk_tree_model_iter_n_children (model, NULL);
+
+        /* Connected before the filter, so that the number of rows is
+           already updated when it evaluates the new rows */
+        g_signal_connect (model, "row-inserted",
+                          G_CALLBACK (hildon_find_toolbar_history_inserted), priv);
+        g_signal_connect (model, "row-deleted",
+                          G_CALLBACK (hildon_find_toolbar_history_deleted), priv);
+        g_signal_connect (model, "row-changed",
+                          G_CALLBACK (hildon_find_toolbar_history_changed), priv);
+        g_signal_connect (model, "rows-reordered",
+                          G_CALLBACK (hildon_find_toolbar_history_reordered), priv);
+    }
+}
+
 static void
 hildon_find_toolbar_apply_filter                (HildonFindToolbar *self,  
                                                  GtkTreeModel *model)
@@ -186,6 +288,8 @@ hildon_find_toolbar_apply_filter                (HildonFindToolbar *self,
     HildonFindToolbarPrivate *priv = HILDON_FIND_TOOLBAR_GET_PRIVATE (self);
     g_assert (priv);
 
+    hildon_find_toolbar_set_history (priv, model);
+
     /* Create a filter for the given model. Its only purpose is to hide
        the oldest entries so only "history_limit" entries are visible. */
     filter = gtk_tree_model_filter_new (model, NULL);
@@ -200,6 +304,21 @@ hildon_find_toolbar_apply_filter                (HildonFindToolbar *self,
     g_object_unref (filter);
 }
 
+static void
+hildon_find_toolbar_dispose                     (GObject *object)
+{
+    HildonFindToolbarPrivate *priv = HILDON_FIND_TOOLBAR (object)->priv;
+
+    hildon_find_toolbar_stop_search (priv);
+    hildon_find_toolbar_history_file_flush (priv);
+    hildon_find_toolbar_set_history (priv, NULL);
+
+    g_free (priv->history_file);
+    priv->history_file = NULL;
+
+    G_OBJECT_CLASS (hildon_find_toolbar_parent_class)->dispose (object);
+}
+
 static void
 hildon_find_toolbar_get_property                (GObject *object,
                                                  guint prop_id,
@@ -243,6 +362,18 @@ hildon_find_toolbar_get_property                (GObject *object,
             g_value_set_int (value, priv->history_limit);
             break;
 
+        case PROP_SEARCH_DELAY:
+            g_value_set_int (value, priv->search_delay);
+            break;
+
+        case PROP_SEARCH_MAX_WAIT:
+            g_value_set_uint (value, priv->search_max_wait);
+            break;
+
+        case PROP_HISTORY_FILE:
+            g_value_set_string (value, priv->history_file);
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -310,6 +441,18 @@ hildon_find_toolbar_set_property                (GObject *object,
             }
             break;
 
+        case PROP_SEARCH_DELAY:
+            hildon_find_toolbar_set_search_delay (self, g_value_get_int (value));
+            break;
+
+        case PROP_SEARCH_MAX_WAIT:
+            hildon_find_toolbar_set_search_max_wait (self, g_value_get_uint (value));
+            break;
+
+        case PROP_HISTORY_FILE:
+            hildon_find_toolbar_set_history_file (self, g_value_get_string (value));
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -323,27 +466,253 @@ hildon_find_toolbar_find_string                 (HildonFindToolbar *self,
                                                  const gchar *string)
 {
     GtkTreeModel *model = NULL;
+    GtkTreeIter *found;
     gchar *old_string;
     HildonFindToolbarPrivate *priv = self->priv;
     g_assert (priv);
 
     model = hildon_find_toolbar_get_list_model (priv);
 
-    if (gtk_tree_model_get_iter_first (model, iter))
+    if (priv->history_index != NULL && priv->history_index_column != column)
+        hildon_find_toolbar_invalidate_index (priv);
+
+    /* The list store iters persist, so the index can keep them until
+       the list is changed by someone else */
+    if (priv->history_index == NULL)
+    {
+        priv->history_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                     g_free,
+                                                     (GDestroyNotify) gtk_tree_iter_free);
+        priv->history_index_column = column;
+
+        if (gtk_tree_model_get_iter_first (model, iter))
+        {
+            do {
+                gtk_tree_model_get (model, iter, column, &old_string, -1);
+                if (old_string != NULL)
+                    g_hash_table_insert (priv->history_index, old_string,
+                                         gtk_tree_iter_copy (iter));
+            } while (gtk_tree_model_iter_next (model, iter));
+        }
+    }
+
+    found = g_hash_table_lookup (priv->history_index, string);
+    if (found == NULL)
+        return FALSE;
+
+    /* Found it */
+    *iter = *found;
+
+    return TRUE;
+}
+
+/* Rewrites the history file with only @strings, oldest first. The new
+   file replaces the old one atomically */
+static void
+hildon_find_toolbar_history_file_write          (HildonFindToolbarPrivate *priv,
+                                                 GPtrArray *strings)
+{
+    GString *contents;
+    GError *error = NULL;
+    guint i;
+
+    contents = g_string_new (HISTORY_FILE_MAGIC);
+    for (i = 0; i < strings->len; i++)
+    {
+        const gchar *string = g_ptr_array_index (strings, i);
+        g_string_append_len (contents, string, strlen (string) + 1);
+    }
+
+    if (! g_file_set_contents (priv->history_file, contents->str,
+                               contents->len, &error))
+    {
+        g_warning ("Cannot write history file: %s", error->message);
+        g_error_free (error);
+    }
+
+    g_string_free (contents, TRUE);
+}
+
+/* Writes the last "history_limit" searches of the list to the file */
+static void
+hildon_find_toolbar_history_file_save           (HildonFindToolbarPrivate *priv)
+{
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    GPtrArray *strings;
+    gint column = priv->history_save_column;
+    gint n;
+
+    if (priv->history_save_id != 0)
+    {
+        g_source_remove (priv->history_save_id);
+        priv->history_save_id = 0;
+    }
+
+    model = hildon_find_toolbar_get_list_model (priv);
+    if (model == NULL || priv->history_file == NULL ||
+        priv->history_limit == 0)
+        return;
+
+    n = gtk_tree_model_iter_n_children (model, NULL);
+    strings = g_ptr_array_new_with_free_func (g_free);
+
+    if (gtk_tree_model_iter_nth_child (model, &iter, NULL,
+                                       MAX (n - priv->history_limit, 0)))
     {
         do {
-            gtk_tree_model_get (model, iter, column, &old_string, -1);
-            if (old_string != NULL && strcmp (string, old_string) == 0)
-            {
-                /* Found it */
-                return TRUE;
-            }
-        } while (gtk_tree_model_iter_next (model, iter));
+            gchar *old_string;
+
+            gtk_tree_model_get (model, &iter, column, &old_string, -1);
+            if (old_string != NULL)
+                g_ptr_array_add (strings, old_string);
+        } while (gtk_tree_model_iter_next (model, &iter));
     }
 
+    hildon_find_toolbar_history_file_write (priv, strings);
+    g_ptr_array_unref (strings);
+}
+
+static gboolean
+hildon_find_toolbar_history_file_save_idle      (gpointer data)
+{
+    HildonFindToolbarPrivate *priv = data;
+
+    priv->history_save_id = 0;
+    hildon_find_toolbar_history_file_save (priv);
+
     return FALSE;
 }
 
+/* Saves the history once the current burst of searches is over, so
+   that searching never waits for the disk. A limit of 0 hides the
+   history, it must not wipe the file */
+static void
+hildon_find_toolbar_history_file_queue_save     (HildonFindToolbarPrivate *priv,
+                                                 gint column)
+{
+    if (! priv->history_writable || priv->history_limit == 0)
+        return;
+
+    priv->history_save_column = column;
+    if (priv->history_save_id == 0)
+        priv->history_save_id =
+            gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                       hildon_find_toolbar_history_file_save_idle,
+                                       priv, NULL);
+}
+
+/* Writes the pending changes of the history, if any, right away */
+static void
+hildon_find_toolbar_history_file_flush          (HildonFindToolbarPrivate *priv)
+{
+    if (priv->history_save_id != 0)
+        hildon_find_toolbar_history_file_save (priv);
+}
+
+/* Maps the history file and builds the history list from its newest
+   records, skipping the duplicates. The strings are copied only once,
+   into the list; the file is rewritten if records had to be dropped.
+   Only the last "history_limit" searches are ever saved, so the file
+   stays small */
+static void
+hildon_find_toolbar_history_file_load           (HildonFindToolbar *self)
+{
+    HildonFindToolbarPrivate *priv = self->priv;
+    GMappedFile *mapped;
+    GError *error = NULL;
+    const gchar *contents, *end, *p;
+    GPtrArray *records, *kept;
+    GHashTable *seen;
+    gboolean truncated = FALSE;
+    gsize magic_len = strlen (HISTORY_FILE_MAGIC);
+    gint i;
+
+    priv->history_writable = FALSE;
+
+    mapped = g_mapped_file_new (priv->history_file, FALSE, &error);
+    if (mapped == NULL)
+    {
+        if (! g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            g_warning ("Cannot read history file: %s", error->message);
+        else
+            priv->history_writable = TRUE;
+        g_error_free (error);
+        return;
+    }
+
+    contents = g_mapped_file_get_contents (mapped);
+    end = contents + g_mapped_file_get_length (mapped);
+
+    if (end == contents)
+    {
+        priv->history_writable = TRUE;
+        g_mapped_file_unref (mapped);
+        return;
+    }
+
+    if ((gsize) (end - contents) < magic_len ||
+        memcmp (contents, HISTORY_FILE_MAGIC, magic_len) != 0)
+    {
+        /* Leave a file that is not ours alone */
+        g_warning ("%s is not a history file", priv->history_file);
+        g_mapped_file_unref (mapped);
+        return;
+    }
+
+    records = g_ptr_array_new ();
+    for (p = contents + magic_len; p < end; )
+    {
+        const gchar *nul = memchr (p, '\0', end - p);
+
+        if (nul == NULL)
+        {
+            /* Interrupted while appending the last search */
+            truncated = TRUE;
+            break;
+        }
+
+        if (*p != '\0')
+            g_ptr_array_add (records, (gpointer) p);
+        p = nul + 1;
+    }
+
+    /* Newest first, as the searches are appended to the file */
+    seen = g_hash_table_new (g_str_hash, g_str_equal);
+    kept = g_ptr_array_new ();
+    for (i = (gint) records->len - 1;
+         i >= 0 && (gint) kept->len < priv->history_limit; i--)
+    {
+        gpointer record = g_ptr_array_index (records, i);
+
+        if (g_hash_table_add (seen, record))
+            g_ptr_array_add (kept, record);
+    }
+
+    if (kept->len > 0)
+    {
+        GtkListStore *list = gtk_list_store_new (1, G_TYPE_STRING);
+
+        for (i = (gint) kept->len - 1; i >= 0; i--)
+            gtk_list_store_insert_with_values (list, NULL, -1,
+                                               0, g_ptr_array_index (kept, i), -1);
+
+        hildon_find_toolbar_apply_filter (self, GTK_TREE_MODEL (list));
+        g_object_unref (list);
+        g_object_set (self, "column", 0, NULL);
+    }
+
+    /* Nothing is shown with a limit of 0, so the records are kept */
+    priv->history_writable = TRUE;
+    if (truncated || kept->len < records->len)
+        hildon_find_toolbar_history_file_queue_save (priv, 0);
+
+    g_hash_table_destroy (seen);
+    g_ptr_array_unref (kept);
+    g_ptr_array_unref (records);
+    g_mapped_file_unref (mapped);
+}
+
 static gboolean
 hildon_find_toolbar_history_append              (HildonFindToolbar *self,
                                                  gpointer data) 
@@ -385,8 +754,12 @@ hildon_find_toolbar_history_append              (HildonFindToolbar *self,
 
         /* Latest string is always the first one in list. If the string
            already exists, remove it so there are no duplicates in list. */
+        priv->history_updating = TRUE;
         if (hildon_find_toolbar_find_string (self, &iter, column, string))
+        {
+            g_hash_table_remove (priv->history_index, string);
             gtk_list_store_remove (list, &iter);
+        }
     }
     else
     {
@@ -399,6 +772,10 @@ hildon_find_toolbar_history_append              (HildonFindToolbar *self,
     /* Add the string to first in list */
     gtk_list_store_append (list, &iter);
     gtk_list_store_set (list, &iter, column, string, -1);
+    if (priv->history_index != NULL)
+        g_hash_table_insert (priv->history_index, g_strdup (string),
+                             gtk_tree_iter_copy (&iter));
+    priv->history_updating = FALSE;
 
     if(self_create)
     {
@@ -418,6 +795,8 @@ hildon_find_toolbar_history_append              (HildonFindToolbar *self,
                     gtk_combo_box_get_model (GTK_COMBO_BOX(priv->entry_combo_box))));
     }
 
+    hildon_find_toolbar_history_file_queue_save (priv, column);
+
     g_free (string);
 
     return FALSE;
@@ -431,6 +810,79 @@ hildon_find_toolbar_emit_close                  (GtkButton *button,
     g_signal_emit (self, HildonFindToolbar_signal [CLOSE], 0);
 }
 
+/* Cancels the running incremental search, if any */
+static void
+hildon_find_toolbar_cancel_search               (HildonFindToolbarPrivate *priv)
+{
+    if (priv->search_cancellable != NULL)
+    {
+        g_cancellable_cancel (priv->search_cancellable);
+        g_object_unref (priv->search_cancellable);
+        priv->search_cancellable = NULL;
+        gtk_entry_set_progress_fraction (hildon_find_toolbar_get_entry (priv), 0.0);
+    }
+}
+
+static void
+hildon_find_toolbar_stop_search                 (HildonFindToolbarPrivate *priv)
+{
+    if (priv->search_timeout_id)
+    {
+        g_source_remove (priv->search_timeout_id);
+        priv->search_timeout_id = 0;
+    }
+
+    hildon_find_toolbar_cancel_search (priv);
+}
+
+static gboolean
+hildon_find_toolbar_search_timeout              (gpointer data)
+{
+    HildonFindToolbar *self = HILDON_FIND_TOOLBAR (data);
+    HildonFindToolbarPrivate *priv = self->priv;
+    GCancellable *cancellable;
+
+    priv->search_timeout_id = 0;
+
+    priv->search_cancellable = g_cancellable_new ();
+
+    /* The handler may finish the search, and so drop the cancellable,
+       before returning */
+    cancellable = g_object_ref (priv->search_cancellable);
+    g_signal_emit (self, HildonFindToolbar_signal [INCREMENTAL_SEARCH], 0, cancellable);
+    g_object_unref (cancellable);
+
+    return FALSE;
+}
+
+static void
+hildon_find_toolbar_entry_changed               (GtkEditable *editable,
+                                                 HildonFindToolbar *self)
+{
+    HildonFindToolbarPrivate *priv = self->priv;
+    guint wait;
+
+    if (priv->search_delay < 0)
+        return;
+
+    if (priv->search_timeout_id == 0)
+        priv->search_first_change = g_get_monotonic_time ();
+
+    /* A newer prefix makes the running search useless */
+    hildon_find_toolbar_stop_search (priv);
+
+    wait = hildon_settle_wait (priv->search_first_change, priv->search_delay,
+                               priv->search_max_wait);
+    if (wait == 0 && priv->search_delay > 0) {
+        /* Typing for longer than the maximum wait, search now */
+        hildon_find_toolbar_search_timeout (self);
+        return;
+    }
+
+    priv->search_timeout_id =
+        gdk_threads_add_timeout (wait, hildon_find_toolbar_search_timeout, self);
+}
+
 static void
 hildon_find_toolbar_entry_activate              (GtkWidget *widget,
                                                  gpointer user_data)
@@ -441,6 +893,9 @@ hildon_find_toolbar_entry_activate              (GtkWidget *widget,
     /* NB#40936 stop focus from moving to next widget */
     g_signal_stop_emission_by_name (widget, "activate");
 
+    /* The full search replaces the incremental one */
+    hildon_find_toolbar_stop_search (HILDON_FIND_TOOLBAR (find_toolbar)->priv);
+
     g_signal_emit (find_toolbar, HildonFindToolbar_signal [SEARCH], 0);
     g_signal_emit (find_toolbar, HildonFindToolbar_signal [HISTORY_APPEND], 0, &rb);
 }
@@ -450,6 +905,7 @@ hildon_find_toolbar_class_init                  (HildonFindToolbarClass *klass)
 {
     GObjectClass *object_class = (GObjectClass *) klass;
 
+    object_class->dispose = hildon_find_toolbar_dispose;
     object_class->get_property = hildon_find_toolbar_get_property;
     object_class->set_property = hildon_find_toolbar_set_property;
 
@@ -537,6 +993,57 @@ hildon_find_toolbar_class_init                  (HildonFindToolbarClass *klass)
                 5, G_PARAM_READWRITE |
                 G_PARAM_CONSTRUCT));
 
+    /**
+     * HildonFindToolbar:search-delay:
+     *
+     * Time in milliseconds after the last change of the search prefix
+     * before #HildonFindToolbar::incremental-search is emitted, or -1
+     * to search only when the user activates the entry.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_SEARCH_DELAY,
+            g_param_spec_int ("search-delay",
+                "Search delay",
+                "Milliseconds after typing before searching, "
+                "or -1 to search only on activation",
+                -1, G_MAXINT,
+                -1, G_PARAM_READWRITE |
+                G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonFindToolbar:search-max-wait:
+     *
+     * Maximum time in milliseconds that continuous typing can postpone
+     * #HildonFindToolbar::incremental-search, or 0 for no limit. Only
+     * used if #HildonFindToolbar:search-delay is not -1.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_SEARCH_MAX_WAIT,
+            g_param_spec_uint ("search-max-wait",
+                "Search maximum wait",
+                "Maximum milliseconds typing can postpone a search, "
+                "or 0 for no limit",
+                0, G_MAXUINT,
+                0, G_PARAM_READWRITE |
+                G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonFindToolbar:history-file:
+     *
+     * Name of the file keeping the search history across sessions, or
+     * %NULL. See hildon_find_toolbar_set_history_file().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_HISTORY_FILE,
+            g_param_spec_string ("history-file",
+                "History file",
+                "File keeping the search history across sessions",
+                NULL, G_PARAM_READWRITE |
+                G_PARAM_STATIC_STRINGS));
+
     /**
      * HildonFindToolbar::search:
      * @toolbar: the toolbar which received the signal
@@ -594,6 +1101,46 @@ hildon_find_toolbar_class_init                  (HildonFindToolbarClass *klass)
                 g_signal_accumulator_true_handled, NULL, 
                 _hildon_marshal_BOOLEAN__VOID,
                 G_TYPE_BOOLEAN, 0);
+
+    /**
+     * HildonFindToolbar::incremental-search:
+     * @toolbar: the toolbar which received the signal
+     * @cancellable: a #GCancellable, cancelled when the search is not
+     * needed anymore
+     *
+     * Gets emitted when the search prefix has not changed for
+     * #HildonFindToolbar:search-delay milliseconds. The handler can
+     * search right away, or keep a reference to @cancellable and search
+     * in chunks from idle callbacks, stopping as soon as @cancellable is
+     * cancelled, which happens when the prefix changes again or the
+     * entry is activated. In both cases, it must call
+     * hildon_find_toolbar_search_finished() when done.
+     *
+     * Since: 3.0
+     */
+    HildonFindToolbar_signal[INCREMENTAL_SEARCH] =
+        g_signal_new(
+                "incremental-search", HILDON_TYPE_FIND_TOOLBAR,
+                G_SIGNAL_RUN_LAST, 0,
+                NULL, NULL, _hildon_marshal_VOID__OBJECT,
+                G_TYPE_NONE, 1, G_TYPE_CANCELLABLE);
+
+    /**
+     * HildonFindToolbar::search-finished:
+     * @toolbar: the toolbar which received the signal
+     * @cancellable: the #GCancellable of the finished search
+     *
+     * Gets emitted when the current incremental search is reported
+     * finished with hildon_find_toolbar_search_finished().
+     *
+     * Since: 3.0
+     */
+    HildonFindToolbar_signal[SEARCH_FINISHED] =
+        g_signal_new(
+                "search-finished", HILDON_TYPE_FIND_TOOLBAR,
+                G_SIGNAL_RUN_LAST, 0,
+                NULL, NULL, _hildon_marshal_VOID__OBJECT,
+                G_TYPE_NONE, 1, G_TYPE_CANCELLABLE);
 }
 
 static void
@@ -639,6 +1186,13 @@ hildon_find_toolbar_init                        (HildonFindToolbar *self)
     g_signal_connect (hildon_find_toolbar_get_entry (priv),
             "activate",
             G_CALLBACK(hildon_find_toolbar_entry_activate), self);
+    g_signal_connect (hildon_find_toolbar_get_entry (priv),
+            "changed",
+            G_CALLBACK(hildon_find_toolbar_entry_changed), self);
+    priv->search_delay = -1;
+    priv->history_writable = FALSE;
+    priv->history_save_id = 0;
+    priv->history_save_column = 0;
 
     /* Separator */
     priv->separator = gtk_separator_tool_item_new();
@@ -854,14 +1408,227 @@ hildon_find_toolbar_get_last_index              (HildonFindToolbar *toolbar)
     if (filter_model == NULL)
         return 0;
 
-    gint i = 0;
-    GtkTreeIter iter;
+    /* The filter shows the last "history_limit" rows of the list */
+    gint visible = MIN (priv->history_total, priv->history_limit);
+
+    return visible > 0 ? visible - 1 : 0;
+}
+
+/**
+ * hildon_find_toolbar_set_search_delay:
+ * @toolbar: A #HildonFindToolbar
+ * @delay: milliseconds to wait after the last change of the search
+ *         prefix before searching, or -1 to search only on activation
+ *
+ * Sets the #HildonFindToolbar:search-delay property, making
+ * @toolbar emit #HildonFindToolbar::incremental-search while the user
+ * types. A pending search is cancelled.
+ *
+ * Since: 3.0
+ */
+void
+hildon_find_toolbar_set_search_delay            (HildonFindToolbar *toolbar,
+                                                 gint delay)
+{
+    HildonFindToolbarPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar));
+    g_return_if_fail (delay >= -1);
+    priv = toolbar->priv;
+
+    if (priv->search_delay == delay)
+        return;
+
+    priv->search_delay = delay;
+    hildon_find_toolbar_stop_search (priv);
+
+    g_object_notify (G_OBJECT (toolbar), "search-delay");
+}
+
+/**
+ * hildon_find_toolbar_get_search_delay:
+ * @toolbar: A #HildonFindToolbar
+ *
+ * Gets the #HildonFindToolbar:search-delay property.
+ *
+ * Returns: the delay in milliseconds, or -1 if @toolbar only searches
+ * on activation
+ *
+ * Since: 3.0
+ */
+gint
+hildon_find_toolbar_get_search_delay            (HildonFindToolbar *toolbar)
+{
+    g_return_val_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar), -1);
 
-    gtk_tree_model_get_iter_first (filter_model, &iter);
+    return toolbar->priv->search_delay;
+}
 
-    while (gtk_tree_model_iter_next (filter_model, &iter))
-        i++;
+/**
+ * hildon_find_toolbar_set_search_max_wait:
+ * @toolbar: A #HildonFindToolbar
+ * @max_wait: maximum milliseconds that continuous typing can postpone
+ *            a search, or 0 for no limit
+ *
+ * Sets the #HildonFindToolbar:search-max-wait property. With a
+ * #HildonFindToolbar:search-delay, a search starts only once typing
+ * pauses; this makes one start anyway, at most every @max_wait
+ * milliseconds, while the user keeps typing.
+ *
+ * Since: 3.0
+ */
+void
+hildon_find_toolbar_set_search_max_wait         (HildonFindToolbar *toolbar,
+                                                 guint max_wait)
+{
+    HildonFindToolbarPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar));
+    priv = toolbar->priv;
+
+    if (priv->search_max_wait == max_wait)
+        return;
 
-    return i;
+    priv->search_max_wait = max_wait;
+
+    g_object_notify (G_OBJECT (toolbar), "search-max-wait");
 }
 
+/**
+ * hildon_find_toolbar_get_search_max_wait:
+ * @toolbar: A #HildonFindToolbar
+ *
+ * Gets the #HildonFindToolbar:search-max-wait property.
+ *
+ * Returns: the maximum wait in milliseconds, or 0 if there is no limit
+ *
+ * Since: 3.0
+ */
+guint
+hildon_find_toolbar_get_search_max_wait         (HildonFindToolbar *toolbar)
+{
+    g_return_val_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar), 0);
+
+    return toolbar->priv->search_max_wait;
+}
+
+/**
+ * hildon_find_toolbar_set_history_file:
+ * @toolbar: A #HildonFindToolbar
+ * @filename: the file to keep the search history in, or %NULL
+ *
+ * Makes @toolbar keep its search history in @filename, so that it
+ * survives the application. If the file holds any searches, the most
+ * recent #HildonFindToolbar:history-limit of them, without duplicates,
+ * replace the history list of @toolbar. After a burst of searches, the
+ * file is atomically replaced from an idle with the searches that are
+ * shown. With a #HildonFindToolbar:history-limit of 0 the file is not
+ * written to.
+ *
+ * An existing file that was not written by #HildonFindToolbar is left
+ * untouched, and the history is then not saved.
+ *
+ * Since: 3.0
+ */
+void
+hildon_find_toolbar_set_history_file            (HildonFindToolbar *toolbar,
+                                                 const gchar *filename)
+{
+    HildonFindToolbarPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar));
+    priv = toolbar->priv;
+
+    if (g_strcmp0 (priv->history_file, filename) == 0)
+        return;
+
+    hildon_find_toolbar_history_file_flush (priv);
+    priv->history_writable = FALSE;
+
+    g_free (priv->history_file);
+    priv->history_file = g_strdup (filename);
+
+    if (filename != NULL)
+        hildon_find_toolbar_history_file_load (toolbar);
+
+    g_object_notify (G_OBJECT (toolbar), "history-file");
+}
+
+/**
+ * hildon_find_toolbar_get_history_file:
+ * @toolbar: A #HildonFindToolbar
+ *
+ * Gets the #HildonFindToolbar:history-file property.
+ *
+ * Returns: the name of the history file, or %NULL
+ *
+ * Since: 3.0
+ */
+const gchar *
+hildon_find_toolbar_get_history_file            (HildonFindToolbar *toolbar)
+{
+    g_return_val_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar), NULL);
+
+    return toolbar->priv->history_file;
+}
+
+/**
+ * hildon_find_toolbar_set_search_progress:
+ * @toolbar: A #HildonFindToolbar
+ * @fraction: the fraction of the incremental search done, between 0.0
+ *            and 1.0
+ *
+ * Shows the progress of a long incremental search in the entry of
+ * @toolbar. The progress is cleared when the search finishes or is
+ * cancelled.
+ *
+ * Since: 3.0
+ */
+void
+hildon_find_toolbar_set_search_progress         (HildonFindToolbar *toolbar,
+                                                 gdouble fraction)
+{
+    HildonFindToolbarPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar));
+    priv = toolbar->priv;
+
+    if (priv->search_cancellable == NULL)
+        return;
+
+    gtk_entry_set_progress_fraction (hildon_find_toolbar_get_entry (priv),
+                                     CLAMP (fraction, 0.0, 1.0));
+}
+
+/**
+ * hildon_find_toolbar_search_finished:
+ * @toolbar: A #HildonFindToolbar
+ * @cancellable: the #GCancellable given to the
+ *               #HildonFindToolbar::incremental-search handler
+ *
+ * Tells @toolbar that the incremental search of @cancellable is done.
+ * If it is still the current search, the progress is cleared and
+ * #HildonFindToolbar::search-finished is emitted. Searches that were
+ * replaced by a newer one are ignored.
+ *
+ * Since: 3.0
+ */
+void
+hildon_find_toolbar_search_finished             (HildonFindToolbar *toolbar,
+                                                 GCancellable *cancellable)
+{
+    HildonFindToolbarPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_FIND_TOOLBAR (toolbar));
+    g_return_if_fail (G_IS_CANCELLABLE (cancellable));
+    priv = toolbar->priv;
+
+    if (cancellable != priv->search_cancellable)
+        return;
+
+    priv->search_cancellable = NULL;
+    gtk_entry_set_progress_fraction (hildon_find_toolbar_get_entry (priv), 0.0);
+
+    g_signal_emit (toolbar, HildonFindToolbar_signal [SEARCH_FINISHED], 0, cancellable);
+    g_object_unref (cancellable);
+}
@@ -107,6 +107,35 @@ hildon_find_toolbar_get_active_iter             (HildonFindToolbar *toolbar,
 gint32
 hildon_find_toolbar_get_last_index              (HildonFindToolbar *toolbar);
 
+void
+hildon_find_toolbar_set_search_delay            (HildonFindToolbar *toolbar,
+                                                 gint delay);
+
+gint
+hildon_find_toolbar_get_search_delay            (HildonFindToolbar *toolbar);
+
+void
+hildon_find_toolbar_set_search_max_wait         (HildonFindToolbar *toolbar,
+                                                 guint max_wait);
+
+guint
+hildon_find_toolbar_get_search_max_wait         (HildonFindToolbar *toolbar);
+
+void
+hildon_find_toolbar_set_history_file            (HildonFindToolbar *toolbar,
+                                                 const gchar *filename);
+
+const gchar *
+hildon_find_toolbar_get_history_file            (HildonFindToolbar *toolbar);
+
+void
+hildon_find_toolbar_set_search_progress         (HildonFindToolbar *toolbar,
+                                                 gdouble fraction);
+
+void
+hildon_find_toolbar_search_finished             (HildonFindToolbar *toolbar,
+                                                 GCancellable *cancellable);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_FIND_TOOLBAR_H__ */
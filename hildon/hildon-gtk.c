@@ -266,6 +266,110 @@ do_set_portrait_flags                           (GtkWindow *window,
                                           0, 0, NULL, do_set_portrait_flags, NULL);
 }
 
+typedef struct
+{
+    GtkWindow *window;
+    guint      requested;
+    guint      shown;
+    gint64     shown_since;
+    guint      show_delay;
+    guint      min_on_time;
+    guint      timeout_id;
+} ProgressIndicator;
+
+static GQuark
+progress_indicator_quark                        (void)
+{
+    static GQuark quark = 0;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-progress-indicator");
+
+    return quark;
+}
+
+static void
+progress_indicator_free                         (gpointer data)
+{
+    ProgressIndicator *pi = data;
+
+    if (pi->timeout_id)
+        g_source_remove (pi->timeout_id);
+    g_slice_free (ProgressIndicator, pi);
+}
+
+static ProgressIndicator *
+progress_indicator_get                          (GtkWindow *window)
+{
+    ProgressIndicator *pi = g_object_get_qdata (G_OBJECT (window), progress_indicator_quark ());
+
+    if (G_UNLIKELY (pi == NULL)) {
+        pi = g_slice_new0 (ProgressIndicator);
+        pi->window = window;
+        g_object_set_qdata_full (G_OBJECT (window), progress_indicator_quark (),
+                                 pi, progress_indicator_free);
+    }
+
+    return pi;
+}
+
+static void
+progress_indicator_apply                        (ProgressIndicator *pi)
+{
+    GtkWindow *window = pi->window;
+
+    pi->shown = pi->requested;
+    pi->shown_since = g_get_monotonic_time ();
+
+    hildon_gtk_window_set_flag (window, (HildonFlagFunc) do_set_progress_indicator, GUINT_TO_POINTER (pi->shown));
+    if (HILDON_IS_WINDOW (window)) {
+        HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
+        if (priv->edit_toolbar) {
+            HildonEditToolbar *tb = HILDON_EDIT_TOOLBAR (priv->edit_toolbar);
+            hildon_edit_toolbar_set_progress_indicator (tb, pi->shown);
+        }
+    }
+}
+
+static gboolean
+progress_indicator_timeout                      (gpointer data)
+{
+    ProgressIndicator *pi = data;
+
+    pi->timeout_id = 0;
+    if (pi->requested != pi->shown)
+        progress_indicator_apply (pi);
+
+    return FALSE;
+}
+
+/* Shows the indicator only once it has been requested for
+ * show_delay, and keeps it up for at least min_on_time, so that
+ * flickering requests don't reach the window manager */
+static void
+progress_indicator_update                       (ProgressIndicator *pi)
+{
+    gint64 wait;
+
+    if (pi->timeout_id) {
+        g_source_remove (pi->timeout_id);
+        pi->timeout_id = 0;
+    }
+
+    if (pi->requested == pi->shown)
+        return;
+
+    if (pi->requested)
+        wait = pi->show_delay;
+    else
+        wait = pi->min_on_time - (g_get_monotonic_time () - pi->shown_since) / 1000;
+
+    if (wait <= 0)
+        progress_indicator_apply (pi);
+    else
+        pi->timeout_id = gdk_threads_add_timeout (wait, progress_indicator_timeout, pi);
+}
+
 /**
  * hildon_gtk_window_set_progress_indicator:
  * @window: a #GtkWindow.
@@ -276,20 +380,121 @@ do_set_portrait_flags                           (GtkWindow *window,
  * indicator in the window title. It applies to #HildonDialog and
  * #HildonWindow (including subclasses).
  *
+ * Requests that flicker can be filtered out with
+ * hildon_gtk_window_set_progress_indicator_hysteresis().
+ *
  * Since: 2.2
  **/
 void
 hildon_gtk_window_set_progress_indicator        (GtkWindow *window,
                                                  guint      state)
 {
-    hildon_gtk_window_set_flag (window, (HildonFlagFunc) do_set_progress_indicator, GUINT_TO_POINTER (state));
-    if (HILDON_IS_WINDOW (window)) {
-        HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
-        if (priv->edit_toolbar) {
-            HildonEditToolbar *tb = HILDON_EDIT_TOOLBAR (priv->edit_toolbar);
-            hildon_edit_toolbar_set_progress_indicator (tb, state);
-        }
-    }
+    ProgressIndicator *pi;
+
+    g_return_if_fail (GTK_IS_WINDOW (window));
+
+    /* Progress is often reported for every chunk of work, so only
+     * tell the window manager when the state actually changes */
+    pi = progress_indicator_get (window);
+    pi->requested = state;
+    progress_indicator_update (pi);
+}
+
+/**
+ * hildon_gtk_window_set_progress_indicator_hysteresis:
+ * @window: a #GtkWindow.
+ * @show_delay: time in milliseconds the indicator must be requested
+ *              before it is shown
+ * @min_on_time: minimum time in milliseconds the indicator stays
+ *               shown
+ *
+ * Sets how the progress indicator of @window filters out short
+ * changes. Bursty activity, such as network traffic, often toggles
+ * the indicator many times per second; each change that reaches the
+ * window manager makes it redraw the title bar. Activity shorter than
+ * @show_delay never shows the indicator, and once shown it is not
+ * hidden before @min_on_time has passed.
+ *
+ * Both default to 0, which applies every change immediately. Values
+ * such as 250 and 500 milliseconds hide most bursts.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_gtk_window_set_progress_indicator_hysteresis (GtkWindow *window,
+                                                     guint      show_delay,
+                                                     guint      min_on_time)
+{
+    ProgressIndicator *pi;
+
+    g_return_if_fail (GTK_IS_WINDOW (window));
+
+    pi = progress_indicator_get (window);
+    pi->show_delay = show_delay;
+    pi->min_on_time = min_on_time;
+    progress_indicator_update (pi);
+}
+
+G_LOCK_DEFINE_STATIC (pending_progress);
+static GHashTable *pending_progress = NULL;
+static guint pending_progress_id = 0;
+
+static gboolean
+apply_pending_progress                          (gpointer data)
+{
+    GHashTable *pending;
+    GHashTableIter iter;
+    gpointer window, state;
+
+    G_LOCK (pending_progress);
+    pending = pending_progress;
+    pending_progress = NULL;
+    pending_progress_id = 0;
+    G_UNLOCK (pending_progress);
+
+    g_hash_table_iter_init (&iter, pending);
+    while (g_hash_table_iter_next (&iter, &window, &state))
+        hildon_gtk_window_set_progress_indicator (window, GPOINTER_TO_UINT (state));
+
+    /* Drops the references taken in hildon_gtk_window_post_progress_indicator() */
+    g_hash_table_destroy (pending);
+
+    return FALSE;
+}
+
+/**
+ * hildon_gtk_window_post_progress_indicator:
+ * @window: a #GtkWindow.
+ * @state: The state we want to set: 1 -> show progress indicator, 0
+ *          -> hide progress indicator.
+ *
+ * Like hildon_gtk_window_set_progress_indicator(), but can be called
+ * from any thread. The state is applied from the main loop; all the
+ * states posted before that happens are coalesced, and only the last
+ * one posted for each window is applied.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_gtk_window_post_progress_indicator       (GtkWindow *window,
+                                                 guint      state)
+{
+    g_return_if_fail (GTK_IS_WINDOW (window));
+
+    G_LOCK (pending_progress);
+
+    if (pending_progress == NULL)
+        pending_progress = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+
+    /* If @window is already pending, the table keeps its key and unrefs
+       the one passed in, so this reference is always taken */
+    g_hash_table_insert (pending_progress, g_object_ref (window),
+                         GUINT_TO_POINTER (state));
+
+    if (pending_progress_id == 0)
+        pending_progress_id = gdk_threads_add_idle (apply_pending_progress, NULL);
+
+    G_UNLOCK (pending_progress);
 }
 
 /**
@@ -346,6 +551,34 @@ hildon_gtk_window_enable_zoom_keys              (GtkWindow *window,
     hildon_gtk_window_set_flag (window, (HildonFlagFunc) do_set_zoom_keys, GUINT_TO_POINTER (enable));
 }
 
+static void
+send_screenshot_request                         (GtkWindow *window,
+                                                 gboolean   take)
+{
+    XEvent xev = { 0 };
+
+    xev.xclient.type = ClientMessage;
+    xev.xclient.serial = 0;
+    xev.xclient.send_event = True;
+    xev.xclient.display = GDK_DISPLAY_XDISPLAY (gtk_widget_get_display (GTK_WIDGET (window)));
+    xev.xclient.window = XDefaultRootWindow (xev.xclient.display);
+    xev.xclient.message_type = hildon_get_xatom (gtk_widget_get_display (GTK_WIDGET (window)),
+                                                 HILDON_ATOM_HILDON_LOADING_SCREENSHOT);
+    xev.xclient.format = 32;
+    xev.xclient.data.l[0] = take ? 0 : 1;
+    xev.xclient.data.l[1] = GDK_WINDOW_XID (gtk_widget_get_window (GTK_WIDGET (window)));
+
+    XSendEvent (xev.xclient.display,
+                xev.xclient.window,
+                False,
+                SubstructureRedirectMask | SubstructureNotifyMask,
+                &xev);
+
+    /* Flushing is enough for the request to reach the server even if
+     * the application exits right after; no need for a round-trip. */
+    XFlush (xev.xclient.display);
+}
+
 /**
  * hildon_gtk_window_take_screenshot:
  * @window: a #GtkWindow
@@ -373,29 +606,10 @@ void
 hildon_gtk_window_take_screenshot               (GtkWindow *window,
                                                  gboolean   take)
 {
-    XEvent xev = { 0 };
-
     g_return_if_fail (GTK_IS_WINDOW (window));
     g_return_if_fail (gtk_widget_get_mapped (GTK_WIDGET (window)));
 
-    xev.xclient.type = ClientMessage;
-    xev.xclient.serial = 0;
-    xev.xclient.send_event = True;
-    xev.xclient.display = GDK_DISPLAY_XDISPLAY (gtk_widget_get_display (GTK_WIDGET (window)));
-    xev.xclient.window = XDefaultRootWindow (xev.xclient.display);
-    xev.xclient.message_type = XInternAtom (xev.xclient.display, "_HILDON_LOADING_SCREENSHOT", False);
-    xev.xclient.format = 32;
-    xev.xclient.data.l[0] = take ? 0 : 1;
-    xev.xclient.data.l[1] = GDK_WINDOW_XID (gtk_widget_get_window (GTK_WIDGET (window)));
-
-    XSendEvent (xev.xclient.display,
-                xev.xclient.window,
-                False,
-                SubstructureRedirectMask | SubstructureNotifyMask,
-                &xev);
-
-    XFlush (xev.xclient.display);
-    XSync (xev.xclient.display, False);
+    send_screenshot_request (window, take);
 }
 
 /* XIfEvent() predicate to check for a reply to a
@@ -404,9 +618,8 @@ static Bool
 screenshot_done (Display *dpy, const XEvent *event, GtkWindow *window)
 {
   return event->type == ClientMessage
-    && event->xclient.message_type == XInternAtom (dpy,
-                                           "_HILDON_LOADING_SCREENSHOT",
-                                           False)
+    && event->xclient.message_type == hildon_get_xatom (gtk_widget_get_display (GTK_WIDGET (window)),
+                                                        HILDON_ATOM_HILDON_LOADING_SCREENSHOT)
     && event->xclient.window == GDK_WINDOW_XID (gtk_widget_get_window (GTK_WIDGET (window)));
 }
 
@@ -427,11 +640,185 @@ hildon_gtk_window_take_screenshot_sync          (GtkWindow *window,
 {
   XEvent foo;
 
-  hildon_gtk_window_take_screenshot (window, take);
+  g_return_if_fail (GTK_IS_WINDOW (window));
+  g_return_if_fail (gtk_widget_get_mapped (GTK_WIDGET (window)));
+
+  send_screenshot_request (window, take);
   XIfEvent (GDK_DISPLAY_XDISPLAY (gtk_widget_get_display (GTK_WIDGET (window))),
             &foo, (void *)screenshot_done, (XPointer)window);
 }
 
+typedef struct
+{
+    GtkWindow *window;
+    GdkWindow *gdk_window;
+    gulong     unrealize_id;
+    gulong     cancelled_id;
+    gboolean   completed;
+} ScreenshotRequest;
+
+static void
+screenshot_request_free                         (ScreenshotRequest *request)
+{
+    g_slice_free (ScreenshotRequest, request);
+}
+
+static GdkFilterReturn
+screenshot_filter                               (GdkXEvent *xevent,
+                                                 GdkEvent  *event,
+                                                 gpointer   data);
+
+static void
+screenshot_complete                             (GTask  *task,
+                                                 GError *error)
+{
+    ScreenshotRequest *request = g_task_get_task_data (task);
+    GCancellable *cancellable = g_task_get_cancellable (task);
+
+    request->completed = TRUE;
+
+    gdk_window_remove_filter (request->gdk_window, screenshot_filter, task);
+    g_signal_handler_disconnect (request->window, request->unrealize_id);
+    g_cancellable_disconnect (cancellable, request->cancelled_id);
+
+    if (error)
+        g_task_return_error (task, error);
+    else
+        g_task_return_boolean (task, TRUE);
+
+    g_object_unref (task);
+}
+
+static GdkFilterReturn
+screenshot_filter                               (GdkXEvent *xevent,
+                                                 GdkEvent  *event,
+                                                 gpointer   data)
+{
+    GTask *task = data;
+    ScreenshotRequest *request = g_task_get_task_data (task);
+
+    if (screenshot_done (GDK_WINDOW_XDISPLAY (request->gdk_window), xevent,
+                         request->window))
+    {
+        screenshot_complete (task, NULL);
+        return GDK_FILTER_REMOVE;
+    }
+
+    return GDK_FILTER_CONTINUE;
+}
+
+static void
+screenshot_unrealized                           (GtkWidget *widget,
+                                                 GTask     *task)
+{
+    screenshot_complete (task, g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CLOSED,
+                                                    "The window was unrealized"));
+}
+
+static gboolean
+screenshot_cancelled_idle                       (gpointer data)
+{
+    GTask *task = data;
+    ScreenshotRequest *request = g_task_get_task_data (task);
+
+    /* The reply may have arrived in the meantime */
+    if (!request->completed)
+        screenshot_complete (task, g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                        "Operation was cancelled"));
+
+    return FALSE;
+}
+
+/* Can run in any thread, and the handler cannot disconnect itself, so
+ * the request is completed from the main loop */
+static void
+screenshot_cancelled                            (GCancellable *cancellable,
+                                                 GTask        *task)
+{
+    gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE, screenshot_cancelled_idle,
+                               g_object_ref (task), g_object_unref);
+}
+
+/**
+ * hildon_gtk_window_take_screenshot_async:
+ * @window: a #GtkWindow
+ * @take: %TRUE to take a screenshot, %FALSE to destroy the existing one.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the operation is complete
+ * @user_data: data to pass to @callback
+ *
+ * Like hildon_gtk_window_take_screenshot_sync(), but returns immediately
+ * and calls @callback from the main loop once the window manager has
+ * replied. Call hildon_gtk_window_take_screenshot_finish() from @callback
+ * to get the result.
+ *
+ * The operation fails with %G_IO_ERROR_CLOSED if @window is unrealized
+ * before the reply arrives.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_gtk_window_take_screenshot_async         (GtkWindow           *window,
+                                                 gboolean             take,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data)
+{
+    ScreenshotRequest *request;
+    GTask *task;
+
+    g_return_if_fail (GTK_IS_WINDOW (window));
+    g_return_if_fail (gtk_widget_get_mapped (GTK_WIDGET (window)));
+    g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+    task = g_task_new (window, cancellable, callback, user_data);
+    g_task_set_source_tag (task, hildon_gtk_window_take_screenshot_async);
+
+    if (g_task_return_error_if_cancelled (task))
+    {
+        g_object_unref (task);
+        return;
+    }
+
+    request = g_slice_new0 (ScreenshotRequest);
+    request->window = window;
+    request->gdk_window = gtk_widget_get_window (GTK_WIDGET (window));
+    g_task_set_task_data (task, request, (GDestroyNotify) screenshot_request_free);
+
+    /* The reply is sent to our own window */
+    gdk_window_add_filter (request->gdk_window, screenshot_filter, task);
+    request->unrealize_id = g_signal_connect (window, "unrealize",
+                                              G_CALLBACK (screenshot_unrealized), task);
+    request->cancelled_id = g_cancellable_connect (cancellable,
+                                                   G_CALLBACK (screenshot_cancelled),
+                                                   task, NULL);
+
+    send_screenshot_request (window, take);
+}
+
+/**
+ * hildon_gtk_window_take_screenshot_finish:
+ * @window: a #GtkWindow
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes an operation started with
+ * hildon_gtk_window_take_screenshot_async().
+ *
+ * Returns: %TRUE if the window manager has completed the operation.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_gtk_window_take_screenshot_finish        (GtkWindow     *window,
+                                                 GAsyncResult  *result,
+                                                 GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, window), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * hildon_gtk_hscale_new:
  *
@@ -480,10 +867,6 @@ hildon_gtk_vscale_new                           (void)
   return scale;
 }
 
-#define HILDON_HEIGHT_FINGER    70
-
-#define HILDON_HEIGHT_THUMB     105
-
 #define HILDON_WIDTH_FULLSCREEN (gdk_screen_get_width (gdk_screen_get_default ()))
 
 #define HILDON_WIDTH_HALFSCREEN (HILDON_WIDTH_FULLSCREEN / 2)
@@ -498,13 +881,42 @@ hildon_gtk_vscale_new                           (void)
  * Since: maemo 2.0
  * Stability: Unstable
  **/
+/* Returns the widget name used by the theme for widgets of @type of
+ * the given height, e.g. "GtkButton-finger". The names are interned and
+ * kept per type, so that creating many widgets allocates nothing. */
+static const gchar *
+theme_size_widget_name                          (GType        type,
+                                                 const gchar *suffix,
+                                                 GHashTable **names)
+{
+  const gchar *name;
+
+  if (G_UNLIKELY (*names == NULL))
+    *names = g_hash_table_new (NULL, NULL);
+
+  name = g_hash_table_lookup (*names, GSIZE_TO_POINTER (type));
+
+  if (G_UNLIKELY (name == NULL))
+    {
+      gchar *tmp = g_strconcat (g_type_name (type), suffix, NULL);
+
+      name = g_intern_string (tmp);
+      g_free (tmp);
+      g_hash_table_insert (*names, GSIZE_TO_POINTER (type), (gpointer) name);
+    }
+
+  return name;
+}
+
 void
 hildon_gtk_widget_set_theme_size (GtkWidget      *widget,
                                   HildonSizeType  size)
 {
+  static GHashTable *finger_names = NULL;
+  static GHashTable *thumb_names = NULL;
   gint width = -1;
   gint height = -1;
-  gchar *widget_name = NULL;
+  const gchar *widget_name = NULL;
 
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
@@ -512,18 +924,16 @@ hildon_gtk_widget_set_theme_size (GtkWidget      *widget,
   if (size & HILDON_SIZE_FINGER_HEIGHT)
     {
       height = HILDON_HEIGHT_FINGER;
-      widget_name = "-finger";
+      widget_name = theme_size_widget_name (G_OBJECT_TYPE (widget),
+                                            "-finger", &finger_names);
     }
   else if (size & HILDON_SIZE_THUMB_HEIGHT)
     {
       height = HILDON_HEIGHT_THUMB;
-      widget_name = "-thumb";
+      widget_name = theme_size_widget_name (G_OBJECT_TYPE (widget),
+                                            "-thumb", &thumb_names);
     }
 
-  if (widget_name)
-    widget_name = g_strconcat (g_type_name (G_OBJECT_TYPE (widget)),
-                               widget_name, NULL);
-
     /* Requested width */
   if (size & HILDON_SIZE_HALFSCREEN_WIDTH)
     {
@@ -538,9 +948,8 @@ hildon_gtk_widget_set_theme_size (GtkWidget      *widget,
 
   gtk_widget_set_size_request (widget, width, height);
 
-  if (widget_name)
-    {
-      gtk_widget_set_name (widget, widget_name);
-      g_free (widget_name);
-    }
+  /* Renaming invalidates the style of the widget, skip it when the
+   * name does not change */
+  if (widget_name && g_strcmp0 (gtk_widget_get_name (widget), widget_name) != 0)
+    gtk_widget_set_name (widget, widget_name);
 }
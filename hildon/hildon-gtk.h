@@ -53,6 +53,15 @@ void
 hildon_gtk_window_set_progress_indicator        (GtkWindow *window,
                                                  guint      state);
 
+void
+hildon_gtk_window_post_progress_indicator       (GtkWindow *window,
+                                                 guint      state);
+
+void
+hildon_gtk_window_set_progress_indicator_hysteresis (GtkWindow *window,
+                                                     guint      show_delay,
+                                                     guint      min_on_time);
+
 void
 hildon_gtk_window_set_do_not_disturb            (GtkWindow *window,
                                                  gboolean   dndflag);
@@ -93,6 +102,18 @@ void
 hildon_gtk_window_take_screenshot_sync          (GtkWindow *window,
                                                  gboolean   take);
 
+void
+hildon_gtk_window_take_screenshot_async         (GtkWindow           *window,
+                                                 gboolean             take,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data);
+
+gboolean
+hildon_gtk_window_take_screenshot_finish        (GtkWindow     *window,
+                                                 GAsyncResult  *result,
+                                                 GError       **error);
+
 void
 hildon_gtk_window_enable_zoom_keys              (GtkWindow *window,
                                                  gboolean   enable);
@@ -39,6 +39,8 @@
 #include                                        <string.h>
 #include                                        "hildon-helper.h"
 #include                                        "hildon-banner.h"
+#include                                        "hildon-pannable-area.h"
+#include                                        "hildon-private.h"
 
 #define                                         HILDON_FINGER_PRESSURE_THRESHOLD 0.4
 
@@ -54,7 +56,7 @@ struct                                          _HildonLogicalElement
 {
     gboolean is_color;                          /* If FALSE, it's a logical font def */
     GtkRcFlags rc_flags;
-    GtkStateFlags state;
+    GtkStateType state;
     gchar *logical_color_name;
     gchar *logical_font_name;
 } typedef                                       HildonLogicalElement;
@@ -143,7 +145,7 @@ attach_new_font_element                         (GtkWidget *widget,
 static GSList*
 attach_new_color_element                        (GtkWidget *widget, 
                                                  GtkRcFlags flags,
-                                                 GtkStateFlags state,
+                                                 GtkStateType state,
                                                  const gchar *color_name)
 {
     GSList *style_list = g_object_get_qdata (G_OBJECT (widget), hildon_helper_logical_data_quark ());
@@ -175,119 +177,293 @@ attach_new_color_element                        (GtkWidget *widget,
     return style_list;
 }
 
-static void 
-hildon_change_style_recursive_from_list         (GtkWidget *widget, 
-                                                 GtkStyleContext *prev_style, 
-                                                 GSList *list)
+static GQuark
+hildon_helper_logical_provider_quark            (void)
 {
-    g_assert (GTK_IS_WIDGET (widget));
+    static GQuark quark = 0;
 
-    /* Change the style for child widgets */
-    if (GTK_IS_CONTAINER (widget)) {
-        GList *iterator, *children;
-        children = gtk_container_get_children (GTK_CONTAINER (widget));
-        for (iterator = children; iterator != NULL; iterator = g_list_next (iterator))
-            hildon_change_style_recursive_from_list (GTK_WIDGET (iterator->data), prev_style, list);
-        g_list_free (children);
-    }
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-logical-provider");
+
+    return quark;
+}
+
+static GQuark
+hildon_helper_logical_applied_quark             (void)
+{
+    static GQuark quark = 0;
 
-    /* gtk_widget_modify_*() emit "style_set" signals, so if we got here from
-       "style_set" signal, we need to block this function from being called
-       again or we get into inifinite loop.
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-logical-applied");
 
-    FIXME: Compiling with gcc > 3.3 and -pedantic won't allow
-    conversion between function and object pointers. GLib API however
-    requires an object pointer for a function, so we have to work
-    around this.
-    See http://bugzilla.gnome.org/show_bug.cgi?id=310175
-    */
+    return quark;
+}
 
-    G_GNUC_EXTENSION
-        g_signal_handlers_block_matched (G_OBJECT (widget), G_SIGNAL_MATCH_ID | G_SIGNAL_MATCH_FUNC,
-                g_signal_lookup ("style_updated", G_TYPE_FROM_INSTANCE (widget)),
-                0, NULL,
-                (gpointer) hildon_change_style_recursive_from_list,
-                NULL);
+static const gchar *
+logical_state_pseudo_class                      (GtkStateType state)
+{
+    switch (state)
+    {
+        case GTK_STATE_ACTIVE:
+            return ":active";
+        case GTK_STATE_PRELIGHT:
+            return ":hover";
+        case GTK_STATE_SELECTED:
+            return ":selected";
+        case GTK_STATE_INSENSITIVE:
+            return ":disabled";
+        case GTK_STATE_INCONSISTENT:
+            return ":indeterminate";
+        case GTK_STATE_FOCUSED:
+            return ":focus";
+        default:
+            return "";
+    }
+}
 
-    /* We iterate over all list elements and apply each style
-     * specification. */
+/* Turns the logical elements attached to a widget into a single style
+ * sheet. Logical colors are written as @name references, so the CSS
+ * engine resolves them against the current theme by itself and nothing
+ * needs to be redone when the theme changes. */
+static gchar *
+hildon_logical_element_list_to_css              (GSList *list)
+{
+    GString *css = g_string_new (NULL);
+    GSList *iterator;
 
-    GSList *iterator = list;
-    while (iterator) {
-    
+    for (iterator = list; iterator != NULL; iterator = iterator->next) {
         HildonLogicalElement *element = (HildonLogicalElement *) iterator->data;
 
         if (element->is_color == TRUE) {
-            GtkStyleContext *style;
-            /* Changing logical color */
-            GdkRGBA color;
-            style = gtk_widget_get_style_context (widget);
-            if (gtk_style_context_lookup_color (style, element->logical_color_name, &color) == TRUE) {
-
-                switch (element->rc_flags)
-                {
-                    case GTK_RC_FG:
-                         gtk_widget_override_color (widget, element->state, &color);
-                        break;
-
-                    case GTK_RC_BG:
-                        gtk_widget_override_background_color (widget, element->state, &color);
-                        break;
-
-                    case GTK_RC_TEXT:
-                         gtk_widget_override_color (widget, element->state, &color);
-                        break;
-
-                    case GTK_RC_BASE:
-                        gtk_widget_override_background_color (widget, element->state, &color);
-                        break;
-                }
+            const gchar *property;
+
+            switch (element->rc_flags)
+            {
+                case GTK_RC_FG:
+                case GTK_RC_TEXT:
+                    property = "color";
+                    break;
+
+                case GTK_RC_BG:
+                case GTK_RC_BASE:
+                    property = "background-color";
+                    break;
+
+                default:
+                    continue;
             }
+
+            g_string_append_printf (css, "*%s { %s: @%s; }\n",
+                                    logical_state_pseudo_class (element->state),
+                                    property, element->logical_color_name);
         } else {
-            
-            /* Changing logical font */
-            //GtkStyle *font_style = gtk_rc_get_style_by_paths (gtk_settings_get_default (), element->logical_font_name, NULL, G_TYPE_NONE);
-/* FIX THIS:
-https://mail.gnome.org/archives/commits-list/2015-February/msg03002.html
-https://mail.gnome.org/archives/commits-list/2011-January/msg05922.html*/
-
-            gchar *css;
-            GtkCssProvider *css_provider;
-
-            css = g_strconcat("GtkWidget {font:", element->logical_font_name, "}", NULL);
-
-            css_provider = gtk_css_provider_new();
-            gtk_css_provider_load_from_data(css_provider, css, -1, NULL);
-            g_free(css);
-            gtk_style_context_add_provider(gtk_widget_get_style_context(widget) ,
-                                           GTK_STYLE_PROVIDER(css_provider),
-                                           GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-            g_object_unref(css_provider);
-
-            /*GtkStyleContext *font_style = gtk_style_context_new ();
-            //gtk_style_context_set_path (font_style, element->logical_font_name);
-            if (font_style != NULL) {
-                PangoFontDescription *font_desc = 0;
-                gtk_style_context_get (font_style, gtk_widget_get_state_flags (widget), "font", &font_desc, NULL);
-
-                if (font_desc != NULL) {
-                    gtk_widget_override_font (widget, font_desc);
-                    pango_font_description_free (font_desc);
-                }
-            }*/
+            g_string_append_printf (css, "* { font: %s; }\n",
+                                    element->logical_font_name);
         }
+    }
 
-        iterator = iterator->next;
-    } 
+    return g_string_free (css, FALSE);
+}
+
+static void
+hildon_logical_provider_unapply_child           (GtkWidget *widget,
+                                                 gpointer provider);
+
+/* Providers by style sheet. Widgets given the same logical colors and
+ * fonts share one provider, so its CSS is only parsed once. The table
+ * does not own the providers; they remove themselves when finalized. */
+static GHashTable *logical_providers = NULL;
+
+static void
+hildon_logical_provider_finalized               (gpointer data,
+                                                 GObject *provider)
+{
+    g_hash_table_remove (logical_providers, data);
+}
+
+/* Takes ownership of @css */
+static GtkCssProvider *
+hildon_logical_provider_lookup                  (gchar *css)
+{
+    GtkCssProvider *provider;
+
+    if (G_UNLIKELY (logical_providers == NULL))
+        logical_providers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    provider = g_hash_table_lookup (logical_providers, css);
+    if (provider != NULL) {
+        g_free (css);
+        return g_object_ref (provider);
+    }
+
+    provider = gtk_css_provider_new ();
+    gtk_css_provider_load_from_data (provider, css, -1, NULL);
+    g_hash_table_insert (logical_providers, css, provider);
+    g_object_weak_ref (G_OBJECT (provider), hildon_logical_provider_finalized, css);
+
+    return provider;
+}
+
+/* Removes @provider from the subtree of @widget, but not from the
+ * subtrees of descendants that were given the same style sheet */
+static void
+hildon_logical_provider_unapply                 (GtkWidget *widget,
+                                                 gpointer provider)
+{
+    GSList *applied;
+
+    applied = g_object_steal_qdata (G_OBJECT (widget), hildon_helper_logical_applied_quark ());
+    if (g_slist_find (applied, provider) != NULL) {
+        gtk_style_context_remove_provider (gtk_widget_get_style_context (widget),
+                                           GTK_STYLE_PROVIDER (provider));
+        applied = g_slist_remove (applied, provider);
+    }
+    g_object_set_qdata_full (G_OBJECT (widget), hildon_helper_logical_applied_quark (),
+                             applied, (GDestroyNotify) g_slist_free);
+
+    if (GTK_IS_CONTAINER (widget))
+        gtk_container_forall (GTK_CONTAINER (widget), hildon_logical_provider_unapply_child, provider);
+}
+
+static void
+hildon_logical_provider_unapply_child           (GtkWidget *widget,
+                                                 gpointer provider)
+{
+    if (g_object_get_qdata (G_OBJECT (widget), hildon_helper_logical_provider_quark ()) != provider)
+        hildon_logical_provider_unapply (widget, provider);
+}
+
+static GtkCssProvider *
+hildon_logical_provider_update                  (GtkWidget *widget,
+                                                 GSList *list)
+{
+    GtkCssProvider *provider;
+    GtkCssProvider *old;
+    GtkWidget *ancestor;
+
+    provider = hildon_logical_provider_lookup (hildon_logical_element_list_to_css (list));
+
+    old = g_object_get_qdata (G_OBJECT (widget), hildon_helper_logical_provider_quark ());
+    if (old == provider) {
+        g_object_unref (provider);
+        return provider;
+    }
+
+    /* The old style sheet stays where an ancestor also uses it */
+    if (old != NULL) {
+        for (ancestor = gtk_widget_get_parent (widget); ancestor != NULL;
+             ancestor = gtk_widget_get_parent (ancestor)) {
+            if (g_object_get_qdata (G_OBJECT (ancestor), hildon_helper_logical_provider_quark ()) == old)
+                break;
+        }
+
+        if (ancestor == NULL)
+            hildon_logical_provider_unapply (widget, old);
+    }
+
+    g_object_set_qdata_full (G_OBJECT (widget), hildon_helper_logical_provider_quark (),
+                             provider, g_object_unref);
+
+    return provider;
+}
+
+static void
+hildon_logical_provider_apply                   (GtkWidget *widget,
+                                                 gpointer provider)
+{
+    GSList *applied;
+
+    /* Remember which providers each widget already has, so walking the
+     * subtree again only touches the children added since last time */
+    applied = g_object_steal_qdata (G_OBJECT (widget), hildon_helper_logical_applied_quark ());
+    if (g_slist_find (applied, provider) == NULL) {
+        gtk_style_context_add_provider (gtk_widget_get_style_context (widget),
+                                        GTK_STYLE_PROVIDER (provider),
+                                        GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+        applied = g_slist_prepend (applied, provider);
+    }
+    g_object_set_qdata_full (G_OBJECT (widget), hildon_helper_logical_applied_quark (),
+                             applied, (GDestroyNotify) g_slist_free);
+
+    if (GTK_IS_CONTAINER (widget))
+        gtk_container_forall (GTK_CONTAINER (widget), hildon_logical_provider_apply, provider);
+}
 
-    /* FIXME: Compilation workaround for gcc > 3.3 + -pedantic again */
+static void 
+hildon_change_style_recursive_from_list         (GtkWidget *widget, 
+                                                 GtkStyleContext *prev_style, 
+                                                 GSList *list)
+{
+    GtkCssProvider *provider;
 
-    G_GNUC_EXTENSION
-        g_signal_handlers_unblock_matched (G_OBJECT (widget), G_SIGNAL_MATCH_ID | G_SIGNAL_MATCH_FUNC,
-                g_signal_lookup ("style_updated", G_TYPE_FROM_INSTANCE (widget)),
-                0, NULL,
-                (gpointer) hildon_change_style_recursive_from_list,
-                NULL);
+    g_assert (GTK_IS_WIDGET (widget));
+
+    provider = g_object_get_qdata (G_OBJECT (widget), hildon_helper_logical_provider_quark ());
+    if (provider == NULL)
+        provider = hildon_logical_provider_update (widget, list);
+
+    hildon_logical_provider_apply (widget, provider);
+}
+
+enum {
+    DEVICE_PRESSURE_UNKNOWN,
+    DEVICE_PRESSURE_NONE,
+    DEVICE_PRESSURE_AXIS
+};
+
+static GQuark
+device_pressure_quark                           (void)
+{
+    static GQuark quark = 0;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-helper-device-pressure");
+
+    return quark;
+}
+
+static void
+device_pressure_changed                         (GdkDevice *device)
+{
+    g_object_set_qdata (G_OBJECT (device), device_pressure_quark (),
+                        GINT_TO_POINTER (DEVICE_PRESSURE_UNKNOWN));
+}
+
+/* Whether @device has a pressure axis. The answer is kept on the
+ * device, so it goes away with it, and is forgotten when its axes
+ * change */
+static gboolean
+device_has_pressure                             (GdkDevice *device)
+{
+    gint cached;
+    gint i, n_axes;
+
+    if (device == NULL)
+        return TRUE;
+
+    cached = GPOINTER_TO_INT (g_object_get_qdata (G_OBJECT (device),
+                                                  device_pressure_quark ()));
+    if (cached != DEVICE_PRESSURE_UNKNOWN)
+        return cached == DEVICE_PRESSURE_AXIS;
+
+    if (!g_signal_handler_find (device, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+                                device_pressure_changed, NULL))
+        g_signal_connect (device, "changed",
+                          G_CALLBACK (device_pressure_changed), NULL);
+
+    cached = DEVICE_PRESSURE_NONE;
+    n_axes = gdk_device_get_n_axes (device);
+    for (i = 0; i < n_axes; i++) {
+        if (gdk_device_get_axis_use (device, i) == GDK_AXIS_PRESSURE) {
+            cached = DEVICE_PRESSURE_AXIS;
+            break;
+        }
+    }
+
+    g_object_set_qdata (G_OBJECT (device), device_pressure_quark (),
+                        GINT_TO_POINTER (cached));
+
+    return cached == DEVICE_PRESSURE_AXIS;
 }
 
 /**
@@ -303,7 +479,8 @@ hildon_helper_event_button_is_finger            (GdkEventButton *event)
 {
     gdouble pressure;
 
-    if (gdk_event_get_axis ((GdkEvent*) event, GDK_AXIS_PRESSURE, &pressure) &&
+    if (device_has_pressure (event->device) &&
+        gdk_event_get_axis ((GdkEvent*) event, GDK_AXIS_PRESSURE, &pressure) &&
         pressure > HILDON_FINGER_PRESSURE_THRESHOLD)
         return TRUE;
 
@@ -326,8 +503,9 @@ hildon_helper_event_button_is_finger            (GdkEventButton *event)
  * @logicalfontname: a gchar* with the logical font name to assign to the widget.
  *
  * This function assigns a defined logical font to the @widget and all its child widgets.
- * it also connects to the "style_set" signal which will retrieve & assign the new font
- * for the given logical name each time the theme is changed
+ * The logical font is resolved by the CSS engine, so it follows theme changes
+ * without further work. The function also connects to the "style_set" signal
+ * so that child widgets added later get the logical font as well.
  * The returned signal id can be used to disconnect the signal.
  * When calling multiple times the previous signal (obtained by calling this function) is disconnected
  * automatically and should not be used.
@@ -353,6 +531,7 @@ hildon_helper_set_logical_font                  (GtkWidget *widget,
                                           G_CALLBACK (hildon_change_style_recursive_from_list), NULL);
 
     /* Change the font now */
+    hildon_logical_provider_update (widget, list);
     hildon_change_style_recursive_from_list (widget, NULL, list);
 
     /* Connect to "style_set" so that the font gets changed whenever theme changes. */
@@ -371,8 +550,9 @@ hildon_helper_set_logical_font                  (GtkWidget *widget,
  * @logicalcolorname: A gchar* with the logical font name to assign to the widget.
  * 
  * This function assigns a defined logical color to the @widget and all it's child widgets.
- * It also connects to the "style_set" signal which will retrieve & assign the new color 
- * for the given logical name each time the theme is changed.
+ * The logical color is resolved by the CSS engine, so it follows theme changes
+ * without further work. The function also connects to the "style_set" signal
+ * so that child widgets added later get the logical color as well.
  * The returned signal id can be used to disconnect the signal.
  * When calling multiple times the previous signal (obtained by calling this function) is disconnected 
  * automatically and should not be used. 
@@ -401,6 +581,7 @@ hildon_helper_set_logical_color                 (GtkWidget *widget,
                                           G_CALLBACK (hildon_change_style_recursive_from_list), NULL);
 
     /* Change the colors now */
+    hildon_logical_provider_update (widget, list);
     hildon_change_style_recursive_from_list (widget, NULL, list);
 
     /* Connect to "style_set" so that the colors gets changed whenever theme */
@@ -438,6 +619,32 @@ hildon_helper_set_thumb_scrollbar               (GtkScrolledWindow *win,
         gtk_widget_set_name (vscrollbar, (thumb) ? "hildon-thumb-scrollbar" : NULL);
 }
 
+enum {
+    FILE_SIZE_KB,
+    FILE_SIZE_1KB_99KB,
+    FILE_SIZE_100KB_1MB,
+    FILE_SIZE_1MB_10MB,
+    FILE_SIZE_10MB_1GB,
+    FILE_SIZE_1GB_OR_GREATER,
+    FILE_SIZE_N_FORMATS
+};
+
+/* Looked up for every call, so that a change of locale is followed */
+static const gchar *
+file_size_format                                (guint which)
+{
+    static const gchar *const msgids[FILE_SIZE_N_FORMATS] = {
+        "ckdg_va_properties_size_kb",
+        "ckdg_va_properties_size_1kb_99kb",
+        "ckdg_va_properties_size_100kb_1mb",
+        "ckdg_va_properties_size_1mb_10mb",
+        "ckdg_va_properties_size_10mb_1gb",
+        "ckdg_va_properties_size_1gb_or_greater"
+    };
+
+    return g_dgettext ("hildon-fm", msgids[which]);
+}
+
 /**
  * hildon_format_file_size_for_display:
  * @size: a size in bytes
@@ -452,37 +659,73 @@ hildon_helper_set_thumb_scrollbar               (GtkScrolledWindow *win,
 gchar *
 hildon_format_file_size_for_display             (goffset size)
 {
-    #define _HFM(string) g_dgettext ("hildon-fm", string)
+    gint length = hildon_format_file_size_to_buffer (size, NULL, 0);
+    gchar *buffer = g_malloc (length + 1);
+
+    hildon_format_file_size_to_buffer (size, buffer, length + 1);
+
+    return buffer;
+}
+
+/**
+ * hildon_format_file_size_to_buffer:
+ * @size: a size in bytes
+ * @buffer: a buffer where to write the formatted size, or %NULL
+ * @buffer_size: the size of @buffer, in bytes
+ *
+ * Formats a file size like hildon_format_file_size_for_display(), but
+ * writes it into @buffer instead of allocating it, so this is cheap
+ * enough to be called from a #GtkTreeCellDataFunc for every visible
+ * row. The result is always nul-terminated and truncated if it does
+ * not fit; 64 bytes are enough for any translation shipped with Maemo.
+ * Pass a %NULL @buffer and a @buffer_size of 0 to only get the length.
+ *
+ * Returns: the length of the whole formatted size, not counting the
+ * nul byte.
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_format_file_size_to_buffer               (goffset size,
+                                                 gchar *buffer,
+                                                 gsize buffer_size)
+{
+    g_return_val_if_fail (buffer != NULL || buffer_size == 0, -1);
 
     if (size < 1024)
-        return g_strdup_printf (_HFM ("ckdg_va_properties_size_kb"),
-                                1);
+        return g_snprintf (buffer, buffer_size, file_size_format (FILE_SIZE_KB),
+                           1);
     else if (size < 100 * 1024)
-        return g_strdup_printf (_HFM ("ckdg_va_properties_size_1kb_99kb"),
-                                (int)size / 1024);
+        return g_snprintf (buffer, buffer_size, file_size_format (FILE_SIZE_1KB_99KB),
+                           (int)size / 1024);
     else if (size < 1024 * 1024)
-        return g_strdup_printf (_HFM ("ckdg_va_properties_size_100kb_1mb"),
-                                (int)size / 1024);
+        return g_snprintf (buffer, buffer_size, file_size_format (FILE_SIZE_100KB_1MB),
+                           (int)size / 1024);
     else if (size < 10 * 1024 * 1024)
-        return g_strdup_printf (_HFM ("ckdg_va_properties_size_1mb_10mb"),
-                                size / (1024.0f * 1024.0f));
+        return g_snprintf (buffer, buffer_size, file_size_format (FILE_SIZE_1MB_10MB),
+                           size / (1024.0f * 1024.0f));
     else if (size < 1024 * 1024 * 1024)
-        return g_strdup_printf (_HFM ("ckdg_va_properties_size_10mb_1gb"),
-                                size / (1024.0f * 1024.0f));
+        return g_snprintf (buffer, buffer_size, file_size_format (FILE_SIZE_10MB_1GB),
+                           size / (1024.0f * 1024.0f));
     else
-        return g_strdup_printf (_HFM ("ckdg_va_properties_size_1gb_or_greater"),
-                                size / (1024.0f * 1024.0f * 1024.0f));
+        return g_snprintf (buffer, buffer_size, file_size_format (FILE_SIZE_1GB_OR_GREATER),
+                           size / (1024.0f * 1024.0f * 1024.0f));
 }
 
 
+/* Latin, IPA, Greek and Cyrillic blocks, U+0000 to U+04FF */
+#define                                         STRIPPED_TABLE_SIZE 0x500
+
+static gunichar                                 stripped_table[STRIPPED_TABLE_SIZE];
+
 /**
- * stripped_char:
+ * stripped_char_slow:
  *
  * Returns a stripped version of @ch, removing any case, accentuation
  * mark, or any special mark on it.
  **/
 static gunichar
-stripped_char (gunichar ch)
+stripped_char_slow (gunichar ch)
 {
   gunichar decomp[4];
   gunichar retval;
@@ -513,9 +756,63 @@ stripped_char (gunichar ch)
   return 0;
 }
 
-static gchar *
+/**
+ * stripped_table_init:
+ *
+ * Fills the folding table with the result of stripped_char_slow() for
+ * every code point it covers, the first time it is needed.
+ **/
+static void
+stripped_table_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    gunichar ch;
+
+    for (ch = 0; ch < STRIPPED_TABLE_SIZE; ch++)
+      stripped_table[ch] = stripped_char_slow (ch);
+
+    g_once_init_leave (&initialized, 1);
+  }
+}
+
+/**
+ * stripped_char:
+ *
+ * Returns a stripped version of @ch, removing any case, accentuation
+ * mark, or any special mark on it. ASCII is folded inline, the
+ * Latin, Greek and Cyrillic blocks come from a precomputed table and
+ * anything else goes through stripped_char_slow().
+ **/
+static inline gunichar
+stripped_char (gunichar ch)
+{
+  if (G_LIKELY (ch < 0x80)) {
+    if (ch < 0x20 || ch == 0x7f)
+      return 0;
+    if (ch >= 'A' && ch <= 'Z')
+      return ch + ('a' - 'A');
+    return ch;
+  }
+
+  if (ch < STRIPPED_TABLE_SIZE) {
+    stripped_table_init ();
+    return stripped_table[ch];
+  }
+
+  return stripped_char_slow (ch);
+}
+
+static inline gchar *
 e_util_unicode_get_utf8 (const gchar *text, gunichar *out)
 {
+  /* ASCII needs no decoding */
+  if (G_LIKELY ((guchar) *text < 0x80)) {
+    *out = (guchar) *text;
+    return (gchar *) text + 1;
+  }
+
   *out = g_utf8_get_char (text);
   return (*out == (gunichar)-1) ? NULL : g_utf8_next_char (text);
 }
@@ -666,6 +963,238 @@ hildon_helper_strip_string (const gchar *string)
   return nuni;
 }
 
+/**
+ * hildon_helper_strip_strings:
+ * @strings: a %NULL-terminated array of strings to be stripped off.
+ *
+ * Strips all capitalization and accentuation marks from every string
+ * in @strings, as hildon_helper_strip_string() does. This is useful
+ * when a whole set of strings is going to be searched, since all the
+ * results are stored in a single allocation.
+ *
+ * Unlike hildon_helper_strip_string(), empty strings and strings
+ * with illegal UTF-8 sequences result in an empty Unicode string
+ * rather than %NULL, so the returned array has the same length as
+ * @strings.
+ *
+ * Returns: a newly allocated %NULL-terminated array with the stripped
+ * Unicode strings. Free it with g_free(), the strings must not be
+ * freed separately.
+ *
+ * Since: 3.0
+ **/
+gunichar **
+hildon_helper_strip_strings (const gchar * const *strings)
+{
+  gunichar **result;
+  gunichar *buffer;
+  gsize n_strings = 0;
+  gsize n_chars = 0;
+  gsize i;
+
+  g_return_val_if_fail (strings != NULL, NULL);
+
+  /* A code point never takes less than a byte, so the length in
+     bytes is enough room for each stripped string */
+  for (i = 0; strings[i] != NULL; i++)
+    n_chars += strlen (strings[i]) + 1;
+  n_strings = i;
+
+  result = g_malloc (sizeof (gunichar *) * (n_strings + 1) +
+                     sizeof (gunichar) * n_chars);
+  buffer = (gunichar *) (result + n_strings + 1);
+
+  for (i = 0; i < n_strings; i++) {
+    const gchar *p;
+    gunichar unival;
+    gsize nlen = 0;
+
+    for (p = e_util_unicode_get_utf8 (strings[i], &unival);
+         p && unival;
+         p = e_util_unicode_get_utf8 (p, &unival)) {
+      gunichar sc = stripped_char (unival);
+      if (sc)
+        buffer[nlen++] = sc;
+    }
+
+    /* NULL means there was illegal utf-8 sequence */
+    if (!p) nlen = 0;
+
+    buffer[nlen] = 0;
+    result[i] = buffer;
+    buffer += strlen (strings[i]) + 1;
+  }
+
+  result[n_strings] = NULL;
+
+  return result;
+}
+
+/* ASCII transliterations of U+00A0 to U+017F (Latin-1 Supplement and
+ * Latin Extended-A), taken from their Unicode decompositions with a few
+ * letters which do not decompose (æ, ø, ß, ł, þ...) spelled out. No
+ * entry is longer than the UTF-8 encoding of its code point, so a
+ * normalized string is never longer than the original one. */
+#define                                         TRANSLIT_TABLE_START 0xA0
+#define                                         TRANSLIT_TABLE_END 0x180
+
+static const gchar * const                      translit_table[TRANSLIT_TABLE_END - TRANSLIT_TABLE_START] = {
+    /* U+00A0 */ " ", "!", "c", "?", "?", "?", "|", "?",
+    /* U+00A8 */ "\"", "?", "a", "<<", "!", "", "?", "-",
+    /* U+00B0 */ "?", "+-", "2", "3", "'", "u", "?", ".",
+    /* U+00B8 */ ",", "1", "o", ">>", "?", "?", "?", "?",
+    /* U+00C0 */ "A", "A", "A", "A", "A", "A", "AE", "C",
+    /* U+00C8 */ "E", "E", "E", "E", "I", "I", "I", "I",
+    /* U+00D0 */ "D", "N", "O", "O", "O", "O", "O", "x",
+    /* U+00D8 */ "O", "U", "U", "U", "U", "Y", "TH", "ss",
+    /* U+00E0 */ "a", "a", "a", "a", "a", "a", "ae", "c",
+    /* U+00E8 */ "e", "e", "e", "e", "i", "i", "i", "i",
+    /* U+00F0 */ "d", "n", "o", "o", "o", "o", "o", ":",
+    /* U+00F8 */ "o", "u", "u", "u", "u", "y", "th", "y",
+    /* U+0100 */ "A", "a", "A", "a", "A", "a", "C", "c",
+    /* U+0108 */ "C", "c", "C", "c", "C", "c", "D", "d",
+    /* U+0110 */ "D", "d", "E", "e", "E", "e", "E", "e",
+    /* U+0118 */ "E", "e", "E", "e", "G", "g", "G", "g",
+    /* U+0120 */ "G", "g", "G", "g", "H", "h", "H", "h",
+    /* U+0128 */ "I", "i", "I", "i", "I", "i", "I", "i",
+    /* U+0130 */ "I", "i", "IJ", "ij", "J", "j", "K", "k",
+    /* U+0138 */ "q", "L", "l", "L", "l", "L", "l", "L",
+    /* U+0140 */ "l", "L", "l", "N", "n", "N", "n", "N",
+    /* U+0148 */ "n", "'n", "N", "n", "O", "o", "O", "o",
+    /* U+0150 */ "O", "o", "OE", "oe", "R", "r", "R", "r",
+    /* U+0158 */ "R", "r", "S", "s", "S", "s", "S", "s",
+    /* U+0160 */ "S", "s", "T", "t", "T", "t", "T", "t",
+    /* U+0168 */ "U", "u", "U", "u", "U", "u", "U", "u",
+    /* U+0170 */ "U", "u", "U", "u", "W", "w", "Y", "y",
+    /* U+0178 */ "Y", "Z", "z", "Z", "z", "Z", "z", "s",
+};
+
+/**
+ * translit_char:
+ * @ch: a non-ASCII code point
+ * @scratch: a buffer of at least two bytes
+ *
+ * Returns the ASCII transliteration of @ch, which may be an empty
+ * string for marks and invisible characters, or "?" if there is no
+ * sensible transliteration.
+ **/
+static const gchar *
+translit_char (gunichar ch, gchar *scratch)
+{
+    gunichar decomp[4];
+
+    /* C1 control characters */
+    if (ch < TRANSLIT_TABLE_START)
+        return "?";
+
+    if (ch < TRANSLIT_TABLE_END)
+        return translit_table[ch - TRANSLIT_TABLE_START];
+
+    switch (ch) {
+    case 0x2000: case 0x2001: case 0x2002: case 0x2003: case 0x2004:
+    case 0x2005: case 0x2006: case 0x2007: case 0x2008: case 0x2009:
+    case 0x200A: case 0x202F: case 0x205F:
+        return " ";
+    case 0x200B: case 0x200C: case 0x200D: case 0x200E: case 0x200F:
+    case 0x2060: case 0xFEFF:
+        return "";
+    case 0x2010: case 0x2011: case 0x2012: case 0x2013: case 0x2014:
+    case 0x2015: case 0x2212:
+        return "-";
+    case 0x2018: case 0x2019: case 0x201A: case 0x201B: case 0x2032:
+        return "'";
+    case 0x201C: case 0x201D: case 0x201E: case 0x201F: case 0x2033:
+        return "\"";
+    case 0x2022:
+        return "o";
+    case 0x2026:
+        return "...";
+    case 0x2039:
+        return "<";
+    case 0x203A:
+        return ">";
+    case 0x20AC:
+        return "EUR";
+    }
+
+    if (g_unichar_ismark (ch))
+        return "";
+
+    /* Latin Extended Additional and the like decompose to ASCII */
+    if (g_unichar_fully_decompose (ch, FALSE, decomp, 4) && decomp[0] < 0x80) {
+        scratch[0] = decomp[0];
+        scratch[1] = '\0';
+        return scratch;
+    }
+
+    return "?";
+}
+
+/**
+ * hildon_helper_normalize_string_to_buffer:
+ * @string: a string
+ * @buffer: a buffer where to write the normalized string, or %NULL
+ * @buffer_size: the size of @buffer, in bytes
+ *
+ * Transforms a string into an ascii equivalent representation, like
+ * hildon_helper_normalize_string(), but writes it into @buffer
+ * instead of allocating it. The result is always nul-terminated and
+ * truncated if it does not fit, so callers only interested in the
+ * first bytes can pass a small buffer.
+ *
+ * The normalized string is never longer than @string, so a buffer
+ * of strlen (@string) + 1 bytes is always big enough. The result
+ * comes from a built-in transliteration table and does not depend
+ * on the current locale.
+ *
+ * Returns: the length of the whole normalized string, not counting
+ * the nul byte, or -1 if @string is not valid UTF-8.
+ *
+ * Since: 3.0
+ **/
+gssize
+hildon_helper_normalize_string_to_buffer (const gchar *string,
+                                          gchar *buffer,
+                                          gsize buffer_size)
+{
+    const gchar *p;
+    gchar scratch[2];
+    gsize len = 0;
+
+    g_return_val_if_fail (string != NULL, -1);
+    g_return_val_if_fail (buffer != NULL || buffer_size == 0, -1);
+
+    for (p = string; *p != '\0'; ) {
+        const gchar *t;
+        gunichar ch;
+
+        if ((guchar) *p < 0x80) {
+            if (len + 1 < buffer_size)
+                buffer[len] = *p;
+            len++;
+            p++;
+            continue;
+        }
+
+        ch = g_utf8_get_char_validated (p, -1);
+        if (ch == (gunichar) -1 || ch == (gunichar) -2)
+            return -1;
+
+        for (t = translit_char (ch, scratch); *t != '\0'; t++) {
+            if (len + 1 < buffer_size)
+                buffer[len] = *t;
+            len++;
+        }
+
+        p = g_utf8_next_char (p);
+    }
+
+    if (buffer_size > 0)
+        buffer[MIN (len, buffer_size - 1)] = '\0';
+
+    return len;
+}
+
 /**
  * hildon_helper_normalize_string:
  * @string: a string
@@ -673,16 +1202,173 @@ hildon_helper_strip_string (const gchar *string)
  * Transform a string into an ascii equivalent representation.
  * This is necessary for hildon_helper_smart_match() to work properly.
  *
- * Returns: a newly allocated string.
+ * See hildon_helper_normalize_string_to_buffer() for a version that
+ * does not allocate memory.
+ *
+ * Returns: a newly allocated string, or %NULL if @string is not
+ * valid UTF-8.
  **/
 gchar *
 hildon_helper_normalize_string (const gchar *string)
 {
-    gchar *str = g_convert (string, -1, "ascii//translit", "utf-8", NULL, NULL, NULL);
+    gsize size;
+    gchar *str;
+
+    g_return_val_if_fail (string != NULL, NULL);
+
+    size = strlen (string) + 1;
+    str = g_malloc (size);
+
+    if (hildon_helper_normalize_string_to_buffer (string, str, size) < 0) {
+        g_free (str);
+        return NULL;
+    }
 
     return str;
 }
 
+/**
+ * hildon_helper_normalize_strings:
+ * @strings: a %NULL-terminated array of strings
+ *
+ * Transforms every string in @strings into an ascii equivalent
+ * representation, as hildon_helper_normalize_string() does, storing
+ * all the results in a single allocation. This is useful to build
+ * the search index of a whole model at once, for instance from the
+ * threads of a #GThreadPool, each normalizing its own batch of rows.
+ *
+ * Strings which are not valid UTF-8 result in an empty string rather
+ * than %NULL, so the returned array has the same length as @strings.
+ *
+ * Like the rest of the string matching functions, this keeps no state
+ * and depends neither on the locale nor on iconv, so it can be called
+ * from any thread.
+ *
+ * Returns: a newly allocated %NULL-terminated array with the
+ * normalized strings. Free it with g_free(), the strings must not be
+ * freed separately.
+ *
+ * Since: 3.0
+ **/
+gchar **
+hildon_helper_normalize_strings (const gchar * const *strings)
+{
+    gchar **result;
+    gchar *buffer;
+    gsize n_strings;
+    gsize n_bytes = 0;
+    gsize i;
+
+    g_return_val_if_fail (strings != NULL, NULL);
+
+    /* A normalized string is never longer than the original one */
+    for (i = 0; strings[i] != NULL; i++)
+        n_bytes += strlen (strings[i]) + 1;
+    n_strings = i;
+
+    result = g_malloc (sizeof (gchar *) * (n_strings + 1) + n_bytes);
+    buffer = (gchar *) (result + n_strings + 1);
+
+    for (i = 0; i < n_strings; i++) {
+        gsize size = strlen (strings[i]) + 1;
+
+        if (hildon_helper_normalize_string_to_buffer (strings[i], buffer, size) < 0)
+            buffer[0] = '\0';
+
+        result[i] = buffer;
+        buffer += size;
+    }
+
+    result[n_strings] = NULL;
+
+    return result;
+}
+
+#define                                         ASCII_FOLD(c) \
+    (((c) >= 'A' && (c) <= 'Z') ? (c) + ('a' - 'A') : (c))
+
+/**
+ * ascii_strcasestr:
+ * @haystack: a string where to find a match
+ * @needle: what to find
+ *
+ * Same as strcasestr(), but only folding ASCII letters, so it gives
+ * the same result whatever the locale of the calling thread is.
+ *
+ * Returns: the first occurence of @needle in @haystack, or %NULL.
+ **/
+static const gchar *
+ascii_strcasestr (const gchar *haystack,
+                  const gchar *needle)
+{
+    const guchar *p;
+    const guchar *n = (const guchar *) needle;
+
+    if (n[0] == '\0')
+        return haystack;
+
+    for (p = (const guchar *) haystack; *p != '\0'; p++) {
+        gsize k = 0;
+
+        while (n[k] != '\0' && ASCII_FOLD (p[k]) == ASCII_FOLD (n[k]))
+            k++;
+        if (n[k] == '\0')
+            return (const gchar *) p;
+    }
+
+    return NULL;
+}
+
+/**
+ * smart_match_word_prefix:
+ * @haystack: a string where to find a match
+ * @needle: what to find, starting with an alphanumeric character
+ * @len: the length of @needle
+ * @lowered: whether @needle is already lowercase
+ *
+ * Finds the first word of @haystack starting with @needle, ignoring
+ * ASCII case. Each word is rejected on its first character before
+ * comparing the rest, so most words cost a single comparison.
+ *
+ * Returns: the start of the matching word, or %NULL.
+ **/
+static const gchar *
+smart_match_word_prefix (const gchar *haystack,
+                         const gchar *needle,
+                         gsize len,
+                         gboolean lowered)
+{
+    const guchar *p = (const guchar *) haystack;
+    const guchar *n = (const guchar *) needle;
+    guchar first = lowered ? n[0] : ASCII_FOLD (n[0]);
+
+    while (*p != '\0') {
+        while (*p != '\0' && !g_ascii_isalnum (*p))
+            p++;
+        if (*p == '\0')
+            break;
+
+        if (ASCII_FOLD (*p) == first) {
+            gsize k = 1;
+
+            if (lowered) {
+                while (k < len && ASCII_FOLD (p[k]) == n[k])
+                    k++;
+            } else {
+                while (k < len && ASCII_FOLD (p[k]) == ASCII_FOLD (n[k]))
+                    k++;
+            }
+            if (k == len)
+                return (const gchar *) p;
+        }
+
+        while (g_ascii_isalnum (*p))
+            p++;
+    }
+
+    return NULL;
+}
+
 /**
  * hildon_helper_smart_match:
  * @haystack: a string where to find a match
@@ -696,6 +1382,10 @@ hildon_helper_normalize_string (const gchar *string)
  * If @haystack itself doesn't start with an alphanumeric character,
  * then the search is equivalent to strcasecmp().
  *
+ * The case of ASCII letters only is ignored, so the result does not
+ * depend on the locale and the function can be called from any
+ * thread.
+ *
  * To make the best of this method, it is recommended that both the needle
  * and the haystack are already normalized as ASCII strings. For this, you
  * should call hildon_helper_normalize_string() on both strings.
@@ -713,19 +1403,563 @@ hildon_helper_smart_match (const gchar *haystack, const gchar *needle)
     gboolean skip_separators = g_ascii_isalnum (needle[0]);
 
     if (skip_separators) {
-        gint i = 0;
-        while (haystack[i] != '\0') {
-            while (haystack[i] != '\0' && !g_ascii_isalnum (haystack[i]))
-                i++;
-            if (g_ascii_strncasecmp (haystack + i, needle, strlen (needle)) == 0) {
-                return (gchar *)haystack + i;
-            }
-            while (g_ascii_isalnum (haystack[i]))
-                   i++;
-        }
+        return (gchar *) smart_match_word_prefix (haystack, needle, strlen (needle), FALSE);
     } else {
-        return strcasestr (haystack, needle);
+        return (gchar *) ascii_strcasestr (haystack, needle);
     }
 
     return NULL;
 }
+
+struct _HildonHelperNeedle
+{
+    gchar *lowered;
+    gsize len;
+    gboolean skip_separators;
+};
+
+/**
+ * hildon_helper_needle_new:
+ * @needle: what to find
+ *
+ * Prepares @needle to be searched for with
+ * hildon_helper_smart_match_needle(). The needle is lowered and its
+ * length computed only once, which pays off when the same needle is
+ * matched against many haystacks, like the rows of a filtered model.
+ *
+ * As with hildon_helper_smart_match(), @needle should already be
+ * normalized with hildon_helper_normalize_string().
+ *
+ * Returns: a newly allocated #HildonHelperNeedle. Free it with
+ * hildon_helper_needle_free().
+ *
+ * Since: 3.0
+ **/
+HildonHelperNeedle *
+hildon_helper_needle_new (const gchar *needle)
+{
+    HildonHelperNeedle *compiled;
+
+    g_return_val_if_fail (needle != NULL, NULL);
+
+    compiled = g_slice_new (HildonHelperNeedle);
+    compiled->lowered = g_ascii_strdown (needle, -1);
+    compiled->len = strlen (compiled->lowered);
+    compiled->skip_separators = g_ascii_isalnum (needle[0]);
+
+    return compiled;
+}
+
+/**
+ * hildon_helper_needle_free:
+ * @needle: a #HildonHelperNeedle
+ *
+ * Frees a needle created with hildon_helper_needle_new().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_helper_needle_free (HildonHelperNeedle *needle)
+{
+    if (needle == NULL)
+        return;
+
+    g_free (needle->lowered);
+    g_slice_free (HildonHelperNeedle, needle);
+}
+
+/**
+ * hildon_helper_smart_match_needle:
+ * @haystack: a string where to find a match
+ * @needle: a #HildonHelperNeedle, what to find
+ *
+ * Same as hildon_helper_smart_match(), but with a needle prepared
+ * by hildon_helper_needle_new().
+ *
+ * Returns: a pointer to the first occurence of @needle in @haystack or %NULL
+ * if not found
+ *
+ * Since: 3.0
+ **/
+gchar *
+hildon_helper_smart_match_needle (const gchar *haystack,
+                                  const HildonHelperNeedle *needle)
+{
+    if (haystack == NULL) return NULL;
+    if (needle == NULL) return NULL;
+    if (haystack[0] == '\0') return NULL;
+
+    if (needle->skip_separators) {
+        return (gchar *) smart_match_word_prefix (haystack, needle->lowered, needle->len, TRUE);
+    } else {
+        return (gchar *) ascii_strcasestr (haystack, needle->lowered);
+    }
+}
+
+struct _HildonHelperQuery
+{
+    HildonHelperNeedle **needles;
+    guint n_needles;
+    gboolean distinct_words;
+};
+
+static gint
+needle_compare_length (gconstpointer a,
+                       gconstpointer b,
+                       gpointer data)
+{
+    const HildonHelperNeedle *na = *(HildonHelperNeedle * const *) a;
+    const HildonHelperNeedle *nb = *(HildonHelperNeedle * const *) b;
+
+    /* Longest first */
+    if (na->len == nb->len)
+        return 0;
+    return na->len > nb->len ? -1 : 1;
+}
+
+/**
+ * hildon_helper_query_new:
+ * @text: the text of the query, as typed by the user
+ * @distinct_words: whether each token must match a different word
+ *
+ * Compiles a search query made of space-separated tokens. Each token
+ * is normalized with hildon_helper_normalize_string() and prepared
+ * with hildon_helper_needle_new() only once, so the query can then
+ * be matched against every row of a model with
+ * hildon_helper_query_match().
+ *
+ * Tokens are tried longest first, since they are the least likely to
+ * match, so most haystacks are rejected by the first token.
+ *
+ * If @distinct_words is %TRUE, for example, "jo jo" matches "John
+ * Jones" but not "John Smith".
+ *
+ * Returns: a newly allocated #HildonHelperQuery. Free it with
+ * hildon_helper_query_free().
+ *
+ * Since: 3.0
+ **/
+HildonHelperQuery *
+hildon_helper_query_new (const gchar *text,
+                         gboolean distinct_words)
+{
+    HildonHelperQuery *query;
+    gchar **tokens;
+    guint i;
+
+    g_return_val_if_fail (text != NULL, NULL);
+
+    tokens = g_strsplit (text, " ", -1);
+
+    query = g_slice_new (HildonHelperQuery);
+    query->needles = g_new (HildonHelperNeedle *, g_strv_length (tokens) + 1);
+    query->n_needles = 0;
+    query->distinct_words = distinct_words;
+
+    for (i = 0; tokens[i] != NULL; i++) {
+        gchar *token;
+
+        if (tokens[i][0] == '\0')
+            continue;
+
+        token = hildon_helper_normalize_string (tokens[i]);
+        if (token != NULL) {
+            query->needles[query->n_needles++] = hildon_helper_needle_new (token);
+            g_free (token);
+        }
+    }
+    query->needles[query->n_needles] = NULL;
+
+    g_strfreev (tokens);
+
+    g_qsort_with_data (query->needles, query->n_needles, sizeof (HildonHelperNeedle *),
+                       needle_compare_length, NULL);
+
+    return query;
+}
+
+/**
+ * hildon_helper_query_free:
+ * @query: a #HildonHelperQuery
+ *
+ * Frees a query created with hildon_helper_query_new().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_helper_query_free (HildonHelperQuery *query)
+{
+    guint i;
+
+    if (query == NULL)
+        return;
+
+    for (i = 0; i < query->n_needles; i++)
+        hildon_helper_needle_free (query->needles[i]);
+    g_free (query->needles);
+    g_slice_free (HildonHelperQuery, query);
+}
+
+/**
+ * hildon_helper_query_is_empty:
+ * @query: a #HildonHelperQuery
+ *
+ * Returns: %TRUE if @query has no tokens, and thus matches everything.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_helper_query_is_empty (const HildonHelperQuery *query)
+{
+    g_return_val_if_fail (query != NULL, TRUE);
+
+    return query->n_needles == 0;
+}
+
+/* Returns the end of the word starting at @word */
+static const gchar *
+word_end (const gchar *word)
+{
+    while (g_ascii_isalnum (*word))
+        word++;
+
+    return word;
+}
+
+/**
+ * query_match_distinct:
+ *
+ * Tries to match needles @i and following to words of @haystack not
+ * present in @used, backtracking if a needle could match several
+ * words.
+ **/
+static gboolean
+query_match_distinct (const HildonHelperQuery *query,
+                      const gchar *haystack,
+                      guint i,
+                      const gchar **used)
+{
+    const HildonHelperNeedle *needle;
+    const gchar *p;
+
+    if (i == query->n_needles)
+        return TRUE;
+
+    needle = query->needles[i];
+
+    /* Non-word tokens are plain substrings, they do not take a word */
+    if (!needle->skip_separators) {
+        return ascii_strcasestr (haystack, needle->lowered) != NULL &&
+            query_match_distinct (query, haystack, i + 1, used);
+    }
+
+    for (p = smart_match_word_prefix (haystack, needle->lowered, needle->len, TRUE);
+         p != NULL;
+         p = smart_match_word_prefix (word_end (p), needle->lowered, needle->len, TRUE)) {
+        guint j;
+
+        for (j = 0; j < i && used[j] != p; j++);
+        if (j < i)
+            continue;
+
+        used[i] = p;
+        if (query_match_distinct (query, haystack, i + 1, used))
+            return TRUE;
+    }
+
+    used[i] = NULL;
+
+    return FALSE;
+}
+
+/**
+ * hildon_helper_query_match:
+ * @query: a #HildonHelperQuery
+ * @haystack: a string normalized with hildon_helper_normalize_string()
+ *
+ * Checks whether every token of @query matches @haystack, as
+ * hildon_helper_smart_match_needle() does. Matching stops at the
+ * first token that fails.
+ *
+ * Returns: %TRUE if @haystack matches @query.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_helper_query_match (const HildonHelperQuery *query,
+                           const gchar *haystack)
+{
+    guint i;
+
+    g_return_val_if_fail (query != NULL, FALSE);
+
+    if (query->n_needles == 0)
+        return TRUE;
+
+    for (i = 0; i < query->n_needles; i++) {
+        if (hildon_helper_smart_match_needle (haystack, query->needles[i]) == NULL)
+            return FALSE;
+    }
+
+    if (query->distinct_words && query->n_needles > 1) {
+        const gchar **used = g_newa (const gchar *, query->n_needles);
+
+        return query_match_distinct (query, haystack, 0, used);
+    }
+
+    return TRUE;
+}
+
+struct _HildonHelperSectionIndex
+{
+    GPtrArray *labels;
+    GArray *rows;
+    GHashTable *sections;
+};
+
+static gchar *
+section_label_for_string (const gchar *string)
+{
+    gunichar c;
+    gchar buf[7];
+    gint len;
+
+    if (string == NULL || *string == '\0')
+        return g_strdup ("#");
+
+    c = g_utf8_get_char_validated (string, -1);
+    if (c == (gunichar) -1 || c == (gunichar) -2 || !g_unichar_isalpha (c))
+        return g_strdup ("#");
+
+    len = g_unichar_to_utf8 (g_unichar_toupper (c), buf);
+
+    return g_strndup (buf, len);
+}
+
+/**
+ * hildon_helper_section_index_new:
+ * @model: a list #GtkTreeModel, sorted on @column
+ * @column: a string column of @model
+ *
+ * Builds an index of the sections of @model, one per distinct uppercase
+ * first letter of @column. Rows not starting with a letter are grouped
+ * in a "#" section. The model is walked only once; afterwards the first
+ * row of any section is found in constant time, which makes it suitable
+ * for an alphabet strip next to a list using
+ * hildon_helper_set_thumb_scrollbar().
+ *
+ * The index is not updated when @model changes. Build a new one after
+ * the model has been modified.
+ *
+ * Returns: a newly allocated #HildonHelperSectionIndex. Free it with
+ * hildon_helper_section_index_free().
+ *
+ * Since: 3.0
+ **/
+HildonHelperSectionIndex *
+hildon_helper_section_index_new (GtkTreeModel *model,
+                                 gint column)
+{
+    HildonHelperSectionIndex *index;
+    GtkTreeIter iter;
+    gboolean valid;
+    gint row = 0;
+
+    g_return_val_if_fail (GTK_IS_TREE_MODEL (model), NULL);
+    g_return_val_if_fail (column >= 0 && column < gtk_tree_model_get_n_columns (model), NULL);
+
+    index = g_slice_new (HildonHelperSectionIndex);
+    index->labels = g_ptr_array_new_with_free_func (g_free);
+    index->rows = g_array_new (FALSE, FALSE, sizeof (gint));
+    index->sections = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (valid = gtk_tree_model_get_iter_first (model, &iter); valid;
+         valid = gtk_tree_model_iter_next (model, &iter), row++) {
+        gchar *to_free;
+        gchar *label;
+
+        label = section_label_for_string (hildon_tree_model_peek_string (model, &iter,
+                                                                         column, &to_free));
+        g_free (to_free);
+
+        /* Only the first row of each section is kept, so strays in a
+         * section already seen (like "#" rows) don't split it */
+        if (g_hash_table_lookup_extended (index->sections, label, NULL, NULL)) {
+            g_free (label);
+            continue;
+        }
+
+        g_hash_table_insert (index->sections, label,
+                             GUINT_TO_POINTER (index->labels->len));
+        g_ptr_array_add (index->labels, label);
+        g_array_append_val (index->rows, row);
+    }
+
+    return index;
+}
+
+/**
+ * hildon_helper_section_index_free:
+ * @index: a #HildonHelperSectionIndex
+ *
+ * Frees an index created with hildon_helper_section_index_new().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_helper_section_index_free (HildonHelperSectionIndex *index)
+{
+    if (index == NULL)
+        return;
+
+    g_hash_table_destroy (index->sections);
+    g_ptr_array_free (index->labels, TRUE);
+    g_array_free (index->rows, TRUE);
+    g_slice_free (HildonHelperSectionIndex, index);
+}
+
+/**
+ * hildon_helper_section_index_get_n_sections:
+ * @index: a #HildonHelperSectionIndex
+ *
+ * Returns: the number of sections in @index.
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_helper_section_index_get_n_sections (const HildonHelperSectionIndex *index)
+{
+    g_return_val_if_fail (index != NULL, 0);
+
+    return index->labels->len;
+}
+
+/**
+ * hildon_helper_section_index_get_label:
+ * @index: a #HildonHelperSectionIndex
+ * @section: a section number
+ *
+ * Returns: the label of @section, owned by @index, or %NULL if there
+ * is no such section. Sections keep the order of the model.
+ *
+ * Since: 3.0
+ **/
+const gchar *
+hildon_helper_section_index_get_label (const HildonHelperSectionIndex *index,
+                                       guint section)
+{
+    g_return_val_if_fail (index != NULL, NULL);
+
+    if (section >= index->labels->len)
+        return NULL;
+
+    return g_ptr_array_index (index->labels, section);
+}
+
+/**
+ * hildon_helper_section_index_lookup:
+ * @index: a #HildonHelperSectionIndex
+ * @label: a section label, like "A"
+ *
+ * Finds the section labelled @label. Lowercase letters find the
+ * section of their uppercase counterpart.
+ *
+ * Returns: the section number, or -1 if no row starts with @label.
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_helper_section_index_lookup (const HildonHelperSectionIndex *index,
+                                    const gchar *label)
+{
+    gchar *key;
+    gpointer section;
+    gboolean found;
+
+    g_return_val_if_fail (index != NULL, -1);
+    g_return_val_if_fail (label != NULL, -1);
+
+    key = section_label_for_string (label);
+    found = g_hash_table_lookup_extended (index->sections, key, NULL, &section);
+    g_free (key);
+
+    return found ? (gint) GPOINTER_TO_UINT (section) : -1;
+}
+
+/**
+ * hildon_helper_section_index_get_row:
+ * @index: a #HildonHelperSectionIndex
+ * @section: a section number
+ *
+ * Returns: the model row where @section starts, or -1 if there is
+ * no such section.
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_helper_section_index_get_row (const HildonHelperSectionIndex *index,
+                                     guint section)
+{
+    g_return_val_if_fail (index != NULL, -1);
+
+    if (section >= index->rows->len)
+        return -1;
+
+    return g_array_index (index->rows, gint, section);
+}
+
+/**
+ * hildon_helper_section_index_jump:
+ * @index: a #HildonHelperSectionIndex
+ * @treeview: the #GtkTreeView showing the model @index was built from
+ * @section: a section number
+ *
+ * Scrolls @treeview so that the first row of @section is at the top,
+ * without any animation. If @treeview is inside a #HildonPannableArea,
+ * hildon_pannable_area_jump_to() is used.
+ *
+ * When @treeview is in fixed height mode (see
+ * gtk_tree_view_set_fixed_height_mode()), the offset of the row is known
+ * without measuring the rows above it, so jumping costs the same
+ * whatever the section. This is what makes an index strip usable on
+ * very long lists.
+ *
+ * Returns: %TRUE if @section exists and @treeview was scrolled.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_helper_section_index_jump (const HildonHelperSectionIndex *index,
+                                  GtkTreeView *treeview,
+                                  guint section)
+{
+    GtkTreePath *path;
+    GtkWidget *area;
+    GdkRectangle rect;
+    gint y;
+
+    g_return_val_if_fail (index != NULL, FALSE);
+    g_return_val_if_fail (GTK_IS_TREE_VIEW (treeview), FALSE);
+
+    if (section >= index->rows->len || gtk_tree_view_get_model (treeview) == NULL)
+        return FALSE;
+
+    path = gtk_tree_path_new_from_indices (g_array_index (index->rows, gint, section), -1);
+    gtk_tree_view_get_background_area (treeview, path, NULL, &rect);
+    gtk_tree_path_free (path);
+
+    gtk_tree_view_convert_bin_window_to_tree_coords (treeview, 0, rect.y, NULL, &y);
+
+    area = gtk_widget_get_ancestor (GTK_WIDGET (treeview), HILDON_TYPE_PANNABLE_AREA);
+    if (area != NULL && gtk_widget_get_realized (area)) {
+        GtkAdjustment *vadj;
+
+        /* hildon_pannable_area_jump_to() centers the point it is given */
+        vadj = hildon_pannable_area_get_vadjustment (HILDON_PANNABLE_AREA (area));
+        hildon_pannable_area_jump_to (HILDON_PANNABLE_AREA (area), -1,
+                                      y + gtk_adjustment_get_page_size (vadj) / 2);
+    } else
+        gtk_tree_view_scroll_to_point (treeview, -1, y);
+
+    return TRUE;
+}
@@ -32,6 +32,12 @@
 
 G_BEGIN_DECLS
 
+typedef struct                                  _HildonHelperNeedle HildonHelperNeedle;
+
+typedef struct                                  _HildonHelperQuery HildonHelperQuery;
+
+typedef struct                                  _HildonHelperSectionIndex HildonHelperSectionIndex;
+
 gulong
 hildon_helper_set_logical_font                  (GtkWidget *widget, 
                                                  const gchar *logicalfontname);
@@ -51,6 +57,11 @@ hildon_helper_set_thumb_scrollbar               (GtkScrolledWindow *win,
 gchar *
 hildon_format_file_size_for_display             (goffset size);
 
+gint
+hildon_format_file_size_to_buffer               (goffset size,
+                                                 gchar *buffer,
+                                                 gsize buffer_size);
+
 const gchar *
 hildon_helper_utf8_strstrcasedecomp_needle_stripped (const gchar *haystack,
 						     const gunichar *nuni);
@@ -58,13 +69,75 @@ hildon_helper_utf8_strstrcasedecomp_needle_stripped (const gchar *haystack,
 gunichar *
 hildon_helper_strip_string                      (const gchar *string);
 
+gunichar **
+hildon_helper_strip_strings                     (const gchar * const *strings);
+
 gchar *
 hildon_helper_normalize_string                  (const gchar *string);
 
+gssize
+hildon_helper_normalize_string_to_buffer        (const gchar *string,
+                                                 gchar *buffer,
+                                                 gsize buffer_size);
+
+gchar **
+hildon_helper_normalize_strings                 (const gchar * const *strings);
+
 gchar *
 hildon_helper_smart_match                       (const gchar *haystack,
                                                  const gchar *needle);
 
+HildonHelperNeedle *
+hildon_helper_needle_new                        (const gchar *needle);
+
+void
+hildon_helper_needle_free                       (HildonHelperNeedle *needle);
+
+gchar *
+hildon_helper_smart_match_needle                (const gchar *haystack,
+                                                 const HildonHelperNeedle *needle);
+
+HildonHelperQuery *
+hildon_helper_query_new                         (const gchar *text,
+                                                 gboolean distinct_words);
+
+void
+hildon_helper_query_free                        (HildonHelperQuery *query);
+
+gboolean
+hildon_helper_query_is_empty                    (const HildonHelperQuery *query);
+
+gboolean
+hildon_helper_query_match                       (const HildonHelperQuery *query,
+                                                 const gchar *haystack);
+
+HildonHelperSectionIndex *
+hildon_helper_section_index_new                 (GtkTreeModel *model,
+                                                 gint column);
+
+void
+hildon_helper_section_index_free                (HildonHelperSectionIndex *index);
+
+guint
+hildon_helper_section_index_get_n_sections      (const HildonHelperSectionIndex *index);
+
+const gchar *
+hildon_helper_section_index_get_label           (const HildonHelperSectionIndex *index,
+                                                 guint section);
+
+gint
+hildon_helper_section_index_lookup              (const HildonHelperSectionIndex *index,
+                                                 const gchar *label);
+
+gint
+hildon_helper_section_index_get_row             (const HildonHelperSectionIndex *index,
+                                                 guint section);
+
+gboolean
+hildon_helper_section_index_jump                (const HildonHelperSectionIndex *index,
+                                                 GtkTreeView *treeview,
+                                                 guint section);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_HELPER_H__ */
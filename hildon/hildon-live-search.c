@@ -37,6 +37,7 @@
  */
 
 #include                                        "hildon-live-search.h"
+#include                                        "hildon-private.h"
 
 #include                                        <hildon/hildon.h>
 #include                                        <string.h>
@@ -48,6 +49,15 @@ G_DEFINE_TYPE (HildonLiveSearch, hildon_live_search, GTK_TYPE_TOOLBAR);
                                                 HILDON_TYPE_LIVE_SEARCH,           \
                                                 HildonLiveSearchPrivate))
 
+/* What the visible function of a filter answers while a chunked
+ * refilter makes the child model announce a row: @visible, instead
+ * of matching the row again, if @applying. */
+typedef struct
+{
+    gboolean visible;
+    gboolean applying;
+} HildonLiveSearchChunk;
+
 struct _HildonLiveSearchPrivate
 {
     GtkTreeModelFilter *filter;
@@ -58,10 +68,26 @@ struct _HildonLiveSearchPrivate
     GtkWidget *event_widget;
     GHashTable *selection_map;
 
+    /* Selection map for list models, the sorted positions of the
+       selected child model rows */
+    GArray *selection_rows;
+    GtkTreeModel *selection_model;
+    gulong selection_inserted_id;
+    gulong selection_deleted_id;
+    gulong selection_reordered_id;
+
+    /* Rows of the tree view model and of the child model, mapped both
+       ways while the selection is saved or restored, see
+       selection_flags_map_build() */
+    GArray *view_to_base;
+    GArray *base_to_view;
+    gboolean view_map_valid;
+
     gulong key_press_id;
     gulong event_widget_destroy_id;
     gulong kb_focus_widget_destroy_id;
-    gulong idle_filter_id;
+    guint idle_filter_id;
+    guint entry_update_id;
 
     gchar *prefix;
     gint text_column;
@@ -71,8 +97,119 @@ struct _HildonLiveSearchPrivate
     GDestroyNotify visible_destroy;
     gboolean visible_func_set;
     gboolean run_async;
+
+    /* Normalized key index, see hildon_live_search_set_use_index() */
+    gboolean use_index;
+    gboolean index_refiltering;
+    GtkTreeModel *index_model;
+    GPtrArray *index_rows;
+    GHashTable *index_map;
+    GString *index_pool;
+    gsize index_waste;
+    gchar *index_prefix;
+    guint index_serial;
+    GQueue *match_history;
+    gulong index_inserted_id;
+    gulong index_changed_id;
+    gulong index_deleted_id;
+    gulong index_reordered_id;
+
+    /* Substring matching, see hildon_live_search_set_match_substrings() */
+    gboolean match_substrings;
+    GHashTable *trigrams;
+
+    /* See hildon_live_search_set_parallel_match() */
+    gboolean parallel_match;
+
+    /* Chunked refilter, see HildonLiveSearch:refilter-chunk-size */
+    guint chunk_size;
+    guint chunk_time;
+    guint chunk_id;
+    gint chunk_pos;
+    gboolean chunk_restart;
+    HildonLiveSearchChunk chunk_state;
+    GtkTreeModel *chunk_model;
+    gulong chunk_inserted_id;
+    gulong chunk_deleted_id;
+    gulong chunk_reordered_id;
+
+    /* Extra filters, see hildon_live_search_add_filter() */
+    GPtrArray *sections;
+    guint sections_last;
+    guint sections_id;
+
+    /* Matched part of the rows, see hildon_live_search_get_match() */
+    GHashTable *spans;
+    gchar *span_prefix;
+
+    /* Best rows, see hildon_live_search_set_max_ranked_results() */
+    guint ranked_max;
+    gboolean ranking;
+    GArray *ranked_heap;
+    GtkListStore *ranked_store;
+    guint ranked_seq;
+    guint n_matches;
+};
+
+/* How well a row matched, lower is better */
+enum
+{
+    RANK_EXACT,
+    RANK_PREFIX,
+    RANK_WORD_START,
+    RANK_SUBSTRING
 };
 
+/* A row of the ranked heap. @seq is the position of the row among the
+ * ones visited by the refilter, so ties keep the order of the model. */
+typedef struct
+{
+    guint score;
+    guint seq;
+    GtkTreePath *path;
+} HildonLiveSearchRanked;
+
+/* Where the prefix matched the text of a row, in bytes. @hash is the
+ * hash of the text the span was computed for. Spans are keyed by the
+ * user_data of the row, and only kept for the rows of the indexed
+ * model, whose row-deleted handler drops them. */
+typedef struct
+{
+    guint hash;
+    gint start;
+    gint end;
+} HildonLiveSearchSpan;
+
+/* One row of the normalized key index. @row is the user_data of the
+ * row's iter, which is stable for GTK_TREE_MODEL_ITERS_PERSIST models.
+ * The key itself lives in the shared key pool at @offset. The row
+ * matches the current prefix if @serial equals the index serial. */
+typedef struct
+{
+    gpointer row;
+    gsize offset;
+    gsize length;
+    guint serial;
+} HildonLiveSearchIndexEntry;
+
+/* The rows matched by one prefix. The match history keeps the most
+ * recently used of these, the last one at its tail. */
+typedef struct
+{
+    gchar *prefix;
+    GPtrArray *rows;
+} HildonLiveSearchMatchSet;
+
+#define                                         MATCH_HISTORY_MAX 32
+
+#define                                         INDEX_NO_KEY G_MAXSIZE
+
+/* Packs the three bytes at @p into a non-zero hash key */
+#define                                         TRIGRAM_KEY(p) \
+    GUINT_TO_POINTER (((guint) ((const guchar *) (p))[0] << 16) | \
+                      ((guint) ((const guchar *) (p))[1] << 8) |  \
+                      (guint) ((const guchar *) (p))[2])
+
 enum
 {
     PROP_0,
@@ -80,7 +217,13 @@ enum
     PROP_FILTER,
     PROP_WIDGET,
     PROP_TEXT_COLUMN,
-    PROP_TEXT
+    PROP_TEXT,
+    PROP_USE_INDEX,
+    PROP_REFILTER_CHUNK_SIZE,
+    PROP_REFILTER_CHUNK_TIME,
+    PROP_MATCH_SUBSTRINGS,
+    PROP_PARALLEL_MATCH,
+    PROP_MAX_RANKED_RESULTS
 };
 
 enum
@@ -132,20 +275,155 @@ key_equal_func                                  (gconstpointer v1,
     return ret;
 }
 
+/**
+ * selection_rows_find:
+ * @rows: the sorted positions of the selected rows
+ * @len: how many of @rows to look at
+ * @pos: a row of the child model
+ * @index: return location for the index of @pos in @rows, or of the
+ * first position after it
+ *
+ * Returns: %TRUE if @pos is one of the first @len @rows.
+ **/
+static gboolean
+selection_rows_find                             (GArray                  *rows,
+                                                 guint                    len,
+                                                 gint                     pos,
+                                                 guint                   *index)
+{
+    guint lo = 0, hi = len;
+
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+
+        if (g_array_index (rows, gint, mid) < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *index = lo;
+
+    return lo < len && g_array_index (rows, gint, lo) == pos;
+}
+
+static void
+on_selection_row_inserted                       (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 GtkTreeIter             *iter,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    GArray *rows = priv->selection_rows;
+    guint i;
+
+    selection_rows_find (rows, rows->len,
+                         gtk_tree_path_get_indices (path)[0], &i);
+    for (; i < rows->len; i++)
+        g_array_index (rows, gint, i)++;
+}
+
+static void
+on_selection_row_deleted                        (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    GArray *rows = priv->selection_rows;
+    guint i;
+
+    if (selection_rows_find (rows, rows->len,
+                             gtk_tree_path_get_indices (path)[0], &i))
+        g_array_remove_index (rows, i);
+    for (; i < rows->len; i++)
+        g_array_index (rows, gint, i)--;
+}
+
+static gint
+selection_rows_compare                          (gconstpointer            a,
+                                                 gconstpointer            b)
+{
+    gint pos_a = *(const gint *) a;
+    gint pos_b = *(const gint *) b;
+
+    return pos_a < pos_b ? -1 : pos_a > pos_b;
+}
+
+static void
+on_selection_rows_reordered                     (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 GtkTreeIter             *iter,
+                                                 gint                    *new_order,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    GArray *rows = priv->selection_rows;
+    gint n_rows, *old_to_new;
+    guint i;
+
+    if (rows->len == 0)
+        return;
+
+    n_rows = gtk_tree_model_iter_n_children (model, NULL);
+    old_to_new = g_new (gint, n_rows);
+    for (i = 0; i < (guint) n_rows; i++)
+        old_to_new[new_order[i]] = i;
+
+    for (i = 0; i < rows->len; i++)
+        g_array_index (rows, gint, i) = old_to_new[g_array_index (rows, gint, i)];
+    g_array_sort (rows, selection_rows_compare);
+
+    g_free (old_to_new);
+}
+
+/**
+ * selection_map_exists:
+ * @priv: The private pimpl
+ *
+ * Returns: %TRUE if a selection map, of either kind, was created.
+ **/
+static gboolean
+selection_map_exists                            (HildonLiveSearchPrivate *priv)
+{
+    return priv->selection_map != NULL || priv->selection_rows != NULL;
+}
+
 /**
  * selection_map_create:
  * @priv: The private pimpl
  *
  * Adds a selection map which is useful when merging selected rows in
  * a treeview, when the live search widget is used.
+ *
+ * For list models the map is the sorted array of the selected child
+ * model rows, kept in sync with the model signals, so that saving and
+ * restoring the selection only visits the selected rows. Other models
+ * use a hash table of #GtkTreeRowReference.
  **/
 static void
 selection_map_create                            (HildonLiveSearchPrivate *priv)
 {
+    GtkTreeModel *base_model;
+
     if (!GTK_IS_TREE_VIEW (priv->kb_focus_widget))
         return;
 
-    g_assert (priv->selection_map == NULL);
+    g_assert (!selection_map_exists (priv));
+
+    base_model = gtk_tree_model_filter_get_model (priv->filter);
+
+    if (gtk_tree_model_get_flags (base_model) & GTK_TREE_MODEL_LIST_ONLY) {
+        priv->selection_rows = g_array_new (FALSE, FALSE, sizeof (gint));
+        priv->selection_model = g_object_ref (base_model);
+
+        priv->selection_inserted_id =
+            g_signal_connect (base_model, "row-inserted",
+                              G_CALLBACK (on_selection_row_inserted), priv);
+        priv->selection_deleted_id =
+            g_signal_connect (base_model, "row-deleted",
+                              G_CALLBACK (on_selection_row_deleted), priv);
+        priv->selection_reordered_id =
+            g_signal_connect (base_model, "rows-reordered",
+                              G_CALLBACK (on_selection_rows_reordered), priv);
+        return;
+    }
 
     priv->selection_map = g_hash_table_new_full
         (hash_func, key_equal_func,
@@ -166,6 +444,28 @@ selection_map_destroy                           (HildonLiveSearchPrivate *priv)
         g_hash_table_destroy (priv->selection_map);
         priv->selection_map = NULL;
     }
+
+    if (priv->selection_rows != NULL) {
+        g_signal_handler_disconnect (priv->selection_model,
+                                     priv->selection_inserted_id);
+        g_signal_handler_disconnect (priv->selection_model,
+                                     priv->selection_deleted_id);
+        g_signal_handler_disconnect (priv->selection_model,
+                                     priv->selection_reordered_id);
+        g_object_unref (priv->selection_model);
+        priv->selection_model = NULL;
+
+        g_array_free (priv->selection_rows, TRUE);
+        priv->selection_rows = NULL;
+    }
+
+    if (priv->view_to_base != NULL) {
+        g_array_free (priv->view_to_base, TRUE);
+        g_array_free (priv->base_to_view, TRUE);
+        priv->view_to_base = NULL;
+        priv->base_to_view = NULL;
+        priv->view_map_valid = FALSE;
+    }
 }
 
 static GtkTreePath *
@@ -245,6 +545,233 @@ row_reference_is_not_selected (GtkTreeRowReference *row_ref,
 }
 
 
+/* Selected rows from which mapping the whole view beats converting
+ * their paths one by one through a sort model */
+#define                                         VIEW_MAP_MIN_ROWS 16
+
+/**
+ * selection_flags_map_build:
+ * @priv: The private pimpl
+ *
+ * Maps the rows of the tree view model to the rows of the child model
+ * and back, with one walk over the tree view model. Converting a child
+ * path through a #GtkTreeModelSort looks for the row in the whole
+ * level, so for more than a few selected rows the two arrays make
+ * saving and restoring the selection linear instead of quadratic.
+ * The map is only valid until the models change.
+ **/
+static void
+selection_flags_map_build                       (HildonLiveSearchPrivate *priv)
+{
+    GtkTreeModel *view_model;
+    GtkTreeIter view_iter, filter_iter, base_iter;
+    gboolean valid;
+    gint view_pos = 0;
+
+    priv->view_map_valid = FALSE;
+
+    view_model = gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget));
+    if (!GTK_IS_TREE_MODEL_SORT (view_model) ||
+        priv->selection_rows->len < VIEW_MAP_MIN_ROWS)
+        return;
+
+    if (priv->view_to_base == NULL) {
+        priv->view_to_base = g_array_new (FALSE, FALSE, sizeof (gint));
+        priv->base_to_view = g_array_new (FALSE, FALSE, sizeof (gint));
+    }
+
+    g_array_set_size (priv->view_to_base, 0);
+    g_array_set_size (priv->base_to_view,
+                      gtk_tree_model_iter_n_children (priv->selection_model, NULL));
+    memset (priv->base_to_view->data, 0xff, priv->base_to_view->len * sizeof (gint));
+
+    for (valid = gtk_tree_model_get_iter_first (view_model, &view_iter);
+         valid;
+         valid = gtk_tree_model_iter_next (view_model, &view_iter)) {
+        GtkTreePath *base_path;
+        gint pos;
+
+        gtk_tree_model_sort_convert_iter_to_child_iter (GTK_TREE_MODEL_SORT (view_model),
+                                                        &filter_iter, &view_iter);
+        gtk_tree_model_filter_convert_iter_to_child_iter (priv->filter,
+                                                          &base_iter, &filter_iter);
+        base_path = gtk_tree_model_get_path (priv->selection_model, &base_iter);
+        pos = gtk_tree_path_get_indices (base_path)[0];
+        gtk_tree_path_free (base_path);
+
+        g_array_append_val (priv->view_to_base, pos);
+        g_array_index (priv->base_to_view, gint, pos) = view_pos++;
+    }
+
+    priv->view_map_valid = TRUE;
+}
+
+/**
+ * selection_flags_get_view_path:
+ * @priv: The private pimpl
+ * @pos: a row of the child model
+ *
+ * Returns: the path of @pos in the tree view model, or %NULL if the
+ * row is filtered out.
+ **/
+static GtkTreePath *
+selection_flags_get_view_path                   (HildonLiveSearchPrivate *priv,
+                                                 gint                     pos)
+{
+    GtkTreePath *base_path, *filter_path, *view_path;
+
+    if (priv->view_map_valid) {
+        gint view_pos = g_array_index (priv->base_to_view, gint, pos);
+
+        return view_pos < 0 ? NULL : gtk_tree_path_new_from_indices (view_pos, -1);
+    }
+
+    base_path = gtk_tree_path_new_from_indices (pos, -1);
+    filter_path = gtk_tree_model_filter_convert_child_path_to_path
+        (priv->filter, base_path);
+    gtk_tree_path_free (base_path);
+
+    if (filter_path == NULL)
+        return NULL;
+
+    view_path = convert_child_path_to_path (
+        gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)),
+        GTK_TREE_MODEL (priv->filter), filter_path);
+    gtk_tree_path_free (filter_path);
+
+    return view_path;
+}
+
+/**
+ * selection_flags_get_pos:
+ * @priv: The private pimpl
+ * @view_path: a path in the tree view model
+ *
+ * Returns: the row of the child model shown at @view_path.
+ **/
+static gint
+selection_flags_get_pos                         (HildonLiveSearchPrivate *priv,
+                                                 GtkTreePath             *view_path)
+{
+    GtkTreePath *base_path, *filter_path;
+    gint pos;
+
+    if (priv->view_map_valid)
+        return g_array_index (priv->view_to_base, gint,
+                              gtk_tree_path_get_indices (view_path)[0]);
+
+    filter_path = convert_path_to_child_path (
+        gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)),
+        GTK_TREE_MODEL (priv->filter), view_path);
+    base_path = gtk_tree_model_filter_convert_path_to_child_path
+        (priv->filter, filter_path);
+    pos = gtk_tree_path_get_indices (base_path)[0];
+
+    gtk_tree_path_free (filter_path);
+    gtk_tree_path_free (base_path);
+
+    return pos;
+}
+
+/**
+ * selection_flags_update_from_selection:
+ * @priv: The private pimpl
+ *
+ * Same as selection_map_update_map_from_selection(), for the list
+ * based selection map. Only the rows in the map and the selected
+ * rows are visited.
+ **/
+static void
+selection_flags_update_from_selection           (HildonLiveSearchPrivate *priv)
+{
+    GtkTreeSelection *selection;
+    GList *selected_list, *l_iter;
+    GArray *rows = priv->selection_rows;
+    guint i, kept = 0;
+
+    selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->kb_focus_widget));
+    selection_flags_map_build (priv);
+
+    /* Forget the visible rows which are not selected anymore; rows
+       filtered out keep their state */
+    for (i = 0; i < rows->len; i++) {
+        gint pos = g_array_index (rows, gint, i);
+        GtkTreePath *view_path;
+
+        view_path = selection_flags_get_view_path (priv, pos);
+        if (view_path != NULL) {
+            gboolean selected = gtk_tree_selection_path_is_selected (selection,
+                                                                     view_path);
+
+            gtk_tree_path_free (view_path);
+            if (!selected)
+                continue;
+        }
+
+        g_array_index (rows, gint, kept++) = pos;
+    }
+    g_array_set_size (rows, kept);
+
+    /* Add the selected rows which are not in the map yet, then sort
+       them all at once */
+    selected_list = gtk_tree_selection_get_selected_rows (selection, NULL);
+    for (l_iter = selected_list; l_iter; l_iter = g_list_next (l_iter)) {
+        gint pos = selection_flags_get_pos (priv, l_iter->data);
+
+        if (!selection_rows_find (rows, kept, pos, &i))
+            g_array_append_val (rows, pos);
+        gtk_tree_path_free (l_iter->data);
+    }
+    g_list_free (selected_list);
+
+    if (rows->len > kept)
+        g_array_sort (rows, selection_rows_compare);
+
+    priv->view_map_valid = FALSE;
+}
+
+/**
+ * selection_flags_update_selection:
+ * @priv: The private pimpl
+ *
+ * Same as selection_map_update_selection_from_map(), for the list
+ * based selection map.
+ **/
+static void
+selection_flags_update_selection                (HildonLiveSearchPrivate *priv)
+{
+    GtkTreeSelection *selection;
+    GList *selected_list, *l_iter;
+    GArray *rows = priv->selection_rows;
+    guint i;
+
+    selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->kb_focus_widget));
+    selection_flags_map_build (priv);
+
+    /* unselect things which are not in the map */
+    selected_list = gtk_tree_selection_get_selected_rows (selection, NULL);
+    for (l_iter = selected_list; l_iter; l_iter = g_list_next (l_iter)) {
+        if (!selection_rows_find (rows, rows->len,
+                                  selection_flags_get_pos (priv, l_iter->data), &i))
+            gtk_tree_selection_unselect_path (selection, l_iter->data);
+        gtk_tree_path_free (l_iter->data);
+    }
+    g_list_free (selected_list);
+
+    /* select the visible rows in the map */
+    for (i = 0; i < rows->len; i++) {
+        GtkTreePath *view_path;
+
+        view_path = selection_flags_get_view_path (priv, g_array_index (rows, gint, i));
+        if (view_path != NULL) {
+            gtk_tree_selection_select_path (selection, view_path);
+            gtk_tree_path_free (view_path);
+        }
+    }
+
+    priv->view_map_valid = FALSE;
+}
+
 /**
  * selection_map_update_map_from_selection:
  * @priv: The private pimpl
@@ -262,6 +789,11 @@ selection_map_update_map_from_selection         (HildonLiveSearchPrivate *priv)
     if (!GTK_IS_TREE_VIEW (priv->kb_focus_widget))
         return;
 
+    if (priv->selection_rows != NULL) {
+        selection_flags_update_from_selection (priv);
+        return;
+    }
+
     base_model = gtk_tree_model_filter_get_model (priv->filter);
     selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->kb_focus_widget));
 
@@ -321,6 +853,11 @@ selection_map_update_selection_from_map         (HildonLiveSearchPrivate *priv)
     if (!GTK_IS_TREE_VIEW (priv->kb_focus_widget))
         return;
 
+    if (priv->selection_rows != NULL) {
+        selection_flags_update_selection (priv);
+        return;
+    }
+
     selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->kb_focus_widget));
 
     /* unselect things which are not in priv->selection_map */
@@ -372,858 +909,3326 @@ selection_map_update_selection_from_map         (HildonLiveSearchPrivate *priv)
     }
 }
 
-static void
-refilter (HildonLiveSearch *livesearch)
+static gchar *
+index_normalize_key                             (const gchar *string)
 {
-    HildonLiveSearchPrivate *priv = livesearch->priv;
-    gboolean handled = FALSE;
-    gboolean needs_mapping;
-
-    needs_mapping = GTK_IS_TREE_VIEW (priv->kb_focus_widget) &&
-        gtk_tree_selection_get_mode (gtk_tree_view_get_selection (
-                                         GTK_TREE_VIEW (priv->kb_focus_widget))) != GTK_SELECTION_NONE;
+    if (string == NULL)
+        return NULL;
 
-    /* This is not pretty code, but it should fix some warnings in the case we
-       attempt to refilter before the treeview actually has a model. */
-    if (needs_mapping && !gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)))
-        return;
-
-    /* Create/update selection map from current selection */
-    if (needs_mapping) {
-        if (priv->selection_map == NULL)
-            selection_map_create (priv);
-        selection_map_update_map_from_selection (priv);
-    }
-
-    /* Filter the model */
-    g_signal_emit (livesearch, signals[REFILTER], 0, &handled);
-    if (!handled && priv->filter)
-        gtk_tree_model_filter_refilter (priv->filter);
-
-    /* Restore selection from mapping */
-    if (needs_mapping)
-        selection_map_update_selection_from_map (priv);
+    return g_utf8_normalize (string, -1, G_NORMALIZE_DEFAULT);
 }
 
 static gboolean
-on_idle_refilter (HildonLiveSearch *livesearch)
+index_is_usable                                 (HildonLiveSearchPrivate *priv,
+                                                 GtkTreeModel            *model)
 {
-    refilter (livesearch);
+    GtkTreeModelFlags flags;
 
-    if (livesearch->priv->prefix == NULL)
-        selection_map_destroy (livesearch->priv);
+    if (!priv->use_index || model == NULL ||
+        priv->visible_func != NULL || priv->text_column < 0)
+        return FALSE;
 
-    livesearch->priv->idle_filter_id = 0;
+    flags = gtk_tree_model_get_flags (model);
 
-    return FALSE;
+    return (flags & GTK_TREE_MODEL_LIST_ONLY) &&
+        (flags & GTK_TREE_MODEL_ITERS_PERSIST);
 }
 
 static void
-on_entry_changed                                (GtkEntry *entry,
-                                                 gpointer  user_data)
+index_pool_compact                              (HildonLiveSearchPrivate *priv)
 {
-    HildonLiveSearch *livesearch = user_data;
-    HildonLiveSearchPrivate *priv;
-    const char *text;
-    glong len;
-
-    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    priv = livesearch->priv;
+    GString *pool;
+    guint i;
 
-    text = gtk_entry_get_text (GTK_ENTRY (entry));
-    len = g_utf8_strlen (text, -1);
-    if (len < 1) {
-        text = NULL;
-    }
+    pool = g_string_sized_new (priv->index_pool->len - priv->index_waste);
 
-    g_free (priv->prefix);
-    priv->prefix = g_strdup (text);
+    for (i = 0; i < priv->index_rows->len; i++) {
+        HildonLiveSearchIndexEntry *entry = g_ptr_array_index (priv->index_rows, i);
 
-    if (priv->run_async) {
-        if (priv->idle_filter_id == 0) {
-            priv->idle_filter_id = gdk_threads_add_idle ((GSourceFunc) on_idle_refilter, livesearch);
-        }
-    } else {
-        if (priv->idle_filter_id != 0) {
-            g_source_remove (priv->idle_filter_id);
-            priv->idle_filter_id = 0;
-        }
-        on_idle_refilter (livesearch);
-    }
+        if (entry->offset == INDEX_NO_KEY)
+            continue;
 
-    /* Show the livesearch only if there is text in it */
-    if (priv->prefix == NULL) {
-        gtk_widget_hide (GTK_WIDGET (livesearch));
-    } else {
-        gtk_widget_show (GTK_WIDGET (livesearch));
+        g_string_append_len (pool, priv->index_pool->str + entry->offset,
+                             entry->length + 1);
+        entry->offset = pool->len - entry->length - 1;
     }
 
-    /* Any change in the entry implies a change in HildonLiveSearch:text. */
-    g_object_notify (G_OBJECT (livesearch), "text");
+    g_string_free (priv->index_pool, TRUE);
+    priv->index_pool = pool;
+    priv->index_waste = 0;
 }
 
 /**
- * hildon_live_search_append_text:
- * @livesearch: An #HildonLiveSearch widget
- * @text: Text to append. @text is copied internally
- * can be freed later by the caller.
- *
- * Appends a string to the entry text in the live search widget.
+ * index_key_matches:
+ * @priv: The private pimpl
+ * @key: a normalized key
+ * @text: the normalized text to look for
  *
- * Since: 2.2.4
+ * This is the default matching rule: @key must start with @text, or
+ * contain it if #HildonLiveSearch:match-substrings is set.
  **/
-void
-hildon_live_search_append_text                  (HildonLiveSearch *livesearch,
-                                                 const char       *text)
+static gboolean
+index_key_matches                               (HildonLiveSearchPrivate *priv,
+                                                 const gchar             *key,
+                                                 const gchar             *text)
 {
-    GtkEditable *editable;
-    int pos, start, end;
-
-    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    g_return_if_fail (NULL != text);
+    if (priv->match_substrings)
+        return strstr (key, text) != NULL;
 
-    editable = GTK_EDITABLE (livesearch->priv->entry);
-
-    if (gtk_editable_get_selection_bounds (editable, &start, &end)) {
-        gtk_editable_delete_text (editable, start, end);
-    }
-    pos = gtk_editable_get_position (editable);
-    gtk_editable_insert_text (editable, text, strlen (text), &pos);
-    gtk_editable_set_position (editable, pos + 1);
+    return g_str_has_prefix (key, text);
 }
 
 /**
- * hildon_live_search_set_text:
- * @livesearch: An #HildonLiveSearch widget
- * @text: Text to set. @text is copied internally
- * can be freed later by the caller.
- *
- * Sets a string to the entry text in the live search widget.
+ * trigrams_update_entry:
+ * @priv: The private pimpl
+ * @entry: an index entry
+ * @add: whether to add or remove @entry
  *
- * Since: 2.2.15
+ * Adds @entry to, or removes it from, the posting list of every
+ * trigram of its key. This must be called with the key still in the
+ * pool, so removal has to happen before the key is replaced.
  **/
-void
-hildon_live_search_set_text                  (HildonLiveSearch *livesearch,
-                                              const char       *text)
+static void
+trigrams_update_entry                           (HildonLiveSearchPrivate    *priv,
+                                                 HildonLiveSearchIndexEntry *entry,
+                                                 gboolean                    add)
 {
-    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    g_return_if_fail (NULL != text);
+    const gchar *key;
+    gsize i;
 
-    livesearch->priv->run_async = FALSE;
-    gtk_entry_set_text (GTK_ENTRY (livesearch->priv->entry),
-                        text);
-    livesearch->priv->run_async = TRUE;
+    if (priv->trigrams == NULL || entry->offset == INDEX_NO_KEY)
+        return;
 
-    /* GObject::notify::text for HildonLiveSearch:text emitted in the
-       handler for GtkEntry::changed. */
+    key = priv->index_pool->str + entry->offset;
+
+    for (i = 0; i + 2 < entry->length; i++) {
+        gpointer trigram = TRIGRAM_KEY (key + i);
+        GPtrArray *postings = g_hash_table_lookup (priv->trigrams, trigram);
+
+        if (add) {
+            if (postings == NULL) {
+                postings = g_ptr_array_new ();
+                g_hash_table_insert (priv->trigrams, trigram, postings);
+            }
+            /* A trigram repeated in the same key is only listed once */
+            if (postings->len == 0 ||
+                g_ptr_array_index (postings, postings->len - 1) != entry)
+                g_ptr_array_add (postings, entry);
+        } else if (postings != NULL) {
+            g_ptr_array_remove_fast (postings, entry);
+            if (postings->len == 0)
+                g_hash_table_remove (priv->trigrams, trigram);
+        }
+    }
 }
 
 /**
- * hildon_live_search_get_text:
- * @livesearch: An #HildonLiveSearch widget
- *
- * Retrieves the text contents of the #HildonLiveSearch widget.
- *
- * Returns: a pointer to the text contents of the widget as a
- * string. This string should not be freed, modified, or stored.
+ * trigrams_lookup:
+ * @priv: The private pimpl
+ * @text: a normalized text at least three bytes long
  *
- * Since: 2.2.4
+ * Returns: the shortest posting list among the trigrams of @text, or
+ * %NULL if one of them does not appear in any key, in which case no
+ * row can match.
  **/
-const char *
-hildon_live_search_get_text                     (HildonLiveSearch *livesearch)
+static GPtrArray *
+trigrams_lookup                                 (HildonLiveSearchPrivate *priv,
+                                                 const gchar             *text)
 {
-    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), NULL);
+    GPtrArray *shortest = NULL;
+    gsize length = strlen (text);
+    gsize i;
+
+    for (i = 0; i + 2 < length; i++) {
+        GPtrArray *postings = g_hash_table_lookup (priv->trigrams,
+                                                   TRIGRAM_KEY (text + i));
+        if (postings == NULL)
+            return NULL;
+        if (shortest == NULL || postings->len < shortest->len)
+            shortest = postings;
+    }
 
-    return gtk_entry_get_text (GTK_ENTRY (livesearch->priv->entry));
+    return shortest;
 }
 
-/*
- * Key press handler. This takes key presses from the source widget and
- * manipulate the entry. This manipulation then calls #on_entry_changed.
- */
-static gboolean
-on_key_press_event                              (GtkWidget        *widget,
-                                                 GdkEventKey      *event,
-                                                 HildonLiveSearch *live_search)
+static void
+index_entry_set_key                             (HildonLiveSearchPrivate    *priv,
+                                                 HildonLiveSearchIndexEntry *entry,
+                                                 GtkTreeModel               *model,
+                                                 GtkTreeIter                *iter)
 {
-    HildonLiveSearchPrivate *priv;
-    gboolean handled = FALSE;
+    const gchar *string;
+    gchar *string_copy;
+    gchar *key;
+    gsize length;
+
+    string = hildon_tree_model_peek_string (model, iter, priv->text_column, &string_copy);
+    key = index_normalize_key (string);
+    g_free (string_copy);
+
+    trigrams_update_entry (priv, entry, FALSE);
+
+    if (key == NULL) {
+        if (entry->offset != INDEX_NO_KEY)
+            priv->index_waste += entry->length + 1;
+        entry->offset = INDEX_NO_KEY;
+        entry->length = 0;
+        return;
+    }
 
-    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (live_search), FALSE);
-    priv = live_search->priv;
+    length = strlen (key);
 
-    if (gtk_widget_get_visible (priv->kb_focus_widget)) {
-        /* If the live search is hidden, Ctrl+whatever is always
-         * passed to the focus widget, with the exception of
-         * Ctrl + Space, which is given to the entry, so that the input method
-         * is allowed to switch the keyboard layout. */
-        if (gtk_widget_get_visible (GTK_WIDGET (live_search)) ||
-            !(event->state & GDK_CONTROL_MASK ||
-              event->keyval == GDK_KEY_Control_L ||
-              event->keyval == GDK_KEY_Control_R) ||
-            (event->state & GDK_CONTROL_MASK &&
-             event->keyval == GDK_KEY_space)) {
-            GdkEvent *new_event;
+    /* Reuse the old slot when the new key fits in it */
+    if (entry->offset != INDEX_NO_KEY && length <= entry->length) {
+        memcpy (priv->index_pool->str + entry->offset, key, length + 1);
+        priv->index_waste += entry->length - length;
+    } else {
+        if (entry->offset != INDEX_NO_KEY)
+            priv->index_waste += entry->length + 1;
+        entry->offset = priv->index_pool->len;
+        g_string_append_len (priv->index_pool, key, length + 1);
+    }
+    entry->length = length;
 
-            /* If the entry is realized and has focus, it is enough to catch events.
-             * This assumes that the toolbar is a child of the hook widget. */
-            gtk_widget_realize (priv->entry);
-            if (!gtk_widget_has_focus (priv->entry))
-                gtk_widget_grab_focus (priv->entry);
+    trigrams_update_entry (priv, entry, TRUE);
 
-            new_event = gdk_event_copy ((GdkEvent *)event);
-            handled = gtk_widget_event (priv->entry, new_event);
-            gdk_event_free (new_event);
-        } else if (!gtk_widget_has_focus (priv->kb_focus_widget)) {
-            gtk_widget_grab_focus (GTK_WIDGET (priv->kb_focus_widget));
-        }
+    g_free (key);
+}
+
+static HildonLiveSearchIndexEntry *
+index_entry_new                                 (HildonLiveSearchPrivate *priv,
+                                                 GtkTreeModel            *model,
+                                                 GtkTreeIter             *iter)
+{
+    HildonLiveSearchIndexEntry *entry = g_slice_new (HildonLiveSearchIndexEntry);
+
+    entry->row = iter->user_data;
+    entry->offset = INDEX_NO_KEY;
+    entry->length = 0;
+    entry->serial = 0;
+    index_entry_set_key (priv, entry, model, iter);
+
+    g_hash_table_insert (priv->index_map, entry->row, entry);
+
+    return entry;
+}
+
+static void
+index_entry_free                                (HildonLiveSearchIndexEntry *entry)
+{
+    g_slice_free (HildonLiveSearchIndexEntry, entry);
+}
+
+static void
+index_fill                                      (HildonLiveSearchPrivate *priv)
+{
+    GtkTreeIter iter;
+    gboolean valid;
+
+    valid = gtk_tree_model_get_iter_first (priv->index_model, &iter);
+    while (valid) {
+        g_ptr_array_add (priv->index_rows,
+                         index_entry_new (priv, priv->index_model, &iter));
+        valid = gtk_tree_model_iter_next (priv->index_model, &iter);
     }
+}
 
-    return handled;
+static void
+match_set_free                                  (HildonLiveSearchMatchSet *set)
+{
+    g_free (set->prefix);
+    g_ptr_array_free (set->rows, TRUE);
+    g_slice_free (HildonLiveSearchMatchSet, set);
 }
 
+/**
+ * match_history_clear:
+ * @priv: The private pimpl
+ *
+ * Forgets the rows matched by earlier prefixes. This must be done
+ * whenever a row is added, removed or changes its key.
+ **/
 static void
-on_hide_cb                                      (GtkWidget        *widget,
-                                                 HildonLiveSearch *live_search)
+match_history_clear                             (HildonLiveSearchPrivate *priv)
 {
-    hildon_live_search_set_text (live_search, "");
-    gtk_widget_grab_focus (live_search->priv->kb_focus_widget);
+    HildonLiveSearchMatchSet *set;
+
+    if (priv->match_history == NULL)
+        return;
+
+    while ((set = g_queue_pop_head (priv->match_history)) != NULL)
+        match_set_free (set);
 }
 
-/* GObject methods */
+static void
+on_index_row_inserted                           (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 GtkTreeIter             *iter,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    gint pos = gtk_tree_path_get_indices (path)[0];
+
+    g_ptr_array_insert (priv->index_rows, pos,
+                        index_entry_new (priv, model, iter));
+    match_history_clear (priv);
+}
 
 static void
-hildon_live_search_get_property                 (GObject    *object,
-                                                 guint       property_id,
-                                                 GValue     *value,
-                                                 GParamSpec *pspec)
+on_index_row_changed                            (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 GtkTreeIter             *iter,
+                                                 HildonLiveSearchPrivate *priv)
 {
-    HildonLiveSearch *livesearch = HILDON_LIVE_SEARCH (object);
+    HildonLiveSearchIndexEntry *entry;
 
-    switch (property_id) {
-    case PROP_FILTER:
-        g_value_set_object (value, livesearch->priv->filter);
-        break;
-    case PROP_TEXT_COLUMN:
-        g_value_set_int (value, livesearch->priv->text_column);
-        break;
-    case PROP_TEXT:
-        g_value_set_string (value, livesearch->priv->prefix);
-        break;
-    default:
-        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    /* Emitted by a chunked refilter, the key did not change */
+    if (hildon_live_search_is_announcing (model))
+        return;
+
+    entry = g_hash_table_lookup (priv->index_map, iter->user_data);
+    if (entry != NULL) {
+        index_entry_set_key (priv, entry, model, iter);
+        match_history_clear (priv);
     }
 }
 
 static void
-hildon_live_search_set_property                 (GObject      *object,
-                                                 guint         property_id,
-                                                 const GValue *value,
-                                                 GParamSpec   *pspec)
+on_index_row_deleted                            (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 HildonLiveSearchPrivate *priv)
 {
-    HildonLiveSearch *livesearch = HILDON_LIVE_SEARCH (object);
+    HildonLiveSearchIndexEntry *entry;
+    gint pos = gtk_tree_path_get_indices (path)[0];
 
-    switch (property_id) {
-    case PROP_FILTER:
-        hildon_live_search_set_filter (livesearch,
-                                       g_value_get_object (value));
-        break;
-    case PROP_TEXT_COLUMN:
-        hildon_live_search_set_text_column (livesearch,
-                                            g_value_get_int (value));
-        break;
-    case PROP_TEXT:
-        hildon_live_search_set_text (livesearch,
-                                     g_value_get_string (value));
-        break;
-    default:
-        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    g_return_if_fail ((guint) pos < priv->index_rows->len);
+
+    match_history_clear (priv);
+
+    entry = g_ptr_array_index (priv->index_rows, pos);
+    trigrams_update_entry (priv, entry, FALSE);
+    if (entry->offset != INDEX_NO_KEY)
+        priv->index_waste += entry->length + 1;
+    g_hash_table_remove (priv->index_map, entry->row);
+    if (priv->spans != NULL)
+        g_hash_table_remove (priv->spans, entry->row);
+    g_ptr_array_remove_index (priv->index_rows, pos);
+
+    if (priv->index_waste > priv->index_pool->len / 2)
+        index_pool_compact (priv);
+}
+
+static void
+on_index_rows_reordered                         (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 GtkTreeIter             *iter,
+                                                 gint                    *new_order,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    GPtrArray *rows;
+    guint i;
+
+    /* Only the row order changes, keys and pool stay as they are */
+    rows = g_ptr_array_sized_new (priv->index_rows->len);
+    for (i = 0; i < priv->index_rows->len; i++)
+        g_ptr_array_add (rows, g_ptr_array_index (priv->index_rows, new_order[i]));
+
+    memcpy (priv->index_rows->pdata, rows->pdata,
+            rows->len * sizeof (gpointer));
+    g_ptr_array_free (rows, TRUE);
+}
+
+/**
+ * index_destroy:
+ * @priv: The private pimpl
+ *
+ * Drops the normalized key index and disconnects from its model.
+ **/
+static void
+index_destroy                                   (HildonLiveSearchPrivate *priv)
+{
+    if (priv->index_model == NULL)
+        return;
+
+    g_signal_handler_disconnect (priv->index_model, priv->index_inserted_id);
+    g_signal_handler_disconnect (priv->index_model, priv->index_changed_id);
+    g_signal_handler_disconnect (priv->index_model, priv->index_deleted_id);
+    g_signal_handler_disconnect (priv->index_model, priv->index_reordered_id);
+    g_object_unref (priv->index_model);
+    priv->index_model = NULL;
+
+    /* Nothing prunes the spans of deleted rows any more */
+    if (priv->spans != NULL)
+        g_hash_table_remove_all (priv->spans);
+
+    if (priv->trigrams != NULL) {
+        g_hash_table_destroy (priv->trigrams);
+        priv->trigrams = NULL;
+    }
+
+    g_hash_table_destroy (priv->index_map);
+    g_ptr_array_free (priv->index_rows, TRUE);
+    g_string_free (priv->index_pool, TRUE);
+    priv->index_map = NULL;
+    priv->index_rows = NULL;
+    priv->index_pool = NULL;
+    priv->index_waste = 0;
+
+    g_free (priv->index_prefix);
+    priv->index_prefix = NULL;
+    priv->index_serial = 0;
+
+    match_history_clear (priv);
+    g_queue_free (priv->match_history);
+    priv->match_history = NULL;
+}
+
+/**
+ * index_ensure:
+ * @priv: The private pimpl
+ *
+ * Builds the normalized key index for the child model of the filter,
+ * if the index is enabled and the model allows it, and keeps it up to
+ * date through the model signals. The index is dropped otherwise.
+ *
+ * Returns: %TRUE if an index is available.
+ **/
+static gboolean
+index_ensure                                    (HildonLiveSearchPrivate *priv)
+{
+    GtkTreeModel *model;
+
+    model = priv->filter ? gtk_tree_model_filter_get_model (priv->filter) : NULL;
+
+    if (!index_is_usable (priv, model)) {
+        index_destroy (priv);
+        return FALSE;
     }
+
+    if (priv->index_model == model)
+        return TRUE;
+
+    index_destroy (priv);
+
+    priv->index_model = g_object_ref (model);
+    priv->index_rows = g_ptr_array_new_with_free_func ((GDestroyNotify) index_entry_free);
+    priv->index_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+    priv->index_pool = g_string_new (NULL);
+    priv->match_history = g_queue_new ();
+    if (priv->match_substrings)
+        priv->trigrams = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                (GDestroyNotify) g_ptr_array_unref);
+    index_fill (priv);
+
+    priv->index_inserted_id =
+        g_signal_connect (model, "row-inserted",
+                          G_CALLBACK (on_index_row_inserted), priv);
+    priv->index_changed_id =
+        g_signal_connect (model, "row-changed",
+                          G_CALLBACK (on_index_row_changed), priv);
+    priv->index_deleted_id =
+        g_signal_connect (model, "row-deleted",
+                          G_CALLBACK (on_index_row_deleted), priv);
+    priv->index_reordered_id =
+        g_signal_connect (model, "rows-reordered",
+                          G_CALLBACK (on_index_rows_reordered), priv);
+
+    return TRUE;
 }
 
+/* Parallel matching, see hildon_live_search_set_parallel_match(). The
+ * candidates are split in ranges, and each range sets its flags in
+ * @matches. The index is not touched by anybody else meanwhile, since
+ * the main thread waits for all the ranges. */
+typedef struct
+{
+    GMutex lock;
+    GCond done;
+    gint pending;
+    HildonLiveSearchPrivate *priv;
+    const gchar *pool;
+    GPtrArray *candidates;
+    guint8 *matches;
+} HildonLiveSearchMatchBatch;
+
+typedef struct
+{
+    HildonLiveSearchMatchBatch *batch;
+    guint start;
+    guint end;
+} HildonLiveSearchMatchRange;
+
+#define                                         PARALLEL_MATCH_MIN_ROWS 8192
+
+static GThreadPool *match_pool = NULL;
+
 static void
-hildon_live_search_dispose                      (GObject *object)
+match_range                                     (HildonLiveSearchMatchRange *range)
 {
-    HildonLiveSearchPrivate *priv = HILDON_LIVE_SEARCH (object)->priv;
+    HildonLiveSearchMatchBatch *batch = range->batch;
+    guint i;
 
-    hildon_live_search_widget_unhook (HILDON_LIVE_SEARCH (object));
+    for (i = range->start; i < range->end; i++) {
+        HildonLiveSearchIndexEntry *entry = g_ptr_array_index (batch->candidates, i);
 
-    if (priv->filter) {
-        selection_map_destroy (priv);
-        g_object_unref (priv->filter);
-        priv->filter = NULL;
+        batch->matches[i] = (entry->offset != INDEX_NO_KEY &&
+                             index_key_matches (batch->priv, batch->pool + entry->offset,
+                                                batch->priv->index_prefix));
     }
+}
 
-    if (priv->prefix) {
-        g_free (priv->prefix);
-        priv->prefix = NULL;
+static void
+match_range_thread                              (gpointer data,
+                                                 gpointer user_data)
+{
+    HildonLiveSearchMatchRange *range = data;
+    HildonLiveSearchMatchBatch *batch = range->batch;
+
+    match_range (range);
+
+    g_mutex_lock (&batch->lock);
+    if (--batch->pending == 0)
+        g_cond_signal (&batch->done);
+    g_mutex_unlock (&batch->lock);
+}
+
+/**
+ * index_match_parallel:
+ * @priv: The private pimpl
+ * @candidates: the index entries to test
+ * @set: the match set to fill
+ *
+ * Tests @candidates like index_match() does, spreading the work over
+ * one thread per processor, then marks the matching rows in order.
+ *
+ * Returns: %FALSE if the work could not be spread, and nothing was done.
+ **/
+static gboolean
+index_match_parallel                            (HildonLiveSearchPrivate  *priv,
+                                                 GPtrArray                *candidates,
+                                                 HildonLiveSearchMatchSet *set)
+{
+    HildonLiveSearchMatchBatch batch;
+    HildonLiveSearchMatchRange *ranges;
+    guint n_ranges = g_get_num_processors ();
+    guint size, i;
+
+    if (n_ranges < 2 || candidates->len < PARALLEL_MATCH_MIN_ROWS)
+        return FALSE;
+
+    if (match_pool == NULL) {
+        match_pool = g_thread_pool_new (match_range_thread, NULL,
+                                        n_ranges - 1, FALSE, NULL);
+        if (match_pool == NULL)
+            return FALSE;
     }
 
-    if (priv->visible_destroy) {
-        priv->visible_destroy (priv->visible_data);
-        priv->visible_destroy = NULL;
+    g_mutex_init (&batch.lock);
+    g_cond_init (&batch.done);
+    batch.priv = priv;
+    batch.pool = priv->index_pool->str;
+    batch.candidates = candidates;
+    batch.matches = g_new (guint8, candidates->len);
+    batch.pending = n_ranges - 1;
+
+    ranges = g_new (HildonLiveSearchMatchRange, n_ranges);
+    size = (candidates->len + n_ranges - 1) / n_ranges;
+    for (i = 0; i < n_ranges; i++) {
+        ranges[i].batch = &batch;
+        ranges[i].start = MIN (i * size, candidates->len);
+        ranges[i].end = MIN (ranges[i].start + size, candidates->len);
     }
 
-    if (priv->idle_filter_id) {
-        g_source_remove (priv->idle_filter_id);
-        priv->idle_filter_id = 0;
+    /* The last range is ours, the others go to the pool */
+    for (i = 0; i + 1 < n_ranges; i++)
+        g_thread_pool_push (match_pool, &ranges[i], NULL);
+    match_range (&ranges[n_ranges - 1]);
+
+    g_mutex_lock (&batch.lock);
+    while (batch.pending > 0)
+        g_cond_wait (&batch.done, &batch.lock);
+    g_mutex_unlock (&batch.lock);
+
+    for (i = 0; i < candidates->len; i++) {
+        if (batch.matches[i]) {
+            HildonLiveSearchIndexEntry *entry = g_ptr_array_index (candidates, i);
+
+            entry->serial = priv->index_serial;
+            g_ptr_array_add (set->rows, entry);
+        }
     }
 
-    G_OBJECT_CLASS (hildon_live_search_parent_class)->dispose (object);
+    g_free (batch.matches);
+    g_free (ranges);
+    g_mutex_clear (&batch.lock);
+    g_cond_clear (&batch.done);
+
+    return TRUE;
 }
 
+/**
+ * index_match:
+ * @priv: The private pimpl
+ *
+ * Matches the current prefix against the keys in the index, in one
+ * pass over the key pool and without allocating per row.
+ *
+ * As the user types, every new prefix extends the previous one, and
+ * its matches are a subset of the previous matches. Therefore only
+ * the rows matched by the longest cached prefix of the new prefix
+ * are tested. When the prefix gets shorter again, or goes back to
+ * one of the last few prefixes, the cached result for it is reused as
+ * is. The cache survives the text being cleared, as when the live
+ * search is hidden, and is only dropped when the rows change.
+ *
+ * When matching substrings, texts of three bytes or more only test
+ * the rows in the shortest posting list of their trigrams, if that
+ * is smaller than the rows matched by the cached prefix.
+ *
+ * With #HildonLiveSearch:parallel-match, big candidate sets are
+ * tested by several threads, see index_match_parallel().
+ **/
 static void
-hildon_live_search_class_init                   (HildonLiveSearchClass *klass)
+index_match                                     (HildonLiveSearchPrivate *priv)
 {
-    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    const gchar *pool = priv->index_pool->str;
+    HildonLiveSearchMatchSet *base = NULL;
+    HildonLiveSearchMatchSet *set;
+    GQueue *history = priv->match_history;
+    GPtrArray *candidates;
+    GList *l;
+    guint i;
+
+    g_free (priv->index_prefix);
+    priv->index_prefix = index_normalize_key (priv->prefix);
+
+    /* With no prefix everything is visible */
+    if (priv->index_prefix == NULL)
+        return;
 
-    g_type_class_add_private (klass, sizeof (HildonLiveSearchPrivate));
+    /* Find the longest cached prefix of the new prefix */
+    for (l = history->tail; l != NULL; l = l->prev) {
+        set = l->data;
+        if (g_str_has_prefix (priv->index_prefix, set->prefix) &&
+            (base == NULL || strlen (set->prefix) > strlen (base->prefix)))
+            base = set;
+    }
 
-    object_class->get_property = hildon_live_search_get_property;
-    object_class->set_property = hildon_live_search_set_property;
-    object_class->dispose = hildon_live_search_dispose;
+    priv->index_serial++;
+    if (G_UNLIKELY (priv->index_serial == 0)) {
+        for (i = 0; i < priv->index_rows->len; i++)
+            ((HildonLiveSearchIndexEntry *) g_ptr_array_index (priv->index_rows, i))->serial = 0;
+        priv->index_serial = 1;
+    }
 
-    /**
-     * HildonLiveSearch:filter:
-     *
-     * The #GtkTreeModelFilter to filter.
-     *
-     * Since: 2.2.4
-     */
-    g_object_class_install_property (object_class,
-                                     PROP_FILTER,
-                                     g_param_spec_object ("filter",
-                                                          "Filter",
-                                                          "Model filter",
-                                                          GTK_TYPE_TREE_MODEL_FILTER,
-                                                          G_PARAM_READWRITE |
-                                                          G_PARAM_STATIC_NICK |
-                                                          G_PARAM_STATIC_NAME |
+    if (base != NULL && strcmp (base->prefix, priv->index_prefix) == 0) {
+        for (i = 0; i < base->rows->len; i++)
+            ((HildonLiveSearchIndexEntry *) g_ptr_array_index (base->rows, i))->serial =
+                priv->index_serial;
+        g_queue_remove (history, base);
+        g_queue_push_tail (history, base);
+        return;
+    }
+
+    candidates = base ? base->rows : priv->index_rows;
+
+    set = g_slice_new (HildonLiveSearchMatchSet);
+    set->prefix = g_strdup (priv->index_prefix);
+    set->rows = g_ptr_array_new ();
+
+    /* No posting list at all means that no key has some trigram */
+    if (priv->trigrams != NULL && strlen (priv->index_prefix) >= 3) {
+        GPtrArray *postings = trigrams_lookup (priv, priv->index_prefix);
+
+        if (postings == NULL || postings->len < candidates->len)
+            candidates = postings;
+    }
+
+    if (candidates != NULL && priv->parallel_match &&
+        index_match_parallel (priv, candidates, set))
+        candidates = NULL;
+
+    for (i = 0; candidates != NULL && i < candidates->len; i++) {
+        HildonLiveSearchIndexEntry *entry = g_ptr_array_index (candidates, i);
+
+        if (entry->offset != INDEX_NO_KEY &&
+            index_key_matches (priv, pool + entry->offset, priv->index_prefix)) {
+            entry->serial = priv->index_serial;
+            g_ptr_array_add (set->rows, entry);
+        }
+    }
+
+    if (g_queue_get_length (history) == MATCH_HISTORY_MAX)
+        match_set_free (g_queue_pop_head (history));
+    g_queue_push_tail (history, set);
+}
+
+static void
+spans_clear                                     (HildonLiveSearchPrivate *priv)
+{
+    if (priv->spans)
+        g_hash_table_remove_all (priv->spans);
+
+    g_free (priv->span_prefix);
+    priv->span_prefix = NULL;
+}
+
+/**
+ * span_compute:
+ * @priv: The private pimpl
+ * @string: the text of a row
+ * @start: return location for the start of the match
+ * @end: return location for the end of the match
+ *
+ * Finds where the current prefix matches @string with the default
+ * matching rule, see index_key_matches(). The match is found in the
+ * normalized text, and mapped back to @string one character at a time.
+ *
+ * Returns: %TRUE if the prefix matches @string.
+ **/
+static gboolean
+span_compute                                    (HildonLiveSearchPrivate *priv,
+                                                 const gchar             *string,
+                                                 gint                    *start,
+                                                 gint                    *end)
+{
+    const gchar *match, *p;
+    gchar *key;
+    gsize match_start, match_end, offset;
+
+    if (priv->span_prefix == NULL)
+        priv->span_prefix = index_normalize_key (priv->prefix);
+
+    key = index_normalize_key (string);
+    if (key == NULL || priv->span_prefix == NULL) {
+        g_free (key);
+        return FALSE;
+    }
+
+    if (priv->match_substrings)
+        match = strstr (key, priv->span_prefix);
+    else
+        match = g_str_has_prefix (key, priv->span_prefix) ? key : NULL;
+
+    if (match == NULL) {
+        g_free (key);
+        return FALSE;
+    }
+
+    match_start = match - key;
+    match_end = match_start + strlen (priv->span_prefix);
+    g_free (key);
+
+    *start = 0;
+    *end = strlen (string);
+    offset = 0;
+
+    for (p = string; *p != '\0'; p = g_utf8_next_char (p)) {
+        gchar *normalized;
+
+        if (offset <= match_start)
+            *start = p - string;
+
+        normalized = g_utf8_normalize (p, g_utf8_next_char (p) - p, G_NORMALIZE_DEFAULT);
+        offset += normalized ? strlen (normalized) : 0;
+        g_free (normalized);
+
+        if (offset >= match_end) {
+            *end = g_utf8_next_char (p) - string;
+            break;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * ranked_score:
+ * @key: the text of a row
+ * @text: the text to look for, which @key contains
+ *
+ * Scores how well @text matches @key: the whole of it, its start, the
+ * start of one of its words, or somewhere else.
+ **/
+static guint
+ranked_score                                    (const gchar *key,
+                                                 const gchar *text)
+{
+    const gchar *match;
+
+    if (strcmp (key, text) == 0)
+        return RANK_EXACT;
+
+    if (g_str_has_prefix (key, text))
+        return RANK_PREFIX;
+
+    for (match = strstr (key, text); match != NULL;
+         match = strstr (g_utf8_next_char (match), text)) {
+        gunichar prev = g_utf8_get_char (g_utf8_prev_char (match));
+
+        if (!g_unichar_isalnum (prev))
+            return RANK_WORD_START;
+    }
+
+    return RANK_SUBSTRING;
+}
+
+static gboolean
+ranked_is_worse                                 (const HildonLiveSearchRanked *a,
+                                                 const HildonLiveSearchRanked *b)
+{
+    return a->score != b->score ? a->score > b->score : a->seq > b->seq;
+}
+
+static gint
+ranked_compare                                  (gconstpointer a,
+                                                 gconstpointer b)
+{
+    const HildonLiveSearchRanked *ra = a;
+    const HildonLiveSearchRanked *rb = b;
+
+    if (ra->score != rb->score)
+        return ra->score < rb->score ? -1 : 1;
+
+    return ra->seq < rb->seq ? -1 : (ra->seq > rb->seq);
+}
+
+static void
+ranked_sift_down                                (GArray *heap,
+                                                 guint   i)
+{
+    HildonLiveSearchRanked *rows = (HildonLiveSearchRanked *) heap->data;
+
+    for (;;) {
+        guint worst = i;
+        guint l = 2 * i + 1;
+        guint r = l + 1;
+        HildonLiveSearchRanked tmp;
+
+        if (l < heap->len && ranked_is_worse (&rows[l], &rows[worst]))
+            worst = l;
+        if (r < heap->len && ranked_is_worse (&rows[r], &rows[worst]))
+            worst = r;
+        if (worst == i)
+            break;
+
+        tmp = rows[i];
+        rows[i] = rows[worst];
+        rows[worst] = tmp;
+        i = worst;
+    }
+}
+
+static void
+ranked_heap_clear                               (HildonLiveSearchPrivate *priv)
+{
+    guint i;
+
+    priv->ranked_seq = 0;
+    priv->n_matches = 0;
+
+    if (priv->ranked_heap == NULL)
+        return;
+
+    for (i = 0; i < priv->ranked_heap->len; i++)
+        gtk_tree_path_free (g_array_index (priv->ranked_heap, HildonLiveSearchRanked, i).path);
+    g_array_set_size (priv->ranked_heap, 0);
+}
+
+/**
+ * ranked_add:
+ * @priv: The private pimpl
+ * @model: the child model
+ * @iter: a visible row of @model
+ * @key: the text of the row, in the same form as @text
+ * @text: the text the row matched
+ *
+ * Offers a row to the heap of the best ranked ones. The heap keeps
+ * its worst row at the root, so a row that does not make it costs a
+ * single comparison and one that does O(log K).
+ **/
+static void
+ranked_add                                      (HildonLiveSearchPrivate *priv,
+                                                 GtkTreeModel            *model,
+                                                 GtkTreeIter             *iter,
+                                                 const gchar             *key,
+                                                 const gchar             *text)
+{
+    HildonLiveSearchRanked row;
+    GArray *heap = priv->ranked_heap;
+
+    row.score = (key && text) ? ranked_score (key, text) : RANK_EXACT;
+    row.seq = priv->ranked_seq++;
+    priv->n_matches++;
+
+    if (heap->len == priv->ranked_max) {
+        HildonLiveSearchRanked *root = &g_array_index (heap, HildonLiveSearchRanked, 0);
+
+        if (!ranked_is_worse (root, &row))
+            return;
+
+        gtk_tree_path_free (root->path);
+        row.path = gtk_tree_model_get_path (model, iter);
+        *root = row;
+        ranked_sift_down (heap, 0);
+    } else {
+        guint i;
+
+        row.path = gtk_tree_model_get_path (model, iter);
+        g_array_append_val (heap, row);
+
+        /* Sift up */
+        for (i = heap->len - 1; i > 0; i = (i - 1) / 2) {
+            HildonLiveSearchRanked *rows = (HildonLiveSearchRanked *) heap->data;
+            HildonLiveSearchRanked tmp;
+
+            if (!ranked_is_worse (&rows[i], &rows[(i - 1) / 2]))
+                break;
+
+            tmp = rows[i];
+            rows[i] = rows[(i - 1) / 2];
+            rows[(i - 1) / 2] = tmp;
+        }
+    }
+}
+
+/* Fills the ranked model with the contents of the heap, best first */
+static void
+ranked_publish                                  (HildonLiveSearchPrivate *priv)
+{
+    GtkTreeModel *model;
+    guint i;
+
+    priv->ranking = FALSE;
+
+    if (priv->ranked_store == NULL)
+        return;
+
+    gtk_list_store_clear (priv->ranked_store);
+
+    if (priv->filter == NULL || priv->prefix == NULL) {
+        ranked_heap_clear (priv);
+        return;
+    }
+
+    model = gtk_tree_model_filter_get_model (priv->filter);
+    g_array_sort (priv->ranked_heap, ranked_compare);
+
+    for (i = 0; i < priv->ranked_heap->len; i++) {
+        HildonLiveSearchRanked *row = &g_array_index (priv->ranked_heap, HildonLiveSearchRanked, i);
+        GtkTreeIter iter, ranked_iter;
+        gchar *text = NULL;
+
+        if (!gtk_tree_model_get_iter (model, &iter, row->path))
+            continue;
+
+        if (priv->text_column >= 0)
+            gtk_tree_model_get (model, &iter, priv->text_column, &text, -1);
+
+        gtk_list_store_insert_with_values (priv->ranked_store, &ranked_iter, -1,
+                                           HILDON_LIVE_SEARCH_RANKED_COLUMN_TEXT, text,
+                                           HILDON_LIVE_SEARCH_RANKED_COLUMN_PATH, row->path,
+                                           -1);
+        g_free (text);
+    }
+
+    for (i = 0; i < priv->ranked_heap->len; i++)
+        gtk_tree_path_free (g_array_index (priv->ranked_heap, HildonLiveSearchRanked, i).path);
+    g_array_set_size (priv->ranked_heap, 0);
+}
+
+static gboolean
+refilter_needs_mapping                          (HildonLiveSearchPrivate *priv)
+{
+    return GTK_IS_TREE_VIEW (priv->kb_focus_widget) &&
+        gtk_tree_selection_get_mode (gtk_tree_view_get_selection (
+                                         GTK_TREE_VIEW (priv->kb_focus_widget))) != GTK_SELECTION_NONE;
+}
+
+/**
+ * refilter_begin:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Saves the selection into the selection map and emits
+ * #HildonLiveSearch::refilter.
+ *
+ * Returns: %TRUE if the filter model has to be refiltered by us.
+ **/
+static gboolean
+refilter_begin                                  (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    gboolean handled = FALSE;
+
+    HILDON_PERF (LIVE_SEARCH_REFILTERS);
+    HILDON_PROBE2 (live_search__refilter__start, livesearch, priv->prefix);
+
+    spans_clear (priv);
+
+    ranked_heap_clear (priv);
+    priv->ranking = (priv->ranked_max > 0);
+
+    /* Create/update selection map from current selection */
+    if (refilter_needs_mapping (priv)) {
+        if (!selection_map_exists (priv))
+            selection_map_create (priv);
+        selection_map_update_map_from_selection (priv);
+    }
+
+    g_signal_emit (livesearch, signals[REFILTER], 0, &handled);
+
+    return !handled && priv->filter;
+}
+
+static void
+refilter_end                                    (HildonLiveSearch *livesearch)
+{
+    /* Restore selection from mapping */
+    if (refilter_needs_mapping (livesearch->priv))
+        selection_map_update_selection_from_map (livesearch->priv);
+
+    if (livesearch->priv->ranking)
+        ranked_publish (livesearch->priv);
+
+    HILDON_PROBE1 (live_search__refilter__end, livesearch);
+}
+
+static gboolean
+refilter_can_start                              (HildonLiveSearchPrivate *priv)
+{
+    /* This is not pretty code, but it should fix some warnings in the case we
+       attempt to refilter before the treeview actually has a model. */
+    return !(refilter_needs_mapping (priv) &&
+             !gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)));
+}
+
+static void
+refilter (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+
+    if (!refilter_can_start (priv))
+        return;
+
+    HILDON_WATCH_ENTER ("live-search-refilter");
+
+    /* Filter the model */
+    if (refilter_begin (livesearch)) {
+        if (index_ensure (priv)) {
+            index_match (priv);
+            priv->index_refiltering = TRUE;
+        }
+        gtk_tree_model_filter_refilter (priv->filter);
+        priv->index_refiltering = FALSE;
+    }
+
+    refilter_end (livesearch);
+
+    HILDON_WATCH_LEAVE ("live-search-refilter");
+}
+
+static gboolean
+on_idle_refilter (HildonLiveSearch *livesearch)
+{
+    refilter (livesearch);
+
+    if (livesearch->priv->prefix == NULL)
+        selection_map_destroy (livesearch->priv);
+
+    livesearch->priv->idle_filter_id = 0;
+
+    return FALSE;
+}
+
+/* Extra filters driven by the same text, see hildon_live_search_add_filter().
+ * The filter keeps a reference on its section through its visible
+ * function, so @priv is cleared when the section is removed. */
+typedef struct
+{
+    gint ref_count;
+    HildonLiveSearchPrivate *priv;
+    GtkTreeModelFilter *filter;
+    GtkTreeModel *model;
+    GtkWidget *widget;
+    gint text_column;
+    gint pos;                   /* next row to refilter, -1 if done */
+    HildonLiveSearchChunk chunk;
+    gulong inserted_id;
+    gulong deleted_id;
+    gulong reordered_id;
+} HildonLiveSearchSection;
+
+#define                                         SECTION_DONE -1
+
+/* Makes @filter keep showing or hiding the row at @iter of @model
+   while it is announced, if @model is the child model of @filter */
+static void
+chunk_hold                                      (HildonLiveSearchChunk *chunk,
+                                                 GtkTreeModelFilter    *filter,
+                                                 GtkTreeModel          *model,
+                                                 GtkTreeIter           *iter)
+{
+    GtkTreeIter filter_iter;
+
+    if (filter == NULL || gtk_tree_model_filter_get_model (filter) != model)
+        return;
+
+    chunk->visible = gtk_tree_model_filter_convert_child_iter_to_iter (filter,
+                                                                       &filter_iter,
+                                                                       iter);
+    chunk->applying = TRUE;
+}
+
+/* The model a chunked refilter is announcing a row of, if any */
+static GtkTreeModel *announcing_model = NULL;
+
+/* Whether the row-changed being emitted on @model comes from a chunked
+ * refilter, which only shows or hides the row in a filter: the row did
+ * not change */
+G_GNUC_INTERNAL gboolean
+hildon_live_search_is_announcing                (GtkTreeModel *model)
+{
+    return model != NULL && model == announcing_model;
+}
+
+/**
+ * chunk_apply:
+ * @priv: The private pimpl
+ * @chunk: the chunked refilter state of @filter
+ * @filter: the filter being refiltered
+ * @model: the child model of @filter
+ * @iter: a row of @model
+ * @visible: whether the row matches the current text
+ *
+ * Shows or hides the row at @iter in @filter. Only a row whose
+ * visibility flips is announced with row-changed, so that @filter
+ * re-evaluates just that row: finding out whether @filter shows it is
+ * a lookup, and a refilter never walks the whole model in one go.
+ * The other filters of the live search on @model keep the row as they
+ * show it now, they are refiltered on their own. Everything else
+ * watching @model sees the row-changed too, while
+ * hildon_live_search_is_announcing() returns %TRUE for @model.
+ **/
+static void
+chunk_apply                                     (HildonLiveSearchPrivate *priv,
+                                                 HildonLiveSearchChunk   *chunk,
+                                                 GtkTreeModelFilter      *filter,
+                                                 GtkTreeModel            *model,
+                                                 GtkTreeIter             *iter,
+                                                 gboolean                 visible)
+{
+    GtkTreeIter filter_iter;
+    GtkTreeModel *announcing;
+    GtkTreePath *path;
+    guint i;
+
+    visible = (visible != FALSE);
+    if (gtk_tree_model_filter_convert_child_iter_to_iter (filter, &filter_iter, iter) == visible)
+        return;
+
+    chunk_hold (&priv->chunk_state, priv->filter, model, iter);
+    for (i = 0; priv->sections != NULL && i < priv->sections->len; i++) {
+        HildonLiveSearchSection *section = g_ptr_array_index (priv->sections, i);
+
+        chunk_hold (&section->chunk, section->filter, model, iter);
+    }
+
+    chunk->visible = visible;
+    chunk->applying = TRUE;
+
+    path = gtk_tree_model_get_path (model, iter);
+    announcing = announcing_model;
+    announcing_model = model;
+    gtk_tree_model_row_changed (model, path, iter);
+    announcing_model = announcing;
+    gtk_tree_path_free (path);
+
+    priv->chunk_state.applying = FALSE;
+    for (i = 0; priv->sections != NULL && i < priv->sections->len; i++)
+        ((HildonLiveSearchSection *) g_ptr_array_index (priv->sections, i))->chunk.applying = FALSE;
+}
+
+static void
+on_chunk_model_changed                          (HildonLiveSearchPrivate *priv)
+{
+    /* Rows moved under our cursor, go through the whole model again */
+    priv->chunk_restart = TRUE;
+}
+
+/**
+ * chunked_refilter_stop:
+ * @priv: The private pimpl
+ *
+ * Cancels the chunked refilter in progress, if any. Rows already
+ * shown or hidden keep their new visibility.
+ **/
+static void
+chunked_refilter_stop                           (HildonLiveSearchPrivate *priv)
+{
+    if (priv->chunk_id) {
+        g_source_remove (priv->chunk_id);
+        priv->chunk_id = 0;
+    }
+
+    if (priv->chunk_model) {
+        g_signal_handler_disconnect (priv->chunk_model, priv->chunk_inserted_id);
+        g_signal_handler_disconnect (priv->chunk_model, priv->chunk_deleted_id);
+        g_signal_handler_disconnect (priv->chunk_model, priv->chunk_reordered_id);
+        g_object_unref (priv->chunk_model);
+        priv->chunk_model = NULL;
+    }
+}
+
+static gboolean
+on_chunk_refilter                               (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    GtkTreeModel *model = priv->chunk_model;
+    GtkTreeIter iter;
+    gint64 start_time = g_get_monotonic_time ();
+    guint n_rows = 0;
+    gboolean valid;
+
+    HILDON_WATCH_ENTER ("live-search-refilter");
+
+    if (priv->chunk_restart) {
+        priv->chunk_pos = 0;
+        priv->chunk_restart = FALSE;
+        ranked_heap_clear (priv);
+    }
+
+    priv->index_refiltering = (priv->index_model == model);
+
+    valid = gtk_tree_model_iter_nth_child (model, &iter, NULL, priv->chunk_pos);
+    while (valid) {
+        chunk_apply (priv, &priv->chunk_state, priv->filter, model, &iter,
+                     visible_func (model, &iter, priv));
+
+        priv->chunk_pos++;
+        valid = gtk_tree_model_iter_next (model, &iter);
+
+        if (++n_rows >= priv->chunk_size ||
+            (priv->chunk_time > 0 &&
+             g_get_monotonic_time () - start_time >= priv->chunk_time))
+            break;
+    }
+
+    priv->index_refiltering = FALSE;
+
+    if (valid || priv->chunk_restart) {
+        HILDON_WATCH_LEAVE ("live-search-refilter");
+        return TRUE;
+    }
+
+    priv->chunk_id = 0;
+    chunked_refilter_stop (priv);
+
+    refilter_end (livesearch);
+    if (priv->prefix == NULL)
+        selection_map_destroy (priv);
+
+    HILDON_WATCH_LEAVE ("live-search-refilter");
+
+    return FALSE;
+}
+
+/**
+ * chunked_refilter_start:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Starts refiltering the model a few rows per main loop iteration,
+ * cancelling the one in progress. Rows change their visibility as
+ * soon as they are processed, so results show up progressively.
+ *
+ * Returns: %TRUE if the refilter was handled, %FALSE if it has to be
+ * done the usual way.
+ **/
+static gboolean
+chunked_refilter_start                          (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    GtkTreeModel *model;
+
+    chunked_refilter_stop (priv);
+
+    if (priv->chunk_size == 0 || priv->filter == NULL ||
+        !priv->visible_func_set)
+        return FALSE;
+
+    model = gtk_tree_model_filter_get_model (priv->filter);
+    if (!(gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY))
+        return FALSE;
+
+    if (!refilter_can_start (priv))
+        return TRUE;
+
+    if (!refilter_begin (livesearch)) {
+        refilter_end (livesearch);
+        return TRUE;
+    }
+
+    if (index_ensure (priv))
+        index_match (priv);
+
+    priv->chunk_model = g_object_ref (model);
+    priv->chunk_pos = 0;
+    priv->chunk_restart = FALSE;
+    priv->chunk_inserted_id =
+        g_signal_connect_swapped (model, "row-inserted",
+                                  G_CALLBACK (on_chunk_model_changed), priv);
+    priv->chunk_deleted_id =
+        g_signal_connect_swapped (model, "row-deleted",
+                                  G_CALLBACK (on_chunk_model_changed), priv);
+    priv->chunk_reordered_id =
+        g_signal_connect_swapped (model, "rows-reordered",
+                                  G_CALLBACK (on_chunk_model_changed), priv);
+
+    priv->chunk_id = gdk_threads_add_idle ((GSourceFunc) on_chunk_refilter, livesearch);
+
+    return TRUE;
+}
+
+static void
+section_unref                                   (HildonLiveSearchSection *section)
+{
+    if (--section->ref_count > 0)
+        return;
+
+    g_slice_free (HildonLiveSearchSection, section);
+}
+
+static void
+section_detach                                  (HildonLiveSearchSection *section)
+{
+    g_signal_handler_disconnect (section->model, section->inserted_id);
+    g_signal_handler_disconnect (section->model, section->deleted_id);
+    g_signal_handler_disconnect (section->model, section->reordered_id);
+    g_object_unref (section->model);
+    g_object_unref (section->filter);
+
+    if (section->widget)
+        g_object_remove_weak_pointer (G_OBJECT (section->widget),
+                                      (gpointer *) &section->widget);
+
+    section->priv = NULL;
+    section_unref (section);
+}
+
+static gboolean
+section_visible_func                            (GtkTreeModel *model,
+                                                 GtkTreeIter  *iter,
+                                                 gpointer      data)
+{
+    HildonLiveSearchSection *section = data;
+    const gchar *string;
+    gchar *string_copy;
+    gboolean visible;
+
+    if (section->chunk.applying)
+        return section->chunk.visible;
+
+    if (section->priv == NULL || section->priv->prefix == NULL)
+        return TRUE;
+
+    HILDON_PERF (LIVE_SEARCH_ROW_VISITS);
+
+    string = hildon_tree_model_peek_string (model, iter, section->text_column, &string_copy);
+    visible = (string != NULL &&
+               index_key_matches (section->priv, string, section->priv->prefix));
+    g_free (string_copy);
+
+    return visible;
+}
+
+static void
+on_section_model_changed                        (HildonLiveSearchSection *section)
+{
+    /* Rows moved under our cursor, go through the whole model again */
+    if (section->pos != SECTION_DONE)
+        section->pos = 0;
+}
+
+static gboolean
+section_is_onscreen                             (HildonLiveSearchSection *section)
+{
+    return section->widget == NULL || gtk_widget_get_mapped (section->widget);
+}
+
+/**
+ * sections_next:
+ * @priv: The private pimpl
+ *
+ * Picks the section to refilter next: the next pending one, in turn,
+ * among the sections on screen, or among the others once those are
+ * done.
+ **/
+static HildonLiveSearchSection *
+sections_next                                   (HildonLiveSearchPrivate *priv)
+{
+    guint n = priv->sections->len;
+    guint pass, k;
+
+    for (pass = 0; pass < 2; pass++) {
+        for (k = 1; k <= n; k++) {
+            guint i = (priv->sections_last + k) % n;
+            HildonLiveSearchSection *section = g_ptr_array_index (priv->sections, i);
+
+            if (section->pos != SECTION_DONE &&
+                section_is_onscreen (section) == (pass == 0)) {
+                priv->sections_last = i;
+                return section;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * section_refilter_chunk:
+ * @priv: The private pimpl
+ * @section: a section
+ *
+ * Refilters the next rows of @section, as many as a chunk of the main
+ * filter, or all of them if chunks are disabled or the model is not
+ * a list.
+ **/
+static void
+section_refilter_chunk                          (HildonLiveSearchPrivate *priv,
+                                                 HildonLiveSearchSection *section)
+{
+    GtkTreeIter iter;
+    gint64 start_time = g_get_monotonic_time ();
+    guint n_rows = 0;
+    gboolean valid;
+
+    if (priv->chunk_size == 0 ||
+        !(gtk_tree_model_get_flags (section->model) & GTK_TREE_MODEL_LIST_ONLY)) {
+        gtk_tree_model_filter_refilter (section->filter);
+        section->pos = SECTION_DONE;
+        return;
+    }
+
+    valid = gtk_tree_model_iter_nth_child (section->model, &iter, NULL, section->pos);
+    while (valid) {
+        chunk_apply (priv, &section->chunk, section->filter, section->model, &iter,
+                     section_visible_func (section->model, &iter, section));
+
+        section->pos++;
+        valid = gtk_tree_model_iter_next (section->model, &iter);
+
+        if (++n_rows >= priv->chunk_size ||
+            (priv->chunk_time > 0 &&
+             g_get_monotonic_time () - start_time >= priv->chunk_time))
+            break;
+    }
+
+    if (!valid)
+        section->pos = SECTION_DONE;
+}
+
+static gboolean
+on_sections_refilter                            (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    HildonLiveSearchSection *section;
+
+    section = sections_next (priv);
+    if (section != NULL)
+        section_refilter_chunk (priv, section);
+
+    if (sections_next (priv) != NULL)
+        return TRUE;
+
+    priv->sections_id = 0;
+
+    return FALSE;
+}
+
+/**
+ * sections_refilter_start:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Starts refiltering all the extra filters for the current text,
+ * cancelling the refilter in progress.
+ **/
+static void
+sections_refilter_start                         (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    guint i;
+
+    if (priv->sections == NULL || priv->sections->len == 0)
+        return;
+
+    for (i = 0; i < priv->sections->len; i++)
+        ((HildonLiveSearchSection *) g_ptr_array_index (priv->sections, i))->pos = 0;
+
+    if (priv->sections_id == 0)
+        priv->sections_id = gdk_threads_add_idle ((GSourceFunc) on_sections_refilter,
+                                                  livesearch);
+}
+
+static void
+sections_destroy                                (HildonLiveSearchPrivate *priv)
+{
+    if (priv->sections_id) {
+        g_source_remove (priv->sections_id);
+        priv->sections_id = 0;
+    }
+
+    if (priv->sections) {
+        g_ptr_array_free (priv->sections, TRUE);
+        priv->sections = NULL;
+    }
+}
+
+/**
+ * entry_update:
+ *
+ * Refilters for the text of the entry, shows or hides the live search
+ * and notifies #HildonLiveSearch:text.
+ **/
+static void
+entry_update                                    (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    const char *text;
+    glong len;
+
+    text = gtk_entry_get_text (GTK_ENTRY (priv->entry));
+    len = g_utf8_strlen (text, -1);
+    if (len < 1) {
+        text = NULL;
+    }
+
+    g_free (priv->prefix);
+    priv->prefix = g_strdup (text);
+
+    if (priv->run_async && priv->chunk_size > 0) {
+        if (priv->idle_filter_id != 0) {
+            hildon_job_remove (priv->idle_filter_id);
+            priv->idle_filter_id = 0;
+        }
+        if (!chunked_refilter_start (livesearch))
+            on_idle_refilter (livesearch);
+    } else if (priv->run_async) {
+        if (priv->idle_filter_id == 0) {
+            priv->idle_filter_id = hildon_job_add (GTK_WIDGET (livesearch),
+                                                   HILDON_JOB_PRIORITY_DEFAULT, 0,
+                                                   (GSourceFunc) on_idle_refilter,
+                                                   livesearch, NULL);
+        }
+    } else {
+        chunked_refilter_stop (priv);
+        if (priv->idle_filter_id != 0) {
+            hildon_job_remove (priv->idle_filter_id);
+            priv->idle_filter_id = 0;
+        }
+        on_idle_refilter (livesearch);
+    }
+
+    sections_refilter_start (livesearch);
+
+    /* Show the livesearch only if there is text in it */
+    if (priv->prefix == NULL) {
+        gtk_widget_hide (GTK_WIDGET (livesearch));
+    } else {
+        gtk_widget_show (GTK_WIDGET (livesearch));
+    }
+
+    /* Any change in the entry implies a change in HildonLiveSearch:text. */
+    g_object_notify (G_OBJECT (livesearch), "text");
+}
+
+static gboolean
+on_entry_update_job                             (HildonLiveSearch *livesearch)
+{
+    livesearch->priv->entry_update_id = 0;
+    entry_update (livesearch);
+
+    return FALSE;
+}
+
+static void
+entry_update_cancel                             (HildonLiveSearchPrivate *priv)
+{
+    if (priv->entry_update_id != 0) {
+        g_source_remove (priv->entry_update_id);
+        priv->entry_update_id = 0;
+    }
+}
+
+static void
+on_entry_changed                                (GtkEntry *entry,
+                                                 gpointer  user_data)
+{
+    HildonLiveSearch *livesearch = user_data;
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    priv = livesearch->priv;
+
+    if (!priv->run_async) {
+        entry_update_cancel (priv);
+        entry_update (livesearch);
+        return;
+    }
+
+    /* The keys forwarded by on_key_press_event() and the words
+       committed by input methods change the entry several times in a
+       row. Only the last text is filtered for, with a single show and
+       notification: the idle runs once the pending events have been
+       handled, but still before the frame is painted. */
+    if (priv->entry_update_id == 0)
+        priv->entry_update_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                                           (GSourceFunc) on_entry_update_job,
+                                                           livesearch, NULL);
+}
+
+/**
+ * hildon_live_search_append_text:
+ * @livesearch: An #HildonLiveSearch widget
+ * @text: Text to append. @text is copied internally
+ * can be freed later by the caller.
+ *
+ * Appends a string to the entry text in the live search widget.
+ *
+ * Since: 2.2.4
+ **/
+void
+hildon_live_search_append_text                  (HildonLiveSearch *livesearch,
+                                                 const char       *text)
+{
+    GtkEditable *editable;
+    int pos, start, end;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (NULL != text);
+
+    editable = GTK_EDITABLE (livesearch->priv->entry);
+
+    if (gtk_editable_get_selection_bounds (editable, &start, &end)) {
+        gtk_editable_delete_text (editable, start, end);
+    }
+    pos = gtk_editable_get_position (editable);
+    gtk_editable_insert_text (editable, text, strlen (text), &pos);
+    gtk_editable_set_position (editable, pos + 1);
+}
+
+/**
+ * hildon_live_search_set_text:
+ * @livesearch: An #HildonLiveSearch widget
+ * @text: Text to set. @text is copied internally
+ * can be freed later by the caller.
+ *
+ * Sets a string to the entry text in the live search widget.
+ *
+ * Since: 2.2.15
+ **/
+void
+hildon_live_search_set_text                  (HildonLiveSearch *livesearch,
+                                              const char       *text)
+{
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (NULL != text);
+
+    livesearch->priv->run_async = FALSE;
+    gtk_entry_set_text (GTK_ENTRY (livesearch->priv->entry),
+                        text);
+    hildon_entry_settle_now (HILDON_ENTRY (livesearch->priv->entry));
+    livesearch->priv->run_async = TRUE;
+
+    /* GObject::notify::text for HildonLiveSearch:text emitted in the
+       handler for HildonEntry::settled. */
+}
+
+/**
+ * hildon_live_search_get_text:
+ * @livesearch: An #HildonLiveSearch widget
+ *
+ * Retrieves the text contents of the #HildonLiveSearch widget.
+ *
+ * Returns: a pointer to the text contents of the widget as a
+ * string. This string should not be freed, modified, or stored.
+ *
+ * Since: 2.2.4
+ **/
+const char *
+hildon_live_search_get_text                     (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), NULL);
+
+    return gtk_entry_get_text (GTK_ENTRY (livesearch->priv->entry));
+}
+
+/*
+ * Key press handler. This takes key presses from the source widget and
+ * manipulate the entry. This manipulation then calls #on_entry_changed.
+ */
+static gboolean
+on_key_press_event                              (GtkWidget        *widget,
+                                                 GdkEventKey      *event,
+                                                 HildonLiveSearch *live_search)
+{
+    HildonLiveSearchPrivate *priv;
+    gboolean handled = FALSE;
+
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (live_search), FALSE);
+    priv = live_search->priv;
+
+    if (gtk_widget_get_visible (priv->kb_focus_widget)) {
+        /* If the live search is hidden, Ctrl+whatever is always
+         * passed to the focus widget, with the exception of
+         * Ctrl + Space, which is given to the entry, so that the input method
+         * is allowed to switch the keyboard layout. */
+        if (gtk_widget_get_visible (GTK_WIDGET (live_search)) ||
+            !(event->state & GDK_CONTROL_MASK ||
+              event->keyval == GDK_KEY_Control_L ||
+              event->keyval == GDK_KEY_Control_R) ||
+            (event->state & GDK_CONTROL_MASK &&
+             event->keyval == GDK_KEY_space)) {
+            GdkEvent *new_event;
+
+            /* If the entry is realized and has focus, it is enough to catch events.
+             * This assumes that the toolbar is a child of the hook widget. */
+            gtk_widget_realize (priv->entry);
+            if (!gtk_widget_has_focus (priv->entry))
+                gtk_widget_grab_focus (priv->entry);
+
+            new_event = gdk_event_copy ((GdkEvent *)event);
+            handled = gtk_widget_event (priv->entry, new_event);
+            gdk_event_free (new_event);
+        } else if (!gtk_widget_has_focus (priv->kb_focus_widget)) {
+            gtk_widget_grab_focus (GTK_WIDGET (priv->kb_focus_widget));
+        }
+    }
+
+    return handled;
+}
+
+static void
+on_hide_cb                                      (GtkWidget        *widget,
+                                                 HildonLiveSearch *live_search)
+{
+    hildon_live_search_set_text (live_search, "");
+    gtk_widget_grab_focus (live_search->priv->kb_focus_widget);
+}
+
+/* GObject methods */
+
+static void
+hildon_live_search_get_property                 (GObject    *object,
+                                                 guint       property_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonLiveSearch *livesearch = HILDON_LIVE_SEARCH (object);
+
+    switch (property_id) {
+    case PROP_FILTER:
+        g_value_set_object (value, livesearch->priv->filter);
+        break;
+    case PROP_TEXT_COLUMN:
+        g_value_set_int (value, livesearch->priv->text_column);
+        break;
+    case PROP_TEXT:
+        g_value_set_string (value, livesearch->priv->prefix);
+        break;
+    case PROP_USE_INDEX:
+        g_value_set_boolean (value, livesearch->priv->use_index);
+        break;
+    case PROP_REFILTER_CHUNK_SIZE:
+        g_value_set_uint (value, livesearch->priv->chunk_size);
+        break;
+    case PROP_REFILTER_CHUNK_TIME:
+        g_value_set_uint (value, livesearch->priv->chunk_time);
+        break;
+    case PROP_MATCH_SUBSTRINGS:
+        g_value_set_boolean (value, livesearch->priv->match_substrings);
+        break;
+    case PROP_PARALLEL_MATCH:
+        g_value_set_boolean (value, livesearch->priv->parallel_match);
+        break;
+    case PROP_MAX_RANKED_RESULTS:
+        g_value_set_uint (value, livesearch->priv->ranked_max);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+hildon_live_search_set_property                 (GObject      *object,
+                                                 guint         property_id,
+                                                 const GValue *value,
+                                                 GParamSpec   *pspec)
+{
+    HildonLiveSearch *livesearch = HILDON_LIVE_SEARCH (object);
+
+    switch (property_id) {
+    case PROP_FILTER:
+        hildon_live_search_set_filter (livesearch,
+                                       g_value_get_object (value));
+        break;
+    case PROP_TEXT_COLUMN:
+        hildon_live_search_set_text_column (livesearch,
+                                            g_value_get_int (value));
+        break;
+    case PROP_TEXT:
+        hildon_live_search_set_text (livesearch,
+                                     g_value_get_string (value));
+        break;
+    case PROP_USE_INDEX:
+        hildon_live_search_set_use_index (livesearch,
+                                          g_value_get_boolean (value));
+        break;
+    case PROP_REFILTER_CHUNK_SIZE:
+        hildon_live_search_set_refilter_chunk (livesearch,
+                                               g_value_get_uint (value),
+                                               livesearch->priv->chunk_time);
+        break;
+    case PROP_REFILTER_CHUNK_TIME:
+        hildon_live_search_set_refilter_chunk (livesearch,
+                                               livesearch->priv->chunk_size,
+                                               g_value_get_uint (value));
+        break;
+    case PROP_MATCH_SUBSTRINGS:
+        hildon_live_search_set_match_substrings (livesearch,
+                                                 g_value_get_boolean (value));
+        break;
+    case PROP_PARALLEL_MATCH:
+        hildon_live_search_set_parallel_match (livesearch,
+                                               g_value_get_boolean (value));
+        break;
+    case PROP_MAX_RANKED_RESULTS:
+        hildon_live_search_set_max_ranked_results (livesearch,
+                                                   g_value_get_uint (value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    }
+}
+
+static void
+hildon_live_search_dispose                      (GObject *object)
+{
+    HildonLiveSearchPrivate *priv = HILDON_LIVE_SEARCH (object)->priv;
+
+    hildon_live_search_widget_unhook (HILDON_LIVE_SEARCH (object));
+
+    index_destroy (priv);
+
+    if (priv->filter) {
+        selection_map_destroy (priv);
+        g_object_unref (priv->filter);
+        priv->filter = NULL;
+    }
+
+    if (priv->prefix) {
+        g_free (priv->prefix);
+        priv->prefix = NULL;
+    }
+
+    if (priv->visible_destroy) {
+        priv->visible_destroy (priv->visible_data);
+        priv->visible_destroy = NULL;
+    }
+
+    if (priv->idle_filter_id) {
+        hildon_job_remove (priv->idle_filter_id);
+        priv->idle_filter_id = 0;
+    }
+
+    entry_update_cancel (priv);
+    chunked_refilter_stop (priv);
+    sections_destroy (priv);
+
+    spans_clear (priv);
+    if (priv->spans) {
+        g_hash_table_destroy (priv->spans);
+        priv->spans = NULL;
+    }
+
+    ranked_heap_clear (priv);
+    if (priv->ranked_heap) {
+        g_array_free (priv->ranked_heap, TRUE);
+        priv->ranked_heap = NULL;
+    }
+    if (priv->ranked_store) {
+        g_object_unref (priv->ranked_store);
+        priv->ranked_store = NULL;
+    }
+
+    G_OBJECT_CLASS (hildon_live_search_parent_class)->dispose (object);
+}
+
+static void
+hildon_live_search_class_init                   (HildonLiveSearchClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (klass, sizeof (HildonLiveSearchPrivate));
+
+    object_class->get_property = hildon_live_search_get_property;
+    object_class->set_property = hildon_live_search_set_property;
+    object_class->dispose = hildon_live_search_dispose;
+
+    /**
+     * HildonLiveSearch:filter:
+     *
+     * The #GtkTreeModelFilter to filter.
+     *
+     * Since: 2.2.4
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_FILTER,
+                                     g_param_spec_object ("filter",
+                                                          "Filter",
+                                                          "Model filter",
+                                                          GTK_TYPE_TREE_MODEL_FILTER,
+                                                          G_PARAM_READWRITE |
+                                                          G_PARAM_STATIC_NICK |
+                                                          G_PARAM_STATIC_NAME |
                                                           G_PARAM_STATIC_BLURB));
 
-    /**
-     * HildonLiveSearch:text-column:
-     *
-     * A %G_TYPE_STRING column in the child model of #HildonLiveSearch:filter,
-     * to be used by the default filtering function of #HildonLiveSearch.
-     *
-     * Since: 2.2.4
-     */
-    g_object_class_install_property (object_class,
-                                     PROP_TEXT_COLUMN,
-                                     g_param_spec_int ("text-column",
-                                                       "Text column",
-                                                       "Column to use to filter "
-                                                       "elements from the #GtkTreeModelFilter",
-                                                       -1, G_MAXINT, -1,
-                                                       G_PARAM_READWRITE |
-                                                       G_PARAM_STATIC_STRINGS));
+    /**
+     * HildonLiveSearch:text-column:
+     *
+     * A %G_TYPE_STRING column in the child model of #HildonLiveSearch:filter,
+     * to be used by the default filtering function of #HildonLiveSearch.
+     *
+     * Since: 2.2.4
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_TEXT_COLUMN,
+                                     g_param_spec_int ("text-column",
+                                                       "Text column",
+                                                       "Column to use to filter "
+                                                       "elements from the #GtkTreeModelFilter",
+                                                       -1, G_MAXINT, -1,
+                                                       G_PARAM_READWRITE |
+                                                       G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:text:
+     *
+     * The text used to filter
+     *
+     * Since: 2.2.15
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_TEXT,
+                                     g_param_spec_string ("text",
+                                                       "Text",
+                                                       "Text to use as a filter",
+                                                       "",
+                                                       G_PARAM_READWRITE |
+                                                       G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:use-index:
+     *
+     * Whether the default filtering function should keep an index of
+     * normalized row keys. See hildon_live_search_set_use_index().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_USE_INDEX,
+                                     g_param_spec_boolean ("use-index",
+                                                           "Use index",
+                                                           "Whether to keep an index of "
+                                                           "normalized row keys",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE |
+                                                           G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:refilter-chunk-size:
+     *
+     * The maximum number of rows to refilter per main loop iteration,
+     * or 0 to refilter all of them at once.
+     * See hildon_live_search_set_refilter_chunk().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_REFILTER_CHUNK_SIZE,
+                                     g_param_spec_uint ("refilter-chunk-size",
+                                                        "Refilter chunk size",
+                                                        "Rows to refilter per main "
+                                                        "loop iteration, 0 for all",
+                                                        0, G_MAXUINT, 0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:refilter-chunk-time:
+     *
+     * The maximum time in microseconds to spend refiltering per main
+     * loop iteration, or 0 for no limit. Only used if
+     * #HildonLiveSearch:refilter-chunk-size is not 0.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_REFILTER_CHUNK_TIME,
+                                     g_param_spec_uint ("refilter-chunk-time",
+                                                        "Refilter chunk time",
+                                                        "Microseconds to spend refiltering "
+                                                        "per main loop iteration, 0 for no limit",
+                                                        0, G_MAXUINT, 0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:match-substrings:
+     *
+     * Whether the default filtering function matches the text anywhere
+     * in the rows instead of only at their start.
+     * See hildon_live_search_set_match_substrings().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_MATCH_SUBSTRINGS,
+                                     g_param_spec_boolean ("match-substrings",
+                                                           "Match substrings",
+                                                           "Whether to match the text anywhere "
+                                                           "in the rows",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE |
+                                                           G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:parallel-match:
+     *
+     * Whether the index matches big models using several threads.
+     * See hildon_live_search_set_parallel_match().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_PARALLEL_MATCH,
+                                     g_param_spec_boolean ("parallel-match",
+                                                           "Parallel match",
+                                                           "Whether to match big indexes "
+                                                           "using several threads",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE |
+                                                           G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:max-ranked-results:
+     *
+     * How many of the best matching rows are kept in the ranked model,
+     * or 0 not to rank the rows.
+     * See hildon_live_search_set_max_ranked_results().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_MAX_RANKED_RESULTS,
+                                     g_param_spec_uint ("max-ranked-results",
+                                                        "Max ranked results",
+                                                        "How many of the best matching "
+                                                        "rows to keep in the ranked model",
+                                                        0, G_MAXUINT, 0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonLiveSearch::refilter:
+   * @livesearch: the object which received the signal
+   *
+   * The "refilter" signal is emitted when the text in the entry changed and a
+   * refilter is needed.
+   *
+   * If this signal is not stopped, gtk_tree_model_filter_refilter() will be
+   * called on the filter model. Otherwise the handler is responsible to
+   * refilter it.
+   *
+   * Returns: %TRUE to stop other handlers from being invoked for the event.
+   * %FALSE to propagate the event further.
+   *
+   * Since: 2.2.4
+   */
+  signals[REFILTER] =
+    g_signal_new ("refilter",
+                  HILDON_TYPE_LIVE_SEARCH,
+                  G_SIGNAL_RUN_LAST, 0,
+                  g_signal_accumulator_true_handled, NULL,
+                  _hildon_marshal_BOOLEAN__VOID, G_TYPE_BOOLEAN, 0);
+}
+
+static void
+close_button_clicked_cb                         (GtkWidget *button,
+                                                 gpointer   user_data)
+{
+    gtk_widget_hide (GTK_WIDGET (user_data));
+}
+
+static void
+hildon_live_search_init                         (HildonLiveSearch *self)
+{
+    HildonLiveSearchPrivate *priv;
+    GtkToolItem *close_button_container;
+    GtkWidget *close;
+    GtkToolItem *close_button;
+    GtkToolItem *entry_container;
+    GtkWidget *entry_hbox;
+    self->priv = priv = GET_PRIVATE (self);
+
+    gtk_toolbar_set_style (GTK_TOOLBAR (self), GTK_TOOLBAR_ICONS);
+    gtk_container_set_border_width (GTK_CONTAINER (self), 0);
+
+    priv->kb_focus_widget = NULL;
+    priv->prefix = NULL;
+
+    priv->visible_func = NULL;
+    priv->visible_data = NULL;
+    priv->visible_destroy = NULL;
+    priv->visible_func_set = FALSE;
+    priv->idle_filter_id = 0;
+
+    priv->selection_map = NULL;
+    priv->run_async = TRUE;
+
+    priv->use_index = FALSE;
+    priv->match_substrings = FALSE;
+    priv->parallel_match = FALSE;
+    priv->trigrams = NULL;
+    priv->index_refiltering = FALSE;
+    priv->index_model = NULL;
+    priv->index_rows = NULL;
+    priv->index_map = NULL;
+    priv->index_pool = NULL;
+    priv->index_waste = 0;
+    priv->index_prefix = NULL;
+    priv->index_serial = 0;
+    priv->match_history = NULL;
+
+    priv->chunk_size = 0;
+    priv->chunk_time = 0;
+    priv->chunk_id = 0;
+    priv->chunk_pos = 0;
+    priv->chunk_restart = FALSE;
+    memset (&priv->chunk_state, 0, sizeof (HildonLiveSearchChunk));
+    priv->chunk_model = NULL;
+
+    priv->sections = NULL;
+    priv->sections_last = 0;
+    priv->sections_id = 0;
+
+    priv->spans = NULL;
+    priv->span_prefix = NULL;
+
+    priv->ranked_max = 0;
+    priv->ranking = FALSE;
+    priv->ranked_heap = NULL;
+    priv->ranked_store = NULL;
+    priv->ranked_seq = 0;
+    priv->n_matches = 0;
+
+    priv->text_column = -1;
+
+    entry_container = gtk_tool_item_new ();
+    gtk_tool_item_set_expand (entry_container, TRUE);
+
+    entry_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    gtk_box_set_homogeneous(GTK_BOX(entry_hbox), FALSE);
+    gtk_container_add (GTK_CONTAINER (entry_container), entry_hbox);
+
+    priv->entry = hildon_entry_new (HILDON_SIZE_FINGER_HEIGHT);
+
+    gtk_widget_set_name (GTK_WIDGET (priv->entry),
+                         "HildonLiveSearchEntry");
+
+    gtk_box_pack_start (GTK_BOX (entry_hbox), priv->entry, TRUE, TRUE,
+                        HILDON_MARGIN_DEFAULT);
+
+    gtk_toolbar_insert (GTK_TOOLBAR (self), entry_container, 0);
+    gtk_widget_show_all (GTK_WIDGET (entry_container));
+
+    close = gtk_image_new_from_icon_name ("window-close",
+                                          HILDON_ICON_SIZE_FINGER);
+    gtk_widget_set_halign (close, GTK_ALIGN_START);
+    gtk_widget_set_valign (close, GTK_ALIGN_START);
+    close_button = gtk_tool_button_new (close, NULL);
+    gtk_widget_set_can_focus (GTK_WIDGET (close_button), FALSE);
+
+    gtk_widget_set_margin_top(GTK_WIDGET (close_button), 0);
+    gtk_widget_set_margin_bottom(GTK_WIDGET (close_button), 0);
+    gtk_widget_set_margin_start(GTK_WIDGET (close_button), 0);
+    gtk_widget_set_margin_end(GTK_WIDGET (close_button), HILDON_MARGIN_DEFAULT);
+
+    close_button_container = gtk_tool_item_new ();
+    gtk_container_add (GTK_CONTAINER (close_button_container),
+                       GTK_WIDGET (close_button));
+
+    gtk_toolbar_insert (GTK_TOOLBAR (self), close_button_container, -1);
+    gtk_widget_show_all (GTK_WIDGET (close_button_container));
+
+    g_signal_connect (G_OBJECT (close_button), "clicked",
+                      G_CALLBACK (close_button_clicked_cb), self);
+
+    /* Emitted right after "changed" unless a settle delay is set */
+    g_signal_connect (G_OBJECT (priv->entry), "settled",
+                      G_CALLBACK (on_entry_changed), self);
+
+    g_signal_connect (self, "hide",
+                      G_CALLBACK (on_hide_cb), self);
+
+    gtk_widget_set_no_show_all (GTK_WIDGET (self), TRUE);
+}
+
+/* Public interface */
+
+/**
+ * hildon_live_search_new:
+ *
+ * Creates and returns a new #HildonLiveSearch widget.
+ *
+ * Returns: The newly created live search widget.
+ *
+ * Since: 2.2.4
+ **/
+GtkWidget *
+hildon_live_search_new                          (void)
+{
+    return g_object_new (HILDON_TYPE_LIVE_SEARCH, NULL);
+}
+
+static gboolean
+visible_func                                    (GtkTreeModel *model,
+                                                 GtkTreeIter  *iter,
+                                                 gpointer      data)
+{
+    HildonLiveSearchPrivate *priv;
+    const gchar *string;
+    gchar *string_copy;
+    gboolean visible = FALSE;
+    gboolean ranking;
+
+    priv = (HildonLiveSearchPrivate *) data;
+
+    /* The chunked refilter already matched and ranked this row */
+    if (priv->chunk_state.applying)
+        return priv->chunk_state.visible;
+
+    HILDON_PERF (LIVE_SEARCH_ROW_VISITS);
+
+    if (priv->prefix == NULL)
+        return TRUE;
+
+    if (priv->visible_func == NULL && priv->text_column == -1)
+        return TRUE;
+
+    ranking = priv->ranking;
+
+    if (priv->visible_func) {
+        visible = (priv->visible_func) (model, iter,
+                                        priv->prefix,
+                                        priv->visible_data);
+        if (visible && ranking)
+            ranked_add (priv, model, iter, NULL, NULL);
+    } else if (priv->index_model == model) {
+        HildonLiveSearchIndexEntry *entry = NULL;
+
+        /* The index is only trusted during a refilter: single row
+         * updates reach the filter before they reach the index. */
+        if (priv->index_refiltering)
+            entry = g_hash_table_lookup (priv->index_map, iter->user_data);
+
+        if (entry != NULL) {
+            visible = (entry->serial == priv->index_serial);
+            if (visible && ranking)
+                ranked_add (priv, model, iter,
+                            priv->index_pool->str + entry->offset,
+                            priv->index_prefix);
+        } else {
+            gchar *key;
+            gchar *norm_prefix;
+
+            string = hildon_tree_model_peek_string (model, iter, priv->text_column,
+                                                    &string_copy);
+            key = index_normalize_key (string);
+            norm_prefix = index_normalize_key (priv->prefix);
+            visible = (key != NULL && index_key_matches (priv, key, norm_prefix));
+            if (visible && ranking)
+                ranked_add (priv, model, iter, key, norm_prefix);
+            g_free (norm_prefix);
+            g_free (key);
+            g_free (string_copy);
+        }
+    } else {
+        string = hildon_tree_model_peek_string (model, iter, priv->text_column, &string_copy);
+        visible = (string != NULL && index_key_matches (priv, string, priv->prefix));
+        if (visible && ranking)
+            ranked_add (priv, model, iter, string, priv->prefix);
+        g_free (string_copy);
+    }
+
+    return visible;
+}
+
+/**
+ * hildon_live_search_set_filter:
+ * @livesearch: An #HildonLiveSearch widget
+ * @filter: a #GtkTreeModelFilter, or %NULL
+ *
+ * Sets a filter for @livesearch.
+ *
+ * Since: 2.2.4
+ */
+void
+hildon_live_search_set_filter                   (HildonLiveSearch   *livesearch,
+                                                 GtkTreeModelFilter *filter)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (filter == NULL || GTK_IS_TREE_MODEL_FILTER (filter));
+
+    priv = livesearch->priv;
+
+    if (filter == priv->filter)
+        return;
+
+    if (filter)
+        g_object_ref (filter);
 
-    /**
-     * HildonLiveSearch:text:
-     *
-     * The text used to filter
-     *
-     * Since: 2.2.15
-     */
-    g_object_class_install_property (object_class,
-                                     PROP_TEXT,
-                                     g_param_spec_string ("text",
-                                                       "Text",
-                                                       "Text to use as a filter",
-                                                       "",
-                                                       G_PARAM_READWRITE |
-                                                       G_PARAM_STATIC_STRINGS));
+    /* The map refers to rows of the old child model */
+    selection_map_destroy (priv);
 
-  /**
-   * HildonLiveSearch::refilter:
-   * @livesearch: the object which received the signal
-   *
-   * The "refilter" signal is emitted when the text in the entry changed and a
-   * refilter is needed.
-   *
-   * If this signal is not stopped, gtk_tree_model_filter_refilter() will be
-   * called on the filter model. Otherwise the handler is responsible to
-   * refilter it.
-   *
-   * Returns: %TRUE to stop other handlers from being invoked for the event.
-   * %FALSE to propagate the event further.
-   *
-   * Since: 2.2.4
-   */
-  signals[REFILTER] =
-    g_signal_new ("refilter",
-                  HILDON_TYPE_LIVE_SEARCH,
-                  G_SIGNAL_RUN_LAST, 0,
-                  g_signal_accumulator_true_handled, NULL,
-                  _hildon_marshal_BOOLEAN__VOID, G_TYPE_BOOLEAN, 0);
+    if (priv->filter)
+        g_object_unref (priv->filter);
+
+    priv->filter = filter;
+
+    if (priv->visible_func_set == FALSE &&
+        (priv->text_column != -1 || priv->visible_func)) {
+        gtk_tree_model_filter_set_visible_func (filter,
+                                                visible_func,
+                                                priv,
+                                                NULL);
+        priv->visible_func_set = TRUE;
+    }
+
+    refilter (livesearch);
+
+    g_object_notify (G_OBJECT (livesearch), "filter");
+}
+
+/**
+ * hildon_live_search_get_filter:
+ * @livesearch: An #HildonLiveSearch widget
+ *
+ * Returns: The #GtkTreeModelFilter set with hildon_live_search_set_filter()
+ *
+ * Since: 2.2.4
+ */
+GtkTreeModelFilter *
+hildon_live_search_get_filter (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), NULL);
+
+    priv = livesearch->priv;
+
+    return priv->filter;
+}
+
+/**
+ * hildon_live_search_set_text_column:
+ * @livesearch: a #HildonLiveSearch
+ * @text_column: the column in the model of @livesearch to get the strings
+ * to filter from
+ *
+ * Sets the column to be used by the default filtering method.
+ * This column must be of type %G_TYPE_STRING.
+ *
+ * Calling this method will trigger filtering of the model, so use
+ * with moderation. Note that you can only use either
+ * #HildonLiveSearch:text-column or
+ * hildon_live_search_set_visible_func().
+ *
+ * Since: 2.2.4
+ **/
+void
+hildon_live_search_set_text_column              (HildonLiveSearch *livesearch,
+                                                 gint              text_column)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (-1 <= text_column);
+
+    priv = livesearch->priv;
+
+    g_return_if_fail (text_column < gtk_tree_model_get_n_columns (gtk_tree_model_filter_get_model (priv->filter)));
+    g_return_if_fail (priv->visible_func == NULL);
+
+    if (priv->text_column == text_column)
+        return;
+
+    priv->text_column = text_column;
+
+    /* Keys are read from the text column, rebuild them on next refilter */
+    index_destroy (priv);
+
+    if (priv->visible_func_set == FALSE) {
+        gtk_tree_model_filter_set_visible_func (priv->filter,
+                                                visible_func,
+                                                priv,
+                                                NULL);
+        priv->visible_func_set = TRUE;
+    }
+
+    refilter (livesearch);
 }
 
 static void
-close_button_clicked_cb                         (GtkWidget *button,
+on_widget_destroy                               (GtkWidget *object,
                                                  gpointer   user_data)
 {
-    gtk_widget_hide (GTK_WIDGET (user_data));
+    hildon_live_search_widget_unhook (HILDON_LIVE_SEARCH (user_data));
+}
+
+/**
+ * hildon_live_search_widget_hook:
+ * @livesearch: An #HildonLiveSearch widget
+ * @hook_widget: A widget on which we listen for key events
+ * @kb_focus: The widget which we grab focus on
+ *
+ * This function must be called after a #HildonLiveSearch widget is
+ * constructed to set the hook widget and the focus widget for
+ * @livesearch. After that, the #HildonLiveSearch widget can be
+ * packed into a container and used.
+ *
+ * Since: 2.2.4
+ **/
+void
+hildon_live_search_widget_hook                  (HildonLiveSearch *livesearch,
+                                                 GtkWidget        *hook_widget,
+                                                 GtkWidget        *kb_focus)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (GTK_IS_WIDGET (hook_widget));
+    g_return_if_fail (GTK_IS_WIDGET (kb_focus));
+
+    priv = livesearch->priv;
+
+    g_return_if_fail (priv->event_widget == NULL);
+
+    priv->event_widget = g_object_ref (hook_widget);
+    priv->kb_focus_widget = g_object_ref (kb_focus);
+
+    priv->key_press_id =
+        g_signal_connect (hook_widget, "key-press-event",
+                          G_CALLBACK (on_key_press_event), livesearch);
+
+    priv->event_widget_destroy_id =
+        g_signal_connect (hook_widget, "destroy",
+                          G_CALLBACK (on_widget_destroy), livesearch);
+
+    priv->kb_focus_widget_destroy_id =
+        g_signal_connect (kb_focus, "destroy",
+                          G_CALLBACK (on_widget_destroy), livesearch);
+}
+
+/**
+ * hildon_live_search_widget_unhook:
+ * @livesearch: An #HildonLiveSearch widget
+ *
+ * This function unsets the hook and focus widgets which were set
+ * earlier using hildon_live_search_widget_hook().
+ *
+ * Since: 2.2.4
+ **/
+void
+hildon_live_search_widget_unhook                (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    priv = livesearch->priv;
+
+    if (priv->event_widget == NULL)
+        return;
+
+    /* All these variables are set together on hildon_live_search_widget_hook(),
+     * so event_widget != NULL implies that all these are non-NULL too */
+    g_return_if_fail (priv->kb_focus_widget != NULL);
+    g_return_if_fail (priv->key_press_id != 0);
+    g_return_if_fail (priv->event_widget_destroy_id != 0);
+    g_return_if_fail (priv->kb_focus_widget_destroy_id != 0);
+
+    g_signal_handler_disconnect (priv->event_widget, priv->key_press_id);
+    g_signal_handler_disconnect (priv->event_widget, priv->event_widget_destroy_id);
+    g_signal_handler_disconnect (priv->kb_focus_widget, priv->kb_focus_widget_destroy_id);
+
+    g_object_unref (priv->kb_focus_widget);
+    g_object_unref (priv->event_widget);
+
+    priv->key_press_id = 0;
+    priv->event_widget_destroy_id = 0;
+    priv->kb_focus_widget_destroy_id = 0;
+
+    priv->kb_focus_widget = NULL;
+    priv->event_widget = NULL;
+}
+
+/**
+ * hildon_live_search_save_state:
+ * @livesearch: An #HildonLiveSearch widget
+ * @key_file: The key file to save to
+ *
+ * Saves the live search text to a #GKeyFile.
+ *
+ * Since: 2.2.4
+ **/
+void
+hildon_live_search_save_state                   (HildonLiveSearch *livesearch,
+                                                 GKeyFile         *key_file)
+{
+    const char *text;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+
+    text = gtk_entry_get_text (GTK_ENTRY (livesearch->priv->entry));
+    if (text) {
+        g_key_file_set_string (key_file,
+                               "LiveSearch",
+                               "Text",
+                               text);
+    }
 }
 
-static void
-hildon_live_search_init                         (HildonLiveSearch *self)
+/**
+ * hildon_live_search_restore_state:
+ * @livesearch: An #HildonLiveSearch widget
+ * @key_file: The key file to read from
+ *
+ * Restores a live search widget's text from a #GKeyFile.
+ *
+ * Since: 2.2.4
+ **/
+void
+hildon_live_search_restore_state                (HildonLiveSearch *livesearch,
+                                                 GKeyFile         *key_file)
 {
-    HildonLiveSearchPrivate *priv;
-    GtkToolItem *close_button_container;
-    GtkWidget *close;
-    GtkToolItem *close_button;
-    GtkToolItem *entry_container;
-    GtkWidget *entry_hbox;
-    self->priv = priv = GET_PRIVATE (self);
+    char *text;
 
-    gtk_toolbar_set_style (GTK_TOOLBAR (self), GTK_TOOLBAR_ICONS);
-    gtk_container_set_border_width (GTK_CONTAINER (self), 0);
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
 
-    priv->kb_focus_widget = NULL;
-    priv->prefix = NULL;
+    text = g_key_file_get_string (key_file,
+                                  "LiveSearch",
+                                  "Text",
+                                  NULL);
+    if (text) {
+        gtk_entry_set_text (GTK_ENTRY (livesearch->priv->entry), text);
+        hildon_entry_settle_now (HILDON_ENTRY (livesearch->priv->entry));
+        g_free (text);
+    }
+}
 
-    priv->visible_func = NULL;
-    priv->visible_data = NULL;
-    priv->visible_destroy = NULL;
-    priv->visible_func_set = FALSE;
-    priv->idle_filter_id = 0;
+/**
+ * hildon_live_search_set_visible_func:
+ * @livesearch: a HildonLiveSearch
+ * @func: a #HildonLiveSearchVisibleFunc
+ * @data: user data to pass to @func or %NULL
+ * @destroy: Destroy notifier of @data, or %NULL.
+ *
+ * Sets the function to use to determine whether a row should be
+ * visible when the text in the entry changes. Internally,
+ * gtk_tree_model_filter_set_visible_func() is used.
+ *
+ * This is convenience API to replace #GtkTreeModelFilter's visible function
+ * by one that gives the current text in the entry.
+ *
+ * If this function is unset, #HildonLiveSearch:text-column is used.
+ *
+ * Since: 2.2.4
+ **/
+void
+hildon_live_search_set_visible_func             (HildonLiveSearch           *livesearch,
+                                                 HildonLiveSearchVisibleFunc func,
+                                                 gpointer                    data,
+                                                 GDestroyNotify              destroy)
+{
+    HildonLiveSearchPrivate *priv;
 
-    priv->selection_map = NULL;
-    priv->run_async = TRUE;
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (func != NULL);
 
-    priv->text_column = -1;
+    priv = livesearch->priv;
 
-    entry_container = gtk_tool_item_new ();
-    gtk_tool_item_set_expand (entry_container, TRUE);
+    g_return_if_fail (priv->text_column == -1);
 
-    entry_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-    gtk_box_set_homogeneous(GTK_BOX(entry_hbox), FALSE);
-    gtk_container_add (GTK_CONTAINER (entry_container), entry_hbox);
+    if (priv->visible_destroy) {
+        priv->visible_destroy (priv->visible_data);
+    }
 
-    priv->entry = hildon_entry_new (HILDON_SIZE_FINGER_HEIGHT);
+    priv->visible_func = func;
+    priv->visible_data = data;
+    priv->visible_destroy = destroy;
 
-    gtk_widget_set_name (GTK_WIDGET (priv->entry),
-                         "HildonLiveSearchEntry");
+    if (priv->visible_func_set == FALSE) {
+        gtk_tree_model_filter_set_visible_func (priv->filter,
+                                                visible_func,
+                                                priv,
+                                                NULL);
+        priv->visible_func_set = TRUE;
+    }
 
-    gtk_box_pack_start (GTK_BOX (entry_hbox), priv->entry, TRUE, TRUE,
-                        HILDON_MARGIN_DEFAULT);
+    refilter (livesearch);
+}
 
-    gtk_toolbar_insert (GTK_TOOLBAR (self), entry_container, 0);
-    gtk_widget_show_all (GTK_WIDGET (entry_container));
+/**
+ * hildon_live_search_clean_selection_map:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Cleans the selection map maintained by
+ * @livesearch. When used together with a #GtkTreeView,
+ * #HildonLiveSearch maintains internally a selection
+ * map, to make sure that selection is invariant to filtering.
+ *
+ * In some cases, you might want to clean this selection mapping, to
+ * ensure that after removing the entered text from @livesearch, the
+ * selection is not restored. This is useful in particular when you
+ * are using @livesearch with a #GtkTreeModel in a #GtkTreeView with
+ * #GtkSelectionMode set to %GTK_SELECTION_SINGLE.
+ *
+ * Since: 2.2.10
+ **/
+void
+hildon_live_search_clean_selection_map (HildonLiveSearch * livesearch)
+{
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
 
-    close = gtk_image_new_from_icon_name ("window-close",
-                                          HILDON_ICON_SIZE_FINGER);
-    gtk_widget_set_halign (close, GTK_ALIGN_START);
-    gtk_widget_set_valign (close, GTK_ALIGN_START);
-    close_button = gtk_tool_button_new (close, NULL);
-    gtk_widget_set_can_focus (GTK_WIDGET (close_button), FALSE);
+    if (selection_map_exists (livesearch->priv)) {
+        selection_map_destroy (livesearch->priv);
+        selection_map_create (livesearch->priv);
+        selection_map_update_map_from_selection (livesearch->priv);
+    }
+}
 
-    gtk_widget_set_margin_top(GTK_WIDGET (close_button), 0);
-    gtk_widget_set_margin_bottom(GTK_WIDGET (close_button), 0);
-    gtk_widget_set_margin_start(GTK_WIDGET (close_button), 0);
-    gtk_widget_set_margin_end(GTK_WIDGET (close_button), HILDON_MARGIN_DEFAULT);
+/**
+ * hildon_live_search_set_use_index:
+ * @livesearch: a #HildonLiveSearch
+ * @use_index: whether to index the rows of the filtered model
+ *
+ * Enables or disables the normalized key index of @livesearch. When
+ * enabled, and filtering is done with #HildonLiveSearch:text-column
+ * and no #HildonLiveSearchVisibleFunc, the text of every row is read
+ * once, normalized with g_utf8_normalize() and stored in a compact
+ * key pool. The index is kept up to date through the model signals,
+ * so that refiltering only has to scan this pool, without fetching
+ * or allocating anything per row.
+ *
+ * While the text only grows, each refilter also just tests the rows
+ * that matched the previous text, and the results for the last texts
+ * are kept until the rows change, so that deleting characters,
+ * switching back to a recent text or showing the live search again
+ * with its previous text does not rescan the keys.
+ *
+ * The index is only used with list models whose iters persist, like
+ * #GtkListStore. For other models, @livesearch silently filters the
+ * usual way.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_set_use_index                (HildonLiveSearch *livesearch,
+                                                 gboolean          use_index)
+{
+    HildonLiveSearchPrivate *priv;
 
-    close_button_container = gtk_tool_item_new ();
-    gtk_container_add (GTK_CONTAINER (close_button_container),
-                       GTK_WIDGET (close_button));
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
 
-    gtk_toolbar_insert (GTK_TOOLBAR (self), close_button_container, -1);
-    gtk_widget_show_all (GTK_WIDGET (close_button_container));
+    priv = livesearch->priv;
+    use_index = use_index ? TRUE : FALSE;
 
-    g_signal_connect (G_OBJECT (close_button), "clicked",
-                      G_CALLBACK (close_button_clicked_cb), self);
+    if (priv->use_index == use_index)
+        return;
 
-    g_signal_connect (G_OBJECT (priv->entry), "changed",
-                      G_CALLBACK (on_entry_changed), self);
+    priv->use_index = use_index;
 
-    g_signal_connect (self, "hide",
-                      G_CALLBACK (on_hide_cb), self);
+    if (!use_index)
+        index_destroy (priv);
 
-    gtk_widget_set_no_show_all (GTK_WIDGET (self), TRUE);
+    g_object_notify (G_OBJECT (livesearch), "use-index");
 }
 
-/* Public interface */
-
 /**
- * hildon_live_search_new:
+ * hildon_live_search_get_use_index:
+ * @livesearch: a #HildonLiveSearch
  *
- * Creates and returns a new #HildonLiveSearch widget.
+ * Gets whether @livesearch keeps an index of normalized row keys. See
+ * hildon_live_search_set_use_index().
  *
- * Returns: The newly created live search widget.
+ * Returns: %TRUE if the index is enabled.
  *
- * Since: 2.2.4
+ * Since: 3.0
  **/
-GtkWidget *
-hildon_live_search_new                          (void)
+gboolean
+hildon_live_search_get_use_index                (HildonLiveSearch *livesearch)
 {
-    return g_object_new (HILDON_TYPE_LIVE_SEARCH, NULL);
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), FALSE);
+
+    return livesearch->priv->use_index;
 }
 
-static gboolean
-visible_func                                    (GtkTreeModel *model,
-                                                 GtkTreeIter  *iter,
-                                                 gpointer      data)
+/**
+ * hildon_live_search_set_refilter_chunk:
+ * @livesearch: a #HildonLiveSearch
+ * @n_rows: the maximum number of rows to refilter per main loop
+ * iteration, or 0 to refilter all of them at once
+ * @max_usec: the maximum time in microseconds to spend refiltering
+ * per main loop iteration, or 0 for no limit
+ *
+ * Makes @livesearch refilter list models in chunks, so that a big
+ * model does not block the main loop while the user types. Each
+ * chunk stops after @n_rows rows or @max_usec microseconds, whichever
+ * comes first. Rows appear or disappear progressively as they are
+ * processed, and any new text typed cancels the chunk in progress and
+ * starts over.
+ *
+ * The child model is not modified, but each row that has to appear or
+ * disappear is announced on it with #GtkTreeModel::row-changed, so that
+ * the filter re-evaluates that row alone. Every other handler of that
+ * signal on the child model runs as well: a #GtkTreeModelSort on top of
+ * it sorts the row again, and application handlers are called for a row
+ * whose contents are the same.
+ *
+ * Text set with hildon_live_search_set_text() is always filtered at
+ * once.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_set_refilter_chunk           (HildonLiveSearch *livesearch,
+                                                 guint             n_rows,
+                                                 guint             max_usec)
 {
     HildonLiveSearchPrivate *priv;
-    gchar *string;
-    gboolean visible = FALSE;
 
-    priv = (HildonLiveSearchPrivate *) data;
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
 
-    if (priv->prefix == NULL)
-        return TRUE;
+    priv = livesearch->priv;
 
-    if (priv->visible_func == NULL && priv->text_column == -1)
-        return TRUE;
+    g_object_freeze_notify (G_OBJECT (livesearch));
 
-    if (priv->visible_func) {
-        visible = (priv->visible_func) (model, iter,
-                                        priv->prefix,
-                                        priv->visible_data);
-    } else {
-        gtk_tree_model_get (model, iter, priv->text_column, &string, -1);
-        visible = (string != NULL && g_str_has_prefix (string, priv->prefix));
-        g_free (string);
+    if (priv->chunk_size != n_rows) {
+        priv->chunk_size = n_rows;
+        g_object_notify (G_OBJECT (livesearch), "refilter-chunk-size");
     }
 
-    return visible;
+    if (priv->chunk_time != max_usec) {
+        priv->chunk_time = max_usec;
+        g_object_notify (G_OBJECT (livesearch), "refilter-chunk-time");
+    }
+
+    g_object_thaw_notify (G_OBJECT (livesearch));
 }
 
 /**
- * hildon_live_search_set_filter:
- * @livesearch: An #HildonLiveSearch widget
- * @filter: a #GtkTreeModelFilter, or %NULL
+ * hildon_live_search_set_match_substrings:
+ * @livesearch: a #HildonLiveSearch
+ * @match_substrings: %TRUE to match the text anywhere in the rows
  *
- * Sets a filter for @livesearch.
+ * Makes the default filtering method show the rows that contain the
+ * text anywhere, instead of only the rows starting with it.
  *
- * Since: 2.2.4
- */
+ * If the index is enabled with hildon_live_search_set_use_index(),
+ * it also keeps a posting list of rows for every trigram found in
+ * their keys, so that texts of three or more bytes are matched
+ * against a few candidate rows rather than the whole model.
+ *
+ * Calling this method will trigger filtering of the model.
+ *
+ * Since: 3.0
+ **/
 void
-hildon_live_search_set_filter                   (HildonLiveSearch   *livesearch,
-                                                 GtkTreeModelFilter *filter)
+hildon_live_search_set_match_substrings         (HildonLiveSearch *livesearch,
+                                                 gboolean          match_substrings)
 {
     HildonLiveSearchPrivate *priv;
 
     g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    g_return_if_fail (filter == NULL || GTK_IS_TREE_MODEL_FILTER (filter));
 
     priv = livesearch->priv;
+    match_substrings = match_substrings ? TRUE : FALSE;
 
-    if (filter == priv->filter)
+    if (priv->match_substrings == match_substrings)
         return;
 
-    if (filter)
-        g_object_ref (filter);
+    priv->match_substrings = match_substrings;
 
-    if (priv->filter)
-        g_object_unref (priv->filter);
+    /* Cached matches and trigrams depend on the rule, start over */
+    index_destroy (priv);
 
-    priv->filter = filter;
+    g_object_notify (G_OBJECT (livesearch), "match-substrings");
 
-    if (priv->visible_func_set == FALSE &&
-        (priv->text_column != -1 || priv->visible_func)) {
-        gtk_tree_model_filter_set_visible_func (filter,
-                                                visible_func,
-                                                priv,
-                                                NULL);
-        priv->visible_func_set = TRUE;
-    }
+    if (priv->filter != NULL)
+        refilter (livesearch);
+    sections_refilter_start (livesearch);
+}
 
-    refilter (livesearch);
+/**
+ * hildon_live_search_get_match_substrings:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Gets whether @livesearch matches the text anywhere in the rows. See
+ * hildon_live_search_set_match_substrings().
+ *
+ * Returns: %TRUE if substrings are matched.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_live_search_get_match_substrings         (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), FALSE);
 
-    g_object_notify (G_OBJECT (livesearch), "filter");
+    return livesearch->priv->match_substrings;
 }
 
 /**
- * hildon_live_search_get_filter:
- * @livesearch: An #HildonLiveSearch widget
+ * hildon_live_search_add_filter:
+ * @livesearch: a #HildonLiveSearch
+ * @filter: a #GtkTreeModelFilter
+ * @text_column: the column of the child model of @filter holding the
+ * strings to filter on
+ * @widget: (allow-none): the widget showing @filter, or %NULL
+ *
+ * Makes @livesearch filter @filter too, besides the one set with
+ * hildon_live_search_set_filter(). This lets a single live search
+ * drive several lists, like the sections of a search screen, instead
+ * of having one #HildonLiveSearch per list.
+ *
+ * The rows of @filter are visible if their string in @text_column
+ * matches the text like with #HildonLiveSearch:text-column; @filter
+ * must not have a visible function yet. When the text changes, the
+ * extra filters are refiltered from the main loop, one chunk of
+ * #HildonLiveSearch:refilter-chunk-size rows at a time, or a whole
+ * filter at a time if chunks are disabled, taking turns. The filters
+ * whose @widget is mapped are refiltered first, the others later.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_add_filter                   (HildonLiveSearch   *livesearch,
+                                                 GtkTreeModelFilter *filter,
+                                                 gint                text_column,
+                                                 GtkWidget          *widget)
+{
+    HildonLiveSearchPrivate *priv;
+    HildonLiveSearchSection *section;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+    g_return_if_fail (text_column >= 0);
+    g_return_if_fail (widget == NULL || GTK_IS_WIDGET (widget));
+
+    priv = livesearch->priv;
+
+    if (priv->sections == NULL)
+        priv->sections = g_ptr_array_new_with_free_func ((GDestroyNotify) section_detach);
+
+    section = g_slice_new0 (HildonLiveSearchSection);
+    section->ref_count = 2;     /* the list and the filter */
+    section->priv = priv;
+    section->filter = g_object_ref (filter);
+    section->model = g_object_ref (gtk_tree_model_filter_get_model (filter));
+    section->text_column = text_column;
+    section->pos = SECTION_DONE;
+
+    section->widget = widget;
+    if (widget)
+        g_object_add_weak_pointer (G_OBJECT (widget), (gpointer *) &section->widget);
+
+    section->inserted_id =
+        g_signal_connect_swapped (section->model, "row-inserted",
+                                  G_CALLBACK (on_section_model_changed), section);
+    section->deleted_id =
+        g_signal_connect_swapped (section->model, "row-deleted",
+                                  G_CALLBACK (on_section_model_changed), section);
+    section->reordered_id =
+        g_signal_connect_swapped (section->model, "rows-reordered",
+                                  G_CALLBACK (on_section_model_changed), section);
+
+    gtk_tree_model_filter_set_visible_func (filter, section_visible_func, section,
+                                            (GDestroyNotify) section_unref);
+
+    g_ptr_array_add (priv->sections, section);
+
+    if (priv->prefix != NULL)
+        sections_refilter_start (livesearch);
+}
+
+/**
+ * hildon_live_search_remove_filter:
+ * @livesearch: a #HildonLiveSearch
+ * @filter: a #GtkTreeModelFilter added with hildon_live_search_add_filter()
  *
- * Returns: The #GtkTreeModelFilter set with hildon_live_search_set_filter()
+ * Stops filtering @filter with @livesearch. All the rows of @filter
+ * are shown again.
  *
- * Since: 2.2.4
- */
-GtkTreeModelFilter *
-hildon_live_search_get_filter (HildonLiveSearch *livesearch)
+ * Since: 3.0
+ **/
+void
+hildon_live_search_remove_filter                (HildonLiveSearch   *livesearch,
+                                                 GtkTreeModelFilter *filter)
 {
     HildonLiveSearchPrivate *priv;
+    guint i;
 
-    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), NULL);
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
     priv = livesearch->priv;
 
-    return priv->filter;
+    for (i = 0; priv->sections != NULL && i < priv->sections->len; i++) {
+        HildonLiveSearchSection *section = g_ptr_array_index (priv->sections, i);
+
+        if (section->filter == filter) {
+            /* Keep @filter alive through the detach */
+            g_object_ref (filter);
+            g_ptr_array_remove_index (priv->sections, i);
+            gtk_tree_model_filter_refilter (filter);
+            g_object_unref (filter);
+            return;
+        }
+    }
+
+    g_warning ("%s: filter %p is not driven by this live search", G_STRFUNC, filter);
 }
 
 /**
- * hildon_live_search_set_text_column:
+ * hildon_live_search_set_parallel_match:
  * @livesearch: a #HildonLiveSearch
- * @text_column: the column in the model of @livesearch to get the strings
- * to filter from
- *
- * Sets the column to be used by the default filtering method.
- * This column must be of type %G_TYPE_STRING.
+ * @parallel_match: %TRUE to match using several threads
  *
- * Calling this method will trigger filtering of the model, so use
- * with moderation. Note that you can only use either
- * #HildonLiveSearch:text-column or
- * hildon_live_search_set_visible_func().
+ * Makes the index of @livesearch, see hildon_live_search_set_use_index(),
+ * split the rows to match among one thread per processor when there
+ * are many of them. The keys of the index are only read while the
+ * threads run, and the filter is updated from the main thread
+ * afterwards, so this is safe with any model the index can be used
+ * with. It has no effect on single processor machines, without the
+ * index, or with a #HildonLiveSearchVisibleFunc.
  *
- * Since: 2.2.4
+ * Since: 3.0
  **/
 void
-hildon_live_search_set_text_column              (HildonLiveSearch *livesearch,
-                                                 gint              text_column)
+hildon_live_search_set_parallel_match           (HildonLiveSearch *livesearch,
+                                                 gboolean          parallel_match)
 {
     HildonLiveSearchPrivate *priv;
 
     g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    g_return_if_fail (-1 <= text_column);
 
     priv = livesearch->priv;
+    parallel_match = parallel_match ? TRUE : FALSE;
 
-    g_return_if_fail (text_column < gtk_tree_model_get_n_columns (gtk_tree_model_filter_get_model (priv->filter)));
-    g_return_if_fail (priv->visible_func == NULL);
-
-    if (priv->text_column == text_column)
+    if (priv->parallel_match == parallel_match)
         return;
 
-    priv->text_column = text_column;
-
-    if (priv->visible_func_set == FALSE) {
-        gtk_tree_model_filter_set_visible_func (priv->filter,
-                                                visible_func,
-                                                priv,
-                                                NULL);
-        priv->visible_func_set = TRUE;
-    }
+    priv->parallel_match = parallel_match;
 
-    refilter (livesearch);
+    g_object_notify (G_OBJECT (livesearch), "parallel-match");
 }
 
-static void
-on_widget_destroy                               (GtkWidget *object,
-                                                 gpointer   user_data)
+/**
+ * hildon_live_search_get_parallel_match:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Gets whether @livesearch matches big indexes using several threads.
+ * See hildon_live_search_set_parallel_match().
+ *
+ * Returns: %TRUE if matching is done in parallel.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_live_search_get_parallel_match           (HildonLiveSearch *livesearch)
 {
-    hildon_live_search_widget_unhook (HILDON_LIVE_SEARCH (user_data));
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), FALSE);
+
+    return livesearch->priv->parallel_match;
 }
 
 /**
- * hildon_live_search_widget_hook:
- * @livesearch: An #HildonLiveSearch widget
- * @hook_widget: A widget on which we listen for key events
- * @kb_focus: The widget which we grab focus on
+ * hildon_live_search_set_max_ranked_results:
+ * @livesearch: a #HildonLiveSearch
+ * @max_results: how many rows to rank, or 0 to disable ranking
  *
- * This function must be called after a #HildonLiveSearch widget is
- * constructed to set the hook widget and the focus widget for
- * @livesearch. After that, the #HildonLiveSearch widget can be
- * packed into a container and used.
+ * Makes @livesearch also rank the rows it shows, and keep the best
+ * @max_results of them in the model returned by
+ * hildon_live_search_get_ranked_model(). Rows whose text is exactly the
+ * search text rank first, then those starting with it, then those
+ * with a word starting with it, then the rest; rows that rank the
+ * same keep the order of the model.
  *
- * Since: 2.2.4
+ * The rows are scored while they are filtered, and only the best ones
+ * are kept, so this costs O(n log @max_results) per refilter instead of
+ * sorting every visible row as a #GtkTreeModelSort on top of the
+ * filter would. When hildon_live_search_get_n_matches() returns more
+ * than @max_results, the filter itself can be shown to see all the
+ * matches.
+ *
+ * Rows filtered with a #HildonLiveSearchVisibleFunc all rank the
+ * same.
+ *
+ * Disabling ranking empties and releases the ranked model; enabling it
+ * again gives a new one.
+ *
+ * Since: 3.0
  **/
 void
-hildon_live_search_widget_hook                  (HildonLiveSearch *livesearch,
-                                                 GtkWidget        *hook_widget,
-                                                 GtkWidget        *kb_focus)
+hildon_live_search_set_max_ranked_results       (HildonLiveSearch *livesearch,
+                                                 guint             max_results)
 {
     HildonLiveSearchPrivate *priv;
 
     g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    g_return_if_fail (GTK_IS_WIDGET (hook_widget));
-    g_return_if_fail (GTK_IS_WIDGET (kb_focus));
 
     priv = livesearch->priv;
 
-    g_return_if_fail (priv->event_widget == NULL);
+    if (priv->ranked_max == max_results)
+        return;
 
-    priv->event_widget = g_object_ref (hook_widget);
-    priv->kb_focus_widget = g_object_ref (kb_focus);
+    priv->ranked_max = max_results;
 
-    priv->key_press_id =
-        g_signal_connect (hook_widget, "key-press-event",
-                          G_CALLBACK (on_key_press_event), livesearch);
+    if (max_results > 0 && priv->ranked_heap == NULL)
+        priv->ranked_heap = g_array_new (FALSE, FALSE, sizeof (HildonLiveSearchRanked));
 
-    priv->event_widget_destroy_id =
-        g_signal_connect (hook_widget, "destroy",
-                          G_CALLBACK (on_widget_destroy), livesearch);
+    if (max_results == 0) {
+        ranked_heap_clear (priv);
+        priv->ranking = FALSE;
+        if (priv->ranked_heap) {
+            g_array_free (priv->ranked_heap, TRUE);
+            priv->ranked_heap = NULL;
+        }
+        if (priv->ranked_store) {
+            gtk_list_store_clear (priv->ranked_store);
+            g_object_unref (priv->ranked_store);
+            priv->ranked_store = NULL;
+        }
+    }
 
-    priv->kb_focus_widget_destroy_id =
-        g_signal_connect (kb_focus, "destroy",
-                          G_CALLBACK (on_widget_destroy), livesearch);
+    if (max_results > 0 && priv->prefix != NULL)
+        refilter (livesearch);
+
+    g_object_notify (G_OBJECT (livesearch), "max-ranked-results");
 }
 
 /**
- * hildon_live_search_widget_unhook:
- * @livesearch: An #HildonLiveSearch widget
+ * hildon_live_search_get_max_ranked_results:
+ * @livesearch: a #HildonLiveSearch
  *
- * This function unsets the hook and focus widgets which were set
- * earlier using hildon_live_search_widget_hook().
+ * See hildon_live_search_set_max_ranked_results().
  *
- * Since: 2.2.4
+ * Returns: how many rows @livesearch ranks, or 0 if it does not rank them.
+ *
+ * Since: 3.0
  **/
-void
-hildon_live_search_widget_unhook                (HildonLiveSearch *livesearch)
+guint
+hildon_live_search_get_max_ranked_results       (HildonLiveSearch *livesearch)
 {
-    HildonLiveSearchPrivate *priv;
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), 0);
 
-    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    priv = livesearch->priv;
+    return livesearch->priv->ranked_max;
+}
 
-    if (priv->event_widget == NULL)
-        return;
+/**
+ * hildon_live_search_get_ranked_model:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Gets the model holding the best matching rows, best first, see
+ * hildon_live_search_set_max_ranked_results(). It has the
+ * %HILDON_LIVE_SEARCH_RANKED_COLUMN_TEXT column, a copy of the text of
+ * the row, and the %HILDON_LIVE_SEARCH_RANKED_COLUMN_PATH column, the
+ * #GtkTreePath of the row in the child model of the filter. It is
+ * updated after each refilter, and empty when there is no text.
+ *
+ * Returns: (transfer none): the ranked model.
+ *
+ * Since: 3.0
+ **/
+GtkTreeModel *
+hildon_live_search_get_ranked_model             (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv;
 
-    /* All these variables are set together on hildon_live_search_widget_hook(),
-     * so event_widget != NULL implies that all these are non-NULL too */
-    g_return_if_fail (priv->kb_focus_widget != NULL);
-    g_return_if_fail (priv->key_press_id != 0);
-    g_return_if_fail (priv->event_widget_destroy_id != 0);
-    g_return_if_fail (priv->kb_focus_widget_destroy_id != 0);
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), NULL);
 
-    g_signal_handler_disconnect (priv->event_widget, priv->key_press_id);
-    g_signal_handler_disconnect (priv->event_widget, priv->event_widget_destroy_id);
-    g_signal_handler_disconnect (priv->kb_focus_widget, priv->kb_focus_widget_destroy_id);
+    priv = livesearch->priv;
 
-    g_object_unref (priv->kb_focus_widget);
-    g_object_unref (priv->event_widget);
+    if (priv->ranked_store == NULL)
+        priv->ranked_store = gtk_list_store_new (HILDON_LIVE_SEARCH_RANKED_N_COLUMNS,
+                                                 G_TYPE_STRING, GTK_TYPE_TREE_PATH);
 
-    priv->key_press_id = 0;
-    priv->event_widget_destroy_id = 0;
-    priv->kb_focus_widget_destroy_id = 0;
+    return GTK_TREE_MODEL (priv->ranked_store);
+}
 
-    priv->kb_focus_widget = NULL;
-    priv->event_widget = NULL;
+/**
+ * hildon_live_search_get_n_matches:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Gets how many rows matched in the last refilter, when
+ * #HildonLiveSearch:max-ranked-results is set. If this is more than
+ * the rows in hildon_live_search_get_ranked_model(), some matches are
+ * only in the filter.
+ *
+ * Returns: the number of matching rows.
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_live_search_get_n_matches                (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), 0);
+
+    return livesearch->priv->n_matches;
 }
 
 /**
- * hildon_live_search_save_state:
- * @livesearch: An #HildonLiveSearch widget
- * @key_file: The key file to save to
+ * hildon_live_search_set_settle_delay:
+ * @livesearch: a #HildonLiveSearch
+ * @delay: milliseconds without typing before the filter is updated
+ * @max_wait: maximum milliseconds continuous typing can postpone the
+ * update, or 0 for no limit
  *
- * Saves the live search text to a #GKeyFile.
+ * Makes @livesearch refilter only once typing pauses for @delay
+ * milliseconds, instead of after every keystroke, see
+ * hildon_entry_set_settle_delay(). This bounds the work done while the
+ * user types fast on big models. Text set with
+ * hildon_live_search_set_text() is always applied right away.
  *
- * Since: 2.2.4
+ * The default, a @delay of 0, refilters on every change.
+ *
+ * Since: 3.0
  **/
 void
-hildon_live_search_save_state                   (HildonLiveSearch *livesearch,
-                                                 GKeyFile         *key_file)
+hildon_live_search_set_settle_delay             (HildonLiveSearch *livesearch,
+                                                 guint             delay,
+                                                 guint             max_wait)
 {
-    const char *text;
-
     g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
 
-    text = gtk_entry_get_text (GTK_ENTRY (livesearch->priv->entry));
-    if (text) {
-        g_key_file_set_string (key_file,
-                               "LiveSearch",
-                               "Text",
-                               text);
-    }
+    hildon_entry_set_settle_delay (HILDON_ENTRY (livesearch->priv->entry),
+                                   delay, max_wait);
 }
 
 /**
- * hildon_live_search_restore_state:
- * @livesearch: An #HildonLiveSearch widget
- * @key_file: The key file to read from
+ * hildon_live_search_get_settle_delay:
+ * @livesearch: a #HildonLiveSearch
+ * @max_wait: (out) (allow-none): location for the maximum wait, or %NULL
  *
- * Restores a live search widget's text from a #GKeyFile.
+ * See hildon_live_search_set_settle_delay().
  *
- * Since: 2.2.4
+ * Returns: the settle delay of @livesearch, in milliseconds
+ *
+ * Since: 3.0
  **/
-void
-hildon_live_search_restore_state                (HildonLiveSearch *livesearch,
-                                                 GKeyFile         *key_file)
+guint
+hildon_live_search_get_settle_delay             (HildonLiveSearch *livesearch,
+                                                 guint            *max_wait)
 {
-    char *text;
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), 0);
 
-    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-
-    text = g_key_file_get_string (key_file,
-                                  "LiveSearch",
-                                  "Text",
-                                  NULL);
-    if (text) {
-        gtk_entry_set_text (GTK_ENTRY (livesearch->priv->entry), text);
-        g_free (text);
-    }
+    return hildon_entry_get_settle_delay (HILDON_ENTRY (livesearch->priv->entry),
+                                          max_wait);
 }
 
 /**
- * hildon_live_search_set_visible_func:
- * @livesearch: a HildonLiveSearch
- * @func: a #HildonLiveSearchVisibleFunc
- * @data: user data to pass to @func or %NULL
- * @destroy: Destroy notifier of @data, or %NULL.
+ * hildon_live_search_get_match:
+ * @livesearch: a #HildonLiveSearch
+ * @model: the filter set with hildon_live_search_set_filter(), or its child model
+ * @iter: a row of @model
+ * @start: (out) (allow-none): return location for the start of the match, or %NULL
+ * @end: (out) (allow-none): return location for the end of the match, or %NULL
  *
- * Sets the function to use to determine whether a row should be
- * visible when the text in the entry changes. Internally,
- * gtk_tree_model_filter_set_visible_func() is used.
+ * Gets the part of the text of a row, in the column set with
+ * hildon_live_search_set_text_column(), that the current text of
+ * @livesearch matched, as byte offsets in the text. This is meant for
+ * highlighting the matches in the results, see
+ * hildon_live_search_highlight_cell().
  *
- * This is convenience API to replace #GtkTreeModelFilter's visible function
- * by one that gives the current text in the entry.
+ * The match of a row is computed once per search text and then
+ * remembered, when the child model is indexed (see
+ * hildon_live_search_set_use_index()), so calling this from a cell data
+ * function on every redraw is cheap.
  *
- * If this function is unset, #HildonLiveSearch:text-column is used.
+ * Rows filtered with a function set with
+ * hildon_live_search_set_visible_func() have no match.
  *
- * Since: 2.2.4
+ * Returns: %TRUE if the row matches the current text.
+ *
+ * Since: 3.0
  **/
-void
-hildon_live_search_set_visible_func             (HildonLiveSearch           *livesearch,
-                                                 HildonLiveSearchVisibleFunc func,
-                                                 gpointer                    data,
-                                                 GDestroyNotify              destroy)
+gboolean
+hildon_live_search_get_match                    (HildonLiveSearch *livesearch,
+                                                 GtkTreeModel     *model,
+                                                 GtkTreeIter      *iter,
+                                                 gint             *start,
+                                                 gint             *end)
 {
     HildonLiveSearchPrivate *priv;
-
-    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
-    g_return_if_fail (func != NULL);
+    HildonLiveSearchSpan *span = NULL;
+    GtkTreeIter child_iter;
+    const gchar *string;
+    gchar *string_copy;
+    gboolean cache;
+    guint hash;
+    gint s, e;
+
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), FALSE);
+    g_return_val_if_fail (GTK_IS_TREE_MODEL (model), FALSE);
+    g_return_val_if_fail (iter != NULL, FALSE);
 
     priv = livesearch->priv;
 
-    g_return_if_fail (priv->text_column == -1);
+    if (priv->prefix == NULL || priv->visible_func != NULL || priv->text_column < 0)
+        return FALSE;
 
-    if (priv->visible_destroy) {
-        priv->visible_destroy (priv->visible_data);
+    if (priv->filter != NULL && model == GTK_TREE_MODEL (priv->filter)) {
+        gtk_tree_model_filter_convert_iter_to_child_iter (priv->filter, &child_iter, iter);
+        model = gtk_tree_model_filter_get_model (priv->filter);
+        iter = &child_iter;
     }
 
-    priv->visible_func = func;
-    priv->visible_data = data;
-    priv->visible_destroy = destroy;
+    string = hildon_tree_model_peek_string (model, iter, priv->text_column, &string_copy);
+    if (string == NULL)
+        return FALSE;
 
-    if (priv->visible_func_set == FALSE) {
-        gtk_tree_model_filter_set_visible_func (priv->filter,
-                                                visible_func,
-                                                priv,
-                                                NULL);
-        priv->visible_func_set = TRUE;
+    /* Rows are told apart by their persistent iters, and the index
+     * drops the spans of the rows deleted from its model */
+    cache = (model == priv->index_model);
+    hash = g_str_hash (string);
+
+    if (cache && priv->spans != NULL) {
+        span = g_hash_table_lookup (priv->spans, iter->user_data);
+        if (span != NULL && span->hash != hash)
+            span = NULL;
     }
 
-    refilter (livesearch);
+    if (span == NULL) {
+        if (!span_compute (priv, string, &s, &e))
+            s = e = -1;
+
+        if (cache) {
+            if (priv->spans == NULL)
+                priv->spans = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+            span = g_new (HildonLiveSearchSpan, 1);
+            span->hash = hash;
+            span->start = s;
+            span->end = e;
+            g_hash_table_insert (priv->spans, iter->user_data, span);
+        }
+    } else {
+        s = span->start;
+        e = span->end;
+    }
+
+    g_free (string_copy);
+
+    if (s < 0)
+        return FALSE;
+
+    if (start)
+        *start = s;
+    if (end)
+        *end = e;
+
+    return TRUE;
+}
+
+static void
+highlight_cell_data_func                        (GtkCellLayout   *layout,
+                                                 GtkCellRenderer *cell,
+                                                 GtkTreeModel    *model,
+                                                 GtkTreeIter     *iter,
+                                                 gpointer         data)
+{
+    HildonLiveSearch *livesearch = g_weak_ref_get (data);
+    PangoAttrList *attributes = NULL;
+    gchar *text = NULL;
+    gint start, end;
+
+    if (livesearch != NULL && livesearch->priv->text_column >= 0) {
+        GtkTreeModel *child = model;
+        GtkTreeIter child_iter = *iter;
+
+        if (livesearch->priv->filter != NULL && model == GTK_TREE_MODEL (livesearch->priv->filter)) {
+            gtk_tree_model_filter_convert_iter_to_child_iter (livesearch->priv->filter,
+                                                              &child_iter, iter);
+            child = gtk_tree_model_filter_get_model (livesearch->priv->filter);
+        }
+        gtk_tree_model_get (child, &child_iter, livesearch->priv->text_column, &text, -1);
+
+        if (hildon_live_search_get_match (livesearch, model, iter, &start, &end)) {
+            PangoAttribute *bold = pango_attr_weight_new (PANGO_WEIGHT_BOLD);
+
+            bold->start_index = start;
+            bold->end_index = end;
+            attributes = pango_attr_list_new ();
+            pango_attr_list_insert (attributes, bold);
+        }
+    }
+
+    g_object_set (cell, "text", text, "attributes", attributes, NULL);
+
+    if (attributes)
+        pango_attr_list_unref (attributes);
+    g_free (text);
+    if (livesearch)
+        g_object_unref (livesearch);
+}
+
+static void
+highlight_cell_data_free                        (gpointer data)
+{
+    g_weak_ref_clear (data);
+    g_slice_free (GWeakRef, data);
 }
 
 /**
- * hildon_live_search_clean_selection_map:
+ * hildon_live_search_highlight_cell:
  * @livesearch: a #HildonLiveSearch
+ * @layout: the #GtkCellLayout @cell is packed in, e.g. a #GtkTreeViewColumn
+ * @cell: a #GtkCellRendererText
  *
- * Cleans the selection map maintained by
- * @livesearch. When used together with a #GtkTreeView,
- * #HildonLiveSearch maintains internally a selection
- * map, to make sure that selection is invariant to filtering.
+ * Makes @cell show the text of the rows, from the column set with
+ * hildon_live_search_set_text_column(), with the part matched by the
+ * current text of @livesearch in bold. The matches are those of
+ * hildon_live_search_get_match(), so the matching is not done again
+ * every time a row is drawn.
  *
- * In some cases, you might want to clean this selection mapping, to
- * ensure that after removing the entered text from @livesearch, the
- * selection is not restored. This is useful in particular when you
- * are using @livesearch with a #GtkTreeModel in a #GtkTreeView with
- * #GtkSelectionMode set to %GTK_SELECTION_SINGLE.
+ * This replaces the cell data function of @cell in @layout.
  *
- * Since: 2.2.10
+ * Since: 3.0
  **/
 void
-hildon_live_search_clean_selection_map (HildonLiveSearch * livesearch)
+hildon_live_search_highlight_cell               (HildonLiveSearch *livesearch,
+                                                 GtkCellLayout    *layout,
+                                                 GtkCellRenderer  *cell)
 {
+    GWeakRef *ref;
+
     g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+    g_return_if_fail (GTK_IS_CELL_LAYOUT (layout));
+    g_return_if_fail (GTK_IS_CELL_RENDERER_TEXT (cell));
 
-    if (livesearch->priv->selection_map) {
-        selection_map_destroy (livesearch->priv);
-        selection_map_create (livesearch->priv);
-        selection_map_update_map_from_selection (livesearch->priv);
-    }
+    ref = g_slice_new (GWeakRef);
+    g_weak_ref_init (ref, livesearch);
+
+    gtk_cell_layout_set_cell_data_func (layout, cell, highlight_cell_data_func,
+                                        ref, highlight_cell_data_free);
 }
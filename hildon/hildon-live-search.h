@@ -52,6 +52,23 @@ G_BEGIN_DECLS
                                                 HildonLiveSearchClass))
 
 
+/**
+ * HildonLiveSearchRankedColumn:
+ * @HILDON_LIVE_SEARCH_RANKED_COLUMN_TEXT: the text of the row
+ * @HILDON_LIVE_SEARCH_RANKED_COLUMN_PATH: the #GtkTreePath of the row in the child model
+ * @HILDON_LIVE_SEARCH_RANKED_N_COLUMNS: the number of columns
+ *
+ * The columns of hildon_live_search_get_ranked_model().
+ *
+ * Since: 3.0
+ **/
+typedef enum
+{
+    HILDON_LIVE_SEARCH_RANKED_COLUMN_TEXT,
+    HILDON_LIVE_SEARCH_RANKED_COLUMN_PATH,
+    HILDON_LIVE_SEARCH_RANKED_N_COLUMNS
+} HildonLiveSearchRankedColumn;
+
 typedef struct                                  _HildonLiveSearch HildonLiveSearch;
 
 typedef struct                                  _HildonLiveSearchClass HildonLiveSearchClass;
@@ -141,6 +158,76 @@ hildon_live_search_set_visible_func              (HildonLiveSearch           *li
 void
 hildon_live_search_clean_selection_map           (HildonLiveSearch * livesearch);
 
+void
+hildon_live_search_set_use_index                 (HildonLiveSearch *livesearch,
+                                                  gboolean          use_index);
+
+gboolean
+hildon_live_search_get_use_index                 (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_set_refilter_chunk            (HildonLiveSearch *livesearch,
+                                                  guint             n_rows,
+                                                  guint             max_usec);
+
+void
+hildon_live_search_set_match_substrings          (HildonLiveSearch *livesearch,
+                                                  gboolean          match_substrings);
+
+gboolean
+hildon_live_search_get_match_substrings          (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_set_parallel_match            (HildonLiveSearch *livesearch,
+                                                  gboolean          parallel_match);
+
+gboolean
+hildon_live_search_get_parallel_match            (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_set_max_ranked_results        (HildonLiveSearch *livesearch,
+                                                  guint             max_results);
+
+guint
+hildon_live_search_get_max_ranked_results        (HildonLiveSearch *livesearch);
+
+GtkTreeModel *
+hildon_live_search_get_ranked_model              (HildonLiveSearch *livesearch);
+
+guint
+hildon_live_search_get_n_matches                 (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_set_settle_delay              (HildonLiveSearch *livesearch,
+                                                  guint             delay,
+                                                  guint             max_wait);
+
+guint
+hildon_live_search_get_settle_delay              (HildonLiveSearch *livesearch,
+                                                  guint            *max_wait);
+
+gboolean
+hildon_live_search_get_match                     (HildonLiveSearch *livesearch,
+                                                  GtkTreeModel     *model,
+                                                  GtkTreeIter      *iter,
+                                                  gint             *start,
+                                                  gint             *end);
+
+void
+hildon_live_search_highlight_cell                (HildonLiveSearch *livesearch,
+                                                  GtkCellLayout    *layout,
+                                                  GtkCellRenderer  *cell);
+
+void
+hildon_live_search_add_filter                    (HildonLiveSearch   *livesearch,
+                                                  GtkTreeModelFilter *filter,
+                                                  gint                text_column,
+                                                  GtkWidget          *widget);
+
+void
+hildon_live_search_remove_filter                 (HildonLiveSearch   *livesearch,
+                                                  GtkTreeModelFilter *filter);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_LIVE_SEARCH__ */
@@ -33,6 +33,34 @@
  * you need a customized initialization of the GTK+ library you have
  * to use hildon_init() after the customized GTK+ initialization.
  *
+ * To see how much of the application startup time is spent in Hildon,
+ * set the <envar>HILDON_STARTUP_TRACE</envar> environment variable. With
+ * the value <literal>log</literal> the duration of hildon_init(), of
+ * the theme lookup, of the first window realization and of the first
+ * #HildonAppMenu preparation is logged as each of them ends. Any other
+ * value is taken as a file name, written in the Chrome trace event
+ * format when the program exits.
+ *
+ * When the library is configured with
+ * <literal>--enable-perf-counters</literal>, some widgets count the work
+ * they do: #HildonLiveSearch refilters and the rows they visit,
+ * #HildonTouchSelector::changed emissions, the client messages of
+ * #HildonRemoteTexture and #HildonAnimationActor, the synchronous X
+ * requests made by #HildonProgram and #HildonWindow, and #HildonAppMenu
+ * repacks. The counters are read with hildon_debug_get_counters(); set
+ * <envar>HILDON_PERF_COUNTERS</envar> to a number of seconds to have them
+ * logged that often.
+ *
+ * Setting <envar>HILDON_STALL_WATCHDOG</envar> to a number of
+ * milliseconds (any other value means 16) logs every main loop
+ * iteration that takes longer, with the time spent in the libhildon
+ * entry points that ran during it: #HildonLiveSearch refilters,
+ * #HildonTouchSelector::changed emissions, picker dialogs being
+ * opened, #HildonWindowStack updates, #HildonNote layouts, #HildonAppMenu
+ * popups and #HildonBanner<!-- -->s, and the perf counters that moved.
+ * It costs a clock read per iteration, so it can be left on in field
+ * tests.
+ *
  * <example>
  * <title>Typical <function>main</function> function for a Hildon application</title>
  *   <programlisting>
@@ -65,11 +93,14 @@
  */
 
 
+#include <stdlib.h>
+#include <string.h>
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
 
 #include "hildon-main.h"
 #include "hildon-stock.h"
+#include "hildon-private.h"
 
 #define GETTEXT_PACKAGE "hildon-libs"
 
@@ -86,6 +117,208 @@ static const GtkStockItem hildon_items[] = {
   { HILDON_STOCK_NEXT, N_("wdgt_bd_next"), 0, 0, GETTEXT_PACKAGE },
 };
 
+#ifdef HILDON_ENABLE_PERF_COUNTERS
+gint hildon_perf_counters[HILDON_PERF_N_COUNTERS];
+
+static const gchar *hildon_perf_counter_names[HILDON_PERF_N_COUNTERS] = {
+  "live-search-refilters",
+  "live-search-row-visits",
+  "touch-selector-changed",
+  "remote-texture-messages",
+  "animation-actor-messages",
+  "x-round-trips",
+  "app-menu-repacks",
+  "icon-cache-hits",
+  "icon-cache-misses"
+};
+
+static gboolean
+dump_perf_counters                              (gpointer data)
+{
+  GString *str = g_string_new ("perf counters:");
+  guint i;
+
+  for (i = 0; i < HILDON_PERF_N_COUNTERS; i++)
+    g_string_append_printf (str, " %s=%u", hildon_perf_counter_names[i],
+                            (guint) g_atomic_int_get (&hildon_perf_counters[i]));
+
+  g_message ("%s", str->str);
+  g_string_free (str, TRUE);
+
+  return TRUE;
+}
+#endif
+
+/*
+ * Stall watchdog.
+ *
+ * The default main context polls through watchdog_poll(), and the time
+ * from the end of a poll to the start of the next one is the time taken
+ * by the sources dispatched in between. When it is over the threshold,
+ * the stall is logged with the time spent in each libhildon entry point
+ * marked with HILDON_WATCH_ENTER() during it, and with the perf counters
+ * that moved. Entry points still running at the next poll, e.g. because
+ * they run a nested main loop, are not carried over.
+ */
+
+#define WATCHDOG_DEFAULT_MS 16
+#define WATCHDOG_MAX_SPANS 8
+
+typedef struct
+{
+  const gchar *what;
+  gint64 start;
+  gint64 total;
+  gint depth;
+} HildonWatchSpan;
+
+gboolean hildon_watchdog_active = FALSE;
+
+static GThread *watchdog_thread = NULL;
+static GPollFunc watchdog_chained_poll = NULL;
+static gint64 watchdog_threshold = 0;
+static gint64 watchdog_dispatch_start = 0;
+static HildonWatchSpan watchdog_spans[WATCHDOG_MAX_SPANS];
+static guint watchdog_n_spans = 0;
+#ifdef HILDON_ENABLE_PERF_COUNTERS
+static gint watchdog_counters[HILDON_PERF_N_COUNTERS];
+#endif
+
+static HildonWatchSpan *
+watchdog_find_span                              (const gchar *what,
+                                                 gboolean     create)
+{
+  guint i;
+
+  for (i = 0; i < watchdog_n_spans; i++)
+    if (strcmp (watchdog_spans[i].what, what) == 0)
+      return &watchdog_spans[i];
+
+  if (!create || watchdog_n_spans == WATCHDOG_MAX_SPANS)
+    return NULL;
+
+  watchdog_spans[watchdog_n_spans].what = what;
+  watchdog_spans[watchdog_n_spans].total = 0;
+  watchdog_spans[watchdog_n_spans].depth = 0;
+
+  return &watchdog_spans[watchdog_n_spans++];
+}
+
+void
+hildon_watchdog_enter                           (const gchar *what)
+{
+  HildonWatchSpan *span;
+
+  if (g_thread_self () != watchdog_thread)
+    return;
+
+  span = watchdog_find_span (what, TRUE);
+  if (span && span->depth++ == 0)
+    span->start = g_get_monotonic_time ();
+}
+
+void
+hildon_watchdog_leave                           (const gchar *what)
+{
+  HildonWatchSpan *span;
+
+  if (g_thread_self () != watchdog_thread)
+    return;
+
+  span = watchdog_find_span (what, FALSE);
+  if (span && span->depth > 0 && --span->depth == 0)
+    span->total += g_get_monotonic_time () - span->start;
+}
+
+static void
+watchdog_report                                 (gint64 now)
+{
+  GString *str = g_string_new (NULL);
+  guint i;
+
+  g_string_printf (str, "main loop stalled for %.1f ms",
+                   (now - watchdog_dispatch_start) / 1000.0);
+
+  if (watchdog_n_spans == 0)
+    g_string_append (str, " outside of libhildon");
+
+  for (i = 0; i < watchdog_n_spans; i++) {
+    HildonWatchSpan *span = &watchdog_spans[i];
+    gint64 total = span->total + (span->depth > 0 ? now - span->start : 0);
+
+    g_string_append_printf (str, "%s %s (%.1f ms)", i == 0 ? " in" : ",",
+                            span->what, total / 1000.0);
+  }
+
+#ifdef HILDON_ENABLE_PERF_COUNTERS
+  for (i = 0; i < HILDON_PERF_N_COUNTERS; i++) {
+    gint delta = g_atomic_int_get (&hildon_perf_counters[i]) - watchdog_counters[i];
+
+    if (delta != 0)
+      g_string_append_printf (str, " %s+%d", hildon_perf_counter_names[i], delta);
+  }
+#endif
+
+  g_message ("%s", str->str);
+  g_string_free (str, TRUE);
+}
+
+static gint
+watchdog_poll                                   (GPollFD *ufds,
+                                                 guint    nfds,
+                                                 gint     timeout)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint ret;
+
+  if (watchdog_dispatch_start != 0 &&
+      now - watchdog_dispatch_start >= watchdog_threshold)
+    watchdog_report (now);
+
+  ret = watchdog_chained_poll (ufds, nfds, timeout);
+
+  watchdog_n_spans = 0;
+#ifdef HILDON_ENABLE_PERF_COUNTERS
+  {
+    guint i;
+
+    for (i = 0; i < HILDON_PERF_N_COUNTERS; i++)
+      watchdog_counters[i] = g_atomic_int_get (&hildon_perf_counters[i]);
+  }
+#endif
+  watchdog_dispatch_start = g_get_monotonic_time ();
+
+  return ret;
+}
+
+static void
+watchdog_start                                  (void)
+{
+  const gchar *env = g_getenv ("HILDON_STALL_WATCHDOG");
+  gint threshold;
+
+  if (env == NULL || *env == '\0')
+    return;
+
+  threshold = atoi (env);
+  if (threshold <= 0)
+    threshold = WATCHDOG_DEFAULT_MS;
+
+  watchdog_threshold = threshold * (gint64) 1000;
+  watchdog_thread = g_thread_self ();
+  watchdog_chained_poll = g_main_context_get_poll_func (NULL);
+  g_main_context_set_poll_func (NULL, watchdog_poll);
+  hildon_watchdog_active = TRUE;
+}
+
+static gboolean
+cache_sounds_idle                               (gpointer data)
+{
+  hildon_note_cache_sounds ();
+
+  return FALSE;
+}
+
 /**
  * hildon_init:
  *
@@ -106,6 +339,8 @@ hildon_init (void)
     initialized = TRUE;
   }
 
+  hildon_trace_begin ("hildon_init");
+
   /* Register icon sizes - DEPRECIATED! */
   //gtk_icon_size_register ("hildon-xsmall", 16, 16);
   //gtk_icon_size_register ("hildon-small", 24, 24);
@@ -116,7 +351,165 @@ hildon_init (void)
   //gtk_icon_size_register ("hildon-xlarge", 128, 128);
 
   /* Add Hildon stock items */
+  hildon_trace_begin ("stock-items");
   gtk_stock_add_static (hildon_items, G_N_ELEMENTS (hildon_items));
+  hildon_trace_end ("stock-items");
+
+  /* No style sheet is loaded here. The names and classes the Hildon
+   * widgets use are styled by the theme, which GTK+ parses by itself,
+   * and GTK+ can only load CSS as text, from a GResource or not. The
+   * only CSS made by libhildon, for the logical colors and fonts, is
+   * parsed once per style sheet and shared; see hildon-helper.c */
+
+  /* Preload the note sounds once the application is up and running.
+   * The system sound volume is only read when a sound is played */
+  gdk_threads_add_idle_full (G_PRIORITY_LOW, cache_sounds_idle, NULL, NULL);
+
+#ifdef HILDON_ENABLE_PERF_COUNTERS
+  {
+    const gchar *env = g_getenv ("HILDON_PERF_COUNTERS");
+    guint interval = env ? atoi (env) : 0;
+
+    if (interval > 0)
+      gdk_threads_add_timeout_seconds (interval, dump_perf_counters, NULL);
+  }
+#endif
+
+  watchdog_start ();
+
+  hildon_trace_end ("hildon_init");
+}
+
+typedef struct
+{
+  gchar **names;
+  gint size;
+  guint next;
+} HildonIconPrefetch;
+
+/* GtkIconInfo references, which keep the loaded pixbufs in the icon
+ * theme cache */
+static GSList *prefetched_icons = NULL;
+
+static void
+purge_prefetched_icons                          (gpointer data)
+{
+  g_slist_free_full (prefetched_icons, g_object_unref);
+  prefetched_icons = NULL;
+
+  hildon_remove_purge_func (purge_prefetched_icons, NULL);
+}
+
+static void
+icon_prefetch_free                              (gpointer data)
+{
+  HildonIconPrefetch *prefetch = data;
+
+  g_strfreev (prefetch->names);
+  g_slice_free (HildonIconPrefetch, prefetch);
+}
+
+static gboolean
+prefetch_icons_idle                             (gpointer data)
+{
+  HildonIconPrefetch *prefetch = data;
+  GtkIconInfo *info;
+
+  info = gtk_icon_theme_lookup_icon (gtk_icon_theme_get_default (),
+                                     prefetch->names[prefetch->next++],
+                                     prefetch->size, 0);
+  if (info) {
+    GdkPixbuf *pixbuf = gtk_icon_info_load_icon (info, NULL);
+
+    if (pixbuf)
+      g_object_unref (pixbuf);
+
+    if (prefetched_icons == NULL)
+      hildon_add_purge_func (purge_prefetched_icons, NULL);
+    prefetched_icons = g_slist_prepend (prefetched_icons, info);
+  }
+
+  return prefetch->names[prefetch->next] != NULL;
+}
+
+/**
+ * hildon_prefetch_icons:
+ * @icon_names: a %NULL-terminated array of icon names
+ * @pixel_size: the size the icons will be used at, in pixels
+ *
+ * Loads @icon_names from the default icon theme in the background, one
+ * icon per low priority idle. Low priority idles run after redrawing,
+ * so calling this before showing the first window keeps the icon theme
+ * I/O out of the first frame. Widgets later showing these icons at
+ * @pixel_size, like the images of #HildonButton<!-- -->s, find them
+ * in memory. The icons stay loaded until hildon_program_purge_caches()
+ * is called.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_prefetch_icons                           (const gchar * const *icon_names,
+                                                 gint                 pixel_size)
+{
+  HildonIconPrefetch *prefetch;
+
+  g_return_if_fail (icon_names != NULL);
+  g_return_if_fail (pixel_size > 0);
+
+  if (icon_names[0] == NULL)
+    return;
+
+  prefetch = g_slice_new (HildonIconPrefetch);
+  prefetch->names = g_strdupv ((gchar **) icon_names);
+  prefetch->size = pixel_size;
+  prefetch->next = 0;
+
+  gdk_threads_add_idle_full (G_PRIORITY_LOW, prefetch_icons_idle,
+                             prefetch, icon_prefetch_free);
+}
+
+/**
+ * hildon_debug_get_counters:
+ * @n_counters: return location for the number of counters
+ *
+ * Reads the counters of the work done by some widgets: refilters of
+ * #HildonLiveSearch and the rows they visit, #HildonTouchSelector::changed
+ * emissions, client messages of #HildonRemoteTexture and
+ * #HildonAnimationActor, synchronous X requests made by #HildonProgram
+ * and #HildonWindow, and #HildonAppMenu repacks. The counters are only
+ * available when the library was configured with
+ * <literal>--enable-perf-counters</literal>.
+ *
+ * Returns: a newly allocated array of @n_counters counters, to be freed
+ * with g_free(), or %NULL if the counters were not compiled in.
+ *
+ * Since: 3.0
+ **/
+HildonDebugCounter *
+hildon_debug_get_counters                       (guint *n_counters)
+{
+#ifdef HILDON_ENABLE_PERF_COUNTERS
+  HildonDebugCounter *counters;
+  guint i;
+
+  g_return_val_if_fail (n_counters != NULL, NULL);
+
+  counters = g_new (HildonDebugCounter, HILDON_PERF_N_COUNTERS);
+  for (i = 0; i < HILDON_PERF_N_COUNTERS; i++) {
+    counters[i].name = hildon_perf_counter_names[i];
+    counters[i].value = g_atomic_int_get (&hildon_perf_counters[i]);
+  }
+
+  *n_counters = HILDON_PERF_N_COUNTERS;
+
+  return counters;
+#else
+  g_return_val_if_fail (n_counters != NULL, NULL);
+
+  *n_counters = 0;
+
+  return NULL;
+#endif
 }
 
 /**
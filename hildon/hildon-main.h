@@ -25,4 +25,24 @@ G_BEGIN_DECLS
 void hildon_init     (void);
 void hildon_gtk_init (int *argc, char ***argv);
 
+void hildon_prefetch_icons (const gchar * const *icon_names,
+                            gint                 pixel_size);
+
+/**
+ * HildonDebugCounter:
+ * @name: the name of the counter, e.g. "live-search-refilters"
+ * @value: how many times the counted event happened
+ *
+ * A counter returned by hildon_debug_get_counters().
+ *
+ * Since: 3.0
+ */
+typedef struct
+{
+  const gchar *name;
+  guint value;
+} HildonDebugCounter;
+
+HildonDebugCounter *hildon_debug_get_counters (guint *n_counters);
+
 G_END_DECLS
@@ -49,6 +49,9 @@ struct                                          _HildonNotePrivate
     gchar *original_description;
     guint idle_handler;
 
+    HildonNoteProgress *progress;
+    guint progress_tick_id;
+
   /* These strings stored for backwards compatibility */
     gchar *icon;
     gchar *stock_icon;
@@ -85,6 +85,7 @@
 #endif
 
 #include                                        <stdio.h>
+#include                                        <math.h>
 #include                                        <string.h>
 #include                                        <libintl.h>
 #include                                        <X11/X.h>
@@ -98,6 +99,7 @@
 #include                                        "hildon-stock.h"
 #include                                        "hildon-enum-types.h"
 #include                                        "hildon-note-private.h"
+#include                                        "hildon-private.h"
 
 #define                                         HILDON_INFORMATION_NOTE_MIN_HEIGHT 140
 
@@ -188,6 +190,94 @@ event_box_press_event                           (GtkEventBox    *event_box,
     }
 }
 
+/* The fraction is stored as an integer so that it can be updated
+ * atomically */
+#define                                         PROGRESS_SCALE (1 << 20)
+
+struct                                          _HildonNoteProgress
+{
+    volatile gint ref_count;
+    volatile gint fraction;
+    volatile gint dirty;
+    GWeakRef note;
+    GCancellable *cancellable;
+};
+
+G_DEFINE_BOXED_TYPE (HildonNoteProgress, hildon_note_progress,
+                     hildon_note_progress_ref, hildon_note_progress_unref)
+
+/* Samples the progress on the next frame, and only moves the bar when
+ * it would move by at least a pixel. The tick then removes itself, so
+ * the frame clock does not keep running while no progress is reported;
+ * hildon_note_progress_set_fraction() adds it back */
+static gboolean
+progress_tick                                   (GtkWidget     *bar,
+                                                 GdkFrameClock *clock,
+                                                 gpointer       data)
+{
+    HildonNotePrivate *priv = data;
+    gdouble fraction, shown;
+    gint width;
+
+    /* Clear the flag before sampling, so a fraction reported after the
+     * sample queues a new tick */
+    g_atomic_int_set (&priv->progress->dirty, 0);
+
+    fraction = (gdouble) g_atomic_int_get (&priv->progress->fraction) / PROGRESS_SCALE;
+    shown = gtk_progress_bar_get_fraction (GTK_PROGRESS_BAR (bar));
+    width = gtk_widget_get_allocated_width (bar);
+
+    if (fraction != shown &&
+        (fabs (fraction - shown) * width >= 1.0 || fraction == 0.0 || fraction == 1.0))
+        gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (bar), fraction);
+
+    priv->progress_tick_id = 0;
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+progress_attach                                 (HildonNotePrivate *priv)
+{
+    if (priv->progress && priv->progressbar && priv->progress_tick_id == 0)
+        priv->progress_tick_id = gtk_widget_add_tick_callback (priv->progressbar,
+                                                               progress_tick,
+                                                               priv, NULL);
+}
+
+static void
+progress_detach                                 (HildonNotePrivate *priv)
+{
+    if (priv->progress_tick_id) {
+        gtk_widget_remove_tick_callback (priv->progressbar, priv->progress_tick_id);
+        priv->progress_tick_id = 0;
+    }
+}
+
+static gboolean
+progress_wake                                   (gpointer data)
+{
+    HildonNoteProgress *progress = data;
+    HildonNote *note = g_weak_ref_get (&progress->note);
+
+    if (note) {
+        progress_attach (HILDON_NOTE_GET_PRIVATE (note));
+        g_object_unref (note);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+progress_note_response                          (GtkDialog *dialog,
+                                                 gint response_id,
+                                                 HildonNoteProgress *progress)
+{
+    if (response_id == GTK_RESPONSE_CANCEL ||
+        response_id == GTK_RESPONSE_DELETE_EVENT)
+        g_cancellable_cancel (progress->cancellable);
+}
+
 static void
 hildon_note_set_property                        (GObject *object,
                                                  guint prop_id,
@@ -204,6 +294,9 @@ hildon_note_set_property                        (GObject *object,
     switch (prop_id) {
 
         case PROP_HILDON_NOTE_TYPE:
+            /* The layout is only built once the type is first set */
+            if (priv->note_n == g_value_get_enum (value) && priv->box != NULL)
+                break;
             priv->note_n = g_value_get_enum (value);
 	    hildon_note_rename (note);
             hildon_note_rebuild (note);
@@ -237,6 +330,8 @@ hildon_note_set_property                        (GObject *object,
             widget = g_value_get_object (value);
             if (widget != priv->progressbar)
             {
+                progress_detach (priv);
+
                 if (priv->progressbar)
                     g_object_unref (priv->progressbar);
 
@@ -247,6 +342,7 @@ hildon_note_set_property                        (GObject *object,
                     g_object_ref_sink (G_OBJECT (widget));
                 }
 
+                progress_attach (priv);
                 hildon_note_rebuild (note);
             }
             break;
@@ -454,10 +550,19 @@ hildon_note_finalize                            (GObject *obj_self)
         priv->stock_icon = NULL;
     }
     if (priv->idle_handler) {
-        g_source_remove (priv->idle_handler);
+        hildon_job_remove (priv->idle_handler);
         priv->idle_handler = 0;
     }
 
+    progress_detach (priv);
+
+    if (priv->progress) {
+        /* Nobody is watching the progress anymore */
+        g_cancellable_cancel (priv->progress->cancellable);
+        hildon_note_progress_unref (priv->progress);
+        priv->progress = NULL;
+    }
+
     if (priv->progressbar)
         g_object_unref (priv->progressbar);
 
@@ -490,7 +595,7 @@ hildon_note_orientation_update (HildonNote *note, GdkScreen *screen)
 //    HildonNotePrivate* priv = HILDON_NOTE_GET_PRIVATE (note);
 //    GtkWidget *parent;
 //    gint button_width, padding;
-    gboolean portrait = gdk_screen_get_width (screen) < gdk_screen_get_height (screen);
+    gboolean portrait = hildon_get_screen_geometry (screen)->portrait;
 
 //    g_object_ref (gtk_dialog_get_action_area (dialog));
 //    unpack_widget (gtk_dialog_get_action_area (dialog));
@@ -526,16 +631,16 @@ hildon_note_get_preferred_width (GtkWidget *note,
 }
 
 static void
-screen_size_changed                            (GdkScreen *screen,
-                                                GtkWidget *note)
+screen_size_changed                            (GtkWidget                  *note,
+                                                const HildonScreenGeometry *geometry)
 {
     HildonNotePrivate *priv = HILDON_NOTE_GET_PRIVATE (note);
+    GdkScreen *screen = gtk_widget_get_screen (note);
 
     hildon_note_rename (HILDON_NOTE (note));
 
     if (priv->note_n == HILDON_NOTE_TYPE_INFORMATION) {
-        gint screen_width = gdk_screen_get_width (screen);
-        gint text_width = screen_width - HILDON_INFORMATION_NOTE_MARGIN * 2;
+        gint text_width = geometry->width - HILDON_INFORMATION_NOTE_MARGIN * 2;
         g_object_set (priv->label, "width-request", text_width, NULL);
 
         return;
@@ -562,7 +667,7 @@ hildon_note_realize                             (GtkWidget *widget)
 
     /* Set the _HILDON_NOTIFICATION_TYPE property so Matchbox places the window correctly */
     display = gdk_window_get_display (gtk_widget_get_window (widget));
-    atom = gdk_x11_get_xatom_by_name_for_display (display, "_HILDON_NOTIFICATION_TYPE");
+    atom = hildon_get_xatom (display, HILDON_ATOM_HILDON_NOTIFICATION_TYPE);
 
     if (priv->note_n == HILDON_NOTE_TYPE_INFORMATION) {
         notification_type = "_HILDON_NOTIFICATION_TYPE_INFO";
@@ -579,9 +684,8 @@ hildon_note_realize                             (GtkWidget *widget)
 //        g_signal_connect (priv->label, "size-request", G_CALLBACK (label_size_request), widget);
     }
 
-    GdkScreen *screen = gtk_widget_get_screen (widget);
-    g_signal_connect (screen, "size-changed", G_CALLBACK (screen_size_changed), widget);
-    screen_size_changed (screen, widget);
+    hildon_watch_screen (widget, screen_size_changed);
+    screen_size_changed (widget, hildon_get_screen_geometry (gtk_widget_get_screen (widget)));
 
     hildon_gtk_window_set_portrait_flags (GTK_WINDOW (widget), HILDON_PORTRAIT_MODE_SUPPORT);
 }
@@ -590,9 +694,8 @@ static void
 hildon_note_unrealize                           (GtkWidget *widget)
 {
     HildonNotePrivate *priv = HILDON_NOTE_GET_PRIVATE (widget);
-    GdkScreen *screen = gtk_widget_get_screen (widget);
 
-    g_signal_handlers_disconnect_by_func (screen, G_CALLBACK (screen_size_changed), widget);
+    hildon_unwatch_screen (widget);
     g_signal_handlers_disconnect_by_func (priv->label, G_CALLBACK (label_size_request), widget);
 
     GTK_WIDGET_CLASS (parent_class)->unrealize (widget);
@@ -622,7 +725,7 @@ hildon_note_rename                              (HildonNote *note)
   GEnumClass *enum_class;
   gchar *name;
   GdkScreen *screen = gtk_widget_get_screen (GTK_WIDGET (note));
-  gboolean portrait = gdk_screen_get_width (screen) < gdk_screen_get_height (screen);
+  gboolean portrait = hildon_get_screen_geometry (screen)->portrait;
   const gchar *portrait_suffix = portrait ? "-portrait" : NULL;
 
   HildonNotePrivate *priv = HILDON_NOTE_GET_PRIVATE (note);
@@ -641,12 +744,30 @@ hildon_note_rename                              (HildonNote *note)
   g_type_class_unref (enum_class);
 }
 
+/* Removes the children of the layout box other than the label and the
+ * current progress bar */
+static void
+unpack_stale_child                              (GtkWidget *child,
+                                                 gpointer   data)
+{
+    HildonNotePrivate *priv = data;
+
+    if (child != priv->label && child != priv->progressbar)
+        gtk_container_remove (GTK_CONTAINER (priv->box), child);
+}
+
+/*
+  Updates the buttons and the layout for the note type and progress bar.
+  The widgets that the new type still needs are kept, so changing the
+  type or the progress bar of a shown note only creates what is missing.
+*/
 static void
 hildon_note_rebuild                             (HildonNote *note)
 {
     GtkDialog *dialog;
     HildonNotePrivate *priv;
-//    gboolean is_info_note = FALSE;
+    gboolean need_ok, need_cancel;
+    const gchar *cancel_label;
 
     g_assert (HILDON_IS_NOTE (note));
 
@@ -655,85 +776,101 @@ hildon_note_rebuild                             (HildonNote *note)
 
     dialog = GTK_DIALOG (note);
 
-    /* Reuse exiting content widgets for new layout */
-    unpack_widget (priv->label);
-    unpack_widget (priv->progressbar);
-    unpack_widget (priv->event_box);
+    HILDON_WATCH_ENTER ("note-rebuild");
 
-    /* Destroy old layout and buttons */
-    if (priv->box) {
-        gtk_widget_destroy (priv->box);
-        priv->box = NULL;
+    /* Add needed buttons for each note type */
+    switch (priv->note_n)
+    {
+        case HILDON_NOTE_TYPE_CONFIRMATION:
+            need_ok = need_cancel = TRUE;
+            cancel_label = HILDON_STOCK_NO;
+            break;
+
+        case HILDON_NOTE_TYPE_PROGRESSBAR:
+            need_ok = FALSE;
+            need_cancel = TRUE;
+            cancel_label = HILDON_STOCK_STOP;
+            break;
+
+        case HILDON_NOTE_TYPE_INFORMATION:
+        case HILDON_NOTE_TYPE_CONFIRMATION_BUTTON:
+        default:
+            need_ok = need_cancel = FALSE;
+            cancel_label = NULL;
+            break;
     }
-    if (priv->okButton) {
+
+    /* An OK button added after the cancel one would be in the wrong
+     * place, so replace both */
+    if (need_ok && priv->okButton == NULL && priv->cancelButton != NULL) {
+        gtk_widget_destroy (priv->cancelButton);
+        priv->cancelButton = NULL;
+    }
+
+    if (!need_ok && priv->okButton) {
         gtk_widget_destroy (priv->okButton);
         priv->okButton = NULL;
     }
-    if (priv->cancelButton) {
+    if (!need_cancel && priv->cancelButton) {
         gtk_widget_destroy (priv->cancelButton);
         priv->cancelButton = NULL;
     }
 
-    /* Add needed buttons and images for each note type */
-    switch (priv->note_n)
-    {
-        case HILDON_NOTE_TYPE_CONFIRMATION:
+    /* Reused buttons get back their default labels */
+    if (need_ok) {
+        if (priv->okButton) {
+            gtk_button_set_label (GTK_BUTTON (priv->okButton), HILDON_STOCK_YES);
+        } else {
             priv->okButton = gtk_dialog_add_button (dialog,
-		    HILDON_STOCK_YES, GTK_RESPONSE_OK);
-            priv->cancelButton = gtk_dialog_add_button (dialog,
-                    HILDON_STOCK_NO, GTK_RESPONSE_CANCEL);
-            gtk_widget_show (priv->cancelButton);
+                    HILDON_STOCK_YES, GTK_RESPONSE_OK);
             g_object_get (priv->okButton, "width-request",
                           &priv->button_width, NULL);
-            gtk_widget_set_no_show_all (priv->cancelButton, FALSE);
-            break;
-
-        case HILDON_NOTE_TYPE_PROGRESSBAR:
+        }
+    }
+    if (need_cancel) {
+        if (priv->cancelButton) {
+            gtk_button_set_label (GTK_BUTTON (priv->cancelButton), cancel_label);
+        } else {
             priv->cancelButton = gtk_dialog_add_button (dialog,
-                    HILDON_STOCK_STOP, GTK_RESPONSE_CANCEL);
+                    cancel_label, GTK_RESPONSE_CANCEL);
             gtk_widget_show (priv->cancelButton);
             gtk_widget_set_no_show_all (priv->cancelButton, FALSE);
-            break;
-
-        case HILDON_NOTE_TYPE_INFORMATION:
-            //is_info_note = TRUE;
-            break;
-
-        case HILDON_NOTE_TYPE_CONFIRMATION_BUTTON:
-        default:
-            break;
+        }
     }
 
-    /* Don't display the action area if this is just an information
-     * note. This prevents text from being slightly aligned to the
-     * left
-     */
-//    if (is_info_note) {
-//        gtk_widget_hide (gtk_dialog_get_action_area (dialog));
-//    } else {
-//        gtk_widget_show (gtk_dialog_get_action_area (dialog));
-//    }
-//    gtk_widget_set_no_show_all (gtk_dialog_get_action_area (dialog), is_info_note);
-
     /* Pack label vertically. Spacing is only necessary for the progressbar note. */
-    priv->box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
-    gtk_container_add (GTK_CONTAINER (priv->event_box), priv->box);
-    gtk_box_pack_start (GTK_BOX (priv->box), priv->label, TRUE, TRUE, 0);
+    if (priv->box == NULL) {
+        priv->box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+        gtk_container_add (GTK_CONTAINER (priv->event_box), priv->box);
+    } else {
+        gtk_container_foreach (GTK_CONTAINER (priv->box), unpack_stale_child, priv);
+    }
+
+    if (gtk_widget_get_parent (priv->label) != priv->box) {
+        unpack_widget (priv->label);
+        gtk_box_pack_start (GTK_BOX (priv->box), priv->label, TRUE, TRUE, 0);
+    }
 
     if (priv->progressbar) {
         gtk_widget_set_halign(priv->label, GTK_ALIGN_START);
         gtk_widget_set_valign(priv->label, GTK_ALIGN_FILL);
         gtk_widget_set_margin_top (priv->event_box, HILDON_MARGIN_DOUBLE);
-        gtk_box_pack_start (GTK_BOX (priv->box), priv->progressbar, FALSE, FALSE, 0);
+        if (gtk_widget_get_parent (priv->progressbar) != priv->box) {
+            unpack_widget (priv->progressbar);
+            gtk_box_pack_start (GTK_BOX (priv->box), priv->progressbar, FALSE, FALSE, 0);
+        }
     } else {
         gtk_widget_set_halign(priv->label, GTK_ALIGN_FILL);
         gtk_widget_set_valign(priv->label, GTK_ALIGN_FILL);
         gtk_widget_set_margin_top (priv->event_box, 0);
     }
 
-    gtk_container_add (GTK_CONTAINER (gtk_dialog_get_content_area (dialog)), priv->event_box);
+    if (gtk_widget_get_parent (priv->event_box) == NULL)
+        gtk_container_add (GTK_CONTAINER (gtk_dialog_get_content_area (dialog)), priv->event_box);
 
     gtk_widget_show_all (priv->event_box);
+
+    HILDON_WATCH_LEAVE ("note-rebuild");
 }
 
 /**
@@ -980,7 +1117,18 @@ on_show_cb                                      (GtkWidget *widget,
     HildonNotePrivate *priv;
 
     priv = HILDON_NOTE_GET_PRIVATE (widget);
-    priv->idle_handler = gdk_threads_add_idle (sound_handling, widget);
+    if (priv->idle_handler == 0)
+        priv->idle_handler = hildon_job_add (widget, HILDON_JOB_PRIORITY_HIGH, 0,
+                                             sound_handling, widget, NULL);
+}
+
+/* Uploads the note sounds to the sound server, so that the first note
+ * doesn't have to wait for them to be decoded; see hildon_init() */
+void
+hildon_note_cache_sounds                        (void)
+{
+    hildon_cache_system_sound (INFORMATION_SOUND_PATH);
+    hildon_cache_system_sound (CONFIRMATION_SOUND_PATH);
 }
 
 /* We play a system sound when the note comes visible */
@@ -1009,3 +1157,135 @@ sound_handling                                  (gpointer data)
 
     return FALSE;
 }
+
+/**
+ * hildon_note_get_progress:
+ * @note: a #HildonNote with a progress bar, see
+ * hildon_note_new_cancel_with_progress_bar()
+ *
+ * Gets the #HildonNoteProgress of @note. Worker threads can report
+ * their progress with hildon_note_progress_set_fraction() as often as
+ * they like: the note reads the last reported fraction on the next
+ * frame, and only redraws the progress bar when it moves by a pixel or
+ * more. While no progress is reported, the note does not wake up.
+ *
+ * The #GCancellable returned by hildon_note_progress_get_cancellable()
+ * is cancelled when the user cancels @note, or when @note is finalized.
+ *
+ * Returns: a new reference to the progress of @note, to be released
+ * with hildon_note_progress_unref(), or %NULL if @note has no progress
+ * bar
+ *
+ * Since: 3.0
+ **/
+HildonNoteProgress *
+hildon_note_get_progress                        (HildonNote *note)
+{
+    HildonNotePrivate *priv;
+
+    g_return_val_if_fail (HILDON_IS_NOTE (note), NULL);
+
+    priv = HILDON_NOTE_GET_PRIVATE (note);
+    g_return_val_if_fail (priv->progressbar != NULL, NULL);
+
+    if (priv->progress == NULL) {
+        priv->progress = g_slice_new (HildonNoteProgress);
+        priv->progress->ref_count = 1;
+        priv->progress->fraction = gtk_progress_bar_get_fraction
+            (GTK_PROGRESS_BAR (priv->progressbar)) * PROGRESS_SCALE;
+        priv->progress->dirty = 0;
+        g_weak_ref_init (&priv->progress->note, note);
+        priv->progress->cancellable = g_cancellable_new ();
+
+        g_signal_connect (note, "response",
+                          G_CALLBACK (progress_note_response), priv->progress);
+        progress_attach (priv);
+    }
+
+    return hildon_note_progress_ref (priv->progress);
+}
+
+/**
+ * hildon_note_progress_ref:
+ * @progress: a #HildonNoteProgress
+ *
+ * Adds a reference to @progress. This function is thread-safe.
+ *
+ * Returns: @progress
+ *
+ * Since: 3.0
+ **/
+HildonNoteProgress *
+hildon_note_progress_ref                        (HildonNoteProgress *progress)
+{
+    g_return_val_if_fail (progress != NULL, NULL);
+
+    g_atomic_int_inc (&progress->ref_count);
+
+    return progress;
+}
+
+/**
+ * hildon_note_progress_unref:
+ * @progress: a #HildonNoteProgress
+ *
+ * Releases a reference to @progress. This function is thread-safe.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_note_progress_unref                      (HildonNoteProgress *progress)
+{
+    g_return_if_fail (progress != NULL);
+
+    if (g_atomic_int_dec_and_test (&progress->ref_count)) {
+        g_weak_ref_clear (&progress->note);
+        g_object_unref (progress->cancellable);
+        g_slice_free (HildonNoteProgress, progress);
+    }
+}
+
+/**
+ * hildon_note_progress_set_fraction:
+ * @progress: a #HildonNoteProgress
+ * @fraction: the fraction of the work done, between 0.0 and 1.0
+ *
+ * Reports the progress of the work shown by a note. This function can
+ * be called from any thread, and is cheap enough to be called for every
+ * unit of work done.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_note_progress_set_fraction               (HildonNoteProgress *progress,
+                                                 gdouble fraction)
+{
+    g_return_if_fail (progress != NULL);
+
+    g_atomic_int_set (&progress->fraction, CLAMP (fraction, 0.0, 1.0) * PROGRESS_SCALE);
+
+    /* Only the first report after the last frame wakes the note up */
+    if (g_atomic_int_compare_and_exchange (&progress->dirty, 0, 1))
+        g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, progress_wake,
+                         hildon_note_progress_ref (progress),
+                         (GDestroyNotify) hildon_note_progress_unref);
+}
+
+/**
+ * hildon_note_progress_get_cancellable:
+ * @progress: a #HildonNoteProgress
+ *
+ * Gets the #GCancellable that tells when the work reported to
+ * @progress is not wanted anymore.
+ *
+ * Returns: a #GCancellable owned by @progress
+ *
+ * Since: 3.0
+ **/
+GCancellable *
+hildon_note_progress_get_cancellable            (HildonNoteProgress *progress)
+{
+    g_return_val_if_fail (progress != NULL, NULL);
+
+    return progress->cancellable;
+}
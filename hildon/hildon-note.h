@@ -109,6 +109,38 @@ typedef enum
     HILDON_NOTE_TYPE_PROGRESSBAR
 }                                               HildonNoteType;
 
+/**
+ * HildonNoteProgress:
+ *
+ * The progress of a progress bar note, which can be updated from any
+ * thread. See hildon_note_get_progress().
+ *
+ * Since: 3.0
+ */
+typedef struct                                  _HildonNoteProgress HildonNoteProgress;
+
+#define                                         HILDON_TYPE_NOTE_PROGRESS \
+                                                (hildon_note_progress_get_type ())
+
+GType
+hildon_note_progress_get_type                   (void) G_GNUC_CONST;
+
+HildonNoteProgress *
+hildon_note_get_progress                        (HildonNote *note);
+
+HildonNoteProgress *
+hildon_note_progress_ref                        (HildonNoteProgress *progress);
+
+void
+hildon_note_progress_unref                      (HildonNoteProgress *progress);
+
+void
+hildon_note_progress_set_fraction               (HildonNoteProgress *progress,
+                                                 gdouble fraction);
+
+GCancellable *
+hildon_note_progress_get_cancellable            (HildonNoteProgress *progress);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_NOTE_H__ */
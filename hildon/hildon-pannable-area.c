@@ -52,6 +52,7 @@
 #include "hildon-pannable-area.h"
 #include "hildon-marshalers.h"
 #include "hildon-enum-types.h"
+#include "hildon-private.h"
 
 #define SCROLL_BAR_MIN_SIZE 5
 #define RATIO_TOLERANCE 0.000001
@@ -65,6 +66,29 @@
 #define ACCEL_FACTOR 27
 #define MIN_ACCEL_THRESHOLD 40
 #define FAST_CLICK 125
+#define KINETIC_MAX_FRAME_TIME 0.1
+#define KINETIC_MIN_CURVE_TIME 0.05
+#define BOUNCE_STIFFNESS 12.0
+#define BOUNCE_VELOCITY_FACTOR 0.3
+#define EDGE_GLOW_ALPHA 0.25
+#define DRAG_SAMPLES 8
+#define DRAG_SAMPLE_WINDOW 100
+#define GESTURE_MIN_SAMPLES 3
+#define GESTURE_MIN_DISTANCE 6
+#define GESTURE_DIRECTION_RATIO 2.0
+#define GESTURE_FLICK_VELOCITY 300
+
+/* Drag offset at the time of a motion event, in ms */
+typedef struct {
+  guint32 time;
+  gdouble x;
+  gdouble y;
+} DragSample;
+
+/* Areas sharing the adjustment of one axis */
+typedef struct {
+  GSList *members;
+} AreaLink;
 
 struct _HildonPannableAreaPrivate {
   HildonPannableAreaMode mode;
@@ -149,6 +173,13 @@ struct _HildonPannableAreaPrivate {
 
   gboolean center_on_child_focus;
   gboolean center_on_child_focus_pending;
+  guint focus_tick_id;
+
+  /* Row being scrolled to by hildon_pannable_area_scroll_to_row() */
+  GtkTreeView *row_view;
+  GtkTreeRowReference *row_ref;
+  gint row_target_y;
+  guint row_tick_id;
 
   gboolean selection_movement;
 
@@ -163,22 +194,94 @@ struct _HildonPannableAreaPrivate {
 
   gdouble hsource;
   gdouble htarget;
+  gdouble hsource_vel;	/* Velocity at the start of the curve, in px/s */
   gdouble vsource;
   gdouble vtarget;
+  gdouble vsource_vel;
 
   guint duration;
   gint64 start_time;
   gint64 end_time;
   guint tick_id;
   GdkFrameClock *clock;
+
+  GtkGesture *drag_gesture;
+  gboolean kinetic;
+  gint64 last_frame_time;
+  gdouble drag_hvalue;
+  gdouble drag_vvalue;
+
+  guint prediction_time;
+  GdkRectangle predicted_viewport;
+
+  gboolean scrolling;
+
+  gboolean cache_content;
+  cairo_surface_t *cache_surface;
+  GdkRectangle cache_rect;	/* Cached part, in viewport bin window coordinates */
+  gint cache_content_width;
+  gint cache_content_height;
+
+  GArray *hit_entries;		/* HitEntry, sorted by rect.y */
+  gint *hit_max_end;		/* Implicit interval tree over hit_entries */
+  gboolean hit_index_valid;
+
+  gboolean animating;
+  gboolean animating_axis[2];	/* Indexed by GtkOrientation */
+  gboolean bouncing;
+  gint64 bounce_time;
+  gdouble overshoot_x;		/* How far past the bounds the content is pulled */
+  gdouble overshoot_y;
+  gdouble overshoot_vel_x;
+  gdouble overshoot_vel_y;
+  cairo_surface_t *overshoot_surface;
+
+  gboolean drag_pending;	/* A motion waits for the next frame */
+  gdouble pending_offset_x;
+  gdouble pending_offset_y;
+  DragSample drag_samples[DRAG_SAMPLES];
+  guint n_drag_samples;
+  guint drag_sample_head;
+
+  /* The gesture recognizer sees the motion on both axes from the
+   * press on, before the panning threshold */
+  DragSample gesture_samples[DRAG_SAMPLES];
+  guint n_gesture_samples;
+  guint gesture_sample_head;
+  gint gesture_direction;	/* Predicted HildonMovementDirection, or -1 */
+  gboolean gesture_confirmed;
+
+  AreaLink *links[2];		/* Indexed by GtkOrientation */
+
+  gboolean record_frame_stats;
+  HildonPannableAreaFrameStats frame_stats;	/* Cumulative */
+  HildonPannableAreaFrameStats session_stats;
+  GdkFrameClock *stats_clock;
+  gulong stats_paint_id;
+  gint64 stats_start_time;
+  gint64 stats_last_frame;
+  gdouble stats_hvalue;
+  gdouble stats_vvalue;
 };
 
+/* A widget allocation in the hit testing index, in the coordinates of
+ * the viewport content */
+typedef struct {
+  GdkRectangle rect;
+  GtkWidget *widget;
+  gint depth;
+} HitEntry;
+
 /*signals*/
 enum {
   HORIZONTAL_MOVEMENT,
   VERTICAL_MOVEMENT,
   PANNING_STARTED,
   PANNING_FINISHED,
+  PREDICTED_VIEWPORT,
+  FRAME_STATS,
+  GESTURE_BEGIN,
+  GESTURE_CANCEL,
   LAST_SIGNAL
 };
 
@@ -211,6 +314,10 @@ enum {
   PROP_HADJUSTMENT,
   PROP_VADJUSTMENT,
   PROP_CENTER_ON_CHILD_FOCUS,
+  PROP_PREDICTION_TIME,
+  PROP_SCROLLING,
+  PROP_CACHE_CONTENT,
+  PROP_RECORD_FRAME_STATS,
   PROP_LAST
 };
 
@@ -242,6 +349,33 @@ static void hildon_pannable_area_remove (GtkContainer *container, GtkWidget *chi
 static void hildon_pannable_area_set_focus_child (GtkContainer *container,
                                                  GtkWidget *child);
 static void hildon_pannable_area_center_on_child_focus (HildonPannableArea *area);
+static void hildon_pannable_area_unrealize (GtkWidget *widget);
+static gboolean hildon_pannable_area_draw (GtkWidget *widget,
+                                           cairo_t *cr);
+static void hildon_pannable_area_size_allocate (GtkWidget *widget,
+                                                GtkAllocation *allocation);
+static void hildon_pannable_area_invalidate_cache (HildonPannableArea *area);
+static void hildon_pannable_area_bounce_stop (HildonPannableArea *area);
+static void hildon_pannable_area_maybe_end_updating (HildonPannableArea *area);
+static void hildon_pannable_area_claim_links (HildonPannableArea *area);
+static void hildon_pannable_area_end_updating (HildonPannableArea *area);
+static void hildon_pannable_area_set_scrolling (HildonPannableArea *area,
+                                                gboolean scrolling);
+static void hildon_pannable_area_kinetic_stop (HildonPannableArea *area);
+static void hildon_pannable_area_stop_frame_stats (HildonPannableArea *area,
+                                                   gboolean report);
+static void hildon_pannable_area_drag_begin (GtkGestureDrag *gesture,
+                                             gdouble start_x,
+                                             gdouble start_y,
+                                             HildonPannableArea *area);
+static void hildon_pannable_area_drag_update (GtkGestureDrag *gesture,
+                                              gdouble offset_x,
+                                              gdouble offset_y,
+                                              HildonPannableArea *area);
+static void hildon_pannable_area_drag_end (GtkGestureDrag *gesture,
+                                           gdouble offset_x,
+                                           gdouble offset_y,
+                                           HildonPannableArea *area);
 
 
 static void
@@ -250,10 +384,20 @@ hildon_pannable_area_finalize (GObject *object)
   HildonPannableArea *area = HILDON_PANNABLE_AREA (object);
   HildonPannableAreaPrivate *priv = area->priv;
 
-  if (priv->tick_id)
-    g_signal_handler_disconnect (priv->clock, priv->tick_id);
-  if (priv->clock)
-    g_object_unref (priv->clock);
+  /* Only drop the frame clock handler: nothing may be emitted from
+     finalize */
+  if (priv->tick_id != 0)
+    {
+      g_signal_handler_disconnect (priv->clock, priv->tick_id);
+      priv->tick_id = 0;
+      gdk_frame_clock_end_updating (priv->clock);
+    }
+  hildon_pannable_area_invalidate_cache (area);
+  hildon_pannable_area_bounce_stop (area);
+  g_object_unref (priv->drag_gesture);
+  if (priv->hit_entries)
+    g_array_free (priv->hit_entries, TRUE);
+  g_free (priv->hit_max_end);
 
   G_OBJECT_CLASS (hildon_pannable_area_parent_class)->finalize (object);
 }
@@ -262,7 +406,7 @@ static void
 hildon_pannable_area_class_init (HildonPannableAreaClass * class)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (class);
-//  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (class);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (class);
 //  GtkContainerClass *container_class = GTK_CONTAINER_CLASS (class);
 
   object_class->finalize     = hildon_pannable_area_finalize;
@@ -270,9 +414,273 @@ hildon_pannable_area_class_init (HildonPannableAreaClass * class)
   object_class->set_property = hildon_pannable_area_set_property;
   object_class->get_property = hildon_pannable_area_get_property;
 
+  widget_class->unrealize = hildon_pannable_area_unrealize;
+  widget_class->draw = hildon_pannable_area_draw;
+  widget_class->size_allocate = hildon_pannable_area_size_allocate;
+
+  /**
+   * HildonPannableArea:cache-content:
+   *
+   * Whether to keep the content of a #GtkViewport child in an
+   * offscreen surface while panning. The surface covers the visible
+   * area plus half a page on each side; each frame only blits it at
+   * the new offset and renders the strips that scroll into the cache.
+   * It is meant for static content such as forms of buttons and
+   * captions; the child is drawn normally again when the motion stops.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_CACHE_CONTENT,
+                                   g_param_spec_boolean ("cache-content",
+                                                         "Cache content",
+                                                         "Whether to pan a cached "
+                                                         "copy of the viewport content",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonPannableArea:prediction-time:
+   *
+   * How far ahead, in milliseconds, the viewport reported by
+   * #HildonPannableArea::predicted-viewport is projected. Setting it to
+   * 0 disables the signal.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_PREDICTION_TIME,
+                                   g_param_spec_uint ("prediction-time",
+                                                      "Prediction time",
+                                                      "How far ahead the predicted "
+                                                      "viewport is projected, in ms",
+                                                      0, G_MAXUINT, 300,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonPannableArea:record-frame-stats:
+   *
+   * Whether the area measures the frames it paints while it moves, so
+   * that applications can log how smooth scrolling is. See
+   * hildon_pannable_area_get_frame_stats() and
+   * #HildonPannableArea::frame-stats.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_RECORD_FRAME_STATS,
+                                   g_param_spec_boolean ("record-frame-stats",
+                                                         "Record frame stats",
+                                                         "Whether to measure "
+                                                         "frame timings while "
+                                                         "panning",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonPannableArea:scrolling:
+   *
+   * Whether the area is being dragged or is animating a flick or a
+   * hildon_pannable_area_scroll_to(). Children with expensive drawing
+   * can use hildon_pannable_area_widget_get_scrolling() to render a
+   * cheaper version of themselves meanwhile; the child is redrawn when
+   * the motion stops.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_SCROLLING,
+                                   g_param_spec_boolean ("scrolling",
+                                                         "Scrolling",
+                                                         "Whether the area is "
+                                                         "being panned",
+                                                         FALSE,
+                                                         G_PARAM_READABLE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonPannableArea::panning-started:
+   * @area: the object which received the signal
+   *
+   * The "panning-started" signal is emitted when the area starts
+   * moving, see #HildonPannableArea:scrolling.
+   *
+   * Since: 3.0
+   */
+  pannable_area_signals[PANNING_STARTED] =
+    g_signal_new ("panning-started",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
+
+  /**
+   * HildonPannableArea::panning-finished:
+   * @area: the object which received the signal
+   *
+   * The "panning-finished" signal is emitted when the area stops
+   * moving, see #HildonPannableArea:scrolling.
+   *
+   * Since: 3.0
+   */
+  pannable_area_signals[PANNING_FINISHED] =
+    g_signal_new ("panning-finished",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
+
+  /**
+   * HildonPannableArea::predicted-viewport:
+   * @area: the object which received the signal
+   * @viewport: the projected visible rectangle, in the coordinates of
+   * the adjustments
+   *
+   * The "predicted-viewport" signal is emitted on every frame of a
+   * kinetic scroll or of a hildon_pannable_area_scroll_to() animation,
+   * whenever the area the viewport is projected to show
+   * #HildonPannableArea:prediction-time milliseconds from now changes.
+   * Models feeding the child can use it to prefetch the rows that are
+   * about to become visible.
+   *
+   * Since: 3.0
+   */
+  pannable_area_signals[PREDICTED_VIEWPORT] =
+    g_signal_new ("predicted-viewport",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__BOXED, G_TYPE_NONE, 1,
+                  GDK_TYPE_RECTANGLE | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  /**
+   * HildonPannableArea::frame-stats:
+   * @area: the object which received the signal
+   * @stats: the measurements of the session that just ended
+   *
+   * The "frame-stats" signal is emitted after
+   * #HildonPannableArea::panning-finished when
+   * #HildonPannableArea:record-frame-stats is set, with the frame
+   * timings of the drag or animation that just ended. @stats has
+   * #HildonPannableAreaFrameStats.sessions set to 1.
+   *
+   * Since: 3.0
+   */
+  pannable_area_signals[FRAME_STATS] =
+    g_signal_new ("frame-stats",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__BOXED, G_TYPE_NONE, 1,
+                  HILDON_TYPE_PANNABLE_AREA_FRAME_STATS | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  /**
+   * HildonPannableArea::horizontal-movement:
+   * @area: the object which received the signal
+   * @direction: the direction the finger moves in
+   * @x: horizontal coordinate of the press, relative to @area
+   * @y: vertical coordinate of the press, relative to @area
+   *
+   * The "horizontal-movement" signal is emitted once per drag, when the
+   * gesture announced by #HildonPannableArea::gesture-begin is confirmed
+   * to be a horizontal one: the finger went past the panning threshold
+   * in that direction, or was flicked that way. It is emitted whatever
+   * #HildonPannableArea:mov-mode is, so that a vertical list can react
+   * to sideways swipes.
+   *
+   * Since: 2.2
+   */
+  pannable_area_signals[HORIZONTAL_MOVEMENT] =
+    g_signal_new ("horizontal-movement",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (HildonPannableAreaClass, horizontal_movement),
+                  NULL, NULL,
+                  _hildon_marshal_VOID__INT_DOUBLE_DOUBLE, G_TYPE_NONE, 3,
+                  HILDON_TYPE_MOVEMENT_DIRECTION, G_TYPE_DOUBLE, G_TYPE_DOUBLE);
+
+  /**
+   * HildonPannableArea::vertical-movement:
+   * @area: the object which received the signal
+   * @direction: the direction the finger moves in
+   * @x: horizontal coordinate of the press, relative to @area
+   * @y: vertical coordinate of the press, relative to @area
+   *
+   * Like #HildonPannableArea::horizontal-movement, for vertical
+   * gestures.
+   *
+   * Since: 2.2
+   */
+  pannable_area_signals[VERTICAL_MOVEMENT] =
+    g_signal_new ("vertical-movement",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (HildonPannableAreaClass, vertical_movement),
+                  NULL, NULL,
+                  _hildon_marshal_VOID__INT_DOUBLE_DOUBLE, G_TYPE_NONE, 3,
+                  HILDON_TYPE_MOVEMENT_DIRECTION, G_TYPE_DOUBLE, G_TYPE_DOUBLE);
+
+  /**
+   * HildonPannableArea::gesture-begin:
+   * @area: the object which received the signal
+   * @direction: the predicted direction of the finger
+   * @velocity: the speed of the finger in that direction, in pixels
+   * per second
+   *
+   * The "gesture-begin" signal is emitted as soon as the first few
+   * motion events of a drag tell which way it goes, well before the
+   * panning threshold is reached. The direction and speed are fitted
+   * over the timestamps of the samples, so a single jittery event does
+   * not decide them. Applications can start a transition right away,
+   * in the same frame.
+   *
+   * The prediction is either confirmed by
+   * #HildonPannableArea::horizontal-movement or
+   * #HildonPannableArea::vertical-movement, or withdrawn by
+   * #HildonPannableArea::gesture-cancel, after which another
+   * "gesture-begin" may follow in the same drag.
+   *
+   * Since: 3.0
+   */
+  pannable_area_signals[GESTURE_BEGIN] =
+    g_signal_new ("gesture-begin",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  _hildon_marshal_VOID__ENUM_DOUBLE, G_TYPE_NONE, 2,
+                  HILDON_TYPE_MOVEMENT_DIRECTION, G_TYPE_DOUBLE);
+
+  /**
+   * HildonPannableArea::gesture-cancel:
+   * @area: the object which received the signal
+   * @direction: the direction of the withdrawn prediction
+   *
+   * The "gesture-cancel" signal is emitted when the gesture announced by
+   * #HildonPannableArea::gesture-begin turns out otherwise: the finger
+   * turned to another direction, went back, or was lifted before the
+   * gesture was confirmed.
+   *
+   * Since: 3.0
+   */
+  pannable_area_signals[GESTURE_CANCEL] =
+    g_signal_new ("gesture-cancel",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__ENUM, G_TYPE_NONE, 1,
+                  HILDON_TYPE_MOVEMENT_DIRECTION);
+
   /*
   widget_class->realize = hildon_pannable_area_realize;
-  widget_class->unrealize = hildon_pannable_area_unrealize;
 
   container_class->add = hildon_pannable_area_add;
   container_class->remove = hildon_pannable_area_remove;
@@ -287,11 +695,380 @@ hildon_pannable_area_init (HildonPannableArea * area)
   area->priv->duration = 200;
   area->priv->clock = gtk_widget_get_frame_clock (GTK_WIDGET (area));
 
+  /* Kinetic defaults; velocities are in pixels per second and the
+   * deceleration is applied sps times per second of animation */
+  area->priv->mode = HILDON_PANNABLE_AREA_MODE_AUTO;
+  area->priv->mov_mode = HILDON_MOVEMENT_MODE_VERT;
+  area->priv->vmin = 20;
+  area->priv->vmax = 6000;
+  area->priv->decel = 0.93;
+  area->priv->sps = 60;
+  area->priv->panning_threshold = 25;
+  area->priv->prediction_time = 300;
+  area->priv->vovershoot_max = 150;
+  area->priv->hovershoot_max = 150;
+  area->priv->gesture_direction = -1;
+
   gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (area),
                                   GTK_POLICY_NEVER,
                                   GTK_POLICY_AUTOMATIC);
   gtk_scrolled_window_set_hadjustment (GTK_SCROLLED_WINDOW (area), NULL);
   gtk_scrolled_window_set_vadjustment (GTK_SCROLLED_WINDOW (area), NULL);
+
+  /* We do our own kinetics, the generic ones would fight with them */
+  gtk_scrolled_window_set_kinetic_scrolling (GTK_SCROLLED_WINDOW (area), FALSE);
+
+  /* Capture phase, so we see the drag before the child does; the
+   * sequence is only claimed once it is known to be a pan */
+  area->priv->drag_gesture = gtk_gesture_drag_new (GTK_WIDGET (area));
+  gtk_event_controller_set_propagation_phase (GTK_EVENT_CONTROLLER (area->priv->drag_gesture),
+                                              GTK_PHASE_CAPTURE);
+  g_signal_connect (area->priv->drag_gesture, "drag-begin",
+                    G_CALLBACK (hildon_pannable_area_drag_begin), area);
+  g_signal_connect (area->priv->drag_gesture, "drag-update",
+                    G_CALLBACK (hildon_pannable_area_drag_update), area);
+  g_signal_connect (area->priv->drag_gesture, "drag-end",
+                    G_CALLBACK (hildon_pannable_area_drag_end), area);
+
+  hildon_add_purge_func ((HildonPurgeFunc) hildon_pannable_area_invalidate_cache, area);
+}
+
+static void
+hildon_pannable_area_unrealize (GtkWidget *widget)
+{
+  HildonPannableArea *area = HILDON_PANNABLE_AREA (widget);
+
+  /* The frame clock goes away with the toplevel */
+  hildon_pannable_area_kinetic_stop (area);
+  hildon_pannable_area_bounce_stop (area);
+  area->priv->animating = FALSE;
+  hildon_pannable_area_end_updating (area);
+  area->priv->clock = NULL;
+
+  if (area->priv->focus_tick_id) {
+    gtk_widget_remove_tick_callback (widget, area->priv->focus_tick_id);
+    area->priv->focus_tick_id = 0;
+  }
+  area->priv->center_on_child_focus_pending = FALSE;
+
+  hildon_pannable_area_invalidate_cache (area);
+
+  GTK_WIDGET_CLASS (hildon_pannable_area_parent_class)->unrealize (widget);
+}
+
+static void
+hildon_pannable_area_size_allocate (GtkWidget *widget,
+                                    GtkAllocation *allocation)
+{
+  hildon_pannable_area_invalidate_cache (HILDON_PANNABLE_AREA (widget));
+
+  /* Any relayout of the content goes through here */
+  HILDON_PANNABLE_AREA (widget)->priv->hit_index_valid = FALSE;
+
+  GTK_WIDGET_CLASS (hildon_pannable_area_parent_class)->size_allocate (widget, allocation);
+}
+
+static void
+hildon_pannable_area_invalidate_cache (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  if (priv->cache_surface) {
+    cairo_surface_destroy (priv->cache_surface);
+    priv->cache_surface = NULL;
+  }
+}
+
+/* The widget drawn into the cache: only the child of a viewport can be
+ * drawn at an arbitrary offset, native scrollables draw just what they
+ * show */
+static GtkWidget *
+hildon_pannable_area_get_cacheable_child (HildonPannableArea *area)
+{
+  GtkWidget *viewport = gtk_bin_get_child (GTK_BIN (area));
+  GtkWidget *content;
+
+  if (!GTK_IS_VIEWPORT (viewport) || !gtk_widget_get_visible (viewport))
+    return NULL;
+
+  content = gtk_bin_get_child (GTK_BIN (viewport));
+  if (content == NULL || !gtk_widget_get_visible (content))
+    return NULL;
+
+  return content;
+}
+
+/* Renders @rect, in bin window coordinates, of @content into the cache
+ * surface through @cr */
+static void
+hildon_pannable_area_cache_render (HildonPannableArea *area,
+                                   GtkWidget *viewport,
+                                   GtkWidget *content,
+                                   cairo_t *cr,
+                                   const cairo_rectangle_int_t *rect)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkAllocation content_alloc;
+
+  gtk_widget_get_allocation (content, &content_alloc);
+
+  cairo_save (cr);
+  cairo_rectangle (cr, rect->x - priv->cache_rect.x, rect->y - priv->cache_rect.y,
+                   rect->width, rect->height);
+  cairo_clip (cr);
+
+  gtk_render_background (gtk_widget_get_style_context (viewport), cr,
+                         0, 0, priv->cache_rect.width, priv->cache_rect.height);
+
+  cairo_translate (cr, content_alloc.x - priv->cache_rect.x,
+                   content_alloc.y - priv->cache_rect.y);
+  gtk_widget_draw (content, cr);
+  cairo_restore (cr);
+}
+
+/* Makes sure the cache covers the visible part, moving it along when
+ * needed; what is still valid is copied over and only the newly
+ * covered strips are rendered */
+static gboolean
+hildon_pannable_area_update_cache (HildonPannableArea *area,
+                                   GtkWidget *viewport,
+                                   GtkWidget *content)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+  GtkAllocation content_alloc;
+  GdkRectangle visible, rect;
+  cairo_surface_t *surface;
+  cairo_region_t *dirty;
+  cairo_t *cr;
+  gint i, n;
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+  gtk_widget_get_allocation (content, &content_alloc);
+
+  visible.x = (gint) gtk_adjustment_get_value (hadj);
+  visible.y = (gint) gtk_adjustment_get_value (vadj);
+  visible.width = gtk_widget_get_allocated_width (viewport);
+  visible.height = gtk_widget_get_allocated_height (viewport);
+
+  if (visible.width <= 0 || visible.height <= 0)
+    return FALSE;
+
+  if (content_alloc.width != priv->cache_content_width ||
+      content_alloc.height != priv->cache_content_height) {
+    hildon_pannable_area_invalidate_cache (area);
+    priv->cache_content_width = content_alloc.width;
+    priv->cache_content_height = content_alloc.height;
+  }
+
+  if (priv->cache_surface &&
+      gdk_rectangle_intersect (&visible, &priv->cache_rect, &rect) &&
+      rect.width == visible.width && rect.height == visible.height)
+    return TRUE;
+
+  rect.width = visible.width * 2;
+  rect.height = visible.height * 2;
+  rect.x = MAX (0, visible.x - visible.width / 2);
+  rect.y = MAX (0, visible.y - visible.height / 2);
+
+  surface = gdk_window_create_similar_surface (gtk_widget_get_window (GTK_WIDGET (area)),
+                                               CAIRO_CONTENT_COLOR_ALPHA,
+                                               rect.width, rect.height);
+  cr = cairo_create (surface);
+  dirty = cairo_region_create_rectangle (&rect);
+
+  if (priv->cache_surface) {
+    cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface (cr, priv->cache_surface,
+                              priv->cache_rect.x - rect.x,
+                              priv->cache_rect.y - rect.y);
+    cairo_paint (cr);
+    cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+    cairo_region_subtract_rectangle (dirty, &priv->cache_rect);
+    cairo_surface_destroy (priv->cache_surface);
+  }
+
+  priv->cache_surface = surface;
+  priv->cache_rect = rect;
+
+  n = cairo_region_num_rectangles (dirty);
+  for (i = 0; i < n; i++) {
+    cairo_rectangle_int_t strip;
+
+    cairo_region_get_rectangle (dirty, i, &strip);
+    hildon_pannable_area_cache_render (area, viewport, content, cr, &strip);
+  }
+
+  cairo_region_destroy (dirty);
+  cairo_destroy (cr);
+
+  return TRUE;
+}
+
+static void
+hildon_pannable_area_draw_scrollbars (HildonPannableArea *area,
+                                      cairo_t *cr)
+{
+  GtkWidget *scrollbar;
+
+  scrollbar = gtk_scrolled_window_get_hscrollbar (GTK_SCROLLED_WINDOW (area));
+  if (scrollbar && gtk_widget_get_visible (scrollbar))
+    gtk_container_propagate_draw (GTK_CONTAINER (area), scrollbar, cr);
+  scrollbar = gtk_scrolled_window_get_vscrollbar (GTK_SCROLLED_WINDOW (area));
+  if (scrollbar && gtk_widget_get_visible (scrollbar))
+    gtk_container_propagate_draw (GTK_CONTAINER (area), scrollbar, cr);
+}
+
+/* Paints a glow fading from the edge over the @size pixels of @rect
+ * uncovered by the overshoot; @size is negative for the far edge */
+static void
+hildon_pannable_area_draw_edge_glow (GtkWidget *widget,
+                                     cairo_t *cr,
+                                     GtkAllocation *rect,
+                                     gdouble size,
+                                     GtkOrientation orientation)
+{
+  GtkStyleContext *context = gtk_widget_get_style_context (widget);
+  cairo_pattern_t *glow;
+  GdkRGBA color;
+  gdouble x0, y0, x1, y1;
+
+  if (size == 0)
+    return;
+
+  gtk_style_context_get_color (context, gtk_widget_get_state_flags (widget), &color);
+
+  x0 = x1 = rect->x;
+  y0 = y1 = rect->y;
+  if (orientation == GTK_ORIENTATION_HORIZONTAL) {
+    if (size < 0)
+      x0 = x1 = rect->x + rect->width;
+    x1 += size;
+  } else {
+    if (size < 0)
+      y0 = y1 = rect->y + rect->height;
+    y1 += size;
+  }
+
+  glow = cairo_pattern_create_linear (x0, y0, x1, y1);
+  cairo_pattern_add_color_stop_rgba (glow, 0, color.red, color.green, color.blue,
+                                     EDGE_GLOW_ALPHA * color.alpha);
+  cairo_pattern_add_color_stop_rgba (glow, 1, color.red, color.green, color.blue, 0);
+
+  cairo_save (cr);
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    cairo_rectangle (cr, MIN (x0, x1), rect->y, fabs (size), rect->height);
+  else
+    cairo_rectangle (cr, rect->x, MIN (y0, y1), rect->width, fabs (size));
+  cairo_set_source (cr, glow);
+  cairo_fill (cr);
+  cairo_restore (cr);
+
+  cairo_pattern_destroy (glow);
+}
+
+/* While overshooting the adjustments sit at their bounds, so the child
+ * looks the same during all the bounce: it is drawn once into a
+ * surface which is then just composited at the overshoot offset */
+static gboolean
+hildon_pannable_area_draw_overshoot (HildonPannableArea *area,
+                                     cairo_t *cr)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkWidget *widget = GTK_WIDGET (area);
+  GtkWidget *child = gtk_bin_get_child (GTK_BIN (area));
+  GtkAllocation alloc, child_alloc;
+
+  if (child == NULL || !gtk_widget_get_visible (child))
+    return FALSE;
+
+  gtk_widget_get_allocation (widget, &alloc);
+  gtk_widget_get_allocation (child, &child_alloc);
+  child_alloc.x -= alloc.x;
+  child_alloc.y -= alloc.y;
+
+  if (child_alloc.width <= 0 || child_alloc.height <= 0)
+    return FALSE;
+
+  if (priv->overshoot_surface == NULL) {
+    cairo_t *child_cr;
+
+    priv->overshoot_surface =
+      gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                         CAIRO_CONTENT_COLOR_ALPHA,
+                                         child_alloc.width, child_alloc.height);
+    child_cr = cairo_create (priv->overshoot_surface);
+    gtk_widget_draw (child, child_cr);
+    cairo_destroy (child_cr);
+  }
+
+  cairo_save (cr);
+  cairo_rectangle (cr, child_alloc.x, child_alloc.y, child_alloc.width, child_alloc.height);
+  cairo_clip (cr);
+
+  gtk_render_background (gtk_widget_get_style_context (widget), cr,
+                         child_alloc.x, child_alloc.y,
+                         child_alloc.width, child_alloc.height);
+  cairo_set_source_surface (cr, priv->overshoot_surface,
+                            child_alloc.x - priv->overshoot_x,
+                            child_alloc.y - priv->overshoot_y);
+  cairo_paint (cr);
+
+  hildon_pannable_area_draw_edge_glow (widget, cr, &child_alloc, -priv->overshoot_x,
+                                       GTK_ORIENTATION_HORIZONTAL);
+  hildon_pannable_area_draw_edge_glow (widget, cr, &child_alloc, -priv->overshoot_y,
+                                       GTK_ORIENTATION_VERTICAL);
+  cairo_restore (cr);
+
+  hildon_pannable_area_draw_scrollbars (area, cr);
+
+  return TRUE;
+}
+
+static gboolean
+hildon_pannable_area_draw (GtkWidget *widget,
+                           cairo_t *cr)
+{
+  HildonPannableArea *area = HILDON_PANNABLE_AREA (widget);
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkWidget *viewport, *content;
+  GtkAllocation alloc, viewport_alloc;
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+
+  if ((priv->overshoot_x != 0 || priv->overshoot_y != 0) &&
+      hildon_pannable_area_draw_overshoot (area, cr))
+    return FALSE;
+
+  content = hildon_pannable_area_get_cacheable_child (area);
+  viewport = gtk_bin_get_child (GTK_BIN (area));
+
+  if (!priv->cache_content || !priv->scrolling || content == NULL ||
+      !hildon_pannable_area_update_cache (area, viewport, content))
+    return GTK_WIDGET_CLASS (hildon_pannable_area_parent_class)->draw (widget, cr);
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+  gtk_widget_get_allocation (widget, &alloc);
+  gtk_widget_get_allocation (viewport, &viewport_alloc);
+
+  cairo_save (cr);
+  cairo_rectangle (cr, viewport_alloc.x - alloc.x, viewport_alloc.y - alloc.y,
+                   viewport_alloc.width, viewport_alloc.height);
+  cairo_clip (cr);
+  cairo_set_source_surface (cr, priv->cache_surface,
+                            viewport_alloc.x - alloc.x -
+                            (gtk_adjustment_get_value (hadj) - priv->cache_rect.x),
+                            viewport_alloc.y - alloc.y -
+                            (gtk_adjustment_get_value (vadj) - priv->cache_rect.y));
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  hildon_pannable_area_draw_scrollbars (area, cr);
+
+  return FALSE;
 }
 
 static void
@@ -300,9 +1077,21 @@ hildon_pannable_area_get_property (GObject * object,
 				   GValue * value,
                                    GParamSpec * pspec)
 {
-//  HildonPannableAreaPrivate *priv = HILDON_PANNABLE_AREA (object)->priv;
+  HildonPannableAreaPrivate *priv = HILDON_PANNABLE_AREA (object)->priv;
 
   switch (property_id) {
+  case PROP_PREDICTION_TIME:
+    g_value_set_uint (value, priv->prediction_time);
+    break;
+  case PROP_SCROLLING:
+    g_value_set_boolean (value, priv->scrolling);
+    break;
+  case PROP_CACHE_CONTENT:
+    g_value_set_boolean (value, priv->cache_content);
+    break;
+  case PROP_RECORD_FRAME_STATS:
+    g_value_set_boolean (value, priv->record_frame_stats);
+    break;
 /*  case PROP_CENTER_ON_CHILD_FOCUS:
     g_value_set_boolean (value, priv->center_on_child_focus);
     break;*/
@@ -318,10 +1107,22 @@ hildon_pannable_area_set_property (GObject * object,
 				   const GValue * value,
                                    GParamSpec * pspec)
 {
-//  HildonPannableAreaPrivate *priv = HILDON_PANNABLE_AREA (object)->priv;
+  HildonPannableAreaPrivate *priv = HILDON_PANNABLE_AREA (object)->priv;
 //  gboolean enabled;
 
   switch (property_id) {
+  case PROP_PREDICTION_TIME:
+    priv->prediction_time = g_value_get_uint (value);
+    break;
+  case PROP_CACHE_CONTENT:
+    hildon_pannable_area_set_cache_content (HILDON_PANNABLE_AREA (object),
+                                            g_value_get_boolean (value));
+    break;
+  case PROP_RECORD_FRAME_STATS:
+    hildon_pannable_area_set_record_frame_stats (HILDON_PANNABLE_AREA (object),
+                                                 g_value_get_boolean (value));
+    break;
+
 /*  case PROP_ENABLED:
     enabled = g_value_get_boolean (value);
 
@@ -342,12 +1143,20 @@ hildon_pannable_area_set_property (GObject * object,
   }
 }
 
+static void
+hildon_pannable_area_row_scroll_stop (HildonPannableArea *area);
+
 static void
 hildon_pannable_area_dispose (GObject * object)
 {
   GtkWidget *child = gtk_bin_get_child (GTK_BIN (object));
 
   hildon_pannable_area_remove_timeouts (GTK_WIDGET (object));
+  hildon_pannable_area_stop_frame_stats (HILDON_PANNABLE_AREA (object), FALSE);
+  hildon_pannable_area_row_scroll_stop (HILDON_PANNABLE_AREA (object));
+  hildon_remove_purge_func ((HildonPurgeFunc) hildon_pannable_area_invalidate_cache, object);
+  hildon_pannable_area_unlink (HILDON_PANNABLE_AREA (object), GTK_ORIENTATION_HORIZONTAL);
+  hildon_pannable_area_unlink (HILDON_PANNABLE_AREA (object), GTK_ORIENTATION_VERTICAL);
 
   if (child) {
     g_signal_handlers_disconnect_by_func (child,
@@ -496,11 +1305,31 @@ hildon_pannable_area_center_on_child_focus      (HildonPannableArea *area)
     focused_child = gtk_window_get_focus (GTK_WINDOW (window));
   }
 
-  if (focused_child) {
+  if (focused_child && gtk_widget_is_ancestor (focused_child, GTK_WIDGET (area))) {
     hildon_pannable_area_scroll_to_child (area, focused_child);
   }
 }
 
+/* Focus can move several times per frame, e.g. while a d-pad key
+ * repeats; only the last focused child is scrolled to, and the scroll
+ * retargets the animation in flight keeping its speed */
+static gboolean
+hildon_pannable_area_focus_tick (GtkWidget     *widget,
+                                 GdkFrameClock *clock,
+                                 gpointer       data)
+{
+  HildonPannableArea *area = HILDON_PANNABLE_AREA (widget);
+
+  area->priv->focus_tick_id = 0;
+
+  if (area->priv->center_on_child_focus_pending) {
+    area->priv->center_on_child_focus_pending = FALSE;
+    hildon_pannable_area_center_on_child_focus (area);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 hildon_pannable_area_set_focus_child            (GtkContainer     *container,
                                                  GtkWidget        *child)
@@ -513,6 +1342,11 @@ hildon_pannable_area_set_focus_child            (GtkContainer     *container,
 
   if (GTK_IS_WIDGET (child)) {
     area->priv->center_on_child_focus_pending = TRUE;
+
+    if (area->priv->focus_tick_id == 0 && gtk_widget_get_realized (GTK_WIDGET (area)))
+      area->priv->focus_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (area),
+                                                                hildon_pannable_area_focus_tick,
+                                                                NULL, NULL);
   }
 }
 
@@ -595,6 +1429,8 @@ hildon_pannable_area_begin_updating (HildonPannableArea *area)
                                         G_CALLBACK (hildon_pannable_area_on_frame_clock_update), area);
       gdk_frame_clock_begin_updating (priv->clock);
     }
+
+  hildon_pannable_area_set_scrolling (area, TRUE);
 }
 
 static void
@@ -608,110 +1444,1204 @@ hildon_pannable_area_end_updating (HildonPannableArea *area)
       priv->tick_id = 0;
       gdk_frame_clock_end_updating (priv->clock);
     }
+
+  if (!priv->moved || !priv->button_pressed)
+    hildon_pannable_area_set_scrolling (area, FALSE);
 }
 
-/* From clutter-easing.c, based on Robert Penner's
- * infamous easing equations, MIT license.
- */
-static gdouble
-ease_out_cubic (gdouble t)
+static void
+hildon_pannable_area_frame_stats_after_paint (GdkFrameClock *clock,
+                                              HildonPannableArea *area)
 {
-  gdouble p = t - 1;
+  HildonPannableAreaPrivate *priv = area->priv;
+  HildonPannableAreaFrameStats *stats = &priv->session_stats;
+  GtkScrolledWindow *window = GTK_SCROLLED_WINDOW (area);
+  gint64 frame_time = gdk_frame_clock_get_frame_time (clock);
+  gdouble hvalue = gtk_adjustment_get_value (gtk_scrolled_window_get_hadjustment (window));
+  gdouble vvalue = gtk_adjustment_get_value (gtk_scrolled_window_get_vadjustment (window));
+
+  stats->frames++;
+  stats->distance += fabs (hvalue - priv->stats_hvalue) + fabs (vvalue - priv->stats_vvalue);
+  priv->stats_hvalue = hvalue;
+  priv->stats_vvalue = vvalue;
+
+  if (priv->stats_last_frame != 0) {
+    gint64 interval = frame_time - priv->stats_last_frame;
+    gint64 refresh = 0;
+    GdkFrameTimings *timings;
+
+    timings = gdk_frame_clock_get_frame_timings (clock,
+                                                 gdk_frame_clock_get_frame_counter (clock) - 1);
+    if (timings != NULL)
+      refresh = gdk_frame_timings_get_refresh_interval (timings);
+    if (refresh == 0)
+      gdk_frame_clock_get_refresh_info (clock, frame_time, &refresh, NULL);
+
+    stats->worst_frame_interval = MAX (stats->worst_frame_interval, interval);
+
+    /* Every refresh without a new frame in between is a missed one */
+    if (refresh > 0 && interval > refresh + refresh / 2)
+      stats->missed_frames += (interval + refresh / 2) / refresh - 1;
+  }
 
-  return p * p * p + 1;
+  priv->stats_last_frame = frame_time;
 }
 
 static void
-hildon_pannable_area_on_frame_clock_update (GdkFrameClock *clock,
-                                            HildonPannableArea *area)
+hildon_pannable_area_start_frame_stats (HildonPannableArea *area)
 {
   HildonPannableAreaPrivate *priv = area->priv;
-  gint64 now;
+  GtkScrolledWindow *window = GTK_SCROLLED_WINDOW (area);
 
-  now = gdk_frame_clock_get_frame_time (clock);
+  if (!priv->record_frame_stats || priv->stats_clock != NULL)
+    return;
 
-  GtkAdjustment *hadj;
-  GtkAdjustment *vadj;
+  priv->stats_clock = gtk_widget_get_frame_clock (GTK_WIDGET (area));
+  if (priv->stats_clock == NULL)
+    return;
 
-  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
-  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+  g_object_ref (priv->stats_clock);
+  priv->stats_paint_id = g_signal_connect (priv->stats_clock, "after-paint",
+                                           G_CALLBACK (hildon_pannable_area_frame_stats_after_paint),
+                                           area);
 
-  if (now < priv->end_time)
-    {
-      gdouble t;
+  priv->session_stats = (HildonPannableAreaFrameStats) { 1, 0, 0, 0, 0.0, 0 };
+  priv->stats_start_time = g_get_monotonic_time ();
+  priv->stats_last_frame = 0;
+  priv->stats_hvalue = gtk_adjustment_get_value (gtk_scrolled_window_get_hadjustment (window));
+  priv->stats_vvalue = gtk_adjustment_get_value (gtk_scrolled_window_get_vadjustment (window));
+}
 
-      t = (now - priv->start_time) / (gdouble) (priv->end_time - priv->start_time);
-      t = ease_out_cubic (t);
-      gtk_adjustment_set_value (hadj, priv->hsource + t * (priv->htarget - priv->hsource));
-      gtk_adjustment_set_value (vadj, priv->vsource + t * (priv->vtarget - priv->vsource));
-    }
-  else
-    {
-      gtk_adjustment_set_value (hadj, priv->htarget);
-      gtk_adjustment_set_value (vadj, priv->vtarget);
-      hildon_pannable_area_end_updating (area);
-    }
+/* Ends the session being measured, reporting it if @report */
+static void
+hildon_pannable_area_stop_frame_stats (HildonPannableArea *area,
+                                       gboolean report)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  HildonPannableAreaFrameStats *stats = &priv->session_stats;
+  HildonPannableAreaFrameStats *total = &priv->frame_stats;
+
+  if (priv->stats_clock == NULL)
+    return;
+
+  g_signal_handler_disconnect (priv->stats_clock, priv->stats_paint_id);
+  priv->stats_paint_id = 0;
+  g_object_unref (priv->stats_clock);
+  priv->stats_clock = NULL;
+
+  if (!report)
+    return;
+
+  stats->duration = g_get_monotonic_time () - priv->stats_start_time;
+
+  total->sessions += stats->sessions;
+  total->frames += stats->frames;
+  total->missed_frames += stats->missed_frames;
+  total->worst_frame_interval = MAX (total->worst_frame_interval, stats->worst_frame_interval);
+  total->distance += stats->distance;
+  total->duration += stats->duration;
+
+  g_signal_emit (area, pannable_area_signals[FRAME_STATS], 0, stats);
 }
 
+static void
+hildon_pannable_area_set_scrolling (HildonPannableArea *area,
+                                    gboolean scrolling)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkWidget *child;
+
+  if (priv->scrolling == scrolling)
+    return;
 
-// WORKING ON THIS.  HANDLE -1 values
-static void hildon_pannable_area_set_value_internal (HildonPannableArea *area,
-                                         gdouble             hvalue,
-                                         gdouble             vvalue,
-                                         gboolean            animate)
+  priv->scrolling = scrolling;
+
+  /* Whatever changed while we were still is not in the cache */
+  hildon_pannable_area_invalidate_cache (area);
+
+  if (scrolling)
+    hildon_pannable_area_start_frame_stats (area);
+
+  g_signal_emit (area, pannable_area_signals[scrolling ? PANNING_STARTED : PANNING_FINISHED], 0);
+  g_object_notify (G_OBJECT (area), "scrolling");
+
+  if (!scrolling)
+    hildon_pannable_area_stop_frame_stats (area, TRUE);
+
+  /* Children may have drawn a cheap version while we moved */
+  child = gtk_bin_get_child (GTK_BIN (area));
+  if (!scrolling && child != NULL)
+    gtk_widget_queue_draw (child);
+}
+
+/* Time the frame being prepared will reach the screen. When vblanks
+ * were missed this is further ahead of the last frame than one refresh
+ * interval, and sampling the animations at that time makes them catch
+ * up instead of lagging behind */
+static gint64
+hildon_pannable_area_get_frame_time (GdkFrameClock *clock)
+{
+  GdkFrameTimings *timings;
+  gint64 frame_time;
+  gint64 predicted;
+
+  frame_time = gdk_frame_clock_get_frame_time (clock);
+  timings = gdk_frame_clock_get_frame_timings (clock,
+                                               gdk_frame_clock_get_frame_counter (clock));
+  if (timings == NULL)
+    return frame_time;
+
+  predicted = gdk_frame_timings_get_predicted_presentation_time (timings);
+
+  return MAX (frame_time, predicted);
+}
+
+/* Cubic Hermite curve from @source, leaving it at @source_vel, to
+ * @target, arriving with zero velocity. With source_vel = 3 * (target -
+ * source) / duration it is Penner's ease-out cubic. @t is the curve
+ * parameter in [0, 1] and @duration its length in seconds */
+static void
+hildon_pannable_area_curve_sample (gdouble source,
+                                   gdouble source_vel,
+                                   gdouble target,
+                                   gdouble duration,
+                                   gdouble t,
+                                   gdouble *value,
+                                   gdouble *vel)
+{
+  gdouble t2 = t * t;
+  gdouble t3 = t2 * t;
+  gdouble m = source_vel * duration;
+
+  if (value)
+    *value = (2 * t3 - 3 * t2 + 1) * source +
+      (t3 - 2 * t2 + t) * m +
+      (-2 * t3 + 3 * t2) * target;
+
+  if (vel)
+    *vel = ((6 * t2 - 6 * t) * source +
+            (3 * t2 - 4 * t + 1) * m +
+            (-6 * t2 + 6 * t) * target) / duration;
+}
+
+/* Velocity at which a curve from @source to @target starts. When
+ * @moving, it is the current velocity @vel, so that retargeting does
+ * not jerk, capped to the ease-out one so the curve does not overshoot
+ * @target; from rest the curve is the ease-out */
+static gdouble
+hildon_pannable_area_curve_source_vel (gdouble source,
+                                       gdouble target,
+                                       gdouble vel,
+                                       gdouble duration,
+                                       gboolean moving)
+{
+  gdouble ease_out = 3 * (target - source) / duration;
+
+  if (!moving)
+    return ease_out;
+
+  if ((target - source) * vel > 0 && fabs (vel) > fabs (ease_out))
+    return ease_out;
+
+  return vel;
+}
+
+/* Velocity of the running scroll_to() animation at @now */
+static void
+hildon_pannable_area_animation_velocity (HildonPannableArea *area,
+                                         gint64 now,
+                                         gdouble *hvel,
+                                         gdouble *vvel)
 {
   HildonPannableAreaPrivate *priv = area->priv;
+  gdouble duration, t;
 
-  /* don't use CLAMP() so we don't end up below lower if upper - page_size
-   * is smaller than lower
-   */
+  *hvel = 0;
+  *vvel = 0;
 
-  GtkAdjustment *vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
-  if (vvalue == -1)
-    {
-      vvalue = gtk_adjustment_get_value (vadj);
-    }
-  else
-    {
-      vvalue = MIN (vvalue, gtk_adjustment_get_upper(vadj) - gtk_adjustment_get_page_size(vadj));
-      vvalue = MAX (vvalue, gtk_adjustment_get_lower(vadj));
-    }
+  if (!priv->animating || now >= priv->end_time)
+    return;
 
-  GtkAdjustment *hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
-  if (hvalue == -1)
-    {
-      hvalue = gtk_adjustment_get_value (hadj);
-    }
-  else
-    {
-      hvalue = MIN (hvalue, gtk_adjustment_get_upper(hadj) - gtk_adjustment_get_page_size(hadj));
-      hvalue = MAX (hvalue, gtk_adjustment_get_lower(hadj));
-    }
+  duration = (priv->end_time - priv->start_time) / (gdouble) G_USEC_PER_SEC;
+  t = CLAMP ((now - priv->start_time) / (gdouble) (priv->end_time - priv->start_time), 0, 1);
 
-  area->priv->clock = gtk_widget_get_frame_clock (GTK_WIDGET (area));
-  
-  if (animate && priv->duration != 0 && priv->clock != NULL)
-    {
-      if (priv->tick_id && priv->htarget == hvalue && priv->vtarget == vvalue)
-        return;
+  if (priv->animating_axis[GTK_ORIENTATION_HORIZONTAL])
+    hildon_pannable_area_curve_sample (priv->hsource, priv->hsource_vel, priv->htarget,
+                                       duration, t, NULL, hvel);
+  if (priv->animating_axis[GTK_ORIENTATION_VERTICAL])
+    hildon_pannable_area_curve_sample (priv->vsource, priv->vsource_vel, priv->vtarget,
+                                       duration, t, NULL, vvel);
+}
 
-      priv->vsource = gtk_adjustment_get_value (vadj);
-      priv->vtarget = vvalue;
-      priv->hsource = gtk_adjustment_get_value (hadj);
-      priv->htarget = hvalue;
-      priv->start_time = gdk_frame_clock_get_frame_time (priv->clock);
-      priv->end_time = priv->start_time + 1000 * priv->duration;
-      hildon_pannable_area_begin_updating (area);
-    }
-  else
-    {
-      hildon_pannable_area_end_updating (area);
-      gtk_adjustment_set_value (vadj, vvalue);
-      gtk_adjustment_set_value (hadj, hvalue);
-    }
+/* Moves @adj by @delta, returns FALSE if it was stopped by one of the
+ * bounds */
+static gboolean
+hildon_pannable_area_adjustment_move (GtkAdjustment *adj,
+                                      gdouble delta)
+{
+  gdouble lower, upper, value, target;
+
+  lower = gtk_adjustment_get_lower (adj);
+  upper = MAX (lower, gtk_adjustment_get_upper (adj) - gtk_adjustment_get_page_size (adj));
+  value = gtk_adjustment_get_value (adj);
+  target = CLAMP (value + delta, lower, upper);
+
+  if (target != value)
+    gtk_adjustment_set_value (adj, target);
+
+  return (target == value + delta);
 }
 
-/**
+/* How far @value is outside the range of @adj */
+static gdouble
+hildon_pannable_area_adjustment_excess (GtkAdjustment *adj,
+                                        gdouble value)
+{
+  gdouble lower, upper;
+
+  lower = gtk_adjustment_get_lower (adj);
+  upper = MAX (lower, gtk_adjustment_get_upper (adj) - gtk_adjustment_get_page_size (adj));
+
+  if (value < lower)
+    return value - lower;
+  if (value > upper)
+    return value - upper;
+  return 0;
+}
+
+/* Rubber band: dragging past the bounds pulls the content less and
+ * less, never more than @max */
+static gdouble
+hildon_pannable_area_rubber_band (gdouble excess,
+                                  gdouble max)
+{
+  gdouble pull;
+
+  if (max <= 0)
+    return 0;
+
+  pull = max * (1 - exp (-fabs (excess) / max));
+
+  return (excess < 0) ? -pull : pull;
+}
+
+static gdouble
+hildon_pannable_area_rubber_band_inverse (gdouble overshoot,
+                                          gdouble max)
+{
+  gdouble excess;
+
+  if (max <= 0 || fabs (overshoot) >= max)
+    return 0;
+
+  excess = -max * log (1 - fabs (overshoot) / max);
+
+  return (overshoot < 0) ? -excess : excess;
+}
+
+static void
+hildon_pannable_area_set_overshoot (HildonPannableArea *area,
+                                    gdouble overshoot_x,
+                                    gdouble overshoot_y)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  if (priv->overshoot_x == overshoot_x && priv->overshoot_y == overshoot_y)
+    return;
+
+  priv->overshoot_x = overshoot_x;
+  priv->overshoot_y = overshoot_y;
+
+  /* Back in place, the child is drawn for real again */
+  if (overshoot_x == 0 && overshoot_y == 0 && priv->overshoot_surface) {
+    cairo_surface_destroy (priv->overshoot_surface);
+    priv->overshoot_surface = NULL;
+  }
+
+  /* Only the composition changes, nothing is relaid out */
+  gtk_widget_queue_draw (GTK_WIDGET (area));
+}
+
+static void
+hildon_pannable_area_bounce_stop (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  priv->bouncing = FALSE;
+  priv->overshoot_vel_x = 0;
+  priv->overshoot_vel_y = 0;
+  hildon_pannable_area_set_overshoot (area, 0, 0);
+}
+
+static void
+hildon_pannable_area_bounce_start (HildonPannableArea *area,
+                                   gdouble vel_x,
+                                   gdouble vel_y)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  priv->clock = gtk_widget_get_frame_clock (GTK_WIDGET (area));
+  if (priv->clock == NULL) {
+    hildon_pannable_area_bounce_stop (area);
+    return;
+  }
+
+  priv->overshoot_vel_x += vel_x;
+  priv->overshoot_vel_y += vel_y;
+
+  if (!priv->bouncing) {
+    priv->bouncing = TRUE;
+    priv->bounce_time = hildon_pannable_area_get_frame_time (priv->clock);
+  }
+  hildon_pannable_area_begin_updating (area);
+}
+
+/* Critically damped spring pulling the overshoot back to 0, sampled
+ * exactly at the elapsed time */
+static void
+hildon_pannable_area_bounce_axis (gdouble *overshoot,
+                                  gdouble *vel,
+                                  gdouble dt,
+                                  gdouble max)
+{
+  gdouble decay = exp (-BOUNCE_STIFFNESS * dt);
+  gdouble c = *vel + BOUNCE_STIFFNESS * *overshoot;
+
+  *vel = (*vel - BOUNCE_STIFFNESS * c * dt) * decay;
+  *overshoot = CLAMP ((*overshoot + c * dt) * decay, -max, max);
+}
+
+static void
+hildon_pannable_area_bounce_step (HildonPannableArea *area,
+                                  gint64 now)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  gdouble dt, overshoot_x, overshoot_y;
+
+  dt = (now - priv->bounce_time) / (gdouble) G_USEC_PER_SEC;
+  priv->bounce_time = now;
+
+  if (dt <= 0)
+    return;
+
+  dt = MIN (dt, KINETIC_MAX_FRAME_TIME);
+
+  overshoot_x = priv->overshoot_x;
+  overshoot_y = priv->overshoot_y;
+  hildon_pannable_area_bounce_axis (&overshoot_x, &priv->overshoot_vel_x,
+                                    dt, priv->hovershoot_max);
+  hildon_pannable_area_bounce_axis (&overshoot_y, &priv->overshoot_vel_y,
+                                    dt, priv->vovershoot_max);
+
+  if (fabs (overshoot_x) < 0.5 && fabs (overshoot_y) < 0.5 &&
+      fabs (priv->overshoot_vel_x) < priv->vmin &&
+      fabs (priv->overshoot_vel_y) < priv->vmin) {
+    hildon_pannable_area_bounce_stop (area);
+    hildon_pannable_area_maybe_end_updating (area);
+    return;
+  }
+
+  hildon_pannable_area_set_overshoot (area, overshoot_x, overshoot_y);
+}
+
+static gboolean
+hildon_pannable_area_axis_enabled (HildonPannableArea *area,
+                                   GtkOrientation orientation)
+{
+  GtkAdjustment *adj;
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL) {
+    if (!(area->priv->mov_mode & HILDON_MOVEMENT_MODE_HORIZ))
+      return FALSE;
+    adj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  } else {
+    if (!(area->priv->mov_mode & HILDON_MOVEMENT_MODE_VERT))
+      return FALSE;
+    adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+  }
+
+  return (gtk_adjustment_get_upper (adj) - gtk_adjustment_get_lower (adj) >
+          gtk_adjustment_get_page_size (adj));
+}
+
+static void
+hildon_pannable_area_kinetic_stop (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  if (!priv->kinetic)
+    return;
+
+  priv->kinetic = FALSE;
+  priv->vel_x = 0;
+  priv->vel_y = 0;
+  hildon_pannable_area_maybe_end_updating (area);
+}
+
+/* The frame clock keeps ticking while anything still moves */
+static void
+hildon_pannable_area_maybe_end_updating (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  if (!priv->kinetic && !priv->animating && !priv->bouncing && !priv->drag_pending)
+    hildon_pannable_area_end_updating (area);
+}
+
+/* Stops whatever moves @area along @orientation, and only that: a
+ * flick, an animation or a bounce goes on along the other axis */
+static void
+hildon_pannable_area_stop_axis (HildonPannableArea *area,
+                                GtkOrientation orientation)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL) {
+    priv->vel_x = 0;
+    priv->overshoot_vel_x = 0;
+    hildon_pannable_area_set_overshoot (area, 0, priv->overshoot_y);
+  } else {
+    priv->vel_y = 0;
+    priv->overshoot_vel_y = 0;
+    hildon_pannable_area_set_overshoot (area, priv->overshoot_x, 0);
+  }
+
+  priv->animating_axis[orientation] = FALSE;
+  if (!priv->animating_axis[GTK_ORIENTATION_HORIZONTAL] &&
+      !priv->animating_axis[GTK_ORIENTATION_VERTICAL])
+    priv->animating = FALSE;
+
+  if (priv->vel_x == 0 && priv->vel_y == 0)
+    hildon_pannable_area_kinetic_stop (area);
+
+  if (priv->overshoot_x == 0 && priv->overshoot_y == 0 &&
+      priv->overshoot_vel_x == 0 && priv->overshoot_vel_y == 0)
+    hildon_pannable_area_bounce_stop (area);
+
+  hildon_pannable_area_maybe_end_updating (area);
+}
+
+/* @area is about to move a shared adjustment: whatever its linked
+ * areas were doing along that axis stops, so only one of them drives
+ * it and only one frame clock tick runs for the whole group */
+static void
+hildon_pannable_area_claim_links (HildonPannableArea *area)
+{
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (area->priv->links); i++) {
+    AreaLink *link = area->priv->links[i];
+    GSList *l;
+
+    if (link == NULL)
+      continue;
+
+    for (l = link->members; l != NULL; l = l->next) {
+      HildonPannableArea *member = l->data;
+
+      if (member == area)
+        continue;
+
+      hildon_pannable_area_stop_axis (member, i);
+    }
+  }
+}
+
+static void
+hildon_pannable_area_kinetic_start (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  priv->clock = gtk_widget_get_frame_clock (GTK_WIDGET (area));
+
+  if (priv->clock == NULL ||
+      (fabs (priv->vel_x) < priv->vmin && fabs (priv->vel_y) < priv->vmin)) {
+    priv->vel_x = 0;
+    priv->vel_y = 0;
+    return;
+  }
+
+  hildon_pannable_area_claim_links (area);
+  priv->kinetic = TRUE;
+  priv->last_frame_time = hildon_pannable_area_get_frame_time (priv->clock);
+  hildon_pannable_area_begin_updating (area);
+}
+
+/* Advances the momentum scroll to the time of the current frame. The
+ * velocity decays as vel * decel^(sps * t), and the displacement is the
+ * integral of that curve over the elapsed frame time, so the trajectory
+ * is the same whatever the frame rate is */
+static void
+hildon_pannable_area_kinetic_step (HildonPannableArea *area,
+                                   gint64 now)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+  gdouble dt, k, friction, travel;
+
+  dt = (now - priv->last_frame_time) / (gdouble) G_USEC_PER_SEC;
+  priv->last_frame_time = now;
+
+  if (dt <= 0)
+    return;
+
+  /* Don't let a stalled main loop throw the content across the list */
+  dt = MIN (dt, KINETIC_MAX_FRAME_TIME);
+
+  k = -log (priv->decel) * priv->sps;
+  friction = exp (-k * dt);
+  travel = (k > 0) ? (1 - friction) / k : dt;
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+
+  /* Hitting a bound hands what is left of the speed over to the
+   * bounce */
+  if (priv->vel_x != 0 &&
+      !hildon_pannable_area_adjustment_move (hadj, priv->vel_x * travel)) {
+    hildon_pannable_area_bounce_start (area, priv->vel_x * BOUNCE_VELOCITY_FACTOR, 0);
+    priv->vel_x = 0;
+  }
+  if (priv->vel_y != 0 &&
+      !hildon_pannable_area_adjustment_move (vadj, priv->vel_y * travel)) {
+    hildon_pannable_area_bounce_start (area, 0, priv->vel_y * BOUNCE_VELOCITY_FACTOR);
+    priv->vel_y = 0;
+  }
+
+  priv->vel_x *= friction;
+  priv->vel_y *= friction;
+
+  if (fabs (priv->vel_x) < priv->vmin && fabs (priv->vel_y) < priv->vmin)
+    hildon_pannable_area_kinetic_stop (area);
+}
+
+static void
+hildon_pannable_area_drag_begin (GtkGestureDrag *gesture,
+                                 gdouble start_x,
+                                 gdouble start_y,
+                                 HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+
+  hildon_pannable_area_claim_links (area);
+
+  /* A press on a moving list just stops it, it must not reach the
+   * child as a click */
+  if (priv->kinetic || priv->bouncing) {
+    hildon_pannable_area_kinetic_stop (area);
+    gtk_gesture_set_state (GTK_GESTURE (gesture), GTK_EVENT_SEQUENCE_CLAIMED);
+  }
+
+  /* A bounce is caught where it is: the overshoot stays and the drag
+   * continues from the point it corresponds to */
+  priv->bouncing = FALSE;
+  priv->overshoot_vel_x = 0;
+  priv->overshoot_vel_y = 0;
+  priv->animating = FALSE;
+  hildon_pannable_area_end_updating (area);
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+
+  priv->button_pressed = TRUE;
+  priv->moved = FALSE;
+  priv->drag_hvalue = gtk_adjustment_get_value (hadj) +
+    hildon_pannable_area_rubber_band_inverse (priv->overshoot_x, priv->hovershoot_max);
+  priv->drag_vvalue = gtk_adjustment_get_value (vadj) +
+    hildon_pannable_area_rubber_band_inverse (priv->overshoot_y, priv->vovershoot_max);
+  priv->n_drag_samples = 0;
+  priv->drag_pending = FALSE;
+  priv->vel_x = 0;
+  priv->vel_y = 0;
+  priv->last_time = gtk_get_current_event_time ();
+
+  priv->x = start_x;
+  priv->y = start_y;
+  priv->n_gesture_samples = 0;
+  priv->gesture_direction = -1;
+  priv->gesture_confirmed = FALSE;
+}
+
+/* Velocity of the finger, in px/s, as the least squares slope of the
+ * samples of the last DRAG_SAMPLE_WINDOW ms in the ring @samples, whose
+ * next slot is @head; one noisy event does not decide the flick as it
+ * would with the last delta alone. Returns FALSE with fewer than two
+ * samples. */
+static gboolean
+hildon_pannable_area_sample_velocity (const DragSample *samples,
+                                      guint n_samples,
+                                      guint head,
+                                      gdouble *vel_x,
+                                      gdouble *vel_y)
+{
+  gdouble st = 0, sx = 0, sy = 0, stt = 0, stx = 0, sty = 0, d;
+  guint32 last;
+  guint i, n = 0;
+
+  *vel_x = 0;
+  *vel_y = 0;
+
+  if (n_samples < 2)
+    return FALSE;
+
+  last = samples[(head + DRAG_SAMPLES - 1) % DRAG_SAMPLES].time;
+
+  for (i = 0; i < n_samples; i++) {
+    const DragSample *sample = &samples[(head + DRAG_SAMPLES - 1 - i) % DRAG_SAMPLES];
+    gdouble t = -((gint32) (last - sample->time)) / 1000.0;
+
+    if (last - sample->time > DRAG_SAMPLE_WINDOW)
+      break;
+
+    st += t;
+    sx += sample->x;
+    sy += sample->y;
+    stt += t * t;
+    stx += t * sample->x;
+    sty += t * sample->y;
+    n++;
+  }
+
+  d = n * stt - st * st;
+  if (n < 2 || d <= 0)
+    return FALSE;
+
+  *vel_x = (n * stx - st * sx) / d;
+  *vel_y = (n * sty - st * sy) / d;
+
+  return TRUE;
+}
+
+/* Velocity of the content, in px/s */
+static void
+hildon_pannable_area_drag_velocity (HildonPannableArea *area,
+                                    gdouble *vel_x,
+                                    gdouble *vel_y)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  hildon_pannable_area_sample_velocity (priv->drag_samples, priv->n_drag_samples,
+                                        priv->drag_sample_head, vel_x, vel_y);
+
+  /* Content moves against the finger */
+  *vel_x = -*vel_x;
+  *vel_y = -*vel_y;
+}
+
+static void
+hildon_pannable_area_gesture_cancel (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  gint direction = priv->gesture_direction;
+
+  if (direction < 0)
+    return;
+
+  priv->gesture_direction = -1;
+  g_signal_emit (area, pannable_area_signals[GESTURE_CANCEL], 0, direction);
+}
+
+static void
+hildon_pannable_area_gesture_confirm (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  gint direction = priv->gesture_direction;
+
+  priv->gesture_confirmed = TRUE;
+
+  if (direction == HILDON_MOVEMENT_LEFT || direction == HILDON_MOVEMENT_RIGHT)
+    g_signal_emit (area, pannable_area_signals[HORIZONTAL_MOVEMENT], 0,
+                   direction, priv->x, priv->y);
+  else
+    g_signal_emit (area, pannable_area_signals[VERTICAL_MOVEMENT], 0,
+                   direction, priv->x, priv->y);
+}
+
+/* Classifies the drag from its first samples. A direction is predicted
+ * once the finger went GESTURE_MIN_DISTANCE pixels mostly along one
+ * axis with a fitted velocity pointing the same way, and confirmed at
+ * the panning threshold */
+static void
+hildon_pannable_area_gesture_update (HildonPannableArea *area,
+                                     gdouble offset_x,
+                                     gdouble offset_y)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  DragSample *sample;
+  gdouble vel_x, vel_y, major, minor, vel;
+  gboolean horizontal;
+  gint direction = -1;
+
+  sample = &priv->gesture_samples[priv->gesture_sample_head];
+  sample->time = gtk_get_current_event_time ();
+  sample->x = offset_x;
+  sample->y = offset_y;
+  priv->gesture_sample_head = (priv->gesture_sample_head + 1) % DRAG_SAMPLES;
+  priv->n_gesture_samples = MIN (priv->n_gesture_samples + 1, DRAG_SAMPLES);
+
+  if (priv->gesture_confirmed ||
+      !hildon_pannable_area_sample_velocity (priv->gesture_samples,
+                                             priv->n_gesture_samples,
+                                             priv->gesture_sample_head,
+                                             &vel_x, &vel_y))
+    return;
+
+  horizontal = fabs (offset_x) >= fabs (offset_y);
+  major = horizontal ? offset_x : offset_y;
+  minor = horizontal ? offset_y : offset_x;
+  vel = horizontal ? vel_x : vel_y;
+
+  if (priv->n_gesture_samples >= GESTURE_MIN_SAMPLES &&
+      fabs (major) >= GESTURE_MIN_DISTANCE &&
+      fabs (major) >= GESTURE_DIRECTION_RATIO * fabs (minor) &&
+      vel * major > 0) {
+    if (horizontal)
+      direction = major < 0 ? HILDON_MOVEMENT_LEFT : HILDON_MOVEMENT_RIGHT;
+    else
+      direction = major < 0 ? HILDON_MOVEMENT_UP : HILDON_MOVEMENT_DOWN;
+  }
+
+  if (direction >= 0 && direction != priv->gesture_direction) {
+    hildon_pannable_area_gesture_cancel (area);
+    priv->gesture_direction = direction;
+    g_signal_emit (area, pannable_area_signals[GESTURE_BEGIN], 0,
+                   direction, fabs (vel));
+  } else if (direction < 0 && priv->gesture_direction >= 0) {
+    /* An unclear sample keeps the prediction, going back withdraws it */
+    gboolean predicted_horizontal = priv->gesture_direction == HILDON_MOVEMENT_LEFT ||
+      priv->gesture_direction == HILDON_MOVEMENT_RIGHT;
+    gdouble predicted_vel = predicted_horizontal ? vel_x : vel_y;
+    gdouble predicted_major = predicted_horizontal ? offset_x : offset_y;
+
+    if (predicted_vel * predicted_major < 0)
+      hildon_pannable_area_gesture_cancel (area);
+  }
+
+  if (priv->gesture_direction >= 0 && fabs (major) >= priv->panning_threshold &&
+      horizontal == (priv->gesture_direction == HILDON_MOVEMENT_LEFT ||
+                     priv->gesture_direction == HILDON_MOVEMENT_RIGHT))
+    hildon_pannable_area_gesture_confirm (area);
+}
+
+/* At the release, a prediction short of the threshold still holds if
+ * the finger was flicked its way */
+static void
+hildon_pannable_area_gesture_end (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  gdouble vel_x, vel_y, vel;
+  guint32 last;
+
+  if (priv->gesture_confirmed || priv->gesture_direction < 0)
+    return;
+
+  last = priv->gesture_samples[(priv->gesture_sample_head + DRAG_SAMPLES - 1) % DRAG_SAMPLES].time;
+
+  hildon_pannable_area_sample_velocity (priv->gesture_samples,
+                                        priv->n_gesture_samples,
+                                        priv->gesture_sample_head,
+                                        &vel_x, &vel_y);
+
+  switch (priv->gesture_direction) {
+  case HILDON_MOVEMENT_LEFT:
+    vel = -vel_x;
+    break;
+  case HILDON_MOVEMENT_RIGHT:
+    vel = vel_x;
+    break;
+  case HILDON_MOVEMENT_UP:
+    vel = -vel_y;
+    break;
+  default:
+    vel = vel_y;
+    break;
+  }
+
+  if (vel >= GESTURE_FLICK_VELOCITY &&
+      gtk_get_current_event_time () - last <= CURSOR_STOPPED_TIMEOUT)
+    hildon_pannable_area_gesture_confirm (area);
+  else
+    hildon_pannable_area_gesture_cancel (area);
+}
+
+/* Applies the last motion of the drag. Called once per frame, however
+ * many motion events arrived since the previous one */
+static void
+hildon_pannable_area_drag_apply (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+  gdouble offset_x = priv->pending_offset_x;
+  gdouble offset_y = priv->pending_offset_y;
+
+  if (!priv->drag_pending)
+    return;
+
+  priv->drag_pending = FALSE;
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+
+  if (hildon_pannable_area_axis_enabled (area, GTK_ORIENTATION_HORIZONTAL))
+    hildon_pannable_area_adjustment_move (hadj, priv->drag_hvalue - offset_x -
+                                          gtk_adjustment_get_value (hadj));
+  if (hildon_pannable_area_axis_enabled (area, GTK_ORIENTATION_VERTICAL))
+    hildon_pannable_area_adjustment_move (vadj, priv->drag_vvalue - offset_y -
+                                          gtk_adjustment_get_value (vadj));
+
+  /* Past the bounds the content follows the finger on a rubber band;
+   * this is applied at composition time, in this very frame */
+  hildon_pannable_area_set_overshoot
+    (area,
+     hildon_pannable_area_rubber_band
+     (hildon_pannable_area_adjustment_excess (hadj, priv->drag_hvalue - offset_x),
+      priv->hovershoot_max),
+     hildon_pannable_area_rubber_band
+     (hildon_pannable_area_adjustment_excess (vadj, priv->drag_vvalue - offset_y),
+      priv->vovershoot_max));
+}
+
+static void
+hildon_pannable_area_drag_update (GtkGestureDrag *gesture,
+                                  gdouble offset_x,
+                                  gdouble offset_y,
+                                  HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  DragSample *sample;
+
+  hildon_pannable_area_gesture_update (area, offset_x, offset_y);
+
+  if (!hildon_pannable_area_axis_enabled (area, GTK_ORIENTATION_HORIZONTAL))
+    offset_x = 0;
+  if (!hildon_pannable_area_axis_enabled (area, GTK_ORIENTATION_VERTICAL))
+    offset_y = 0;
+
+  if (!priv->moved) {
+    if (fabs (offset_x) < priv->panning_threshold &&
+        fabs (offset_y) < priv->panning_threshold)
+      return;
+
+    priv->moved = TRUE;
+    gtk_gesture_set_state (GTK_GESTURE (gesture), GTK_EVENT_SEQUENCE_CLAIMED);
+    hildon_pannable_area_set_scrolling (area, TRUE);
+  }
+
+  sample = &priv->drag_samples[priv->drag_sample_head];
+  sample->time = gtk_get_current_event_time ();
+  sample->x = offset_x;
+  sample->y = offset_y;
+  priv->drag_sample_head = (priv->drag_sample_head + 1) % DRAG_SAMPLES;
+  priv->n_drag_samples = MIN (priv->n_drag_samples + 1, DRAG_SAMPLES);
+  priv->last_time = sample->time;
+
+  priv->pending_offset_x = offset_x;
+  priv->pending_offset_y = offset_y;
+  priv->drag_pending = TRUE;
+
+  priv->clock = gtk_widget_get_frame_clock (GTK_WIDGET (area));
+  if (priv->clock != NULL)
+    hildon_pannable_area_begin_updating (area);
+  else
+    hildon_pannable_area_drag_apply (area);
+}
+
+static void
+hildon_pannable_area_drag_end (GtkGestureDrag *gesture,
+                               gdouble offset_x,
+                               gdouble offset_y,
+                               HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  priv->button_pressed = FALSE;
+
+  hildon_pannable_area_gesture_end (area);
+
+  /* Whatever motion is still waiting is where the drag ended */
+  hildon_pannable_area_drag_apply (area);
+
+  /* Released past a bound: spring back, without a flick */
+  if (priv->overshoot_x != 0 || priv->overshoot_y != 0) {
+    priv->vel_x = 0;
+    priv->vel_y = 0;
+    hildon_pannable_area_bounce_start (area, 0, 0);
+    if (!priv->bouncing)
+      hildon_pannable_area_set_scrolling (area, FALSE);
+    return;
+  }
+
+  if (!priv->moved)
+    return;
+
+  /* The finger rested before lifting, that is not a flick */
+  if (gtk_get_current_event_time () - priv->last_time > CURSOR_STOPPED_TIMEOUT ||
+      priv->mode == HILDON_PANNABLE_AREA_MODE_PUSH) {
+    priv->vel_x = 0;
+    priv->vel_y = 0;
+  } else {
+    hildon_pannable_area_drag_velocity (area, &priv->vel_x, &priv->vel_y);
+    priv->vel_x = CLAMP (priv->vel_x, -priv->vmax, priv->vmax);
+    priv->vel_y = CLAMP (priv->vel_y, -priv->vmax, priv->vmax);
+
+    hildon_pannable_area_kinetic_start (area);
+  }
+
+  if (!priv->kinetic && !priv->bouncing)
+    hildon_pannable_area_set_scrolling (area, FALSE);
+}
+
+/* Where the current movement will have taken the viewport
+ * prediction_time ms after @now, clamped to the scrollable range */
+static void
+hildon_pannable_area_predict_viewport (HildonPannableArea *area,
+                                       gint64 now,
+                                       GdkRectangle *viewport)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+  gdouble horizon, hvalue, vvalue;
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+  horizon = priv->prediction_time / 1000.0;
+
+  if (priv->kinetic)
+    {
+      gdouble k = -log (priv->decel) * priv->sps;
+      gdouble travel = (k > 0) ? (1 - exp (-k * horizon)) / k : horizon;
+
+      hvalue = gtk_adjustment_get_value (hadj) + priv->vel_x * travel;
+      vvalue = gtk_adjustment_get_value (vadj) + priv->vel_y * travel;
+    }
+  else if (now + horizon * G_USEC_PER_SEC < priv->end_time)
+    {
+      gdouble duration = (priv->end_time - priv->start_time) / (gdouble) G_USEC_PER_SEC;
+      gdouble t = (now + horizon * G_USEC_PER_SEC - priv->start_time) /
+        (gdouble) (priv->end_time - priv->start_time);
+
+      hildon_pannable_area_curve_sample (priv->hsource, priv->hsource_vel, priv->htarget,
+                                         duration, t, &hvalue, NULL);
+      hildon_pannable_area_curve_sample (priv->vsource, priv->vsource_vel, priv->vtarget,
+                                         duration, t, &vvalue, NULL);
+    }
+  else
+    {
+      hvalue = priv->htarget;
+      vvalue = priv->vtarget;
+    }
+
+  hvalue = MIN (hvalue, gtk_adjustment_get_upper (hadj) - gtk_adjustment_get_page_size (hadj));
+  hvalue = MAX (hvalue, gtk_adjustment_get_lower (hadj));
+  vvalue = MIN (vvalue, gtk_adjustment_get_upper (vadj) - gtk_adjustment_get_page_size (vadj));
+  vvalue = MAX (vvalue, gtk_adjustment_get_lower (vadj));
+
+  viewport->x = (gint) hvalue;
+  viewport->y = (gint) vvalue;
+  viewport->width = (gint) gtk_adjustment_get_page_size (hadj);
+  viewport->height = (gint) gtk_adjustment_get_page_size (vadj);
+}
+
+static void
+hildon_pannable_area_emit_predicted_viewport (HildonPannableArea *area,
+                                              gint64 now)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  GdkRectangle viewport;
+
+  if (priv->prediction_time == 0)
+    return;
+
+  hildon_pannable_area_predict_viewport (area, now, &viewport);
+
+  if (viewport.x == priv->predicted_viewport.x &&
+      viewport.y == priv->predicted_viewport.y &&
+      viewport.width == priv->predicted_viewport.width &&
+      viewport.height == priv->predicted_viewport.height)
+    return;
+
+  priv->predicted_viewport = viewport;
+  g_signal_emit (area, pannable_area_signals[PREDICTED_VIEWPORT], 0, &viewport);
+}
+
+static void
+hildon_pannable_area_on_frame_clock_update (GdkFrameClock *clock,
+                                            HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  gint64 now;
+
+  now = hildon_pannable_area_get_frame_time (clock);
+
+  if (priv->kinetic)
+    {
+      hildon_pannable_area_kinetic_step (area, now);
+      hildon_pannable_area_emit_predicted_viewport (area, now);
+    }
+
+  if (priv->bouncing)
+    hildon_pannable_area_bounce_step (area, now);
+
+  if (priv->drag_pending)
+    {
+      hildon_pannable_area_drag_apply (area);
+      hildon_pannable_area_maybe_end_updating (area);
+    }
+
+  if (!priv->animating)
+    return;
+
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+
+  if (now < priv->end_time)
+    {
+      gdouble t, duration, hvalue, vvalue;
+
+      duration = (priv->end_time - priv->start_time) / (gdouble) G_USEC_PER_SEC;
+      t = MAX (0, (now - priv->start_time) / (gdouble) (priv->end_time - priv->start_time));
+      hildon_pannable_area_curve_sample (priv->hsource, priv->hsource_vel, priv->htarget,
+                                         duration, t, &hvalue, NULL);
+      hildon_pannable_area_curve_sample (priv->vsource, priv->vsource_vel, priv->vtarget,
+                                         duration, t, &vvalue, NULL);
+      /* An axis claimed by a linked area is left to it */
+      if (priv->animating_axis[GTK_ORIENTATION_HORIZONTAL])
+        gtk_adjustment_set_value (hadj, hvalue);
+      if (priv->animating_axis[GTK_ORIENTATION_VERTICAL])
+        gtk_adjustment_set_value (vadj, vvalue);
+      hildon_pannable_area_emit_predicted_viewport (area, now);
+    }
+  else
+    {
+      if (priv->animating_axis[GTK_ORIENTATION_HORIZONTAL])
+        gtk_adjustment_set_value (hadj, priv->htarget);
+      if (priv->animating_axis[GTK_ORIENTATION_VERTICAL])
+        gtk_adjustment_set_value (vadj, priv->vtarget);
+      priv->animating = FALSE;
+      hildon_pannable_area_maybe_end_updating (area);
+    }
+}
+
+
+// WORKING ON THIS.  HANDLE -1 values
+static void hildon_pannable_area_set_value_internal (HildonPannableArea *area,
+                                         gdouble             hvalue,
+                                         gdouble             vvalue,
+                                         gboolean            animate)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  /* don't use CLAMP() so we don't end up below lower if upper - page_size
+   * is smaller than lower
+   */
+
+  GtkAdjustment *vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+  if (vvalue == -1)
+    {
+      vvalue = gtk_adjustment_get_value (vadj);
+    }
+  else
+    {
+      vvalue = MIN (vvalue, gtk_adjustment_get_upper(vadj) - gtk_adjustment_get_page_size(vadj));
+      vvalue = MAX (vvalue, gtk_adjustment_get_lower(vadj));
+    }
+
+  GtkAdjustment *hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  if (hvalue == -1)
+    {
+      hvalue = gtk_adjustment_get_value (hadj);
+    }
+  else
+    {
+      hvalue = MIN (hvalue, gtk_adjustment_get_upper(hadj) - gtk_adjustment_get_page_size(hadj));
+      hvalue = MAX (hvalue, gtk_adjustment_get_lower(hadj));
+    }
+
+  area->priv->clock = gtk_widget_get_frame_clock (GTK_WIDGET (area));
+
+  hildon_pannable_area_claim_links (area);
+
+  if (animate && priv->duration != 0 && priv->clock != NULL)
+    {
+      gdouble duration = priv->duration / 1000.0;
+      gdouble hvel, vvel;
+      gboolean moving;
+      gint64 now;
+
+      if (priv->animating && priv->htarget == hvalue && priv->vtarget == vvalue &&
+          priv->animating_axis[GTK_ORIENTATION_HORIZONTAL] &&
+          priv->animating_axis[GTK_ORIENTATION_VERTICAL])
+        return;
+
+      /* Retarget in flight: the new curve starts where we are and with
+       * the speed we have, be it from a flick or from a previous
+       * scroll_to(), so repeated calls don't stall the movement */
+      now = hildon_pannable_area_get_frame_time (priv->clock);
+      moving = priv->kinetic || priv->animating;
+      if (priv->kinetic)
+        {
+          hvel = priv->vel_x;
+          vvel = priv->vel_y;
+        }
+      else
+        {
+          hildon_pannable_area_animation_velocity (area, now, &hvel, &vvel);
+        }
+
+      priv->kinetic = FALSE;
+      priv->vel_x = 0;
+      priv->vel_y = 0;
+
+      priv->vsource = gtk_adjustment_get_value (vadj);
+      priv->vtarget = vvalue;
+      priv->hsource = gtk_adjustment_get_value (hadj);
+      priv->htarget = hvalue;
+
+      /* An ease-out starts at three times its mean speed; if we are
+       * already moving faster than that towards the target, shorten
+       * the curve so it starts at our speed instead of overshooting */
+      if ((hvalue - priv->hsource) * hvel > 0)
+        duration = MIN (duration, 3 * fabs (hvalue - priv->hsource) / fabs (hvel));
+      if ((vvalue - priv->vsource) * vvel > 0)
+        duration = MIN (duration, 3 * fabs (vvalue - priv->vsource) / fabs (vvel));
+      duration = MAX (duration, KINETIC_MIN_CURVE_TIME);
+
+      priv->hsource_vel = hildon_pannable_area_curve_source_vel (priv->hsource, hvalue,
+                                                                 hvel, duration, moving);
+      priv->vsource_vel = hildon_pannable_area_curve_source_vel (priv->vsource, vvalue,
+                                                                 vvel, duration, moving);
+
+      priv->start_time = now;
+      priv->end_time = priv->start_time + duration * G_USEC_PER_SEC;
+      priv->animating = TRUE;
+      priv->animating_axis[GTK_ORIENTATION_HORIZONTAL] = TRUE;
+      priv->animating_axis[GTK_ORIENTATION_VERTICAL] = TRUE;
+      hildon_pannable_area_bounce_stop (area);
+      hildon_pannable_area_begin_updating (area);
+    }
+  else
+    {
+      /* An explicit destination overrides any flick in progress */
+      priv->kinetic = FALSE;
+      priv->vel_x = 0;
+      priv->vel_y = 0;
+      priv->animating = FALSE;
+      hildon_pannable_area_bounce_stop (area);
+      hildon_pannable_area_end_updating (area);
+      gtk_adjustment_set_value (vadj, vvalue);
+      gtk_adjustment_set_value (hadj, hvalue);
+    }
+}
+
+/**
  * hildon_pannable_area_scroll_to:
  * @area: A #HildonPannableArea.
  * @x: The x coordinate of the destination point or -1 to ignore this axis.
@@ -743,6 +2673,9 @@ static void hildon_pannable_area_set_value_internal (HildonPannableArea *area,
  * </programlisting>
  * </example>
  *
+ * hildon_pannable_area_scroll_to_row() does the same for long lists
+ * without measuring the rows above the one scrolled to.
+ *
  * If you want to present a child widget in simpler scenarios,
  * use hildon_pannable_area_scroll_to_child() instead.
  *
@@ -890,59 +2823,520 @@ hildon_pannable_area_scroll_to_child (HildonPannableArea *area, GtkWidget *child
   if (gtk_bin_get_child (GTK_BIN (area)) == NULL)
     return;
 
-  /* We need to get to check the child of the inside the area */
-  bin_child = gtk_bin_get_child (GTK_BIN (area));
+  /* We need to get to check the child of the inside the area */
+  bin_child = gtk_bin_get_child (GTK_BIN (area));
+
+  /* we check if we added a viewport */
+  if (GTK_IS_VIEWPORT (bin_child)) {
+    bin_child = gtk_bin_get_child (GTK_BIN (bin_child));
+  }
+
+  if (gtk_widget_translate_coordinates (child, bin_child, 0, 0, &x, &y))
+    hildon_pannable_area_scroll_to (area, x, y);
+}
+
+/**
+ * hildon_pannable_area_jump_to_child:
+ * @area: A #HildonPannableArea.
+ * @child: A #GtkWidget, descendant of @area.
+ *
+ * Jumps to make sure @child is visible inside @area. @child must
+ * be a descendant of @area. If you want to move inside a scrollable
+ * widget, like, #GtkTreeview, see hildon_pannable_area_scroll_to().
+ *
+ * There is a precondition to this function: the widget must be
+ * already realized. You can control if the widget is ready with the
+ * GTK_WIDGET_REALIZED macro. If you want to call this function during
+ * the initialization process of the widget do it inside a callback to
+ * the ::realize signal, using g_signal_connect_after() function.
+ *
+ * Since: 2.2
+ **/
+void
+hildon_pannable_area_jump_to_child (HildonPannableArea *area, GtkWidget *child)
+{
+  GtkWidget *bin_child;
+  gint x, y;
+
+  g_return_if_fail (gtk_widget_get_realized (GTK_WIDGET (area)));
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+  g_return_if_fail (GTK_IS_WIDGET (child));
+  g_return_if_fail (gtk_widget_is_ancestor (child, GTK_WIDGET (area)));
+
+  if (gtk_bin_get_child (GTK_BIN (area)) == NULL)
+    return;
+
+  /* We need to get to check the child of the inside the area */
+  bin_child = gtk_bin_get_child (GTK_BIN (area));
+
+  /* we check if we added a viewport */
+  if (GTK_IS_VIEWPORT (bin_child)) {
+    bin_child = gtk_bin_get_child (GTK_BIN (bin_child));
+  }
+
+  if (gtk_widget_translate_coordinates (child, bin_child, 0, 0, &x, &y))
+    hildon_pannable_area_jump_to (area, x, y);
+}
+
+static gint
+rectangle_compare_y (gconstpointer a,
+                     gconstpointer b)
+{
+  const GdkRectangle *ra = a;
+  const GdkRectangle *rb = b;
+
+  return (ra->y != rb->y) ? ra->y - rb->y : ra->x - rb->x;
+}
+
+/* Vertical value showing fully as many of the sorted @rects as
+ * possible, preferring among the best groups the one needing the
+ * least scroll from @current */
+static gdouble
+hildon_pannable_area_reveal_most (GArray *rects,
+                                  gdouble current,
+                                  gdouble page)
+{
+  gdouble best = current;
+  gdouble best_distance = G_MAXDOUBLE;
+  gint best_count = 0;
+  guint i, j;
+
+  for (i = 0; i < rects->len; i++) {
+    GdkRectangle *first = &g_array_index (rects, GdkRectangle, i);
+    gdouble top = first->y;
+    gdouble bottom = top;
+    gdouble value, distance;
+    gint count = 0;
+
+    for (j = i; j < rects->len; j++) {
+      GdkRectangle *r = &g_array_index (rects, GdkRectangle, j);
+
+      if (r->y >= top + page)
+        break;
+      if (r->y + r->height <= top + page) {
+        count++;
+        bottom = MAX (bottom, r->y + r->height);
+      }
+    }
+
+    if (top < current)
+      value = top;
+    else if (bottom > current + page)
+      value = bottom - page;
+    else
+      value = current;
+    distance = fabs (value - current);
+
+    if (count > best_count || (count == best_count && distance < best_distance)) {
+      best = value;
+      best_count = count;
+      best_distance = distance;
+    }
+  }
+
+  return best;
+}
+
+static void
+hildon_pannable_area_reveal_children (HildonPannableArea *area,
+                                      GList *children,
+                                      HildonPannableAreaRevealPolicy policy,
+                                      gboolean animate)
+{
+  GtkAdjustment *hadj;
+  GtkAdjustment *vadj;
+  GtkWidget *bin_child;
+  GArray *rects;
+  GList *l;
+  gdouble hvalue, vvalue;
+
+  bin_child = gtk_bin_get_child (GTK_BIN (area));
+  if (bin_child == NULL)
+    return;
+
+  if (GTK_IS_VIEWPORT (bin_child))
+    bin_child = gtk_bin_get_child (GTK_BIN (bin_child));
+
+  for (l = children; l != NULL; l = l->next) {
+    g_return_if_fail (GTK_IS_WIDGET (l->data));
+    g_return_if_fail (gtk_widget_is_ancestor (l->data, GTK_WIDGET (area)));
+  }
+
+  rects = g_array_new (FALSE, FALSE, sizeof (GdkRectangle));
+
+  for (l = children; l != NULL; l = l->next) {
+    GtkWidget *child = l->data;
+    GdkRectangle rect;
+
+    if (!gtk_widget_translate_coordinates (child, bin_child, 0, 0, &rect.x, &rect.y))
+      continue;
+
+    rect.width = gtk_widget_get_allocated_width (child);
+    rect.height = gtk_widget_get_allocated_height (child);
+    g_array_append_val (rects, rect);
+
+    if (policy == HILDON_PANNABLE_AREA_REVEAL_FIRST)
+      break;
+  }
+
+  if (rects->len == 0) {
+    g_array_free (rects, TRUE);
+    return;
+  }
+
+  hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+  vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+
+  g_array_sort (rects, rectangle_compare_y);
+
+  if (policy == HILDON_PANNABLE_AREA_REVEAL_MOST) {
+    hvalue = -1;
+    vvalue = hildon_pannable_area_reveal_most (rects, gtk_adjustment_get_value (vadj),
+                                               gtk_adjustment_get_page_size (vadj));
+  } else {
+    /* The first one, or the topmost: the same point scroll_to_child()
+     * would center */
+    GdkRectangle *target = &g_array_index (rects, GdkRectangle, 0);
+
+    hvalue = target->x - gtk_adjustment_get_page_size (hadj) / 2;
+    vvalue = target->y - gtk_adjustment_get_page_size (vadj) / 2;
+  }
+
+  /* -1 means "leave this axis alone" to set_value_internal() */
+  if (hvalue != -1)
+    hvalue = MAX (hvalue, gtk_adjustment_get_lower (hadj));
+  vvalue = MAX (vvalue, gtk_adjustment_get_lower (vadj));
+
+  hildon_pannable_area_set_value_internal (area, hvalue, vvalue, animate);
+
+  g_array_free (rects, TRUE);
+}
+
+/**
+ * hildon_pannable_area_scroll_to_children:
+ * @area: A #HildonPannableArea.
+ * @children: (element-type GtkWidget): a list of descendants of @area
+ * @policy: which of @children to bring into view
+ *
+ * Smoothly scrolls @area once to reveal @children according to
+ * @policy. This is cheaper and smoother than calling
+ * hildon_pannable_area_scroll_to_child() for each of them, which
+ * would restart the animation every time.
+ *
+ * The same preconditions as for hildon_pannable_area_scroll_to_child()
+ * apply.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_scroll_to_children (HildonPannableArea *area,
+                                         GList *children,
+                                         HildonPannableAreaRevealPolicy policy)
+{
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+  g_return_if_fail (gtk_widget_get_realized (GTK_WIDGET (area)));
+
+  hildon_pannable_area_reveal_children (area, children, policy, TRUE);
+}
+
+/**
+ * hildon_pannable_area_jump_to_children:
+ * @area: A #HildonPannableArea.
+ * @children: (element-type GtkWidget): a list of descendants of @area
+ * @policy: which of @children to bring into view
+ *
+ * Jumps to reveal @children according to @policy, see
+ * hildon_pannable_area_scroll_to_children().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_jump_to_children (HildonPannableArea *area,
+                                       GList *children,
+                                       HildonPannableAreaRevealPolicy policy)
+{
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+  g_return_if_fail (gtk_widget_get_realized (GTK_WIDGET (area)));
+
+  hildon_pannable_area_reveal_children (area, children, policy, FALSE);
+}
+
+static void
+hildon_pannable_area_row_scroll_stop (HildonPannableArea *area)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+
+  if (priv->row_tick_id)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (area), priv->row_tick_id);
+  priv->row_tick_id = 0;
+
+  if (priv->row_view)
+    g_object_remove_weak_pointer (G_OBJECT (priv->row_view), (gpointer *) &priv->row_view);
+  priv->row_view = NULL;
+
+  if (priv->row_ref)
+    gtk_tree_row_reference_free (priv->row_ref);
+  priv->row_ref = NULL;
+}
+
+/* Position of the row at @path in the tree coordinates of @treeview,
+ * as known by the tree view right now, and its height */
+static gint
+hildon_pannable_area_row_position (GtkTreeView *treeview,
+                                   GtkTreePath *path,
+                                   gint *height)
+{
+  GdkRectangle rect;
+  gint y;
+
+  gtk_tree_view_get_background_area (treeview, path, NULL, &rect);
+  gtk_tree_view_convert_bin_window_to_tree_coords (treeview, 0, rect.y, NULL, &y);
+
+  *height = rect.height;
+
+  return y;
+}
+
+/* Once the rows around the target have been validated by the tree
+ * view, their real heights may have moved the row away from the
+ * estimated position; follow it until the scroll is over */
+static gboolean
+hildon_pannable_area_row_scroll_tick (GtkWidget *widget,
+                                      GdkFrameClock *frame_clock,
+                                      gpointer user_data)
+{
+  HildonPannableArea *area = HILDON_PANNABLE_AREA (widget);
+  HildonPannableAreaPrivate *priv = area->priv;
+  GtkTreePath *path;
+  gint y, height;
+
+  if (priv->row_view == NULL || !gtk_tree_row_reference_valid (priv->row_ref))
+    {
+      priv->row_tick_id = 0;
+      hildon_pannable_area_row_scroll_stop (area);
+      return G_SOURCE_REMOVE;
+    }
+
+  path = gtk_tree_row_reference_get_path (priv->row_ref);
+  y = hildon_pannable_area_row_position (priv->row_view, path, &height);
+  gtk_tree_path_free (path);
+
+  if (ABS (y - priv->row_target_y) > 1)
+    {
+      priv->row_target_y = y;
+      hildon_pannable_area_scroll_to (area, -1, y + height / 2);
+      return G_SOURCE_CONTINUE;
+    }
+
+  if (hildon_pannable_area_get_scrolling (area))
+    return G_SOURCE_CONTINUE;
 
-  /* we check if we added a viewport */
-  if (GTK_IS_VIEWPORT (bin_child)) {
-    bin_child = gtk_bin_get_child (GTK_BIN (bin_child));
-  }
+  priv->row_tick_id = 0;
+  hildon_pannable_area_row_scroll_stop (area);
 
-  if (gtk_widget_translate_coordinates (child, bin_child, 0, 0, &x, &y))
-    hildon_pannable_area_scroll_to (area, x, y);
+  return G_SOURCE_REMOVE;
 }
 
 /**
- * hildon_pannable_area_jump_to_child:
+ * hildon_pannable_area_scroll_to_row:
  * @area: A #HildonPannableArea.
- * @child: A #GtkWidget, descendant of @area.
+ * @treeview: A #GtkTreeView, the child of @area.
+ * @path: The path of a row of @treeview.
  *
- * Jumps to make sure @child is visible inside @area. @child must
- * be a descendant of @area. If you want to move inside a scrollable
- * widget, like, #GtkTreeview, see hildon_pannable_area_scroll_to().
+ * Smoothly scrolls @area to center the row at @path of @treeview, like
+ * hildon_pannable_area_scroll_to() with the position of the row, but
+ * without looking at the rows above it.
  *
- * There is a precondition to this function: the widget must be
- * already realized. You can control if the widget is ready with the
- * GTK_WIDGET_REALIZED macro. If you want to call this function during
- * the initialization process of the widget do it inside a callback to
- * the ::realize signal, using g_signal_connect_after() function.
+ * In a list whose #GtkTreeView:fixed-height-mode is set, the position
+ * of the row is worked out from its index and the height of the first
+ * row. Otherwise the same estimate is scrolled to first, and the scroll
+ * is corrected in the following frames, once the tree view has measured
+ * the rows that came into view. Rows of trees, which have no index,
+ * are scrolled to where the tree view places them.
  *
- * Since: 2.2
+ * The same preconditions as for hildon_pannable_area_scroll_to()
+ * apply.
+ *
+ * Since: 3.0
  **/
 void
-hildon_pannable_area_jump_to_child (HildonPannableArea *area, GtkWidget *child)
+hildon_pannable_area_scroll_to_row (HildonPannableArea *area,
+                                    GtkTreeView *treeview,
+                                    GtkTreePath *path)
 {
-  GtkWidget *bin_child;
-  gint x, y;
+  HildonPannableAreaPrivate *priv;
+  GtkTreeModel *model;
+  GtkTreePath *first;
+  gint y, height;
 
-  g_return_if_fail (gtk_widget_get_realized (GTK_WIDGET (area)));
   g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
-  g_return_if_fail (GTK_IS_WIDGET (child));
-  g_return_if_fail (gtk_widget_is_ancestor (child, GTK_WIDGET (area)));
+  g_return_if_fail (gtk_widget_get_realized (GTK_WIDGET (area)));
+  g_return_if_fail (GTK_IS_TREE_VIEW (treeview));
+  g_return_if_fail (path != NULL);
 
-  if (gtk_bin_get_child (GTK_BIN (area)) == NULL)
+  priv = area->priv;
+  model = gtk_tree_view_get_model (treeview);
+
+  hildon_pannable_area_row_scroll_stop (area);
+
+  if (model == NULL)
     return;
 
-  /* We need to get to check the child of the inside the area */
-  bin_child = gtk_bin_get_child (GTK_BIN (area));
+  if (gtk_tree_path_get_depth (path) != 1 ||
+      !(gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY))
+    {
+      y = hildon_pannable_area_row_position (treeview, path, &height);
+      hildon_pannable_area_scroll_to (area, -1, y + height / 2);
+      return;
+    }
 
-  /* we check if we added a viewport */
-  if (GTK_IS_VIEWPORT (bin_child)) {
-    bin_child = gtk_bin_get_child (GTK_BIN (bin_child));
+  /* Only the first row needs to be measured */
+  first = gtk_tree_path_new_first ();
+  y = hildon_pannable_area_row_position (treeview, first, &height);
+  gtk_tree_path_free (first);
+
+  y += gtk_tree_path_get_indices (path)[0] * height;
+  hildon_pannable_area_scroll_to (area, -1, y + height / 2);
+
+  if (gtk_tree_view_get_fixed_height_mode (treeview))
+    return;
+
+  priv->row_view = treeview;
+  g_object_add_weak_pointer (G_OBJECT (treeview), (gpointer *) &priv->row_view);
+  priv->row_ref = gtk_tree_row_reference_new (model, path);
+  priv->row_target_y = y;
+  priv->row_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (area),
+                                                    hildon_pannable_area_row_scroll_tick,
+                                                    NULL, NULL);
+}
+
+typedef struct {
+  GArray *entries;
+  GtkWidget *content;
+  gint depth;
+} HitIndexData;
+
+static void
+hildon_pannable_area_hit_index_add (GtkWidget *widget,
+                                    gpointer user_data)
+{
+  HitIndexData *data = user_data;
+  HitEntry entry;
+  gint x, y;
+
+  if (!gtk_widget_is_drawable (widget) ||
+      !gtk_widget_translate_coordinates (widget, data->content, 0, 0, &x, &y))
+    return;
+
+  entry.widget = widget;
+  entry.depth = data->depth;
+  entry.rect.x = x;
+  entry.rect.y = y;
+  entry.rect.width = gtk_widget_get_allocated_width (widget);
+  entry.rect.height = gtk_widget_get_allocated_height (widget);
+  g_array_append_val (data->entries, entry);
+
+  /* Activatable widgets are what a tap is meant for, their own
+   * children (a button label, say) are not */
+  if (GTK_IS_CONTAINER (widget) &&
+      GTK_WIDGET_GET_CLASS (widget)->activate_signal == 0) {
+    data->depth++;
+    gtk_container_forall (GTK_CONTAINER (widget),
+                          hildon_pannable_area_hit_index_add, data);
+    data->depth--;
   }
+}
 
-  if (gtk_widget_translate_coordinates (child, bin_child, 0, 0, &x, &y))
-    hildon_pannable_area_jump_to (area, x, y);
+static gint
+hit_entry_compare (gconstpointer a,
+                   gconstpointer b)
+{
+  const HitEntry *ea = a;
+  const HitEntry *eb = b;
+
+  return ea->rect.y - eb->rect.y;
+}
+
+/* The sorted array is read as a balanced binary tree, the middle of
+ * each range being its root; hit_max_end holds the lowest edge of each
+ * subtree so stabbing queries can skip whole ranges */
+static gint
+hildon_pannable_area_hit_index_build_tree (HildonPannableAreaPrivate *priv,
+                                           gint lo,
+                                           gint hi)
+{
+  HitEntry *entry;
+  gint mid, end;
+
+  if (lo >= hi)
+    return G_MININT;
+
+  mid = (lo + hi) / 2;
+  entry = &g_array_index (priv->hit_entries, HitEntry, mid);
+  end = entry->rect.y + entry->rect.height;
+  end = MAX (end, hildon_pannable_area_hit_index_build_tree (priv, lo, mid));
+  end = MAX (end, hildon_pannable_area_hit_index_build_tree (priv, mid + 1, hi));
+  priv->hit_max_end[mid] = end;
+
+  return end;
+}
+
+static void
+hildon_pannable_area_hit_index_rebuild (HildonPannableArea *area,
+                                        GtkWidget *content)
+{
+  HildonPannableAreaPrivate *priv = area->priv;
+  HitIndexData data;
+
+  if (priv->hit_entries == NULL)
+    priv->hit_entries = g_array_new (FALSE, FALSE, sizeof (HitEntry));
+  g_array_set_size (priv->hit_entries, 0);
+
+  data.entries = priv->hit_entries;
+  data.content = content;
+  data.depth = 0;
+  hildon_pannable_area_hit_index_add (content, &data);
+
+  /* Stable for equal keys, so later (topmost) siblings stay later */
+  g_array_sort (priv->hit_entries, hit_entry_compare);
+
+  g_free (priv->hit_max_end);
+  priv->hit_max_end = g_new (gint, MAX (priv->hit_entries->len, 1));
+  hildon_pannable_area_hit_index_build_tree (priv, 0, priv->hit_entries->len);
+
+  priv->hit_index_valid = TRUE;
+}
+
+static void
+hildon_pannable_area_hit_index_query (HildonPannableAreaPrivate *priv,
+                                      gint lo,
+                                      gint hi,
+                                      gint x,
+                                      gint y,
+                                      HitEntry **best)
+{
+  HitEntry *entry;
+  gint mid;
+
+  if (lo >= hi)
+    return;
+
+  mid = (lo + hi) / 2;
+  if (priv->hit_max_end[mid] <= y)
+    return;
+
+  hildon_pannable_area_hit_index_query (priv, lo, mid, x, y, best);
+
+  entry = &g_array_index (priv->hit_entries, HitEntry, mid);
+  if (entry->rect.y > y)
+    return;
+
+  if (y < entry->rect.y + entry->rect.height &&
+      x >= entry->rect.x && x < entry->rect.x + entry->rect.width &&
+      (*best == NULL || entry->depth >= (*best)->depth))
+    *best = entry;
+
+  hildon_pannable_area_hit_index_query (priv, mid + 1, hi, x, y, best);
 }
 
 /**
@@ -954,6 +3348,10 @@ hildon_pannable_area_jump_to_child (HildonPannableArea *area, GtkWidget *child)
  * Get the widget at the point (x, y) inside the pannable area. In
  * case no widget found it returns NULL.
  *
+ * When the child of @area is a #GtkViewport the lookup goes through an
+ * index of the allocations of its content, which is rebuilt lazily
+ * after each relayout and answers in logarithmic time.
+ *
  * returns: the #GtkWidget if we find a widget, NULL in any other case
  *
  * Since: 2.2
@@ -964,6 +3362,33 @@ hildon_pannable_get_child_widget_at (HildonPannableArea *area,
 {
   GdkWindow *window = NULL;
   GtkWidget *child_widget = NULL;
+  GtkWidget *content;
+
+  g_return_val_if_fail (HILDON_IS_PANNABLE_AREA (area), NULL);
+
+  /* The content of a viewport is hit tested through an index of the
+   * allocations, rebuilt after each relayout; other children are
+   * looked up through their windows */
+  content = hildon_pannable_area_get_cacheable_child (area);
+  if (content != NULL) {
+    HildonPannableAreaPrivate *priv = area->priv;
+    GtkAdjustment *hadj;
+    GtkAdjustment *vadj;
+    HitEntry *best = NULL;
+
+    if (!priv->hit_index_valid)
+      hildon_pannable_area_hit_index_rebuild (area, content);
+
+    hadj = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area));
+    vadj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area));
+
+    hildon_pannable_area_hit_index_query (priv, 0, priv->hit_entries->len,
+                                          (gint) (x + gtk_adjustment_get_value (hadj)),
+                                          (gint) (y + gtk_adjustment_get_value (vadj)),
+                                          &best);
+
+    return best ? best->widget : NULL;
+  }
 
   window = hildon_pannable_area_get_topmost
     (gtk_widget_get_window (gtk_bin_get_child (GTK_BIN (area))),
@@ -1062,3 +3487,328 @@ hildon_pannable_area_set_center_on_child_focus  (HildonPannableArea *area,
 
   area->priv->center_on_child_focus = value;
 }
+
+/**
+ * hildon_pannable_area_get_scrolling:
+ * @area: A #HildonPannableArea
+ *
+ * Gets the @area #HildonPannableArea:scrolling property value.
+ *
+ * Returns: %TRUE if @area is being panned or is animating
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_pannable_area_get_scrolling              (HildonPannableArea *area)
+{
+  g_return_val_if_fail (HILDON_IS_PANNABLE_AREA (area), FALSE);
+
+  return area->priv->scrolling;
+}
+
+/**
+ * hildon_pannable_area_widget_get_scrolling:
+ * @widget: A #GtkWidget
+ *
+ * Tells whether any #HildonPannableArea containing @widget is
+ * currently being panned. This is meant to be called from draw
+ * handlers or cell data functions, which can then skip expensive work
+ * such as pixbuf scaling until the motion stops and the area asks for
+ * a full redraw.
+ *
+ * Returns: %TRUE if an ancestor of @widget is scrolling
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_pannable_area_widget_get_scrolling       (GtkWidget *widget)
+{
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), FALSE);
+
+  for (widget = gtk_widget_get_parent (widget); widget != NULL;
+       widget = gtk_widget_get_parent (widget)) {
+    if (HILDON_IS_PANNABLE_AREA (widget) &&
+        HILDON_PANNABLE_AREA (widget)->priv->scrolling)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+ * hildon_pannable_area_set_cache_content:
+ * @area: A #HildonPannableArea
+ * @cache_content: whether to cache the content while panning
+ *
+ * Sets the @area #HildonPannableArea:cache-content property to
+ * @cache_content.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_set_cache_content          (HildonPannableArea *area,
+                                                 gboolean cache_content)
+{
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+
+  cache_content = (cache_content != FALSE);
+
+  if (area->priv->cache_content == cache_content)
+    return;
+
+  area->priv->cache_content = cache_content;
+  hildon_pannable_area_invalidate_cache (area);
+  gtk_widget_queue_draw (GTK_WIDGET (area));
+
+  g_object_notify (G_OBJECT (area), "cache-content");
+}
+
+/**
+ * hildon_pannable_area_get_cache_content:
+ * @area: A #HildonPannableArea
+ *
+ * Gets the @area #HildonPannableArea:cache-content property value.
+ *
+ * Returns: whether @area caches its content while panning
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_pannable_area_get_cache_content          (HildonPannableArea *area)
+{
+  g_return_val_if_fail (HILDON_IS_PANNABLE_AREA (area), FALSE);
+
+  return area->priv->cache_content;
+}
+
+/**
+ * hildon_pannable_area_link:
+ * @area: A #HildonPannableArea
+ * @other: Another #HildonPannableArea
+ * @orientation: the axis to link
+ *
+ * Links the @orientation axis of @area and @other, which will share
+ * one #GtkAdjustment for it from then on, @area's one. Panning either
+ * of them scrolls all the linked areas in the same frame; when one
+ * area starts a drag, a flick or an animation, the motion of the
+ * others stops, so a single animation and frame clock tick drive the
+ * group. This is useful, for instance, to keep a header row in sync
+ * with the body of a table. The linked contents should have the same
+ * extent along @orientation.
+ *
+ * If @other was linked to other areas on that axis it leaves them.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_link                       (HildonPannableArea *area,
+                                                 HildonPannableArea *other,
+                                                 GtkOrientation orientation)
+{
+  AreaLink *link;
+
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (other));
+  g_return_if_fail (area != other);
+
+  if (other->priv->links[orientation] != NULL &&
+      other->priv->links[orientation] == area->priv->links[orientation])
+    return;
+
+  hildon_pannable_area_unlink (other, orientation);
+
+  link = area->priv->links[orientation];
+  if (link == NULL) {
+    link = g_slice_new0 (AreaLink);
+    link->members = g_slist_prepend (link->members, area);
+    area->priv->links[orientation] = link;
+  }
+
+  link->members = g_slist_prepend (link->members, other);
+  other->priv->links[orientation] = link;
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    gtk_scrolled_window_set_hadjustment (GTK_SCROLLED_WINDOW (other),
+                                         gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (area)));
+  else
+    gtk_scrolled_window_set_vadjustment (GTK_SCROLLED_WINDOW (other),
+                                         gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (area)));
+}
+
+/**
+ * hildon_pannable_area_unlink:
+ * @area: A #HildonPannableArea
+ * @orientation: the axis to unlink
+ *
+ * Removes @area from the areas it was linked to on the @orientation
+ * axis with hildon_pannable_area_link(). @area gets an adjustment of
+ * its own for that axis.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_unlink                     (HildonPannableArea *area,
+                                                 GtkOrientation orientation)
+{
+  AreaLink *link;
+
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+
+  link = area->priv->links[orientation];
+  if (link == NULL)
+    return;
+
+  link->members = g_slist_remove (link->members, area);
+  area->priv->links[orientation] = NULL;
+
+  /* A group of one is no group */
+  if (link->members != NULL && link->members->next == NULL) {
+    HILDON_PANNABLE_AREA (link->members->data)->priv->links[orientation] = NULL;
+    g_slist_free (link->members);
+    link->members = NULL;
+  }
+  if (link->members == NULL)
+    g_slice_free (AreaLink, link);
+
+  if (gtk_widget_in_destruction (GTK_WIDGET (area)))
+    return;
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    gtk_scrolled_window_set_hadjustment (GTK_SCROLLED_WINDOW (area), NULL);
+  else
+    gtk_scrolled_window_set_vadjustment (GTK_SCROLLED_WINDOW (area), NULL);
+}
+
+G_DEFINE_BOXED_TYPE (HildonPannableAreaFrameStats, hildon_pannable_area_frame_stats,
+                     hildon_pannable_area_frame_stats_copy,
+                     hildon_pannable_area_frame_stats_free)
+
+/**
+ * hildon_pannable_area_frame_stats_copy:
+ * @stats: a #HildonPannableAreaFrameStats
+ *
+ * Copies @stats.
+ *
+ * Returns: a newly allocated copy of @stats, to be freed with
+ * hildon_pannable_area_frame_stats_free()
+ *
+ * Since: 3.0
+ **/
+HildonPannableAreaFrameStats *
+hildon_pannable_area_frame_stats_copy           (const HildonPannableAreaFrameStats *stats)
+{
+  g_return_val_if_fail (stats != NULL, NULL);
+
+  return g_slice_dup (HildonPannableAreaFrameStats, stats);
+}
+
+/**
+ * hildon_pannable_area_frame_stats_free:
+ * @stats: a #HildonPannableAreaFrameStats
+ *
+ * Frees a #HildonPannableAreaFrameStats copied with
+ * hildon_pannable_area_frame_stats_copy().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_frame_stats_free           (HildonPannableAreaFrameStats *stats)
+{
+  if (stats)
+    g_slice_free (HildonPannableAreaFrameStats, stats);
+}
+
+/**
+ * hildon_pannable_area_set_record_frame_stats:
+ * @area: A #HildonPannableArea
+ * @record: whether to measure frame timings
+ *
+ * Sets the #HildonPannableArea:record-frame-stats property. While it
+ * is set, @area measures, in every drag or kinetic or
+ * hildon_pannable_area_scroll_to() animation, how many frames it
+ * paints, how many display refreshes it misses and how far it moves.
+ * Each session is reported with #HildonPannableArea::frame-stats and
+ * added to the totals returned by hildon_pannable_area_get_frame_stats().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_set_record_frame_stats     (HildonPannableArea *area,
+                                                 gboolean record)
+{
+  HildonPannableAreaPrivate *priv;
+
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+
+  priv = area->priv;
+  record = (record != FALSE);
+
+  if (priv->record_frame_stats == record)
+    return;
+
+  priv->record_frame_stats = record;
+
+  if (record && priv->scrolling)
+    hildon_pannable_area_start_frame_stats (area);
+  else if (!record)
+    hildon_pannable_area_stop_frame_stats (area, FALSE);
+
+  g_object_notify (G_OBJECT (area), "record-frame-stats");
+}
+
+/**
+ * hildon_pannable_area_get_record_frame_stats:
+ * @area: A #HildonPannableArea
+ *
+ * Gets the @area #HildonPannableArea:record-frame-stats property value.
+ *
+ * Returns: whether @area measures frame timings
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_pannable_area_get_record_frame_stats     (HildonPannableArea *area)
+{
+  g_return_val_if_fail (HILDON_IS_PANNABLE_AREA (area), FALSE);
+
+  return area->priv->record_frame_stats;
+}
+
+/**
+ * hildon_pannable_area_get_frame_stats:
+ * @area: A #HildonPannableArea
+ * @stats: return location for the measurements
+ *
+ * Fills @stats with the measurements of all the sessions that ended
+ * since #HildonPannableArea:record-frame-stats was set or
+ * hildon_pannable_area_reset_frame_stats() was last called.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_get_frame_stats            (HildonPannableArea *area,
+                                                 HildonPannableAreaFrameStats *stats)
+{
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+  g_return_if_fail (stats != NULL);
+
+  *stats = area->priv->frame_stats;
+}
+
+/**
+ * hildon_pannable_area_reset_frame_stats:
+ * @area: A #HildonPannableArea
+ *
+ * Clears the totals returned by hildon_pannable_area_get_frame_stats().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_pannable_area_reset_frame_stats          (HildonPannableArea *area)
+{
+  HildonPannableAreaFrameStats empty = { 0, };
+
+  g_return_if_fail (HILDON_IS_PANNABLE_AREA (area));
+
+  area->priv->frame_stats = empty;
+}
@@ -96,6 +96,52 @@ typedef enum {
   HILDON_MOVEMENT_RIGHT
 } HildonMovementDirection;
 
+/**
+ * HildonPannableAreaRevealPolicy:
+ * @HILDON_PANNABLE_AREA_REVEAL_FIRST: Reveal the first widget of the list
+ * @HILDON_PANNABLE_AREA_REVEAL_TOPMOST: Reveal the widget placed highest
+ * @HILDON_PANNABLE_AREA_REVEAL_MOST: Scroll as little as possible while
+ * fully revealing as many widgets as fit in the area
+ *
+ * Used by hildon_pannable_area_scroll_to_children() to choose what to
+ * bring into view.
+ *
+ * Since: 3.0
+ */
+typedef enum {
+  HILDON_PANNABLE_AREA_REVEAL_FIRST,
+  HILDON_PANNABLE_AREA_REVEAL_TOPMOST,
+  HILDON_PANNABLE_AREA_REVEAL_MOST
+} HildonPannableAreaRevealPolicy;
+
+/**
+ * HildonPannableAreaFrameStats:
+ * @sessions: the number of drag or animation sessions measured
+ * @frames: the number of frames painted while moving
+ * @missed_frames: how many display refreshes passed without a new frame
+ * @worst_frame_interval: the longest time between two frames, in
+ * microseconds
+ * @distance: how far the adjustments moved in total, in pixels
+ * @duration: the time spent moving, in microseconds
+ *
+ * Frame timing measurements of a #HildonPannableArea, see
+ * hildon_pannable_area_set_record_frame_stats().
+ *
+ * Since: 3.0
+ */
+typedef struct
+{
+  guint sessions;
+  guint frames;
+  guint missed_frames;
+  gint64 worst_frame_interval;
+  gdouble distance;
+  gint64 duration;
+} HildonPannableAreaFrameStats;
+
+#define                                         HILDON_TYPE_PANNABLE_AREA_FRAME_STATS \
+                                                (hildon_pannable_area_frame_stats_get_type ())
+
 /**
  * HildonPannableArea:
  *
@@ -138,6 +184,15 @@ void hildon_pannable_area_scroll_to_child       (HildonPannableArea *area,
  						 GtkWidget *child);
 void hildon_pannable_area_jump_to_child         (HildonPannableArea *area,
                                                  GtkWidget *child);
+void hildon_pannable_area_scroll_to_children    (HildonPannableArea *area,
+                                                 GList *children,
+                                                 HildonPannableAreaRevealPolicy policy);
+void hildon_pannable_area_jump_to_children      (HildonPannableArea *area,
+                                                 GList *children,
+                                                 HildonPannableAreaRevealPolicy policy);
+void hildon_pannable_area_scroll_to_row        (HildonPannableArea *area,
+                                                 GtkTreeView *treeview,
+                                                 GtkTreePath *path);
 GtkWidget* hildon_pannable_get_child_widget_at  (HildonPannableArea *area,
                                                  gdouble x, gdouble y);
 GtkAdjustment* hildon_pannable_area_get_hadjustment (HildonPannableArea *area);
@@ -145,6 +200,27 @@ GtkAdjustment* hildon_pannable_area_get_vadjustment (HildonPannableArea *area);
 gboolean hildon_pannable_area_get_center_on_child_focus (HildonPannableArea *area);
 void hildon_pannable_area_set_center_on_child_focus (HildonPannableArea *area,
                                                      gboolean value);
+gboolean hildon_pannable_area_get_scrolling     (HildonPannableArea *area);
+gboolean hildon_pannable_area_widget_get_scrolling (GtkWidget *widget);
+void hildon_pannable_area_set_cache_content     (HildonPannableArea *area,
+                                                 gboolean cache_content);
+gboolean hildon_pannable_area_get_cache_content (HildonPannableArea *area);
+void hildon_pannable_area_link                  (HildonPannableArea *area,
+                                                 HildonPannableArea *other,
+                                                 GtkOrientation orientation);
+void hildon_pannable_area_unlink                (HildonPannableArea *area,
+                                                 GtkOrientation orientation);
+
+GType hildon_pannable_area_frame_stats_get_type (void) G_GNUC_CONST;
+HildonPannableAreaFrameStats *hildon_pannable_area_frame_stats_copy
+                                                (const HildonPannableAreaFrameStats *stats);
+void hildon_pannable_area_frame_stats_free      (HildonPannableAreaFrameStats *stats);
+void hildon_pannable_area_set_record_frame_stats (HildonPannableArea *area,
+                                                 gboolean record);
+gboolean hildon_pannable_area_get_record_frame_stats (HildonPannableArea *area);
+void hildon_pannable_area_get_frame_stats       (HildonPannableArea *area,
+                                                 HildonPannableAreaFrameStats *stats);
+void hildon_pannable_area_reset_frame_stats     (HildonPannableArea *area);
 
 G_END_DECLS
 
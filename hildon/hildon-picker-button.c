@@ -71,6 +71,9 @@
 #include "hildon-picker-button.h"
 #include "hildon-picker-button-private.h"
 #include "hildon-picker-dialog.h"
+#include "hildon-picker-dialog-private.h"
+#include "hildon-stock.h"
+#include "hildon-private.h"
 
 G_DEFINE_TYPE (HildonPickerButton, hildon_picker_button, HILDON_TYPE_BUTTON)
 
@@ -82,9 +85,15 @@ typedef struct _HildonPickerButtonPrivate HildonPickerButtonPrivate;
 struct _HildonPickerButtonPrivate
 {
   GtkWidget *selector;
-  GtkWidget *dialog;
+  HildonPickerButtonSelectorFunc selector_func;   /* creates the selector */
+  gpointer selector_data;
+  GDestroyNotify selector_destroy;
+  GtkWidget *dialog;                              /* only set while shown */
+  gulong dialog_response_id;
   gchar *done_button_text;
   guint disable_value_changed : 1;
+  guint dialog_is_shared : 1;
+  guint value_pending : 1;                        /* changed while the dialog was up */
 };
 
 /* Signals */
@@ -105,6 +114,12 @@ static guint picker_button_signals[LAST_SIGNAL] = { 0 };
 static gboolean
 _current_selector_empty                         (HildonPickerButton *button);
 
+static void
+hildon_picker_button_clear_selector_func        (HildonPickerButtonPrivate *priv);
+
+static void
+hildon_picker_button_release_dialog             (HildonPickerButton *button);
+
 static void
 hildon_picker_button_selector_selection_changed (HildonTouchSelector * selector,
                                                  gint column,
@@ -158,7 +173,16 @@ hildon_picker_button_finalize (GObject * object)
 
   priv = GET_PRIVATE (object);
 
+  hildon_picker_button_clear_selector_func (priv);
+  hildon_picker_button_release_dialog (HILDON_PICKER_BUTTON (object));
+
   if (priv->selector) {
+    GtkWidget *toplevel = gtk_widget_get_toplevel (priv->selector);
+
+    /* The selector may still be packed in a hidden shared dialog */
+    if (HILDON_IS_PICKER_DIALOG (toplevel))
+      hildon_picker_dialog_release_selector (HILDON_PICKER_DIALOG (toplevel),
+                                             HILDON_TOUCH_SELECTOR (priv->selector));
     g_signal_handlers_disconnect_by_func (priv->selector,
                                           hildon_picker_button_selector_selection_changed,
                                           object);
@@ -168,10 +192,6 @@ hildon_picker_button_finalize (GObject * object)
     g_object_unref (priv->selector);
     priv->selector = NULL;
   }
-  if (priv->dialog) {
-    gtk_widget_destroy (priv->dialog);
-    priv->dialog = NULL;
-  }
 
   if (priv->done_button_text) {
     g_free (priv->done_button_text);
@@ -216,15 +236,21 @@ static void
 _selection_changed (HildonPickerButton *button)
 {
   HildonPickerButtonPrivate *priv = GET_PRIVATE (button);
+  gchar *value;
 
-  if (!GTK_IS_WINDOW (priv->dialog) ||
-      !gtk_widget_get_visible (GTK_WIDGET (priv->dialog))) {
-    gchar *value = hildon_touch_selector_get_current_text (HILDON_TOUCH_SELECTOR (priv->selector));
-    if (value) {
-      hildon_button_set_value (HILDON_BUTTON (button), value);
-      g_free (value);
-      hildon_picker_button_value_changed (button);
-    }
+  /* The label is hidden behind the dialog, the value is only printed
+     once when it is answered */
+  if (GTK_IS_WINDOW (priv->dialog) &&
+      gtk_widget_get_visible (GTK_WIDGET (priv->dialog))) {
+    priv->value_pending = TRUE;
+    return;
+  }
+
+  value = hildon_touch_selector_get_current_text (HILDON_TOUCH_SELECTOR (priv->selector));
+  if (value) {
+    hildon_button_set_value (HILDON_BUTTON (button), value);
+    g_free (value);
+    hildon_picker_button_value_changed (button);
   }
 }
 
@@ -246,47 +272,129 @@ hildon_picker_button_on_dialog_response (GtkDialog *dialog,
     hildon_button_set_value (HILDON_BUTTON (button), value);
     g_free (value);
     hildon_picker_button_value_changed (button);
+  } else if (priv->value_pending) {
+    /* The selection is normally restored on cancel, only touch the
+       label if it didn't get back to what it shows */
+    value = hildon_touch_selector_get_current_text
+            (HILDON_TOUCH_SELECTOR (priv->selector));
+    if (value && g_strcmp0 (value, hildon_button_get_value (HILDON_BUTTON (button))) != 0) {
+      hildon_button_set_value (HILDON_BUTTON (button), value);
+      hildon_picker_button_value_changed (button);
+    }
+    g_free (value);
   }
 
-  gtk_widget_hide (GTK_WIDGET (dialog));
+  priv->value_pending = FALSE;
+
+  hildon_picker_button_release_dialog (button);
 }
 
+/* Hides the dialog @button brought up and gives it back: the shared
+ * dialog keeps the selector packed so reopening the same picker needs
+ * no reparenting, a private one is destroyed without the selector. */
 static void
-hildon_picker_button_clicked (GtkButton * button)
+hildon_picker_button_release_dialog             (HildonPickerButton *button)
 {
+  HildonPickerButtonPrivate *priv = GET_PRIVATE (button);
+  GtkWidget *dialog = priv->dialog;
+
+  if (dialog == NULL)
+    return;
+
+  priv->dialog = NULL;
+
+  if (priv->dialog_response_id) {
+    g_signal_handler_disconnect (dialog, priv->dialog_response_id);
+    priv->dialog_response_id = 0;
+  }
+
+  gtk_widget_hide (dialog);
+
+  if (priv->dialog_is_shared) {
+    gtk_window_set_transient_for (GTK_WINDOW (dialog), NULL);
+    g_object_unref (dialog);
+  } else {
+    if (priv->selector)
+      hildon_picker_dialog_release_selector (HILDON_PICKER_DIALOG (dialog),
+                                             HILDON_TOUCH_SELECTOR (priv->selector));
+    gtk_widget_destroy (dialog);
+  }
+}
+
+static GtkWidget *
+hildon_picker_button_acquire_dialog             (HildonPickerButton *button)
+{
+  HildonPickerButtonPrivate *priv = GET_PRIVATE (button);
+  HildonPickerDialog *dialog;
   GtkWidget *parent;
-  HildonPickerButtonPrivate *priv;
+  GtkWidget *toplevel;
 
-  priv = GET_PRIVATE (HILDON_PICKER_BUTTON (button));
+  priv->dialog = hildon_picker_dialog_get_shared (gtk_widget_get_screen (GTK_WIDGET (button)));
+  priv->dialog_is_shared = TRUE;
 
-  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (priv->selector));
+  if (gtk_widget_get_visible (priv->dialog)) {
+    /* Another picker is using the shared dialog */
+    priv->dialog = hildon_picker_dialog_new (NULL);
+    priv->dialog_is_shared = FALSE;
+    g_signal_connect (priv->dialog, "delete-event",
+                      G_CALLBACK (gtk_widget_hide_on_delete),
+                      NULL);
+  } else {
+    g_object_ref (priv->dialog);
+  }
 
-  /* Create the dialog if it doesn't exist already.  */
-  if (!priv->dialog) {
-    parent = gtk_widget_get_toplevel (GTK_WIDGET (button));
-    if (gtk_widget_is_toplevel (parent)) {
-      priv->dialog = hildon_picker_dialog_new (GTK_WINDOW (parent));
-    } else {
-      priv->dialog = hildon_picker_dialog_new (NULL);
-    }
+  dialog = HILDON_PICKER_DIALOG (priv->dialog);
 
-    hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (priv->dialog),
-                                       HILDON_TOUCH_SELECTOR (priv->selector));
-    if (priv->done_button_text) {
-      hildon_picker_dialog_set_done_label (HILDON_PICKER_DIALOG (priv->dialog),
-                                           priv->done_button_text);
-    }
+  if (hildon_picker_dialog_get_selector (dialog) != HILDON_TOUCH_SELECTOR (priv->selector)) {
+    /* Left behind in the shared dialog of another screen */
+    toplevel = gtk_widget_get_toplevel (priv->selector);
+    if (HILDON_IS_PICKER_DIALOG (toplevel))
+      hildon_picker_dialog_release_selector (HILDON_PICKER_DIALOG (toplevel),
+                                             HILDON_TOUCH_SELECTOR (priv->selector));
+
+    hildon_picker_dialog_set_selector (dialog, HILDON_TOUCH_SELECTOR (priv->selector));
+  }
 
-    gtk_window_set_modal (GTK_WINDOW (priv->dialog),
+  parent = gtk_widget_get_toplevel (GTK_WIDGET (button));
+  if (gtk_widget_is_toplevel (parent)) {
+    gtk_window_set_transient_for (GTK_WINDOW (dialog), GTK_WINDOW (parent));
+    gtk_window_set_modal (GTK_WINDOW (dialog),
                           gtk_window_get_modal (GTK_WINDOW (parent)));
-    gtk_window_set_title (GTK_WINDOW (priv->dialog),
-                          hildon_button_get_title (HILDON_BUTTON (button)));
-    g_signal_connect (priv->dialog, "response",
+  } else {
+    gtk_window_set_transient_for (GTK_WINDOW (dialog), NULL);
+    gtk_window_set_modal (GTK_WINDOW (dialog), FALSE);
+  }
+
+  hildon_picker_dialog_set_done_label (dialog, priv->done_button_text ?
+                                       priv->done_button_text : HILDON_STOCK_DONE);
+  gtk_window_set_title (GTK_WINDOW (dialog),
+                        hildon_button_get_title (HILDON_BUTTON (button)));
+
+  priv->dialog_response_id =
+    g_signal_connect (dialog, "response",
                       G_CALLBACK (hildon_picker_button_on_dialog_response),
                       button);
-    g_signal_connect (priv->dialog, "delete-event",
-                      G_CALLBACK (gtk_widget_hide_on_delete),
-                      NULL);
+
+  return priv->dialog;
+}
+
+static void
+hildon_picker_button_clicked (GtkButton * button)
+{
+  HildonPickerButtonPrivate *priv;
+
+  priv = GET_PRIVATE (HILDON_PICKER_BUTTON (button));
+
+  /* The selector of a lazy button is only built when first needed */
+  hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (priv->selector));
+
+  HILDON_WATCH_ENTER ("picker-dialog-open");
+
+  /* Borrow the shared dialog unless it is already up for this button */
+  if (!priv->dialog) {
+    hildon_picker_button_acquire_dialog (HILDON_PICKER_BUTTON (button));
   }
 
   if (_current_selector_empty (HILDON_PICKER_BUTTON (button))) {
@@ -294,6 +402,8 @@ hildon_picker_button_clicked (GtkButton * button)
   } {
     gtk_window_present (GTK_WINDOW (priv->dialog));
   }
+
+  HILDON_WATCH_LEAVE ("picker-dialog-open");
 }
 
 static void
@@ -368,7 +478,13 @@ hildon_picker_button_init (HildonPickerButton * self)
   priv = GET_PRIVATE (self);
 
   priv->dialog = NULL;
+  priv->dialog_response_id = 0;
+  priv->dialog_is_shared = FALSE;
+  priv->value_pending = FALSE;
   priv->selector = NULL;
+  priv->selector_func = NULL;
+  priv->selector_data = NULL;
+  priv->selector_destroy = NULL;
   priv->done_button_text = NULL;
   priv->disable_value_changed = FALSE;
 
@@ -453,6 +569,9 @@ hildon_picker_button_set_selector (HildonPickerButton * button,
 
   priv = GET_PRIVATE (button);
 
+  /* An explicit selector replaces the one that would be created */
+  hildon_picker_button_clear_selector_func (priv);
+
   if (priv->selector == (GtkWidget*) selector) {
       return;
   }
@@ -515,9 +634,101 @@ hildon_picker_button_get_selector (HildonPickerButton * button)
 
   priv = GET_PRIVATE (button);
 
+  if (priv->selector == NULL && priv->selector_func != NULL) {
+    HildonPickerButtonSelectorFunc func = priv->selector_func;
+    HildonTouchSelector *selector;
+    gchar *old_value;
+    const gchar *value;
+    gboolean disabled;
+
+    /* The function is only called once */
+    priv->selector_func = NULL;
+    selector = func (button, priv->selector_data);
+    hildon_picker_button_clear_selector_func (priv);
+
+    g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), NULL);
+
+    /* The initial value normally matches the selector, in which case
+       the value has not changed */
+    old_value = g_strdup (hildon_button_get_value (HILDON_BUTTON (button)));
+    disabled = priv->disable_value_changed;
+    priv->disable_value_changed = TRUE;
+    hildon_picker_button_set_selector (button, selector);
+    priv->disable_value_changed = disabled;
+
+    value = hildon_button_get_value (HILDON_BUTTON (button));
+    if (g_strcmp0 (old_value, value) != 0)
+      hildon_picker_button_value_changed (button);
+    g_free (old_value);
+  }
+
   return HILDON_TOUCH_SELECTOR (priv->selector);
 }
 
+static void
+hildon_picker_button_clear_selector_func        (HildonPickerButtonPrivate *priv)
+{
+  GDestroyNotify destroy = priv->selector_destroy;
+  gpointer data = priv->selector_data;
+
+  priv->selector_func = NULL;
+  priv->selector_data = NULL;
+  priv->selector_destroy = NULL;
+
+  if (destroy)
+    destroy (data);
+}
+
+/**
+ * hildon_picker_button_set_selector_func:
+ * @button: a #HildonPickerButton
+ * @func: a function that creates the #HildonTouchSelector of @button
+ * @data: user data for @func
+ * @destroy: destroy notifier for @data, or %NULL
+ * @value: the value shown by @button until the selector is created,
+ *         or %NULL
+ *
+ * Makes @button create its #HildonTouchSelector with @func the first
+ * time it is needed, normally when the user clicks @button, instead of
+ * having to create it upfront with hildon_picker_button_set_selector().
+ * This saves building the models and tree views of selectors that are
+ * rarely opened, as in screens with many picker buttons.
+ *
+ * @value is shown until then, and should be the current text of the
+ * selector that @func creates. Calling hildon_picker_button_get_selector()
+ * or any function using the selector creates it too.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_picker_button_set_selector_func          (HildonPickerButton             *button,
+                                                 HildonPickerButtonSelectorFunc  func,
+                                                 gpointer                        data,
+                                                 GDestroyNotify                  destroy,
+                                                 const gchar                    *value)
+{
+  HildonPickerButtonPrivate *priv;
+  gboolean disabled;
+
+  g_return_if_fail (HILDON_IS_PICKER_BUTTON (button));
+  g_return_if_fail (func != NULL);
+
+  priv = GET_PRIVATE (button);
+
+  /* Drops the current selector, and any pending function */
+  disabled = priv->disable_value_changed;
+  priv->disable_value_changed = TRUE;
+  hildon_picker_button_set_selector (button, NULL);
+  priv->disable_value_changed = disabled;
+
+  priv->selector_func = func;
+  priv->selector_data = data;
+  priv->selector_destroy = destroy;
+
+  hildon_button_set_value (HILDON_BUTTON (button), value ? value : "");
+  hildon_picker_button_value_changed (button);
+}
+
 /**
  * hildon_picker_button_get_active:
  * @button: a #HildonPickerButton
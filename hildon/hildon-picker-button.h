@@ -58,6 +58,20 @@ struct                                          _HildonPickerButtonClass
   HildonButtonClass parent_class;
 };
 
+/**
+ * HildonPickerButtonSelectorFunc:
+ * @button: the #HildonPickerButton
+ * @data: the user data given to hildon_picker_button_set_selector_func()
+ *
+ * Creates the #HildonTouchSelector of a #HildonPickerButton.
+ *
+ * Returns: a new #HildonTouchSelector
+ *
+ * Since: 3.0
+ */
+typedef HildonTouchSelector * (*HildonPickerButtonSelectorFunc) (HildonPickerButton *button,
+                                                                 gpointer            data);
+
 GType
 hildon_picker_button_get_type                   (void);
 
@@ -72,6 +86,13 @@ hildon_picker_button_set_selector               (HildonPickerButton * button,
 HildonTouchSelector*
 hildon_picker_button_get_selector               (HildonPickerButton *button);
 
+void
+hildon_picker_button_set_selector_func          (HildonPickerButton             *button,
+                                                 HildonPickerButtonSelectorFunc  func,
+                                                 gpointer                        data,
+                                                 GDestroyNotify                  destroy,
+                                                 const gchar                    *value);
+
 void
 hildon_picker_button_set_active                 (HildonPickerButton * button,
                                                  gint index);
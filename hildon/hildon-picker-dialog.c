@@ -51,7 +51,10 @@
 #include "hildon-touch-selector.h"
 #include "hildon-touch-selector-entry.h"
 #include "hildon-picker-dialog.h"
+#include "hildon-picker-dialog-private.h"
+#include "hildon-touch-selector-private.h"
 #include "hildon-stock.h"
+#include "hildon-private.h"
 
 #define HILDON_PICKER_DIALOG_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HILDON_TYPE_PICKER_DIALOG, HildonPickerDialogPrivate))
 
@@ -66,7 +69,7 @@ struct _HildonPickerDialogPrivate
   gulong signal_columns_changed_id;
 
   gboolean center_on_show;
-  GSList *current_selection;
+  HildonTouchSelectorSnapshot *current_selection;
   gchar *current_text;
 };
 
@@ -373,6 +376,13 @@ hildon_picker_dialog_get_preferred_height       (GtkWidget *widget,
   if (selector) {
     gint border;
     gint selector_minimum, selector_natural;
+    guint max_height;
+
+    /* Anything past the maximum height is not shown, so the selector
+       does not need to measure that far. Set before the content area
+       is measured, since that measures the selector too */
+    max_height = hildon_picker_dialog_get_max_height (HILDON_PICKER_DIALOG (widget));
+    hildon_touch_selector_set_height_limit (selector, max_height);
 
     gtk_widget_get_preferred_height (gtk_bin_get_child (GTK_BIN (widget)), minimum, natural);
 
@@ -384,7 +394,7 @@ hildon_picker_dialog_get_preferred_height       (GtkWidget *widget,
 
     *minimum = border + *minimum + selector_minimum;
 
-    *natural = MIN (hildon_picker_dialog_get_max_height (HILDON_PICKER_DIALOG (widget)),
+    *natural = MIN (max_height,
                     border + *natural + selector_natural - selector_minimum);
   } else
     GTK_WIDGET_CLASS (hildon_picker_dialog_parent_class)->get_preferred_height
@@ -411,11 +421,7 @@ hildon_picker_dialog_get_max_height             (HildonPickerDialog *dialog)
 
   screen = gtk_widget_get_screen (GTK_WIDGET (dialog));
   if (screen != NULL) {
-    if (gdk_screen_get_width (screen) > gdk_screen_get_height (screen)) {
-      landscape = TRUE;
-    } else {
-      landscape = FALSE;
-    }
+    landscape = !hildon_get_screen_geometry (screen)->portrait;
   }
 
   if (landscape) {
@@ -568,19 +574,11 @@ hildon_picker_dialog_get_done_label (HildonPickerDialog * dialog)
   return gtk_button_get_label (GTK_BUTTON (priv->button));
 }
 
-static void
-free_path_list (GList *list)
-{
-  g_list_foreach (list, (GFunc) gtk_tree_path_free, NULL);
-  g_list_free (list);
-}
-
 static void
 _clean_current_selection (HildonPickerDialog *dialog)
 {
   if (dialog->priv->current_selection) {
-    g_slist_foreach (dialog->priv->current_selection, (GFunc) free_path_list, NULL);
-    g_slist_free (dialog->priv->current_selection);
+    hildon_touch_selector_snapshot_free (dialog->priv->current_selection);
     dialog->priv->current_selection = NULL;
   }
   if (dialog->priv->current_text) {
@@ -593,18 +591,12 @@ static void
 _save_current_selection (HildonPickerDialog *dialog)
 {
   HildonTouchSelector *selector;
-  gint i, columns;
 
   selector = HILDON_TOUCH_SELECTOR (dialog->priv->selector);
 
   _clean_current_selection (dialog);
 
-  columns = hildon_touch_selector_get_num_columns (selector);
-  for (i = 0; i  < columns; i++) {
-    dialog->priv->current_selection
-      = g_slist_append (dialog->priv->current_selection,
-                        hildon_touch_selector_get_selected_rows (selector, i));
-  }
+  dialog->priv->current_selection = hildon_touch_selector_get_snapshot (selector);
   if (HILDON_IS_TOUCH_SELECTOR_ENTRY (selector)) {
 	  HildonEntry *entry = hildon_touch_selector_entry_get_entry (HILDON_TOUCH_SELECTOR_ENTRY (selector));
 	  dialog->priv->current_text = g_strdup (gtk_entry_get_text (GTK_ENTRY (entry)));
@@ -614,48 +606,28 @@ _save_current_selection (HildonPickerDialog *dialog)
 static void
 _restore_current_selection (HildonPickerDialog *dialog)
 {
-  GSList *current_selection, *iter;
-  GList *selected, *selected_iter;
-  GtkTreePath *current_path;
   HildonTouchSelector *selector;
-  GtkTreeModel *model;
-  GtkTreeIter tree_iter;
-  gint i;
 
   if (dialog->priv->current_selection == NULL)
     return;
 
-  current_selection = dialog->priv->current_selection;
   selector = HILDON_TOUCH_SELECTOR (dialog->priv->selector);
 
-  if (hildon_touch_selector_get_num_columns (selector) !=
-      g_slist_length (current_selection)) {
+  if (dialog->priv->signal_changed_id)
+    g_signal_handler_block (selector, dialog->priv->signal_changed_id);
+  hildon_touch_selector_freeze_changed (selector);
+  if (!hildon_touch_selector_apply_snapshot (selector, dialog->priv->current_selection)) {
     /* We conclude that if the current selection has the same
        numbers of columns that the selector, all this ok
        Anyway this shouldn't happen. */
     g_critical ("Trying to restore the selection on a selector after change"
                 " the number of columns. Are you removing columns while the"
                 " dialog is open?");
-    return;
-  }
-
-  if (dialog->priv->signal_changed_id)
-    g_signal_handler_block (selector, dialog->priv->signal_changed_id);
-  for (iter = current_selection, i = 0; iter; iter = g_slist_next (iter), i++) {
-    selected = (GList *) (iter->data);
-    model = hildon_touch_selector_get_model (selector, i);
-    if (selected)
-        hildon_touch_selector_unselect_all (selector, i);
-    for (selected_iter = selected; selected_iter; selected_iter = g_list_next (selected_iter)) {
-      current_path = (GtkTreePath *) selected_iter->data;
-      if (gtk_tree_model_get_iter (model, &tree_iter, current_path))
-          hildon_touch_selector_select_iter (selector, i, &tree_iter, FALSE);
-    }
-  }
-  if (HILDON_IS_TOUCH_SELECTOR_ENTRY (selector) && dialog->priv->current_text != NULL) {
+  } else if (HILDON_IS_TOUCH_SELECTOR_ENTRY (selector) && dialog->priv->current_text != NULL) {
     HildonEntry *entry = hildon_touch_selector_entry_get_entry (HILDON_TOUCH_SELECTOR_ENTRY (selector));
     gtk_entry_set_text (GTK_ENTRY (entry), dialog->priv->current_text);
   }
+  hildon_touch_selector_thaw_changed (selector);
   if (dialog->priv->signal_changed_id)
     g_signal_handler_unblock (selector, dialog->priv->signal_changed_id);
 }
@@ -683,8 +655,13 @@ setup_interaction_mode (HildonPickerDialog * dialog)
   if (dialog->priv->signal_changed_id) {
     g_signal_handler_disconnect (dialog->priv->selector,
                                  dialog->priv->signal_changed_id);
+    dialog->priv->signal_changed_id = 0;
   }
 
+  /* The shared dialog is realized before it gets a selector */
+  if (dialog->priv->selector == NULL)
+    return;
+
   if (requires_done_button (dialog) == FALSE) {
     dialog->priv->signal_changed_id =
       g_signal_connect (G_OBJECT (dialog->priv->selector), "changed",
@@ -719,6 +696,28 @@ hildon_picker_dialog_new (GtkWindow * parent)
 }
 
 
+static void
+_hildon_picker_dialog_remove_selector (HildonPickerDialog * dialog)
+{
+  if (dialog->priv->selector == NULL)
+    return;
+
+  if (dialog->priv->signal_changed_id) {
+    g_signal_handler_disconnect (dialog->priv->selector,
+                                 dialog->priv->signal_changed_id);
+    dialog->priv->signal_changed_id = 0;
+  }
+  if (dialog->priv->signal_columns_changed_id) {
+    g_signal_handler_disconnect (dialog->priv->selector,
+                                 dialog->priv->signal_columns_changed_id);
+    dialog->priv->signal_columns_changed_id = 0;
+  }
+
+  gtk_container_remove (GTK_CONTAINER (gtk_dialog_get_content_area (GTK_DIALOG (dialog))),
+                        dialog->priv->selector);
+  dialog->priv->selector = NULL;
+}
+
 static gboolean
 _hildon_picker_dialog_set_selector (HildonPickerDialog * dialog,
                                     HildonTouchSelector * selector)
@@ -726,14 +725,7 @@ _hildon_picker_dialog_set_selector (HildonPickerDialog * dialog,
   g_object_ref (selector);
 
   /* Remove the old selector, if any */
-  if (dialog->priv->selector != NULL) {
-    gtk_container_remove (GTK_CONTAINER (gtk_dialog_get_content_area (GTK_DIALOG (dialog))),
-                          dialog->priv->selector);
-    if (dialog->priv->signal_columns_changed_id) {
-            g_signal_handler_disconnect (dialog->priv->selector,
-                                         dialog->priv->signal_columns_changed_id);
-    }
-  }
+  _hildon_picker_dialog_remove_selector (dialog);
 
   dialog->priv->selector = GTK_WIDGET (selector);
 
@@ -794,3 +786,59 @@ hildon_picker_dialog_get_selector (HildonPickerDialog * dialog)
 
   return HILDON_TOUCH_SELECTOR (dialog->priv->selector);
 }
+
+static void
+_on_shared_dialog_destroy                       (GtkWidget *dialog,
+                                                 gpointer   data)
+{
+  g_object_steal_qdata (G_OBJECT (gtk_widget_get_screen (dialog)),
+                        GPOINTER_TO_UINT (data));
+}
+
+/* Returns the picker dialog shared by the picker buttons on @screen.
+ * It is created and realized on first use and only hidden between
+ * uses, so that bringing up a picker is a map and a selector swap
+ * rather than building a new toplevel each time. */
+GtkWidget G_GNUC_INTERNAL *
+hildon_picker_dialog_get_shared                 (GdkScreen *screen)
+{
+  static GQuark quark = 0;
+  GtkWidget *dialog;
+
+  g_return_val_if_fail (GDK_IS_SCREEN (screen), NULL);
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("hildon-picker-dialog-shared");
+
+  dialog = g_object_get_qdata (G_OBJECT (screen), quark);
+  if (dialog == NULL) {
+    dialog = hildon_picker_dialog_new (NULL);
+    gtk_window_set_screen (GTK_WINDOW (dialog), screen);
+    g_signal_connect (dialog, "delete-event",
+                      G_CALLBACK (gtk_widget_hide_on_delete), NULL);
+    g_signal_connect (dialog, "destroy",
+                      G_CALLBACK (_on_shared_dialog_destroy),
+                      GUINT_TO_POINTER (quark));
+    g_object_set_qdata_full (G_OBJECT (screen), quark, dialog,
+                             (GDestroyNotify) gtk_widget_destroy);
+    gtk_widget_realize (dialog);
+  }
+
+  return dialog;
+}
+
+/* Takes @selector out of @dialog if it is the one being shown, so
+ * that it can be packed somewhere else or released by its owner. */
+void G_GNUC_INTERNAL
+hildon_picker_dialog_release_selector           (HildonPickerDialog  *dialog,
+                                                 HildonTouchSelector *selector)
+{
+  g_return_if_fail (HILDON_IS_PICKER_DIALOG (dialog));
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+
+  if (dialog->priv->selector != GTK_WIDGET (selector))
+    return;
+
+  _clean_current_selection (dialog);
+  _hildon_picker_dialog_remove_selector (dialog);
+}
@@ -26,8 +26,28 @@
 #include                                        <config.h>
 #endif
 
+#include                                        <stdlib.h>
+#include                                        <string.h>
+#include                                        <locale.h>
+#include                                        <stdio.h>
+#include                                        <unistd.h>
+#include                                        <X11/Xlib-xcb.h>
+
 #include                                        "hildon-private.h"
 #include                                        "hildon-defines.h"
+#include                                        "hildon-touch-selector-string-store-private.h"
+#include                                        "hildon-touch-selector-virtual-model-private.h"
+
+static const gchar *hildon_atom_names[HILDON_N_ATOMS] = {
+    "_MB_CURRENT_APP_WINDOW",
+    "_MB_GRAB_TRANSFER",
+    "_NET_WM_CONTEXT_CUSTOM",
+    "_NET_WM_WINDOW_TYPE",
+    "_HILDON_WM_WINDOW_TYPE_APP_MENU",
+    "_HILDON_LOADING_SCREENSHOT",
+    "_HILDON_NOTIFICATION_TYPE",
+    "_HILDON_STACKABLE_WINDOW"
+};
 
 G_GNUC_INTERNAL GtkWidget *
 hildon_private_create_animation                 (gfloat       framerate,
@@ -47,21 +67,17 @@ hildon_private_create_animation                 (gfloat       framerate,
 
     for (i = 1; i <= nframes; i++) {
         GdkPixbuf *frame;
-        GError *error = NULL;
         gchar *icon_name = g_strdup_printf (template, i);
-        frame = gtk_icon_theme_load_icon (theme, icon_name,
-                                          HILDON_ICON_PIXEL_SIZE_STYLUS,
-                                          0, &error);
-
-        if (error) {
-            g_warning ("Icon theme lookup for icon `%s' failed: %s",
-                       icon_name, error->message);
-            g_error_free (error);
+        frame = hildon_load_icon (theme, icon_name,
+                                  HILDON_ICON_PIXEL_SIZE_STYLUS, 1);
+
+        if (frame == NULL) {
+            g_warning ("Icon theme lookup for icon `%s' failed", icon_name);
         } else {
             gdk_pixbuf_simple_anim_add_frame (anim, frame);
+            g_object_unref (frame);
         }
 
-        g_object_unref (frame);
         g_free (icon_name);
     }
 
@@ -71,6 +87,366 @@ hildon_private_create_animation                 (gfloat       framerate,
     return image;
 }
 
+/*
+ * Icon cache.
+ *
+ * Lists and grids show the same few icons in many rows or buttons.
+ * GtkIconTheme only keeps a handful of recently loaded icons, so
+ * the loaded pixbufs are kept here, shared by every widget, until the
+ * theme changes or the caches are purged. Icons that are missing
+ * from the theme are remembered too.
+ */
+typedef struct
+{
+    GtkIconTheme *theme;
+    gchar *name;
+    gint size;
+    gint scale;
+} HildonIconKey;
+
+static GHashTable *icon_cache = NULL;           /* HildonIconKey -> GdkPixbuf or NULL */
+
+static guint
+hildon_icon_key_hash                            (gconstpointer key)
+{
+    const HildonIconKey *k = key;
+
+    return g_str_hash (k->name) ^ g_direct_hash (k->theme) ^ (k->size << 8) ^ k->scale;
+}
+
+static gboolean
+hildon_icon_key_equal                           (gconstpointer a,
+                                                 gconstpointer b)
+{
+    const HildonIconKey *ka = a;
+    const HildonIconKey *kb = b;
+
+    return ka->theme == kb->theme && ka->size == kb->size &&
+        ka->scale == kb->scale && strcmp (ka->name, kb->name) == 0;
+}
+
+static void
+hildon_icon_key_free                            (gpointer key)
+{
+    HildonIconKey *k = key;
+
+    g_free (k->name);
+    g_slice_free (HildonIconKey, k);
+}
+
+static gboolean
+hildon_icon_key_has_theme                       (gpointer key,
+                                                 gpointer value,
+                                                 gpointer theme)
+{
+    return ((HildonIconKey *) key)->theme == theme;
+}
+
+static void
+hildon_icon_pixbuf_unref                        (gpointer pixbuf)
+{
+    if (pixbuf)
+        g_object_unref (pixbuf);
+}
+
+static void
+hildon_icon_theme_changed                       (GtkIconTheme *theme)
+{
+    g_hash_table_foreach_remove (icon_cache, hildon_icon_key_has_theme, theme);
+}
+
+static void
+hildon_icon_theme_finalized                     (gpointer  data,
+                                                 GObject  *where_the_theme_was)
+{
+    g_hash_table_foreach_remove (icon_cache, hildon_icon_key_has_theme,
+                                 where_the_theme_was);
+}
+
+static void
+hildon_icon_cache_purge                         (gpointer data)
+{
+    g_hash_table_remove_all (icon_cache);
+}
+
+/* Returns a new reference to @icon_name loaded from @theme at @size
+ * pixels times @scale, or %NULL if the theme doesn't have it. */
+G_GNUC_INTERNAL GdkPixbuf *
+hildon_load_icon                                (GtkIconTheme *theme,
+                                                 const gchar  *icon_name,
+                                                 gint          size,
+                                                 gint          scale)
+{
+    static GQuark watched_quark = 0;
+    HildonIconKey key = { theme, (gchar *) icon_name, size, scale };
+    HildonIconKey *new_key;
+    gpointer pixbuf;
+
+    g_return_val_if_fail (GTK_IS_ICON_THEME (theme), NULL);
+    g_return_val_if_fail (icon_name != NULL, NULL);
+
+    if (G_UNLIKELY (icon_cache == NULL)) {
+        icon_cache = g_hash_table_new_full (hildon_icon_key_hash, hildon_icon_key_equal,
+                                            hildon_icon_key_free, hildon_icon_pixbuf_unref);
+        hildon_add_purge_func (hildon_icon_cache_purge, NULL);
+        watched_quark = g_quark_from_static_string ("hildon-icon-cache-watched");
+    }
+
+    if (g_hash_table_lookup_extended (icon_cache, &key, NULL, &pixbuf)) {
+        HILDON_PERF (ICON_CACHE_HITS);
+        return pixbuf ? g_object_ref (pixbuf) : NULL;
+    }
+
+    HILDON_PERF (ICON_CACHE_MISSES);
+
+    if (!g_object_get_qdata (G_OBJECT (theme), watched_quark)) {
+        g_signal_connect (theme, "changed", G_CALLBACK (hildon_icon_theme_changed), NULL);
+        g_object_weak_ref (G_OBJECT (theme), hildon_icon_theme_finalized, NULL);
+        g_object_set_qdata (G_OBJECT (theme), watched_quark, GINT_TO_POINTER (TRUE));
+    }
+
+    pixbuf = gtk_icon_theme_load_icon_for_scale (theme, icon_name, size, scale, 0, NULL);
+
+    new_key = g_slice_new (HildonIconKey);
+    new_key->theme = theme;
+    new_key->name = g_strdup (icon_name);
+    new_key->size = size;
+    new_key->scale = scale;
+    g_hash_table_insert (icon_cache, new_key, pixbuf ? g_object_ref (pixbuf) : NULL);
+
+    return pixbuf;
+}
+
+/*
+ * Window property batching.
+ *
+ * Setting up a window changes several hildon-desktop properties back
+ * to back (markup, menu flag, hibernation, portrait flags...). They are
+ * collected here per window and set together from a high priority
+ * idle, or when the window is realized, so each property is sent once
+ * with its last value, and not at all if the server already has it.
+ * Only mapped windows batch: hildon-desktop reads the properties when
+ * the window is mapped, so a realized window that is not mapped yet
+ * gets them right away, and what is pending is sent before a mapped
+ * window is unmapped, so that it cannot be mapped again without it.
+ */
+typedef struct
+{
+    GdkAtom type;
+    gint format;
+    gint n_elements;
+    guchar *data;                               /* NULL to delete */
+} HildonWindowProperty;
+
+typedef struct
+{
+    GtkWindow *window;
+    GHashTable *pending;                        /* GdkAtom -> property */
+    GHashTable *current;                        /* What the server has */
+    guint flush_id;
+} HildonWindowProperties;
+
+static void
+hildon_window_property_free                     (gpointer data)
+{
+    HildonWindowProperty *prop = data;
+
+    g_free (prop->data);
+    g_slice_free (HildonWindowProperty, prop);
+}
+
+static gsize
+hildon_window_property_size                     (gint format,
+                                                 gint n_elements)
+{
+    /* Format 32 data is passed around as longs, like Xlib does */
+    return n_elements * (format == 32 ? sizeof (glong) : format / 8);
+}
+
+static gboolean
+hildon_window_property_equal                    (const HildonWindowProperty *a,
+                                                 const HildonWindowProperty *b)
+{
+    if (a->data == NULL || b->data == NULL)
+        return a->data == b->data;
+
+    return a->type == b->type &&
+        a->format == b->format &&
+        a->n_elements == b->n_elements &&
+        memcmp (a->data, b->data,
+                hildon_window_property_size (a->format, a->n_elements)) == 0;
+}
+
+static void
+hildon_window_properties_flush                  (HildonWindowProperties *props)
+{
+    GdkWindow *gdkwin = gtk_widget_get_window (GTK_WIDGET (props->window));
+    GHashTableIter iter;
+    gpointer atom, value;
+
+    if (props->flush_id) {
+        g_source_remove (props->flush_id);
+        props->flush_id = 0;
+    }
+
+    if (g_hash_table_size (props->pending) == 0)
+        return;
+
+    hildon_trace_begin ("window-properties");
+
+    g_hash_table_iter_init (&iter, props->pending);
+    while (g_hash_table_iter_next (&iter, &atom, &value)) {
+        HildonWindowProperty *prop = value;
+        HildonWindowProperty *cur = g_hash_table_lookup (props->current, atom);
+
+        g_hash_table_iter_steal (&iter);
+
+        if (cur != NULL && hildon_window_property_equal (cur, prop)) {
+            hildon_window_property_free (prop);
+            continue;
+        }
+
+        if (prop->data) {
+            gdk_property_change (gdkwin, atom, prop->type, prop->format,
+                                 GDK_PROP_MODE_REPLACE, prop->data, prop->n_elements);
+        } else {
+            gdk_property_delete (gdkwin, atom);
+        }
+
+        g_hash_table_replace (props->current, atom, prop);
+    }
+
+    hildon_trace_end ("window-properties");
+}
+
+static gboolean
+hildon_window_properties_flush_idle             (gpointer data)
+{
+    HildonWindowProperties *props = data;
+
+    props->flush_id = 0;
+
+    if (gtk_widget_get_realized (GTK_WIDGET (props->window)))
+        hildon_window_properties_flush (props);
+
+    return FALSE;
+}
+
+static void
+hildon_window_properties_realized               (GtkWidget              *widget,
+                                                 HildonWindowProperties *props)
+{
+    hildon_window_properties_flush (props);
+}
+
+static void
+hildon_window_properties_unrealized             (GtkWidget              *widget,
+                                                 HildonWindowProperties *props)
+{
+    GHashTableIter iter;
+    gpointer atom, value;
+
+    /* The properties go away with the X window, so send them again when
+     * a new one is created, unless they are changed before that */
+    g_hash_table_iter_init (&iter, props->current);
+    while (g_hash_table_iter_next (&iter, &atom, &value)) {
+        g_hash_table_iter_steal (&iter);
+        if (g_hash_table_lookup (props->pending, atom) == NULL)
+            g_hash_table_insert (props->pending, atom, value);
+        else
+            hildon_window_property_free (value);
+    }
+}
+
+static void
+hildon_window_properties_free                   (HildonWindowProperties *props)
+{
+    if (props->flush_id)
+        g_source_remove (props->flush_id);
+
+    g_hash_table_destroy (props->pending);
+    g_hash_table_destroy (props->current);
+    g_slice_free (HildonWindowProperties, props);
+}
+
+static HildonWindowProperties *
+hildon_window_properties_get                    (GtkWindow *window)
+{
+    static GQuark quark = 0;
+    HildonWindowProperties *props;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-window-properties");
+
+    props = g_object_get_qdata (G_OBJECT (window), quark);
+    if (props == NULL) {
+        props = g_slice_new0 (HildonWindowProperties);
+        props->window = window;
+        props->pending = g_hash_table_new_full (NULL, NULL, NULL, hildon_window_property_free);
+        props->current = g_hash_table_new_full (NULL, NULL, NULL, hildon_window_property_free);
+        g_object_set_qdata_full (G_OBJECT (window), quark, props,
+                                 (GDestroyNotify) hildon_window_properties_free);
+        g_signal_connect_after (window, "realize",
+                                G_CALLBACK (hildon_window_properties_realized), props);
+        g_signal_connect (window, "unrealize",
+                          G_CALLBACK (hildon_window_properties_unrealized), props);
+        g_signal_connect (window, "unmap",
+                          G_CALLBACK (hildon_window_properties_realized), props);
+    }
+
+    return props;
+}
+
+/*
+ * Sets @property on @window, or deletes it if @data is %NULL. On a
+ * mapped window the change is only sent to the server at the next
+ * flush, see above.
+ * Format 32 @data is an array of longs.
+ */
+G_GNUC_INTERNAL void
+hildon_gtk_window_queue_property                                  (GtkWindow     *window,
+                                                                   GdkAtom        property,
+                                                                   GdkAtom        type,
+                                                                   gint           format,
+                                                                   gconstpointer  data,
+                                                                   gint           n_elements)
+{
+    HildonWindowProperties *props;
+    HildonWindowProperty *prop;
+
+    g_return_if_fail (GTK_IS_WINDOW (window));
+    g_return_if_fail (format == 8 || format == 16 || format == 32);
+
+    props = hildon_window_properties_get (window);
+
+    prop = g_slice_new0 (HildonWindowProperty);
+    prop->type = type;
+    prop->format = format;
+    prop->n_elements = n_elements;
+    if (data) {
+        gsize size = hildon_window_property_size (format, n_elements);
+
+        prop->data = g_malloc (size);
+        memcpy (prop->data, data, size);
+    }
+
+    g_hash_table_replace (props->pending, property, prop);
+
+    if (!gtk_widget_get_realized (GTK_WIDGET (window)))
+        return;
+
+    /* The window manager must see the properties when the window is
+       mapped, which can happen before an idle runs */
+    if (!gtk_widget_get_mapped (GTK_WIDGET (window))) {
+        hildon_window_properties_flush (props);
+        return;
+    }
+
+    if (props->flush_id == 0)
+        props->flush_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                                     hildon_window_properties_flush_idle,
+                                                     props, NULL);
+}
 
 void
 hildon_gtk_window_set_clear_window_flag                           (GtkWindow   *window,
@@ -78,16 +454,11 @@ hildon_gtk_window_set_clear_window_flag                           (GtkWindow   *
                                                                    Atom         xatom,
                                                                    gboolean     flag)
 {
-    GdkWindow *gdkwin = gtk_widget_get_window (GTK_WIDGET (window))	;
     GdkAtom atom = gdk_atom_intern (atomname, FALSE);
+    glong set = 1;
 
-    if (flag) {
-        guint32 set = 1;
-        gdk_property_change (gdkwin, atom, gdk_x11_xatom_to_atom (xatom),
-                             32, GDK_PROP_MODE_REPLACE, (const guchar *) &set, 1);
-    } else {
-        gdk_property_delete (gdkwin, atom);
-    }
+    hildon_gtk_window_queue_property (window, atom, gdk_x11_xatom_to_atom (xatom),
+                                      32, flag ? &set : NULL, 1);
 }
 
 void
@@ -104,3 +475,1591 @@ hildon_gtk_window_set_flag                                        (GtkWindow
          g_signal_connect (window, "realize", G_CALLBACK (func), userdata);
      }
 }
+
+/*
+ * Returns the X atom @atom on @display. The whole table is interned with
+ * a single XInternAtoms() call the first time it's needed on a display,
+ * so that looking atoms up from event filters never goes to the server.
+ */
+G_GNUC_INTERNAL Atom
+hildon_get_xatom                                (GdkDisplay *display,
+                                                 HildonAtom  atom)
+{
+    static GQuark quark = 0;
+    Atom *atoms;
+
+    g_return_val_if_fail (GDK_IS_DISPLAY (display), None);
+    g_return_val_if_fail (atom < HILDON_N_ATOMS, None);
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-xatoms");
+
+    atoms = g_object_get_qdata (G_OBJECT (display), quark);
+
+    if (G_UNLIKELY (atoms == NULL))
+    {
+        atoms = g_new (Atom, HILDON_N_ATOMS);
+        XInternAtoms (GDK_DISPLAY_XDISPLAY (display),
+                      (char **) hildon_atom_names, HILDON_N_ATOMS,
+                      False, atoms);
+        g_object_set_qdata_full (G_OBJECT (display), quark, atoms, g_free);
+    }
+
+    return atoms[atom];
+}
+
+/*
+ * Asynchronous property queries.
+ *
+ * Requests are sent on the display's xcb connection and their cookies
+ * queued on a main loop source, which hands the replies over on a later
+ * dispatch instead of blocking on the server. X errors come back with the
+ * reply, so no gdk_error_trap_push()/pop() round-trip is needed either.
+ */
+typedef struct
+{
+    unsigned int              sequence;
+    GWeakRef                  owner;
+    HildonPropertyReplyFunc   func;
+    gpointer                  data;
+    gboolean                  done;
+    xcb_get_property_reply_t *reply;
+} HildonPropertyRequest;
+
+typedef struct
+{
+    GSource           source;
+    GPollFD           pollfd;
+    xcb_connection_t *connection;
+    GQueue            requests;
+} HildonPropertySource;
+
+/* Collects the replies that have arrived, in request order. Returns
+ * whether the oldest request has been answered. */
+static gboolean
+hildon_property_source_poll                     (HildonPropertySource *psource)
+{
+    GList *iter;
+
+    for (iter = psource->requests.head; iter; iter = iter->next)
+    {
+        HildonPropertyRequest *request = iter->data;
+        xcb_generic_error_t *error = NULL;
+        void *reply = NULL;
+
+        if (request->done)
+            continue;
+
+        if (!xcb_poll_for_reply (psource->connection, request->sequence,
+                                 &reply, &error))
+            break;
+
+        request->done = TRUE;
+        request->reply = reply;
+        free (error);
+    }
+
+    return psource->requests.head &&
+        ((HildonPropertyRequest *) psource->requests.head->data)->done;
+}
+
+static gboolean
+hildon_property_source_prepare                  (GSource *source,
+                                                 gint    *timeout)
+{
+    *timeout = -1;
+
+    return hildon_property_source_poll ((HildonPropertySource *) source);
+}
+
+static gboolean
+hildon_property_source_check                    (GSource *source)
+{
+    return hildon_property_source_poll ((HildonPropertySource *) source);
+}
+
+static gboolean
+hildon_property_source_dispatch                 (GSource     *source,
+                                                 GSourceFunc  callback,
+                                                 gpointer     user_data)
+{
+    HildonPropertySource *psource = (HildonPropertySource *) source;
+
+    while (psource->requests.head &&
+           ((HildonPropertyRequest *) psource->requests.head->data)->done)
+    {
+        HildonPropertyRequest *request = g_queue_pop_head (&psource->requests);
+        GObject *owner = g_weak_ref_get (&request->owner);
+
+        if (owner)
+        {
+            request->func (owner, request->reply, request->data);
+            g_object_unref (owner);
+        }
+
+        free (request->reply);
+        g_weak_ref_clear (&request->owner);
+        g_slice_free (HildonPropertyRequest, request);
+    }
+
+    return TRUE;
+}
+
+static GSourceFuncs hildon_property_source_funcs = {
+    hildon_property_source_prepare,
+    hildon_property_source_check,
+    hildon_property_source_dispatch,
+    NULL
+};
+
+static void
+hildon_property_source_destroy                  (gpointer data)
+{
+    GSource *source = data;
+
+    g_source_destroy (source);
+    g_source_unref (source);
+}
+
+G_GNUC_INTERNAL void
+hildon_get_property_async                       (GdkDisplay              *display,
+                                                 Window                   window,
+                                                 Atom                     property,
+                                                 Atom                     type,
+                                                 guint32                  length,
+                                                 GObject                 *owner,
+                                                 HildonPropertyReplyFunc  func,
+                                                 gpointer                 data)
+{
+    static GQuark quark = 0;
+    HildonPropertySource *psource;
+    HildonPropertyRequest *request;
+    xcb_get_property_cookie_t cookie;
+
+    g_return_if_fail (GDK_IS_DISPLAY (display));
+    g_return_if_fail (G_IS_OBJECT (owner));
+    g_return_if_fail (func != NULL);
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-property-source");
+
+    psource = g_object_get_qdata (G_OBJECT (display), quark);
+
+    if (G_UNLIKELY (psource == NULL))
+    {
+        GSource *source = g_source_new (&hildon_property_source_funcs,
+                                        sizeof (HildonPropertySource));
+
+        psource = (HildonPropertySource *) source;
+        psource->connection = XGetXCBConnection (GDK_DISPLAY_XDISPLAY (display));
+        psource->pollfd.fd = xcb_get_file_descriptor (psource->connection);
+        psource->pollfd.events = G_IO_IN | G_IO_HUP | G_IO_ERR;
+        g_queue_init (&psource->requests);
+
+        g_source_add_poll (source, &psource->pollfd);
+        g_source_set_priority (source, GDK_PRIORITY_EVENTS);
+        g_source_set_can_recurse (source, TRUE);
+        g_source_attach (source, NULL);
+
+        g_object_set_qdata_full (G_OBJECT (display), quark, psource,
+                                 hildon_property_source_destroy);
+    }
+
+    /* Xlib may have buffered requests that this one depends on */
+    XFlush (GDK_DISPLAY_XDISPLAY (display));
+
+    cookie = xcb_get_property (psource->connection, FALSE, window,
+                               property, type, 0, length);
+    xcb_flush (psource->connection);
+
+    request = g_slice_new0 (HildonPropertyRequest);
+    request->sequence = cookie.sequence;
+    g_weak_ref_init (&request->owner, owner);
+    request->func = func;
+    request->data = data;
+
+    g_queue_push_tail (&psource->requests, request);
+}
+
+typedef struct
+{
+    GtkWidget *widget;
+    Atom ready_atom;
+    HildonReadyFunc func;
+    HildonResyncFunc resync;
+    GList resync_link;
+} HildonReadyWatch;
+
+/* Watches waiting to resend their state, see hildon_queue_resync() */
+static GQueue resync_queue = G_QUEUE_INIT;
+static guint resync_id = 0;
+
+static GQuark
+hildon_ready_watch_quark                        (void)
+{
+    static GQuark quark = 0;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-ready-watch");
+
+    return quark;
+}
+
+static void
+hildon_ready_reply                              (GObject                  *owner,
+                                                 xcb_get_property_reply_t *reply,
+                                                 gpointer                  data)
+{
+    HildonReadyWatch *watch;
+    gboolean ready;
+
+    /* The window may have been unrealized while the reply was on its way */
+    watch = g_object_get_qdata (owner, hildon_ready_watch_quark ());
+    if (watch == NULL)
+        return;
+
+    /* The value of the property is not used, it is enough that it is set */
+    ready = (reply != NULL &&
+             reply->type == XA_ATOM &&
+             reply->format == 32 &&
+             reply->value_len == 1);
+
+    watch->func (watch->widget, ready);
+}
+
+static GdkFilterReturn
+hildon_ready_filter                             (GdkXEvent *xevent,
+                                                 GdkEvent  *event,
+                                                 gpointer   data)
+{
+    HildonReadyWatch *watch = data;
+    XAnyEvent *any = xevent;
+
+    if (any->type == PropertyNotify &&
+        ((XPropertyEvent *) xevent)->atom == watch->ready_atom)
+    {
+        GdkWindow *window = gtk_widget_get_window (watch->widget);
+
+        hildon_get_property_async (gdk_window_get_display (window),
+                                   GDK_WINDOW_XID (window),
+                                   watch->ready_atom, XA_ATOM, 32,
+                                   G_OBJECT (watch->widget),
+                                   hildon_ready_reply, NULL);
+    }
+
+    return GDK_FILTER_CONTINUE;
+}
+
+/* Tracks the property the compositing window manager sets on the window
+ * of a realized animation actor or remote texture once it is ready for
+ * its client messages. */
+G_GNUC_INTERNAL void
+hildon_watch_ready                              (GtkWidget       *widget,
+                                                 const gchar     *ready_atom_name,
+                                                 HildonReadyFunc  func)
+{
+    HildonReadyWatch *watch;
+    GdkWindow *window;
+
+    g_return_if_fail (gtk_widget_get_realized (widget));
+    g_return_if_fail (func != NULL);
+
+    hildon_unwatch_ready (widget);
+
+    window = gtk_widget_get_window (widget);
+
+    watch = g_slice_new (HildonReadyWatch);
+    watch->widget = widget;
+    watch->ready_atom = gdk_x11_get_xatom_by_name_for_display
+        (gdk_window_get_display (window), ready_atom_name);
+    watch->func = func;
+    watch->resync = NULL;
+    watch->resync_link.data = watch;
+    watch->resync_link.prev = watch->resync_link.next = NULL;
+
+    /* GDK only runs the filters of the window an event is for */
+    gdk_window_add_filter (window, hildon_ready_filter, watch);
+    g_object_set_qdata (G_OBJECT (widget), hildon_ready_watch_quark (), watch);
+}
+
+G_GNUC_INTERNAL void
+hildon_unwatch_ready                            (GtkWidget *widget)
+{
+    HildonReadyWatch *watch;
+
+    watch = g_object_get_qdata (G_OBJECT (widget), hildon_ready_watch_quark ());
+    if (watch == NULL)
+        return;
+
+    if (watch->resync != NULL)
+        g_queue_unlink (&resync_queue, &watch->resync_link);
+
+    gdk_window_remove_filter (gtk_widget_get_window (widget),
+                              hildon_ready_filter, watch);
+    g_object_set_qdata (G_OBJECT (widget), hildon_ready_watch_quark (), NULL);
+    g_slice_free (HildonReadyWatch, watch);
+}
+
+static gboolean
+hildon_resync_idle                              (gpointer data)
+{
+    GSList *displays = NULL;
+    GSList *l;
+    GList *link;
+
+    resync_id = 0;
+
+    while ((link = g_queue_pop_head_link (&resync_queue)) != NULL) {
+        HildonReadyWatch *watch = link->data;
+        HildonResyncFunc resync = watch->resync;
+        GdkDisplay *display = gtk_widget_get_display (watch->widget);
+
+        watch->resync = NULL;
+        if (!g_slist_find (displays, display))
+            displays = g_slist_prepend (displays, display);
+
+        resync (watch->widget);
+    }
+
+    /* Everything was resent without flushing in between */
+    for (l = displays; l != NULL; l = l->next)
+        gdk_display_flush (l->data);
+    g_slist_free (displays);
+
+    return FALSE;
+}
+
+/* A restarted window manager sets the ready property of every actor
+ * and texture again, and has lost all of their state. Instead of
+ * resending it from each ready notification, all of them are resent
+ * together from one idle, with a single flush of the X connection. */
+G_GNUC_INTERNAL void
+hildon_queue_resync                             (GtkWidget        *widget,
+                                                 HildonResyncFunc  func)
+{
+    HildonReadyWatch *watch;
+
+    g_return_if_fail (func != NULL);
+
+    watch = g_object_get_qdata (G_OBJECT (widget), hildon_ready_watch_quark ());
+    g_return_if_fail (watch != NULL);
+
+    if (watch->resync == NULL)
+        g_queue_push_tail_link (&resync_queue, &watch->resync_link);
+    watch->resync = func;
+
+    if (resync_id == 0)
+        resync_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                               hildon_resync_idle, NULL, NULL);
+}
+
+typedef struct
+{
+    GtkWidget *widget;
+    HildonScreenFunc func;
+} HildonScreenWatch;
+
+typedef struct
+{
+    HildonScreenGeometry geometry;
+    GQueue watches;
+    guint update_id;
+} HildonScreenWatcher;
+
+static GQuark
+hildon_screen_watch_quark                       (void)
+{
+    static GQuark quark = 0;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-screen-watch");
+
+    return quark;
+}
+
+static void
+hildon_screen_geometry_compute                  (GdkScreen            *screen,
+                                                 HildonScreenGeometry *geometry)
+{
+    geometry->width = gdk_screen_get_width (screen);
+    geometry->height = gdk_screen_get_height (screen);
+    geometry->portrait = geometry->width < geometry->height;
+}
+
+static gboolean
+hildon_screen_update                            (gpointer data)
+{
+    GdkScreen *screen = data;
+    HildonScreenWatcher *watcher;
+    HildonScreenGeometry geometry;
+    GList *watches, *l;
+
+    watcher = g_object_get_qdata (G_OBJECT (screen), hildon_screen_watch_quark ());
+    watcher->update_id = 0;
+
+    /* RandR usually sends several notifications for one rotation */
+    hildon_screen_geometry_compute (screen, &geometry);
+    if (geometry.width == watcher->geometry.width &&
+        geometry.height == watcher->geometry.height)
+        return FALSE;
+
+    watcher->geometry = geometry;
+
+    /* Subscribers may unwatch each other while they are notified */
+    watches = g_list_copy (watcher->watches.head);
+    for (l = watches; l != NULL; l = l->next) {
+        HildonScreenWatch *watch = l->data;
+
+        if (g_queue_find (&watcher->watches, watch))
+            watch->func (watch->widget, &watcher->geometry);
+    }
+    g_list_free (watches);
+
+    return FALSE;
+}
+
+static void
+hildon_screen_size_changed                      (GdkScreen           *screen,
+                                                 HildonScreenWatcher *watcher)
+{
+    /* Runs before GTK+ relayouts and redraws, so every subscriber has
+     * queued its resize by the time the new frame is laid out */
+    if (watcher->update_id == 0)
+        watcher->update_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                                        hildon_screen_update,
+                                                        screen, NULL);
+}
+
+static HildonScreenWatcher *
+hildon_screen_watcher_get                       (GdkScreen *screen)
+{
+    HildonScreenWatcher *watcher;
+
+    watcher = g_object_get_qdata (G_OBJECT (screen), hildon_screen_watch_quark ());
+    if (watcher == NULL) {
+        /* Screens are never finalized, so neither is the watcher */
+        watcher = g_slice_new0 (HildonScreenWatcher);
+        g_queue_init (&watcher->watches);
+        hildon_screen_geometry_compute (screen, &watcher->geometry);
+        g_signal_connect (screen, "size-changed",
+                          G_CALLBACK (hildon_screen_size_changed), watcher);
+        g_object_set_qdata (G_OBJECT (screen), hildon_screen_watch_quark (), watcher);
+    }
+
+    return watcher;
+}
+
+/* The geometry of @screen as last notified to the functions registered
+ * with hildon_watch_screen(), so that all widgets agree on it */
+G_GNUC_INTERNAL const HildonScreenGeometry *
+hildon_get_screen_geometry                      (GdkScreen *screen)
+{
+    g_return_val_if_fail (GDK_IS_SCREEN (screen), NULL);
+
+    return &hildon_screen_watcher_get (screen)->geometry;
+}
+
+/* Calls @func whenever the size of the screen of @widget changes. All
+ * the library's widgets share one "size-changed" handler per screen:
+ * the new geometry is computed once and the functions are called in
+ * the order they were registered, all in the same main loop iteration
+ * and before the next relayout. @widget must keep its screen until
+ * hildon_unwatch_screen() is called, which realize and unrealize
+ * guarantee. */
+G_GNUC_INTERNAL void
+hildon_watch_screen                             (GtkWidget        *widget,
+                                                 HildonScreenFunc  func)
+{
+    HildonScreenWatcher *watcher;
+    HildonScreenWatch *watch;
+
+    g_return_if_fail (GTK_IS_WIDGET (widget));
+    g_return_if_fail (func != NULL);
+
+    hildon_unwatch_screen (widget);
+
+    watcher = hildon_screen_watcher_get (gtk_widget_get_screen (widget));
+
+    watch = g_slice_new (HildonScreenWatch);
+    watch->widget = widget;
+    watch->func = func;
+
+    g_queue_push_tail (&watcher->watches, watch);
+    g_object_set_qdata (G_OBJECT (widget), hildon_screen_watch_quark (), watch);
+}
+
+G_GNUC_INTERNAL void
+hildon_unwatch_screen                           (GtkWidget *widget)
+{
+    HildonScreenWatcher *watcher;
+    HildonScreenWatch *watch;
+
+    watch = g_object_get_qdata (G_OBJECT (widget), hildon_screen_watch_quark ());
+    if (watch == NULL)
+        return;
+
+    watcher = hildon_screen_watcher_get (gtk_widget_get_screen (widget));
+    g_queue_remove (&watcher->watches, watch);
+    g_object_set_qdata (G_OBJECT (widget), hildon_screen_watch_quark (), NULL);
+    g_slice_free (HildonScreenWatch, watch);
+}
+
+typedef struct
+{
+    HildonPurgeFunc func;
+    gpointer data;
+} HildonPurgeWatch;
+
+static GSList *purge_watches = NULL;
+
+void
+hildon_add_purge_func                           (HildonPurgeFunc func,
+                                                 gpointer        data)
+{
+    HildonPurgeWatch *watch = g_slice_new (HildonPurgeWatch);
+
+    watch->func = func;
+    watch->data = data;
+    purge_watches = g_slist_prepend (purge_watches, watch);
+}
+
+void
+hildon_remove_purge_func                        (HildonPurgeFunc func,
+                                                 gpointer        data)
+{
+    GSList *iter;
+
+    for (iter = purge_watches; iter; iter = iter->next)
+    {
+        HildonPurgeWatch *watch = iter->data;
+
+        if (watch->func == func && watch->data == data)
+        {
+            purge_watches = g_slist_delete_link (purge_watches, iter);
+            g_slice_free (HildonPurgeWatch, watch);
+            break;
+        }
+    }
+}
+
+void
+hildon_purge_caches                             (void)
+{
+    GSList *watches, *iter;
+
+    /* Purge functions may remove themselves */
+    watches = g_slist_copy (purge_watches);
+    for (iter = watches; iter; iter = iter->next)
+    {
+        HildonPurgeWatch *watch = iter->data;
+
+        if (g_slist_find (purge_watches, watch))
+            watch->func (watch->data);
+    }
+    g_slist_free (watches);
+}
+
+/* Conversions whose output only depends on one field of the struct
+   tm. Each of their values is formatted once and reused */
+static const struct
+{
+    gchar conversion;
+    gint n_values;
+} time_conversions[] = {
+    { 'd', 31 }, { 'e', 31 },
+    { 'm', 12 }, { 'B', 12 }, { 'b', 12 }, { 'h', 12 },
+    { 'A', 7 },  { 'a', 7 },
+    { 'H', 24 }, { 'I', 24 },
+    { 'M', 60 },
+    { 'p', 2 }
+};
+
+#define                                         TIME_MAX_VALUES 60
+
+#define                                         TIME_PART_LITERAL -1
+
+#define                                         TIME_PART_STRFTIME -2
+
+typedef struct
+{
+    gint conversion;        /* index in time_conversions, or TIME_PART_* */
+    gchar *text;            /* the literal text or the strftime format */
+} HildonTimePart;
+
+static gchar *time_labels[G_N_ELEMENTS (time_conversions)][TIME_MAX_VALUES];
+
+static GHashTable *time_formats = NULL;
+
+static gchar *time_locale = NULL;
+
+static void
+hildon_time_parts_free                          (gpointer data)
+{
+    GArray *parts = data;
+    guint i;
+
+    for (i = 0; i < parts->len; i++)
+        g_free (g_array_index (parts, HildonTimePart, i).text);
+    g_array_free (parts, TRUE);
+}
+
+static void
+hildon_time_purge                               (gpointer data)
+{
+    guint i, j;
+
+    g_hash_table_remove_all (time_formats);
+    for (i = 0; i < G_N_ELEMENTS (time_conversions); i++)
+    {
+        for (j = 0; j < TIME_MAX_VALUES; j++)
+        {
+            g_free (time_labels[i][j]);
+            time_labels[i][j] = NULL;
+        }
+    }
+}
+
+/* Returns the value of @tm shown by the conversion @i, or -1 */
+static gint
+hildon_time_conversion_value                    (guint            i,
+                                                 const struct tm *tm)
+{
+    gint value;
+
+    switch (time_conversions[i].conversion)
+    {
+    case 'd': case 'e':
+        value = tm->tm_mday - 1;
+        break;
+    case 'm': case 'B': case 'b': case 'h':
+        value = tm->tm_mon;
+        break;
+    case 'A': case 'a':
+        value = tm->tm_wday;
+        break;
+    case 'H': case 'I':
+        value = tm->tm_hour;
+        break;
+    case 'M':
+        value = tm->tm_min;
+        break;
+    default:
+        value = tm->tm_hour >= 12 ? 1 : 0;
+        break;
+    }
+
+    return (value >= 0 && value < time_conversions[i].n_values) ? value : -1;
+}
+
+static const gchar *
+hildon_time_label                               (guint i,
+                                                 gint  value)
+{
+    if (time_labels[i][value] == NULL)
+    {
+        struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+        gchar format[3] = { '%', time_conversions[i].conversion, '\0' };
+        gchar label[255];
+
+        tm.tm_mday = 1;
+        switch (format[1])
+        {
+        case 'd': case 'e':
+            tm.tm_mday = value + 1;
+            break;
+        case 'm': case 'B': case 'b': case 'h':
+            tm.tm_mon = value;
+            break;
+        case 'A': case 'a':
+            tm.tm_wday = value;
+            break;
+        case 'H': case 'I':
+            tm.tm_hour = value;
+            break;
+        case 'M':
+            tm.tm_min = value;
+            break;
+        default:
+            tm.tm_hour = value * 12;
+            break;
+        }
+
+        if (strftime (label, sizeof (label), format, &tm) == 0)
+            label[0] = '\0';
+        time_labels[i][value] = g_strdup (label);
+    }
+
+    return time_labels[i][value];
+}
+
+static void
+hildon_time_parts_add                           (GArray      *parts,
+                                                 gint         conversion,
+                                                 const gchar *text,
+                                                 gsize        len)
+{
+    HildonTimePart part;
+
+    part.conversion = conversion;
+    part.text = g_strndup (text, len);
+    g_array_append_val (parts, part);
+}
+
+/* Splits @format in literal text and conversions */
+static GArray *
+hildon_time_parse                               (const gchar *format)
+{
+    GArray *parts = g_array_new (FALSE, FALSE, sizeof (HildonTimePart));
+    GString *literal = g_string_new (NULL);
+    const gchar *p = format;
+
+    while (*p)
+    {
+        const gchar *start;
+        guint i;
+
+        if (*p != '%')
+        {
+            g_string_append_c (literal, *p++);
+            continue;
+        }
+
+        if (p[1] == '%')
+        {
+            g_string_append_c (literal, '%');
+            p += 2;
+            continue;
+        }
+
+        if (literal->len > 0)
+        {
+            hildon_time_parts_add (parts, TIME_PART_LITERAL, literal->str, literal->len);
+            g_string_truncate (literal, 0);
+        }
+
+        /* Flags, field width and modifiers */
+        start = p++;
+        while (*p && strchr ("_-0^#", *p))
+            p++;
+        while (g_ascii_isdigit (*p))
+            p++;
+        if (*p == 'E' || *p == 'O')
+            p++;
+        if (*p)
+            p++;
+
+        for (i = 0; p - start == 2 && i < G_N_ELEMENTS (time_conversions); i++)
+        {
+            if (time_conversions[i].conversion == start[1])
+                break;
+        }
+
+        if (p - start == 2 && i < G_N_ELEMENTS (time_conversions))
+            hildon_time_parts_add (parts, i, NULL, 0);
+        else
+            hildon_time_parts_add (parts, TIME_PART_STRFTIME, start, p - start);
+    }
+
+    if (literal->len > 0)
+        hildon_time_parts_add (parts, TIME_PART_LITERAL, literal->str, literal->len);
+    g_string_free (literal, TRUE);
+
+    return parts;
+}
+
+/*
+ * Formats @tm like strftime() does with @format. The formats are
+ * parsed once, and the names of the days and months, the hours and
+ * the minutes are formatted once per locale, so composing a date or
+ * time label only concatenates cached strings.
+ */
+gchar *
+hildon_format_time                              (const gchar     *format,
+                                                 const struct tm *tm)
+{
+    const gchar *locale = setlocale (LC_TIME, NULL);
+    GString *result;
+    GArray *parts;
+    guint i;
+
+    if (G_UNLIKELY (time_formats == NULL))
+    {
+        time_formats = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, hildon_time_parts_free);
+        hildon_add_purge_func (hildon_time_purge, NULL);
+    }
+
+    /* The labels depend on the locale, which can change at runtime */
+    if (g_strcmp0 (locale, time_locale) != 0)
+    {
+        hildon_time_purge (NULL);
+        g_free (time_locale);
+        time_locale = g_strdup (locale);
+    }
+
+    parts = g_hash_table_lookup (time_formats, format);
+    if (parts == NULL)
+    {
+        parts = hildon_time_parse (format);
+        g_hash_table_insert (time_formats, g_strdup (format), parts);
+    }
+
+    result = g_string_sized_new (32);
+    for (i = 0; i < parts->len; i++)
+    {
+        HildonTimePart *part = &g_array_index (parts, HildonTimePart, i);
+        gint value = -1;
+
+        if (part->conversion >= 0)
+            value = hildon_time_conversion_value (part->conversion, tm);
+
+        if (part->conversion == TIME_PART_LITERAL)
+        {
+            g_string_append (result, part->text);
+        }
+        else if (value >= 0)
+        {
+            g_string_append (result, hildon_time_label (part->conversion, value));
+        }
+        else
+        {
+            gchar label[255];
+            gchar spec[3] = { '%', '\0', '\0' };
+            const gchar *text = part->text;
+
+            /* Out of range values are left to strftime() */
+            if (text == NULL)
+            {
+                spec[1] = time_conversions[part->conversion].conversion;
+                text = spec;
+            }
+            if (strftime (label, sizeof (label), text, tm) > 0)
+                g_string_append (result, label);
+        }
+    }
+
+    return g_string_free (result, FALSE);
+}
+
+/*
+ * Gets the string in @column of the row @iter of @model. The
+ * models of Hildon that keep their strings around hand out the string
+ * itself, and *@to_free is set to %NULL; for any other model the
+ * string is copied, and must be freed with g_free (*@to_free). Either
+ * way, the result is only valid until @model is used again.
+ */
+const gchar *
+hildon_tree_model_peek_string                   (GtkTreeModel *model,
+                                                 GtkTreeIter  *iter,
+                                                 gint          column,
+                                                 gchar       **to_free)
+{
+    *to_free = NULL;
+
+    if (column == 0 && HILDON_IS_TOUCH_SELECTOR_STRING_STORE (model))
+        return hildon_touch_selector_string_store_peek (HILDON_TOUCH_SELECTOR_STRING_STORE (model),
+                                                        iter);
+
+    if (column == 0 && HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL (model))
+        return hildon_touch_selector_virtual_model_peek (HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (model),
+                                                         iter);
+
+    gtk_tree_model_get (model, iter, column, to_free, -1);
+
+    return *to_free;
+}
+
+/*
+ * Returns how many milliseconds a debounced consumer should still wait,
+ * @delay after the last change but no longer than @max_wait (0 meaning
+ * no limit) after @first_change, the monotonic time of the first change
+ * of the burst. Returns 0 if it should act right away.
+ */
+guint
+hildon_settle_wait                              (gint64 first_change,
+                                                 guint  delay,
+                                                 guint  max_wait)
+{
+    gint64 elapsed;
+
+    if (max_wait == 0)
+        return delay;
+
+    elapsed = (g_get_monotonic_time () - first_change) / 1000;
+    if (elapsed >= max_wait)
+        return 0;
+
+    return MIN (delay, max_wait - elapsed);
+}
+
+/*
+ * Startup trace.
+ *
+ * When HILDON_STARTUP_TRACE is set, the first run of each startup
+ * phase (hildon_init, first window realization, first app menu...) is
+ * timed. If the variable is "log" every phase is logged as it ends,
+ * otherwise it names a file that gets the phases in the Chrome trace
+ * event format when the program exits.
+ */
+typedef struct
+{
+    const gchar *phase;
+    gint64 begin;
+    gint64 end;
+} HildonTracePhase;
+
+enum
+{
+    TRACE_UNKNOWN = -1,
+    TRACE_OFF,
+    TRACE_LOG,
+    TRACE_FILE
+};
+
+static gint trace_mode = TRACE_UNKNOWN;
+static gchar *trace_file = NULL;
+static GArray *trace_phases = NULL;
+static gint64 trace_start = 0;
+
+static void
+hildon_trace_dump                               (void)
+{
+    FILE *f;
+    guint i;
+    gboolean first = TRUE;
+
+    f = fopen (trace_file, "w");
+    if (f == NULL) {
+        g_warning ("Could not write the startup trace to %s", trace_file);
+        return;
+    }
+
+    fputs ("{\"traceEvents\":[", f);
+    for (i = 0; i < trace_phases->len; i++) {
+        HildonTracePhase *p = &g_array_index (trace_phases, HildonTracePhase, i);
+
+        if (p->end == 0)
+            continue;
+
+        fprintf (f, "%s\n{\"name\":\"%s\",\"cat\":\"hildon\",\"ph\":\"X\","
+                 "\"ts\":%lld,\"dur\":%lld,"
+                 "\"pid\":%d,\"tid\":1}",
+                 first ? "" : ",", p->phase,
+                 (long long) p->begin, (long long) (p->end - p->begin),
+                 (gint) getpid ());
+        first = FALSE;
+    }
+    fputs ("\n]}\n", f);
+
+    fclose (f);
+}
+
+static gboolean
+hildon_trace_enabled                            (void)
+{
+    if (G_UNLIKELY (trace_mode == TRACE_UNKNOWN)) {
+        const gchar *env = g_getenv ("HILDON_STARTUP_TRACE");
+
+        if (env == NULL || *env == '\0') {
+            trace_mode = TRACE_OFF;
+        } else {
+            trace_phases = g_array_new (FALSE, FALSE, sizeof (HildonTracePhase));
+            trace_start = g_get_monotonic_time ();
+            if (strcmp (env, "log") == 0) {
+                trace_mode = TRACE_LOG;
+            } else {
+                trace_mode = TRACE_FILE;
+                trace_file = g_strdup (env);
+                atexit (hildon_trace_dump);
+            }
+        }
+    }
+
+    return trace_mode != TRACE_OFF;
+}
+
+/* Starts timing @phase, a static string, unless it already ran */
+G_GNUC_INTERNAL void
+hildon_trace_begin                              (const gchar *phase)
+{
+    HildonTracePhase p;
+    guint i;
+
+    if (G_LIKELY (!hildon_trace_enabled ()))
+        return;
+
+    for (i = 0; i < trace_phases->len; i++)
+        if (strcmp (g_array_index (trace_phases, HildonTracePhase, i).phase, phase) == 0)
+            return;
+
+    p.phase = phase;
+    p.begin = g_get_monotonic_time ();
+    p.end = 0;
+    g_array_append_val (trace_phases, p);
+}
+
+G_GNUC_INTERNAL void
+hildon_trace_end                                (const gchar *phase)
+{
+    guint i;
+
+    if (G_LIKELY (!hildon_trace_enabled ()))
+        return;
+
+    for (i = 0; i < trace_phases->len; i++) {
+        HildonTracePhase *p = &g_array_index (trace_phases, HildonTracePhase, i);
+
+        if (p->end != 0 || strcmp (p->phase, phase) != 0)
+            continue;
+
+        p->end = g_get_monotonic_time ();
+        if (trace_mode == TRACE_LOG)
+            g_message ("startup trace: %s took %.3f ms, ended at %.3f ms", phase,
+                       (p->end - p->begin) / 1000.0, (p->end - trace_start) / 1000.0);
+        return;
+    }
+}
+
+/*
+ * Deferred work scheduler. Jobs that would otherwise be plain idles are
+ * run in the time left in a frame once it has been laid out and
+ * painted, so that they don't push the next frame past its deadline.
+ * The frame clock of the widget a job is queued for is watched for
+ * that. When no frames are being drawn the jobs are run from an idle,
+ * a few milliseconds at a time, so input is still handled in between.
+ *
+ * Jobs are run by priority, in the order they were queued. Like a
+ * GSourceFunc, a job returning TRUE is queued again, behind the other
+ * jobs of its priority.
+ */
+typedef struct
+{
+    guint id;
+    HildonJobPriority priority;
+    GSourceFunc func;
+    gpointer data;
+    GDestroyNotify notify;
+    guint delay_id;
+    gboolean running;
+    gboolean removed;
+} HildonJob;
+
+/* Time kept free at the end of a frame, in microseconds */
+#define HILDON_JOB_FRAME_MARGIN 2000
+
+/* Time given to the jobs by each idle run, when no frames are drawn */
+#define HILDON_JOB_IDLE_BUDGET 5000
+
+#define HILDON_JOB_DEFAULT_INTERVAL 16667
+
+static GQueue job_queues[HILDON_JOB_N_PRIORITIES];
+static GHashTable *jobs = NULL;
+static guint job_next_id = 1;
+static guint job_idle_id = 0;
+static gint64 job_last_paint = 0;
+static gint64 job_frame_interval = HILDON_JOB_DEFAULT_INTERVAL;
+
+static void
+hildon_job_free                                 (HildonJob *job)
+{
+    g_hash_table_remove (jobs, GUINT_TO_POINTER (job->id));
+    if (job->notify)
+        job->notify (job->data);
+    g_slice_free (HildonJob, job);
+}
+
+static gboolean
+hildon_job_pending                              (void)
+{
+    gint i;
+
+    for (i = 0; i < HILDON_JOB_N_PRIORITIES; i++)
+        if (!g_queue_is_empty (&job_queues[i]))
+            return TRUE;
+
+    return FALSE;
+}
+
+/* Runs the queued jobs until @deadline, a monotonic time, but always
+ * at least one. Returns whether some are left. */
+static gboolean
+hildon_job_run_until                            (gint64 deadline)
+{
+    gint i = 0;
+
+    while (i < HILDON_JOB_N_PRIORITIES) {
+        HildonJob *job = g_queue_pop_head (&job_queues[i]);
+        gboolean again;
+
+        if (job == NULL) {
+            i++;
+            continue;
+        }
+
+        job->running = TRUE;
+        again = job->func (job->data);
+        job->running = FALSE;
+
+        if (again && !job->removed)
+            g_queue_push_tail (&job_queues[job->priority], job);
+        else
+            hildon_job_free (job);
+
+        if (g_get_monotonic_time () >= deadline)
+            break;
+
+        /* A job may have queued one of higher priority */
+        i = 0;
+    }
+
+    return hildon_job_pending ();
+}
+
+static gboolean
+hildon_job_idle                                 (gpointer data);
+
+static void
+hildon_job_schedule                             (guint delay)
+{
+    if (job_idle_id != 0)
+        return;
+
+    if (delay > 0)
+        job_idle_id = gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT_IDLE, delay,
+                                                    hildon_job_idle, NULL, NULL);
+    else
+        job_idle_id = gdk_threads_add_idle (hildon_job_idle, NULL);
+}
+
+static gboolean
+hildon_job_idle                                 (gpointer data)
+{
+    gint64 now = g_get_monotonic_time ();
+    gint64 next_frame = job_last_paint + 2 * job_frame_interval;
+
+    job_idle_id = 0;
+
+    /* Frames are being drawn, leave the jobs to them unless they stop */
+    if (now < next_frame) {
+        hildon_job_schedule ((next_frame - now) / 1000 + 1);
+        return FALSE;
+    }
+
+    if (hildon_job_run_until (now + HILDON_JOB_IDLE_BUDGET))
+        hildon_job_schedule (0);
+
+    return FALSE;
+}
+
+static void
+hildon_job_after_paint                          (GdkFrameClock *clock,
+                                                 gpointer       data)
+{
+    gint64 frame_time = gdk_frame_clock_get_frame_time (clock);
+    gint64 interval = 0;
+
+    gdk_frame_clock_get_refresh_info (clock, frame_time, &interval, NULL);
+    if (interval <= 0)
+        interval = HILDON_JOB_DEFAULT_INTERVAL;
+
+    job_frame_interval = interval;
+    job_last_paint = g_get_monotonic_time ();
+
+    if (!hildon_job_pending ())
+        return;
+
+    if (!hildon_job_run_until (frame_time + interval - HILDON_JOB_FRAME_MARGIN))
+        return;
+
+    /* More work is left for the next frames, or for the idle */
+    hildon_job_schedule (0);
+}
+
+static void
+hildon_job_watch_widget                         (GtkWidget *widget)
+{
+    static GQuark quark = 0;
+    GdkFrameClock *clock;
+
+    if (widget == NULL || (clock = gtk_widget_get_frame_clock (widget)) == NULL)
+        return;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-job-watched");
+
+    if (g_object_get_qdata (G_OBJECT (clock), quark) != NULL)
+        return;
+
+    g_object_set_qdata (G_OBJECT (clock), quark, GINT_TO_POINTER (TRUE));
+    g_signal_connect (clock, "after-paint", G_CALLBACK (hildon_job_after_paint), NULL);
+}
+
+static gboolean
+hildon_job_delay_done                           (gpointer data)
+{
+    HildonJob *job = data;
+
+    job->delay_id = 0;
+    g_queue_push_tail (&job_queues[job->priority], job);
+    hildon_job_schedule (0);
+
+    return FALSE;
+}
+
+/*
+ * Queues @func to be called with @data in the spare time of a frame of
+ * @widget, or in an idle if @widget is %NULL or no frames are drawn. If
+ * @delay is not 0, the job is only queued after that many milliseconds.
+ * @notify is called on @data once the job is done or removed. Returns
+ * an id for hildon_job_remove(), never 0.
+ */
+G_GNUC_INTERNAL guint
+hildon_job_add                                  (GtkWidget         *widget,
+                                                 HildonJobPriority  priority,
+                                                 guint              delay,
+                                                 GSourceFunc        func,
+                                                 gpointer           data,
+                                                 GDestroyNotify     notify)
+{
+    HildonJob *job;
+
+    g_return_val_if_fail (func != NULL, 0);
+    g_return_val_if_fail (priority < HILDON_JOB_N_PRIORITIES, 0);
+
+    if (G_UNLIKELY (jobs == NULL))
+        jobs = g_hash_table_new (NULL, NULL);
+
+    job = g_slice_new0 (HildonJob);
+    job->id = job_next_id++;
+    if (G_UNLIKELY (job_next_id == 0))
+        job_next_id = 1;
+    job->priority = priority;
+    job->func = func;
+    job->data = data;
+    job->notify = notify;
+    g_hash_table_insert (jobs, GUINT_TO_POINTER (job->id), job);
+
+    hildon_job_watch_widget (widget);
+
+    if (delay > 0) {
+        job->delay_id = gdk_threads_add_timeout (delay, hildon_job_delay_done, job);
+    } else {
+        g_queue_push_tail (&job_queues[priority], job);
+        hildon_job_schedule (0);
+    }
+
+    return job->id;
+}
+
+/* Removes the job @id, which must not have been done yet. It can be
+ * called from the job itself. */
+G_GNUC_INTERNAL void
+hildon_job_remove                               (guint id)
+{
+    HildonJob *job;
+
+    g_return_if_fail (id != 0);
+
+    job = jobs ? g_hash_table_lookup (jobs, GUINT_TO_POINTER (id)) : NULL;
+    g_return_if_fail (job != NULL);
+
+    if (job->running) {
+        /* Freed once it returns */
+        job->removed = TRUE;
+        return;
+    }
+
+    if (job->delay_id != 0)
+        g_source_remove (job->delay_id);
+    else
+        g_queue_remove (&job_queues[job->priority], job);
+
+    hildon_job_free (job);
+}
+
+/*
+ * Compositor messages. The client messages of animation actors and
+ * remote textures are normally sent on the X connection of GDK. With
+ * HILDON_COMPOSITOR_THREAD set, they are instead sent by a thread with
+ * an X connection of its own, so that the main loop never blocks on a
+ * full X output buffer while animating.
+ *
+ * The messages sent during a main loop iteration are gathered by the
+ * main thread without locking, and handed to the thread as one batch,
+ * either by hildon_compositor_flush() or from a high priority idle.
+ * The window manager thus still gets each batch in one go. Messages
+ * that set a state of their window replace any message for the same
+ * state still waiting to be sent, so a thread falling behind catches up
+ * by sending only the latest state. The replacement takes the place of
+ * the newest message, so that it is not sent before messages that came
+ * after the one it replaces.
+ *
+ * Nothing orders the two X connections. GDK's is flushed before each
+ * batch is handed over, so the windows the batch refers to were at
+ * least written out first, but the X server may still process requests
+ * buffered on GDK's connection, like a window creation or map, after
+ * the messages of the thread, and messages sent on one connection can
+ * overtake those sent on the other. Actors and remote textures
+ * therefore send all the messages about a window with
+ * hildon_compositor_send_direct() until the window manager was told to
+ * show or hide it, so that it gets their whole first state in order
+ * and after the window itself, and only use the thread afterwards.
+ */
+typedef struct
+{
+    gint64  key;
+    guint32 window;
+    guint32 type;
+    guint32 data[5];
+    gint slot;
+    gboolean replaced;
+} HildonCompositorMessage;
+
+typedef enum
+{
+    COMPOSITOR_UNKNOWN,
+    COMPOSITOR_DIRECT,
+    COMPOSITOR_THREAD
+} HildonCompositorMode;
+
+static HildonCompositorMode compositor_mode = COMPOSITOR_UNKNOWN;
+static GdkDisplay *compositor_display = NULL;
+static xcb_connection_t *compositor_connection = NULL;
+static GPtrArray *compositor_batch = NULL;
+static guint compositor_handover_id = 0;
+
+/* Shared with the thread */
+static GMutex compositor_lock;
+static GCond compositor_cond;
+static GPtrArray *compositor_queue = NULL;
+static GHashTable *compositor_queued = NULL;
+
+static void
+hildon_compositor_message_free                  (gpointer data)
+{
+    g_slice_free (HildonCompositorMessage, data);
+}
+
+static gpointer
+hildon_compositor_thread                        (gpointer data)
+{
+    GPtrArray *sending = g_ptr_array_new_with_free_func (hildon_compositor_message_free);
+
+    for (;;) {
+        GPtrArray *swap;
+        xcb_generic_event_t *event;
+        guint i;
+
+        g_mutex_lock (&compositor_lock);
+        while (compositor_queue->len == 0)
+            g_cond_wait (&compositor_cond, &compositor_lock);
+        swap = compositor_queue;
+        compositor_queue = sending;
+        sending = swap;
+        g_hash_table_remove_all (compositor_queued);
+        g_mutex_unlock (&compositor_lock);
+
+        for (i = 0; i < sending->len; i++) {
+            HildonCompositorMessage *message = g_ptr_array_index (sending, i);
+            xcb_client_message_event_t client = { 0 };
+
+            if (message->replaced)
+                continue;
+
+            client.response_type = XCB_CLIENT_MESSAGE;
+            client.format = 32;
+            client.window = message->window;
+            client.type = message->type;
+            memcpy (client.data.data32, message->data, sizeof (message->data));
+
+            xcb_send_event (compositor_connection, TRUE, message->window,
+                            XCB_EVENT_MASK_STRUCTURE_NOTIFY, (const char *) &client);
+        }
+
+        g_ptr_array_set_size (sending, 0);
+        xcb_flush (compositor_connection);
+
+        /* Nothing is asked for, but the errors for windows destroyed
+         * meanwhile are queued as events */
+        while ((event = xcb_poll_for_event (compositor_connection)) != NULL)
+            free (event);
+    }
+
+    return NULL;
+}
+
+static gboolean
+hildon_compositor_start                         (GdkDisplay *display)
+{
+    const gchar *env = g_getenv ("HILDON_COMPOSITOR_THREAD");
+    GError *error = NULL;
+    GThread *thread;
+
+    if (env == NULL || *env == '\0')
+        return FALSE;
+
+    compositor_connection = xcb_connect (DisplayString (GDK_DISPLAY_XDISPLAY (display)), NULL);
+    if (xcb_connection_has_error (compositor_connection)) {
+        g_warning ("Could not open the compositor message connection");
+        xcb_disconnect (compositor_connection);
+        compositor_connection = NULL;
+        return FALSE;
+    }
+
+    compositor_queue = g_ptr_array_new_with_free_func (hildon_compositor_message_free);
+    compositor_queued = g_hash_table_new (g_int64_hash, g_int64_equal);
+
+    thread = g_thread_try_new ("hildon-compositor", hildon_compositor_thread, NULL, &error);
+    if (thread == NULL) {
+        g_warning ("Could not start the compositor message thread: %s", error->message);
+        g_error_free (error);
+        xcb_disconnect (compositor_connection);
+        compositor_connection = NULL;
+        return FALSE;
+    }
+    g_thread_unref (thread);
+
+    compositor_display = display;
+    compositor_batch = g_ptr_array_new ();
+
+    return TRUE;
+}
+
+static void
+hildon_compositor_handover                      (void)
+{
+    guint i;
+
+    if (compositor_handover_id != 0) {
+        g_source_remove (compositor_handover_id);
+        compositor_handover_id = 0;
+    }
+
+    if (compositor_batch->len == 0)
+        return;
+
+    /* Write out the windows the batch refers to before the thread can
+       send anything about them */
+    XFlush (GDK_DISPLAY_XDISPLAY (compositor_display));
+
+    g_mutex_lock (&compositor_lock);
+
+    for (i = 0; i < compositor_batch->len; i++) {
+        HildonCompositorMessage *message = g_ptr_array_index (compositor_batch, i);
+        HildonCompositorMessage *queued = NULL;
+
+        if (message->slot >= 0)
+            queued = g_hash_table_lookup (compositor_queued, &message->key);
+
+        /* Left in the queue for the thread to skip, removing it would
+           cost a move of all the messages after it */
+        if (queued)
+            queued->replaced = TRUE;
+
+        g_ptr_array_add (compositor_queue, message);
+        if (message->slot >= 0)
+            g_hash_table_replace (compositor_queued, &message->key, message);
+    }
+
+    g_cond_signal (&compositor_cond);
+    g_mutex_unlock (&compositor_lock);
+
+    g_ptr_array_set_size (compositor_batch, 0);
+}
+
+static gboolean
+hildon_compositor_handover_idle                 (gpointer data)
+{
+    compositor_handover_id = 0;
+    hildon_compositor_handover ();
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Sends a client message about the window of @widget to the window
+ * manager on the X connection of GDK, ordered with the requests made
+ * through GDK so far */
+G_GNUC_INTERNAL void
+hildon_compositor_send_direct                   (GtkWidget *widget,
+                                                 guint32    message_type,
+                                                 guint32    l0,
+                                                 guint32    l1,
+                                                 guint32    l2,
+                                                 guint32    l3,
+                                                 guint32    l4)
+{
+    GdkWindow *window = gtk_widget_get_window (widget);
+    XEvent event = { 0 };
+
+    event.xclient.type = ClientMessage;
+    event.xclient.window = GDK_WINDOW_XID (window);
+    event.xclient.message_type = (Atom) message_type;
+    event.xclient.format = 32;
+    event.xclient.data.l[0] = l0;
+    event.xclient.data.l[1] = l1;
+    event.xclient.data.l[2] = l2;
+    event.xclient.data.l[3] = l3;
+    event.xclient.data.l[4] = l4;
+
+    XSendEvent (GDK_WINDOW_XDISPLAY (window), GDK_WINDOW_XID (window), True,
+                StructureNotifyMask, &event);
+}
+
+/* Sends a client message about the window of @widget to the window
+ * manager. Messages that set a state, which a later message for the
+ * same state entirely replaces, give the @slot of that state; others
+ * pass -1. The slot, not @message_type, tells the states apart, as
+ * some messages, like rotations, set a different one for each value
+ * of their first argument. */
+G_GNUC_INTERNAL void
+hildon_compositor_send                          (GtkWidget *widget,
+                                                 guint32    message_type,
+                                                 gint       slot,
+                                                 guint32    l0,
+                                                 guint32    l1,
+                                                 guint32    l2,
+                                                 guint32    l3,
+                                                 guint32    l4)
+{
+    GdkWindow *window = gtk_widget_get_window (widget);
+    GdkDisplay *display = gdk_window_get_display (window);
+    HildonCompositorMessage *message;
+
+    if (G_UNLIKELY (compositor_mode == COMPOSITOR_UNKNOWN))
+        compositor_mode = hildon_compositor_start (display) ?
+            COMPOSITOR_THREAD : COMPOSITOR_DIRECT;
+
+    if (compositor_mode == COMPOSITOR_DIRECT || display != compositor_display) {
+        hildon_compositor_send_direct (widget, message_type, l0, l1, l2, l3, l4);
+        return;
+    }
+
+    message = g_slice_new (HildonCompositorMessage);
+    message->window = GDK_WINDOW_XID (window);
+    message->type = message_type;
+    message->key = ((gint64) message->window << 32) | (guint32) slot;
+    message->data[0] = l0;
+    message->data[1] = l1;
+    message->data[2] = l2;
+    message->data[3] = l3;
+    message->data[4] = l4;
+    message->slot = slot;
+    message->replaced = FALSE;
+
+    g_ptr_array_add (compositor_batch, message);
+
+    if (compositor_handover_id == 0)
+        compositor_handover_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                                            hildon_compositor_handover_idle,
+                                                            NULL, NULL);
+}
+
+/* Pushes out the messages sent with hildon_compositor_send() so far */
+G_GNUC_INTERNAL void
+hildon_compositor_flush                         (GdkDisplay *display)
+{
+    if (compositor_mode == COMPOSITOR_THREAD && display == compositor_display)
+        hildon_compositor_handover ();
+    else
+        XFlush (GDK_DISPLAY_XDISPLAY (display));
+}
@@ -25,23 +25,264 @@
 #ifndef                                         __HILDON_PRIVATE_H__
 #define                                         __HILDON_PRIVATE_H__
 
+#include                                        <time.h>
 #include                                        <gtk/gtk.h>
 #include <X11/Xatom.h>
 #include <gdk/gdkx.h>
+#include <xcb/xcb.h>
 
 G_BEGIN_DECLS
 
+/* Heights of the finger and thumb sizes of #HildonSizeType */
+#define                                         HILDON_HEIGHT_FINGER 70
+
+#define                                         HILDON_HEIGHT_THUMB 105
+
 G_GNUC_INTERNAL GtkWidget *
 hildon_private_create_animation                 (gfloat       framerate,
                                                  const gchar *template,
                                                  gint         nframes);
 
+G_GNUC_INTERNAL void
+hildon_gtk_window_queue_property                                  (GtkWindow     *window,
+                                                                   GdkAtom        property,
+                                                                   GdkAtom        type,
+                                                                   gint           format,
+                                                                   gconstpointer  data,
+                                                                   gint           n_elements);
+
 G_GNUC_INTERNAL void
 hildon_gtk_window_set_clear_window_flag                           (GtkWindow   *window,
                                                                    const gchar *atomname,
                                                                    Atom         xatom,
                                                                    gboolean     flag);
 
+/* X atoms used by the library. They are interned together, with a
+ * single round-trip, the first time one of them is needed on a display;
+ * see hildon_get_xatom(). Keep in sync with the names in hildon-private.c */
+typedef enum
+{
+    HILDON_ATOM_MB_CURRENT_APP_WINDOW,
+    HILDON_ATOM_MB_GRAB_TRANSFER,
+    HILDON_ATOM_NET_WM_CONTEXT_CUSTOM,
+    HILDON_ATOM_NET_WM_WINDOW_TYPE,
+    HILDON_ATOM_HILDON_WM_WINDOW_TYPE_APP_MENU,
+    HILDON_ATOM_HILDON_LOADING_SCREENSHOT,
+    HILDON_ATOM_HILDON_NOTIFICATION_TYPE,
+    HILDON_ATOM_HILDON_STACKABLE_WINDOW,
+    HILDON_N_ATOMS
+} HildonAtom;
+
+G_GNUC_INTERNAL Atom
+hildon_get_xatom                                (GdkDisplay *display,
+                                                 HildonAtom  atom);
+
+/* Called with the reply to hildon_get_property_async(), or %NULL if the
+ * request failed (e.g. the window doesn't exist anymore). The reply is
+ * freed after the callback returns. */
+typedef void (*HildonPropertyReplyFunc)         (GObject                  *owner,
+                                                 xcb_get_property_reply_t *reply,
+                                                 gpointer                  data);
+
+G_GNUC_INTERNAL void
+hildon_get_property_async                       (GdkDisplay              *display,
+                                                 Window                   window,
+                                                 Atom                     property,
+                                                 Atom                     type,
+                                                 guint32                  length,
+                                                 GObject                 *owner,
+                                                 HildonPropertyReplyFunc  func,
+                                                 gpointer                 data);
+
+/* Called when the reply to a query of the ready property of @widget
+ * arrives; @ready tells whether the window manager has set it */
+typedef void (*HildonReadyFunc)                 (GtkWidget *widget,
+                                                 gboolean   ready);
+
+G_GNUC_INTERNAL void
+hildon_watch_ready                              (GtkWidget       *widget,
+                                                 const gchar     *ready_atom_name,
+                                                 HildonReadyFunc  func);
+
+G_GNUC_INTERNAL void
+hildon_unwatch_ready                            (GtkWidget *widget);
+
+/* Resends the whole state of @widget after the window manager restarted */
+typedef void (*HildonResyncFunc)                (GtkWidget *widget);
+
+G_GNUC_INTERNAL void
+hildon_queue_resync                             (GtkWidget        *widget,
+                                                 HildonResyncFunc  func);
+
+typedef struct
+{
+    gint width;
+    gint height;
+    gboolean portrait;
+} HildonScreenGeometry;
+
+typedef void (*HildonScreenFunc)                (GtkWidget                  *widget,
+                                                 const HildonScreenGeometry *geometry);
+
+G_GNUC_INTERNAL const HildonScreenGeometry *
+hildon_get_screen_geometry                      (GdkScreen *screen);
+
+G_GNUC_INTERNAL void
+hildon_watch_screen                             (GtkWidget        *widget,
+                                                 HildonScreenFunc  func);
+
+G_GNUC_INTERNAL void
+hildon_unwatch_screen                           (GtkWidget *widget);
+
+/* Called to drop memory that can be recreated on demand, see
+ * hildon_program_purge_caches() */
+typedef void (*HildonPurgeFunc)                 (gpointer data);
+
+G_GNUC_INTERNAL void
+hildon_add_purge_func                           (HildonPurgeFunc func,
+                                                 gpointer        data);
+
+G_GNUC_INTERNAL void
+hildon_remove_purge_func                        (HildonPurgeFunc func,
+                                                 gpointer        data);
+
+G_GNUC_INTERNAL void
+hildon_purge_caches                             (void);
+
+G_GNUC_INTERNAL void
+hildon_note_cache_sounds                        (void);
+
+G_GNUC_INTERNAL GdkPixbuf *
+hildon_load_icon                                (GtkIconTheme *theme,
+                                                 const gchar  *icon_name,
+                                                 gint          size,
+                                                 gint          scale);
+
+G_GNUC_INTERNAL gchar *
+hildon_format_time                              (const gchar     *format,
+                                                 const struct tm *tm);
+
+G_GNUC_INTERNAL const gchar *
+hildon_tree_model_peek_string                   (GtkTreeModel *model,
+                                                 GtkTreeIter  *iter,
+                                                 gint          column,
+                                                 gchar       **to_free);
+
+G_GNUC_INTERNAL guint
+hildon_settle_wait                              (gint64 first_change,
+                                                 guint  delay,
+                                                 guint  max_wait);
+
+G_GNUC_INTERNAL void
+hildon_trace_begin                              (const gchar *phase);
+
+G_GNUC_INTERNAL void
+hildon_trace_end                                (const gchar *phase);
+
+/* See hildon-live-search.c */
+G_GNUC_INTERNAL gboolean
+hildon_live_search_is_announcing                (GtkTreeModel *model);
+
+/* Client messages to the window manager, sent from a thread of their own
+ * with HILDON_COMPOSITOR_THREAD. See hildon-private.c */
+G_GNUC_INTERNAL void
+hildon_compositor_send                          (GtkWidget *widget,
+                                                 guint32    message_type,
+                                                 gint       slot,
+                                                 guint32    l0,
+                                                 guint32    l1,
+                                                 guint32    l2,
+                                                 guint32    l3,
+                                                 guint32    l4);
+
+G_GNUC_INTERNAL void
+hildon_compositor_send_direct                   (GtkWidget *widget,
+                                                 guint32    message_type,
+                                                 guint32    l0,
+                                                 guint32    l1,
+                                                 guint32    l2,
+                                                 guint32    l3,
+                                                 guint32    l4);
+
+G_GNUC_INTERNAL void
+hildon_compositor_flush                         (GdkDisplay *display);
+
+/* Counters read by hildon_debug_get_counters(). Keep in sync with the
+ * names in hildon-main.c */
+typedef enum
+{
+    HILDON_PERF_LIVE_SEARCH_REFILTERS,
+    HILDON_PERF_LIVE_SEARCH_ROW_VISITS,
+    HILDON_PERF_TOUCH_SELECTOR_CHANGED,
+    HILDON_PERF_REMOTE_TEXTURE_MESSAGES,
+    HILDON_PERF_ANIMATION_ACTOR_MESSAGES,
+    HILDON_PERF_X_ROUND_TRIPS,
+    HILDON_PERF_APP_MENU_REPACKS,
+    HILDON_PERF_ICON_CACHE_HITS,
+    HILDON_PERF_ICON_CACHE_MISSES,
+    HILDON_PERF_N_COUNTERS
+} HildonPerfCounter;
+
+#ifdef HILDON_ENABLE_PERF_COUNTERS
+G_GNUC_INTERNAL extern gint hildon_perf_counters[HILDON_PERF_N_COUNTERS];
+
+#define HILDON_PERF(counter) \
+    g_atomic_int_inc (&hildon_perf_counters[HILDON_PERF_##counter])
+#else
+#define HILDON_PERF(counter) G_STMT_START { } G_STMT_END
+#endif
+
+/* Main loop stall watchdog, enabled with HILDON_STALL_WATCHDOG. The
+ * entry points that can take long are marked, so that a stall is
+ * logged with the ones that ran during it. @what is a static string. */
+G_GNUC_INTERNAL extern gboolean hildon_watchdog_active;
+
+G_GNUC_INTERNAL void
+hildon_watchdog_enter                           (const gchar *what);
+
+G_GNUC_INTERNAL void
+hildon_watchdog_leave                           (const gchar *what);
+
+#define HILDON_WATCH_ENTER(what) G_STMT_START { \
+    if (G_UNLIKELY (hildon_watchdog_active)) hildon_watchdog_enter (what); } G_STMT_END
+#define HILDON_WATCH_LEAVE(what) G_STMT_START { \
+    if (G_UNLIKELY (hildon_watchdog_active)) hildon_watchdog_leave (what); } G_STMT_END
+
+/* Static trace points for systemtap, perf and bpftrace. They are nops
+ * (cost nothing when nothing is attached) and are listed with e.g.
+ * "perf list sdt_hildon:*" */
+#ifdef HILDON_ENABLE_SDT
+#include <sys/sdt.h>
+
+#define HILDON_PROBE(name)              DTRACE_PROBE (hildon, name)
+#define HILDON_PROBE1(name, a)          DTRACE_PROBE1 (hildon, name, a)
+#define HILDON_PROBE2(name, a, b)       DTRACE_PROBE2 (hildon, name, a, b)
+#else
+#define HILDON_PROBE(name)              G_STMT_START { } G_STMT_END
+#define HILDON_PROBE1(name, a)          G_STMT_START { } G_STMT_END
+#define HILDON_PROBE2(name, a, b)       G_STMT_START { } G_STMT_END
+#endif
+
+/* Deferred work, run in the spare time of frames. See hildon-private.c */
+typedef enum
+{
+    HILDON_JOB_PRIORITY_HIGH,
+    HILDON_JOB_PRIORITY_DEFAULT,
+    HILDON_JOB_PRIORITY_LOW,
+    HILDON_JOB_N_PRIORITIES
+} HildonJobPriority;
+
+G_GNUC_INTERNAL guint
+hildon_job_add                                  (GtkWidget         *widget,
+                                                 HildonJobPriority  priority,
+                                                 guint              delay,
+                                                 GSourceFunc        func,
+                                                 gpointer           data,
+                                                 GDestroyNotify     notify);
+
+G_GNUC_INTERNAL void
+hildon_job_remove                               (guint id);
+
 typedef void (*HildonFlagFunc) (GtkWindow *window, gpointer userdata);
 
 G_GNUC_INTERNAL void
@@ -45,6 +45,12 @@ struct                                          _HildonProgramPrivate
     HildonAppMenu *common_app_menu;
     GtkWidget *common_toolbar;
     GSList *windows;
+    gboolean common_menu_flag;
+    HildonWindow *menu_flag_window; /* Last topmost window whose menu flag was updated */
+    GHashTable *window_ids;         /* realized window -> HildonProgramWindowIds */
+    GHashTable *xid_windows;        /* XID -> window, for the realized windows */
+    GHashTable *group_counts;       /* group XID -> number of windows in the group */
+    HildonWindow *topmost_window;   /* the window that is topmost, if any */
 };
 
 G_END_DECLS
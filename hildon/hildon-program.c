@@ -87,7 +87,11 @@
 #include                                        "hildon-program-private.h"
 #include                                        "hildon-window-private.h"
 #include                                        "hildon-window-stack.h"
+#include                                        "hildon-pannable-area.h"
+#include                                        "hildon-picker-button.h"
+#include                                        "hildon-live-search.h"
 #include                                        "hildon-app-menu-private.h"
+#include                                        "hildon-private.h"
 
 static void
 hildon_program_init                             (HildonProgram *self);
@@ -116,6 +120,14 @@ enum
     PROP_KILLABLE
 };
 
+enum
+{
+    PURGE_CACHES,
+    LAST_SIGNAL
+};
+
+static guint                                    signals[LAST_SIGNAL] = { 0 };
+
 GType G_GNUC_CONST
 hildon_program_get_type                         (void)
 {
@@ -141,6 +153,19 @@ hildon_program_get_type                         (void)
     return program_type;
 }
 
+/* The X ids of a realized window, as they were when it was realized */
+typedef struct
+{
+    Window xid;
+    Window group;
+} HildonProgramWindowIds;
+
+static void
+hildon_program_window_ids_free                  (gpointer data)
+{
+    g_slice_free (HildonProgramWindowIds, data);
+}
+
 static void
 hildon_program_init                             (HildonProgram *self)
 {
@@ -154,6 +179,13 @@ hildon_program_init                             (HildonProgram *self)
     priv->common_app_menu = NULL;
     priv->common_toolbar = NULL;
     priv->windows = NULL;
+    priv->common_menu_flag = FALSE;
+    priv->menu_flag_window = NULL;
+    priv->window_ids = g_hash_table_new_full (NULL, NULL, NULL,
+                                              hildon_program_window_ids_free);
+    priv->xid_windows = g_hash_table_new (NULL, NULL);
+    priv->group_counts = g_hash_table_new (NULL, NULL);
+    priv->topmost_window = NULL;
 }
 
 static void
@@ -173,6 +205,16 @@ hildon_program_finalize                         (GObject *self)
         g_object_unref (priv->common_menu);
         priv->common_menu = NULL;
     }
+
+    g_hash_table_destroy (priv->window_ids);
+    g_hash_table_destroy (priv->xid_windows);
+    g_hash_table_destroy (priv->group_counts);
+}
+
+static void
+hildon_program_real_purge_caches                (HildonProgram *self)
+{
+    hildon_purge_caches ();
 }
 
 static void
@@ -187,6 +229,8 @@ hildon_program_class_init                       (HildonProgramClass *self)
     object_class->set_property  = hildon_program_set_property;
     object_class->get_property  = hildon_program_get_property;
 
+    self->purge_caches          = hildon_program_real_purge_caches;
+
     /* Install properties */
 
     /**
@@ -216,6 +260,27 @@ hildon_program_class_init                       (HildonProgramClass *self)
                 "Navigator in low memory situation",
                 FALSE,
                 G_PARAM_READWRITE)); 
+
+    /**
+     * HildonProgram::purge-caches:
+     * @program: the #HildonProgram that received the signal
+     *
+     * Emitted when the program should release all the memory it can
+     * recreate later, either because hildon_program_purge_caches() was
+     * called or because the program went to the background while it
+     * can hibernate. The default handler drops the caches kept by the
+     * Hildon widgets; connect to it to drop the application's own
+     * caches as well.
+     *
+     * Since: 3.0
+     */
+    signals[PURGE_CACHES] = g_signal_new ("purge-caches",
+                                          G_TYPE_FROM_CLASS (object_class),
+                                          G_SIGNAL_RUN_LAST,
+                                          G_STRUCT_OFFSET (HildonProgramClass, purge_caches),
+                                          NULL, NULL,
+                                          g_cclosure_marshal_VOID__VOID,
+                                          G_TYPE_NONE, 0);
     return;
 }
 
@@ -290,6 +355,10 @@ hildon_program_window_list_is_is_topmost        (gpointer data,
     }
 }
 
+static void
+hildon_program_window_set_common_menu_flag      (HildonWindow *window,
+                                                 gboolean common_menu);
+
 /*
  * Check the _MB_CURRENT_APP_WINDOW on the root window, and update
  * the top_most status accordingly
@@ -299,6 +368,7 @@ hildon_program_update_top_most                  (HildonProgram *program)
 {
     gboolean is_topmost;
     Window active_window;
+    HildonWindow *topmost_window;
     HildonProgramPrivate *priv;
 
     priv = HILDON_PROGRAM_GET_PRIVATE (program);
@@ -309,31 +379,13 @@ hildon_program_update_top_most                  (HildonProgram *program)
 
     if (active_window)
     {
-      gint xerror;
-      XWMHints *wm_hints;
-      
-      gdk_error_trap_push ();
-      wm_hints = XGetWMHints (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()), active_window);
-      xerror = gdk_error_trap_pop ();
-      if (xerror && xerror != BadWindow)
-      {
-        if (wm_hints)
-          XFree (wm_hints);
-        return;
-      }
+        Window active_group = hildon_window_get_active_window_group ();
 
-      if (wm_hints)
-      {
-        GSList *iter;
-        for (iter = priv->windows ; iter && !is_topmost; iter = iter->next)
-          {
-            GdkWindow *gdkwin = gtk_widget_get_window (GTK_WIDGET (iter->data));
-            GdkWindow *group = gdkwin ? gdk_window_get_group (gdkwin) : NULL;
-            if (group)
-              is_topmost = wm_hints->window_group == GDK_WINDOW_XID (group);
-          }
-        XFree (wm_hints);
-      }
+        /* The groups of the windows are kept up to date as they are
+         * realized, so this is a single lookup */
+        if (active_group)
+            is_topmost = g_hash_table_lookup (priv->group_counts,
+                                              GSIZE_TO_POINTER (active_group)) != NULL;
     }
 
     /* Send notification if is_topmost has changed */
@@ -341,45 +393,127 @@ hildon_program_update_top_most                  (HildonProgram *program)
     {
       priv->is_topmost = is_topmost;
       g_object_notify (G_OBJECT (program), "is-topmost");
+
+      /* A program in the background is the first candidate for
+       * hibernation, so give up what can be recreated first */
+      if (!is_topmost && priv->killable)
+        g_signal_emit (program, signals[PURGE_CACHES], 0);
     }
 
-    /* Check each window if it was is_topmost */
-    g_slist_foreach (priv->windows, 
-            (GFunc)hildon_program_window_list_is_is_topmost, &active_window);
+    /* Only the window that was topmost and the one that is now can
+     * have changed */
+    topmost_window = active_window ?
+        g_hash_table_lookup (priv->xid_windows, GSIZE_TO_POINTER (active_window)) : NULL;
+
+    if (priv->topmost_window && priv->topmost_window != topmost_window)
+        hildon_program_window_list_is_is_topmost (priv->topmost_window, &active_window);
+
+    if (topmost_window)
+        hildon_program_window_list_is_is_topmost (topmost_window, &active_window);
+
+    priv->topmost_window = topmost_window;
+
+    /* The common menu flag is only kept up to date in the topmost
+     * window, so bring the new one up to date */
+    if ((priv->common_menu || priv->common_app_menu) &&
+        topmost_window && topmost_window != priv->menu_flag_window)
+    {
+        hildon_program_window_set_common_menu_flag (topmost_window, priv->common_menu_flag);
+        priv->menu_flag_window = topmost_window;
+    }
 }
 
-/*
- * We keep track of the _MB_CURRENT_APP_WINDOW property on the root window,
- * to detect when a window belonging to this program was is_topmost. This
- * is based on the window group WM hint.
- */
-static GdkFilterReturn
-hildon_program_root_window_event_filter         (GdkXEvent *xevent,
-                                                 GdkEvent *event,
-                                                 gpointer data)
+static void
+hildon_program_window_track                     (HildonProgram *program,
+                                                 HildonWindow  *window)
 {
-    XAnyEvent *eventti = xevent;
-    HildonProgram *program = HILDON_PROGRAM (data);
-    Atom active_app_atom =
-            XInternAtom (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()),
-                         "_MB_CURRENT_APP_WINDOW", False);
+    HildonProgramPrivate *priv = HILDON_PROGRAM_GET_PRIVATE (program);
+    HildonProgramWindowIds *ids;
+    GdkWindow *gdkwin;
+    GdkWindow *group;
+
+    gdkwin = gtk_widget_get_window (GTK_WIDGET (window));
+    if (gdkwin == NULL || g_hash_table_lookup (priv->window_ids, window))
+        return;
+
+    group = gdk_window_get_group (gdkwin);
 
-    if (eventti->type == PropertyNotify)
+    ids = g_slice_new (HildonProgramWindowIds);
+    ids->xid = GDK_WINDOW_XID (gdkwin);
+    ids->group = group ? GDK_WINDOW_XID (group) : 0;
+    g_hash_table_insert (priv->window_ids, window, ids);
+
+    g_hash_table_insert (priv->xid_windows, GSIZE_TO_POINTER (ids->xid), window);
+
+    if (ids->group)
     {
-        XPropertyEvent *pevent = xevent;
+        gpointer key = GSIZE_TO_POINTER (ids->group);
+        guint count = GPOINTER_TO_UINT (g_hash_table_lookup (priv->group_counts, key));
 
-        if (pevent->atom == active_app_atom)
-        {
-            hildon_program_update_top_most (program);
-        }
+        g_hash_table_insert (priv->group_counts, key, GUINT_TO_POINTER (count + 1));
+    }
+}
+
+static void
+hildon_program_window_untrack                   (HildonProgram *program,
+                                                 HildonWindow  *window)
+{
+    HildonProgramPrivate *priv = HILDON_PROGRAM_GET_PRIVATE (program);
+    HildonProgramWindowIds *ids;
+
+    ids = g_hash_table_lookup (priv->window_ids, window);
+    if (ids == NULL)
+        return;
+
+    g_hash_table_remove (priv->xid_windows, GSIZE_TO_POINTER (ids->xid));
+
+    if (ids->group)
+    {
+        gpointer key = GSIZE_TO_POINTER (ids->group);
+        guint count = GPOINTER_TO_UINT (g_hash_table_lookup (priv->group_counts, key));
+
+        if (count > 1)
+            g_hash_table_insert (priv->group_counts, key, GUINT_TO_POINTER (count - 1));
+        else
+            g_hash_table_remove (priv->group_counts, key);
     }
 
-    return GDK_FILTER_CONTINUE;
+    g_hash_table_remove (priv->window_ids, window);
+
+    if (priv->topmost_window == window)
+        priv->topmost_window = NULL;
+}
+
+static void
+hildon_program_window_realized                  (HildonWindow  *window,
+                                                 HildonProgram *program)
+{
+    hildon_program_window_track (program, window);
+    hildon_program_update_top_most (program);
+}
+
+static void
+hildon_program_window_unrealized                (HildonWindow  *window,
+                                                 HildonProgram *program)
+{
+    hildon_program_window_untrack (program, window);
+    hildon_program_update_top_most (program);
+}
+
+/*
+ * We keep track of the _MB_CURRENT_APP_WINDOW property on the root window,
+ * to detect when a window belonging to this program was is_topmost. This
+ * is based on the window group WM hint.
+ */
+static void
+hildon_program_active_window_changed            (gpointer data)
+{
+    hildon_program_update_top_most (HILDON_PROGRAM (data));
 }
 
 static void
-hildon_program_window_set_common_menu_flag (HildonWindow *window,
-                                            gboolean common_menu)
+hildon_program_window_set_common_menu_flag      (HildonWindow *window,
+                                                 gboolean common_menu)
 {
     if (HILDON_IS_WINDOW (window))
     {
@@ -392,15 +526,32 @@ hildon_program_window_set_common_menu_flag (HildonWindow *window,
     }
 }
 
+/*
+ * Updating the menu flag of every window means changing an X property
+ * on each of them, although the window manager only shows it for the
+ * topmost one. Update only that window now; other windows are brought
+ * up to date by hildon_program_update_top_most() when they are topped.
+ */
 static void
 hildon_program_set_common_menu_flag (HildonProgram *self,
                                      gboolean common_menu)
 {
     HildonProgramPrivate *priv = HILDON_PROGRAM_GET_PRIVATE (self);
+    GSList *iter;
+
+    priv->common_menu_flag = common_menu;
+    priv->menu_flag_window = NULL;
 
-    g_slist_foreach (priv->windows,
-                     (GFunc) hildon_program_window_set_common_menu_flag,
-                     GINT_TO_POINTER (common_menu));
+    for (iter = priv->windows; iter; iter = iter->next)
+    {
+        HildonWindow *window = HILDON_WINDOW (iter->data);
+        if (hildon_window_get_is_topmost (window))
+        {
+            hildon_program_window_set_common_menu_flag (window, common_menu);
+            priv->menu_flag_window = window;
+            break;
+        }
+    }
 }
 
 /* 
@@ -437,23 +588,6 @@ hildon_program_get_instance                     (void)
     return program;
 }
 
-static void
-window_add_event_filter                         (GtkWidget     *widget,
-                                                 HildonProgram *program)
-{
-    GdkWindow *gdk_window = gtk_widget_get_window (widget);
-    g_assert (gdk_window);
-
-    gdk_window_set_events (gdk_window,
-                           gdk_window_get_events (gdk_window) | GDK_PROPERTY_CHANGE_MASK);
-
-    gdk_window_add_filter (gdk_window,
-                           hildon_program_root_window_event_filter, program);
-
-    g_signal_handlers_disconnect_by_func (widget, G_CALLBACK (window_add_event_filter),
-                                          program);
-}
-
 /**
  * hildon_program_add_window:
  * @self: The #HildonProgram to which the window should be registered
@@ -483,26 +617,27 @@ hildon_program_add_window                       (HildonProgram *self,
         return;
     }
 
-    hildon_program_update_top_most (self);
-
     /* Now that we have a window we should start keeping track of
      * the root window */
-    if (gtk_widget_get_realized (GTK_WIDGET (window)))
-    {
-        window_add_event_filter (GTK_WIDGET (window), self);
-    }
-    else
-    {
-        g_signal_connect_after (window, "realize",
-                                G_CALLBACK (window_add_event_filter), self);
-    }
+    if (priv->window_count == 0)
+        hildon_window_watch_active_window (hildon_program_active_window_changed, self);
+
+    /* Windows are usually realized after being added, and their ids
+     * only exist while they are realized */
+    hildon_program_window_track (self, window);
+    g_signal_connect_after (window, "realize",
+                            G_CALLBACK (hildon_program_window_realized), self);
+    g_signal_connect (window, "unrealize",
+                      G_CALLBACK (hildon_program_window_unrealized), self);
+
+    hildon_program_update_top_most (self);
 
     hildon_window_set_can_hibernate_property (window, &priv->killable);
 
     hildon_window_set_program (window, G_OBJECT (self));
 
     if (priv->common_menu || priv->common_app_menu)
-        hildon_program_window_set_common_menu_flag (window, TRUE);
+        hildon_program_window_set_common_menu_flag (window, priv->common_menu_flag);
 
     priv->windows = g_slist_append (priv->windows, window);
     priv->window_count ++;
@@ -533,16 +668,19 @@ hildon_program_remove_window                    (HildonProgram *self,
 
     hildon_window_unset_program (window);
 
+    g_signal_handlers_disconnect_by_func (window, hildon_program_window_realized, self);
+    g_signal_handlers_disconnect_by_func (window, hildon_program_window_unrealized, self);
+    hildon_program_window_untrack (self, window);
+
     priv->windows = g_slist_remove (priv->windows, window);
 
+    if (priv->menu_flag_window == window)
+        priv->menu_flag_window = NULL;
+
     priv->window_count --;
 
-    if (gtk_widget_get_realized (GTK_WIDGET (window)))
-    {
-        gdk_window_remove_filter (gtk_widget_get_window (GTK_WIDGET (window)),
-                                  hildon_program_root_window_event_filter,
-                                  self);
-    }
+    if (priv->window_count == 0)
+        hildon_window_unwatch_active_window (hildon_program_active_window_changed, self);
 
     if (priv->common_menu || priv->common_app_menu)
         hildon_program_window_set_common_menu_flag (window, FALSE);
@@ -876,3 +1014,292 @@ hildon_program_get_is_topmost                   (HildonProgram *self)
     return priv->is_topmost;
 }
 
+/**
+ * hildon_program_purge_caches:
+ * @self: A #HildonProgram
+ *
+ * Emits #HildonProgram::purge-caches, making the Hildon widgets (and
+ * any application handler) release the memory they only keep to be
+ * faster, such as the content cache of #HildonPannableArea<!-- -->s
+ * or the pools of #HildonWindowStack<!-- -->s. Applications will
+ * typically call this when the system notifies that memory is
+ * running low.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_program_purge_caches                     (HildonProgram *self)
+{
+    g_return_if_fail (HILDON_IS_PROGRAM (self));
+
+    g_signal_emit (self, signals[PURGE_CACHES], 0);
+}
+
+#define                                         HILDON_PROGRAM_STATE_GROUP "HildonProgram"
+
+static GQuark
+hildon_program_pending_value_quark              (void)
+{
+    static GQuark quark = 0;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-program-pending-value");
+
+    return quark;
+}
+
+static gboolean
+hildon_program_try_adjustment_value             (GtkAdjustment *adj,
+                                                 gdouble        value)
+{
+    if (value > gtk_adjustment_get_upper (adj) - gtk_adjustment_get_page_size (adj))
+        return FALSE;
+
+    gtk_adjustment_set_value (adj, value);
+
+    return TRUE;
+}
+
+static void
+hildon_program_adjustment_changed               (GtkAdjustment *adj)
+{
+    gdouble *pending = g_object_get_qdata (G_OBJECT (adj), hildon_program_pending_value_quark ());
+
+    /* Wait for the first allocation, then set the value, clamped to
+     * the range, once and for all */
+    if (gtk_adjustment_get_page_size (adj) <= 0)
+        return;
+
+    g_signal_handlers_disconnect_by_func (adj, hildon_program_adjustment_changed, NULL);
+    if (pending != NULL)
+        gtk_adjustment_set_value (adj, *pending);
+    g_object_set_qdata (G_OBJECT (adj), hildon_program_pending_value_quark (), NULL);
+}
+
+/* Before the first allocation the adjustments have no range yet, so
+ * the value is set as soon as they get one */
+static void
+hildon_program_restore_adjustment               (GtkAdjustment *adj,
+                                                 gdouble        value)
+{
+    gdouble *pending;
+
+    if (hildon_program_try_adjustment_value (adj, value))
+        return;
+
+    pending = g_object_get_qdata (G_OBJECT (adj), hildon_program_pending_value_quark ());
+    if (pending == NULL) {
+        pending = g_new (gdouble, 1);
+        g_object_set_qdata_full (G_OBJECT (adj), hildon_program_pending_value_quark (),
+                                 pending, g_free);
+        g_signal_connect (adj, "changed",
+                          G_CALLBACK (hildon_program_adjustment_changed), NULL);
+    }
+
+    *pending = value;
+}
+
+static void
+hildon_program_save_selector                    (HildonTouchSelector *selector,
+                                                 GKeyFile            *key_file,
+                                                 const gchar         *group)
+{
+    gint n_columns = hildon_touch_selector_get_num_columns (selector);
+    gint *active = g_newa (gint, MAX (n_columns, 1));
+    gint i;
+
+    for (i = 0; i < n_columns; i++)
+        active[i] = hildon_touch_selector_get_active (selector, i);
+
+    g_key_file_set_integer_list (key_file, group, "Active", active, n_columns);
+}
+
+static void
+hildon_program_restore_selector                 (HildonTouchSelector *selector,
+                                                 GKeyFile            *key_file,
+                                                 const gchar         *group)
+{
+    gint *active;
+    gsize i, length;
+
+    active = g_key_file_get_integer_list (key_file, group, "Active", &length, NULL);
+    if (active == NULL)
+        return;
+
+    for (i = 0; i < length && i < (gsize) hildon_touch_selector_get_num_columns (selector); i++)
+        hildon_touch_selector_set_active (selector, i, active[i]);
+
+    g_free (active);
+}
+
+/* Saves or restores the state of @widget, for the widgets that have
+ * one worth keeping */
+static void
+hildon_program_widget_state                     (GtkWidget   *widget,
+                                                 GKeyFile    *key_file,
+                                                 const gchar *group,
+                                                 gboolean     save)
+{
+    if (HILDON_IS_PANNABLE_AREA (widget)) {
+        HildonPannableArea *area = HILDON_PANNABLE_AREA (widget);
+        GtkAdjustment *hadj = hildon_pannable_area_get_hadjustment (area);
+        GtkAdjustment *vadj = hildon_pannable_area_get_vadjustment (area);
+
+        if (save) {
+            g_key_file_set_double (key_file, group, "X", gtk_adjustment_get_value (hadj));
+            g_key_file_set_double (key_file, group, "Y", gtk_adjustment_get_value (vadj));
+        } else if (g_key_file_has_group (key_file, group)) {
+            hildon_program_restore_adjustment (hadj, g_key_file_get_double (key_file, group, "X", NULL));
+            hildon_program_restore_adjustment (vadj, g_key_file_get_double (key_file, group, "Y", NULL));
+        }
+    } else if (HILDON_IS_TOUCH_SELECTOR (widget) || HILDON_IS_PICKER_BUTTON (widget)) {
+        HildonTouchSelector *selector = HILDON_IS_PICKER_BUTTON (widget) ?
+            hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (widget)) :
+            HILDON_TOUCH_SELECTOR (widget);
+
+        if (selector == NULL)
+            return;
+
+        if (save)
+            hildon_program_save_selector (selector, key_file, group);
+        else
+            hildon_program_restore_selector (selector, key_file, group);
+    } else if (HILDON_IS_LIVE_SEARCH (widget)) {
+        HildonLiveSearch *livesearch = HILDON_LIVE_SEARCH (widget);
+
+        if (save) {
+            const gchar *text = hildon_live_search_get_text (livesearch);
+
+            g_key_file_set_string (key_file, group, "Text", text ? text : "");
+        } else {
+            gchar *text = g_key_file_get_string (key_file, group, "Text", NULL);
+
+            if (text != NULL) {
+                hildon_live_search_set_text (livesearch, text);
+                g_free (text);
+            }
+        }
+    }
+}
+
+static void
+hildon_program_prepend_child                    (GtkWidget *child,
+                                                 gpointer   data)
+{
+    GList **children = data;
+
+    *children = g_list_prepend (*children, child);
+}
+
+/* Widgets are told apart by their path from the window, so the state
+ * goes back to the same widgets as long as the application builds the
+ * windows the same way */
+static void
+hildon_program_walk_state                       (GtkWidget *widget,
+                                                 GKeyFile  *key_file,
+                                                 GString   *path,
+                                                 gboolean   save)
+{
+    GList *children = NULL;
+    GList *l;
+    gsize length = path->len;
+    guint i = 0;
+
+    hildon_program_widget_state (widget, key_file, path->str, save);
+
+    if (!GTK_IS_CONTAINER (widget))
+        return;
+
+    gtk_container_forall (GTK_CONTAINER (widget), hildon_program_prepend_child, &children);
+    children = g_list_reverse (children);
+
+    for (l = children; l != NULL; l = l->next, i++) {
+        g_string_append_printf (path, ".%u", i);
+        hildon_program_walk_state (l->data, key_file, path, save);
+        g_string_truncate (path, length);
+    }
+
+    g_list_free (children);
+}
+
+static void
+hildon_program_walk_stack                       (GKeyFile *key_file,
+                                                 gboolean  save)
+{
+    GList *windows, *l;
+    GString *path = g_string_new (NULL);
+    guint depth;
+
+    windows = hildon_window_stack_get_windows (hildon_window_stack_get_default ());
+    depth = g_list_length (windows);
+
+    if (save)
+        g_key_file_set_integer (key_file, HILDON_PROGRAM_STATE_GROUP, "StackDepth", depth);
+
+    /* Windows are numbered from the bottom of the stack */
+    for (l = windows; l != NULL; l = l->next) {
+        g_string_printf (path, "Window %u", --depth);
+        hildon_program_walk_state (l->data, key_file, path, save);
+    }
+
+    g_list_free (windows);
+    g_string_free (path, TRUE);
+}
+
+/**
+ * hildon_program_save_state:
+ * @self: The #HildonProgram
+ * @key_file: The key file to save to
+ *
+ * Saves the state of the user interface of the application to
+ * @key_file, so that it can be brought back with
+ * hildon_program_restore_state() after the application has been
+ * closed, e.g. on hibernation. The number of windows in the default
+ * #HildonWindowStack is saved as the "StackDepth" key of the
+ * "HildonProgram" group. For each window of the stack, the scroll
+ * offsets of its #HildonPannableArea<!-- -->s, the active rows of its
+ * #HildonTouchSelector<!-- -->s and #HildonPickerButton<!-- -->s, and
+ * the text of its #HildonLiveSearch<!-- -->es are saved.
+ *
+ * Widgets are identified by their position in the windows, so @key_file
+ * should be a new key file, not one that holds the state of other
+ * windows.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_program_save_state                       (HildonProgram *self,
+                                                 GKeyFile      *key_file)
+{
+    g_return_if_fail (HILDON_IS_PROGRAM (self));
+    g_return_if_fail (key_file != NULL);
+
+    hildon_program_walk_stack (key_file, TRUE);
+}
+
+/**
+ * hildon_program_restore_state:
+ * @self: The #HildonProgram
+ * @key_file: The key file to read from
+ *
+ * Restores the state saved with hildon_program_save_state() to the
+ * windows of the default #HildonWindowStack. The application creates
+ * its windows again first, as many as the "StackDepth" key of the
+ * "HildonProgram" group says, and pushes them between
+ * hildon_window_stack_begin_update() and
+ * hildon_window_stack_commit_update(). Calling this function before the
+ * commit restores everything before the windows are first mapped;
+ * scroll offsets of pannable areas that are not allocated yet are
+ * applied, clamped to the content, on their first allocation.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_program_restore_state                    (HildonProgram *self,
+                                                 GKeyFile      *key_file)
+{
+    g_return_if_fail (HILDON_IS_PROGRAM (self));
+    g_return_if_fail (key_file != NULL);
+
+    hildon_program_walk_stack (key_file, FALSE);
+}
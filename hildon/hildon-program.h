@@ -65,8 +65,9 @@ struct                                          _HildonProgramClass
 {
     GObjectClass parent;
 
+    void (*purge_caches)(HildonProgram *program);
+
     /* Padding for future extension */
-    void (*_hildon_reserved1)(void);
     void (*_hildon_reserved2)(void);
     void (*_hildon_reserved3)(void);
     void (*_hildon_reserved4)(void);
@@ -117,6 +118,17 @@ hildon_program_get_common_toolbar               (HildonProgram *self);
 gboolean
 hildon_program_get_is_topmost                   (HildonProgram *self);
 
+void
+hildon_program_purge_caches                     (HildonProgram *self);
+
+void
+hildon_program_save_state                       (HildonProgram *self,
+                                                 GKeyFile      *key_file);
+
+void
+hildon_program_restore_state                    (HildonProgram *self,
+                                                 GKeyFile      *key_file);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_PROGRAM_H__ */
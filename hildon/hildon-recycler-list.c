@@ -0,0 +1,862 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-recycler-list
+ * @short_description: A list of widget rows that only creates the visible ones
+ * @see_also: #HildonPannableArea
+ *
+ * #HildonRecyclerList shows the rows of a #GtkTreeModel list as real
+ * widgets, like #HildonButton<!-- -->s or #HildonCheckButton<!-- -->s,
+ * for the lists that can't be made with cell renderers. Instead of one
+ * widget per row, it only keeps enough of them to cover its viewport
+ * and a few rows around it. When the list scrolls, the widgets that went
+ * out of view are given the rows that came into view, so a list of
+ * thousands of rows costs about as much as the rows on the screen.
+ *
+ * The rows are made with the #HildonRecyclerListCreateFunc and given
+ * the contents of a row of the model with the #HildonRecyclerListBindFunc
+ * passed to hildon_recycler_list_set_row_funcs(). As a row widget shows a
+ * different row every time it is bound, it should keep no state of its
+ * own: anything it changes, like whether a check button is active, must
+ * be written to the model and read back when binding.
+ *
+ * All the rows have the height given to hildon_recycler_list_new(). The
+ * list is scrollable, so it is put directly in a #HildonPannableArea,
+ * without a viewport.
+ *
+ * <example>
+ * <title>A list of check buttons</title>
+ * <programlisting>
+ * static GtkWidget *
+ * create_row (HildonRecyclerList *list, gpointer data)
+ * {
+ *     return hildon_check_button_new (HILDON_SIZE_FINGER_HEIGHT);
+ * }
+ * <!-- -->
+ * static void
+ * bind_row (HildonRecyclerList *list, GtkWidget *row,
+ *           GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+ * {
+ *     gchar *name;
+ *     gboolean active;
+ * <!-- -->
+ *     gtk_tree_model_get (model, iter, NAME_COLUMN, &name, ACTIVE_COLUMN, &active, -1);
+ *     gtk_button_set_label (GTK_BUTTON (row), name);
+ *     hildon_check_button_set_active (HILDON_CHECK_BUTTON (row), active);
+ *     g_free (name);
+ * }
+ * <!-- -->
+ * list = hildon_recycler_list_new (model, 70);
+ * hildon_recycler_list_set_row_funcs (HILDON_RECYCLER_LIST (list),
+ *                                     create_row, bind_row, NULL, NULL);
+ * gtk_container_add (GTK_CONTAINER (pannable_area), list);
+ * </programlisting>
+ * </example>
+ */
+
+#include                                        "hildon-recycler-list.h"
+
+/* Rows kept bound above and below the viewport, so that short scrolls
+ * don't need any binding */
+#define                                         HILDON_RECYCLER_LIST_MARGIN_ROWS 4
+
+enum
+{
+    PROP_0,
+    PROP_MODEL,
+    PROP_ROW_HEIGHT,
+    PROP_HADJUSTMENT,
+    PROP_VADJUSTMENT,
+    PROP_HSCROLL_POLICY,
+    PROP_VSCROLL_POLICY
+};
+
+struct                                          _HildonRecyclerListPrivate
+{
+    GtkTreeModel *model;
+    gint n_rows;
+    gint row_height;
+
+    HildonRecyclerListCreateFunc create_func;
+    HildonRecyclerListBindFunc bind_func;
+    gpointer func_data;
+    GDestroyNotify func_destroy;
+
+    /* Row i of the model is shown by rows[i % rows->len], and bound[k]
+     * is the row of the model rows[k] shows, or -1 */
+    GPtrArray *rows;
+    GArray *bound;
+    gint first;
+    gint last;
+
+    GtkAdjustment *hadjustment;
+    GtkAdjustment *vadjustment;
+    guint hscroll_policy : 1;
+    guint vscroll_policy : 1;
+};
+
+G_DEFINE_TYPE_WITH_CODE                         (HildonRecyclerList, hildon_recycler_list, GTK_TYPE_CONTAINER,
+                                                 G_IMPLEMENT_INTERFACE (GTK_TYPE_SCROLLABLE, NULL));
+
+#define                                         HILDON_RECYCLER_LIST_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
+                                                HILDON_TYPE_RECYCLER_LIST, HildonRecyclerListPrivate))
+
+#define                                         BOUND(priv, slot) \
+                                                (g_array_index ((priv)->bound, gint, (slot)))
+
+static void
+hildon_recycler_list_forget_rows                (HildonRecyclerList *list)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+    guint i;
+
+    for (i = 0; i < priv->bound->len; i++)
+        BOUND (priv, i) = -1;
+}
+
+static void
+hildon_recycler_list_bind                       (HildonRecyclerList *list,
+                                                 guint               slot,
+                                                 gint                index)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+    GtkTreeIter iter;
+
+    if (!gtk_tree_model_iter_nth_child (priv->model, &iter, NULL, index))
+        return;
+
+    priv->bind_func (list, g_ptr_array_index (priv->rows, slot), priv->model, &iter,
+                     priv->func_data);
+    BOUND (priv, slot) = index;
+}
+
+/* Makes sure there is a bound row widget for each row of the model in
+ * the viewport and its margin, and hides the spare ones */
+static void
+hildon_recycler_list_update_rows                (HildonRecyclerList *list)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+    GtkWidget *widget = GTK_WIDGET (list);
+    gdouble value = 0;
+    gint page, needed, i;
+    guint slot;
+
+    priv->first = priv->last = 0;
+
+    if (priv->model == NULL || priv->create_func == NULL || priv->n_rows == 0)
+        goto hide;
+
+    if (priv->vadjustment)
+        value = gtk_adjustment_get_value (priv->vadjustment);
+    page = gtk_widget_get_allocated_height (widget);
+
+    priv->first = MAX (0, (gint) (value / priv->row_height) - HILDON_RECYCLER_LIST_MARGIN_ROWS);
+    priv->last = MIN (priv->n_rows,
+                      (gint) ((value + page) / priv->row_height) + 1 + HILDON_RECYCLER_LIST_MARGIN_ROWS);
+    needed = priv->last - priv->first;
+
+    if (needed > (gint) priv->rows->len) {
+        /* Which widget shows which row depends on how many there are */
+        hildon_recycler_list_forget_rows (list);
+
+        while ((gint) priv->rows->len < needed) {
+            GtkWidget *row = priv->create_func (list, priv->func_data);
+            gint unbound = -1;
+
+            g_ptr_array_add (priv->rows, row);
+            g_array_append_val (priv->bound, unbound);
+            gtk_widget_set_parent (row, widget);
+            gtk_widget_show (row);
+        }
+    }
+
+    for (i = priv->first; i < priv->last; i++) {
+        slot = i % priv->rows->len;
+        if (BOUND (priv, slot) != i)
+            hildon_recycler_list_bind (list, slot, i);
+    }
+
+hide:
+    for (slot = 0; slot < priv->rows->len; slot++) {
+        GtkWidget *row = g_ptr_array_index (priv->rows, slot);
+        gint index = BOUND (priv, slot);
+        gboolean visible = index >= priv->first && index < priv->last;
+
+        if (gtk_widget_get_child_visible (row) != visible)
+            gtk_widget_set_child_visible (row, visible);
+    }
+}
+
+static void
+hildon_recycler_list_allocate_rows              (HildonRecyclerList *list)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+    GtkAllocation allocation;
+    gdouble value = 0;
+    gint i;
+
+    if (priv->vadjustment)
+        value = gtk_adjustment_get_value (priv->vadjustment);
+
+    allocation.x = 0;
+    allocation.width = gtk_widget_get_allocated_width (GTK_WIDGET (list));
+    allocation.height = priv->row_height;
+
+    for (i = priv->first; i < priv->last; i++) {
+        GtkWidget *row = g_ptr_array_index (priv->rows, i % priv->rows->len);
+        gint minimum;
+
+        gtk_widget_get_preferred_height (row, &minimum, NULL);
+        allocation.y = i * priv->row_height - (gint) value;
+        gtk_widget_size_allocate (row, &allocation);
+    }
+}
+
+static void
+hildon_recycler_list_configure_adjustments      (HildonRecyclerList *list)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+    gint width = gtk_widget_get_allocated_width (GTK_WIDGET (list));
+    gint height = gtk_widget_get_allocated_height (GTK_WIDGET (list));
+    gdouble upper = (gdouble) priv->n_rows * priv->row_height;
+
+    if (priv->hadjustment)
+        gtk_adjustment_configure (priv->hadjustment, 0, 0, width,
+                                  width * 0.1, width * 0.9, width);
+
+    if (priv->vadjustment)
+        gtk_adjustment_configure (priv->vadjustment,
+                                  CLAMP (gtk_adjustment_get_value (priv->vadjustment),
+                                         0, MAX (0, upper - height)),
+                                  0, MAX (upper, height),
+                                  priv->row_height, height * 0.9, height);
+}
+
+static void
+hildon_recycler_list_value_changed              (GtkAdjustment      *adjustment,
+                                                 HildonRecyclerList *list)
+{
+    if (!gtk_widget_get_realized (GTK_WIDGET (list)))
+        return;
+
+    hildon_recycler_list_update_rows (list);
+    hildon_recycler_list_allocate_rows (list);
+    gtk_widget_queue_draw (GTK_WIDGET (list));
+}
+
+static void
+hildon_recycler_list_set_adjustment             (HildonRecyclerList *list,
+                                                 GtkAdjustment     **slot,
+                                                 GtkAdjustment      *adjustment)
+{
+    if (adjustment && *slot == adjustment)
+        return;
+
+    if (*slot) {
+        g_signal_handlers_disconnect_by_func (*slot, hildon_recycler_list_value_changed, list);
+        g_object_unref (*slot);
+    }
+
+    if (adjustment == NULL)
+        adjustment = gtk_adjustment_new (0, 0, 0, 0, 0, 0);
+
+    *slot = g_object_ref_sink (adjustment);
+    g_signal_connect (adjustment, "value-changed",
+                      G_CALLBACK (hildon_recycler_list_value_changed), list);
+
+    hildon_recycler_list_configure_adjustments (list);
+}
+
+static void
+hildon_recycler_list_rows_changed               (HildonRecyclerList *list)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+
+    priv->n_rows = gtk_tree_model_iter_n_children (priv->model, NULL);
+    hildon_recycler_list_forget_rows (list);
+    gtk_widget_queue_resize (GTK_WIDGET (list));
+}
+
+static void
+hildon_recycler_list_row_changed                (GtkTreeModel       *model,
+                                                 GtkTreePath        *path,
+                                                 GtkTreeIter        *iter,
+                                                 HildonRecyclerList *list)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+    gint index = gtk_tree_path_get_indices (path)[0];
+    guint slot;
+
+    if (priv->rows->len == 0 || index < priv->first || index >= priv->last)
+        return;
+
+    slot = index % priv->rows->len;
+    if (BOUND (priv, slot) == index)
+        priv->bind_func (list, g_ptr_array_index (priv->rows, slot), model, iter,
+                         priv->func_data);
+}
+
+static void
+hildon_recycler_list_clear_rows                 (HildonRecyclerList *list)
+{
+    HildonRecyclerListPrivate *priv = list->priv;
+
+    while (priv->rows->len > 0)
+        gtk_container_remove (GTK_CONTAINER (list),
+                              g_ptr_array_index (priv->rows, priv->rows->len - 1));
+}
+
+static void
+hildon_recycler_list_realize                    (GtkWidget *widget)
+{
+    GtkAllocation allocation;
+    GdkWindowAttr attributes;
+    GdkWindow *window;
+
+    gtk_widget_set_realized (widget, TRUE);
+    gtk_widget_get_allocation (widget, &allocation);
+
+    attributes.window_type = GDK_WINDOW_CHILD;
+    attributes.x = allocation.x;
+    attributes.y = allocation.y;
+    attributes.width = allocation.width;
+    attributes.height = allocation.height;
+    attributes.wclass = GDK_INPUT_OUTPUT;
+    attributes.visual = gtk_widget_get_visual (widget);
+    attributes.event_mask = gtk_widget_get_events (widget) | GDK_EXPOSURE_MASK;
+
+    window = gdk_window_new (gtk_widget_get_parent_window (widget), &attributes,
+                             GDK_WA_X | GDK_WA_Y | GDK_WA_VISUAL);
+    gtk_widget_set_window (widget, window);
+    gtk_widget_register_window (widget, window);
+}
+
+static void
+hildon_recycler_list_get_preferred_width        (GtkWidget *widget,
+                                                 gint      *minimum,
+                                                 gint      *natural)
+{
+    HildonRecyclerListPrivate *priv = HILDON_RECYCLER_LIST (widget)->priv;
+    guint i;
+
+    *minimum = *natural = 0;
+
+    for (i = 0; i < priv->rows->len; i++) {
+        gint row_minimum, row_natural;
+
+        gtk_widget_get_preferred_width (g_ptr_array_index (priv->rows, i),
+                                        &row_minimum, &row_natural);
+        *minimum = MAX (*minimum, row_minimum);
+        *natural = MAX (*natural, row_natural);
+    }
+}
+
+static void
+hildon_recycler_list_get_preferred_height       (GtkWidget *widget,
+                                                 gint      *minimum,
+                                                 gint      *natural)
+{
+    HildonRecyclerListPrivate *priv = HILDON_RECYCLER_LIST (widget)->priv;
+
+    *minimum = priv->n_rows > 0 ? priv->row_height : 0;
+    *natural = priv->n_rows * priv->row_height;
+}
+
+static void
+hildon_recycler_list_size_allocate              (GtkWidget     *widget,
+                                                 GtkAllocation *allocation)
+{
+    HildonRecyclerList *list = HILDON_RECYCLER_LIST (widget);
+
+    gtk_widget_set_allocation (widget, allocation);
+
+    if (gtk_widget_get_realized (widget))
+        gdk_window_move_resize (gtk_widget_get_window (widget),
+                                allocation->x, allocation->y,
+                                allocation->width, allocation->height);
+
+    hildon_recycler_list_configure_adjustments (list);
+    hildon_recycler_list_update_rows (list);
+    hildon_recycler_list_allocate_rows (list);
+}
+
+static gboolean
+hildon_recycler_list_draw                       (GtkWidget *widget,
+                                                 cairo_t   *cr)
+{
+    if (gtk_cairo_should_draw_window (cr, gtk_widget_get_window (widget)))
+        gtk_render_background (gtk_widget_get_style_context (widget), cr, 0, 0,
+                               gtk_widget_get_allocated_width (widget),
+                               gtk_widget_get_allocated_height (widget));
+
+    return GTK_WIDGET_CLASS (hildon_recycler_list_parent_class)->draw (widget, cr);
+}
+
+static void
+hildon_recycler_list_add                        (GtkContainer *container,
+                                                 GtkWidget    *widget)
+{
+    g_warning ("The rows of a HildonRecyclerList are made by its "
+               "HildonRecyclerListCreateFunc, they can't be added");
+}
+
+static void
+hildon_recycler_list_remove                     (GtkContainer *container,
+                                                 GtkWidget    *widget)
+{
+    HildonRecyclerList *list = HILDON_RECYCLER_LIST (container);
+    HildonRecyclerListPrivate *priv = list->priv;
+    guint i;
+
+    for (i = 0; i < priv->rows->len; i++) {
+        if (g_ptr_array_index (priv->rows, i) == widget) {
+            gtk_widget_unparent (widget);
+            g_ptr_array_remove_index (priv->rows, i);
+            g_array_remove_index (priv->bound, i);
+            hildon_recycler_list_forget_rows (list);
+            gtk_widget_queue_resize (GTK_WIDGET (list));
+            return;
+        }
+    }
+}
+
+static void
+hildon_recycler_list_forall                     (GtkContainer *container,
+                                                 gboolean      include_internals,
+                                                 GtkCallback   callback,
+                                                 gpointer      data)
+{
+    HildonRecyclerListPrivate *priv = HILDON_RECYCLER_LIST (container)->priv;
+    guint i;
+
+    /* The callback may remove the row */
+    for (i = priv->rows->len; i > 0; i--)
+        callback (g_ptr_array_index (priv->rows, i - 1), data);
+}
+
+static void
+hildon_recycler_list_set_property               (GObject      *object,
+                                                 guint         prop_id,
+                                                 const GValue *value,
+                                                 GParamSpec   *pspec)
+{
+    HildonRecyclerList *list = HILDON_RECYCLER_LIST (object);
+    HildonRecyclerListPrivate *priv = list->priv;
+
+    switch (prop_id)
+    {
+        case PROP_MODEL:
+            hildon_recycler_list_set_model (list, g_value_get_object (value));
+            break;
+        case PROP_ROW_HEIGHT:
+            hildon_recycler_list_set_row_height (list, g_value_get_int (value));
+            break;
+        case PROP_HADJUSTMENT:
+            hildon_recycler_list_set_adjustment (list, &priv->hadjustment,
+                                                 g_value_get_object (value));
+            break;
+        case PROP_VADJUSTMENT:
+            hildon_recycler_list_set_adjustment (list, &priv->vadjustment,
+                                                 g_value_get_object (value));
+            break;
+        case PROP_HSCROLL_POLICY:
+            priv->hscroll_policy = g_value_get_enum (value);
+            break;
+        case PROP_VSCROLL_POLICY:
+            priv->vscroll_policy = g_value_get_enum (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+hildon_recycler_list_get_property               (GObject    *object,
+                                                 guint       prop_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonRecyclerListPrivate *priv = HILDON_RECYCLER_LIST (object)->priv;
+
+    switch (prop_id)
+    {
+        case PROP_MODEL:
+            g_value_set_object (value, priv->model);
+            break;
+        case PROP_ROW_HEIGHT:
+            g_value_set_int (value, priv->row_height);
+            break;
+        case PROP_HADJUSTMENT:
+            g_value_set_object (value, priv->hadjustment);
+            break;
+        case PROP_VADJUSTMENT:
+            g_value_set_object (value, priv->vadjustment);
+            break;
+        case PROP_HSCROLL_POLICY:
+            g_value_set_enum (value, priv->hscroll_policy);
+            break;
+        case PROP_VSCROLL_POLICY:
+            g_value_set_enum (value, priv->vscroll_policy);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+hildon_recycler_list_dispose                    (GObject *object)
+{
+    HildonRecyclerList *list = HILDON_RECYCLER_LIST (object);
+    HildonRecyclerListPrivate *priv = list->priv;
+
+    hildon_recycler_list_set_model (list, NULL);
+
+    if (priv->func_destroy)
+        priv->func_destroy (priv->func_data);
+    priv->func_destroy = NULL;
+    priv->create_func = NULL;
+    priv->bind_func = NULL;
+
+    if (priv->hadjustment) {
+        g_signal_handlers_disconnect_by_func (priv->hadjustment,
+                                              hildon_recycler_list_value_changed, list);
+        g_clear_object (&priv->hadjustment);
+    }
+
+    if (priv->vadjustment) {
+        g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                              hildon_recycler_list_value_changed, list);
+        g_clear_object (&priv->vadjustment);
+    }
+
+    G_OBJECT_CLASS (hildon_recycler_list_parent_class)->dispose (object);
+}
+
+static void
+hildon_recycler_list_finalize                   (GObject *object)
+{
+    HildonRecyclerListPrivate *priv = HILDON_RECYCLER_LIST (object)->priv;
+
+    g_ptr_array_free (priv->rows, TRUE);
+    g_array_free (priv->bound, TRUE);
+
+    G_OBJECT_CLASS (hildon_recycler_list_parent_class)->finalize (object);
+}
+
+static void
+hildon_recycler_list_class_init                 (HildonRecyclerListClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+    GtkContainerClass *container_class = GTK_CONTAINER_CLASS (klass);
+
+    gobject_class->set_property = hildon_recycler_list_set_property;
+    gobject_class->get_property = hildon_recycler_list_get_property;
+    gobject_class->dispose = hildon_recycler_list_dispose;
+    gobject_class->finalize = hildon_recycler_list_finalize;
+
+    widget_class->realize = hildon_recycler_list_realize;
+    widget_class->get_preferred_width = hildon_recycler_list_get_preferred_width;
+    widget_class->get_preferred_height = hildon_recycler_list_get_preferred_height;
+    widget_class->size_allocate = hildon_recycler_list_size_allocate;
+    widget_class->draw = hildon_recycler_list_draw;
+
+    container_class->add = hildon_recycler_list_add;
+    container_class->remove = hildon_recycler_list_remove;
+    container_class->forall = hildon_recycler_list_forall;
+
+    /**
+     * HildonRecyclerList:model:
+     *
+     * The list shown, one row widget per row.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_MODEL,
+        g_param_spec_object (
+            "model",
+            "Model",
+            "The list shown",
+            GTK_TYPE_TREE_MODEL,
+            G_PARAM_READWRITE));
+
+    /**
+     * HildonRecyclerList:row-height:
+     *
+     * The height of every row, in pixels.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_ROW_HEIGHT,
+        g_param_spec_int (
+            "row-height",
+            "Row height",
+            "Height of every row, in pixels",
+            1, G_MAXINT, 70,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
+    g_object_class_override_property (gobject_class, PROP_HADJUSTMENT, "hadjustment");
+    g_object_class_override_property (gobject_class, PROP_VADJUSTMENT, "vadjustment");
+    g_object_class_override_property (gobject_class, PROP_HSCROLL_POLICY, "hscroll-policy");
+    g_object_class_override_property (gobject_class, PROP_VSCROLL_POLICY, "vscroll-policy");
+
+    g_type_class_add_private (klass, sizeof (HildonRecyclerListPrivate));
+}
+
+static void
+hildon_recycler_list_init                       (HildonRecyclerList *self)
+{
+    HildonRecyclerListPrivate *priv = HILDON_RECYCLER_LIST_GET_PRIVATE (self);
+
+    self->priv = priv;
+
+    priv->rows = g_ptr_array_new ();
+    priv->bound = g_array_new (FALSE, FALSE, sizeof (gint));
+
+    gtk_widget_set_has_window (GTK_WIDGET (self), TRUE);
+    gtk_widget_set_redraw_on_allocate (GTK_WIDGET (self), FALSE);
+}
+
+/**
+ * hildon_recycler_list_new:
+ * @model: (allow-none): a #GtkTreeModel list, or %NULL
+ * @row_height: the height of the rows, in pixels
+ *
+ * Creates a new #HildonRecyclerList showing @model. No row is shown
+ * until the row widgets can be made, see
+ * hildon_recycler_list_set_row_funcs().
+ *
+ * Returns: a new #HildonRecyclerList
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_recycler_list_new                        (GtkTreeModel *model,
+                                                 gint          row_height)
+{
+    return g_object_new (HILDON_TYPE_RECYCLER_LIST,
+                         "model", model,
+                         "row-height", row_height,
+                         NULL);
+}
+
+/**
+ * hildon_recycler_list_set_row_funcs:
+ * @list: a #HildonRecyclerList
+ * @create_func: makes a row widget
+ * @bind_func: makes a row widget show a row of the model
+ * @data: user data for @create_func and @bind_func
+ * @destroy: (allow-none): called on @data when the functions are replaced
+ *
+ * Sets the functions making and filling the row widgets of @list. The
+ * row widgets made by the previous functions are destroyed.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_recycler_list_set_row_funcs              (HildonRecyclerList          *list,
+                                                 HildonRecyclerListCreateFunc create_func,
+                                                 HildonRecyclerListBindFunc   bind_func,
+                                                 gpointer                     data,
+                                                 GDestroyNotify               destroy)
+{
+    HildonRecyclerListPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_RECYCLER_LIST (list));
+    g_return_if_fail (create_func != NULL);
+    g_return_if_fail (bind_func != NULL);
+
+    priv = list->priv;
+
+    hildon_recycler_list_clear_rows (list);
+
+    if (priv->func_destroy)
+        priv->func_destroy (priv->func_data);
+
+    priv->create_func = create_func;
+    priv->bind_func = bind_func;
+    priv->func_data = data;
+    priv->func_destroy = destroy;
+
+    gtk_widget_queue_resize (GTK_WIDGET (list));
+}
+
+/**
+ * hildon_recycler_list_set_model:
+ * @list: a #HildonRecyclerList
+ * @model: (allow-none): a #GtkTreeModel list, or %NULL
+ *
+ * Sets the list shown by @list. Only the top level rows of @model are
+ * shown.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_recycler_list_set_model                  (HildonRecyclerList *list,
+                                                 GtkTreeModel       *model)
+{
+    HildonRecyclerListPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_RECYCLER_LIST (list));
+    g_return_if_fail (model == NULL || GTK_IS_TREE_MODEL (model));
+
+    priv = list->priv;
+
+    if (priv->model == model)
+        return;
+
+    if (priv->model) {
+        g_signal_handlers_disconnect_by_func (priv->model,
+                                              hildon_recycler_list_rows_changed, list);
+        g_signal_handlers_disconnect_by_func (priv->model,
+                                              hildon_recycler_list_row_changed, list);
+        g_object_unref (priv->model);
+    }
+
+    priv->model = model;
+    priv->n_rows = 0;
+    hildon_recycler_list_forget_rows (list);
+
+    if (model) {
+        g_object_ref (model);
+        g_signal_connect_swapped (model, "row-inserted",
+                                  G_CALLBACK (hildon_recycler_list_rows_changed), list);
+        g_signal_connect_swapped (model, "row-deleted",
+                                  G_CALLBACK (hildon_recycler_list_rows_changed), list);
+        g_signal_connect_swapped (model, "rows-reordered",
+                                  G_CALLBACK (hildon_recycler_list_rows_changed), list);
+        g_signal_connect (model, "row-changed",
+                          G_CALLBACK (hildon_recycler_list_row_changed), list);
+        priv->n_rows = gtk_tree_model_iter_n_children (model, NULL);
+    }
+
+    gtk_widget_queue_resize (GTK_WIDGET (list));
+    g_object_notify (G_OBJECT (list), "model");
+}
+
+/**
+ * hildon_recycler_list_get_model:
+ * @list: a #HildonRecyclerList
+ *
+ * Gets the list shown by @list.
+ *
+ * Returns: (transfer none): the #GtkTreeModel, or %NULL
+ *
+ * Since: 3.0
+ **/
+GtkTreeModel *
+hildon_recycler_list_get_model                  (HildonRecyclerList *list)
+{
+    g_return_val_if_fail (HILDON_IS_RECYCLER_LIST (list), NULL);
+
+    return list->priv->model;
+}
+
+/**
+ * hildon_recycler_list_set_row_height:
+ * @list: a #HildonRecyclerList
+ * @row_height: the height of the rows, in pixels
+ *
+ * Sets the height every row of @list is given.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_recycler_list_set_row_height             (HildonRecyclerList *list,
+                                                 gint                row_height)
+{
+    HildonRecyclerListPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_RECYCLER_LIST (list));
+    g_return_if_fail (row_height > 0);
+
+    priv = list->priv;
+
+    if (priv->row_height == row_height)
+        return;
+
+    priv->row_height = row_height;
+
+    gtk_widget_queue_resize (GTK_WIDGET (list));
+    g_object_notify (G_OBJECT (list), "row-height");
+}
+
+/**
+ * hildon_recycler_list_get_row_height:
+ * @list: a #HildonRecyclerList
+ *
+ * Gets the height of the rows of @list.
+ *
+ * Returns: the height, in pixels
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_recycler_list_get_row_height             (HildonRecyclerList *list)
+{
+    g_return_val_if_fail (HILDON_IS_RECYCLER_LIST (list), 0);
+
+    return list->priv->row_height;
+}
+
+/**
+ * hildon_recycler_list_get_row_widget:
+ * @list: a #HildonRecyclerList
+ * @path: a #GtkTreePath of the model of @list
+ *
+ * Gets the widget showing the row at @path, if the row is in or near
+ * the viewport. The widget will show other rows once @list scrolls, so
+ * it should not be kept.
+ *
+ * Returns: (transfer none): the row widget, or %NULL if the row has none
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_recycler_list_get_row_widget             (HildonRecyclerList *list,
+                                                 GtkTreePath        *path)
+{
+    HildonRecyclerListPrivate *priv;
+    gint index;
+    guint slot;
+
+    g_return_val_if_fail (HILDON_IS_RECYCLER_LIST (list), NULL);
+    g_return_val_if_fail (path != NULL, NULL);
+
+    priv = list->priv;
+
+    if (priv->rows->len == 0 || gtk_tree_path_get_depth (path) != 1)
+        return NULL;
+
+    index = gtk_tree_path_get_indices (path)[0];
+    slot = index % priv->rows->len;
+
+    return BOUND (priv, slot) == index ? g_ptr_array_index (priv->rows, slot) : NULL;
+}
@@ -0,0 +1,137 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_RECYCLER_LIST_H__
+#define                                         __HILDON_RECYCLER_LIST_H__
+
+#include                                        <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_RECYCLER_LIST \
+                                                (hildon_recycler_list_get_type())
+
+#define                                         HILDON_RECYCLER_LIST(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_RECYCLER_LIST, HildonRecyclerList))
+
+#define                                         HILDON_RECYCLER_LIST_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                                HILDON_TYPE_RECYCLER_LIST, HildonRecyclerListClass))
+
+#define                                         HILDON_IS_RECYCLER_LIST(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HILDON_TYPE_RECYCLER_LIST))
+
+#define                                         HILDON_IS_RECYCLER_LIST_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_TYPE ((klass), HILDON_TYPE_RECYCLER_LIST))
+
+#define                                         HILDON_RECYCLER_LIST_GET_CLASS(obj) \
+                                                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                                HILDON_TYPE_RECYCLER_LIST, HildonRecyclerListClass))
+
+typedef struct                                  _HildonRecyclerList HildonRecyclerList;
+
+typedef struct                                  _HildonRecyclerListClass HildonRecyclerListClass;
+
+typedef struct                                  _HildonRecyclerListPrivate HildonRecyclerListPrivate;
+
+/**
+ * HildonRecyclerListCreateFunc:
+ * @list: the #HildonRecyclerList
+ * @data: user data given to hildon_recycler_list_set_row_funcs()
+ *
+ * Creates a widget that can show any row of the model of @list.
+ *
+ * Returns: a new #GtkWidget
+ *
+ * Since: 3.0
+ */
+typedef GtkWidget *(*HildonRecyclerListCreateFunc) (HildonRecyclerList *list,
+                                                    gpointer            data);
+
+/**
+ * HildonRecyclerListBindFunc:
+ * @list: the #HildonRecyclerList
+ * @row: a widget made by the #HildonRecyclerListCreateFunc
+ * @model: the model of @list
+ * @iter: the row @row is to show
+ * @data: user data given to hildon_recycler_list_set_row_funcs()
+ *
+ * Makes @row show the row of @model at @iter, replacing what it showed
+ * before.
+ *
+ * Since: 3.0
+ */
+typedef void (*HildonRecyclerListBindFunc)      (HildonRecyclerList *list,
+                                                 GtkWidget          *row,
+                                                 GtkTreeModel       *model,
+                                                 GtkTreeIter        *iter,
+                                                 gpointer            data);
+
+struct                                          _HildonRecyclerListClass
+{
+    GtkContainerClass parent_class;
+};
+
+struct                                          _HildonRecyclerList
+{
+    GtkContainer parent;
+
+    /* private */
+    HildonRecyclerListPrivate *priv;
+};
+
+GType
+hildon_recycler_list_get_type                   (void) G_GNUC_CONST;
+
+GtkWidget *
+hildon_recycler_list_new                        (GtkTreeModel *model,
+                                                 gint          row_height);
+
+void
+hildon_recycler_list_set_row_funcs              (HildonRecyclerList          *list,
+                                                 HildonRecyclerListCreateFunc create_func,
+                                                 HildonRecyclerListBindFunc   bind_func,
+                                                 gpointer                     data,
+                                                 GDestroyNotify               destroy);
+
+void
+hildon_recycler_list_set_model                  (HildonRecyclerList *list,
+                                                 GtkTreeModel       *model);
+
+GtkTreeModel *
+hildon_recycler_list_get_model                  (HildonRecyclerList *list);
+
+void
+hildon_recycler_list_set_row_height             (HildonRecyclerList *list,
+                                                 gint                row_height);
+
+gint
+hildon_recycler_list_get_row_height             (HildonRecyclerList *list);
+
+GtkWidget *
+hildon_recycler_list_get_row_widget             (HildonRecyclerList *list,
+                                                 GtkTreePath        *path);
+
+G_END_DECLS
+
+#endif /* __HILDON_RECYCLER_LIST_H__ */
@@ -0,0 +1,481 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2008 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-remote-texture-atlas
+ * @short_description: A shared memory area split between remote textures.
+ * @see_also: #HildonRemoteTexture
+ *
+ * The #HildonRemoteTextureAtlas lets an application that shows many
+ * small #HildonRemoteTexture<!-- -->s, like a home screen widget made of
+ * icons, keep all of them in a single shared memory area, instead of
+ * one page aligned segment per texture that hildon-desktop has to
+ * attach and bind separately.
+ *
+ * Each texture given to hildon_remote_texture_set_atlas() is handed a
+ * free rectangle of the atlas. The texture then shows the atlas offset
+ * to that rectangle, and its updates are reported to hildon-desktop as
+ * damage to the atlas, so only the pixels that changed are uploaded.
+ *
+ * <example>
+ * <title>Sharing an atlas between textures</title>
+ * <programlisting>
+ * atlas = hildon_remote_texture_atlas_new (512, 512, 4);
+ * <!-- -->
+ * for (i = 0; i < n_icons; i++)
+ * {
+ *     hildon_remote_texture_set_atlas (icons[i], atlas, 64, 64);
+ *     hildon_remote_texture_update_from_surface (icons[i],
+ *                                                hildon_remote_texture_atlas_get_data (atlas),
+ *                                                surfaces[i], 0, 0, 64, 64);
+ * }
+ * <!-- -->
+ * g_object_unref (atlas);
+ * </programlisting>
+ * </example>
+ *
+ * The textures hold a reference on the atlas, and the shared memory area
+ * is released once the last of them has let go of it.
+ */
+
+#include                                        <errno.h>
+#include                                        <sys/ipc.h>
+#include                                        <sys/shm.h>
+
+#include                                        "hildon-remote-texture-atlas.h"
+#include                                        "hildon-remote-texture-private.h"
+
+/* A run of free columns in a shelf */
+typedef struct
+{
+    guint x;
+    guint width;
+} HildonRemoteTextureAtlasSpan;
+
+/* A row of the atlas, as high as the first rectangle placed in it */
+typedef struct
+{
+    guint   y;
+    guint   height;
+    GArray *free;
+} HildonRemoteTextureAtlasShelf;
+
+struct                                          _HildonRemoteTextureAtlasPrivate
+{
+    key_t   key;
+    int     shm_id;
+    guchar *data;
+
+    guint   width;
+    guint   height;
+    guint   bpp;
+
+    GArray *shelves;
+};
+
+#define                                         HILDON_REMOTE_TEXTURE_ATLAS_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj),\
+                                                HILDON_TYPE_REMOTE_TEXTURE_ATLAS, HildonRemoteTextureAtlasPrivate))
+
+G_DEFINE_TYPE (HildonRemoteTextureAtlas, hildon_remote_texture_atlas, G_TYPE_OBJECT);
+
+static void
+hildon_remote_texture_atlas_finalize            (GObject *object)
+{
+    HildonRemoteTextureAtlasPrivate *priv = HILDON_REMOTE_TEXTURE_ATLAS (object)->priv;
+    guint i;
+
+    /* hildon-desktop may still have the segment attached; the kernel
+     * keeps it until it detaches as well. */
+
+    if (priv->data)
+    {
+        shmdt (priv->data);
+        shmctl (priv->shm_id, IPC_RMID, NULL);
+    }
+
+    for (i = 0; i < priv->shelves->len; i++)
+        g_array_free (g_array_index (priv->shelves, HildonRemoteTextureAtlasShelf, i).free, TRUE);
+    g_array_free (priv->shelves, TRUE);
+
+    G_OBJECT_CLASS (hildon_remote_texture_atlas_parent_class)->finalize (object);
+}
+
+static void
+hildon_remote_texture_atlas_class_init          (HildonRemoteTextureAtlasClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+    gobject_class->finalize = hildon_remote_texture_atlas_finalize;
+
+    g_type_class_add_private (klass, sizeof (HildonRemoteTextureAtlasPrivate));
+}
+
+static void
+hildon_remote_texture_atlas_init                (HildonRemoteTextureAtlas *self)
+{
+    HildonRemoteTextureAtlasPrivate *priv;
+
+    self->priv = priv = HILDON_REMOTE_TEXTURE_ATLAS_GET_PRIVATE (self);
+
+    priv->shelves = g_array_new (FALSE, FALSE, sizeof (HildonRemoteTextureAtlasShelf));
+}
+
+/**
+ * hildon_remote_texture_atlas_new:
+ * @width: width of the atlas in pixels
+ * @height: height of the atlas in pixels
+ * @bpp: BYTES per pixel - usually 2,3 or 4
+ *
+ * Allocates a shared memory area of @width by @height pixels, to be
+ * split between the remote textures given to
+ * hildon_remote_texture_set_atlas(). The area is only accessible to the
+ * user running the application.
+ *
+ * Return value: A new #HildonRemoteTextureAtlas, or %NULL if the shared
+ * memory area could not be allocated.
+ *
+ * Since: 3.0
+ **/
+HildonRemoteTextureAtlas *
+hildon_remote_texture_atlas_new                 (guint width,
+                                                 guint height,
+                                                 guint bpp)
+{
+    HildonRemoteTextureAtlas *atlas;
+    HildonRemoteTextureAtlasPrivate *priv;
+    gsize size = (gsize) width * height * bpp;
+    gpointer data;
+
+    g_return_val_if_fail (size > 0, NULL);
+
+    atlas = g_object_new (HILDON_TYPE_REMOTE_TEXTURE_ATLAS, NULL);
+    priv = atlas->priv;
+
+    priv->width = width;
+    priv->height = height;
+    priv->bpp = bpp;
+
+    /* hildon-desktop looks the segment up by key, so it can't be
+     * IPC_PRIVATE. Pick random keys until one is free. */
+
+    do
+    {
+        priv->key = g_random_int_range (1, G_MAXINT32);
+        priv->shm_id = shmget (priv->key, size, IPC_CREAT | IPC_EXCL | 0600);
+    }
+    while (priv->shm_id == -1 && errno == EEXIST);
+
+    if (priv->shm_id == -1)
+    {
+        g_warning ("%s: could not allocate a shared memory area: %s",
+                   G_STRFUNC, g_strerror (errno));
+        g_object_unref (atlas);
+        return NULL;
+    }
+
+    data = shmat (priv->shm_id, NULL, 0);
+
+    if (data == (gpointer) -1)
+    {
+        g_warning ("%s: could not attach a shared memory area: %s",
+                   G_STRFUNC, g_strerror (errno));
+        shmctl (priv->shm_id, IPC_RMID, NULL);
+        g_object_unref (atlas);
+        return NULL;
+    }
+
+    priv->data = data;
+
+    return atlas;
+}
+
+/**
+ * hildon_remote_texture_atlas_get_key:
+ * @atlas: A #HildonRemoteTextureAtlas
+ *
+ * Gets the key hildon-desktop looks the shared memory area of @atlas
+ * up with.
+ *
+ * Return value: the key of the shared memory area
+ *
+ * Since: 3.0
+ **/
+key_t
+hildon_remote_texture_atlas_get_key             (HildonRemoteTextureAtlas *atlas)
+{
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE_ATLAS (atlas), 0);
+
+    return atlas->priv->key;
+}
+
+/**
+ * hildon_remote_texture_atlas_get_data:
+ * @atlas: A #HildonRemoteTextureAtlas
+ *
+ * Gets the pixels of @atlas. Its rows are
+ * hildon_remote_texture_atlas_get_rowstride() bytes long, and each
+ * texture draws into its own rectangle of them, as given by
+ * hildon_remote_texture_get_atlas_area().
+ *
+ * Return value: the shared memory area of @atlas
+ *
+ * Since: 3.0
+ **/
+guchar *
+hildon_remote_texture_atlas_get_data            (HildonRemoteTextureAtlas *atlas)
+{
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE_ATLAS (atlas), NULL);
+
+    return atlas->priv->data;
+}
+
+/**
+ * hildon_remote_texture_atlas_get_size:
+ * @atlas: A #HildonRemoteTextureAtlas
+ * @width: (out) (allow-none): return location for the width, or %NULL
+ * @height: (out) (allow-none): return location for the height, or %NULL
+ *
+ * Gets the size of @atlas in pixels.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_remote_texture_atlas_get_size            (HildonRemoteTextureAtlas *atlas,
+                                                 guint                    *width,
+                                                 guint                    *height)
+{
+    g_return_if_fail (HILDON_IS_REMOTE_TEXTURE_ATLAS (atlas));
+
+    if (width)
+        *width = atlas->priv->width;
+    if (height)
+        *height = atlas->priv->height;
+}
+
+/**
+ * hildon_remote_texture_atlas_get_bpp:
+ * @atlas: A #HildonRemoteTextureAtlas
+ *
+ * Gets the number of bytes per pixel of @atlas.
+ *
+ * Return value: the bytes per pixel of @atlas
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_remote_texture_atlas_get_bpp             (HildonRemoteTextureAtlas *atlas)
+{
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE_ATLAS (atlas), 0);
+
+    return atlas->priv->bpp;
+}
+
+/**
+ * hildon_remote_texture_atlas_get_rowstride:
+ * @atlas: A #HildonRemoteTextureAtlas
+ *
+ * Gets the distance in bytes between the rows of
+ * hildon_remote_texture_atlas_get_data().
+ *
+ * Return value: the rowstride of @atlas
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_remote_texture_atlas_get_rowstride       (HildonRemoteTextureAtlas *atlas)
+{
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE_ATLAS (atlas), 0);
+
+    return atlas->priv->width * atlas->priv->bpp;
+}
+
+/* Takes the first free span of @shelf at least @width wide, returning
+ * FALSE if there is none */
+static gboolean
+hildon_remote_texture_atlas_shelf_take          (HildonRemoteTextureAtlasShelf *shelf,
+                                                 guint                          width,
+                                                 guint                         *x)
+{
+    guint i;
+
+    for (i = 0; i < shelf->free->len; i++)
+    {
+        HildonRemoteTextureAtlasSpan *span =
+            &g_array_index (shelf->free, HildonRemoteTextureAtlasSpan, i);
+
+        if (span->width < width)
+            continue;
+
+        *x = span->x;
+        span->x += width;
+        span->width -= width;
+        if (span->width == 0)
+            g_array_remove_index (shelf->free, i);
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*
+ * Finds room for a @width by @height rectangle in @atlas. Rectangles
+ * go into the lowest shelf that fits them and wastes the fewest rows;
+ * a new shelf is only opened below the others when none does.
+ */
+gboolean
+hildon_remote_texture_atlas_alloc               (HildonRemoteTextureAtlas *atlas,
+                                                 guint                     width,
+                                                 guint                     height,
+                                                 cairo_rectangle_int_t    *area)
+{
+    HildonRemoteTextureAtlasPrivate *priv = atlas->priv;
+    HildonRemoteTextureAtlasShelf *best = NULL;
+    HildonRemoteTextureAtlasShelf shelf;
+    guint bottom = 0;
+    guint x, i;
+
+    if (width == 0 || height == 0 || width > priv->width || height > priv->height)
+        return FALSE;
+
+    for (i = 0; i < priv->shelves->len; i++)
+    {
+        HildonRemoteTextureAtlasShelf *s =
+            &g_array_index (priv->shelves, HildonRemoteTextureAtlasShelf, i);
+        guint j;
+
+        bottom = s->y + s->height;
+
+        if (s->height < height || (best && best->height <= s->height))
+            continue;
+
+        for (j = 0; j < s->free->len; j++)
+            if (g_array_index (s->free, HildonRemoteTextureAtlasSpan, j).width >= width)
+            {
+                best = s;
+                break;
+            }
+    }
+
+    if (best)
+    {
+        hildon_remote_texture_atlas_shelf_take (best, width, &x);
+        area->x = x;
+        area->y = best->y;
+    }
+    else
+    {
+        HildonRemoteTextureAtlasSpan span = { width, priv->width - width };
+
+        if (priv->height - bottom < height)
+            return FALSE;
+
+        shelf.y = bottom;
+        shelf.height = height;
+        shelf.free = g_array_new (FALSE, FALSE, sizeof (HildonRemoteTextureAtlasSpan));
+        if (span.width > 0)
+            g_array_append_val (shelf.free, span);
+        g_array_append_val (priv->shelves, shelf);
+
+        area->x = 0;
+        area->y = bottom;
+    }
+
+    area->width = width;
+    area->height = height;
+
+    return TRUE;
+}
+
+/*
+ * Gives back a rectangle returned by hildon_remote_texture_atlas_alloc().
+ * The shelves left empty at the bottom of the atlas are dropped, so
+ * their rows can be cut into shelves of another height.
+ */
+void
+hildon_remote_texture_atlas_free                (HildonRemoteTextureAtlas    *atlas,
+                                                 const cairo_rectangle_int_t *area)
+{
+    HildonRemoteTextureAtlasPrivate *priv = atlas->priv;
+    HildonRemoteTextureAtlasShelf *shelf = NULL;
+    HildonRemoteTextureAtlasSpan span = { area->x, area->width };
+    GArray *free_spans;
+    guint i;
+
+    for (i = 0; i < priv->shelves->len; i++)
+    {
+        shelf = &g_array_index (priv->shelves, HildonRemoteTextureAtlasShelf, i);
+        if (shelf->y == (guint) area->y)
+            break;
+    }
+
+    g_return_if_fail (i < priv->shelves->len);
+
+    /* Insert the span in order, joining it with its free neighbours */
+
+    free_spans = shelf->free;
+
+    for (i = 0; i < free_spans->len; i++)
+        if (g_array_index (free_spans, HildonRemoteTextureAtlasSpan, i).x > span.x)
+            break;
+
+    if (i < free_spans->len)
+    {
+        HildonRemoteTextureAtlasSpan *next =
+            &g_array_index (free_spans, HildonRemoteTextureAtlasSpan, i);
+
+        if (span.x + span.width == next->x)
+        {
+            span.width += next->width;
+            g_array_remove_index (free_spans, i);
+        }
+    }
+
+    if (i > 0)
+    {
+        HildonRemoteTextureAtlasSpan *prev =
+            &g_array_index (free_spans, HildonRemoteTextureAtlasSpan, i - 1);
+
+        if (prev->x + prev->width == span.x)
+        {
+            prev->width += span.width;
+            span.width = 0;
+        }
+    }
+
+    if (span.width > 0)
+        g_array_insert_val (free_spans, i, span);
+
+    while (priv->shelves->len > 0)
+    {
+        shelf = &g_array_index (priv->shelves, HildonRemoteTextureAtlasShelf,
+                                priv->shelves->len - 1);
+
+        if (shelf->free->len != 1 ||
+            g_array_index (shelf->free, HildonRemoteTextureAtlasSpan, 0).width != priv->width)
+            break;
+
+        g_array_free (shelf->free, TRUE);
+        g_array_remove_index (priv->shelves, priv->shelves->len - 1);
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2008 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_REMOTE_TEXTURE_ATLAS_H__
+#define                                         __HILDON_REMOTE_TEXTURE_ATLAS_H__
+
+#include                                        <glib-object.h>
+#include                                        <sys/types.h>
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_REMOTE_TEXTURE_ATLAS \
+                                                (hildon_remote_texture_atlas_get_type())
+
+#define                                         HILDON_REMOTE_TEXTURE_ATLAS(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_REMOTE_TEXTURE_ATLAS, \
+                                                HildonRemoteTextureAtlas))
+
+#define                                         HILDON_REMOTE_TEXTURE_ATLAS_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                                HILDON_TYPE_REMOTE_TEXTURE_ATLAS, \
+                                                HildonRemoteTextureAtlasClass))
+
+#define                                         HILDON_IS_REMOTE_TEXTURE_ATLAS(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                                                HILDON_TYPE_REMOTE_TEXTURE_ATLAS))
+
+#define                                         HILDON_IS_REMOTE_TEXTURE_ATLAS_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+                                                HILDON_TYPE_REMOTE_TEXTURE_ATLAS))
+
+#define                                         HILDON_REMOTE_TEXTURE_ATLAS_GET_CLASS(obj) \
+                                                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                                HILDON_TYPE_REMOTE_TEXTURE_ATLAS, \
+                                                HildonRemoteTextureAtlasClass))
+
+typedef struct                                  _HildonRemoteTextureAtlas HildonRemoteTextureAtlas;
+typedef struct                                  _HildonRemoteTextureAtlasClass HildonRemoteTextureAtlasClass;
+typedef struct                                  _HildonRemoteTextureAtlasPrivate HildonRemoteTextureAtlasPrivate;
+
+struct                                          _HildonRemoteTextureAtlas
+{
+    GObject parent;
+
+    /* private */
+    HildonRemoteTextureAtlasPrivate *priv;
+};
+
+struct                                          _HildonRemoteTextureAtlasClass
+{
+    GObjectClass parent_class;
+
+    /* Padding for future extension */
+    void (*_hildon_reserved1)(void);
+    void (*_hildon_reserved2)(void);
+    void (*_hildon_reserved3)(void);
+    void (*_hildon_reserved4)(void);
+};
+
+GType
+hildon_remote_texture_atlas_get_type            (void) G_GNUC_CONST;
+
+HildonRemoteTextureAtlas *
+hildon_remote_texture_atlas_new                 (guint                     width,
+                                                 guint                     height,
+                                                 guint                     bpp);
+
+key_t
+hildon_remote_texture_atlas_get_key             (HildonRemoteTextureAtlas *atlas);
+
+guchar *
+hildon_remote_texture_atlas_get_data            (HildonRemoteTextureAtlas *atlas);
+
+void
+hildon_remote_texture_atlas_get_size            (HildonRemoteTextureAtlas *atlas,
+                                                 guint                    *width,
+                                                 guint                    *height);
+
+guint
+hildon_remote_texture_atlas_get_bpp             (HildonRemoteTextureAtlas *atlas);
+
+guint
+hildon_remote_texture_atlas_get_rowstride       (HildonRemoteTextureAtlas *atlas);
+
+G_END_DECLS
+
+#endif /* __HILDON_REMOTE_TEXTURE_ATLAS_H__ */
@@ -29,6 +29,8 @@
 #include <gtk/gtk.h>
 #include <sys/types.h>
 
+#include "hildon-remote-texture-atlas.h"
+
 G_BEGIN_DECLS
 
 typedef struct                                  _HildonRemoteTexturePrivate HildonRemoteTexturePrivate;
@@ -37,6 +39,32 @@ typedef struct                                  _HildonRemoteTexturePrivate Hild
                                                 (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
                                                 HILDON_TYPE_REMOTE_TEXTURE, HildonRemoteTexturePrivate));
 
+#define                                         HILDON_REMOTE_TEXTURE_MAX_BUFFERS 3
+
+/* Damage is sent as at most this many rectangles per frame */
+#define                                         HILDON_REMOTE_TEXTURE_MAX_DAMAGE_RECTS 8
+
+/* A shared memory segment of the buffer ring */
+typedef struct
+{
+    key_t   key;
+    int     shm_id;
+    guchar *data;
+} HildonRemoteTextureBuffer;
+
+/* Messages whose last sent arguments are remembered, so that
+ * resending the same values can be skipped */
+typedef enum
+{
+    HILDON_RT_SENT_SHM,
+    HILDON_RT_SENT_SHOW,
+    HILDON_RT_SENT_POSITION,
+    HILDON_RT_SENT_OFFSET,
+    HILDON_RT_SENT_SCALE,
+    HILDON_RT_SENT_PARENT,
+    HILDON_RT_N_SENT
+} HildonRemoteTextureSentMessage;
+
 struct                                          _HildonRemoteTexturePrivate
 {
     guint   ready : 1;
@@ -49,15 +77,15 @@ struct                                          _HildonRemoteTexturePrivate
     guint   set_scale : 1;
     guint   set_parent : 1;
 
+    guint   batch_depth;
+
     key_t   shm_key;
     guint   shm_width;
     guint   shm_height;
     guint   shm_bpp;
 
-    gint    damage_x1;
-    gint    damage_y1;
-    gint    damage_x2;
-    gint    damage_y2;
+    cairo_region_t *damage;
+    guint   damage_tick_id;
 
     guint   show;
     guint   opacity;
@@ -69,6 +97,10 @@ struct                                          _HildonRemoteTexturePrivate
 
     double   offset_x;
     double   offset_y;
+    guint   offset_tick_id;
+
+    GtkAdjustment *pan_hadjustment;
+    GtkAdjustment *pan_vadjustment;
 
     double  scale_x;
     double  scale_y;
@@ -76,9 +108,32 @@ struct                                          _HildonRemoteTexturePrivate
     GtkWindow* parent;
     gulong  parent_map_event_cb_id;
 
-    gulong  map_event_cb_id;
+    guint32 sent[HILDON_RT_N_SENT][5];
+    guint   sent_valid;
+    guint   threaded;
+
+    HildonRemoteTextureBuffer buffers[HILDON_REMOTE_TEXTURE_MAX_BUFFERS];
+    guint   n_buffers;
+    guint   buffer_width;
+    guint   buffer_height;
+    guint   buffer_bpp;
+    gint    acquired_buffer;
+    gint    presented_buffer;
+
+    HildonRemoteTextureAtlas *atlas;
+    cairo_rectangle_int_t atlas_area;
 };
 
+gboolean G_GNUC_INTERNAL
+hildon_remote_texture_atlas_alloc               (HildonRemoteTextureAtlas *atlas,
+                                                 guint                     width,
+                                                 guint                     height,
+                                                 cairo_rectangle_int_t    *area);
+
+void G_GNUC_INTERNAL
+hildon_remote_texture_atlas_free                (HildonRemoteTextureAtlas    *atlas,
+                                                 const cairo_rectangle_int_t *area);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_REMOTE_TEXTURE_PRIVATE_H__ */
@@ -30,22 +30,43 @@
  * The #HildonRemoteTexture is a GTK+ widget which allows the rendering of
  * a shared memory area within hildon-desktop. It allows the memory area to
  * be positioned and scaled, without altering its' contents.
+ *
+ * The memory area can be provided by the application with
+ * hildon_remote_texture_set_image(), or allocated by the widget as a ring
+ * of buffers with hildon_remote_texture_set_buffers(). With a ring, the
+ * application draws each frame into the buffer returned by
+ * hildon_remote_texture_acquire_buffer() and hands it over with
+ * hildon_remote_texture_present_buffer(), while hildon-desktop is still
+ * reading the previously presented frames.
+ *
+ * A producer whose frames are larger than the area they are shown in,
+ * like a camera preview, can size the ring after
+ * hildon_remote_texture_get_display_size() and hand its full size frames
+ * to hildon_remote_texture_present_scaled(). They are then reduced
+ * while being copied into the shared memory area, so hildon-desktop only
+ * has to upload the pixels that are actually displayed.
+ *
+ * Many small textures can also share the shared memory area of a
+ * #HildonRemoteTextureAtlas, each one being given its own rectangle of
+ * it with hildon_remote_texture_set_atlas().
  */
 
+#include                                        <errno.h>
+#include                                        <string.h>
+#include                                        <sys/ipc.h>
+#include                                        <sys/shm.h>
 #include                                        <gdk/gdkx.h>
 #include                                        <X11/Xatom.h>
 
 #include                                        "hildon-remote-texture.h"
 #include                                        "hildon-remote-texture-private.h"
+#include                                        "hildon-private.h"
 
 G_DEFINE_TYPE (HildonRemoteTexture, hildon_remote_texture, GTK_TYPE_WINDOW);
 
-static GdkFilterReturn
-hildon_remote_texture_event_filter (GdkXEvent *xevent,
-                                     GdkEvent *event,
-                                     gpointer data);
 static void
-hildon_remote_texture_update_ready (HildonRemoteTexture *self);
+hildon_remote_texture_ready_changed (GtkWidget *widget,
+                                     gboolean ready);
 static void
 hildon_remote_texture_send_pending_messages (HildonRemoteTexture *self);
 static void
@@ -54,10 +75,12 @@ static gboolean
 hildon_remote_texture_parent_map_event (GtkWidget *parent,
 					 GdkEvent *event,
 					 gpointer user_data);
-static gboolean
-hildon_remote_texture_map_event (GtkWidget *widget,
-				  GdkEvent *event,
-				  gpointer user_data);
+static void
+hildon_remote_texture_free_buffers (HildonRemoteTexture *self);
+static void
+hildon_remote_texture_send_damage (HildonRemoteTexture *self);
+static void
+hildon_remote_texture_release_atlas (HildonRemoteTexture *self);
 
 static guint32 shm_atom;
 static guint32 damage_atom;
@@ -66,7 +89,6 @@ static guint32 position_atom;
 static guint32 offset_atom;
 static guint32 scale_atom;
 static guint32 parent_atom;
-static guint32 ready_atom;
 
 static gboolean atoms_initialized = FALSE;
 
@@ -116,9 +138,6 @@ hildon_remote_texture_realize                 (GtkWidget *widget)
 	parent_atom =
 	    gdk_x11_get_xatom_by_name_for_display
 	    (display, "_HILDON_TEXTURE_CLIENT_MESSAGE_PARENT");
-	ready_atom =
-	    gdk_x11_get_xatom_by_name_for_display
-	    (display, "_HILDON_TEXTURE_CLIENT_READY");
 #if 0
 	g_debug ("shm atom = %lu\n", shm_atom);
 	g_debug ("damage atom = %lu\n", damage_atom);
@@ -127,7 +146,6 @@ hildon_remote_texture_realize                 (GtkWidget *widget)
 	g_debug ("offset atom = %lu\n", offset_atom);
 	g_debug ("scale atom = %lu\n", scale_atom);
 	g_debug ("parent atom = %lu\n", parent_atom);
-	g_debug ("ready atom = %lu\n", ready_atom);
 #endif
 
 	atoms_initialized = TRUE;
@@ -135,17 +153,20 @@ hildon_remote_texture_realize                 (GtkWidget *widget)
 
     /* Wait for a ready message */
 
-    gdk_window_add_filter (gtk_widget_get_window (widget),
-			   hildon_remote_texture_event_filter,
-			   widget);
+    hildon_watch_ready (widget, "_HILDON_TEXTURE_CLIENT_READY",
+			hildon_remote_texture_ready_changed);
 }
 
 static void
 hildon_remote_texture_unrealize               (GtkWidget *widget)
 {
-    gdk_window_remove_filter (gtk_widget_get_window (widget),
-			      hildon_remote_texture_event_filter,
-			      widget);
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (widget);
+
+    priv->sent_valid = 0;
+    priv->threaded = 0;
+
+    hildon_unwatch_ready (widget);
 
     GTK_WIDGET_CLASS (hildon_remote_texture_parent_class)->unrealize (widget);
 }
@@ -183,6 +204,26 @@ hildon_remote_texture_finalize                (GObject *object)
 
         g_object_unref (priv->parent);
     }
+
+    hildon_remote_texture_free_buffers (self);
+
+    if (priv->atlas)
+    {
+        hildon_remote_texture_atlas_free (priv->atlas, &priv->atlas_area);
+        g_object_unref (priv->atlas);
+    }
+
+    hildon_remote_texture_set_pannable_area (self, NULL);
+
+    if (priv->damage_tick_id)
+        gtk_widget_remove_tick_callback (GTK_WIDGET (self),
+                                         priv->damage_tick_id);
+    if (priv->offset_tick_id)
+        gtk_widget_remove_tick_callback (GTK_WIDGET (self),
+                                         priv->offset_tick_id);
+    cairo_region_destroy (priv->damage);
+
+    G_OBJECT_CLASS (hildon_remote_texture_parent_class)->finalize (object);
 }
 
 static void
@@ -212,6 +253,11 @@ hildon_remote_texture_init                    (HildonRemoteTexture *self)
     priv->scale_x = 1;
     priv->scale_y = 1;
     priv->opacity = 0xff;
+
+    priv->acquired_buffer = -1;
+    priv->presented_buffer = -1;
+
+    priv->damage = cairo_region_create ();
 }
 
 /**
@@ -234,76 +280,19 @@ hildon_remote_texture_new                     (void)
 }
 
 /*
- * An filter for GDK X11 events, waiting for PropertyNotify (window property
- * changes) events, keeping track of remote texture ready atom.
- * Having the ready atom set on the window by the window manager will trigger
- * updates of actor parameters (position/rotation/etc...) to be sent off
- * to the window manager for processing.
- */
-static GdkFilterReturn
-hildon_remote_texture_event_filter             (GdkXEvent *xevent,
-						 GdkEvent *event,
-						 gpointer data)
-{
-    HildonRemoteTexture *self = HILDON_REMOTE_TEXTURE (data);
-    XAnyEvent *any = xevent;
-
-    if (any->type == PropertyNotify)
-    {
-	XPropertyEvent *property = xevent;
-
-	if (property->atom == ready_atom)
-	{
-	    hildon_remote_texture_update_ready (self);
-	}
-    }
-
-    return GDK_FILTER_CONTINUE;
-}
-
-/*
- * Check for the ready atom on the remote texture X11 window.
- * If present, send all pending remote texture messages to the
- * window manager.
+ * Called with the state of the ready property, which the window manager
+ * sets on the remote texture window once it is ready for its messages.
+ * Becoming ready sends off all the pending messages.
  */
 static void
-hildon_remote_texture_update_ready (HildonRemoteTexture *self)
+hildon_remote_texture_ready_changed (GtkWidget *widget,
+                                     gboolean ready)
 {
+    HildonRemoteTexture *self = HILDON_REMOTE_TEXTURE (widget);
     HildonRemoteTexturePrivate
 	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
-    GtkWidget          *widget = GTK_WIDGET (self);
-    Display            *display = GDK_WINDOW_XDISPLAY (gtk_widget_get_window (widget));
-    Window              window = GDK_WINDOW_XID (gtk_widget_get_window (widget));
-
-    int status;
-    gint xerror;
-
-    Atom actual_type;
-    int  actual_format;
-    unsigned long nitems, bytes_after;
-    unsigned char *prop = NULL;
-
-    /* Check for the "ready" property */
-
-    gdk_error_trap_push ();
-    status = XGetWindowProperty (display, window,
-				 ready_atom, 0, 32,
-				 False, XA_ATOM,
-				 &actual_type, &actual_format,
-				 &nitems, &bytes_after, &prop);
-    xerror = gdk_error_trap_pop();
-
-    if (prop)
-    {
-	/* We do not actually use the property value for anything,
-	 * it is enough that the property is set. */
-
-	XFree (prop);
-    }
 
-    if (xerror ||
-	(status != Success) || (actual_type != XA_ATOM) ||
-       	(actual_format != 32) || (nitems != 1))
+    if (!ready)
     {
 	priv->ready = 0;
 	return;
@@ -312,26 +301,17 @@ hildon_remote_texture_update_ready (HildonRemoteTexture *self)
     if (priv->ready)
     {
 	/* The ready flag has been set once already. This means that
-	 * the WM has restarted. Trigger re-mapping of the widget to
-	 * update the texture actor first. Then push all remote
-	 * texture settings anew. */
+	 * the WM has restarted and lost the state of the remote texture:
+	 * push all of its settings anew. */
 
-	priv->map_event_cb_id =
-	    g_signal_connect (G_OBJECT (self),
-			      "map-event",
-			      G_CALLBACK(hildon_remote_texture_map_event),
-			      self);
-
-	if (gtk_widget_get_mapped (GTK_WIDGET (self)))
-	{
-	    gtk_widget_unmap (GTK_WIDGET (self));
-	    gtk_widget_map (GTK_WIDGET (self));
-	}
+	hildon_queue_resync (widget,
+			     (HildonResyncFunc) hildon_remote_texture_send_all_messages);
 
 	return;
     }
 
     priv->ready = 1;
+    priv->sent_valid = 0;
 
     /* Send all pending messages */
 
@@ -351,11 +331,7 @@ hildon_remote_texture_send_pending_messages (HildonRemoteTexture *self)
                                       priv->shm_bpp);
 
     if (priv->set_damage)
-      hildon_remote_texture_update_area (self,
-                                         priv->damage_x1,
-                                         priv->damage_y1,
-                                         priv->damage_x2 - priv->damage_x1,
-                                         priv->damage_y2 - priv->damage_y1);
+      hildon_remote_texture_send_damage (self);
 
     if (priv->set_position)
 	hildon_remote_texture_set_position (self,
@@ -389,8 +365,20 @@ hildon_remote_texture_send_all_messages (HildonRemoteTexture *self)
     HildonRemoteTexturePrivate
 	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
 
+    /* The window manager lost the state of the texture, resend everything */
+
+    priv->sent_valid = 0;
+
     priv->set_shm = 1;
-    priv->set_damage = 1;
+    if (priv->shm_width && priv->shm_height)
+    {
+        cairo_rectangle_int_t all = { 0, 0, priv->shm_width, priv->shm_height };
+
+        if (priv->atlas)
+            all = priv->atlas_area;
+        cairo_region_union_rectangle (priv->damage, &all);
+        priv->set_damage = 1;
+    }
     priv->set_position = 1;
     priv->set_scale = 1;
     priv->set_parent = 1;
@@ -401,6 +389,41 @@ hildon_remote_texture_send_all_messages (HildonRemoteTexture *self)
 
 /* ------------------------------------------------------------- */
 
+/* Messages setting a state give its @slot, or -1, so that the next
+ * message for the same state replaces them, see hildon_compositor_send() */
+static void
+hildon_remote_texture_queue_message (HildonRemoteTexture *self,
+                                    guint32 message_type,
+                                    gint slot,
+                                    guint32 l0,
+                                    guint32 l1,
+                                    guint32 l2,
+                                    guint32 l3,
+                                    guint32 l4)
+{
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    HILDON_PERF (REMOTE_TEXTURE_MESSAGES);
+    HILDON_PROBE2 (remote_texture__send__message, self, message_type);
+
+    /* Until the window manager was told to show or hide the window,
+     * its messages go out on the connection of GDK, after the requests
+     * that create and map the windows they refer to, and in order with
+     * each other, so that the first frame has the whole state. Later
+     * ones may go through the compositor thread */
+    if (priv->threaded) {
+        hildon_compositor_send (GTK_WIDGET (self), message_type, slot,
+                                l0, l1, l2, l3, l4);
+        return;
+    }
+
+    hildon_compositor_send_direct (GTK_WIDGET (self), message_type,
+                                   l0, l1, l2, l3, l4);
+    if (slot == HILDON_RT_SENT_SHOW)
+        priv->threaded = 1;
+}
+
 /**
  * hildon_remote_texture_send_message:
  * @self: A #HildonRemoteTexture
@@ -429,32 +452,41 @@ hildon_remote_texture_send_message (HildonRemoteTexture *self,
                                      guint32 l3,
                                      guint32 l4)
 {
-    GtkWidget          *widget = GTK_WIDGET (self);
-    Display            *display = GDK_WINDOW_XDISPLAY (gtk_widget_get_window (widget));
-    Window              window = GDK_WINDOW_XID (gtk_widget_get_window (widget));
+    hildon_remote_texture_queue_message (self, message_type, -1, l0, l1, l2, l3, l4);
+}
 
-    XEvent event = { 0 };
+/*
+ * Sends a message to the window manager, unless @slot holds the same
+ * arguments from the previous message of that kind: the window manager
+ * already has that state, and resending it would only cost X traffic.
+ */
+static void
+hildon_remote_texture_send_property (HildonRemoteTexture *self,
+                                     HildonRemoteTextureSentMessage slot,
+                                     guint32 message_type,
+                                     guint32 l0,
+                                     guint32 l1,
+                                     guint32 l2,
+                                     guint32 l3,
+                                     guint32 l4)
+{
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+    guint32 *sent = priv->sent[slot];
 
-    event.xclient.type = ClientMessage;
-    event.xclient.window = window;
-    event.xclient.message_type = (Atom)message_type;
-    event.xclient.format = 32;
-    event.xclient.data.l[0] = l0;
-    event.xclient.data.l[1] = l1;
-    event.xclient.data.l[2] = l2;
-    event.xclient.data.l[3] = l3;
-    event.xclient.data.l[4] = l4;
+    if ((priv->sent_valid & (1 << slot)) &&
+	sent[0] == l0 && sent[1] == l1 && sent[2] == l2 &&
+	sent[3] == l3 && sent[4] == l4)
+	return;
 
-#if 0
-    g_debug ("%lu (%lu %lu %lu %lu %lu) -> %lu\n",
-             message_type,
-             l0, l1, l2, l3, l4,
-             window);
-#endif
+    sent[0] = l0;
+    sent[1] = l1;
+    sent[2] = l2;
+    sent[3] = l3;
+    sent[4] = l4;
+    priv->sent_valid |= 1 << slot;
 
-    XSendEvent (display, window, True,
-                StructureNotifyMask,
-                (XEvent *)&event);
+    hildon_remote_texture_queue_message (self, message_type, slot, l0, l1, l2, l3, l4);
 }
 
 /**
@@ -467,6 +499,9 @@ hildon_remote_texture_send_message (HildonRemoteTexture *self,
  * @height: height of image in pixels
  * @bpp: BYTES per pixel - usually 2,3 or 4
  *
+ * Setting another image than the #HildonRemoteTextureAtlas of the
+ * texture gives its rectangle of the atlas back.
+ *
  * Since: 2.2
  */
 void
@@ -480,29 +515,137 @@ hildon_remote_texture_set_image (HildonRemoteTexture *self,
                        *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
   GtkWidget          *widget = GTK_WIDGET (self);
 
+  if (priv->atlas && key != hildon_remote_texture_atlas_get_key (priv->atlas))
+    hildon_remote_texture_release_atlas (self);
+
   priv->set_shm = 1;
   priv->shm_key = key;
   priv->shm_width = width;
   priv->shm_height = height;
   priv->shm_bpp = bpp;
 
-  if (gtk_widget_get_mapped (widget) && priv->ready)
+  if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
        /* Defer messages until the remote texture is parented
         * and the parent window is mapped */
         if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
             return;
-        hildon_remote_texture_send_message (self,
-                                            shm_atom,
-                                            priv->shm_key,
-                                            priv->shm_width,
-                                            priv->shm_height,
-                                            priv->shm_bpp,
-                                            0);
+        hildon_remote_texture_send_property (self, HILDON_RT_SENT_SHM,
+                                             shm_atom,
+                                             priv->shm_key,
+                                             priv->shm_width,
+                                             priv->shm_height,
+                                             priv->shm_bpp,
+                                             0);
         priv->set_shm = 0;
     }
 }
 
+/*
+ * Merges the damage rectangles down to at most
+ * HILDON_REMOTE_TEXTURE_MAX_DAMAGE_RECTS, each time joining the pair
+ * whose bounding box adds the least undamaged area.
+ */
+static gint
+hildon_remote_texture_simplify_damage (cairo_rectangle_int_t *rects,
+                                       gint n_rects)
+{
+    while (n_rects > HILDON_REMOTE_TEXTURE_MAX_DAMAGE_RECTS)
+    {
+        gint64 best_waste = G_MAXINT64;
+        gint best_i = 0, best_j = 1;
+        gint i, j;
+
+        for (i = 0; i < n_rects; i++)
+            for (j = i + 1; j < n_rects; j++)
+            {
+                gint x1 = MIN (rects[i].x, rects[j].x);
+                gint y1 = MIN (rects[i].y, rects[j].y);
+                gint x2 = MAX (rects[i].x + rects[i].width,
+                               rects[j].x + rects[j].width);
+                gint y2 = MAX (rects[i].y + rects[i].height,
+                               rects[j].y + rects[j].height);
+                gint64 waste = (gint64) (x2 - x1) * (y2 - y1)
+                    - (gint64) rects[i].width * rects[i].height
+                    - (gint64) rects[j].width * rects[j].height;
+
+                if (waste < best_waste)
+                {
+                    best_waste = waste;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+
+        gdk_rectangle_union (&rects[best_i], &rects[best_j], &rects[best_i]);
+        rects[best_j] = rects[--n_rects];
+    }
+
+    return n_rects;
+}
+
+/*
+ * Sends the damage accumulated since the last frame, if the window
+ * manager can take it now; otherwise it stays pending.
+ */
+static void
+hildon_remote_texture_send_damage (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+    GtkWidget          *widget = GTK_WIDGET (self);
+    cairo_rectangle_int_t *rects;
+    gint n_rects, i;
+
+    if (!gtk_widget_get_mapped (widget) || !priv->ready || priv->batch_depth)
+        return;
+
+    /* Defer messages until the remote texture is parented
+     * and the parent window is mapped */
+    if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
+        return;
+
+    n_rects = cairo_region_num_rectangles (priv->damage);
+    rects = g_new (cairo_rectangle_int_t, n_rects);
+
+    for (i = 0; i < n_rects; i++)
+        cairo_region_get_rectangle (priv->damage, i, &rects[i]);
+
+    n_rects = hildon_remote_texture_simplify_damage (rects, n_rects);
+
+    for (i = 0; i < n_rects; i++)
+        hildon_remote_texture_send_message (self,
+                                            damage_atom,
+                                            rects[i].x,
+                                            rects[i].y,
+                                            rects[i].width,
+                                            rects[i].height,
+                                            0);
+
+    g_free (rects);
+
+    cairo_region_destroy (priv->damage);
+    priv->damage = cairo_region_create ();
+    priv->set_damage = 0;
+}
+
+static gboolean
+hildon_remote_texture_damage_tick (GtkWidget *widget,
+                                   GdkFrameClock *frame_clock,
+                                   gpointer user_data)
+{
+    HildonRemoteTexture *self = HILDON_REMOTE_TEXTURE (widget);
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    priv->damage_tick_id = 0;
+
+    if (priv->set_damage)
+        hildon_remote_texture_send_damage (self);
+
+    return G_SOURCE_REMOVE;
+}
+
 /**
  * hildon_remote_texture_update_area:
  * @self: A #HildonRemoteTexture
@@ -515,6 +658,14 @@ hildon_remote_texture_set_image (HildonRemoteTexture *self,
  * has changed. This will trigger a redraw and will update the relevant tiles
  * of the texture.
  *
+ * The areas damaged during a frame are accumulated and sent together on
+ * the next tick of the widget's frame clock, merged into a few
+ * rectangles, so many small updates cost neither many messages nor one
+ * upload of their whole bounding box.
+ *
+ * If the texture is in a #HildonRemoteTextureAtlas, the area is relative
+ * to the rectangle of the texture, and is clipped to it.
+ *
  * Since: 2.2
  */
 void
@@ -527,42 +678,31 @@ hildon_remote_texture_update_area (HildonRemoteTexture *self,
   HildonRemoteTexturePrivate
                      *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
   GtkWidget          *widget = GTK_WIDGET (self);
+  cairo_rectangle_int_t area = { x, y, width, height };
 
-  if (priv->damage_x1==priv->damage_x2 || priv->damage_y1==priv->damage_y2)
-    {
-      priv->damage_x1 = x;
-      priv->damage_y1 = y;
-      priv->damage_x2 = x+width;
-      priv->damage_y2 = y+height;
-    }
-  else
+  if (width <= 0 || height <= 0)
+    return;
+
+  /* hildon-desktop only knows of the atlas, damage its rectangle */
+
+  if (priv->atlas)
     {
-      if (x<priv->damage_x1) priv->damage_x1 = x;
-      if (y<priv->damage_y1) priv->damage_y1 = y;
-      if (x+width>priv->damage_x2) priv->damage_x2 = x+width;
-      if (y+height>priv->damage_y2) priv->damage_y2 = y+height;
+      area.x += priv->atlas_area.x;
+      area.y += priv->atlas_area.y;
+      if (!gdk_rectangle_intersect (&area, &priv->atlas_area, &area))
+        return;
     }
+
+  cairo_region_union_rectangle (priv->damage, &area);
   priv->set_damage = 1;
 
-  if (gtk_widget_get_mapped (widget) && priv->ready)
-  {
-     /* Defer messages until the remote texture is parented
-      * and the parent window is mapped */
-      if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
-          return;
-      hildon_remote_texture_send_message (self,
-                                          damage_atom,
-                                          priv->damage_x1,
-                                          priv->damage_y1,
-                                          priv->damage_x2 - priv->damage_x1,
-                                          priv->damage_y2 - priv->damage_y1,
-                                          0);
-      priv->set_damage = 0;
-      priv->damage_x1 = 0;
-      priv->damage_y1 = 0;
-      priv->damage_x2 = 0;
-      priv->damage_y2 = 0;
-  }
+  /* Send the damage of the whole frame at once */
+
+  if (!priv->damage_tick_id)
+    priv->damage_tick_id =
+      gtk_widget_add_tick_callback (widget,
+                                    hildon_remote_texture_damage_tick,
+                                    NULL, NULL);
 }
 
 /**
@@ -608,13 +748,13 @@ hildon_remote_texture_set_show_full (HildonRemoteTexture *self,
     priv->opacity = opacity;
     priv->set_show = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
 	/* Defer show messages until the remote texture is parented
 	 * and the parent window is mapped */
 	if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
 	    return;
-	hildon_remote_texture_send_message (self,
+	hildon_remote_texture_send_property (self, HILDON_RT_SENT_SHOW,
 					     show_atom,
 					     show, opacity,
 					     0, 0, 0);
@@ -703,17 +843,17 @@ hildon_remote_texture_set_position (HildonRemoteTexture *self,
     priv->height = height;
     priv->set_position = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
         /* Defer messages until the remote texture is parented
          * and the parent window is mapped */
 
         if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
             return;
-        hildon_remote_texture_send_message (self,
-                                            position_atom,
-                                            x, y,
-                                            width, height, 0);
+        hildon_remote_texture_send_property (self, HILDON_RT_SENT_POSITION,
+                                             position_atom,
+                                             x, y,
+                                             width, height, 0);
         priv->set_position = 0;
     }
 }
@@ -729,6 +869,9 @@ hildon_remote_texture_set_position (HildonRemoteTexture *self,
  * is also subject to the animation effects rendered by the compositing
  * window manager on that window (like those by task switcher).
  *
+ * If the texture is in a #HildonRemoteTextureAtlas, the offset is
+ * relative to the rectangle of the texture.
+ *
  * If the remote texture WM-counterpart is not ready, the show message
  * will be queued until the WM is ready for it.
  *
@@ -747,21 +890,130 @@ hildon_remote_texture_set_offset (HildonRemoteTexture *self,
     priv->offset_y = y;
     priv->set_offset = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
         /* Defer messages until the remote texture is parented
          * and the parent window is mapped */
 
         if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
             return;
-        hildon_remote_texture_send_message (self,
-                                            offset_atom,
-                                            (gint)(x*65536), (gint)(y*65536),
-                                            0, 0, 0);
+        x += priv->atlas_area.x;
+        y += priv->atlas_area.y;
+        hildon_remote_texture_send_property (self, HILDON_RT_SENT_OFFSET,
+                                             offset_atom,
+                                             (gint)(x*65536), (gint)(y*65536),
+                                             0, 0, 0);
         priv->set_offset = 0;
     }
 }
 
+static gboolean
+hildon_remote_texture_offset_tick (GtkWidget *widget,
+                                   GdkFrameClock *frame_clock,
+                                   gpointer user_data)
+{
+    HildonRemoteTexture *self = HILDON_REMOTE_TEXTURE (widget);
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    priv->offset_tick_id = 0;
+
+    if (priv->set_offset)
+        hildon_remote_texture_set_offset (self, priv->offset_x, priv->offset_y);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Follows the adjustments of the pannable area. The offset is sent
+ * once per frame however many times they moved in between. */
+static void
+hildon_remote_texture_pan_changed (GtkAdjustment *adjustment,
+                                   HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    if (priv->pan_hadjustment)
+        priv->offset_x = gtk_adjustment_get_value (priv->pan_hadjustment) / priv->scale_x;
+    if (priv->pan_vadjustment)
+        priv->offset_y = gtk_adjustment_get_value (priv->pan_vadjustment) / priv->scale_y;
+    priv->set_offset = 1;
+
+    if (!priv->offset_tick_id)
+        priv->offset_tick_id =
+            gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                          hildon_remote_texture_offset_tick,
+                                          NULL, NULL);
+}
+
+static void
+hildon_remote_texture_unwatch_adjustment (HildonRemoteTexture *self,
+                                          GtkAdjustment **adjustment)
+{
+    if (*adjustment == NULL)
+        return;
+
+    g_signal_handlers_disconnect_by_func (*adjustment,
+                                          hildon_remote_texture_pan_changed,
+                                          self);
+    g_object_unref (*adjustment);
+    *adjustment = NULL;
+}
+
+static void
+hildon_remote_texture_watch_adjustment (HildonRemoteTexture *self,
+                                        GtkAdjustment **adjustment,
+                                        GtkAdjustment *new_adjustment)
+{
+    *adjustment = g_object_ref (new_adjustment);
+    g_signal_connect (new_adjustment, "value-changed",
+                      G_CALLBACK (hildon_remote_texture_pan_changed), self);
+}
+
+/**
+ * hildon_remote_texture_set_pannable_area:
+ * @self: A #HildonRemoteTexture
+ * @area: (allow-none): A #HildonPannableArea, or %NULL
+ *
+ * Makes @self follow the panning of @area: the offset of the remote
+ * texture is set from the values of the adjustments of @area, divided
+ * by the scale of the texture. A viewer can then put a widget of the
+ * size of its content in @area and let the kinetic scrolling of @area
+ * pan the texture, instead of calling hildon_remote_texture_set_offset()
+ * from its own motion handlers.
+ *
+ * However often the adjustments change, the new offset is sent to the
+ * window manager at most once per frame.
+ *
+ * Passing %NULL stops following the area that was set before.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_remote_texture_set_pannable_area (HildonRemoteTexture *self,
+                                         HildonPannableArea *area)
+{
+    HildonRemoteTexturePrivate *priv;
+
+    g_return_if_fail (HILDON_IS_REMOTE_TEXTURE (self));
+    g_return_if_fail (area == NULL || HILDON_IS_PANNABLE_AREA (area));
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    hildon_remote_texture_unwatch_adjustment (self, &priv->pan_hadjustment);
+    hildon_remote_texture_unwatch_adjustment (self, &priv->pan_vadjustment);
+
+    if (area == NULL)
+        return;
+
+    hildon_remote_texture_watch_adjustment (self, &priv->pan_hadjustment,
+                                            hildon_pannable_area_get_hadjustment (area));
+    hildon_remote_texture_watch_adjustment (self, &priv->pan_vadjustment,
+                                            hildon_pannable_area_get_vadjustment (area));
+
+    hildon_remote_texture_pan_changed (NULL, self);
+}
+
 /**
  * hildon_remote_texture_set_scalex:
  * @self: A #HildonRemoteTexture
@@ -783,13 +1035,13 @@ hildon_remote_texture_set_scale (HildonRemoteTexture *self,
     priv->scale_y = y_scale;
     priv->set_scale = 1;
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
         /* Defer messages until the remote texture is parented
          * and the parent window is mapped */
         if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
             return;
-        hildon_remote_texture_send_message (self,
+        hildon_remote_texture_send_property (self, HILDON_RT_SENT_SCALE,
                                              scale_atom,
                                              priv->scale_x * (1 << 16),
                                              priv->scale_y * (1 << 16),
@@ -814,36 +1066,6 @@ hildon_remote_texture_parent_map_event (GtkWidget *parent,
     return FALSE;
 }
 
-/*
- * This callback will be triggered by the widget re-mapping
- * itself in case of WM restarting. The point is to push all
- * remote texture parameters anew to the WM.
- */
-static gboolean
-hildon_remote_texture_map_event (GtkWidget *widget,
-				  GdkEvent *event,
-				  gpointer user_data)
-{
-    HildonRemoteTexture
-	               *self = HILDON_REMOTE_TEXTURE (user_data);
-    HildonRemoteTexturePrivate
-	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
-
-    hildon_remote_texture_send_all_messages (self);
-
-    /* Disconnect the "map-event" handler after the "emergency resend all
-     * actor parameters" drill is over. */
-
-    if (priv->map_event_cb_id)
-    {
-	g_signal_handler_disconnect (self,
-				     priv->map_event_cb_id);
-	priv->map_event_cb_id = 0;
-    }
-
-    return FALSE;
-}
-
 /**
  * hildon_remote_texture_set_parent:
  * @self: A #HildonRemoteTexture
@@ -915,7 +1137,7 @@ hildon_remote_texture_set_parent (HildonRemoteTexture *self,
 	}
     }
 
-    if (gtk_widget_get_mapped (widget) && priv->ready)
+    if (gtk_widget_get_mapped (widget) && priv->ready && !priv->batch_depth)
     {
 	Window win = 0;
 
@@ -924,7 +1146,7 @@ hildon_remote_texture_set_parent (HildonRemoteTexture *self,
 
 	if (!priv->parent || !gtk_widget_get_mapped (GTK_WIDGET (priv->parent)))
 	{
-	    hildon_remote_texture_send_message (self,
+	    hildon_remote_texture_send_property (self, HILDON_RT_SENT_SHOW,
 						 show_atom,
 						 0, priv->opacity,
 						 0, 0, 0);
@@ -944,7 +1166,7 @@ hildon_remote_texture_set_parent (HildonRemoteTexture *self,
 	    win = GDK_WINDOW_XID (gdk);
 	}
 
-	hildon_remote_texture_send_message (self,
+	hildon_remote_texture_send_property (self, HILDON_RT_SENT_PARENT,
 					     parent_atom,
 					     win,
 					     0, 0, 0, 0);
@@ -953,7 +1175,7 @@ hildon_remote_texture_set_parent (HildonRemoteTexture *self,
 	/* Set remote texture visibility to desired value (in case it was
 	 * forced off when the actor was parented into an unmapped widget). */
 
-	hildon_remote_texture_send_message (self,
+	hildon_remote_texture_send_property (self, HILDON_RT_SENT_SHOW,
 					     show_atom,
 					     priv->show, priv->opacity,
 					     0, 0, 0);
@@ -961,3 +1183,713 @@ hildon_remote_texture_set_parent (HildonRemoteTexture *self,
     }
 }
 
+/**
+ * hildon_remote_texture_begin_update:
+ * @self: A #HildonRemoteTexture
+ *
+ * Starts a batch of changes to the remote texture. Until the matching
+ * hildon_remote_texture_commit_update(), the setters only record the new
+ * values; nothing is sent to the window manager. This lets several
+ * properties be changed together without the compositor picking up a
+ * frame in which only some of them have been applied.
+ *
+ * Calls may be nested; the changes are sent when the outermost batch
+ * is committed.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_remote_texture_begin_update (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+
+    g_return_if_fail (HILDON_IS_REMOTE_TEXTURE (self));
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    priv->batch_depth++;
+}
+
+/**
+ * hildon_remote_texture_commit_update:
+ * @self: A #HildonRemoteTexture
+ *
+ * Ends a batch of changes started with hildon_remote_texture_begin_update().
+ * When the outermost batch is committed, every property changed since
+ * it began is sent to the window manager in one go, and the X
+ * connection is flushed once.
+ *
+ * If the remote texture WM-counterpart is not ready, the messages
+ * will be queued until the WM is ready for them.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_remote_texture_commit_update (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+    GtkWidget          *widget;
+
+    g_return_if_fail (HILDON_IS_REMOTE_TEXTURE (self));
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+    widget = GTK_WIDGET (self);
+
+    g_return_if_fail (priv->batch_depth > 0);
+
+    if (--priv->batch_depth > 0)
+	return;
+
+    if (gtk_widget_get_mapped (widget) && priv->ready)
+    {
+	hildon_remote_texture_send_pending_messages (self);
+	hildon_compositor_flush (gtk_widget_get_display (widget));
+    }
+}
+
+static void
+hildon_remote_texture_free_buffers (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+    guint i;
+
+    /* hildon-desktop may still have the segments attached; the kernel
+     * keeps them until it detaches as well. */
+
+    for (i = 0; i < priv->n_buffers; i++)
+    {
+        shmdt (priv->buffers[i].data);
+        shmctl (priv->buffers[i].shm_id, IPC_RMID, NULL);
+    }
+
+    memset (priv->buffers, 0, sizeof (priv->buffers));
+    priv->n_buffers = 0;
+    priv->acquired_buffer = -1;
+    priv->presented_buffer = -1;
+}
+
+/**
+ * hildon_remote_texture_set_buffers:
+ * @self: A #HildonRemoteTexture
+ * @n_buffers: number of buffers in the ring, 2 or 3, or 0 to free the ring
+ * @width: width of the buffers in pixels
+ * @height: height of the buffers in pixels
+ * @bpp: BYTES per pixel - usually 2,3 or 4
+ *
+ * Allocates a ring of @n_buffers shared memory areas for the remote
+ * texture, replacing any previous ring. The frames are then produced with
+ * hildon_remote_texture_acquire_buffer() and
+ * hildon_remote_texture_present_buffer(), instead of
+ * hildon_remote_texture_set_image() and hildon_remote_texture_update_area().
+ *
+ * hildon-desktop reads a shared memory area when it is told it has been
+ * damaged, and there is no message telling when it has finished. A buffer
+ * is thus handed out again only after the @n_buffers - 1 buffers presented
+ * after it: with two buffers, the application draws a frame while the
+ * previous one is being read, and three buffers leave a full frame of
+ * slack for the compositor to catch up.
+ *
+ * The shared memory areas are only accessible to the user running the
+ * application, and are released when the ring is replaced or the widget
+ * is destroyed. A rectangle of a #HildonRemoteTextureAtlas the texture
+ * had is given back.
+ *
+ * Returns: %TRUE if the buffers could be allocated.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_remote_texture_set_buffers (HildonRemoteTexture *self,
+                                   guint n_buffers,
+                                   guint width,
+                                   guint height,
+                                   guint bpp)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+    gsize size = (gsize) width * height * bpp;
+    guint i;
+
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE (self), FALSE);
+    g_return_val_if_fail (n_buffers == 0 || n_buffers >= 2, FALSE);
+    g_return_val_if_fail (n_buffers <= HILDON_REMOTE_TEXTURE_MAX_BUFFERS, FALSE);
+    g_return_val_if_fail (n_buffers == 0 || size > 0, FALSE);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    hildon_remote_texture_release_atlas (self);
+    hildon_remote_texture_free_buffers (self);
+
+    priv->buffer_width = width;
+    priv->buffer_height = height;
+    priv->buffer_bpp = bpp;
+
+    for (i = 0; i < n_buffers; i++)
+    {
+        HildonRemoteTextureBuffer *buffer = &priv->buffers[i];
+        gpointer data;
+
+        /* hildon-desktop looks the segments up by key, so they can't
+         * be IPC_PRIVATE. Pick random keys until one is free. */
+
+        do
+        {
+            buffer->key = g_random_int_range (1, G_MAXINT32);
+            buffer->shm_id = shmget (buffer->key, size,
+                                     IPC_CREAT | IPC_EXCL | 0600);
+        }
+        while (buffer->shm_id == -1 && errno == EEXIST);
+
+        if (buffer->shm_id == -1)
+        {
+            g_warning ("%s: could not allocate a shared memory area: %s",
+                       G_STRFUNC, g_strerror (errno));
+            break;
+        }
+
+        data = shmat (buffer->shm_id, NULL, 0);
+
+        if (data == (gpointer) -1)
+        {
+            g_warning ("%s: could not attach a shared memory area: %s",
+                       G_STRFUNC, g_strerror (errno));
+            shmctl (buffer->shm_id, IPC_RMID, NULL);
+            break;
+        }
+
+        buffer->data = data;
+        priv->n_buffers++;
+    }
+
+    if (priv->n_buffers != n_buffers)
+    {
+        hildon_remote_texture_free_buffers (self);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * hildon_remote_texture_acquire_buffer:
+ * @self: A #HildonRemoteTexture
+ *
+ * Returns the buffer of the ring set up with
+ * hildon_remote_texture_set_buffers() into which the next frame should
+ * be drawn. Its rows are width * bpp bytes long, with no padding.
+ *
+ * Calling this function again before
+ * hildon_remote_texture_present_buffer() returns the same buffer.
+ *
+ * Returns: the buffer to draw into, or %NULL if there is no ring.
+ *
+ * Since: 3.0
+ **/
+guchar *
+hildon_remote_texture_acquire_buffer (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE (self), NULL);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    g_return_val_if_fail (priv->n_buffers > 0, NULL);
+
+    /* The oldest presented buffer is the one hildon-desktop is done with */
+
+    if (priv->acquired_buffer < 0)
+        priv->acquired_buffer = (priv->presented_buffer + 1) % priv->n_buffers;
+
+    return priv->buffers[priv->acquired_buffer].data;
+}
+
+/**
+ * hildon_remote_texture_present_buffer:
+ * @self: A #HildonRemoteTexture
+ *
+ * Shows the buffer returned by hildon_remote_texture_acquire_buffer(),
+ * switching the remote texture to it and damaging its whole area.
+ *
+ * If the remote texture WM-counterpart is not ready, the messages
+ * will be queued until the WM is ready for them.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_remote_texture_present_buffer (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+    HildonRemoteTextureBuffer *buffer;
+
+    g_return_if_fail (HILDON_IS_REMOTE_TEXTURE (self));
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    g_return_if_fail (priv->acquired_buffer >= 0);
+
+    buffer = &priv->buffers[priv->acquired_buffer];
+
+    hildon_remote_texture_begin_update (self);
+    hildon_remote_texture_set_image (self, buffer->key,
+                                     priv->buffer_width,
+                                     priv->buffer_height,
+                                     priv->buffer_bpp);
+    hildon_remote_texture_update_area (self, 0, 0,
+                                       priv->buffer_width,
+                                       priv->buffer_height);
+    hildon_remote_texture_commit_update (self);
+
+    priv->presented_buffer = priv->acquired_buffer;
+    priv->acquired_buffer = -1;
+}
+
+/**
+ * hildon_remote_texture_get_display_size:
+ * @self: A #HildonRemoteTexture
+ * @width: (out) (allow-none): return location for the width, or %NULL
+ * @height: (out) (allow-none): return location for the height, or %NULL
+ *
+ * Gets the size of the area the remote texture is shown in, as set
+ * with hildon_remote_texture_set_position(). Producers can use it as a
+ * hint for the size of the buffers passed to
+ * hildon_remote_texture_set_buffers(), since a texture larger than
+ * that area is only scaled down again by hildon-desktop.
+ *
+ * Returns: %TRUE if the area has been set.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_remote_texture_get_display_size (HildonRemoteTexture *self,
+                                        guint *width,
+                                        guint *height)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE (self), FALSE);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    if (width)
+        *width = MAX (priv->width, 0);
+    if (height)
+        *height = MAX (priv->height, 0);
+
+    return priv->width > 0 && priv->height > 0;
+}
+
+/*
+ * Fills @spans with the first source pixel of each of the @dst_size
+ * boxes @src_size pixels are split into, followed by @src_size. Every
+ * box is at least one pixel wide, so enlarging repeats pixels.
+ */
+static void
+hildon_remote_texture_box_spans (guint *spans,
+                                 guint src_size,
+                                 guint dst_size)
+{
+    guint i;
+
+    for (i = 0; i < dst_size; i++)
+        spans[i] = MIN ((guint64) i * src_size / dst_size, src_size - 1);
+
+    spans[dst_size] = src_size;
+}
+
+/**
+ * hildon_remote_texture_present_scaled:
+ * @self: A #HildonRemoteTexture
+ * @data: the pixels of the frame, in the format of the buffer ring
+ * @width: width of the frame in pixels
+ * @height: height of the frame in pixels
+ * @rowstride: distance in bytes between the rows of @data
+ *
+ * Scales a frame to the size of the buffer ring set up with
+ * hildon_remote_texture_set_buffers(), writing it straight into the
+ * buffer returned by hildon_remote_texture_acquire_buffer(), and
+ * presents it as hildon_remote_texture_present_buffer() does.
+ *
+ * Each pixel of the buffer is the average of the pixels of @data it
+ * covers, so a frame larger than the buffer is reduced without the
+ * aliasing of nearest neighbour sampling. @data must have the same
+ * number of bytes per pixel as the ring.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_remote_texture_present_scaled (HildonRemoteTexture *self,
+                                      const guchar *data,
+                                      guint width,
+                                      guint height,
+                                      guint rowstride)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+    guint dst_width, dst_height, bpp;
+    guint *x_spans;
+    guint32 *sums;
+    guchar *dst;
+    guint dx, dy, c;
+
+    g_return_if_fail (HILDON_IS_REMOTE_TEXTURE (self));
+    g_return_if_fail (data != NULL);
+    g_return_if_fail (width > 0 && height > 0);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    g_return_if_fail (priv->n_buffers > 0);
+    g_return_if_fail (rowstride >= width * priv->buffer_bpp);
+
+    dst_width = priv->buffer_width;
+    dst_height = priv->buffer_height;
+    bpp = priv->buffer_bpp;
+
+    dst = hildon_remote_texture_acquire_buffer (self);
+
+    x_spans = g_new (guint, dst_width + 1);
+    hildon_remote_texture_box_spans (x_spans, width, dst_width);
+    sums = g_new (guint32, dst_width * bpp);
+
+    for (dy = 0; dy < dst_height; dy++)
+    {
+        guint y0 = MIN ((guint64) dy * height / dst_height, height - 1);
+        guint y1 = MAX (y0 + 1, (guint64) (dy + 1) * height / dst_height);
+        guint y;
+
+        /* Add up the rows of the box, then each box along them */
+
+        memset (sums, 0, dst_width * bpp * sizeof (guint32));
+
+        for (y = y0; y < y1; y++)
+        {
+            const guchar *row = data + (gsize) y * rowstride;
+
+            for (dx = 0; dx < dst_width; dx++)
+            {
+                guint x0 = x_spans[dx];
+                guint x1 = MAX (x0 + 1, x_spans[dx + 1]);
+                guint32 *sum = sums + dx * bpp;
+                const guchar *p = row + x0 * bpp;
+                const guchar *end = row + x1 * bpp;
+
+                while (p < end)
+                    for (c = 0; c < bpp; c++)
+                        sum[c] += *p++;
+            }
+        }
+
+        for (dx = 0; dx < dst_width; dx++)
+        {
+            guint x0 = x_spans[dx];
+            guint x1 = MAX (x0 + 1, x_spans[dx + 1]);
+            guint32 area = (x1 - x0) * (y1 - y0);
+            guint32 *sum = sums + dx * bpp;
+
+            for (c = 0; c < bpp; c++)
+                *dst++ = (sum[c] + area / 2) / area;
+        }
+    }
+
+    g_free (sums);
+    g_free (x_spans);
+
+    hildon_remote_texture_present_buffer (self);
+}
+
+/* Converts @n cairo pixels, native-endian premultiplied 0xAARRGGBB
+ * words, to the byte order hildon-desktop uploads for @bpp. @alpha is
+ * ORed into each pixel, to make opaque the pixels of surfaces without
+ * an alpha channel. The loops
+ * work on whole words with no branches, so the compiler can vectorize
+ * them. */
+static void
+hildon_remote_texture_convert_row (guchar *dst,
+                                   const guint32 *src,
+                                   guint n,
+                                   guint bpp,
+                                   guint32 alpha)
+{
+    guint i;
+
+    switch (bpp)
+    {
+    case 2:
+        {
+            guint16 *d = (guint16 *) dst;
+
+            for (i = 0; i < n; i++)
+            {
+                guint32 p = src[i];
+
+                d[i] = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+            }
+        }
+        break;
+    case 3:
+        for (i = 0; i < n; i++)
+        {
+            guint32 p = src[i];
+
+            dst[3 * i] = p >> 16;
+            dst[3 * i + 1] = p >> 8;
+            dst[3 * i + 2] = p;
+        }
+        break;
+    case 4:
+        for (i = 0; i < n; i++)
+        {
+            guint32 p = src[i] | alpha;
+            guint32 rgba = (p << 8) | (p >> 24);
+
+            /* Stored as the bytes R, G, B, A whatever the endianness */
+            ((guint32 *) dst)[i] = GUINT32_TO_BE (rgba);
+        }
+        break;
+    }
+}
+
+/**
+ * hildon_remote_texture_update_from_surface:
+ * @self: A #HildonRemoteTexture
+ * @data: the shared memory area set with hildon_remote_texture_set_image()
+ * @surface: an image surface in %CAIRO_FORMAT_ARGB32 or %CAIRO_FORMAT_RGB24
+ * @x: offset of the area to update
+ * @y: offset of the area to update
+ * @width: width of the area to update
+ * @height: height of the area to update
+ *
+ * Copies an area of @surface into @data, converting it to the bytes
+ * per pixel set with hildon_remote_texture_set_image(), and marks the
+ * area as updated with hildon_remote_texture_update_area(). Only the
+ * pixels of the area are converted, so a producer that redraws part of
+ * its frame doesn't pay for the rest.
+ *
+ * With 2 bytes per pixel the texture is RGB565, which halves the
+ * memory bandwidth of the upload; with 4 it is premultiplied RGBA, and
+ * with 3 RGB. The area is clipped to both @surface and the texture.
+ *
+ * If the texture is in a #HildonRemoteTextureAtlas, @data is
+ * hildon_remote_texture_atlas_get_data(), and the area is relative to
+ * the rectangle of the texture.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_remote_texture_update_from_surface (HildonRemoteTexture *self,
+                                           guchar *data,
+                                           cairo_surface_t *surface,
+                                           gint x,
+                                           gint y,
+                                           gint width,
+                                           gint height)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+    cairo_format_t format;
+    const guchar *src;
+    guint bpp, dst_stride;
+    gint src_stride, row;
+    gint max_width, max_height;
+    guint32 alpha;
+
+    g_return_if_fail (HILDON_IS_REMOTE_TEXTURE (self));
+    g_return_if_fail (data != NULL);
+    g_return_if_fail (surface != NULL);
+    g_return_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE);
+
+    format = cairo_image_surface_get_format (surface);
+    g_return_if_fail (format == CAIRO_FORMAT_ARGB32 || format == CAIRO_FORMAT_RGB24);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+    bpp = priv->shm_bpp;
+
+    g_return_if_fail (bpp >= 2 && bpp <= 4);
+
+    if (x < 0)
+    {
+        width += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        height += y;
+        y = 0;
+    }
+    max_width = priv->atlas ? priv->atlas_area.width : (gint) priv->shm_width;
+    max_height = priv->atlas ? priv->atlas_area.height : (gint) priv->shm_height;
+    width = MIN (width, MIN (cairo_image_surface_get_width (surface),
+                             max_width) - x);
+    height = MIN (height, MIN (cairo_image_surface_get_height (surface),
+                               max_height) - y);
+
+    if (width <= 0 || height <= 0)
+        return;
+
+    cairo_surface_flush (surface);
+
+    src = cairo_image_surface_get_data (surface);
+    src_stride = cairo_image_surface_get_stride (surface);
+
+    /* The top byte of RGB24 pixels is undefined, not an alpha */
+    alpha = format == CAIRO_FORMAT_RGB24 ? 0xff000000 : 0;
+    dst_stride = priv->shm_width * bpp;
+
+    /* The pixels of the texture start at its rectangle of the atlas */
+    data += (gsize) priv->atlas_area.y * dst_stride + priv->atlas_area.x * bpp;
+
+    for (row = y; row < y + height; row++)
+        hildon_remote_texture_convert_row (data + (gsize) row * dst_stride + x * bpp,
+                                           (const guint32 *) (src + (gsize) row * src_stride) + x,
+                                           width, bpp, alpha);
+
+    hildon_remote_texture_update_area (self, x, y, width, height);
+}
+
+/* Gives the rectangle of the atlas back, showing the offset relative to
+ * the whole shared memory area again */
+static void
+hildon_remote_texture_release_atlas (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+    HildonRemoteTextureAtlas *atlas = priv->atlas;
+
+    if (!atlas)
+        return;
+
+    hildon_remote_texture_atlas_free (atlas, &priv->atlas_area);
+    memset (&priv->atlas_area, 0, sizeof (priv->atlas_area));
+    priv->atlas = NULL;
+    g_object_unref (atlas);
+
+    hildon_remote_texture_set_offset (self, priv->offset_x, priv->offset_y);
+}
+
+/**
+ * hildon_remote_texture_set_atlas:
+ * @self: A #HildonRemoteTexture
+ * @atlas: (allow-none): A #HildonRemoteTextureAtlas, or %NULL
+ * @width: width of the texture in pixels
+ * @height: height of the texture in pixels
+ *
+ * Makes the texture show a @width by @height rectangle of the shared
+ * memory area of @atlas, instead of an image of its own. The texture
+ * keeps the rectangle, and a reference on @atlas, until it is given
+ * another image, atlas or buffer ring, or it is destroyed. A %NULL
+ * @atlas only gives the rectangle back.
+ *
+ * The texture draws into its rectangle of
+ * hildon_remote_texture_atlas_get_data(), as returned by
+ * hildon_remote_texture_get_atlas_area(). The areas passed to
+ * hildon_remote_texture_update_area() and the offset set with
+ * hildon_remote_texture_set_offset() are relative to the rectangle, and
+ * hildon_remote_texture_set_position() should be given its size, so that
+ * the neighbouring textures don't show.
+ *
+ * Returns: %TRUE if @atlas had room for the texture.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_remote_texture_set_atlas (HildonRemoteTexture *self,
+                                 HildonRemoteTextureAtlas *atlas,
+                                 guint width,
+                                 guint height)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+    cairo_rectangle_int_t area;
+    guint atlas_width, atlas_height;
+    gboolean fits = TRUE;
+
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE (self), FALSE);
+    g_return_val_if_fail (atlas == NULL || HILDON_IS_REMOTE_TEXTURE_ATLAS (atlas), FALSE);
+    g_return_val_if_fail (atlas == NULL || (width > 0 && height > 0), FALSE);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    hildon_remote_texture_begin_update (self);
+
+    hildon_remote_texture_release_atlas (self);
+
+    if (atlas)
+        fits = hildon_remote_texture_atlas_alloc (atlas, width, height, &area);
+
+    if (atlas && fits)
+    {
+        priv->atlas = g_object_ref (atlas);
+        priv->atlas_area = area;
+
+        hildon_remote_texture_atlas_get_size (atlas, &atlas_width, &atlas_height);
+        hildon_remote_texture_set_image (self,
+                                         hildon_remote_texture_atlas_get_key (atlas),
+                                         atlas_width, atlas_height,
+                                         hildon_remote_texture_atlas_get_bpp (atlas));
+        hildon_remote_texture_set_offset (self, priv->offset_x, priv->offset_y);
+        hildon_remote_texture_update_area (self, 0, 0, width, height);
+    }
+
+    hildon_remote_texture_commit_update (self);
+
+    return fits;
+}
+
+/**
+ * hildon_remote_texture_get_atlas:
+ * @self: A #HildonRemoteTexture
+ *
+ * Gets the atlas set with hildon_remote_texture_set_atlas().
+ *
+ * Returns: (transfer none): the #HildonRemoteTextureAtlas of the
+ * texture, or %NULL if it has none.
+ *
+ * Since: 3.0
+ **/
+HildonRemoteTextureAtlas *
+hildon_remote_texture_get_atlas (HildonRemoteTexture *self)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE (self), NULL);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    return priv->atlas;
+}
+
+/**
+ * hildon_remote_texture_get_atlas_area:
+ * @self: A #HildonRemoteTexture
+ * @area: (out): return location for the rectangle
+ *
+ * Gets the rectangle of its #HildonRemoteTextureAtlas the texture
+ * shows, in pixels of the atlas.
+ *
+ * Returns: %TRUE if the texture is in an atlas.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_remote_texture_get_atlas_area (HildonRemoteTexture *self,
+                                      cairo_rectangle_int_t *area)
+{
+    HildonRemoteTexturePrivate
+	               *priv;
+
+    g_return_val_if_fail (HILDON_IS_REMOTE_TEXTURE (self), FALSE);
+    g_return_val_if_fail (area != NULL, FALSE);
+
+    priv = HILDON_REMOTE_TEXTURE_GET_PRIVATE (self);
+
+    *area = priv->atlas_area;
+
+    return priv->atlas != NULL;
+}
@@ -26,6 +26,8 @@
 #define                                         __HILDON_REMOTE_TEXTURE_H__
 
 #include                                        "hildon-window.h"
+#include                                        "hildon-pannable-area.h"
+#include                                        "hildon-remote-texture-atlas.h"
 #include                                        <gtk/gtk.h>
 #include                                        <sys/types.h>
 
@@ -128,9 +130,65 @@ hildon_remote_texture_set_scale (HildonRemoteTexture *self,
                                  double x_scale,
                                  double y_scale);
 void
+hildon_remote_texture_set_pannable_area (HildonRemoteTexture *self,
+                                         HildonPannableArea *area);
+void
 hildon_remote_texture_set_parent (HildonRemoteTexture *self,
 				   GtkWindow *parent);
 
+void
+hildon_remote_texture_begin_update (HildonRemoteTexture *self);
+
+void
+hildon_remote_texture_commit_update (HildonRemoteTexture *self);
+
+gboolean
+hildon_remote_texture_set_buffers (HildonRemoteTexture *self,
+                                   guint n_buffers,
+                                   guint width,
+                                   guint height,
+                                   guint bpp);
+
+guchar *
+hildon_remote_texture_acquire_buffer (HildonRemoteTexture *self);
+
+void
+hildon_remote_texture_present_buffer (HildonRemoteTexture *self);
+
+gboolean
+hildon_remote_texture_get_display_size (HildonRemoteTexture *self,
+                                        guint *width,
+                                        guint *height);
+
+void
+hildon_remote_texture_present_scaled (HildonRemoteTexture *self,
+                                      const guchar *data,
+                                      guint width,
+                                      guint height,
+                                      guint rowstride);
+
+void
+hildon_remote_texture_update_from_surface (HildonRemoteTexture *self,
+                                           guchar *data,
+                                           cairo_surface_t *surface,
+                                           gint x,
+                                           gint y,
+                                           gint width,
+                                           gint height);
+
+gboolean
+hildon_remote_texture_set_atlas (HildonRemoteTexture *self,
+                                 HildonRemoteTextureAtlas *atlas,
+                                 guint width,
+                                 guint height);
+
+HildonRemoteTextureAtlas *
+hildon_remote_texture_get_atlas (HildonRemoteTexture *self);
+
+gboolean
+hildon_remote_texture_get_atlas_area (HildonRemoteTexture *self,
+                                      cairo_rectangle_int_t *area);
+
 G_END_DECLS
 
 #endif                                 /* __HILDON_REMOTE_TEXTURE_H__ */
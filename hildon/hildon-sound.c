@@ -36,15 +36,27 @@
 #include <canberra.h>
 
 #include "hildon-sound.h"
+#include "hildon-private.h"
 
-#define ALARM_GCONF_PATH "/apps/osso/sound/system_alert_volume"
+#define ALARM_GCONF_DIR "/apps/osso/sound"
+
+#define ALARM_GCONF_PATH ALARM_GCONF_DIR "/system_alert_volume"
+
+/* Value of ALARM_GCONF_PATH: 0 mutes the system sounds, 1 plays them
+ * at a lower volume and 2 at full volume */
+#define                                         HILDON_SOUND_VOLUME_UNKNOWN -1
 
 static ca_context *hildon_ca_context_get (void);
 
+G_LOCK_DEFINE_STATIC                            (sound_context);
+
+static gint                                     system_volume = HILDON_SOUND_VOLUME_UNKNOWN;
+
 /*
  * hildon_ca_context_get:
  *
- * hildon maintains a single application-global ca_context object.
+ * hildon maintains a single application-global ca_context object,
+ * shared by all threads. Must be called with the sound_context lock held.
  *
  * This functions is based on ca_gtk_context_get
  *
@@ -53,32 +65,169 @@ static ca_context *hildon_ca_context_get (void);
 static ca_context *
 hildon_ca_context_get (void)
 {
-    static GPrivate context_private = G_PRIVATE_INIT((GDestroyNotify)ca_context_destroy);
-    ca_context *c = NULL;
+    static ca_context *c = NULL;
     const gchar *name = NULL;
     gint ret;
 
-    if ((c = g_private_get(&context_private)))
+    if (c)
         return c;
 
     if ((ret = ca_context_create(&c)) != CA_SUCCESS) {
         g_warning("ca_context_create: %s\n", ca_strerror(ret));
+        c = NULL;
         return NULL;
     }
     if ((ret = ca_context_open(c)) != CA_SUCCESS) {
         g_warning("ca_context_open: %s\n", ca_strerror(ret));
         ca_context_destroy(c);
+        c = NULL;
         return NULL;
     }
 
     if ((name = g_get_application_name()))
         ca_context_change_props(c, CA_PROP_APPLICATION_NAME, name, NULL);
 
-    g_private_set(&context_private, c);
-
     return c;
 }
 
+static void
+volume_changed                                  (GConfClient *client,
+                                                 guint        cnxn_id,
+                                                 GConfEntry  *entry,
+                                                 gpointer     data)
+{
+    GConfValue *value = gconf_entry_get_value (entry);
+
+    if (value != NULL && value->type == GCONF_VALUE_INT)
+        g_atomic_int_set (&system_volume, gconf_value_get_int (value));
+    else
+        g_atomic_int_set (&system_volume, HILDON_SOUND_VOLUME_UNKNOWN);
+}
+
+/*
+ * hildon_sound_watch_volume:
+ *
+ * Reads the system sound volume the first time a sound is played, and
+ * keeps it up to date through a gconf notification from then on, so
+ * that only the first sound waits for gconf, and starting applications
+ * never does. Like the gconf client, this is used from the main thread.
+ */
+static void
+hildon_sound_watch_volume                       (void)
+{
+    static gsize initialized = 0;
+
+    if (g_once_init_enter (&initialized)) {
+        GConfClient *client = gconf_client_get_default ();
+        GError *error = NULL;
+        gint volume;
+
+        gconf_client_add_dir (client, ALARM_GCONF_DIR, GCONF_CLIENT_PRELOAD_NONE, NULL);
+        gconf_client_notify_add (client, ALARM_GCONF_PATH, volume_changed, NULL, NULL, NULL);
+
+        volume = gconf_client_get_int (client, ALARM_GCONF_PATH, &error);
+        if (error) {
+            g_error_free (error);
+            volume = HILDON_SOUND_VOLUME_UNKNOWN;
+        }
+        g_atomic_int_set (&system_volume, volume);
+
+        /* The client is kept alive for the notification */
+        g_once_init_leave (&initialized, 1);
+    }
+}
+
+typedef struct
+{
+    gboolean cache;
+    gchar *sample;
+}                                               HildonSoundRequest;
+
+/* Sounds are loaded and played from a dedicated thread, so neither a
+ * round-trip to the sound server nor decoding a sample ever blocks the
+ * thread that is showing the dialog. */
+static void
+hildon_sound_thread_func                        (gpointer data,
+                                                 gpointer user_data)
+{
+    HildonSoundRequest *request = data;
+    ca_context *ca_con;
+    ca_proplist *pl = NULL;
+    gint volume;
+    gint ret;
+
+    volume = g_atomic_int_get (&system_volume);
+    if (volume == 0 && !request->cache)
+        goto out;
+
+    G_LOCK (sound_context);
+
+    ca_con = hildon_ca_context_get ();
+    if (ca_con == NULL) {
+        G_UNLOCK (sound_context);
+        goto out;
+    }
+
+    /* The path is used as the event id, so a sample that has been
+     * cached with hildon_cache_system_sound() is played from the sound
+     * server's cache instead of being read and decoded again */
+    ca_proplist_create(&pl);
+    ca_proplist_sets(pl, CA_PROP_EVENT_ID, request->sample);
+    ca_proplist_sets(pl, CA_PROP_MEDIA_FILENAME, request->sample);
+    ca_proplist_sets(pl, CA_PROP_MEDIA_ROLE, "dialog-information");
+    ca_proplist_sets(pl, "module-stream-restore.id", "x-maemo-system-sound");
+    if (volume == 1 && !request->cache)
+        ca_proplist_sets(pl, CA_PROP_CANBERRA_VOLUME, "-6.0");
+
+    if (request->cache) {
+        if ((ret = ca_context_cache_full(ca_con, pl)) != CA_SUCCESS)
+            g_debug("ca_context_cache_full: %s", ca_strerror(ret));
+    } else {
+        ca_context_play_full(ca_con, 0, pl, NULL, NULL);
+    }
+
+    ca_proplist_destroy(pl);
+
+    G_UNLOCK (sound_context);
+
+out:
+    g_free (request->sample);
+    g_slice_free (HildonSoundRequest, request);
+}
+
+static void
+hildon_sound_push_request                       (const gchar *sample,
+                                                 gboolean     cache)
+{
+    static gsize initialized = 0;
+    static GThreadPool *pool = NULL;
+    HildonSoundRequest *request;
+    GError *error = NULL;
+
+    if (g_once_init_enter (&initialized)) {
+        pool = g_thread_pool_new (hildon_sound_thread_func, NULL, 1, TRUE, &error);
+        if (pool == NULL) {
+            g_warning ("Unable to create the sound thread: %s", error->message);
+            g_error_free (error);
+            error = NULL;
+        }
+        g_once_init_leave (&initialized, 1);
+    }
+
+    request = g_slice_new (HildonSoundRequest);
+    request->cache = cache;
+    request->sample = g_strdup (sample);
+
+    /* Play synchronously if there is no sound thread */
+    if (pool == NULL || !g_thread_pool_push (pool, request, &error)) {
+        if (error) {
+            g_warning ("Unable to queue the sound request: %s", error->message);
+            g_error_free (error);
+        }
+        hildon_sound_thread_func (request, NULL);
+    }
+}
+
 /**
  * hildon_play_system_sound:
  * @sample: sound file to play
@@ -89,21 +238,34 @@ hildon_ca_context_get (void)
  * This method sets the "dialog-information" role for the sound played,
  * so you need to keep this into account when using it. For any purpose, it
  * is highly recommended that you use canberra-gtk instead of this method.
+ *
+ * The sound is played from a separate thread, so this function returns
+ * immediately.
  */
 void 
 hildon_play_system_sound(const gchar *sample)
 {
-    ca_context *ca_con = NULL;
-    ca_proplist *pl = NULL;
+    g_return_if_fail (sample != NULL);
 
-    ca_con = hildon_ca_context_get ();
-
-    ca_proplist_create(&pl);
-    ca_proplist_sets(pl, CA_PROP_MEDIA_FILENAME, sample);
-    ca_proplist_sets(pl, CA_PROP_MEDIA_ROLE, "dialog-information");
-    ca_proplist_sets(pl, "module-stream-restore.id", "x-maemo-system-sound");
+    hildon_sound_watch_volume ();
+    hildon_sound_push_request (sample, FALSE);
+}
 
-    ca_context_play_full(ca_con, 0, pl, NULL, NULL);
+/**
+ * hildon_cache_system_sound:
+ * @sample: sound file to cache
+ *
+ * Uploads the given sample to the sound server's cache, so that later
+ * calls to hildon_play_system_sound() with the same @sample don't need
+ * to read and decode the file. Like playback, this is done from a
+ * separate thread and the function returns immediately.
+ *
+ * Since: 3.0
+ */
+void
+hildon_cache_system_sound                       (const gchar *sample)
+{
+    g_return_if_fail (sample != NULL);
 
-    ca_proplist_destroy(pl);
+    hildon_sound_push_request (sample, TRUE);
 }
@@ -32,6 +32,9 @@ G_BEGIN_DECLS
 void 
 hildon_play_system_sound                        (const gchar *sample);
 
+void
+hildon_cache_system_sound                       (const gchar *sample);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_SOUND_H__ */
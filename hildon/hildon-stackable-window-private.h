@@ -33,6 +33,10 @@ struct                                          _HildonStackableWindowPrivate
 {
     HildonWindowStack *stack;
     gint stack_position;
+    guint stack_index; /* Index in the stack's array of windows */
+    gboolean buried; /* Stacked under another window */
+    gboolean updates_frozen;
+    gboolean hibernated; /* Its contents were dropped on "hibernate" */
 };
 
 #define                                         HILDON_STACKABLE_WINDOW_GET_PRIVATE(obj) \
@@ -44,6 +48,13 @@ hildon_stackable_window_set_stack               (HildonStackableWindow *self,
                                                  HildonWindowStack     *stack,
                                                  gint                   position);
 
+void G_GNUC_INTERNAL
+hildon_stackable_window_set_buried              (HildonStackableWindow *self,
+                                                 gboolean               buried);
+
+gboolean G_GNUC_INTERNAL
+hildon_stackable_window_hibernate               (HildonStackableWindow *self);
+
 G_END_DECLS
 
 #endif                                 /* __HILDON_STACKABLE_WINDOW_PRIVATE_H__ */
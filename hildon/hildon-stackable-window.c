@@ -51,6 +51,24 @@
  * and all visible #HildonStackableWindow<!-- -->s are always on a
  * stack.
  *
+ * The window manager animates the new window as soon as it is mapped,
+ * using whatever it has drawn so far. A window whose contents take long
+ * to lay out the first time can be prepared in advance with
+ * hildon_stackable_window_prepare(), e.g. from an idle handler while
+ * the user is still looking at the previous window.
+ *
+ * A window with another one stacked on top of it is
+ * #HildonStackableWindow:buried. Its drawing is suspended until it
+ * becomes the topmost window of its stack again, and widgets that run
+ * animations or keep caches can watch the property to pause and release
+ * them meanwhile.
+ *
+ * A stack with hildon_window_stack_set_hibernate_depth() set can go
+ * further and ask windows buried deep enough to drop their contents
+ * with the #HildonStackableWindow::hibernate signal. Such a window is
+ * asked to rebuild them with #HildonStackableWindow::wake-up before it
+ * becomes the topmost window again.
+ *
  * To see how to manage multiple stacks per application and for other
  * advanced details on stack handling, see #HildonWindowStack
  *
@@ -102,9 +120,26 @@
 #include                                        "hildon-stackable-window-private.h"
 #include                                        "hildon-window-stack.h"
 #include                                        "hildon-window-stack-private.h"
+#include                                        "hildon-private.h"
+#include                                        "hildon-marshalers.h"
 
 G_DEFINE_TYPE (HildonStackableWindow, hildon_stackable_window, HILDON_TYPE_WINDOW);
 
+enum
+{
+    PROP_0,
+    PROP_BURIED
+};
+
+enum
+{
+    HIBERNATE,
+    WAKE_UP,
+    LAST_SIGNAL
+};
+
+static guint                                    signals[LAST_SIGNAL] = { 0 };
+
 void G_GNUC_INTERNAL
 hildon_stackable_window_set_stack               (HildonStackableWindow *self,
                                                  HildonWindowStack     *stack,
@@ -122,6 +157,122 @@ hildon_stackable_window_set_stack               (HildonStackableWindow *self,
     priv->stack_position = position;
 }
 
+/* A buried window is covered by the ones above it, so redrawing it
+ * would only be thrown away. The invalidated areas are kept and drawn
+ * when it is uncovered. */
+static void
+hildon_stackable_window_sync_updates            (HildonStackableWindow *self)
+{
+    HildonStackableWindowPrivate *priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (self);
+    GdkWindow *window = gtk_widget_get_window (GTK_WIDGET (self));
+    gboolean freeze = priv->buried && gtk_widget_get_realized (GTK_WIDGET (self));
+
+    if (!freeze == !priv->updates_frozen)
+        return;
+
+    if (freeze)
+        gdk_window_freeze_updates (window);
+    else
+        gdk_window_thaw_updates (window);
+
+    priv->updates_frozen = freeze;
+}
+
+static void
+hildon_stackable_window_wake_up                 (HildonStackableWindow *self)
+{
+    HildonStackableWindowPrivate *priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (self);
+
+    if (priv->hibernated) {
+        priv->hibernated = FALSE;
+        g_signal_emit (self, signals[WAKE_UP], 0);
+    }
+}
+
+void G_GNUC_INTERNAL
+hildon_stackable_window_set_buried              (HildonStackableWindow *self,
+                                                 gboolean               buried)
+{
+    HildonStackableWindowPrivate *priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (self);
+
+    if (!priv->buried == !buried)
+        return;
+
+    priv->buried = buried;
+    hildon_stackable_window_sync_updates (self);
+
+    /* Uncovered windows get their contents back before they are seen;
+     * popped ones wait until they are shown again */
+    if (!buried && priv->stack != NULL)
+        hildon_stackable_window_wake_up (self);
+
+    g_object_notify (G_OBJECT (self), "buried");
+}
+
+/* Asks the application to save the state of a buried window. If it
+ * does, the child of the window is destroyed until the window is
+ * uncovered. Returns whether the window is hibernated. */
+gboolean G_GNUC_INTERNAL
+hildon_stackable_window_hibernate               (HildonStackableWindow *self)
+{
+    HildonStackableWindowPrivate *priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (self);
+    gboolean handled = FALSE;
+
+    if (priv->hibernated || !priv->buried)
+        return priv->hibernated;
+
+    g_signal_emit (self, signals[HIBERNATE], 0, &handled);
+
+    if (handled) {
+        GtkWidget *child = gtk_bin_get_child (GTK_BIN (self));
+
+        if (child != NULL)
+            gtk_widget_destroy (child);
+
+        priv->hibernated = TRUE;
+    }
+
+    return priv->hibernated;
+}
+
+/**
+ * hildon_stackable_window_get_hibernated:
+ * @self: a #HildonStackableWindow
+ *
+ * Returns whether the contents of @self were dropped after a
+ * #HildonStackableWindow::hibernate signal, and not rebuilt yet.
+ *
+ * Return value: %TRUE if @self is hibernated
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_stackable_window_get_hibernated          (HildonStackableWindow *self)
+{
+    g_return_val_if_fail (HILDON_IS_STACKABLE_WINDOW (self), FALSE);
+
+    return HILDON_STACKABLE_WINDOW_GET_PRIVATE (self)->hibernated;
+}
+
+/**
+ * hildon_stackable_window_get_buried:
+ * @self: a #HildonStackableWindow
+ *
+ * Returns whether @self is covered by other windows of its stack. See
+ * #HildonStackableWindow:buried.
+ *
+ * Return value: %TRUE if @self is stacked and not on top of its stack
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_stackable_window_get_buried              (HildonStackableWindow *self)
+{
+    g_return_val_if_fail (HILDON_IS_STACKABLE_WINDOW (self), FALSE);
+
+    return HILDON_STACKABLE_WINDOW_GET_PRIVATE (self)->buried;
+}
+
 /**
  * hildon_stackable_window_get_stack:
  * @self: a #HildonStackableWindow
@@ -145,6 +296,59 @@ hildon_stackable_window_get_stack               (HildonStackableWindow *self)
     return priv->stack;
 }
 
+/**
+ * hildon_stackable_window_prepare:
+ * @self: a #HildonStackableWindow
+ *
+ * Does in advance the work that showing @self for the first time would
+ * otherwise do right when the window manager starts the transition to
+ * it: @self is realized and its contents are laid out at the size of
+ * the windows of the default stack. Measuring the contents loads most
+ * of the fonts, icons and theme images they use. Drawing them still
+ * happens once @self is mapped. @self is not mapped nor added to any
+ * stack.
+ *
+ * Call this after the contents of @self have been added and shown,
+ * and before pushing it. Preparing a window that is already mapped
+ * does nothing.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_stackable_window_prepare                 (HildonStackableWindow *self)
+{
+    GtkWidget *widget;
+    GtkWidget *top;
+    GtkAllocation allocation = { 0, 0, 0, 0 };
+    GtkRequisition requisition;
+
+    g_return_if_fail (HILDON_IS_STACKABLE_WINDOW (self));
+
+    widget = GTK_WIDGET (self);
+
+    if (gtk_widget_get_mapped (widget))
+        return;
+
+    gtk_widget_realize (widget);
+
+    /* The window will be shown at the size of the windows it covers */
+    top = hildon_window_stack_peek (hildon_window_stack_get_default ());
+    if (top && top != widget && gtk_widget_get_mapped (top)) {
+        gtk_widget_get_allocation (top, &allocation);
+    } else {
+        GdkScreen *screen = gtk_widget_get_screen (widget);
+        allocation.width = gdk_screen_get_width (screen);
+        allocation.height = gdk_screen_get_height (screen);
+    }
+
+    gtk_widget_get_preferred_size (widget, &requisition, NULL);
+    allocation.width = MAX (allocation.width, requisition.width);
+    allocation.height = MAX (allocation.height, requisition.height);
+    allocation.x = allocation.y = 0;
+
+    gtk_widget_size_allocate (widget, &allocation);
+}
+
 static void
 hildon_stackable_window_map                     (GtkWidget *widget)
 {
@@ -158,7 +362,7 @@ hildon_stackable_window_map                     (GtkWidget *widget)
     /* Set additional property "_HILDON_STACKABLE_WINDOW", to allow the WM to manage
        it as a stackable window. */
     display = gdk_window_get_display (gtk_widget_get_window (widget));
-    atom = gdk_x11_get_xatom_by_name_for_display (display, "_HILDON_STACKABLE_WINDOW");
+    atom = hildon_get_xatom (display, HILDON_ATOM_HILDON_STACKABLE_WINDOW);
     XChangeProperty (GDK_DISPLAY_XDISPLAY (display), GDK_WINDOW_XID (gtk_widget_get_window (widget)), atom,
                      XA_INTEGER, 32, PropModeReplace,
                      (unsigned char *) &val, 1);
@@ -166,6 +370,28 @@ hildon_stackable_window_map                     (GtkWidget *widget)
     GTK_WIDGET_CLASS (hildon_stackable_window_parent_class)->map (widget);
 }
 
+static void
+hildon_stackable_window_realize                 (GtkWidget *widget)
+{
+    GTK_WIDGET_CLASS (hildon_stackable_window_parent_class)->realize (widget);
+
+    hildon_stackable_window_sync_updates (HILDON_STACKABLE_WINDOW (widget));
+}
+
+static void
+hildon_stackable_window_unrealize               (GtkWidget *widget)
+{
+    HildonStackableWindowPrivate *priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (widget);
+
+    /* The freeze goes away with the GdkWindow */
+    if (priv->updates_frozen) {
+        gdk_window_thaw_updates (gtk_widget_get_window (widget));
+        priv->updates_frozen = FALSE;
+    }
+
+    GTK_WIDGET_CLASS (hildon_stackable_window_parent_class)->unrealize (widget);
+}
+
 static void
 hildon_stackable_window_show                    (GtkWidget *widget)
 {
@@ -177,6 +403,8 @@ hildon_stackable_window_show                    (GtkWidget *widget)
         _hildon_window_stack_do_push (stack, HILDON_STACKABLE_WINDOW (widget));
     }
 
+    hildon_stackable_window_wake_up (HILDON_STACKABLE_WINDOW (widget));
+
     GTK_WIDGET_CLASS (hildon_stackable_window_parent_class)->show (widget);
 }
 
@@ -206,19 +434,109 @@ hildon_stackable_window_delete_event            (GtkWidget   *widget,
         retvalue = GTK_WIDGET_CLASS (hildon_stackable_window_parent_class)->delete_event (widget, event);
     }
 
+    /* Let the stack take the window down without delaying the
+     * transition back to the previous one */
+    if (!retvalue && priv->stack && hildon_window_stack_get_destroy_later (priv->stack)) {
+        hildon_window_stack_destroy_window (priv->stack, HILDON_STACKABLE_WINDOW (widget));
+        retvalue = TRUE;
+    }
+
     return retvalue;
 }
 
+static void
+hildon_stackable_window_get_property            (GObject    *object,
+                                                 guint       property_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonStackableWindowPrivate *priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_BURIED:
+            g_value_set_boolean (value, priv->buried);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
 static void
 hildon_stackable_window_class_init              (HildonStackableWindowClass *klass)
 {
+    GObjectClass      *gobject_class = G_OBJECT_CLASS (klass);
     GtkWidgetClass    *widget_class = GTK_WIDGET_CLASS (klass);
 
+    gobject_class->get_property     = hildon_stackable_window_get_property;
+
+    widget_class->realize           = hildon_stackable_window_realize;
+    widget_class->unrealize         = hildon_stackable_window_unrealize;
     widget_class->map               = hildon_stackable_window_map;
     widget_class->show              = hildon_stackable_window_show;
     widget_class->hide              = hildon_stackable_window_hide;
     widget_class->delete_event      = hildon_stackable_window_delete_event;
 
+    /**
+     * HildonStackableWindow:buried:
+     *
+     * Whether the window is stacked under another window of its stack.
+     * While it is, the window is not redrawn.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (gobject_class, PROP_BURIED,
+            g_param_spec_boolean ("buried",
+                                  "Buried",
+                                  "Whether the window is covered by other windows of its stack",
+                                  FALSE,
+                                  G_PARAM_READABLE));
+
+    /**
+     * HildonStackableWindow::hibernate:
+     * @window: the window which received the signal
+     *
+     * Emitted when the stack of @window wants to free memory, for a
+     * window buried at least as deep as its
+     * hildon_window_stack_set_hibernate_depth(), or for every buried
+     * window when hildon_program_purge_caches() is called. Handlers
+     * that save what is needed to rebuild the contents of @window
+     * return %TRUE; the child of @window is then destroyed.
+     * Toolbars and menus are kept.
+     *
+     * Returns: %TRUE if the contents of @window can be dropped
+     *
+     * Since: 3.0
+     */
+    signals[HIBERNATE] =
+        g_signal_new ("hibernate",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      g_signal_accumulator_true_handled, NULL,
+                      _hildon_marshal_BOOLEAN__VOID,
+                      G_TYPE_BOOLEAN, 0);
+
+    /**
+     * HildonStackableWindow::wake-up:
+     * @window: the window which received the signal
+     *
+     * Emitted on a window whose contents were dropped on
+     * #HildonStackableWindow::hibernate, when it is about to become the
+     * topmost window of its stack. Handlers must add the child of
+     * @window again, from the state they saved.
+     *
+     * Since: 3.0
+     */
+    signals[WAKE_UP] =
+        g_signal_new ("wake-up",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL, NULL,
+                      g_cclosure_marshal_VOID__VOID,
+                      G_TYPE_NONE, 0);
+
     g_type_class_add_private (klass, sizeof (HildonStackableWindowPrivate));
 }
 
@@ -229,6 +547,10 @@ hildon_stackable_window_init                    (HildonStackableWindow *self)
 
     priv->stack = NULL;
     priv->stack_position = -1;
+    priv->stack_index = 0;
+    priv->buried = FALSE;
+    priv->updates_frozen = FALSE;
+    priv->hibernated = FALSE;
 }
 
 /**
@@ -89,6 +89,15 @@ hildon_stackable_window_new                     (void);
 HildonWindowStack *
 hildon_stackable_window_get_stack               (HildonStackableWindow *self);
 
+gboolean
+hildon_stackable_window_get_buried              (HildonStackableWindow *self);
+
+gboolean
+hildon_stackable_window_get_hibernated          (HildonStackableWindow *self);
+
+void
+hildon_stackable_window_prepare                 (HildonStackableWindow *self);
+
 G_END_DECLS
 
 #endif                                 /* __HILDON_STACKABLE_WINDOW_H__ */
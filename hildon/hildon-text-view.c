@@ -45,13 +45,39 @@
  * }
  * </programlisting>
  * </example>
+ *
+ * Long texts, such as logs or message bodies, can be shown with
+ * hildon_text_view_load_text(), which shows the start of the text at
+ * once and appends the rest in the background, so the UI keeps
+ * responding while it is loaded.
  */
 
 #include                                        "hildon-text-view.h"
+#include                                        "hildon-pannable-area.h"
 #include <math.h>
+#include <string.h>
 
 #define HILDON_TEXT_VIEW_DRAG_THRESHOLD 16.0
 
+/* Text inserted at once when a load starts, enough for a screenful */
+#define HILDON_TEXT_VIEW_LOAD_FIRST_CHUNK (8 * 1024)
+
+/* Text inserted at a time by the background load */
+#define HILDON_TEXT_VIEW_LOAD_CHUNK (16 * 1024)
+
+/* Time each background load iteration may take, in microseconds,
+ * normally and while the surrounding pannable area is scrolling */
+#define HILDON_TEXT_VIEW_LOAD_BUDGET 8000
+
+#define HILDON_TEXT_VIEW_LOAD_BUDGET_PANNING 2000
+
+enum {
+    LOAD_PROGRESS,
+    LAST_SIGNAL
+};
+
+static guint                                    signals[LAST_SIGNAL] = { 0 };
+
 G_DEFINE_TYPE                                   (HildonTextView, hildon_text_view, GTK_TYPE_TEXT_VIEW);
 
 #define                                         HILDON_TEXT_VIEW_GET_PRIVATE(obj) \
@@ -65,6 +91,15 @@ struct                                          _HildonTextViewPrivate
     gdouble x;                                                      /* tap x position */
     gdouble y;                                                      /* tap y position */
     gboolean selection_movement;                                    /* selection in progress */
+    gboolean preedit_active;                                        /* the IM shows a preedit */
+
+    /* Background load, see hildon_text_view_load_text() */
+    gchar *load_text;
+    gsize load_len;
+    gsize load_pos;
+    guint load_id;
+    GtkWidget *load_area;                                           /* weak pointer */
+    gboolean load_panning;
 };
 
 
@@ -85,6 +120,45 @@ hildon_text_view_new                            (void)
     return entry;
 }
 
+static void
+hildon_text_view_preedit_changed                (GtkTextView *text_view,
+                                                 const gchar *preedit)
+{
+    HildonTextViewPrivate *priv = HILDON_TEXT_VIEW_GET_PRIVATE (text_view);
+
+    priv->preedit_active = (preedit != NULL && preedit[0] != '\0');
+}
+
+/* Resetting the IM context is a round-trip to the input method, so it
+ * is only done when there is something to reset: a preedit, or a tap
+ * that moves the cursor somewhere else. */
+static void
+hildon_text_view_reset_im_context_for_tap       (GtkTextView    *text_view,
+                                                 GdkEventButton *event)
+{
+    HildonTextViewPrivate *priv = HILDON_TEXT_VIEW_GET_PRIVATE (text_view);
+    GtkTextBuffer *buffer;
+    GtkTextIter tap, cursor;
+    gint x, y;
+
+    if (!priv->preedit_active) {
+        gtk_text_view_window_to_buffer_coords (text_view,
+                                               gtk_text_view_get_window_type (text_view,
+                                                                              event->window),
+                                               event->x, event->y, &x, &y);
+        gtk_text_view_get_iter_at_location (text_view, &tap, x, y);
+
+        buffer = gtk_text_view_get_buffer (text_view);
+        gtk_text_buffer_get_iter_at_mark (buffer, &cursor,
+                                          gtk_text_buffer_get_insert (buffer));
+
+        if (gtk_text_iter_equal (&tap, &cursor))
+            return;
+    }
+
+    gtk_text_view_reset_im_context (text_view);
+}
+
 static gint
 hildon_text_view_button_press_event             (GtkWidget        *widget,
                                                  GdkEventButton   *event)
@@ -96,7 +170,7 @@ hildon_text_view_button_press_event             (GtkWidget        *widget,
 
     if (gtk_text_view_get_editable (text_view))
     {
-        gtk_text_view_reset_im_context (text_view);
+        hildon_text_view_reset_im_context_for_tap (text_view, event);
         return TRUE;
     }
 
@@ -145,7 +219,10 @@ hildon_text_view_button_release_event           (GtkWidget        *widget,
 
     if (gtk_text_view_get_editable (text_view))
     {
-        gtk_text_view_reset_im_context (text_view);
+        /* The press already reset the context if the tap moved the
+         * cursor, so only a preedit started since then is left */
+        if (priv->preedit_active)
+            gtk_text_view_reset_im_context (text_view);
         return TRUE;
     }
 
@@ -188,15 +265,199 @@ hildon_text_view_button_release_event           (GtkWidget        *widget,
     return FALSE;
 }
 
+static void
+on_load_panning_started                         (HildonTextViewPrivate *priv)
+{
+    priv->load_panning = TRUE;
+}
+
+static void
+on_load_panning_finished                        (HildonTextViewPrivate *priv)
+{
+    priv->load_panning = FALSE;
+}
+
+static void
+load_area_disconnect                            (HildonTextViewPrivate *priv)
+{
+    if (priv->load_area == NULL)
+        return;
+
+    g_signal_handlers_disconnect_by_func (priv->load_area,
+                                          on_load_panning_started, priv);
+    g_signal_handlers_disconnect_by_func (priv->load_area,
+                                          on_load_panning_finished, priv);
+    g_object_remove_weak_pointer (G_OBJECT (priv->load_area),
+                                  (gpointer *) &priv->load_area);
+    priv->load_area = NULL;
+    priv->load_panning = FALSE;
+}
+
+/* Watches the pannable area @view is in, if any, as the view can be
+ * packed after the load started */
+static void
+load_area_update                                (HildonTextView *view)
+{
+    HildonTextViewPrivate *priv = HILDON_TEXT_VIEW_GET_PRIVATE (view);
+    GtkWidget *area;
+
+    area = gtk_widget_get_ancestor (GTK_WIDGET (view), HILDON_TYPE_PANNABLE_AREA);
+    if (area == priv->load_area)
+        return;
+
+    load_area_disconnect (priv);
+
+    if (area == NULL)
+        return;
+
+    priv->load_area = area;
+    g_object_add_weak_pointer (G_OBJECT (area), (gpointer *) &priv->load_area);
+    g_signal_connect_swapped (area, "panning-started",
+                              G_CALLBACK (on_load_panning_started), priv);
+    g_signal_connect_swapped (area, "panning-finished",
+                              G_CALLBACK (on_load_panning_finished), priv);
+}
+
+static void
+load_stop                                       (HildonTextViewPrivate *priv)
+{
+    if (priv->load_id) {
+        g_source_remove (priv->load_id);
+        priv->load_id = 0;
+    }
+
+    load_area_disconnect (priv);
+
+    g_free (priv->load_text);
+    priv->load_text = NULL;
+    priv->load_len = 0;
+    priv->load_pos = 0;
+}
+
+/* Returns where the chunk of at most @size bytes starting at the load
+ * position should end: after its last line break if it has one, else
+ * at a character boundary */
+static gsize
+load_chunk_end                                  (HildonTextViewPrivate *priv,
+                                                 gsize                  size)
+{
+    const gchar *text = priv->load_text;
+    gsize end;
+
+    if (priv->load_len - priv->load_pos <= size)
+        return priv->load_len;
+
+    for (end = priv->load_pos + size; end > priv->load_pos; end--) {
+        if (text[end - 1] == '\n')
+            return end;
+    }
+
+    end = priv->load_pos + size;
+    while (end > priv->load_pos && (text[end] & 0xC0) == 0x80)
+        end--;
+
+    return end;
+}
+
+/* Appends the next chunk of the text being loaded. Returns %TRUE if
+ * there is more to append. */
+static gboolean
+load_append_chunk                               (HildonTextView *view,
+                                                 gsize           size)
+{
+    HildonTextViewPrivate *priv = HILDON_TEXT_VIEW_GET_PRIVATE (view);
+    GtkTextBuffer *buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+    GtkTextIter end_iter;
+    gsize end;
+
+    end = load_chunk_end (priv, size);
+
+    /* Inserting at the end leaves the cursor and the scroll position
+     * where they are */
+    gtk_text_buffer_get_end_iter (buffer, &end_iter);
+    gtk_text_buffer_insert (buffer, &end_iter, priv->load_text + priv->load_pos,
+                            end - priv->load_pos);
+    priv->load_pos = end;
+
+    return priv->load_pos < priv->load_len;
+}
+
+static gboolean
+on_load_idle                                    (HildonTextView *view)
+{
+    HildonTextViewPrivate *priv = HILDON_TEXT_VIEW_GET_PRIVATE (view);
+    gint64 start = g_get_monotonic_time ();
+    gint64 budget;
+    gboolean more;
+
+    load_area_update (view);
+    budget = priv->load_panning ?
+        HILDON_TEXT_VIEW_LOAD_BUDGET_PANNING : HILDON_TEXT_VIEW_LOAD_BUDGET;
+
+    do {
+        more = load_append_chunk (view, HILDON_TEXT_VIEW_LOAD_CHUNK);
+    } while (more && g_get_monotonic_time () - start < budget);
+
+    if (more) {
+        g_signal_emit (view, signals[LOAD_PROGRESS], 0,
+                       (gdouble) priv->load_pos / priv->load_len);
+        return TRUE;
+    }
+
+    priv->load_id = 0;
+    load_stop (priv);
+    g_signal_emit (view, signals[LOAD_PROGRESS], 0, 1.0);
+
+    return FALSE;
+}
+
+static void
+on_buffer_notify                                (HildonTextView *view)
+{
+    /* The rest of the text belongs to the old buffer */
+    hildon_text_view_cancel_load (view);
+}
+
+static void
+hildon_text_view_dispose                        (GObject *object)
+{
+    HildonTextViewPrivate *priv = HILDON_TEXT_VIEW_GET_PRIVATE (object);
+
+    load_stop (priv);
+
+    G_OBJECT_CLASS (hildon_text_view_parent_class)->dispose (object);
+}
+
 static void
 hildon_text_view_class_init                     (HildonTextViewClass *klass)
 {
+    GObjectClass *gobject_class = (GObjectClass *)klass;
     GtkWidgetClass *widget_class = (GtkWidgetClass *)klass;
 
+    gobject_class->dispose = hildon_text_view_dispose;
+
     widget_class->motion_notify_event = NULL;
     widget_class->button_press_event = hildon_text_view_button_press_event;
     widget_class->button_release_event = hildon_text_view_button_release_event;
 
+    /**
+     * HildonTextView::load-progress:
+     * @view: the object which received the signal
+     * @fraction: the part of the text loaded so far, from 0 to 1
+     *
+     * Emitted while a text set with hildon_text_view_load_text() is
+     * appended to the buffer, and with @fraction 1 once all of it is.
+     *
+     * Since: 3.0
+     */
+    signals[LOAD_PROGRESS] =
+        g_signal_new ("load-progress",
+                      G_OBJECT_CLASS_TYPE (gobject_class),
+                      G_SIGNAL_RUN_LAST,
+                      0, NULL, NULL,
+                      g_cclosure_marshal_VOID__DOUBLE,
+                      G_TYPE_NONE, 1, G_TYPE_DOUBLE);
+
     g_type_class_add_private (klass, sizeof (HildonTextViewPrivate));
 }
 static void
@@ -205,4 +466,128 @@ hildon_text_view_init                           (HildonTextView *self)
     HildonTextViewPrivate *priv = HILDON_TEXT_VIEW_GET_PRIVATE (self);
 
     priv->selection_movement = FALSE;
+    priv->preedit_active = FALSE;
+    priv->load_text = NULL;
+    priv->load_len = 0;
+    priv->load_pos = 0;
+    priv->load_id = 0;
+    priv->load_area = NULL;
+    priv->load_panning = FALSE;
+
+    g_signal_connect (self, "notify::buffer", G_CALLBACK (on_buffer_notify), NULL);
+    g_signal_connect (self, "preedit-changed",
+                      G_CALLBACK (hildon_text_view_preedit_changed), NULL);
+}
+
+/**
+ * hildon_text_view_load_text:
+ * @view: a #HildonTextView
+ * @text: UTF-8 text
+ * @len: length of @text in bytes, or -1 if it is nul-terminated
+ *
+ * Replaces the contents of the buffer of @view with @text, like
+ * gtk_text_buffer_set_text(), but without blocking: the first
+ * screenful of @text is shown at once, and the rest is appended in
+ * chunks from an idle handler, a few milliseconds at a time.
+ * #HildonTextView::load-progress is emitted as the text is appended.
+ *
+ * The text is appended at the end of the buffer, so the cursor and the
+ * scroll position stay where they are, and a #HildonPannableArea
+ * holding @view can be scrolled while the text is loading. While it
+ * scrolls, less text is appended per iteration so the scrolling stays
+ * smooth.
+ *
+ * Loading another text, or setting another buffer in @view, cancels
+ * the load in progress, see hildon_text_view_cancel_load().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_text_view_load_text                      (HildonTextView *view,
+                                                 const gchar    *text,
+                                                 gssize          len)
+{
+    HildonTextViewPrivate *priv;
+    GtkTextBuffer *buffer;
+    GtkTextIter start;
+
+    g_return_if_fail (HILDON_IS_TEXT_VIEW (view));
+    g_return_if_fail (text != NULL);
+
+    priv = HILDON_TEXT_VIEW_GET_PRIVATE (view);
+
+    if (len < 0)
+        len = strlen (text);
+
+    g_return_if_fail (g_utf8_validate (text, len, NULL));
+
+    load_stop (priv);
+
+    buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+    gtk_text_buffer_set_text (buffer, "", 0);
+
+    priv->load_text = g_strndup (text, len);
+    priv->load_len = len;
+    priv->load_pos = 0;
+
+    if (len > 0 && load_append_chunk (view, HILDON_TEXT_VIEW_LOAD_FIRST_CHUNK)) {
+        gtk_text_buffer_get_start_iter (buffer, &start);
+        gtk_text_buffer_place_cursor (buffer, &start);
+
+        load_area_update (view);
+
+        /* Below the priority of redrawing and of the text view's own
+         * line validation, so the start of the text shows up first */
+        priv->load_id = gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                                   (GSourceFunc) on_load_idle,
+                                                   view, NULL);
+        g_signal_emit (view, signals[LOAD_PROGRESS], 0,
+                       (gdouble) priv->load_pos / priv->load_len);
+    } else {
+        load_stop (priv);
+        g_signal_emit (view, signals[LOAD_PROGRESS], 0, 1.0);
+    }
+}
+
+/**
+ * hildon_text_view_cancel_load:
+ * @view: a #HildonTextView
+ *
+ * Stops appending the text set with hildon_text_view_load_text(). The
+ * part already loaded stays in the buffer.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_text_view_cancel_load                    (HildonTextView *view)
+{
+    HildonTextViewPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_TEXT_VIEW (view));
+
+    priv = HILDON_TEXT_VIEW_GET_PRIVATE (view);
+    load_stop (priv);
+}
+
+/**
+ * hildon_text_view_is_loading:
+ * @view: a #HildonTextView
+ *
+ * Gets whether @view is still appending the text set with
+ * hildon_text_view_load_text().
+ *
+ * Returns: %TRUE if a load is in progress.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_text_view_is_loading                     (HildonTextView *view)
+{
+    HildonTextViewPrivate *priv;
+
+    g_return_val_if_fail (HILDON_IS_TEXT_VIEW (view), FALSE);
+
+    priv = HILDON_TEXT_VIEW_GET_PRIVATE (view);
+
+    return priv->load_id != 0;
 }
@@ -63,6 +63,17 @@ hildon_text_view_get_type                       (void) G_GNUC_CONST;
 GtkWidget *
 hildon_text_view_new                            (void);
 
+void
+hildon_text_view_load_text                      (HildonTextView *view,
+                                                 const gchar    *text,
+                                                 gssize          len);
+
+void
+hildon_text_view_cancel_load                    (HildonTextView *view);
+
+gboolean
+hildon_text_view_is_loading                     (HildonTextView *view);
+
 G_END_DECLS
 
 #endif /* __HILDON_TEXT_VIEW_H__ */
@@ -0,0 +1,701 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-thumbnail-loader
+ * @short_description: Decodes thumbnails for lists and grids in the background
+ *
+ * #HildonThumbnailLoader decodes image files into thumbnails in worker
+ * threads, for the pixbuf cells of a #GtkTreeView or #GtkIconView
+ * inside a #HildonPannableArea. Decoding the images from the cell
+ * data functions would stall scrolling on every new row.
+ *
+ * hildon_thumbnail_loader_get() returns the thumbnail if it is already
+ * loaded, and otherwise queues it and returns %NULL. When the
+ * thumbnail has been decoded #HildonThumbnailLoader::thumbnail-ready
+ * is emitted, and the row can be redrawn. Loaded thumbnails are kept,
+ * least recently used first out, within the memory given to
+ * hildon_thumbnail_loader_new().
+ *
+ * Each request has a position, in the coordinates of the vertical
+ * adjustment of the pannable area set with
+ * hildon_thumbnail_loader_set_pannable_area(). The thumbnails closest
+ * to the area the viewport shows, or is about to show while
+ * scrolling, are decoded first, and the requests for rows that have
+ * scrolled far away are cancelled.
+ *
+ * <example>
+ * <title>Thumbnails in a tree view</title>
+ * <programlisting>
+ * static void
+ * thumbnail_data_func (GtkTreeViewColumn *column,
+ *                      GtkCellRenderer   *renderer,
+ *                      GtkTreeModel      *model,
+ *                      GtkTreeIter       *iter,
+ *                      gpointer           data)
+ * {
+ *     HildonThumbnailLoader *loader = data;
+ *     GtkWidget *treeview = gtk_tree_view_column_get_tree_view (column);
+ *     GtkTreePath *path = gtk_tree_model_get_path (model, iter);
+ *     GdkRectangle area;
+ *     gint y;
+ *     gchar *filename;
+ * <!-- -->
+ *     gtk_tree_view_get_background_area (GTK_TREE_VIEW (treeview), path, column, &area);
+ *     gtk_tree_view_convert_bin_window_to_tree_coords (GTK_TREE_VIEW (treeview),
+ *                                                      0, area.y, NULL, &y);
+ *     gtk_tree_path_free (path);
+ * <!-- -->
+ *     gtk_tree_model_get (model, iter, FILENAME_COLUMN, &filename, -1);
+ *     g_object_set (renderer, "pixbuf",
+ *                   hildon_thumbnail_loader_get (loader, filename, y), NULL);
+ *     g_free (filename);
+ * }
+ * </programlisting>
+ * </example>
+ */
+
+#include                                        "hildon-thumbnail-loader.h"
+
+/* Default size of the thumbnails, in pixels */
+#define                                         HILDON_THUMBNAIL_LOADER_DEFAULT_SIZE 64
+
+/* Number of decoding threads */
+#define                                         HILDON_THUMBNAIL_LOADER_THREADS 2
+
+/* Requests farther than this many pages from the viewport are cancelled */
+#define                                         HILDON_THUMBNAIL_LOADER_KEEP_PAGES 2
+
+enum
+{
+    PROP_0,
+    PROP_SIZE,
+    PROP_MAX_MEMORY
+};
+
+enum
+{
+    THUMBNAIL_READY,
+    LAST_SIGNAL
+};
+
+static guint                                    signals[LAST_SIGNAL] = { 0 };
+
+/* What the loader shares with the decoding threads. It outlives the
+ * loader while decoded thumbnails are on their way to the main
+ * thread. */
+typedef struct
+{
+    gint ref_count;
+    GMutex lock;
+    GQueue waiting;                             /* ThumbnailJob, protected by lock */
+    gint top;                                   /* The viewport, protected by lock */
+    gint bottom;
+    gint size;
+    HildonThumbnailLoader *loader;              /* Main thread only, NULL once finalized */
+} ThumbnailQueue;
+
+typedef struct
+{
+    ThumbnailQueue *queue;
+    gchar *filename;
+    gint position;                              /* Protected by queue->lock */
+    gboolean waiting;                           /* Protected by queue->lock */
+    GCancellable *cancellable;
+    GdkPixbuf *pixbuf;
+} ThumbnailJob;
+
+typedef struct
+{
+    gchar *filename;
+    GdkPixbuf *pixbuf;                          /* NULL if the file could not be decoded */
+    gsize bytes;
+} CacheEntry;
+
+struct                                          _HildonThumbnailLoaderPrivate
+{
+    ThumbnailQueue *queue;
+    GThreadPool *pool;
+    GHashTable *jobs;                           /* filename -> ThumbnailJob */
+
+    GHashTable *cache;                          /* filename -> link in lru */
+    GQueue lru;                                 /* CacheEntry, most recently used first */
+    gsize bytes;
+    gsize max_memory;
+
+    HildonPannableArea *area;
+    GtkAdjustment *vadjustment;
+};
+
+G_DEFINE_TYPE                                   (HildonThumbnailLoader, hildon_thumbnail_loader, G_TYPE_OBJECT);
+
+#define                                         HILDON_THUMBNAIL_LOADER_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
+                                                HILDON_TYPE_THUMBNAIL_LOADER, HildonThumbnailLoaderPrivate))
+
+static void
+thumbnail_queue_unref                           (ThumbnailQueue *queue)
+{
+    if (g_atomic_int_dec_and_test (&queue->ref_count)) {
+        g_mutex_clear (&queue->lock);
+        g_slice_free (ThumbnailQueue, queue);
+    }
+}
+
+static void
+thumbnail_job_free                              (ThumbnailJob *job)
+{
+    thumbnail_queue_unref (job->queue);
+    g_free (job->filename);
+    g_object_unref (job->cancellable);
+    if (job->pixbuf)
+        g_object_unref (job->pixbuf);
+    g_slice_free (ThumbnailJob, job);
+}
+
+/* How far @position is from the viewport. Called with the lock held */
+static gint
+thumbnail_queue_distance                        (ThumbnailQueue *queue,
+                                                 gint            position)
+{
+    if (position < queue->top)
+        return queue->top - position;
+    if (position > queue->bottom)
+        return position - queue->bottom;
+    return 0;
+}
+
+static gboolean
+thumbnail_job_done                              (gpointer data)
+{
+    ThumbnailJob *job = data;
+    HildonThumbnailLoader *loader = job->queue->loader;
+
+    /* Jobs that were cancelled are no longer in the table */
+    if (loader && g_hash_table_lookup (loader->priv->jobs, job->filename) == job) {
+        HildonThumbnailLoaderPrivate *priv = loader->priv;
+        CacheEntry *entry;
+
+        g_hash_table_steal (priv->jobs, job->filename);
+
+        entry = g_slice_new (CacheEntry);
+        entry->filename = job->filename;
+        entry->pixbuf = job->pixbuf;
+        entry->bytes = entry->pixbuf ?
+            (gsize) gdk_pixbuf_get_rowstride (entry->pixbuf) * gdk_pixbuf_get_height (entry->pixbuf) : 0;
+        job->filename = NULL;
+        job->pixbuf = NULL;
+
+        g_queue_push_head (&priv->lru, entry);
+        g_hash_table_insert (priv->cache, entry->filename, priv->lru.head);
+        priv->bytes += entry->bytes;
+
+        /* Keep at least the thumbnail that was just loaded */
+        while (priv->bytes > priv->max_memory && priv->lru.length > 1) {
+            CacheEntry *old = g_queue_pop_tail (&priv->lru);
+
+            g_hash_table_remove (priv->cache, old->filename);
+            priv->bytes -= old->bytes;
+            g_free (old->filename);
+            if (old->pixbuf)
+                g_object_unref (old->pixbuf);
+            g_slice_free (CacheEntry, old);
+        }
+
+        g_signal_emit (loader, signals[THUMBNAIL_READY], 0, entry->filename);
+    }
+
+    thumbnail_job_free (job);
+
+    return FALSE;
+}
+
+/* Runs in the decoding threads. Each call decodes the waiting
+ * request closest to the viewport at that moment. */
+static void
+thumbnail_decode                                (gpointer data,
+                                                 gpointer user_data)
+{
+    ThumbnailQueue *queue = user_data;
+    ThumbnailJob *job = NULL;
+    GList *l;
+    GFile *file;
+    GFileInputStream *stream;
+    gint best = G_MAXINT;
+
+    g_mutex_lock (&queue->lock);
+    for (l = queue->waiting.head; l != NULL; l = l->next) {
+        ThumbnailJob *candidate = l->data;
+        gint distance = thumbnail_queue_distance (queue, candidate->position);
+
+        if (distance < best) {
+            best = distance;
+            job = candidate;
+        }
+    }
+    if (job) {
+        g_queue_remove (&queue->waiting, job);
+        job->waiting = FALSE;
+    }
+    g_mutex_unlock (&queue->lock);
+
+    /* The request this call was queued for was cancelled */
+    if (job == NULL)
+        return;
+
+    file = g_file_new_for_path (job->filename);
+    stream = g_file_read (file, job->cancellable, NULL);
+
+    if (stream) {
+        GdkPixbuf *pixbuf = gdk_pixbuf_new_from_stream_at_scale (G_INPUT_STREAM (stream),
+                                                                 queue->size, queue->size,
+                                                                 TRUE, job->cancellable, NULL);
+
+        if (pixbuf) {
+            job->pixbuf = gdk_pixbuf_apply_embedded_orientation (pixbuf);
+            g_object_unref (pixbuf);
+        }
+        g_object_unref (stream);
+    }
+    g_object_unref (file);
+
+    gdk_threads_add_idle (thumbnail_job_done, job);
+}
+
+static void
+hildon_thumbnail_loader_cancel                  (HildonThumbnailLoader *loader,
+                                                 ThumbnailJob          *job)
+{
+    ThumbnailQueue *queue = loader->priv->queue;
+    gboolean was_waiting;
+
+    g_mutex_lock (&queue->lock);
+    was_waiting = job->waiting;
+    if (was_waiting) {
+        g_queue_remove (&queue->waiting, job);
+        job->waiting = FALSE;
+    }
+    g_mutex_unlock (&queue->lock);
+
+    g_hash_table_steal (loader->priv->jobs, job->filename);
+
+    /* A job being decoded is freed once it is done */
+    if (was_waiting)
+        thumbnail_job_free (job);
+    else
+        g_cancellable_cancel (job->cancellable);
+}
+
+/* Moves the viewport requests are sorted by, and cancels those that
+ * are now too far from it */
+static void
+hildon_thumbnail_loader_set_viewport            (HildonThumbnailLoader *loader,
+                                                 gint                   top,
+                                                 gint                   bottom)
+{
+    HildonThumbnailLoaderPrivate *priv = loader->priv;
+    ThumbnailQueue *queue = priv->queue;
+    GHashTableIter iter;
+    gpointer job;
+    GSList *far = NULL;
+    gint keep;
+
+    g_mutex_lock (&queue->lock);
+    queue->top = top;
+    queue->bottom = bottom;
+    g_mutex_unlock (&queue->lock);
+
+    keep = (bottom - top) * HILDON_THUMBNAIL_LOADER_KEEP_PAGES;
+    if (keep <= 0)
+        return;
+
+    g_hash_table_iter_init (&iter, priv->jobs);
+    while (g_hash_table_iter_next (&iter, NULL, &job)) {
+        gint position;
+
+        g_mutex_lock (&queue->lock);
+        position = ((ThumbnailJob *) job)->position;
+        g_mutex_unlock (&queue->lock);
+
+        if (position < top - keep || position > bottom + keep)
+            far = g_slist_prepend (far, job);
+    }
+
+    while (far) {
+        hildon_thumbnail_loader_cancel (loader, far->data);
+        far = g_slist_delete_link (far, far);
+    }
+}
+
+static void
+vadjustment_changed                             (GtkAdjustment         *adjustment,
+                                                 HildonThumbnailLoader *loader)
+{
+    gint top = gtk_adjustment_get_value (adjustment);
+
+    hildon_thumbnail_loader_set_viewport (loader, top,
+                                          top + gtk_adjustment_get_page_size (adjustment));
+}
+
+static void
+predicted_viewport                              (HildonPannableArea    *area,
+                                                 GdkRectangle          *viewport,
+                                                 HildonThumbnailLoader *loader)
+{
+    hildon_thumbnail_loader_set_viewport (loader, viewport->y, viewport->y + viewport->height);
+}
+
+static void
+hildon_thumbnail_loader_set_property            (GObject      *object,
+                                                 guint         prop_id,
+                                                 const GValue *value,
+                                                 GParamSpec   *pspec)
+{
+    HildonThumbnailLoaderPrivate *priv = HILDON_THUMBNAIL_LOADER (object)->priv;
+
+    switch (prop_id)
+    {
+    case PROP_SIZE:
+        priv->queue->size = g_value_get_int (value);
+        break;
+    case PROP_MAX_MEMORY:
+        priv->max_memory = g_value_get_uint64 (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+hildon_thumbnail_loader_get_property            (GObject    *object,
+                                                 guint       prop_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonThumbnailLoaderPrivate *priv = HILDON_THUMBNAIL_LOADER (object)->priv;
+
+    switch (prop_id)
+    {
+    case PROP_SIZE:
+        g_value_set_int (value, priv->queue->size);
+        break;
+    case PROP_MAX_MEMORY:
+        g_value_set_uint64 (value, priv->max_memory);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+hildon_thumbnail_loader_dispose                 (GObject *object)
+{
+    hildon_thumbnail_loader_set_pannable_area (HILDON_THUMBNAIL_LOADER (object), NULL);
+
+    G_OBJECT_CLASS (hildon_thumbnail_loader_parent_class)->dispose (object);
+}
+
+static void
+hildon_thumbnail_loader_finalize                (GObject *object)
+{
+    HildonThumbnailLoader *loader = HILDON_THUMBNAIL_LOADER (object);
+    HildonThumbnailLoaderPrivate *priv = loader->priv;
+
+    hildon_thumbnail_loader_clear (loader);
+
+    /* The decodes in progress have just been cancelled, so waiting
+     * for them is short. Their results are dropped in the main
+     * thread, which is why the queue can outlive the loader. */
+    g_thread_pool_free (priv->pool, TRUE, TRUE);
+    priv->queue->loader = NULL;
+    thumbnail_queue_unref (priv->queue);
+
+    g_hash_table_destroy (priv->jobs);
+    g_hash_table_destroy (priv->cache);
+
+    G_OBJECT_CLASS (hildon_thumbnail_loader_parent_class)->finalize (object);
+}
+
+static void
+hildon_thumbnail_loader_class_init              (HildonThumbnailLoaderClass *klass)
+{
+    GObjectClass *gobject_class = (GObjectClass *) klass;
+
+    gobject_class->set_property = hildon_thumbnail_loader_set_property;
+    gobject_class->get_property = hildon_thumbnail_loader_get_property;
+    gobject_class->dispose = hildon_thumbnail_loader_dispose;
+    gobject_class->finalize = hildon_thumbnail_loader_finalize;
+
+    /**
+     * HildonThumbnailLoader:size:
+     *
+     * The size, in pixels, of the box the thumbnails are scaled to fit.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_SIZE,
+        g_param_spec_int (
+            "size",
+            "Size",
+            "Size of the thumbnails",
+            1, G_MAXINT, HILDON_THUMBNAIL_LOADER_DEFAULT_SIZE,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    /**
+     * HildonThumbnailLoader:max-memory:
+     *
+     * How many bytes of pixel data the loaded thumbnails can use.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_MAX_MEMORY,
+        g_param_spec_uint64 (
+            "max-memory",
+            "Maximum memory",
+            "Bytes of pixel data the loaded thumbnails can use",
+            0, G_MAXSIZE, 4 * 1024 * 1024,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    /**
+     * HildonThumbnailLoader::thumbnail-ready:
+     * @loader: the object which received the signal
+     * @filename: the file whose thumbnail was loaded
+     *
+     * Emitted when a thumbnail requested with
+     * hildon_thumbnail_loader_get() has been decoded, or could not be,
+     * so that the rows showing @filename can be redrawn. A new call to
+     * hildon_thumbnail_loader_get() returns the thumbnail.
+     *
+     * Since: 3.0
+     */
+    signals[THUMBNAIL_READY] =
+        g_signal_new ("thumbnail-ready",
+                      G_OBJECT_CLASS_TYPE (gobject_class),
+                      G_SIGNAL_RUN_LAST,
+                      G_STRUCT_OFFSET (HildonThumbnailLoaderClass, thumbnail_ready),
+                      NULL, NULL,
+                      g_cclosure_marshal_VOID__STRING,
+                      G_TYPE_NONE, 1, G_TYPE_STRING);
+
+    g_type_class_add_private (klass, sizeof (HildonThumbnailLoaderPrivate));
+}
+
+static void
+hildon_thumbnail_loader_init                    (HildonThumbnailLoader *self)
+{
+    HildonThumbnailLoaderPrivate *priv = HILDON_THUMBNAIL_LOADER_GET_PRIVATE (self);
+
+    self->priv = priv;
+
+    priv->queue = g_slice_new0 (ThumbnailQueue);
+    priv->queue->ref_count = 1;
+    g_mutex_init (&priv->queue->lock);
+    g_queue_init (&priv->queue->waiting);
+    priv->queue->loader = self;
+
+    priv->pool = g_thread_pool_new (thumbnail_decode, priv->queue,
+                                    HILDON_THUMBNAIL_LOADER_THREADS, FALSE, NULL);
+    priv->jobs = g_hash_table_new (g_str_hash, g_str_equal);
+    priv->cache = g_hash_table_new (g_str_hash, g_str_equal);
+    g_queue_init (&priv->lru);
+}
+
+/**
+ * hildon_thumbnail_loader_new:
+ * @size: the size, in pixels, of the box thumbnails are scaled to fit
+ * @max_memory: how many bytes of pixel data the loaded thumbnails can use
+ *
+ * Creates a new #HildonThumbnailLoader.
+ *
+ * Returns: a new #HildonThumbnailLoader
+ *
+ * Since: 3.0
+ **/
+HildonThumbnailLoader *
+hildon_thumbnail_loader_new                     (gint                   size,
+                                                 gsize                  max_memory)
+{
+    g_return_val_if_fail (size > 0, NULL);
+
+    return g_object_new (HILDON_TYPE_THUMBNAIL_LOADER,
+                         "size", size,
+                         "max-memory", (guint64) max_memory,
+                         NULL);
+}
+
+/**
+ * hildon_thumbnail_loader_get:
+ * @loader: a #HildonThumbnailLoader
+ * @filename: the image file
+ * @position: where the thumbnail is shown, in the coordinates of the
+ * vertical adjustment of the pannable area
+ *
+ * Gets the thumbnail of @filename. If it is not loaded yet, it is
+ * queued to be decoded, and #HildonThumbnailLoader::thumbnail-ready is
+ * emitted once it has been. Asking again for a thumbnail that is
+ * queued updates its @position.
+ *
+ * Returns: (transfer none): the thumbnail, or %NULL if it is not
+ * loaded or @filename could not be decoded.
+ *
+ * Since: 3.0
+ **/
+GdkPixbuf *
+hildon_thumbnail_loader_get                     (HildonThumbnailLoader *loader,
+                                                 const gchar           *filename,
+                                                 gint                   position)
+{
+    HildonThumbnailLoaderPrivate *priv;
+    ThumbnailJob *job;
+    GList *link;
+
+    g_return_val_if_fail (HILDON_IS_THUMBNAIL_LOADER (loader), NULL);
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    priv = loader->priv;
+
+    link = g_hash_table_lookup (priv->cache, filename);
+    if (link) {
+        g_queue_unlink (&priv->lru, link);
+        g_queue_push_head_link (&priv->lru, link);
+        return ((CacheEntry *) link->data)->pixbuf;
+    }
+
+    job = g_hash_table_lookup (priv->jobs, filename);
+    if (job) {
+        g_mutex_lock (&priv->queue->lock);
+        job->position = position;
+        g_mutex_unlock (&priv->queue->lock);
+        return NULL;
+    }
+
+    job = g_slice_new0 (ThumbnailJob);
+    job->queue = priv->queue;
+    g_atomic_int_inc (&priv->queue->ref_count);
+    job->filename = g_strdup (filename);
+    job->position = position;
+    job->waiting = TRUE;
+    job->cancellable = g_cancellable_new ();
+    g_hash_table_insert (priv->jobs, job->filename, job);
+
+    g_mutex_lock (&priv->queue->lock);
+    g_queue_push_tail (&priv->queue->waiting, job);
+    g_mutex_unlock (&priv->queue->lock);
+
+    /* Each call of the pool function decodes the best waiting job */
+    g_thread_pool_push (priv->pool, loader, NULL);
+
+    return NULL;
+}
+
+/**
+ * hildon_thumbnail_loader_set_pannable_area:
+ * @loader: a #HildonThumbnailLoader
+ * @area: (allow-none): the #HildonPannableArea showing the thumbnails, or %NULL
+ *
+ * Sets the pannable area whose viewport decides the order the
+ * thumbnails are decoded in. While it scrolls, the thumbnails about to
+ * become visible, as predicted by #HildonPannableArea::predicted-viewport,
+ * come first, and the requests for positions more than two pages away
+ * from the viewport are cancelled.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_thumbnail_loader_set_pannable_area       (HildonThumbnailLoader *loader,
+                                                 HildonPannableArea    *area)
+{
+    HildonThumbnailLoaderPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_THUMBNAIL_LOADER (loader));
+    g_return_if_fail (area == NULL || HILDON_IS_PANNABLE_AREA (area));
+
+    priv = loader->priv;
+
+    if (priv->area == area)
+        return;
+
+    if (priv->area) {
+        g_signal_handlers_disconnect_by_data (priv->area, loader);
+        g_signal_handlers_disconnect_by_data (priv->vadjustment, loader);
+        g_object_unref (priv->vadjustment);
+        g_object_unref (priv->area);
+        priv->vadjustment = NULL;
+        priv->area = NULL;
+    }
+
+    if (area) {
+        priv->area = g_object_ref (area);
+        priv->vadjustment = g_object_ref (hildon_pannable_area_get_vadjustment (area));
+
+        g_signal_connect (area, "predicted-viewport",
+                          G_CALLBACK (predicted_viewport), loader);
+        g_signal_connect (priv->vadjustment, "value-changed",
+                          G_CALLBACK (vadjustment_changed), loader);
+        g_signal_connect (priv->vadjustment, "changed",
+                          G_CALLBACK (vadjustment_changed), loader);
+
+        vadjustment_changed (priv->vadjustment, loader);
+    }
+}
+
+/**
+ * hildon_thumbnail_loader_clear:
+ * @loader: a #HildonThumbnailLoader
+ *
+ * Cancels all the queued requests and drops the loaded thumbnails,
+ * e.g. when the files shown change.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_thumbnail_loader_clear                   (HildonThumbnailLoader *loader)
+{
+    HildonThumbnailLoaderPrivate *priv;
+    CacheEntry *entry;
+    GList *jobs;
+
+    g_return_if_fail (HILDON_IS_THUMBNAIL_LOADER (loader));
+
+    priv = loader->priv;
+
+    jobs = g_hash_table_get_values (priv->jobs);
+    while (jobs) {
+        hildon_thumbnail_loader_cancel (loader, jobs->data);
+        jobs = g_list_delete_link (jobs, jobs);
+    }
+
+    g_hash_table_remove_all (priv->cache);
+    while ((entry = g_queue_pop_head (&priv->lru)) != NULL) {
+        g_free (entry->filename);
+        if (entry->pixbuf)
+            g_object_unref (entry->pixbuf);
+        g_slice_free (CacheEntry, entry);
+    }
+    priv->bytes = 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_THUMBNAIL_LOADER_H__
+#define                                         __HILDON_THUMBNAIL_LOADER_H__
+
+#include                                        "hildon-pannable-area.h"
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_THUMBNAIL_LOADER \
+                                                (hildon_thumbnail_loader_get_type())
+
+#define                                         HILDON_THUMBNAIL_LOADER(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_THUMBNAIL_LOADER, HildonThumbnailLoader))
+
+#define                                         HILDON_THUMBNAIL_LOADER_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                                HILDON_TYPE_THUMBNAIL_LOADER, HildonThumbnailLoaderClass))
+
+#define                                         HILDON_IS_THUMBNAIL_LOADER(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HILDON_TYPE_THUMBNAIL_LOADER))
+
+#define                                         HILDON_IS_THUMBNAIL_LOADER_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_TYPE ((klass), HILDON_TYPE_THUMBNAIL_LOADER))
+
+#define                                         HILDON_THUMBNAIL_LOADER_GET_CLASS(obj) \
+                                                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                                HILDON_TYPE_THUMBNAIL_LOADER, HildonThumbnailLoaderClass))
+
+typedef struct                                  _HildonThumbnailLoader HildonThumbnailLoader;
+
+typedef struct                                  _HildonThumbnailLoaderClass HildonThumbnailLoaderClass;
+
+typedef struct                                  _HildonThumbnailLoaderPrivate HildonThumbnailLoaderPrivate;
+
+struct                                          _HildonThumbnailLoaderClass
+{
+    GObjectClass parent_class;
+
+    void (*thumbnail_ready)                     (HildonThumbnailLoader *loader,
+                                                 const gchar           *filename);
+};
+
+struct                                          _HildonThumbnailLoader
+{
+    GObject parent;
+
+    /* private */
+    HildonThumbnailLoaderPrivate *priv;
+};
+
+GType
+hildon_thumbnail_loader_get_type                (void) G_GNUC_CONST;
+
+HildonThumbnailLoader *
+hildon_thumbnail_loader_new                     (gint                   size,
+                                                 gsize                  max_memory);
+
+GdkPixbuf *
+hildon_thumbnail_loader_get                     (HildonThumbnailLoader *loader,
+                                                 const gchar           *filename,
+                                                 gint                   position);
+
+void
+hildon_thumbnail_loader_set_pannable_area       (HildonThumbnailLoader *loader,
+                                                 HildonPannableArea    *area);
+
+void
+hildon_thumbnail_loader_clear                   (HildonThumbnailLoader *loader);
+
+G_END_DECLS
+
+#endif /* __HILDON_THUMBNAIL_LOADER_H__ */
@@ -0,0 +1,1132 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-tile-grid
+ * @short_description: A grid of same-sized tiles for image galleries
+ * @see_also: #HildonPannableArea, #HildonThumbnailLoader
+ *
+ * #HildonTileGrid shows the rows of a #GtkTreeModel list as a grid of
+ * tiles, each with a thumbnail and a line of text under it. Unlike
+ * #GtkIconView it does not measure its items: all the tiles have the
+ * size given to hildon_tile_grid_new(), so where any item is shown is
+ * known without looking at the others, and only the tiles in view are
+ * ever read from the model and drawn. This keeps galleries of tens of
+ * thousands of items as fast as small ones.
+ *
+ * The thumbnails are taken from a #HildonThumbnailLoader, set with
+ * hildon_tile_grid_set_thumbnail_loader(), for the files named in the
+ * column set with hildon_tile_grid_set_filename_column(). The tiles are
+ * redrawn as their thumbnails get decoded.
+ *
+ * The grid is scrollable, so it is put directly in a
+ * #HildonPannableArea, without a viewport. Tapping a tile emits
+ * #HildonTileGrid::item-activated.
+ *
+ * <example>
+ * <title>A gallery</title>
+ * <programlisting>
+ * loader = hildon_thumbnail_loader_new (120, 8 * 1024 * 1024);
+ * grid = hildon_tile_grid_new (model, 160, 160);
+ * hildon_tile_grid_set_filename_column (HILDON_TILE_GRID (grid), FILENAME_COLUMN);
+ * hildon_tile_grid_set_text_column (HILDON_TILE_GRID (grid), NAME_COLUMN);
+ * hildon_tile_grid_set_thumbnail_loader (HILDON_TILE_GRID (grid), loader);
+ * <!-- -->
+ * area = hildon_pannable_area_new ();
+ * gtk_container_add (GTK_CONTAINER (area), grid);
+ * hildon_thumbnail_loader_set_pannable_area (loader, HILDON_PANNABLE_AREA (area));
+ * </programlisting>
+ * </example>
+ */
+
+#include                                        "hildon-tile-grid.h"
+
+/* Space between the thumbnail and the text, in pixels */
+#define                                         HILDON_TILE_GRID_TEXT_SPACING 4
+
+enum
+{
+    PROP_0,
+    PROP_MODEL,
+    PROP_TILE_WIDTH,
+    PROP_TILE_HEIGHT,
+    PROP_FILENAME_COLUMN,
+    PROP_TEXT_COLUMN,
+    PROP_THUMBNAIL_LOADER,
+    PROP_HADJUSTMENT,
+    PROP_VADJUSTMENT,
+    PROP_HSCROLL_POLICY,
+    PROP_VSCROLL_POLICY
+};
+
+enum
+{
+    ITEM_ACTIVATED,
+    LAST_SIGNAL
+};
+
+static guint                                    signals[LAST_SIGNAL] = { 0 };
+
+struct                                          _HildonTileGridPrivate
+{
+    GtkTreeModel *model;
+    gint n_items;
+    gint tile_width;
+    gint tile_height;
+    gint filename_column;
+    gint text_column;
+
+    HildonThumbnailLoader *loader;
+
+    /* The item under the finger, or -1 */
+    gint pressed;
+
+    /* The vertical offset the window contents were drawn at */
+    gint offset;
+
+    GtkAdjustment *hadjustment;
+    GtkAdjustment *vadjustment;
+    guint hscroll_policy : 1;
+    guint vscroll_policy : 1;
+};
+
+G_DEFINE_TYPE_WITH_CODE                         (HildonTileGrid, hildon_tile_grid, GTK_TYPE_WIDGET,
+                                                 G_IMPLEMENT_INTERFACE (GTK_TYPE_SCROLLABLE, NULL));
+
+#define                                         HILDON_TILE_GRID_GET_PRIVATE(obj) \
+                                                (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
+                                                HILDON_TYPE_TILE_GRID, HildonTileGridPrivate))
+
+static gint
+hildon_tile_grid_get_n_columns                  (HildonTileGrid *grid,
+                                                 gint            width)
+{
+    return MAX (1, width / grid->priv->tile_width);
+}
+
+static gint
+hildon_tile_grid_get_n_rows                     (HildonTileGrid *grid,
+                                                 gint            width)
+{
+    gint n_columns = hildon_tile_grid_get_n_columns (grid, width);
+
+    return (grid->priv->n_items + n_columns - 1) / n_columns;
+}
+
+/* Where the tile of item @index is, in the coordinates of the window */
+static void
+hildon_tile_grid_get_tile_area                  (HildonTileGrid *grid,
+                                                 gint            index,
+                                                 GdkRectangle   *area)
+{
+    HildonTileGridPrivate *priv = grid->priv;
+    gint width = gtk_widget_get_allocated_width (GTK_WIDGET (grid));
+    gint n_columns = hildon_tile_grid_get_n_columns (grid, width);
+    gint cell_width = MAX (priv->tile_width, width / n_columns);
+
+    area->x = (index % n_columns) * cell_width + (cell_width - priv->tile_width) / 2;
+    area->y = (index / n_columns) * priv->tile_height - priv->offset;
+    area->width = priv->tile_width;
+    area->height = priv->tile_height;
+}
+
+/* The item at @x, @y in the coordinates of the window, or -1 */
+static gint
+hildon_tile_grid_get_index_at_pos               (HildonTileGrid *grid,
+                                                 gint            x,
+                                                 gint            y)
+{
+    HildonTileGridPrivate *priv = grid->priv;
+    gint width = gtk_widget_get_allocated_width (GTK_WIDGET (grid));
+    gint n_columns = hildon_tile_grid_get_n_columns (grid, width);
+    gint cell_width = MAX (priv->tile_width, width / n_columns);
+    gint column, index;
+
+    if (x < 0 || y + priv->offset < 0)
+        return -1;
+
+    column = x / cell_width;
+    if (column >= n_columns)
+        return -1;
+
+    index = ((y + priv->offset) / priv->tile_height) * n_columns + column;
+
+    return index < priv->n_items ? index : -1;
+}
+
+static void
+hildon_tile_grid_queue_draw_item                (HildonTileGrid *grid,
+                                                 gint            index)
+{
+    GdkRectangle area;
+
+    if (index < 0)
+        return;
+
+    hildon_tile_grid_get_tile_area (grid, index, &area);
+    gtk_widget_queue_draw_area (GTK_WIDGET (grid), area.x, area.y, area.width, area.height);
+}
+
+static void
+hildon_tile_grid_set_pressed                    (HildonTileGrid *grid,
+                                                 gint            index)
+{
+    HildonTileGridPrivate *priv = grid->priv;
+
+    if (priv->pressed == index)
+        return;
+
+    hildon_tile_grid_queue_draw_item (grid, priv->pressed);
+    priv->pressed = index;
+    hildon_tile_grid_queue_draw_item (grid, priv->pressed);
+}
+
+static void
+hildon_tile_grid_configure_adjustments          (HildonTileGrid *grid)
+{
+    HildonTileGridPrivate *priv = grid->priv;
+    gint width = gtk_widget_get_allocated_width (GTK_WIDGET (grid));
+    gint height = gtk_widget_get_allocated_height (GTK_WIDGET (grid));
+    gdouble upper = (gdouble) hildon_tile_grid_get_n_rows (grid, width) * priv->tile_height;
+
+    if (priv->hadjustment)
+        gtk_adjustment_configure (priv->hadjustment, 0, 0, width,
+                                  width * 0.1, width * 0.9, width);
+
+    if (priv->vadjustment)
+        gtk_adjustment_configure (priv->vadjustment,
+                                  CLAMP (gtk_adjustment_get_value (priv->vadjustment),
+                                         0, MAX (0, upper - height)),
+                                  0, MAX (upper, height),
+                                  priv->tile_height, height * 0.9, height);
+}
+
+static void
+hildon_tile_grid_value_changed                  (GtkAdjustment  *adjustment,
+                                                 HildonTileGrid *grid)
+{
+    HildonTileGridPrivate *priv = grid->priv;
+    gint offset = (gint) gtk_adjustment_get_value (priv->vadjustment);
+
+    if (offset == priv->offset)
+        return;
+
+    /* A scroll is a pan, not a tap */
+    hildon_tile_grid_set_pressed (grid, -1);
+
+    /* Only the tiles scrolled into view need to be drawn */
+    if (gtk_widget_get_realized (GTK_WIDGET (grid)))
+        gdk_window_scroll (gtk_widget_get_window (GTK_WIDGET (grid)), 0, priv->offset - offset);
+
+    priv->offset = offset;
+}
+
+static void
+hildon_tile_grid_set_adjustment                 (HildonTileGrid *grid,
+                                                 GtkAdjustment **slot,
+                                                 GtkAdjustment  *adjustment)
+{
+    if (adjustment && *slot == adjustment)
+        return;
+
+    if (*slot) {
+        g_signal_handlers_disconnect_by_func (*slot, hildon_tile_grid_value_changed, grid);
+        g_object_unref (*slot);
+    }
+
+    if (adjustment == NULL)
+        adjustment = gtk_adjustment_new (0, 0, 0, 0, 0, 0);
+
+    *slot = g_object_ref_sink (adjustment);
+
+    if (slot == &grid->priv->vadjustment) {
+        g_signal_connect (adjustment, "value-changed",
+                          G_CALLBACK (hildon_tile_grid_value_changed), grid);
+        grid->priv->offset = (gint) gtk_adjustment_get_value (adjustment);
+    }
+
+    hildon_tile_grid_configure_adjustments (grid);
+}
+
+static void
+hildon_tile_grid_rows_changed                   (HildonTileGrid *grid)
+{
+    HildonTileGridPrivate *priv = grid->priv;
+
+    priv->n_items = gtk_tree_model_iter_n_children (priv->model, NULL);
+    priv->pressed = -1;
+    gtk_widget_queue_resize (GTK_WIDGET (grid));
+}
+
+static void
+hildon_tile_grid_row_changed                    (GtkTreeModel   *model,
+                                                 GtkTreePath    *path,
+                                                 GtkTreeIter    *iter,
+                                                 HildonTileGrid *grid)
+{
+    hildon_tile_grid_queue_draw_item (grid, gtk_tree_path_get_indices (path)[0]);
+}
+
+static void
+hildon_tile_grid_thumbnail_ready                (HildonThumbnailLoader *loader,
+                                                 const gchar           *filename,
+                                                 HildonTileGrid        *grid)
+{
+    /* Redraws are coalesced by frame, so a burst of thumbnails costs
+     * one redraw of the visible tiles */
+    gtk_widget_queue_draw (GTK_WIDGET (grid));
+}
+
+static void
+hildon_tile_grid_draw_tile                      (HildonTileGrid *grid,
+                                                 cairo_t        *cr,
+                                                 PangoLayout    *layout,
+                                                 gint            index,
+                                                 GtkTreeIter    *iter)
+{
+    HildonTileGridPrivate *priv = grid->priv;
+    GtkStyleContext *context = gtk_widget_get_style_context (GTK_WIDGET (grid));
+    GdkRectangle area;
+    gint text_height = 0;
+
+    hildon_tile_grid_get_tile_area (grid, index, &area);
+
+    gtk_style_context_save (context);
+    if (index == priv->pressed) {
+        gtk_style_context_set_state (context, GTK_STATE_FLAG_ACTIVE);
+        gtk_render_background (context, cr, area.x, area.y, area.width, area.height);
+    }
+
+    if (priv->text_column >= 0) {
+        gchar *text;
+
+        gtk_tree_model_get (priv->model, iter, priv->text_column, &text, -1);
+        pango_layout_set_text (layout, text ? text : "", -1);
+        pango_layout_get_pixel_size (layout, NULL, &text_height);
+        gtk_render_layout (context, cr, area.x, area.y + area.height - text_height, layout);
+        text_height += HILDON_TILE_GRID_TEXT_SPACING;
+        g_free (text);
+    }
+
+    if (priv->filename_column >= 0 && priv->loader) {
+        GdkPixbuf *pixbuf = NULL;
+        gchar *filename;
+
+        gtk_tree_model_get (priv->model, iter, priv->filename_column, &filename, -1);
+        if (filename)
+            pixbuf = hildon_thumbnail_loader_get (priv->loader, filename,
+                                                  area.y + priv->offset);
+
+        if (pixbuf) {
+            gint image_height = area.height - text_height;
+
+            gtk_render_icon (context, cr, pixbuf,
+                             area.x + (area.width - gdk_pixbuf_get_width (pixbuf)) / 2,
+                             area.y + MAX (0, (image_height - gdk_pixbuf_get_height (pixbuf)) / 2));
+        }
+
+        g_free (filename);
+    }
+
+    gtk_style_context_restore (context);
+}
+
+static gboolean
+hildon_tile_grid_draw                           (GtkWidget *widget,
+                                                 cairo_t   *cr)
+{
+    HildonTileGrid *grid = HILDON_TILE_GRID (widget);
+    HildonTileGridPrivate *priv = grid->priv;
+    gint width = gtk_widget_get_allocated_width (widget);
+    gint n_columns = hildon_tile_grid_get_n_columns (grid, width);
+    GdkRectangle clip;
+    PangoLayout *layout;
+    GtkTreeIter iter;
+    gint first, last, index;
+
+    gtk_render_background (gtk_widget_get_style_context (widget), cr, 0, 0,
+                           width, gtk_widget_get_allocated_height (widget));
+
+    if (priv->model == NULL || priv->n_items == 0 ||
+        !gdk_cairo_get_clip_rectangle (cr, &clip))
+        return FALSE;
+
+    /* Only the items of the rows in the clip area are read */
+    first = MAX (0, (clip.y + priv->offset) / priv->tile_height) * n_columns;
+    last = MIN (priv->n_items,
+                ((clip.y + clip.height + priv->offset - 1) / priv->tile_height + 1) * n_columns);
+
+    if (first >= last || !gtk_tree_model_iter_nth_child (priv->model, &iter, NULL, first))
+        return FALSE;
+
+    layout = gtk_widget_create_pango_layout (widget, NULL);
+    pango_layout_set_width (layout, priv->tile_width * PANGO_SCALE);
+    pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+    pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
+
+    index = first;
+    do {
+        hildon_tile_grid_draw_tile (grid, cr, layout, index, &iter);
+    } while (++index < last && gtk_tree_model_iter_next (priv->model, &iter));
+
+    g_object_unref (layout);
+
+    return FALSE;
+}
+
+static void
+hildon_tile_grid_realize                        (GtkWidget *widget)
+{
+    GtkAllocation allocation;
+    GdkWindowAttr attributes;
+    GdkWindow *window;
+
+    gtk_widget_set_realized (widget, TRUE);
+    gtk_widget_get_allocation (widget, &allocation);
+
+    attributes.window_type = GDK_WINDOW_CHILD;
+    attributes.x = allocation.x;
+    attributes.y = allocation.y;
+    attributes.width = allocation.width;
+    attributes.height = allocation.height;
+    attributes.wclass = GDK_INPUT_OUTPUT;
+    attributes.visual = gtk_widget_get_visual (widget);
+    attributes.event_mask = gtk_widget_get_events (widget) | GDK_EXPOSURE_MASK |
+        GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK;
+
+    window = gdk_window_new (gtk_widget_get_parent_window (widget), &attributes,
+                             GDK_WA_X | GDK_WA_Y | GDK_WA_VISUAL);
+    gtk_widget_set_window (widget, window);
+    gtk_widget_register_window (widget, window);
+}
+
+static GtkSizeRequestMode
+hildon_tile_grid_get_request_mode               (GtkWidget *widget)
+{
+    return GTK_SIZE_REQUEST_HEIGHT_FOR_WIDTH;
+}
+
+static void
+hildon_tile_grid_get_preferred_width            (GtkWidget *widget,
+                                                 gint      *minimum,
+                                                 gint      *natural)
+{
+    *minimum = *natural = HILDON_TILE_GRID (widget)->priv->tile_width;
+}
+
+static void
+hildon_tile_grid_get_preferred_height_for_width (GtkWidget *widget,
+                                                 gint       width,
+                                                 gint      *minimum,
+                                                 gint      *natural)
+{
+    HildonTileGrid *grid = HILDON_TILE_GRID (widget);
+    HildonTileGridPrivate *priv = grid->priv;
+
+    *minimum = priv->n_items > 0 ? priv->tile_height : 0;
+    *natural = hildon_tile_grid_get_n_rows (grid, width) * priv->tile_height;
+}
+
+static void
+hildon_tile_grid_get_preferred_height           (GtkWidget *widget,
+                                                 gint      *minimum,
+                                                 gint      *natural)
+{
+    hildon_tile_grid_get_preferred_height_for_width (widget,
+                                                     HILDON_TILE_GRID (widget)->priv->tile_width,
+                                                     minimum, natural);
+}
+
+static void
+hildon_tile_grid_size_allocate                  (GtkWidget     *widget,
+                                                 GtkAllocation *allocation)
+{
+    HildonTileGrid *grid = HILDON_TILE_GRID (widget);
+
+    gtk_widget_set_allocation (widget, allocation);
+
+    if (gtk_widget_get_realized (widget))
+        gdk_window_move_resize (gtk_widget_get_window (widget),
+                                allocation->x, allocation->y,
+                                allocation->width, allocation->height);
+
+    /* Clamping the adjustment may scroll, which redraws what it needs */
+    hildon_tile_grid_configure_adjustments (grid);
+}
+
+static gboolean
+hildon_tile_grid_button_press                   (GtkWidget      *widget,
+                                                 GdkEventButton *event)
+{
+    HildonTileGrid *grid = HILDON_TILE_GRID (widget);
+
+    if (event->button != 1 || event->type != GDK_BUTTON_PRESS)
+        return FALSE;
+
+    hildon_tile_grid_set_pressed (grid, hildon_tile_grid_get_index_at_pos (grid, event->x, event->y));
+
+    return TRUE;
+}
+
+static gboolean
+hildon_tile_grid_button_release                 (GtkWidget      *widget,
+                                                 GdkEventButton *event)
+{
+    HildonTileGrid *grid = HILDON_TILE_GRID (widget);
+    HildonTileGridPrivate *priv = grid->priv;
+    gint index;
+
+    if (event->button != 1)
+        return FALSE;
+
+    index = priv->pressed;
+    hildon_tile_grid_set_pressed (grid, -1);
+
+    if (index >= 0 && index == hildon_tile_grid_get_index_at_pos (grid, event->x, event->y)) {
+        GtkTreePath *path = gtk_tree_path_new_from_indices (index, -1);
+
+        g_signal_emit (grid, signals[ITEM_ACTIVATED], 0, path);
+        gtk_tree_path_free (path);
+    }
+
+    return TRUE;
+}
+
+static void
+hildon_tile_grid_set_property                   (GObject      *object,
+                                                 guint         prop_id,
+                                                 const GValue *value,
+                                                 GParamSpec   *pspec)
+{
+    HildonTileGrid *grid = HILDON_TILE_GRID (object);
+    HildonTileGridPrivate *priv = grid->priv;
+
+    switch (prop_id)
+    {
+        case PROP_MODEL:
+            hildon_tile_grid_set_model (grid, g_value_get_object (value));
+            break;
+        case PROP_TILE_WIDTH:
+            hildon_tile_grid_set_tile_size (grid, g_value_get_int (value), priv->tile_height);
+            break;
+        case PROP_TILE_HEIGHT:
+            hildon_tile_grid_set_tile_size (grid, priv->tile_width, g_value_get_int (value));
+            break;
+        case PROP_FILENAME_COLUMN:
+            hildon_tile_grid_set_filename_column (grid, g_value_get_int (value));
+            break;
+        case PROP_TEXT_COLUMN:
+            hildon_tile_grid_set_text_column (grid, g_value_get_int (value));
+            break;
+        case PROP_THUMBNAIL_LOADER:
+            hildon_tile_grid_set_thumbnail_loader (grid, g_value_get_object (value));
+            break;
+        case PROP_HADJUSTMENT:
+            hildon_tile_grid_set_adjustment (grid, &priv->hadjustment,
+                                             g_value_get_object (value));
+            break;
+        case PROP_VADJUSTMENT:
+            hildon_tile_grid_set_adjustment (grid, &priv->vadjustment,
+                                             g_value_get_object (value));
+            break;
+        case PROP_HSCROLL_POLICY:
+            priv->hscroll_policy = g_value_get_enum (value);
+            break;
+        case PROP_VSCROLL_POLICY:
+            priv->vscroll_policy = g_value_get_enum (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+hildon_tile_grid_get_property                   (GObject    *object,
+                                                 guint       prop_id,
+                                                 GValue     *value,
+                                                 GParamSpec *pspec)
+{
+    HildonTileGridPrivate *priv = HILDON_TILE_GRID (object)->priv;
+
+    switch (prop_id)
+    {
+        case PROP_MODEL:
+            g_value_set_object (value, priv->model);
+            break;
+        case PROP_TILE_WIDTH:
+            g_value_set_int (value, priv->tile_width);
+            break;
+        case PROP_TILE_HEIGHT:
+            g_value_set_int (value, priv->tile_height);
+            break;
+        case PROP_FILENAME_COLUMN:
+            g_value_set_int (value, priv->filename_column);
+            break;
+        case PROP_TEXT_COLUMN:
+            g_value_set_int (value, priv->text_column);
+            break;
+        case PROP_THUMBNAIL_LOADER:
+            g_value_set_object (value, priv->loader);
+            break;
+        case PROP_HADJUSTMENT:
+            g_value_set_object (value, priv->hadjustment);
+            break;
+        case PROP_VADJUSTMENT:
+            g_value_set_object (value, priv->vadjustment);
+            break;
+        case PROP_HSCROLL_POLICY:
+            g_value_set_enum (value, priv->hscroll_policy);
+            break;
+        case PROP_VSCROLL_POLICY:
+            g_value_set_enum (value, priv->vscroll_policy);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+hildon_tile_grid_dispose                        (GObject *object)
+{
+    HildonTileGrid *grid = HILDON_TILE_GRID (object);
+    HildonTileGridPrivate *priv = grid->priv;
+
+    hildon_tile_grid_set_model (grid, NULL);
+    hildon_tile_grid_set_thumbnail_loader (grid, NULL);
+
+    g_clear_object (&priv->hadjustment);
+
+    if (priv->vadjustment) {
+        g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                              hildon_tile_grid_value_changed, grid);
+        g_clear_object (&priv->vadjustment);
+    }
+
+    G_OBJECT_CLASS (hildon_tile_grid_parent_class)->dispose (object);
+}
+
+static void
+hildon_tile_grid_class_init                     (HildonTileGridClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+    gobject_class->set_property = hildon_tile_grid_set_property;
+    gobject_class->get_property = hildon_tile_grid_get_property;
+    gobject_class->dispose = hildon_tile_grid_dispose;
+
+    widget_class->realize = hildon_tile_grid_realize;
+    widget_class->get_request_mode = hildon_tile_grid_get_request_mode;
+    widget_class->get_preferred_width = hildon_tile_grid_get_preferred_width;
+    widget_class->get_preferred_height = hildon_tile_grid_get_preferred_height;
+    widget_class->get_preferred_height_for_width = hildon_tile_grid_get_preferred_height_for_width;
+    widget_class->size_allocate = hildon_tile_grid_size_allocate;
+    widget_class->draw = hildon_tile_grid_draw;
+    widget_class->button_press_event = hildon_tile_grid_button_press;
+    widget_class->button_release_event = hildon_tile_grid_button_release;
+
+    /**
+     * HildonTileGrid:model:
+     *
+     * The list shown, one tile per row.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_MODEL,
+        g_param_spec_object (
+            "model",
+            "Model",
+            "The list shown",
+            GTK_TYPE_TREE_MODEL,
+            G_PARAM_READWRITE));
+
+    /**
+     * HildonTileGrid:tile-width:
+     *
+     * The width of every tile, in pixels.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_TILE_WIDTH,
+        g_param_spec_int (
+            "tile-width",
+            "Tile width",
+            "Width of every tile, in pixels",
+            1, G_MAXINT, 128,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
+    /**
+     * HildonTileGrid:tile-height:
+     *
+     * The height of every tile, in pixels.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_TILE_HEIGHT,
+        g_param_spec_int (
+            "tile-height",
+            "Tile height",
+            "Height of every tile, in pixels",
+            1, G_MAXINT, 128,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
+    /**
+     * HildonTileGrid:filename-column:
+     *
+     * The string column of the model with the files the thumbnails
+     * are made of, or -1 for no thumbnails.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_FILENAME_COLUMN,
+        g_param_spec_int (
+            "filename-column",
+            "Filename column",
+            "Model column with the files of the thumbnails",
+            -1, G_MAXINT, -1,
+            G_PARAM_READWRITE));
+
+    /**
+     * HildonTileGrid:text-column:
+     *
+     * The string column of the model with the text of the tiles, or -1
+     * for no text.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_TEXT_COLUMN,
+        g_param_spec_int (
+            "text-column",
+            "Text column",
+            "Model column with the text of the tiles",
+            -1, G_MAXINT, -1,
+            G_PARAM_READWRITE));
+
+    /**
+     * HildonTileGrid:thumbnail-loader:
+     *
+     * The #HildonThumbnailLoader the thumbnails are taken from.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (
+        gobject_class,
+        PROP_THUMBNAIL_LOADER,
+        g_param_spec_object (
+            "thumbnail-loader",
+            "Thumbnail loader",
+            "The loader the thumbnails are taken from",
+            HILDON_TYPE_THUMBNAIL_LOADER,
+            G_PARAM_READWRITE));
+
+    g_object_class_override_property (gobject_class, PROP_HADJUSTMENT, "hadjustment");
+    g_object_class_override_property (gobject_class, PROP_VADJUSTMENT, "vadjustment");
+    g_object_class_override_property (gobject_class, PROP_HSCROLL_POLICY, "hscroll-policy");
+    g_object_class_override_property (gobject_class, PROP_VSCROLL_POLICY, "vscroll-policy");
+
+    /**
+     * HildonTileGrid::item-activated:
+     * @grid: the #HildonTileGrid
+     * @path: the #GtkTreePath of the item
+     *
+     * Emitted when a tile is tapped.
+     *
+     * Since: 3.0
+     */
+    signals[ITEM_ACTIVATED] =
+        g_signal_new ("item-activated",
+                      G_OBJECT_CLASS_TYPE (gobject_class),
+                      G_SIGNAL_RUN_LAST,
+                      G_STRUCT_OFFSET (HildonTileGridClass, item_activated),
+                      NULL, NULL,
+                      g_cclosure_marshal_VOID__BOXED,
+                      G_TYPE_NONE, 1, GTK_TYPE_TREE_PATH);
+
+    g_type_class_add_private (klass, sizeof (HildonTileGridPrivate));
+}
+
+static void
+hildon_tile_grid_init                           (HildonTileGrid *self)
+{
+    HildonTileGridPrivate *priv = HILDON_TILE_GRID_GET_PRIVATE (self);
+
+    self->priv = priv;
+
+    priv->filename_column = -1;
+    priv->text_column = -1;
+    priv->pressed = -1;
+
+    gtk_widget_set_has_window (GTK_WIDGET (self), TRUE);
+    gtk_widget_set_redraw_on_allocate (GTK_WIDGET (self), FALSE);
+}
+
+/**
+ * hildon_tile_grid_new:
+ * @model: (allow-none): a #GtkTreeModel list, or %NULL
+ * @tile_width: the width of the tiles, in pixels
+ * @tile_height: the height of the tiles, in pixels
+ *
+ * Creates a new #HildonTileGrid showing @model. The tiles are empty
+ * until the columns to show are set, see
+ * hildon_tile_grid_set_filename_column() and
+ * hildon_tile_grid_set_text_column().
+ *
+ * Returns: a new #HildonTileGrid
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_tile_grid_new                            (GtkTreeModel *model,
+                                                 gint          tile_width,
+                                                 gint          tile_height)
+{
+    return g_object_new (HILDON_TYPE_TILE_GRID,
+                         "model", model,
+                         "tile-width", tile_width,
+                         "tile-height", tile_height,
+                         NULL);
+}
+
+/**
+ * hildon_tile_grid_set_model:
+ * @grid: a #HildonTileGrid
+ * @model: (allow-none): a #GtkTreeModel list, or %NULL
+ *
+ * Sets the list shown by @grid. Only the top level rows of @model are
+ * shown.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_tile_grid_set_model                      (HildonTileGrid *grid,
+                                                 GtkTreeModel   *model)
+{
+    HildonTileGridPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_TILE_GRID (grid));
+    g_return_if_fail (model == NULL || GTK_IS_TREE_MODEL (model));
+
+    priv = grid->priv;
+
+    if (priv->model == model)
+        return;
+
+    if (priv->model) {
+        g_signal_handlers_disconnect_by_func (priv->model,
+                                              hildon_tile_grid_rows_changed, grid);
+        g_signal_handlers_disconnect_by_func (priv->model,
+                                              hildon_tile_grid_row_changed, grid);
+        g_object_unref (priv->model);
+    }
+
+    priv->model = model;
+    priv->n_items = 0;
+    priv->pressed = -1;
+
+    if (model) {
+        g_object_ref (model);
+        g_signal_connect_swapped (model, "row-inserted",
+                                  G_CALLBACK (hildon_tile_grid_rows_changed), grid);
+        g_signal_connect_swapped (model, "row-deleted",
+                                  G_CALLBACK (hildon_tile_grid_rows_changed), grid);
+        g_signal_connect_swapped (model, "rows-reordered",
+                                  G_CALLBACK (hildon_tile_grid_rows_changed), grid);
+        g_signal_connect (model, "row-changed",
+                          G_CALLBACK (hildon_tile_grid_row_changed), grid);
+        priv->n_items = gtk_tree_model_iter_n_children (model, NULL);
+    }
+
+    gtk_widget_queue_resize (GTK_WIDGET (grid));
+    g_object_notify (G_OBJECT (grid), "model");
+}
+
+/**
+ * hildon_tile_grid_get_model:
+ * @grid: a #HildonTileGrid
+ *
+ * Gets the list shown by @grid.
+ *
+ * Returns: (transfer none): the #GtkTreeModel, or %NULL
+ *
+ * Since: 3.0
+ **/
+GtkTreeModel *
+hildon_tile_grid_get_model                      (HildonTileGrid *grid)
+{
+    g_return_val_if_fail (HILDON_IS_TILE_GRID (grid), NULL);
+
+    return grid->priv->model;
+}
+
+/**
+ * hildon_tile_grid_set_tile_size:
+ * @grid: a #HildonTileGrid
+ * @tile_width: the width of the tiles, in pixels
+ * @tile_height: the height of the tiles, in pixels
+ *
+ * Sets the size every tile of @grid is given. There are as many
+ * columns as tiles fit in the width of @grid.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_tile_grid_set_tile_size                  (HildonTileGrid *grid,
+                                                 gint            tile_width,
+                                                 gint            tile_height)
+{
+    HildonTileGridPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_TILE_GRID (grid));
+    g_return_if_fail (tile_width > 0);
+    g_return_if_fail (tile_height > 0);
+
+    priv = grid->priv;
+
+    g_object_freeze_notify (G_OBJECT (grid));
+
+    if (priv->tile_width != tile_width) {
+        priv->tile_width = tile_width;
+        g_object_notify (G_OBJECT (grid), "tile-width");
+    }
+
+    if (priv->tile_height != tile_height) {
+        priv->tile_height = tile_height;
+        g_object_notify (G_OBJECT (grid), "tile-height");
+    }
+
+    g_object_thaw_notify (G_OBJECT (grid));
+
+    gtk_widget_queue_resize (GTK_WIDGET (grid));
+}
+
+/**
+ * hildon_tile_grid_get_tile_size:
+ * @grid: a #HildonTileGrid
+ * @tile_width: (out) (allow-none): return location for the width, or %NULL
+ * @tile_height: (out) (allow-none): return location for the height, or %NULL
+ *
+ * Gets the size of the tiles of @grid, in pixels.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_tile_grid_get_tile_size                  (HildonTileGrid *grid,
+                                                 gint           *tile_width,
+                                                 gint           *tile_height)
+{
+    g_return_if_fail (HILDON_IS_TILE_GRID (grid));
+
+    if (tile_width)
+        *tile_width = grid->priv->tile_width;
+    if (tile_height)
+        *tile_height = grid->priv->tile_height;
+}
+
+/**
+ * hildon_tile_grid_set_filename_column:
+ * @grid: a #HildonTileGrid
+ * @column: a string column of the model, or -1
+ *
+ * Sets the column of the model with the files the thumbnails of the
+ * tiles are made of, by the loader set with
+ * hildon_tile_grid_set_thumbnail_loader().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_tile_grid_set_filename_column            (HildonTileGrid *grid,
+                                                 gint            column)
+{
+    g_return_if_fail (HILDON_IS_TILE_GRID (grid));
+    g_return_if_fail (column >= -1);
+
+    if (grid->priv->filename_column == column)
+        return;
+
+    grid->priv->filename_column = column;
+
+    gtk_widget_queue_draw (GTK_WIDGET (grid));
+    g_object_notify (G_OBJECT (grid), "filename-column");
+}
+
+/**
+ * hildon_tile_grid_get_filename_column:
+ * @grid: a #HildonTileGrid
+ *
+ * Gets the column of the model with the files of the thumbnails.
+ *
+ * Returns: the column, or -1 if there are no thumbnails
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_tile_grid_get_filename_column            (HildonTileGrid *grid)
+{
+    g_return_val_if_fail (HILDON_IS_TILE_GRID (grid), -1);
+
+    return grid->priv->filename_column;
+}
+
+/**
+ * hildon_tile_grid_set_text_column:
+ * @grid: a #HildonTileGrid
+ * @column: a string column of the model, or -1
+ *
+ * Sets the column of the model with the text shown under the
+ * thumbnails. The text is ellipsized to the width of the tiles.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_tile_grid_set_text_column                (HildonTileGrid *grid,
+                                                 gint            column)
+{
+    g_return_if_fail (HILDON_IS_TILE_GRID (grid));
+    g_return_if_fail (column >= -1);
+
+    if (grid->priv->text_column == column)
+        return;
+
+    grid->priv->text_column = column;
+
+    gtk_widget_queue_draw (GTK_WIDGET (grid));
+    g_object_notify (G_OBJECT (grid), "text-column");
+}
+
+/**
+ * hildon_tile_grid_get_text_column:
+ * @grid: a #HildonTileGrid
+ *
+ * Gets the column of the model with the text of the tiles.
+ *
+ * Returns: the column, or -1 if there is no text
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_tile_grid_get_text_column                (HildonTileGrid *grid)
+{
+    g_return_val_if_fail (HILDON_IS_TILE_GRID (grid), -1);
+
+    return grid->priv->text_column;
+}
+
+/**
+ * hildon_tile_grid_set_thumbnail_loader:
+ * @grid: a #HildonTileGrid
+ * @loader: (allow-none): a #HildonThumbnailLoader, or %NULL
+ *
+ * Sets the loader the thumbnails of @grid are taken from. The loader
+ * can be shared with other views; for it to decode the visible
+ * thumbnails first, it should be given the pannable area @grid is in,
+ * see hildon_thumbnail_loader_set_pannable_area().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_tile_grid_set_thumbnail_loader           (HildonTileGrid        *grid,
+                                                 HildonThumbnailLoader *loader)
+{
+    HildonTileGridPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_TILE_GRID (grid));
+    g_return_if_fail (loader == NULL || HILDON_IS_THUMBNAIL_LOADER (loader));
+
+    priv = grid->priv;
+
+    if (priv->loader == loader)
+        return;
+
+    if (priv->loader) {
+        g_signal_handlers_disconnect_by_func (priv->loader,
+                                              hildon_tile_grid_thumbnail_ready, grid);
+        g_object_unref (priv->loader);
+    }
+
+    priv->loader = loader;
+
+    if (loader) {
+        g_object_ref (loader);
+        g_signal_connect (loader, "thumbnail-ready",
+                          G_CALLBACK (hildon_tile_grid_thumbnail_ready), grid);
+    }
+
+    gtk_widget_queue_draw (GTK_WIDGET (grid));
+    g_object_notify (G_OBJECT (grid), "thumbnail-loader");
+}
+
+/**
+ * hildon_tile_grid_get_thumbnail_loader:
+ * @grid: a #HildonTileGrid
+ *
+ * Gets the loader the thumbnails of @grid are taken from.
+ *
+ * Returns: (transfer none): the #HildonThumbnailLoader, or %NULL
+ *
+ * Since: 3.0
+ **/
+HildonThumbnailLoader *
+hildon_tile_grid_get_thumbnail_loader           (HildonTileGrid *grid)
+{
+    g_return_val_if_fail (HILDON_IS_TILE_GRID (grid), NULL);
+
+    return grid->priv->loader;
+}
+
+/**
+ * hildon_tile_grid_get_path_at_pos:
+ * @grid: a #HildonTileGrid
+ * @x: the x coordinate, relative to @grid
+ * @y: the y coordinate, relative to @grid
+ *
+ * Finds the item whose tile is at @x, @y.
+ *
+ * Returns: a newly allocated #GtkTreePath, or %NULL if there is no
+ * item there. Free it with gtk_tree_path_free().
+ *
+ * Since: 3.0
+ **/
+GtkTreePath *
+hildon_tile_grid_get_path_at_pos                (HildonTileGrid *grid,
+                                                 gint            x,
+                                                 gint            y)
+{
+    gint index;
+
+    g_return_val_if_fail (HILDON_IS_TILE_GRID (grid), NULL);
+
+    index = hildon_tile_grid_get_index_at_pos (grid, x, y);
+
+    return index >= 0 ? gtk_tree_path_new_from_indices (index, -1) : NULL;
+}
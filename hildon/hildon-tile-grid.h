@@ -0,0 +1,127 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_TILE_GRID_H__
+#define                                         __HILDON_TILE_GRID_H__
+
+#include                                        <gtk/gtk.h>
+#include                                        "hildon-thumbnail-loader.h"
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_TILE_GRID \
+                                                (hildon_tile_grid_get_type())
+
+#define                                         HILDON_TILE_GRID(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_TILE_GRID, HildonTileGrid))
+
+#define                                         HILDON_TILE_GRID_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                                                HILDON_TYPE_TILE_GRID, HildonTileGridClass))
+
+#define                                         HILDON_IS_TILE_GRID(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HILDON_TYPE_TILE_GRID))
+
+#define                                         HILDON_IS_TILE_GRID_CLASS(klass) \
+                                                (G_TYPE_CHECK_CLASS_TYPE ((klass), HILDON_TYPE_TILE_GRID))
+
+#define                                         HILDON_TILE_GRID_GET_CLASS(obj) \
+                                                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                                                HILDON_TYPE_TILE_GRID, HildonTileGridClass))
+
+typedef struct                                  _HildonTileGrid HildonTileGrid;
+
+typedef struct                                  _HildonTileGridClass HildonTileGridClass;
+
+typedef struct                                  _HildonTileGridPrivate HildonTileGridPrivate;
+
+struct                                          _HildonTileGridClass
+{
+    GtkWidgetClass parent_class;
+
+    void (*item_activated)                      (HildonTileGrid *grid,
+                                                 GtkTreePath    *path);
+};
+
+struct                                          _HildonTileGrid
+{
+    GtkWidget parent;
+
+    /* private */
+    HildonTileGridPrivate *priv;
+};
+
+GType
+hildon_tile_grid_get_type                       (void) G_GNUC_CONST;
+
+GtkWidget *
+hildon_tile_grid_new                            (GtkTreeModel *model,
+                                                 gint          tile_width,
+                                                 gint          tile_height);
+
+void
+hildon_tile_grid_set_model                      (HildonTileGrid *grid,
+                                                 GtkTreeModel   *model);
+
+GtkTreeModel *
+hildon_tile_grid_get_model                      (HildonTileGrid *grid);
+
+void
+hildon_tile_grid_set_tile_size                  (HildonTileGrid *grid,
+                                                 gint            tile_width,
+                                                 gint            tile_height);
+
+void
+hildon_tile_grid_get_tile_size                  (HildonTileGrid *grid,
+                                                 gint           *tile_width,
+                                                 gint           *tile_height);
+
+void
+hildon_tile_grid_set_filename_column            (HildonTileGrid *grid,
+                                                 gint            column);
+
+gint
+hildon_tile_grid_get_filename_column            (HildonTileGrid *grid);
+
+void
+hildon_tile_grid_set_text_column                (HildonTileGrid *grid,
+                                                 gint            column);
+
+gint
+hildon_tile_grid_get_text_column                (HildonTileGrid *grid);
+
+void
+hildon_tile_grid_set_thumbnail_loader           (HildonTileGrid        *grid,
+                                                 HildonThumbnailLoader *loader);
+
+HildonThumbnailLoader *
+hildon_tile_grid_get_thumbnail_loader           (HildonTileGrid *grid);
+
+GtkTreePath *
+hildon_tile_grid_get_path_at_pos                (HildonTileGrid *grid,
+                                                 gint            x,
+                                                 gint            y);
+
+G_END_DECLS
+
+#endif /* __HILDON_TILE_GRID_H__ */
@@ -50,6 +50,8 @@
 #include "hildon-enum-types.h"
 #include "hildon-time-selector.h"
 #include "hildon-touch-selector-private.h"
+#include "hildon-touch-selector-virtual-model-private.h"
+#include "hildon-private.h"
 
 #define HILDON_TIME_SELECTOR_GET_PRIVATE(obj)                           \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HILDON_TYPE_TIME_SELECTOR, HildonTimeSelectorPrivate))
@@ -87,6 +89,12 @@ enum
   PROP_TIME_FORMAT_POLICY
 };
 
+/* All the selectors, to update the automatic ones when the clock
+   format changes */
+static GSList *selectors = NULL;
+
+static gboolean clock_is_24h = TRUE;
+
 struct _HildonTimeSelectorPrivate
 {
   GtkTreeModel *hours_model;
@@ -119,6 +127,9 @@ static void hildon_time_selector_set_property (GObject *object,
 /* private functions */
 static GtkTreeModel *_create_hours_model (HildonTimeSelector * selector);
 static GtkTreeModel *_create_minutes_model (guint minutes_step);
+static GtkTreeModel *_get_hours_model (HildonTimeSelector * selector);
+static GtkTreeModel *_get_minutes_model (guint minutes_step);
+static GtkTreeModel *_get_ampm_model (HildonTimeSelector * selector);
 static GtkTreeModel *_create_ampm_model (HildonTimeSelector * selector);
 
 static void _get_real_time (gint * hours, gint * minutes);
@@ -135,6 +146,9 @@ check_automatic_ampm_format                     (HildonTimeSelector * selector);
 static void
 update_format_policy                            (HildonTimeSelector *selector,
                                                  HildonTimeSelectorFormatPolicy new_policy);
+static void
+update_automatic_ampm_format                    (HildonTimeSelector *selector);
+
 static void
 update_format_dependant_columns                 (HildonTimeSelector *selector,
                                                  guint hours,
@@ -206,7 +220,7 @@ hildon_time_selector_constructor (GType type,
 
   g_object_set (object, "live-search", FALSE, NULL);
 
-  selector->priv->hours_model = _create_hours_model (selector);
+  selector->priv->hours_model = _get_hours_model (selector);
 
   column = hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                                      selector->priv->hours_model, TRUE);
@@ -215,14 +229,14 @@ hildon_time_selector_constructor (GType type,
   /* we need initialization parameters in order to create minute models*/
   selector->priv->minutes_step = selector->priv->minutes_step ? selector->priv->minutes_step : 1;
 
-  selector->priv->minutes_model = _create_minutes_model (selector->priv->minutes_step);
+  selector->priv->minutes_model = _get_minutes_model (selector->priv->minutes_step);
 
   column = hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                                      selector->priv->minutes_model, TRUE);
   hildon_touch_selector_column_set_text_column (column, 0);
 
   if (selector->priv->ampm_format) {
-    selector->priv->ampm_model = _create_ampm_model (selector);
+    selector->priv->ampm_model = _get_ampm_model (selector);
 
     hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                               selector->priv->ampm_model, TRUE);
@@ -257,6 +271,9 @@ hildon_time_selector_init (HildonTimeSelector * selector)
   selector->priv->pm = TRUE;
   check_automatic_ampm_format (selector);
 
+  /* Follow changes of the clock format */
+  selectors = g_slist_prepend (selectors, selector);
+
   _get_real_time (&selector->priv->creation_hours,
                   &selector->priv->creation_minutes);
 }
@@ -311,6 +328,8 @@ hildon_time_selector_finalize (GObject * object)
 {
   HildonTimeSelectorPrivate *priv = HILDON_TIME_SELECTOR_GET_PRIVATE (object);
 
+  selectors = g_slist_remove (selectors, object);
+
   if (priv->hours_model) {
     g_object_unref (priv->hours_model);
     priv->hours_model = NULL;
@@ -335,10 +354,9 @@ static gchar *
 _custom_print_func (HildonTouchSelector * touch_selector,
                     gpointer user_data)
 {
-  gchar *result = NULL;
   struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
   HildonTimeSelector *selector = NULL;
-  static gchar string[255];
+  const gchar *format;
   guint hours = 0;
   guint minutes = 0;
 
@@ -351,40 +369,35 @@ _custom_print_func (HildonTouchSelector * touch_selector,
 
   if (selector->priv->ampm_format) {
     if (selector->priv->pm) {
-      strftime (string, 255, _("wdgt_va_12h_time_pm"), &tm);
+      format = _("wdgt_va_12h_time_pm");
     } else {
-      strftime (string, 255, _("wdgt_va_12h_time_am"), &tm);
+      format = _("wdgt_va_12h_time_am");
     }
   } else {
-    strftime (string, 255, _("wdgt_va_24h_time"), &tm);
+    format = _("wdgt_va_24h_time");
   }
 
-
-  result = g_strdup (string);
-
-  return result;
+  return hildon_format_time (format, &tm);
 }
 
-static GtkTreeModel *
-_create_minutes_model (guint minutes_step)
+static gchar *
+_minutes_label (gint row, gpointer data)
 {
-  GtkListStore *store_minutes = NULL;
-  gint i = 0;
-  static gchar label[255];
   struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  GtkTreeIter iter;
 
-  store_minutes = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-  for (i = 0; i <= 59; i=i+minutes_step) {
-    tm.tm_min = i;
-    strftime (label, 255, _("wdgt_va_minutes"), &tm);
+  tm.tm_min = row * GPOINTER_TO_UINT (data);
 
-    gtk_list_store_append (store_minutes, &iter);
-    gtk_list_store_set (store_minutes, &iter,
-                        COLUMN_STRING, label, COLUMN_INT, i, -1);
-  }
+  return hildon_format_time (_("wdgt_va_minutes"), &tm);
+}
 
-  return GTK_TREE_MODEL (store_minutes);
+static GtkTreeModel *
+_create_minutes_model (guint minutes_step)
+{
+  /* One row every minutes_step minutes, from 0 to 59 */
+  return hildon_touch_selector_virtual_model_new_range (0, minutes_step,
+                                                        59 / minutes_step + 1,
+                                                        _minutes_label,
+                                                        GUINT_TO_POINTER (minutes_step), NULL);
 }
 
 static GtkTreeModel *
@@ -394,7 +407,7 @@ _create_hours_model (HildonTimeSelector * selector)
   gint i = 0;
   GtkTreeIter iter;
   struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  static gchar label[255];
+  gchar *label;
   static gint range_12h[12] = {12, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11};
   static gint range_24h[24] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,
                                12,13,14,15,16,17,18,19,20,21,22,23};
@@ -415,11 +428,12 @@ _create_hours_model (HildonTimeSelector * selector)
   store_hours = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
   for (i = 0; i < num_elements; i++) {
     tm.tm_hour = range[i];
-    strftime (label, 255, _(format_string), &tm);
+    label = hildon_format_time (_(format_string), &tm);
 
     gtk_list_store_append (store_hours, &iter);
     gtk_list_store_set (store_hours, &iter,
                         COLUMN_STRING, label, COLUMN_INT, range[i], -1);
+    g_free (label);
   }
 
   return GTK_TREE_MODEL (store_hours);
@@ -449,6 +463,59 @@ _create_ampm_model (HildonTimeSelector * selector)
   return GTK_TREE_MODEL (store_ampm);
 }
 
+/* The label models don't change once built, so all the selectors
+   using the same locale and format share them */
+static GtkTreeModel *
+_get_hours_model (HildonTimeSelector * selector)
+{
+  GtkTreeModel *model;
+  gchar *key;
+
+  key = g_strdup_printf ("hours:%s:%s", setlocale (LC_TIME, NULL),
+                         selector->priv->ampm_format ?
+                         _("wdgt_va_12h_hours") : _("wdgt_va_24h_hours"));
+  model = hildon_touch_selector_get_shared_model
+    (key, (HildonTouchSelectorModelFunc) _create_hours_model, selector);
+  g_free (key);
+
+  return model;
+}
+
+static GtkTreeModel *
+_create_minutes_model_func (gpointer data)
+{
+  return _create_minutes_model (GPOINTER_TO_UINT (data));
+}
+
+static GtkTreeModel *
+_get_minutes_model (guint minutes_step)
+{
+  GtkTreeModel *model;
+  gchar *key;
+
+  key = g_strdup_printf ("minutes:%s:%s:%u", setlocale (LC_TIME, NULL),
+                         _("wdgt_va_minutes"), minutes_step);
+  model = hildon_touch_selector_get_shared_model
+    (key, _create_minutes_model_func, GUINT_TO_POINTER (minutes_step));
+  g_free (key);
+
+  return model;
+}
+
+static GtkTreeModel *
+_get_ampm_model (HildonTimeSelector * selector)
+{
+  GtkTreeModel *model;
+  gchar *key;
+
+  key = g_strdup_printf ("ampm:%s:%s", _("wdgt_va_am"), _("wdgt_va_pm"));
+  model = hildon_touch_selector_get_shared_model
+    (key, (HildonTouchSelectorModelFunc) _create_ampm_model, selector);
+  g_free (key);
+
+  return model;
+}
+
 static void
 _get_real_time (gint * hours, gint * minutes)
 {
@@ -488,24 +555,80 @@ _manage_ampm_selection_cb (HildonTouchSelector * touch_selector,
 }
 
 static void
-check_automatic_ampm_format (HildonTimeSelector * selector)
+clock_format_changed                            (GConfClient *client,
+                                                 guint        cnxn_id,
+                                                 GConfEntry  *entry,
+                                                 gpointer     data)
+{
+  GConfValue *value = gconf_entry_get_value (entry);
+  GSList *iter;
+
+  /* An unset key means the default 24h format */
+  clock_is_24h = (value == NULL || value->type != GCONF_VALUE_BOOL ||
+                  gconf_value_get_bool (value));
+
+  for (iter = selectors; iter != NULL; iter = iter->next)
+    update_automatic_ampm_format (HILDON_TIME_SELECTOR (iter->data));
+}
+
+/* The clock format is read from gconf only once per process, and then
+   kept up to date with a notification */
+static gboolean
+get_clock_is_24h                                (void)
 {
-  GConfClient *client = NULL;
-  gboolean value = TRUE;
+  static GConfClient *client = NULL;
   GError *error = NULL;
 
+  if (G_LIKELY (client != NULL))
+    return clock_is_24h;
+
   client = gconf_client_get_default ();
-  value = gconf_client_get_bool (client, CLOCK_GCONF_IS_24H_FORMAT, &error);
+  gconf_client_add_dir (client, CLOCK_GCONF_PATH, GCONF_CLIENT_PRELOAD_NONE, NULL);
+  gconf_client_notify_add (client, CLOCK_GCONF_IS_24H_FORMAT,
+                           clock_format_changed, NULL, NULL, NULL);
+
+  clock_is_24h = gconf_client_get_bool (client, CLOCK_GCONF_IS_24H_FORMAT, &error);
   if (error != NULL) {
     g_warning
       ("Error trying to get gconf variable %s, using 24h format by default",
        CLOCK_GCONF_IS_24H_FORMAT);
     g_error_free (error);
+    clock_is_24h = TRUE;
   }
 
-  g_object_unref (client);
+  return clock_is_24h;
+}
+
+static void
+check_automatic_ampm_format (HildonTimeSelector * selector)
+{
+  selector->priv->ampm_format = !get_clock_is_24h ();
+}
+
+/* Rebuilds the columns of an automatic selector if the clock format
+   changed under it */
+static void
+update_automatic_ampm_format                    (HildonTimeSelector *selector)
+{
+  gint num_columns;
+  guint hours, minutes;
+
+  if (selector->priv->format_policy != HILDON_TIME_SELECTOR_FORMAT_POLICY_AUTOMATIC)
+    return;
+
+  if (selector->priv->ampm_format == !clock_is_24h)
+    return;
+
+  num_columns = hildon_touch_selector_get_num_columns (HILDON_TOUCH_SELECTOR (selector));
+  if (num_columns < 2) {
+    /* Still under construction */
+    check_automatic_ampm_format (selector);
+    return;
+  }
 
-  selector->priv->ampm_format = !value;
+  hildon_time_selector_get_time (selector, &hours, &minutes);
+  check_automatic_ampm_format (selector);
+  update_format_dependant_columns (selector, hours, minutes);
 }
 
 static void
@@ -575,7 +698,7 @@ update_format_dependant_columns                 (HildonTimeSelector *selector,
   if (selector->priv->hours_model) {
     g_object_unref (selector->priv->hours_model);
   }
-  selector->priv->hours_model = _create_hours_model (selector);
+  selector->priv->hours_model = _get_hours_model (selector);
   hildon_touch_selector_set_model (HILDON_TOUCH_SELECTOR (selector),
                                    0,
                                    selector->priv->hours_model);
@@ -594,7 +717,7 @@ update_format_dependant_columns                 (HildonTimeSelector *selector,
     g_object_unref (selector->priv->ampm_model);
   }
   if (selector->priv->ampm_format) {
-    selector->priv->ampm_model = _create_ampm_model (selector);
+    selector->priv->ampm_model = _get_ampm_model (selector);
 
     hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                               selector->priv->ampm_model, TRUE);
@@ -74,6 +74,29 @@ hildon_touch_selector_column_set_text_column (HildonTouchSelectorColumn *column,
 gint
 hildon_touch_selector_column_get_text_column (HildonTouchSelectorColumn *column);
 
+void
+hildon_touch_selector_column_set_fixed_height_rows (HildonTouchSelectorColumn *column,
+                                                    gboolean                   fixed_height_rows);
+gboolean
+hildon_touch_selector_column_get_fixed_height_rows (HildonTouchSelectorColumn *column);
+
+void
+hildon_touch_selector_column_set_visible_rows (HildonTouchSelectorColumn *column,
+                                               gint                       visible_rows);
+gint
+hildon_touch_selector_column_get_visible_rows (HildonTouchSelectorColumn *column);
+
+void
+hildon_touch_selector_column_set_cache_layouts (HildonTouchSelectorColumn *column,
+                                                gboolean                   cache_layouts);
+gboolean
+hildon_touch_selector_column_get_cache_layouts (HildonTouchSelectorColumn *column);
+
+void
+hildon_touch_selector_column_append_text_array (HildonTouchSelectorColumn *column,
+                                                const gchar * const       *texts,
+                                                gint                       n_texts);
+
 G_END_DECLS
 
 
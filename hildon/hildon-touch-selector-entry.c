@@ -55,6 +55,7 @@
 #include "hildon-touch-selector-private.h"
 #include "hildon-touch-selector-entry.h"
 #include "hildon-entry.h"
+#include "hildon-helper.h"
 
 #include <string.h>
 
@@ -80,13 +81,31 @@ _text_column_modified (GObject *pspec, GParamSpec *gobject, gpointer data);
 struct _HildonTouchSelectorEntryPrivate {
   gulong signal_id;
   GtkWidget *entry;
-  GIConv converter;
   gboolean smart_match;
+
+  /* sorted keys of the model rows, to find the completions without
+     going through the whole model on every keystroke */
+  GtkTreeModel *index_model;
+  gint index_text_column;
+  GArray *exact_index;          /* the texts of the rows */
+  GArray *smart_index;          /* the normalized texts, for smart match */
+  gint *exact_first;            /* first rows of the ranges of each index, */
+  gint *smart_first;            /* see hildon_touch_selector_entry_lookup() */
+
+  gint max_suggestions;         /* 0 to select the first match instead */
+  GHashTable *suggestions;      /* the rows shown in suggestion mode */
 };
 
+typedef struct
+{
+  gchar *key;
+  gint row;
+} HildonTouchSelectorEntryKey;
+
 enum {
   PROP_TEXT_COLUMN = 1,
-  PROP_SMART_MATCH
+  PROP_SMART_MATCH,
+  PROP_MAX_SUGGESTIONS
 };
 
 static void
@@ -105,6 +124,9 @@ hildon_touch_selector_entry_get_property (GObject *object, guint property_id,
   case PROP_SMART_MATCH:
     g_value_set_boolean (value, priv->smart_match);
     break;
+  case PROP_MAX_SUGGESTIONS:
+    g_value_set_int (value, priv->max_suggestions);
+    break;
 
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -127,6 +149,10 @@ hildon_touch_selector_entry_set_property (GObject *object, guint property_id,
   case PROP_SMART_MATCH:
     priv->smart_match = g_value_get_boolean (value);
     break;
+  case PROP_MAX_SUGGESTIONS:
+    hildon_touch_selector_entry_set_max_suggestions (HILDON_TOUCH_SELECTOR_ENTRY (object),
+                                                     g_value_get_int (value));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -148,12 +174,89 @@ hildon_touch_selector_entry_constructor (GType type,
 }
 
 static void
-hildon_touch_selector_entry_finalize (GObject *object)
+hildon_touch_selector_entry_free_index (HildonTouchSelectorEntryPrivate *priv)
+{
+  GArray **indexes[2] = { &priv->exact_index, &priv->smart_index };
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (indexes); i++) {
+    GArray *index = *indexes[i];
+
+    if (index == NULL)
+      continue;
+
+    for (j = 0; j < index->len; j++) {
+      g_free (g_array_index (index, HildonTouchSelectorEntryKey, j).key);
+    }
+    g_array_free (index, TRUE);
+    *indexes[i] = NULL;
+  }
+
+  g_free (priv->exact_first);
+  priv->exact_first = NULL;
+  g_free (priv->smart_first);
+  priv->smart_first = NULL;
+}
+
+static void
+hildon_touch_selector_entry_index_changed (GtkTreeModel *model,
+                                           GtkTreePath *path,
+                                           gpointer data)
+{
+  /* Any change moves the rows around, so the index is rebuilt on the
+     next keystroke */
+  hildon_touch_selector_entry_free_index (data);
+}
+
+static void
+hildon_touch_selector_entry_set_index_model (HildonTouchSelectorEntryPrivate *priv,
+                                             GtkTreeModel *model)
+{
+  if (priv->index_model == model)
+    return;
+
+  hildon_touch_selector_entry_free_index (priv);
+
+  if (priv->index_model != NULL) {
+    g_signal_handlers_disconnect_by_data (priv->index_model, priv);
+    g_object_unref (priv->index_model);
+  }
+
+  priv->index_model = model;
+
+  if (model != NULL) {
+    g_object_ref (model);
+    g_signal_connect_swapped (model, "row-inserted",
+                              G_CALLBACK (hildon_touch_selector_entry_free_index), priv);
+    g_signal_connect (model, "row-deleted",
+                      G_CALLBACK (hildon_touch_selector_entry_index_changed), priv);
+    g_signal_connect_swapped (model, "row-changed",
+                              G_CALLBACK (hildon_touch_selector_entry_free_index), priv);
+    g_signal_connect_swapped (model, "rows-reordered",
+                              G_CALLBACK (hildon_touch_selector_entry_free_index), priv);
+  }
+}
+
+static void
+hildon_touch_selector_entry_dispose (GObject *object)
 {
   HildonTouchSelectorEntryPrivate *priv;
+
   priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (object);
-  g_iconv_close (priv->converter);
-  G_OBJECT_CLASS (hildon_touch_selector_entry_parent_class)->finalize (object);
+
+  hildon_touch_selector_entry_set_index_model (priv, NULL);
+
+  if (priv->suggestions != NULL) {
+    HildonTouchSelectorColumn *column;
+
+    column = hildon_touch_selector_get_column (HILDON_TOUCH_SELECTOR (object), 0);
+    if (column != NULL)
+      hildon_touch_selector_column_set_row_filter (column, NULL, NULL);
+    g_hash_table_destroy (priv->suggestions);
+    priv->suggestions = NULL;
+  }
+
+  G_OBJECT_CLASS (hildon_touch_selector_entry_parent_class)->dispose (object);
 }
 
 static void
@@ -168,9 +271,9 @@ hildon_touch_selector_entry_class_init (HildonTouchSelectorEntryClass *klass)
   selector_class->has_multiple_selection = hildon_touch_selector_entry_has_multiple_selection;
 
   object_class->constructor  = hildon_touch_selector_entry_constructor;
+  object_class->dispose      = hildon_touch_selector_entry_dispose;
   object_class->get_property = hildon_touch_selector_entry_get_property;
   object_class->set_property = hildon_touch_selector_entry_set_property;
-  object_class->finalize     = hildon_touch_selector_entry_finalize;
 
   /**
    * HildonTouchSelectorEntry:smart-match:
@@ -194,6 +297,29 @@ hildon_touch_selector_entry_class_init (HildonTouchSelectorEntryClass *klass)
                                                          "approximate match is found",
                                                          TRUE,
                                                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
+  /**
+   * HildonTouchSelectorEntry:max-suggestions:
+   *
+   * The maximum number of completions shown while typing, or 0 to show
+   * all the rows and select the first completion.
+   *
+   * When this is set, the column only shows the rows that complete the
+   * text of the entry, exact matches first, so typing neither scrolls
+   * the list nor changes its selection.
+   *
+   * Since: 3.0
+   **/
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                   PROP_MAX_SUGGESTIONS,
+                                   g_param_spec_int ("max-suggestions",
+                                                     "Maximum suggestions",
+                                                     "The maximum number of completions "
+                                                     "shown, or 0 to select the first one",
+                                                     0,
+                                                     G_MAXINT,
+                                                     0,
+                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static gchar *
@@ -228,8 +354,6 @@ hildon_touch_selector_entry_init (HildonTouchSelectorEntry *self)
 
   priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (self);
 
-  priv->converter = g_iconv_open ("ascii//translit", "utf-8");
-
   priv->entry = hildon_entry_new (HILDON_SIZE_FINGER_HEIGHT);
   gtk_entry_set_activates_default (GTK_ENTRY (priv->entry), TRUE);
 
@@ -373,6 +497,248 @@ hildon_touch_selector_entry_get_text_column (HildonTouchSelectorEntry *selector)
   return text_column;
 }
 
+static gint
+hildon_touch_selector_entry_row_compare (const gint *a,
+                                         const gint *b)
+{
+  return *a - *b;
+}
+
+static gint
+hildon_touch_selector_entry_key_compare (gconstpointer a,
+                                         gconstpointer b)
+{
+  const HildonTouchSelectorEntryKey *ka = a;
+  const HildonTouchSelectorEntryKey *kb = b;
+  gint result;
+
+  result = strcmp (ka->key, kb->key);
+
+  return result != 0 ? result : ka->row - kb->row;
+}
+
+/*
+ * Builds a segment tree over the rows of the sorted @index: node i
+ * holds the first row of its two children 2i and 2i+1, and the leaves
+ * are at n + i. The first row of any range of keys is then found with
+ * O(log n) reads.
+ */
+static gint *
+hildon_touch_selector_entry_build_first (GArray *index)
+{
+  guint n = index->len;
+  gint *first = g_new (gint, 2 * n + 1);
+  guint i;
+
+  for (i = 0; i < n; i++)
+    first[n + i] = g_array_index (index, HildonTouchSelectorEntryKey, i).row;
+  for (i = n - 1; i > 0 && n > 0; i--)
+    first[i] = MIN (first[2 * i], first[2 * i + 1]);
+
+  return first;
+}
+
+static void
+hildon_touch_selector_entry_build_index (HildonTouchSelectorEntryPrivate *priv,
+                                         gint text_column)
+{
+  HildonTouchSelectorEntryKey key;
+  GtkTreeIter iter;
+  gchar *text;
+  gint row = 0;
+
+  hildon_touch_selector_entry_free_index (priv);
+
+  priv->index_text_column = text_column;
+  priv->exact_index = g_array_new (FALSE, FALSE, sizeof (HildonTouchSelectorEntryKey));
+  if (priv->smart_match)
+    priv->smart_index = g_array_new (FALSE, FALSE, sizeof (HildonTouchSelectorEntryKey));
+
+  if (gtk_tree_model_get_iter_first (priv->index_model, &iter)) {
+    do {
+      gtk_tree_model_get (priv->index_model, &iter, text_column, &text, -1);
+
+      if (text != NULL) {
+        key.row = row;
+
+        if (priv->smart_index != NULL) {
+          gchar *normalized = hildon_helper_normalize_string (text);
+
+          if (normalized != NULL) {
+            key.key = g_ascii_strdown (normalized, -1);
+            g_array_append_val (priv->smart_index, key);
+            g_free (normalized);
+          }
+        }
+
+        key.key = text;
+        g_array_append_val (priv->exact_index, key);
+      }
+
+      row++;
+    } while (gtk_tree_model_iter_next (priv->index_model, &iter));
+  }
+
+  g_array_sort (priv->exact_index, hildon_touch_selector_entry_key_compare);
+  priv->exact_first = hildon_touch_selector_entry_build_first (priv->exact_index);
+  if (priv->smart_index != NULL) {
+    g_array_sort (priv->smart_index, hildon_touch_selector_entry_key_compare);
+    priv->smart_first = hildon_touch_selector_entry_build_first (priv->smart_index);
+  }
+}
+
+/*
+ * Finds the range [@low, @high) of the keys of the sorted @index that
+ * start with @prefix, with two binary searches.
+ */
+static void
+hildon_touch_selector_entry_range (GArray *index,
+                                   const gchar *prefix,
+                                   guint *low,
+                                   guint *high)
+{
+  HildonTouchSelectorEntryKey *keys = (HildonTouchSelectorEntryKey *) index->data;
+  gsize prefix_len = strlen (prefix);
+  guint lo = 0;
+  guint hi = index->len;
+
+  while (lo < hi) {
+    guint middle = lo + (hi - lo) / 2;
+
+    if (strcmp (keys[middle].key, prefix) < 0)
+      lo = middle + 1;
+    else
+      hi = middle;
+  }
+  *low = lo;
+
+  /* The keys from @low on start with @prefix, or are greater */
+  hi = index->len;
+  while (lo < hi) {
+    guint middle = lo + (hi - lo) / 2;
+
+    if (strncmp (keys[middle].key, prefix, prefix_len) == 0)
+      lo = middle + 1;
+    else
+      hi = middle;
+  }
+  *high = lo;
+}
+
+/*
+ * Finds the first row, in model order, whose key in @index starts with
+ * @prefix. The keys starting with @prefix are contiguous in the sorted
+ * index; their first row is read from the segment tree @first.
+ */
+static gint
+hildon_touch_selector_entry_lookup (GArray *index,
+                                    const gint *first,
+                                    const gchar *prefix)
+{
+  guint low, high;
+  gint row = G_MAXINT;
+
+  hildon_touch_selector_entry_range (index, prefix, &low, &high);
+  if (low == high)
+    return -1;
+
+  for (low += index->len, high += index->len; low < high; low /= 2, high /= 2) {
+    if (low & 1)
+      row = MIN (row, first[low++]);
+    if (high & 1)
+      row = MIN (row, first[--high]);
+  }
+
+  return row;
+}
+
+/* Adds to @rows the first rows, in model order, whose key in @index
+   starts with @prefix, until there are @max of them */
+static void
+hildon_touch_selector_entry_collect (GArray *index,
+                                     const gchar *prefix,
+                                     GHashTable *rows,
+                                     gint max)
+{
+  HildonTouchSelectorEntryKey *keys = (HildonTouchSelectorEntryKey *) index->data;
+  GArray *found;
+  guint low, high;
+  guint i;
+
+  hildon_touch_selector_entry_range (index, prefix, &low, &high);
+
+  found = g_array_sized_new (FALSE, FALSE, sizeof (gint), high - low);
+  for (i = low; i < high; i++) {
+    g_array_append_val (found, keys[i].row);
+  }
+  g_array_sort (found, (GCompareFunc) hildon_touch_selector_entry_row_compare);
+
+  for (i = 0; i < found->len && g_hash_table_size (rows) < max; i++) {
+    g_hash_table_add (rows, GINT_TO_POINTER (g_array_index (found, gint, i)));
+  }
+
+  g_array_free (found, TRUE);
+}
+
+static gboolean
+hildon_touch_selector_entry_suggestion_visible (GtkTreeModel *model,
+                                                GtkTreeIter *iter,
+                                                gpointer data)
+{
+  HildonTouchSelectorEntryPrivate *priv = data;
+  GtkTreePath *path;
+  gint row;
+
+  path = gtk_tree_model_get_path (model, iter);
+  row = gtk_tree_path_get_indices (path)[0];
+  gtk_tree_path_free (path);
+
+  return g_hash_table_contains (priv->suggestions, GINT_TO_POINTER (row));
+}
+
+/* Shows only the completions of @prefix in the column, or all the rows
+   if @prefix is empty */
+static void
+hildon_touch_selector_entry_suggest (HildonTouchSelectorEntry *selector,
+                                     const gchar *prefix)
+{
+  HildonTouchSelectorEntryPrivate *priv;
+  HildonTouchSelectorColumn *column;
+
+  priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (selector);
+  column = hildon_touch_selector_get_column (HILDON_TOUCH_SELECTOR (selector), 0);
+
+  if (prefix == NULL || prefix[0] == '\0') {
+    hildon_touch_selector_column_set_row_filter (column, NULL, NULL);
+    return;
+  }
+
+  if (priv->suggestions == NULL)
+    priv->suggestions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_hash_table_remove_all (priv->suggestions);
+
+  /* The exact matches are ranked before the approximate ones */
+  hildon_touch_selector_entry_collect (priv->exact_index, prefix,
+                                       priv->suggestions, priv->max_suggestions);
+
+  if (priv->smart_match) {
+    gchar *ascii_prefix = hildon_helper_normalize_string (prefix);
+
+    if (ascii_prefix != NULL) {
+      gchar *lowered = g_ascii_strdown (ascii_prefix, -1);
+
+      hildon_touch_selector_entry_collect (priv->smart_index, lowered,
+                                           priv->suggestions, priv->max_suggestions);
+      g_free (lowered);
+      g_free (ascii_prefix);
+    }
+  }
+
+  hildon_touch_selector_column_set_row_filter (column,
+                                               hildon_touch_selector_entry_suggestion_visible,
+                                               priv);
+}
+
 static void
 entry_on_text_changed (GtkEditable * editable,
                        gpointer userdata)
@@ -381,15 +747,10 @@ entry_on_text_changed (GtkEditable * editable,
   HildonTouchSelectorEntryPrivate *priv;
   GtkTreeModel *model;
   GtkTreeIter iter;
-  GtkTreeIter iter_suggested;
   GtkEntry *entry;
   const gchar *prefix;
-  gchar *text;
-  gboolean found = FALSE;
   gint text_column = -1;
-  gchar *ascii_prefix = 0;
-  gint prefix_len = 0;
-  gboolean found_suggestion = FALSE;
+  gint row;
 
   entry = GTK_ENTRY (editable);
   selector = HILDON_TOUCH_SELECTOR (userdata);
@@ -401,59 +762,63 @@ entry_on_text_changed (GtkEditable * editable,
   prefix = gtk_entry_get_text (entry);
 
   if (prefix[0] == '\0') {
+	  if (priv->max_suggestions > 0) {
+	    hildon_touch_selector_entry_suggest (HILDON_TOUCH_SELECTOR_ENTRY (selector), NULL);
+	  }
 	  return;
   }
 
   model = hildon_touch_selector_get_model (selector, 0);
 
-  if (!gtk_tree_model_get_iter_first (model, &iter)) {
+  if (model == NULL || text_column < 0 ||
+      !gtk_tree_model_get_iter_first (model, &iter)) {
     return;
   }
 
-  if (priv->smart_match) {
-    ascii_prefix = g_convert_with_iconv (prefix, -1, priv->converter, NULL, NULL, NULL);
-    prefix_len = strlen (ascii_prefix);
+  hildon_touch_selector_entry_set_index_model (priv, model);
+  if (priv->exact_index == NULL ||
+      priv->index_text_column != text_column ||
+      (priv->smart_match && priv->smart_index == NULL)) {
+    hildon_touch_selector_entry_build_index (priv, text_column);
   }
 
-  do {
-    gtk_tree_model_get (model, &iter, text_column, &text, -1);
-    found = g_str_has_prefix (text, prefix);
-
-    if (!found && !found_suggestion && priv->smart_match) {
-      gchar *ascii_text = g_convert_with_iconv (text, -1, priv->converter, NULL, NULL, NULL);
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wuninitialized"
-      found_suggestion = !g_ascii_strncasecmp (ascii_text, ascii_prefix, prefix_len);
-#pragma GCC diagnostic pop
-      if (found_suggestion) {
-        iter_suggested = iter;
-      }
-      g_free (ascii_text);
-    }
+  if (priv->max_suggestions > 0) {
+    /* The list is filtered instead of scrolled, nor is the selection
+       changed while typing */
+    hildon_touch_selector_entry_suggest (HILDON_TOUCH_SELECTOR_ENTRY (selector), prefix);
+    g_signal_handler_block (selector, priv->signal_id);
+    g_signal_emit_by_name (selector, "changed", 0);
+    g_signal_handler_unblock (selector, priv->signal_id);
+    return;
+  }
 
-    g_free (text);
-  } while (found != TRUE && gtk_tree_model_iter_next (model, &iter));
+  /* An exact case match wins over an approximate one */
+  row = hildon_touch_selector_entry_lookup (priv->exact_index, priv->exact_first, prefix);
+
+  if (row == -1 && priv->smart_match) {
+    gchar *ascii_prefix = hildon_helper_normalize_string (prefix);
+
+    if (ascii_prefix != NULL) {
+      gchar *lowered = g_ascii_strdown (ascii_prefix, -1);
+
+      row = hildon_touch_selector_entry_lookup (priv->smart_index, priv->smart_first,
+                                                lowered);
+      g_free (lowered);
+      g_free (ascii_prefix);
+    }
+  }
 
   g_signal_handler_block (selector, priv->signal_id);
   {
     /* We emit the HildonTouchSelector::changed signal because a change in the
        GtkEntry represents a change in current selection, and therefore, users
        should be notified. */
-    if (found) {
+    if (row != -1 && gtk_tree_model_iter_nth_child (model, &iter, NULL, row)) {
       hildon_touch_selector_select_iter (selector, 0, &iter, TRUE);
-    } else if (found_suggestion) {
-      hildon_touch_selector_select_iter (selector, 0, &iter_suggested, TRUE);
     }
     g_signal_emit_by_name (selector, "changed", 0);
   }
   g_signal_handler_unblock (selector, priv->signal_id);
-
-  if (priv->smart_match) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wuninitialized"
-    g_free (ascii_prefix);
-#pragma GCC diagnostic pop
-  }
 }
 
 /* FIXME: This is actually a very ugly way to retrieve the text. Ideally,
@@ -561,3 +926,65 @@ hildon_touch_selector_entry_get_entry (HildonTouchSelectorEntry * selector)
 
 	return HILDON_ENTRY (priv->entry);
 }
+
+/**
+ * hildon_touch_selector_entry_set_max_suggestions:
+ * @selector: a #HildonTouchSelectorEntry
+ * @max_suggestions: the maximum number of completions shown, or 0
+ *
+ * Sets the #HildonTouchSelectorEntry:max-suggestions property. With a
+ * positive value, the column of @selector only shows up to
+ * @max_suggestions rows completing the text of the entry while the
+ * user types. This is recommended for long lists, where scrolling to
+ * the first completion on every keystroke is expensive.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_entry_set_max_suggestions (HildonTouchSelectorEntry *selector,
+                                                 gint max_suggestions)
+{
+  HildonTouchSelectorEntryPrivate *priv;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_ENTRY (selector));
+  g_return_if_fail (max_suggestions >= 0);
+
+  priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (selector);
+
+  if (priv->max_suggestions == max_suggestions)
+    return;
+
+  priv->max_suggestions = max_suggestions;
+
+  if (hildon_touch_selector_get_column (HILDON_TOUCH_SELECTOR (selector), 0) != NULL) {
+    if (max_suggestions > 0)
+      entry_on_text_changed (GTK_EDITABLE (priv->entry), selector);
+    else
+      hildon_touch_selector_entry_suggest (selector, NULL);
+  }
+
+  g_object_notify (G_OBJECT (selector), "max-suggestions");
+}
+
+/**
+ * hildon_touch_selector_entry_get_max_suggestions:
+ * @selector: a #HildonTouchSelectorEntry
+ *
+ * Gets the #HildonTouchSelectorEntry:max-suggestions property.
+ *
+ * Returns: the maximum number of completions shown, or 0 if @selector
+ * selects the first completion instead
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_touch_selector_entry_get_max_suggestions (HildonTouchSelectorEntry *selector)
+{
+  HildonTouchSelectorEntryPrivate *priv;
+
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_ENTRY (selector), 0);
+
+  priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (selector);
+
+  return priv->max_suggestions;
+}
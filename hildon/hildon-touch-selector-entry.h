@@ -82,6 +82,12 @@ hildon_touch_selector_entry_get_text_column     (HildonTouchSelectorEntry *selec
 HildonEntry *
 hildon_touch_selector_entry_get_entry (HildonTouchSelectorEntry * selector);
 
+void
+hildon_touch_selector_entry_set_max_suggestions (HildonTouchSelectorEntry *selector,
+                                                 gint                      max_suggestions);
+gint
+hildon_touch_selector_entry_get_max_suggestions (HildonTouchSelectorEntry *selector);
+
 G_END_DECLS
 
 #endif /* __HILDON_TOUCH_SELECTOR_ENTRY__ */
@@ -31,9 +31,34 @@ hildon_touch_selector_block_changed             (HildonTouchSelector *selector);
 void G_GNUC_INTERNAL
 hildon_touch_selector_unblock_changed           (HildonTouchSelector *selector);
 
+typedef void (*HildonTouchSelectorSettledFunc) (HildonTouchSelector *selector,
+                                                gpointer             data);
+
+void G_GNUC_INTERNAL
+hildon_touch_selector_queue_settled             (HildonTouchSelector            *selector,
+                                                 gint                            column,
+                                                 HildonTouchSelectorSettledFunc  func,
+                                                 gpointer                        data);
+
 void G_GNUC_INTERNAL
 hildon_touch_selector_column_disable_focus      (HildonTouchSelectorColumn *col);
 
+void G_GNUC_INTERNAL
+hildon_touch_selector_column_set_row_filter     (HildonTouchSelectorColumn     *col,
+                                                 GtkTreeModelFilterVisibleFunc  func,
+                                                 gpointer                       data);
+
+void G_GNUC_INTERNAL
+hildon_touch_selector_set_height_limit          (HildonTouchSelector *selector,
+                                                 gint                 limit);
+
+typedef GtkTreeModel *(*HildonTouchSelectorModelFunc) (gpointer data);
+
+GtkTreeModel * G_GNUC_INTERNAL
+hildon_touch_selector_get_shared_model          (const gchar                  *key,
+                                                 HildonTouchSelectorModelFunc  create,
+                                                 gpointer                      data);
+
 G_END_DECLS
 
 #endif
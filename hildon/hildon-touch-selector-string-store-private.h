@@ -0,0 +1,80 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2008 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_TOUCH_SELECTOR_STRING_STORE_PRIVATE_H__
+#define                                         __HILDON_TOUCH_SELECTOR_STRING_STORE_PRIVATE_H__
+
+#include                                        <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_TOUCH_SELECTOR_STRING_STORE \
+                                                (hildon_touch_selector_string_store_get_type ())
+
+#define                                         HILDON_TOUCH_SELECTOR_STRING_STORE(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_TOUCH_SELECTOR_STRING_STORE, \
+                                                HildonTouchSelectorStringStore))
+
+#define                                         HILDON_IS_TOUCH_SELECTOR_STRING_STORE(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                                                HILDON_TYPE_TOUCH_SELECTOR_STRING_STORE))
+
+typedef struct                                  _HildonTouchSelectorStringStore HildonTouchSelectorStringStore;
+typedef struct                                  _HildonTouchSelectorStringStoreClass HildonTouchSelectorStringStoreClass;
+
+GType G_GNUC_INTERNAL
+hildon_touch_selector_string_store_get_type     (void) G_GNUC_CONST;
+
+GtkTreeModel * G_GNUC_INTERNAL
+hildon_touch_selector_string_store_new          (void);
+
+GtkTreeModel * G_GNUC_INTERNAL
+hildon_touch_selector_string_store_new_sorted   (void);
+
+void G_GNUC_INTERNAL
+hildon_touch_selector_string_store_insert       (HildonTouchSelectorStringStore *store,
+                                                 gint                            position,
+                                                 const gchar                    *text);
+
+void G_GNUC_INTERNAL
+hildon_touch_selector_string_store_append_array (HildonTouchSelectorStringStore *store,
+                                                 const gchar * const            *texts,
+                                                 gint                            n_texts);
+
+gboolean G_GNUC_INTERNAL
+hildon_touch_selector_string_store_get_sorted   (HildonTouchSelectorStringStore *store);
+
+gint G_GNUC_INTERNAL
+hildon_touch_selector_string_store_get_n_rows   (HildonTouchSelectorStringStore *store);
+
+const gchar * G_GNUC_INTERNAL
+hildon_touch_selector_string_store_get_text     (HildonTouchSelectorStringStore *store,
+                                                 gint                            row);
+
+const gchar * G_GNUC_INTERNAL
+hildon_touch_selector_string_store_peek         (HildonTouchSelectorStringStore *store,
+                                                 GtkTreeIter                    *iter);
+
+G_END_DECLS
+
+#endif                                          /* __HILDON_TOUCH_SELECTOR_STRING_STORE_PRIVATE_H__ */
@@ -0,0 +1,679 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2008 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * HildonTouchSelectorStringStore is a read-mostly #GtkTreeModel with a
+ * single string column, used by hildon_touch_selector_new_text_compact()
+ * and hildon_touch_selector_new_text_sorted().
+ * All the strings live one after the other, NUL-terminated, in a single
+ * arena, and each row is just the offset of its string in there. Compared
+ * to a #GtkListStore, a row costs four bytes plus its text instead of a
+ * sequence node, a #GValue and a separate allocation, and walking the rows
+ * in order, as the live search does, reads memory sequentially.
+ *
+ * Rows can only be added. Iters are row indices; they stay valid when
+ * rows are appended, but not when a row is inserted before the end.
+ *
+ * A sorted store keeps its rows in collation order instead of insertion
+ * order. The g_utf8_collate_key() of each row is computed once, when the
+ * row is added, and kept in a second arena, so placing a row only takes
+ * strcmp() calls on the keys instead of full UTF-8 collations.
+ */
+
+#ifdef                                          HAVE_CONFIG_H
+#include                                        <config.h>
+#endif
+
+#include                                        <string.h>
+
+#include                                        "hildon-touch-selector-string-store-private.h"
+
+#define                                         ARENA_MIN_SIZE 4096
+
+typedef struct
+{
+    gchar *data;
+    gsize len;
+    gsize size;
+} Arena;
+
+struct                                          _HildonTouchSelectorStringStore
+{
+    GObject parent_instance;
+
+    Arena texts;
+    Arena keys;
+
+    GArray *offsets;            /* guint32 offset in texts of each row */
+    GArray *key_offsets;        /* guint32 offset in keys of each row, or NULL if unsorted */
+    gint stamp;
+};
+
+struct                                          _HildonTouchSelectorStringStoreClass
+{
+    GObjectClass parent_class;
+};
+
+static void
+hildon_touch_selector_string_store_tree_model_init (GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (HildonTouchSelectorStringStore, hildon_touch_selector_string_store, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+                                                hildon_touch_selector_string_store_tree_model_init))
+
+#define                                         ITER_ROW(iter) \
+                                                GPOINTER_TO_INT ((iter)->user_data)
+
+#define                                         N_ROWS(store) \
+                                                ((gint) (store)->offsets->len)
+
+#define                                         ROW_KEY(store, row) \
+                                                ((store)->keys.data + \
+                                                g_array_index ((store)->key_offsets, guint32, (row)))
+
+static void
+hildon_touch_selector_string_store_finalize     (GObject *object)
+{
+    HildonTouchSelectorStringStore *store = HILDON_TOUCH_SELECTOR_STRING_STORE (object);
+
+    g_free (store->texts.data);
+    g_free (store->keys.data);
+    g_array_free (store->offsets, TRUE);
+    if (store->key_offsets != NULL)
+        g_array_free (store->key_offsets, TRUE);
+
+    G_OBJECT_CLASS (hildon_touch_selector_string_store_parent_class)->finalize (object);
+}
+
+static void
+hildon_touch_selector_string_store_class_init   (HildonTouchSelectorStringStoreClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->finalize = hildon_touch_selector_string_store_finalize;
+}
+
+static void
+hildon_touch_selector_string_store_init         (HildonTouchSelectorStringStore *store)
+{
+    store->texts.data = NULL;
+    store->texts.len = 0;
+    store->texts.size = 0;
+    store->keys = store->texts;
+    store->offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+    store->key_offsets = NULL;
+    store->stamp = g_random_int ();
+}
+
+/* Makes room for @extra more bytes in the arena, returns FALSE if the
+   offsets would not fit in 32 bits anymore */
+static gboolean
+arena_reserve                                   (Arena *arena,
+                                                 gsize  extra)
+{
+    gsize needed = arena->len + extra;
+
+    g_return_val_if_fail (needed <= G_MAXUINT32, FALSE);
+
+    if (needed > arena->size) {
+        gsize size = MAX (arena->size, ARENA_MIN_SIZE);
+
+        while (size < needed)
+            size *= 2;
+
+        arena->data = g_realloc (arena->data, size);
+        arena->size = size;
+    }
+
+    return TRUE;
+}
+
+static guint32
+arena_add                                       (Arena       *arena,
+                                                 const gchar *text,
+                                                 gsize        len)
+{
+    guint32 offset = arena->len;
+
+    memcpy (arena->data + offset, text, len + 1);
+    arena->len += len + 1;
+
+    return offset;
+}
+
+/* Invalidates the iters, for when existing rows move */
+static void
+bump_stamp                                      (HildonTouchSelectorStringStore *store)
+{
+    do {
+        store->stamp++;
+    } while (store->stamp == 0);
+}
+
+/* Returns the position after the last row whose key is not greater
+   than @key, so that rows with equal keys stay in insertion order */
+static gint
+sorted_position                                 (HildonTouchSelectorStringStore *store,
+                                                 const gchar                    *key)
+{
+    gint low = 0;
+    gint high = N_ROWS (store);
+
+    while (low < high) {
+        gint middle = low + (high - low) / 2;
+
+        if (strcmp (ROW_KEY (store, middle), key) <= 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+/* Compares two rows of a sorted store, given by their index */
+static gint
+compare_rows                                    (gconstpointer a,
+                                                 gconstpointer b,
+                                                 gpointer      data)
+{
+    HildonTouchSelectorStringStore *store = data;
+    gint row_a = *(const gint *) a;
+    gint row_b = *(const gint *) b;
+    gint result;
+
+    result = strcmp (ROW_KEY (store, row_a), ROW_KEY (store, row_b));
+    if (result != 0)
+        return result;
+
+    /* Rows are appended in order, so this keeps equal rows stable */
+    return row_a < row_b ? -1 : row_a > row_b;
+}
+
+static void
+emit_row_inserted                               (HildonTouchSelectorStringStore *store,
+                                                 gint                            row)
+{
+    GtkTreePath *path;
+    GtkTreeIter iter;
+
+    iter.stamp = store->stamp;
+    iter.user_data = GINT_TO_POINTER (row);
+    path = gtk_tree_path_new_from_indices (row, -1);
+    gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+    gtk_tree_path_free (path);
+}
+
+/* GtkTreeModel implementation */
+
+static GtkTreeModelFlags
+string_store_get_flags                          (GtkTreeModel *tree_model)
+{
+    return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+string_store_get_n_columns                      (GtkTreeModel *tree_model)
+{
+    return 1;
+}
+
+static GType
+string_store_get_column_type                    (GtkTreeModel *tree_model,
+                                                 gint          index)
+{
+    g_return_val_if_fail (index == 0, G_TYPE_INVALID);
+
+    return G_TYPE_STRING;
+}
+
+static gboolean
+string_store_iter_nth_child                     (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreeIter  *parent,
+                                                 gint          n)
+{
+    HildonTouchSelectorStringStore *store = HILDON_TOUCH_SELECTOR_STRING_STORE (tree_model);
+
+    iter->stamp = 0;
+
+    if (parent != NULL || n < 0 || n >= N_ROWS (store))
+        return FALSE;
+
+    iter->stamp = store->stamp;
+    iter->user_data = GINT_TO_POINTER (n);
+
+    return TRUE;
+}
+
+static gboolean
+string_store_get_iter                           (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreePath  *path)
+{
+    if (gtk_tree_path_get_depth (path) != 1) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+
+    return string_store_iter_nth_child (tree_model, iter, NULL,
+                                        gtk_tree_path_get_indices (path)[0]);
+}
+
+static GtkTreePath *
+string_store_get_path                           (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    HildonTouchSelectorStringStore *store = HILDON_TOUCH_SELECTOR_STRING_STORE (tree_model);
+
+    g_return_val_if_fail (iter->stamp == store->stamp, NULL);
+
+    return gtk_tree_path_new_from_indices (ITER_ROW (iter), -1);
+}
+
+static void
+string_store_get_value                          (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 gint          column,
+                                                 GValue       *value)
+{
+    HildonTouchSelectorStringStore *store = HILDON_TOUCH_SELECTOR_STRING_STORE (tree_model);
+
+    g_return_if_fail (iter->stamp == store->stamp);
+    g_return_if_fail (column == 0);
+
+    g_value_init (value, G_TYPE_STRING);
+    g_value_set_string (value,
+                        hildon_touch_selector_string_store_get_text (store, ITER_ROW (iter)));
+}
+
+static gboolean
+string_store_iter_next                          (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    HildonTouchSelectorStringStore *store = HILDON_TOUCH_SELECTOR_STRING_STORE (tree_model);
+    gint row = ITER_ROW (iter) + 1;
+
+    if (row >= N_ROWS (store)) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+
+    iter->user_data = GINT_TO_POINTER (row);
+
+    return TRUE;
+}
+
+static gboolean
+string_store_iter_children                      (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreeIter  *parent)
+{
+    return string_store_iter_nth_child (tree_model, iter, parent, 0);
+}
+
+static gboolean
+string_store_iter_has_child                     (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    return FALSE;
+}
+
+static gint
+string_store_iter_n_children                    (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    if (iter != NULL)
+        return 0;
+
+    return N_ROWS (HILDON_TOUCH_SELECTOR_STRING_STORE (tree_model));
+}
+
+static gboolean
+string_store_iter_parent                        (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreeIter  *child)
+{
+    iter->stamp = 0;
+
+    return FALSE;
+}
+
+static void
+hildon_touch_selector_string_store_tree_model_init (GtkTreeModelIface *iface)
+{
+    iface->get_flags = string_store_get_flags;
+    iface->get_n_columns = string_store_get_n_columns;
+    iface->get_column_type = string_store_get_column_type;
+    iface->get_iter = string_store_get_iter;
+    iface->get_path = string_store_get_path;
+    iface->get_value = string_store_get_value;
+    iface->iter_next = string_store_iter_next;
+    iface->iter_children = string_store_iter_children;
+    iface->iter_has_child = string_store_iter_has_child;
+    iface->iter_n_children = string_store_iter_n_children;
+    iface->iter_nth_child = string_store_iter_nth_child;
+    iface->iter_parent = string_store_iter_parent;
+}
+
+/* Internal API */
+
+GtkTreeModel *
+hildon_touch_selector_string_store_new          (void)
+{
+    return g_object_new (HILDON_TYPE_TOUCH_SELECTOR_STRING_STORE, NULL);
+}
+
+/**
+ * hildon_touch_selector_string_store_new_sorted:
+ *
+ * Creates a #HildonTouchSelectorStringStore that keeps its rows sorted
+ * with g_utf8_collate(). The position given when adding a row is
+ * ignored.
+ **/
+GtkTreeModel *
+hildon_touch_selector_string_store_new_sorted   (void)
+{
+    HildonTouchSelectorStringStore *store;
+
+    store = g_object_new (HILDON_TYPE_TOUCH_SELECTOR_STRING_STORE, NULL);
+    store->key_offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+    return GTK_TREE_MODEL (store);
+}
+
+static void
+insert_sorted                                   (HildonTouchSelectorStringStore *store,
+                                                 const gchar                    *text,
+                                                 gsize                           len)
+{
+    gchar *key;
+    gsize key_len;
+    guint32 offset, key_offset;
+    gint position;
+
+    key = g_utf8_collate_key (text, len);
+    key_len = strlen (key);
+
+    if (!arena_reserve (&store->texts, len + 1) ||
+        !arena_reserve (&store->keys, key_len + 1)) {
+        g_free (key);
+        return;
+    }
+
+    offset = arena_add (&store->texts, text, len);
+    key_offset = arena_add (&store->keys, key, key_len);
+    g_free (key);
+
+    position = sorted_position (store, store->keys.data + key_offset);
+    g_array_insert_val (store->offsets, position, offset);
+    g_array_insert_val (store->key_offsets, position, key_offset);
+
+    if (position < N_ROWS (store) - 1)
+        bump_stamp (store);
+
+    emit_row_inserted (store, position);
+}
+
+/* Appends the new rows, announcing each one, then sorts them on their
+   own and merges them with the rows already in @store, which are sorted
+   too, announcing the result as a single reorder */
+static void
+append_array_sorted                             (HildonTouchSelectorStringStore *store,
+                                                 const gchar * const            *texts,
+                                                 gint                            n_texts)
+{
+    gchar **keys;
+    gsize total = 0;
+    gsize keys_total = 0;
+    GArray *offsets, *key_offsets;
+    gint *added, *new_order;
+    gint n_rows;
+    gint i, j, k;
+    gboolean moved = FALSE;
+
+    keys = g_new (gchar *, n_texts);
+    for (i = 0; i < n_texts; i++) {
+        keys[i] = g_utf8_collate_key (texts[i], -1);
+        total += strlen (texts[i]) + 1;
+        keys_total += strlen (keys[i]) + 1;
+    }
+
+    if (!arena_reserve (&store->texts, total) ||
+        !arena_reserve (&store->keys, keys_total)) {
+        for (i = 0; i < n_texts; i++)
+            g_free (keys[i]);
+        g_free (keys);
+        return;
+    }
+
+    for (i = 0; i < n_texts; i++) {
+        guint32 offset = arena_add (&store->texts, texts[i], strlen (texts[i]));
+        guint32 key_offset = arena_add (&store->keys, keys[i], strlen (keys[i]));
+
+        g_free (keys[i]);
+        g_array_append_val (store->offsets, offset);
+        g_array_append_val (store->key_offsets, key_offset);
+        emit_row_inserted (store, N_ROWS (store) - 1);
+    }
+    g_free (keys);
+
+    n_rows = N_ROWS (store);
+
+    added = g_new (gint, n_texts);
+    for (i = 0; i < n_texts; i++)
+        added[i] = n_rows - n_texts + i;
+    g_qsort_with_data (added, n_texts, sizeof (gint), compare_rows, store);
+
+    offsets = g_array_sized_new (FALSE, FALSE, sizeof (guint32), n_rows);
+    key_offsets = g_array_sized_new (FALSE, FALSE, sizeof (guint32), n_rows);
+    new_order = g_new (gint, n_rows);
+
+    for (i = 0, j = 0, k = 0; k < n_rows; k++) {
+        gint row;
+
+        if (j == n_texts ||
+            (i < n_rows - n_texts &&
+             strcmp (ROW_KEY (store, i), ROW_KEY (store, added[j])) <= 0))
+            row = i++;
+        else
+            row = added[j++];
+
+        if (row != k)
+            moved = TRUE;
+
+        new_order[k] = row;
+        g_array_append_val (offsets, g_array_index (store->offsets, guint32, row));
+        g_array_append_val (key_offsets, g_array_index (store->key_offsets, guint32, row));
+    }
+
+    if (moved) {
+        GtkTreePath *path = gtk_tree_path_new ();
+
+        g_array_free (store->offsets, TRUE);
+        g_array_free (store->key_offsets, TRUE);
+        store->offsets = offsets;
+        store->key_offsets = key_offsets;
+        bump_stamp (store);
+
+        gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+        gtk_tree_path_free (path);
+    } else {
+        g_array_free (offsets, TRUE);
+        g_array_free (key_offsets, TRUE);
+    }
+
+    g_free (new_order);
+    g_free (added);
+}
+
+/**
+ * hildon_touch_selector_string_store_insert:
+ * @store: a #HildonTouchSelectorStringStore
+ * @position: the position of the new row, a position out of range
+ * appends it
+ * @text: the text of the new row
+ *
+ * Inserts a row in @store, like gtk_list_store_insert_with_values().
+ **/
+void
+hildon_touch_selector_string_store_insert       (HildonTouchSelectorStringStore *store,
+                                                 gint                            position,
+                                                 const gchar                    *text)
+{
+    gsize len;
+    guint32 offset;
+
+    g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (store));
+    g_return_if_fail (text != NULL);
+
+    len = strlen (text);
+
+    if (store->key_offsets != NULL) {
+        insert_sorted (store, text, len);
+        return;
+    }
+
+    if (!arena_reserve (&store->texts, len + 1))
+        return;
+
+    offset = arena_add (&store->texts, text, len);
+
+    if (position < 0 || position >= N_ROWS (store)) {
+        position = N_ROWS (store);
+        g_array_append_val (store->offsets, offset);
+    } else {
+        /* The rows after @position move, so do their iters */
+        g_array_insert_val (store->offsets, position, offset);
+        bump_stamp (store);
+    }
+
+    emit_row_inserted (store, position);
+}
+
+/**
+ * hildon_touch_selector_string_store_append_array:
+ * @store: a #HildonTouchSelectorStringStore
+ * @texts: the texts of the new rows
+ * @n_texts: the number of elements in @texts, or -1 if it is
+ * %NULL-terminated
+ *
+ * Appends several rows to @store, growing the arena only once. A sorted
+ * store computes the collation keys of @texts once, sorts them and
+ * merges them with its rows.
+ **/
+void
+hildon_touch_selector_string_store_append_array (HildonTouchSelectorStringStore *store,
+                                                 const gchar * const            *texts,
+                                                 gint                            n_texts)
+{
+    gsize total = 0;
+    gint i;
+
+    g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (store));
+    g_return_if_fail (texts != NULL);
+
+    if (n_texts < 0)
+        n_texts = g_strv_length ((gchar **) texts);
+
+    if (n_texts == 0)
+        return;
+
+    if (store->key_offsets != NULL) {
+        append_array_sorted (store, texts, n_texts);
+        return;
+    }
+
+    for (i = 0; i < n_texts; i++)
+        total += strlen (texts[i]) + 1;
+
+    if (!arena_reserve (&store->texts, total))
+        return;
+
+    /* Each row is announced as soon as it exists, so the handlers
+       never see rows they were not told about yet */
+    for (i = 0; i < n_texts; i++) {
+        guint32 offset = arena_add (&store->texts, texts[i], strlen (texts[i]));
+
+        g_array_append_val (store->offsets, offset);
+        emit_row_inserted (store, N_ROWS (store) - 1);
+    }
+}
+
+/**
+ * hildon_touch_selector_string_store_get_sorted:
+ * @store: a #HildonTouchSelectorStringStore
+ *
+ * Returns: %TRUE if @store keeps its rows sorted, so that new rows can
+ * move the ones it already has
+ **/
+gboolean
+hildon_touch_selector_string_store_get_sorted   (HildonTouchSelectorStringStore *store)
+{
+    g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (store), FALSE);
+
+    return store->key_offsets != NULL;
+}
+
+gint
+hildon_touch_selector_string_store_get_n_rows   (HildonTouchSelectorStringStore *store)
+{
+    g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (store), 0);
+
+    return N_ROWS (store);
+}
+
+/**
+ * hildon_touch_selector_string_store_get_text:
+ * @store: a #HildonTouchSelectorStringStore
+ * @row: a row of @store
+ *
+ * Returns: the text of @row, owned by @store and valid until the next
+ * row is added.
+ **/
+const gchar *
+hildon_touch_selector_string_store_get_text     (HildonTouchSelectorStringStore *store,
+                                                 gint                            row)
+{
+    g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (store), NULL);
+    g_return_val_if_fail (row >= 0 && row < N_ROWS (store), NULL);
+
+    return store->texts.data + g_array_index (store->offsets, guint32, row);
+}
+
+/**
+ * hildon_touch_selector_string_store_peek:
+ * @store: a #HildonTouchSelectorStringStore
+ * @iter: a valid #GtkTreeIter of @store
+ *
+ * Like hildon_touch_selector_string_store_get_text(), for the row
+ * pointed to by @iter.
+ **/
+const gchar *
+hildon_touch_selector_string_store_peek         (HildonTouchSelectorStringStore *store,
+                                                 GtkTreeIter                    *iter)
+{
+    g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (store), NULL);
+    g_return_val_if_fail (iter->stamp == store->stamp, NULL);
+
+    return hildon_touch_selector_string_store_get_text (store, ITER_ROW (iter));
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2008 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL_PRIVATE_H__
+#define                                         __HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL_PRIVATE_H__
+
+#include                                        "hildon-touch-selector.h"
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_TYPE_TOUCH_SELECTOR_VIRTUAL_MODEL \
+                                                (hildon_touch_selector_virtual_model_get_type ())
+
+#define                                         HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                                                HILDON_TYPE_TOUCH_SELECTOR_VIRTUAL_MODEL, \
+                                                HildonTouchSelectorVirtualModel))
+
+#define                                         HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL(obj) \
+                                                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                                                HILDON_TYPE_TOUCH_SELECTOR_VIRTUAL_MODEL))
+
+typedef struct                                  _HildonTouchSelectorVirtualModel HildonTouchSelectorVirtualModel;
+typedef struct                                  _HildonTouchSelectorVirtualModelClass HildonTouchSelectorVirtualModelClass;
+
+GType G_GNUC_INTERNAL
+hildon_touch_selector_virtual_model_get_type    (void) G_GNUC_CONST;
+
+GtkTreeModel * G_GNUC_INTERNAL
+hildon_touch_selector_virtual_model_new         (gint                        n_rows,
+                                                 HildonTouchSelectorRowFunc  func,
+                                                 gpointer                    data,
+                                                 GDestroyNotify              destroy);
+
+GtkTreeModel * G_GNUC_INTERNAL
+hildon_touch_selector_virtual_model_new_range   (gint                        first,
+                                                 gint                        step,
+                                                 gint                        n_rows,
+                                                 HildonTouchSelectorRowFunc  func,
+                                                 gpointer                    data,
+                                                 GDestroyNotify              destroy);
+
+void G_GNUC_INTERNAL
+hildon_touch_selector_virtual_model_set_n_rows  (HildonTouchSelectorVirtualModel *model,
+                                                 gint                             n_rows);
+
+gint G_GNUC_INTERNAL
+hildon_touch_selector_virtual_model_get_n_rows  (HildonTouchSelectorVirtualModel *model);
+
+const gchar * G_GNUC_INTERNAL
+hildon_touch_selector_virtual_model_peek        (HildonTouchSelectorVirtualModel *model,
+                                                 GtkTreeIter                     *iter);
+
+void G_GNUC_INTERNAL
+hildon_touch_selector_virtual_model_row_changed (HildonTouchSelectorVirtualModel *model,
+                                                 gint                             row);
+
+G_END_DECLS
+
+#endif                                          /* __HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL_PRIVATE_H__ */
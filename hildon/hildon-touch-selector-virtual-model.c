@@ -0,0 +1,461 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2008 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * HildonTouchSelectorVirtualModel is the #GtkTreeModel behind the
+ * columns added with hildon_touch_selector_append_virtual_column().
+ * It stores nothing but a row count: iters are row indices, and the
+ * text of a row is asked to a #HildonTouchSelectorRowFunc only when
+ * the row is displayed. The last rows asked for are kept in a small
+ * cache, since the tree view reads the same rows over and over while
+ * panning.
+ *
+ * Models created with hildon_touch_selector_virtual_model_new_range()
+ * have a second, integer column computed from the row index, so they
+ * can stand in for the (label, value) list stores of the date and time
+ * selectors at a constant cost whatever the range.
+ */
+
+#ifdef                                          HAVE_CONFIG_H
+#include                                        <config.h>
+#endif
+
+#include                                        "hildon-touch-selector-virtual-model-private.h"
+
+/* Must be a power of two */
+#define                                         ROW_CACHE_SIZE 128
+
+typedef struct
+{
+    gint row;
+    gchar *text;
+} RowCacheSlot;
+
+struct                                          _HildonTouchSelectorVirtualModel
+{
+    GObject parent_instance;
+
+    gint n_rows;
+    gint stamp;
+
+    gboolean has_value_column;
+    gint first;
+    gint step;
+
+    HildonTouchSelectorRowFunc func;
+    gpointer data;
+    GDestroyNotify destroy;
+
+    RowCacheSlot cache[ROW_CACHE_SIZE];
+};
+
+struct                                          _HildonTouchSelectorVirtualModelClass
+{
+    GObjectClass parent_class;
+};
+
+static void
+hildon_touch_selector_virtual_model_tree_model_init (GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (HildonTouchSelectorVirtualModel, hildon_touch_selector_virtual_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+                                                hildon_touch_selector_virtual_model_tree_model_init))
+
+#define                                         ITER_ROW(iter) \
+                                                GPOINTER_TO_INT ((iter)->user_data)
+
+static void
+row_cache_invalidate                            (HildonTouchSelectorVirtualModel *model,
+                                                 gint                             row)
+{
+    RowCacheSlot *slot = &model->cache[row & (ROW_CACHE_SIZE - 1)];
+
+    if (slot->row == row) {
+        g_free (slot->text);
+        slot->text = NULL;
+        slot->row = -1;
+    }
+}
+
+static const gchar *
+row_cache_lookup                                (HildonTouchSelectorVirtualModel *model,
+                                                 gint                             row)
+{
+    RowCacheSlot *slot = &model->cache[row & (ROW_CACHE_SIZE - 1)];
+
+    if (slot->row != row) {
+        g_free (slot->text);
+        slot->text = model->func ? (* model->func) (row, model->data) : NULL;
+        slot->row = row;
+    }
+
+    return slot->text;
+}
+
+static void
+hildon_touch_selector_virtual_model_finalize    (GObject *object)
+{
+    HildonTouchSelectorVirtualModel *model = HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (object);
+    gint i;
+
+    for (i = 0; i < ROW_CACHE_SIZE; i++)
+        g_free (model->cache[i].text);
+
+    if (model->destroy)
+        (* model->destroy) (model->data);
+
+    G_OBJECT_CLASS (hildon_touch_selector_virtual_model_parent_class)->finalize (object);
+}
+
+static void
+hildon_touch_selector_virtual_model_class_init  (HildonTouchSelectorVirtualModelClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->finalize = hildon_touch_selector_virtual_model_finalize;
+}
+
+static void
+hildon_touch_selector_virtual_model_init        (HildonTouchSelectorVirtualModel *model)
+{
+    gint i;
+
+    model->n_rows = 0;
+    model->stamp = g_random_int ();
+    model->has_value_column = FALSE;
+    model->first = 0;
+    model->step = 1;
+    model->func = NULL;
+    model->data = NULL;
+    model->destroy = NULL;
+
+    for (i = 0; i < ROW_CACHE_SIZE; i++) {
+        model->cache[i].row = -1;
+        model->cache[i].text = NULL;
+    }
+}
+
+/* GtkTreeModel implementation */
+
+static GtkTreeModelFlags
+virtual_model_get_flags                         (GtkTreeModel *tree_model)
+{
+    return GTK_TREE_MODEL_LIST_ONLY | GTK_TREE_MODEL_ITERS_PERSIST;
+}
+
+static gint
+virtual_model_get_n_columns                     (GtkTreeModel *tree_model)
+{
+    return HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (tree_model)->has_value_column ? 2 : 1;
+}
+
+static GType
+virtual_model_get_column_type                   (GtkTreeModel *tree_model,
+                                                 gint          index)
+{
+    g_return_val_if_fail (index >= 0 && index < virtual_model_get_n_columns (tree_model),
+                          G_TYPE_INVALID);
+
+    return (index == 0) ? G_TYPE_STRING : G_TYPE_INT;
+}
+
+static gboolean
+virtual_model_iter_nth_child                    (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreeIter  *parent,
+                                                 gint          n)
+{
+    HildonTouchSelectorVirtualModel *model = HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (tree_model);
+
+    iter->stamp = 0;
+
+    if (parent != NULL || n < 0 || n >= model->n_rows)
+        return FALSE;
+
+    iter->stamp = model->stamp;
+    iter->user_data = GINT_TO_POINTER (n);
+
+    return TRUE;
+}
+
+static gboolean
+virtual_model_get_iter                          (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreePath  *path)
+{
+    if (gtk_tree_path_get_depth (path) != 1) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+
+    return virtual_model_iter_nth_child (tree_model, iter, NULL,
+                                         gtk_tree_path_get_indices (path)[0]);
+}
+
+static GtkTreePath *
+virtual_model_get_path                          (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    HildonTouchSelectorVirtualModel *model = HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (tree_model);
+
+    g_return_val_if_fail (iter->stamp == model->stamp, NULL);
+
+    return gtk_tree_path_new_from_indices (ITER_ROW (iter), -1);
+}
+
+static void
+virtual_model_get_value                         (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 gint          column,
+                                                 GValue       *value)
+{
+    HildonTouchSelectorVirtualModel *model = HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (tree_model);
+
+    g_return_if_fail (iter->stamp == model->stamp);
+    g_return_if_fail (column >= 0 && column < virtual_model_get_n_columns (tree_model));
+
+    if (column == 1) {
+        g_value_init (value, G_TYPE_INT);
+        g_value_set_int (value, model->first + ITER_ROW (iter) * model->step);
+        return;
+    }
+
+    g_value_init (value, G_TYPE_STRING);
+    g_value_set_string (value, row_cache_lookup (model, ITER_ROW (iter)));
+}
+
+static gboolean
+virtual_model_iter_next                         (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    HildonTouchSelectorVirtualModel *model = HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (tree_model);
+    gint row = ITER_ROW (iter) + 1;
+
+    if (row >= model->n_rows) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+
+    iter->user_data = GINT_TO_POINTER (row);
+
+    return TRUE;
+}
+
+static gboolean
+virtual_model_iter_children                     (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreeIter  *parent)
+{
+    return virtual_model_iter_nth_child (tree_model, iter, parent, 0);
+}
+
+static gboolean
+virtual_model_iter_has_child                    (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    return FALSE;
+}
+
+static gint
+virtual_model_iter_n_children                   (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter)
+{
+    if (iter != NULL)
+        return 0;
+
+    return HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (tree_model)->n_rows;
+}
+
+static gboolean
+virtual_model_iter_parent                       (GtkTreeModel *tree_model,
+                                                 GtkTreeIter  *iter,
+                                                 GtkTreeIter  *child)
+{
+    iter->stamp = 0;
+
+    return FALSE;
+}
+
+static void
+hildon_touch_selector_virtual_model_tree_model_init (GtkTreeModelIface *iface)
+{
+    iface->get_flags = virtual_model_get_flags;
+    iface->get_n_columns = virtual_model_get_n_columns;
+    iface->get_column_type = virtual_model_get_column_type;
+    iface->get_iter = virtual_model_get_iter;
+    iface->get_path = virtual_model_get_path;
+    iface->get_value = virtual_model_get_value;
+    iface->iter_next = virtual_model_iter_next;
+    iface->iter_children = virtual_model_iter_children;
+    iface->iter_has_child = virtual_model_iter_has_child;
+    iface->iter_n_children = virtual_model_iter_n_children;
+    iface->iter_nth_child = virtual_model_iter_nth_child;
+    iface->iter_parent = virtual_model_iter_parent;
+}
+
+/* Internal API */
+
+GtkTreeModel *
+hildon_touch_selector_virtual_model_new         (gint                        n_rows,
+                                                 HildonTouchSelectorRowFunc  func,
+                                                 gpointer                    data,
+                                                 GDestroyNotify              destroy)
+{
+    HildonTouchSelectorVirtualModel *model;
+
+    g_return_val_if_fail (n_rows >= 0, NULL);
+    g_return_val_if_fail (func != NULL, NULL);
+
+    model = g_object_new (HILDON_TYPE_TOUCH_SELECTOR_VIRTUAL_MODEL, NULL);
+    model->n_rows = n_rows;
+    model->func = func;
+    model->data = data;
+    model->destroy = destroy;
+
+    return GTK_TREE_MODEL (model);
+}
+
+/**
+ * hildon_touch_selector_virtual_model_new_range:
+ * @first: value of the first row
+ * @step: difference between the values of consecutive rows
+ * @n_rows: the number of rows
+ * @func: function returning the text of a row
+ * @data: data for @func
+ * @destroy: destroy notify for @data, or %NULL
+ *
+ * Creates a model with a text column, filled by @func, and an integer
+ * column whose value for row n is @first + n * @step.
+ **/
+GtkTreeModel *
+hildon_touch_selector_virtual_model_new_range   (gint                        first,
+                                                 gint                        step,
+                                                 gint                        n_rows,
+                                                 HildonTouchSelectorRowFunc  func,
+                                                 gpointer                    data,
+                                                 GDestroyNotify              destroy)
+{
+    HildonTouchSelectorVirtualModel *model;
+
+    model = HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (
+        hildon_touch_selector_virtual_model_new (n_rows, func, data, destroy));
+    g_return_val_if_fail (model != NULL, NULL);
+
+    model->has_value_column = TRUE;
+    model->first = first;
+    model->step = step;
+
+    return GTK_TREE_MODEL (model);
+}
+
+/**
+ * hildon_touch_selector_virtual_model_set_n_rows:
+ * @model: a #HildonTouchSelectorVirtualModel
+ * @n_rows: the new number of rows
+ *
+ * Changes the number of rows of @model, adding or removing rows at
+ * its end.
+ **/
+void
+hildon_touch_selector_virtual_model_set_n_rows  (HildonTouchSelectorVirtualModel *model,
+                                                 gint                             n_rows)
+{
+    GtkTreePath *path;
+    GtkTreeIter iter;
+
+    g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL (model));
+    g_return_if_fail (n_rows >= 0);
+
+    /* Rows are removed from the end so that the paths of the
+       remaining ones are left untouched */
+    while (model->n_rows > n_rows) {
+        model->n_rows--;
+        row_cache_invalidate (model, model->n_rows);
+        path = gtk_tree_path_new_from_indices (model->n_rows, -1);
+        gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
+        gtk_tree_path_free (path);
+    }
+
+    while (model->n_rows < n_rows) {
+        iter.stamp = model->stamp;
+        iter.user_data = GINT_TO_POINTER (model->n_rows);
+        row_cache_invalidate (model, model->n_rows);
+        path = gtk_tree_path_new_from_indices (model->n_rows, -1);
+        model->n_rows++;
+        gtk_tree_model_row_inserted (GTK_TREE_MODEL (model), path, &iter);
+        gtk_tree_path_free (path);
+    }
+}
+
+gint
+hildon_touch_selector_virtual_model_get_n_rows  (HildonTouchSelectorVirtualModel *model)
+{
+    g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL (model), 0);
+
+    return model->n_rows;
+}
+
+/**
+ * hildon_touch_selector_virtual_model_peek:
+ * @model: a #HildonTouchSelectorVirtualModel
+ * @iter: a valid #GtkTreeIter of @model
+ *
+ * Gets the text of the row pointed to by @iter without copying it.
+ *
+ * Returns: the text of the row, owned by the row cache of @model. It
+ * is only valid until the next time @model is asked for a row.
+ **/
+const gchar *
+hildon_touch_selector_virtual_model_peek        (HildonTouchSelectorVirtualModel *model,
+                                                 GtkTreeIter                     *iter)
+{
+    g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL (model), NULL);
+    g_return_val_if_fail (iter->stamp == model->stamp, NULL);
+
+    return row_cache_lookup (model, ITER_ROW (iter));
+}
+
+/**
+ * hildon_touch_selector_virtual_model_row_changed:
+ * @model: a #HildonTouchSelectorVirtualModel
+ * @row: a row of @model
+ *
+ * Drops the cached text of @row and notifies that it has changed.
+ **/
+void
+hildon_touch_selector_virtual_model_row_changed (HildonTouchSelectorVirtualModel *model,
+                                                 gint                             row)
+{
+    GtkTreePath *path;
+    GtkTreeIter iter;
+
+    g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL (model));
+    g_return_if_fail (row >= 0 && row < model->n_rows);
+
+    row_cache_invalidate (model, row);
+
+    iter.stamp = model->stamp;
+    iter.user_data = GINT_TO_POINTER (row);
+    path = gtk_tree_path_new_from_indices (row, -1);
+    gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+    gtk_tree_path_free (path);
+}
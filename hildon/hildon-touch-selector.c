@@ -177,6 +177,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <libintl.h>
 #include <glib.h>
 
 #include "hildon-gtk.h"
@@ -184,8 +185,12 @@
 #include "hildon-pannable-area.h"
 #include "hildon-touch-selector.h"
 #include "hildon-touch-selector-private.h"
+#include "hildon-touch-selector-virtual-model-private.h"
+#include "hildon-touch-selector-string-store-private.h"
 #include "hildon-live-search.h"
 #include "hildon-helper.h"
+#include "hildon-private.h"
+#include "hildon-marshalers.h"
 
 #define HILDON_TOUCH_SELECTOR_GET_PRIVATE(obj)                          \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HILDON_TYPE_TOUCH_SELECTOR, HildonTouchSelectorPrivate))
@@ -207,42 +212,111 @@ struct _HildonTouchSelectorColumnPrivate
   GtkTreeModel *model;
   gint text_column;
   GtkTreeView *tree_view;
-  gulong realize_handler;
+  gulong allocate_handler;      /* scrolls to initial_path once allocated */
   GtkTreePath *initial_path;
   GtkTreeModel *filter;
+  gboolean unfiltered;          /* filter is the model itself */
   GtkWidget *livesearch;
 
   GtkWidget *panarea;           /* the pannable widget */
   GtkWidget *vbox;
   GtkTreeRowReference *last_activated;
+
+  GHashTable *norm_cache;       /* row -> normalized text, for live search */
+
+  /* fragment of the default print function output for this column */
+  gboolean print_valid;
+  gboolean print_selected;
+  gchar *print_text;
+
+  gboolean fixed_height_rows;   /* all the rows have the same height */
+  gint row_height;              /* cached height of a row, 0 if unknown */
+
+  gint visible_rows;            /* rows shown from the top, -1 for all */
+  GtkTreeModelFilterVisibleFunc row_filter;    /* set by subclasses */
+  gpointer row_filter_data;
+  gboolean visible_func_set;    /* the above are installed in the filter */
+
+  /* Until the selector is added to a window, a lazy column does not give
+     its model to the tree view, and keeps its selection here */
+  gboolean attached;
+  GtkTreeRowReference *pending_row;
+
+  /* child index of each visible row, for flat models */
+  GArray *visible_map;
+  gboolean visible_map_valid;
+  gint visible_map_n_rows;      /* rows of the model it was kept for */
+
+  gboolean cache_layouts;       /* text cells keep their shaped layouts */
+
+  gint natural_height;          /* cached natural height, -1 if unknown */
+  gint natural_height_limit;    /* the height limit it was measured for */
+
+  GArray *diff_snapshot;        /* sorted selected rows last reported by
+                                   "selection-diff", NULL if unknown */
 };
 
 struct _HildonTouchSelectorPrivate
 {
-  GSList *columns;              /* the selection columns */
+  GPtrArray *columns;           /* the selection columns */
   GtkWidget *hbox;              /* the container for the selector's columns */
   gboolean initial_scroll;      /* whether initial fancy scrolling to selection */
   gboolean has_live_search;
-  GSList *norm_tokens;
+  HildonHelperQuery *query;     /* compiled live search query */
 
   gboolean changed_blocked;
+  guint changed_freeze_count;   /* nesting of freeze_changed calls */
+  guint64 changed_dirty;        /* columns < 64 changed while frozen */
+  gboolean changed_dirty_high;  /* some column >= 64 changed while frozen */
 
   HildonTouchSelectorPrintFunc print_func;
   gpointer print_user_data;
   GDestroyNotify print_destroy_func;
+  gint summary_limit;           /* max items printed in multiple mode */
+  gboolean lazy_columns;
+  gint height_limit;            /* the most the parent will show, 0 if unknown */
+
+  /* Update of the dependent columns, see hildon_touch_selector_queue_settled() */
+  HildonTouchSelectorSettledFunc settled_func;
+  gpointer settled_data;
+  guint settled_id;
+  gint settled_column;
+  gint64 settled_first;         /* when the burst of changes started */
+  gdouble settled_value;        /* scroll position at the last check */
 };
 
+#define NTH_COLUMN(selector, n)                                         \
+  ((HildonTouchSelectorColumn *) g_ptr_array_index ((selector)->priv->columns, (n)))
+
+/* Returns the position of @column in @selector, or -1 */
+static gint
+hildon_touch_selector_column_index (HildonTouchSelector *selector,
+                                    HildonTouchSelectorColumn *column)
+{
+  guint i;
+
+  for (i = 0; i < selector->priv->columns->len; i++) {
+    if (NTH_COLUMN (selector, i) == column)
+      return i;
+  }
+
+  return -1;
+}
+
 enum
 {
   PROP_HAS_MULTIPLE_SELECTION = 1,
   PROP_INITIAL_SCROLL,
-  PROP_LIVE_SEARCH
+  PROP_LIVE_SEARCH,
+  PROP_SUMMARY_LIMIT,
+  PROP_LAZY_COLUMNS
 };
 
 enum
 {
   CHANGED,
   COLUMNS_CHANGED,
+  SELECTION_DIFF,
   LAST_SIGNAL
 };
 
@@ -251,6 +325,16 @@ static gint hildon_touch_selector_signals[LAST_SIGNAL] = { 0 };
 static void
 hildon_touch_selector_dispose                   (GObject * object);
 
+static void
+hildon_touch_selector_finalize                  (GObject * object);
+
+static void
+hildon_touch_selector_map                       (GtkWidget *widget);
+
+static void
+hildon_touch_selector_hierarchy_changed         (GtkWidget *widget,
+                                                 GtkWidget *previous_toplevel);
+
 static void
 hildon_touch_selector_get_property              (GObject * object,
                                                  guint prop_id,
@@ -300,6 +384,27 @@ static void
 on_row_deleted                                 (GtkTreeModel *model,
                                                 GtkTreePath *path,
                                                 gpointer userdata);
+static void
+on_row_changed_invalidate                      (GtkTreeModel *model,
+                                                GtkTreePath *path,
+                                                GtkTreeIter *iter,
+                                                gpointer userdata);
+static void
+on_rows_reordered_invalidate                   (GtkTreeModel *model,
+                                                GtkTreePath *path,
+                                                GtkTreeIter *iter,
+                                                gpointer new_order,
+                                                gpointer userdata);
+static void
+on_row_inserted_invalidate                     (GtkTreeModel *model,
+                                                GtkTreePath *path,
+                                                GtkTreeIter *iter,
+                                                gpointer userdata);
+static void
+on_tree_view_style_updated                     (GtkWidget *widget,
+                                                gpointer userdata);
+static void
+hildon_touch_selector_column_invalidate_print  (HildonTouchSelectorColumn *col);
 
 static void
 hildon_touch_selector_scroll_to (HildonTouchSelectorColumn *column,
@@ -319,6 +424,9 @@ static void
 hildon_touch_selector_emit_value_changed        (HildonTouchSelector *selector,
                                                  gint column);
 
+static void
+hildon_touch_selector_flush_settled             (HildonTouchSelector *selector);
+
 /* GtkCellLayout implementation (HildonTouchSelectorColumn)*/
 static void hildon_touch_selector_column_cell_layout_init         (GtkCellLayoutIface      *iface);
 
@@ -358,11 +466,14 @@ hildon_touch_selector_class_init (HildonTouchSelectorClass * class)
 
   /* GObject */
   gobject_class->dispose = hildon_touch_selector_dispose;
+  gobject_class->finalize = hildon_touch_selector_finalize;
   gobject_class->get_property = hildon_touch_selector_get_property;
   gobject_class->set_property = hildon_touch_selector_set_property;
 
   /* GtkWidget */
   widget_class->get_preferred_height = hildon_touch_selector_get_preferred_height;
+  widget_class->map = hildon_touch_selector_map;
+  widget_class->hierarchy_changed = hildon_touch_selector_hierarchy_changed;
 
   /* GtkContainer */
   container_class->remove = hildon_touch_selector_remove;
@@ -409,6 +520,37 @@ hildon_touch_selector_class_init (HildonTouchSelectorClass * class)
                   NULL, NULL,
                   g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
 
+  /**
+   * HildonTouchSelector::selection-diff:
+   * @selector: the object which received the signal
+   * @column: the number of the column that has changed
+   * @added: (element-type gint) (allow-none): the positions of the rows
+   * selected since the previous emission, sorted
+   * @removed: (element-type gint) (allow-none): the positions of the rows
+   * unselected since the previous emission, sorted
+   *
+   * The "selection-diff" signal is emitted right before
+   * #HildonTouchSelector::changed when the selection of @column changed,
+   * with the rows of its list model that entered and left the selection.
+   * Listeners of large multiple selections can then update in proportion
+   * to the change instead of reading the whole selection.
+   *
+   * When the difference is not known, because no handler was connected
+   * at the previous change or the rows of the model were inserted,
+   * deleted or reordered since, both @added and @removed are %NULL and
+   * the selection must be read again with
+   * hildon_touch_selector_get_selected_indices().
+   *
+   * Since: 3.0
+   */
+  hildon_touch_selector_signals[SELECTION_DIFF] =
+    g_signal_new ("selection-diff",
+                  G_OBJECT_CLASS_TYPE (class),
+                  G_SIGNAL_RUN_LAST, 0,
+                  NULL, NULL,
+                  _hildon_marshal_VOID__INT_BOXED_BOXED, G_TYPE_NONE, 3,
+                  G_TYPE_INT, G_TYPE_ARRAY, G_TYPE_ARRAY);
+
   /* properties */
 
   g_object_class_install_property (gobject_class, PROP_HAS_MULTIPLE_SELECTION,
@@ -443,6 +585,42 @@ hildon_touch_selector_class_init (HildonTouchSelectorClass * class)
                                                          TRUE,
                                                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
 
+  /**
+   * HildonTouchSelector:summary-limit:
+   *
+   * The maximum number of selected items that the default print
+   * function lists in multiple selection mode. The remaining items are
+   * summarized with their count. A value of 0 means no limit.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (gobject_class),
+                                   PROP_SUMMARY_LIMIT,
+                                   g_param_spec_int ("summary-limit",
+                                                     "Summary limit",
+                                                     "Maximum number of selected items "
+                                                     "listed by the default print function",
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonTouchSelector:lazy-columns:
+   *
+   * Whether the tree views of the columns are only filled when the
+   * selector is added to a window. See
+   * hildon_touch_selector_set_lazy_columns().
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (gobject_class),
+                                   PROP_LAZY_COLUMNS,
+                                   g_param_spec_boolean ("lazy-columns",
+                                                         "Lazy columns",
+                                                         "Whether to fill the columns only "
+                                                         "when the selector is added to a window",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* style properties */
   /* We need to ensure fremantle mode for the treeview in order to work
      properly. This is not about the appearance, this is about behaviour */
@@ -473,6 +651,12 @@ hildon_touch_selector_get_property (GObject * object,
     g_value_set_boolean (value,
                          hildon_touch_selector_get_live_search (HILDON_TOUCH_SELECTOR (object)));
     break;
+  case PROP_SUMMARY_LIMIT:
+    g_value_set_int (value, priv->summary_limit);
+    break;
+  case PROP_LAZY_COLUMNS:
+    g_value_set_boolean (value, priv->lazy_columns);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     break;
@@ -493,6 +677,14 @@ hildon_touch_selector_set_property (GObject *object, guint prop_id,
     hildon_touch_selector_set_live_search (HILDON_TOUCH_SELECTOR (object),
                                            g_value_get_boolean (value));
     break;
+  case PROP_SUMMARY_LIMIT:
+    hildon_touch_selector_set_summary_limit (HILDON_TOUCH_SELECTOR (object),
+                                             g_value_get_int (value));
+    break;
+  case PROP_LAZY_COLUMNS:
+    hildon_touch_selector_set_lazy_columns (HILDON_TOUCH_SELECTOR (object),
+                                            g_value_get_boolean (value));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     break;
@@ -508,16 +700,22 @@ hildon_touch_selector_init (HildonTouchSelector * selector)
   gtk_widget_set_has_window (GTK_WIDGET (selector), FALSE);
   gtk_widget_set_redraw_on_allocate (GTK_WIDGET (selector), FALSE);
 
-  selector->priv->columns = NULL;
+  selector->priv->columns = g_ptr_array_new ();
 
-  selector->priv->norm_tokens = NULL;
+  selector->priv->query = NULL;
   selector->priv->print_func = NULL;
   selector->priv->print_user_data = NULL;
   selector->priv->print_destroy_func = NULL;
+  selector->priv->summary_limit = 0;
+  selector->priv->lazy_columns = FALSE;
+  selector->priv->height_limit = 0;
   selector->priv->initial_scroll = TRUE;
   selector->priv->hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
 
   selector->priv->changed_blocked = FALSE;
+  selector->priv->changed_freeze_count = 0;
+  selector->priv->changed_dirty = 0;
+  selector->priv->changed_dirty_high = FALSE;
 
   gtk_box_pack_end (GTK_BOX (selector), selector->priv->hbox,
                     TRUE, TRUE, 0);
@@ -533,10 +731,15 @@ hildon_touch_selector_dispose (GObject * object)
   hildon_touch_selector_set_print_func_full (selector,
                                              NULL, NULL, NULL);
 
-  if (selector->priv->norm_tokens != NULL) {
-      g_slist_foreach (selector->priv->norm_tokens, (GFunc) g_free, NULL);
-      g_slist_free (selector->priv->norm_tokens);
-      selector->priv->norm_tokens = NULL;
+  if (selector->priv->query != NULL) {
+      hildon_helper_query_free (selector->priv->query);
+      selector->priv->query = NULL;
+  }
+
+  if (selector->priv->settled_id != 0) {
+      g_source_remove (selector->priv->settled_id);
+      selector->priv->settled_id = 0;
+      selector->priv->settled_func = NULL;
   }
 
   gobject_class = G_OBJECT_CLASS (hildon_touch_selector_parent_class);
@@ -546,259 +749,1058 @@ hildon_touch_selector_dispose (GObject * object)
 }
 
 static void
-clean_column                                    (HildonTouchSelectorColumn *col,
-                                                 HildonTouchSelector *selector)
+hildon_touch_selector_finalize (GObject * object)
 {
-  g_signal_handlers_disconnect_by_func (col->priv->model,
-                                        on_row_changed, selector);
-  g_signal_handlers_disconnect_by_func (col->priv->model,
-                                        on_row_deleted, selector);
+  HildonTouchSelector *selector = HILDON_TOUCH_SELECTOR (object);
 
-  if (col->priv->last_activated != NULL) {
-    gtk_tree_row_reference_free (col->priv->last_activated);
-    col->priv->last_activated = NULL;
-  }
-}
+  g_ptr_array_free (selector->priv->columns, TRUE);
 
-/*
- * IMPLEMENTATION NOTES:
- * Some people sent questions regarding the fact that the dispose/finalize functions
- * doesn't clean the internal widgets that could lead to leak memory, so we will
- * clarify this topic.
- *
- * This is not required as #HildonTouchSelector extends #GtkContainer. When the
- * widget is freed, the #GtkContainer freeing memory functions are called. This
- * process includes remove each widget individually, so all the widgets are
- * properly freed.
- *
- * In the same way, this widget redefines gtk_container->remove function, in
- * order to free the column related information if it is required.
- *
- * Please take a look to hildon_touch_selector_remove for more information.
- */
+  G_OBJECT_CLASS (hildon_touch_selector_parent_class)->finalize (object);
+}
 
-/*------------------------------ GtkContainer ------------------------------ */
+static gboolean
+hildon_touch_selector_is_anchored               (HildonTouchSelector *selector)
+{
+  return gtk_widget_is_toplevel (gtk_widget_get_toplevel (GTK_WIDGET (selector)));
+}
 
 /*
- * Required in order to free the column at the columns list
+ * Visible row map of a column: for flat models, the child index of
+ * every row shown by the filter, in order. It is built in one pass the
+ * first time it is needed, and then converts filter indices to child
+ * indices by lookup, and child indices to filter indices by binary
+ * search, where GtkTreeModelFilter walks its levels for every
+ * conversion. Rows the model inserts or deletes update it in place,
+ * so that filling a model while looking up its rows stays linear. Rows
+ * the filter shows or hides, and reorders, make it be built again, so
+ * that a whole refilter costs a single rebuild.
  */
 static void
-hildon_touch_selector_remove (GtkContainer * container, GtkWidget * widget)
+on_filter_changed_invalidate_map (HildonTouchSelectorColumn *column)
 {
-  HildonTouchSelector *selector = NULL;
+  column->priv->visible_map_valid = FALSE;
+  column->priv->natural_height = -1;
+}
 
-  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (container));
-  selector = HILDON_TOUCH_SELECTOR (container);
+static void
+on_filter_row_changed_invalidate_height (HildonTouchSelectorColumn *column)
+{
+  /* The new contents of the row may have a different height */
+  column->priv->natural_height = -1;
+}
 
-  /* Remove the extra data related to the columns, if required. */
-  if (widget == selector->priv->hbox) {
-    g_slist_foreach (selector->priv->columns, (GFunc) clean_column, selector);
-    g_slist_foreach (selector->priv->columns, (GFunc) g_object_unref, NULL);
+/* Position of the first visible row whose child index is >= @index */
+static guint
+visible_map_lower_bound (GArray *map,
+                         gint index)
+{
+  guint lo = 0;
+  guint hi = map->len;
 
-    g_slist_free (selector->priv->columns);
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
 
-    selector->priv->columns = NULL;
+    if (g_array_index (map, gint, mid) < index)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
-  /* Now remove the widget itself from the container */
-  GTK_CONTAINER_CLASS (hildon_touch_selector_parent_class)->remove (container, widget);
+  return lo;
 }
 
-/* ------------------------------ PRIVATE METHODS ---------------------------- */
-void
-hildon_touch_selector_block_changed             (HildonTouchSelector *selector)
+/* Whether the map was kept for the rows the model has now. The filter
+   announces the rows the model inserts or deletes before the model
+   handlers below run, so until those run the map is behind the model.
+   A map built meanwhile is not, and then they have nothing to do */
+static gboolean
+visible_map_is_current (HildonTouchSelectorColumn *column)
 {
-  selector->priv->changed_blocked = TRUE;
+  return column->priv->visible_map_valid &&
+    gtk_tree_model_iter_n_children (column->priv->model, NULL) == column->priv->visible_map_n_rows;
 }
 
-void
-hildon_touch_selector_unblock_changed           (HildonTouchSelector *selector)
+/* The filter showed or hid a row, or announced one the model inserts
+   or deletes, which is left to the model handlers below. A refilter
+   shows and hides many rows, so the map is built again once for all
+   of them rather than updated for each */
+static void
+on_filter_visibility_invalidate_map (HildonTouchSelectorColumn *column)
 {
-  selector->priv->changed_blocked = FALSE;
-}
+  column->priv->natural_height = -1;
 
-void
-hildon_touch_selector_column_disable_focus      (HildonTouchSelectorColumn *col)
-{
-    g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (col));
-    gtk_widget_set_can_focus (GTK_WIDGET (col->priv->tree_view), FALSE);
+  if (visible_map_is_current (column))
+    column->priv->visible_map_valid = FALSE;
 }
 
 static void
-hildon_touch_selector_emit_value_changed        (HildonTouchSelector *selector,
-                                                 gint column)
+on_model_row_inserted_update_map (GtkTreeModel *model,
+                                  GtkTreePath *path,
+                                  GtkTreeIter *iter,
+                                  HildonTouchSelectorColumn *column)
 {
-  /* FIXME: it could be good to emit too the GtkTreePath of the element
-     selected, as now it is required to connect to the signal and then ask
-     for the element selected. We can't do this API change, in order to avoid
-     and ABI break */
-  if (!selector->priv->changed_blocked) {
-    if (hildon_touch_selector_get_column_selection_mode (selector) == HILDON_TOUCH_SELECTOR_SELECTION_MODE_SINGLE &&
-        selector->priv->columns) {
-      HildonTouchSelectorColumn *col;
-      col = (HildonTouchSelectorColumn *) selector->priv->columns->data;
-      if (col->priv->livesearch) {
-        hildon_live_search_clean_selection_map (HILDON_LIVE_SEARCH (col->priv->livesearch));
-      }
-    }
-    g_signal_emit (selector, hildon_touch_selector_signals[CHANGED], 0, column);
-  }
-}
+  GArray *map = column->priv->visible_map;
+  GtkTreeIter filter_iter;
+  gint index;
+  guint pos, i;
 
-/**
- * default_print_func:
- * @selector: a #HildonTouchSelector
- *
- * Default print function
- *
- * Returns: a new string that represents the selected items
- *
- * Since: 2.2
- **/
-static gchar *
-_default_print_func (HildonTouchSelector * selector, gpointer user_data)
-{
-  gchar *result = NULL;
-  gchar *aux = NULL;
-  gint num_columns = 0;
-  GtkTreeIter iter;
-  GtkTreeModel *model = NULL;
-  gchar *current_string = NULL;
-  gint i;
-  HildonTouchSelectorSelectionMode mode;
-  GList *item = NULL;
-  GtkTreePath *current_path = NULL;
-  GList *selected_rows = NULL;
-  gint initial_value = 0;
-  gint text_column = -1;
-  HildonTouchSelectorColumn *column = NULL;
+  column->priv->natural_height = -1;
 
-  num_columns = hildon_touch_selector_get_num_columns (selector);
+  if (!column->priv->visible_map_valid || visible_map_is_current (column))
+    return;
 
-  mode = hildon_touch_selector_get_column_selection_mode (selector);
+  index = gtk_tree_path_get_indices (path)[0];
+  pos = visible_map_lower_bound (map, index);
 
-  if ((mode == HILDON_TOUCH_SELECTOR_SELECTION_MODE_MULTIPLE)
-      && (num_columns > 0)) {
-    /* In this case we get the first column first */
-    selected_rows = hildon_touch_selector_get_selected_rows (selector, 0);
-    model = hildon_touch_selector_get_model (selector, 0);
-    column = hildon_touch_selector_get_column (selector, 0);
-    text_column = hildon_touch_selector_column_get_text_column (column);
+  /* Appending only costs the search */
+  for (i = pos; i < map->len; i++)
+    g_array_index (map, gint, i)++;
 
-    result = g_strdup_printf ("(");
-    i = 0;
-    for (item = selected_rows; item; item = g_list_next (item)) {
-      current_path = item->data;
-      gtk_tree_model_get_iter (model, &iter, current_path);
+  if (gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (column->priv->filter),
+                                                        &filter_iter, iter))
+    g_array_insert_val (map, pos, index);
 
-      if (text_column != -1) {
-        gtk_tree_model_get (model, &iter, text_column, &current_string, -1);
-      }
+  column->priv->visible_map_n_rows++;
+}
 
-      if (i < g_list_length (selected_rows) - 1) {
-        aux = g_strconcat (result, current_string, ",", NULL);
-        g_free (result);
-        result = aux;
-      } else {
-        aux = g_strconcat (result, current_string, NULL);
-        g_free (result);
-        result = aux;
-      }
+static void
+on_model_row_deleted_update_map (GtkTreeModel *model,
+                                 GtkTreePath *path,
+                                 HildonTouchSelectorColumn *column)
+{
+  GArray *map = column->priv->visible_map;
+  gint index;
+  guint pos, i;
 
-      if (current_string) {
-        g_free (current_string);
-        current_string = NULL;
-      }
+  column->priv->natural_height = -1;
 
-      i++;
-    }
+  if (!column->priv->visible_map_valid || visible_map_is_current (column))
+    return;
 
-    aux = g_strconcat (result, ")", NULL);
-    g_free (result);
-    result = aux;
+  index = gtk_tree_path_get_indices (path)[0];
+  pos = visible_map_lower_bound (map, index);
 
-    g_list_foreach (selected_rows, (GFunc) (gtk_tree_path_free), NULL);
-    g_list_free (selected_rows);
-    initial_value = 1;
-  } else {
-    initial_value = 0;
-  }
+  if (pos < map->len && g_array_index (map, gint, pos) == index)
+    g_array_remove_index (map, pos);
 
-  for (i = initial_value; i < num_columns; i++) {
-    model = hildon_touch_selector_get_model (selector, i);
-    column = hildon_touch_selector_get_column (selector, i);
-    text_column = hildon_touch_selector_column_get_text_column (column);
+  for (i = pos; i < map->len; i++)
+    g_array_index (map, gint, i)--;
 
-    if (hildon_touch_selector_get_selected (selector, i, &iter)) {
-      if (text_column == -1 ) {
-        g_warning ("Trying to use the default print function in HildonTouchSelector, but "
-                   "\"text-column\" property is not set for HildonTouchSelectorColumn %p.", column);
-        current_string = NULL;
-      } else {
-        gtk_tree_model_get (model, &iter, text_column, &current_string, -1);
-      }
+  column->priv->visible_map_n_rows--;
+}
 
-      if (i == 0) {
-        result = current_string;
-      } else {
-        aux = g_strconcat (result, ":", current_string, NULL);
-        g_free (result);
-        g_free (current_string);
-        current_string = NULL;
-        result = aux;
-      }
-    }
+static void
+hildon_touch_selector_column_watch_filter (HildonTouchSelectorColumn *column)
+{
+  /* Rows hidden by the filter still move the child indices of the
+     visible ones, so watch the child model as well. The filter is new,
+     so the map is updated before anybody else watching the filter
+     looks at it */
+  g_signal_connect_swapped (column->priv->filter, "row-inserted",
+                            G_CALLBACK (on_filter_visibility_invalidate_map), column);
+  g_signal_connect_swapped (column->priv->filter, "row-deleted",
+                            G_CALLBACK (on_filter_visibility_invalidate_map), column);
+  g_signal_connect_swapped (column->priv->filter, "rows-reordered",
+                            G_CALLBACK (on_filter_changed_invalidate_map), column);
+  g_signal_connect_swapped (column->priv->filter, "row-changed",
+                            G_CALLBACK (on_filter_row_changed_invalidate_height), column);
+
+  if (!column->priv->unfiltered) {
+    g_signal_connect (column->priv->model, "row-inserted",
+                      G_CALLBACK (on_model_row_inserted_update_map), column);
+    g_signal_connect (column->priv->model, "row-deleted",
+                      G_CALLBACK (on_model_row_deleted_update_map), column);
+    g_signal_connect_swapped (column->priv->model, "rows-reordered",
+                              G_CALLBACK (on_filter_changed_invalidate_map), column);
   }
-
-  return result;
+  column->priv->visible_map_valid = FALSE;
 }
 
 static void
-hildon_touch_selector_row_activated_cb          (GtkTreeView       *tree_view,
-                                                 GtkTreePath       *path,
-                                                 GtkTreeViewColumn *column,
-                                                 gpointer           user_data)
+hildon_touch_selector_column_unwatch_filter (HildonTouchSelectorColumn *column)
 {
-  HildonTouchSelectorColumn *selector_column = NULL;
-  GtkTreePath *child_path;
+  GtkTreeModel *model;
 
-  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (user_data));
-  selector_column = HILDON_TOUCH_SELECTOR_COLUMN (user_data);
+  g_signal_handlers_disconnect_by_func (column->priv->filter,
+                                        on_filter_visibility_invalidate_map, column);
+  g_signal_handlers_disconnect_by_func (column->priv->filter,
+                                        on_filter_changed_invalidate_map, column);
+  g_signal_handlers_disconnect_by_func (column->priv->filter,
+                                        on_filter_row_changed_invalidate_height, column);
+  if (!column->priv->unfiltered) {
+    model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (column->priv->filter));
+    g_signal_handlers_disconnect_by_func (model, on_model_row_inserted_update_map, column);
+    g_signal_handlers_disconnect_by_func (model, on_model_row_deleted_update_map, column);
+    g_signal_handlers_disconnect_by_func (model, on_filter_changed_invalidate_map, column);
+  }
+  column->priv->visible_map_valid = FALSE;
+}
 
-  if (selector_column->priv->last_activated != NULL) {
-    gtk_tree_row_reference_free (selector_column->priv->last_activated);
+/* Returns the up to date map of @column, or %NULL if its model is not
+   a flat list or is not filtered */
+static GArray *
+hildon_touch_selector_column_get_visible_map (HildonTouchSelectorColumn *column)
+{
+  GtkTreeModelFilter *filter;
+  GtkTreeIter filter_iter, iter;
+  gboolean valid;
+
+  if (column->priv->unfiltered ||
+      !(gtk_tree_model_get_flags (column->priv->model) & GTK_TREE_MODEL_LIST_ONLY))
+    return NULL;
+
+  filter = GTK_TREE_MODEL_FILTER (column->priv->filter);
+
+  if (visible_map_is_current (column))
+    return column->priv->visible_map;
+
+  g_array_set_size (column->priv->visible_map, 0);
+
+  valid = gtk_tree_model_get_iter_first (column->priv->filter, &filter_iter);
+  while (valid) {
+    GtkTreePath *path;
+
+    gtk_tree_model_filter_convert_iter_to_child_iter (filter, &iter, &filter_iter);
+    path = gtk_tree_model_get_path (column->priv->model, &iter);
+    g_array_append_val (column->priv->visible_map, gtk_tree_path_get_indices (path)[0]);
+    gtk_tree_path_free (path);
+
+    valid = gtk_tree_model_iter_next (column->priv->filter, &filter_iter);
   }
 
-  child_path = gtk_tree_model_filter_convert_path_to_child_path (GTK_TREE_MODEL_FILTER (selector_column->priv->filter),
-                                                                 path);
-  selector_column->priv->last_activated = gtk_tree_row_reference_new (selector_column->priv->model,
-                                                                      child_path);
-  gtk_tree_path_free (child_path);
+  column->priv->visible_map_valid = TRUE;
+  column->priv->visible_map_n_rows = gtk_tree_model_iter_n_children (column->priv->model, NULL);
+
+  return column->priv->visible_map;
 }
 
-/*static void
-_row_tapped_cb (GtkTreeView * tree_view, GtkTreePath * path, gpointer user_data)
+/* Like gtk_tree_model_filter_convert_child_path_to_path() */
+static GtkTreePath *
+hildon_touch_selector_column_child_path_to_path (HildonTouchSelectorColumn *column,
+                                                 GtkTreePath *child_path)
 {
-  HildonTouchSelector *selector = NULL;
-  HildonTouchSelectorColumn *column = NULL;
-  gint num_column = -1;
+  GArray *map = NULL;
+  gint index;
+  guint pos;
 
-  column = HILDON_TOUCH_SELECTOR_COLUMN (user_data);
-  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (column->priv->parent));
+  if (column->priv->unfiltered)
+    return gtk_tree_path_copy (child_path);
 
-  selector = column->priv->parent;
+  if (gtk_tree_path_get_depth (child_path) == 1)
+    map = hildon_touch_selector_column_get_visible_map (column);
 
-  num_column = g_slist_index (selector->priv->columns, column);
+  if (map == NULL)
+    return gtk_tree_model_filter_convert_child_path_to_path (GTK_TREE_MODEL_FILTER (column->priv->filter),
+                                                             child_path);
 
-  hildon_touch_selector_emit_value_changed (selector, num_column);
-}*/
+  index = gtk_tree_path_get_indices (child_path)[0];
+  pos = visible_map_lower_bound (map, index);
 
+  if (pos < map->len && g_array_index (map, gint, pos) == index)
+    return gtk_tree_path_new_from_indices (pos, -1);
 
-static HildonTouchSelectorColumn *
-_create_new_column (HildonTouchSelector * selector,
-                    GtkTreeModel * model,
-                    gboolean *emit_changed,
-                    GtkCellRenderer * renderer, va_list args)
+  return NULL;
+}
+
+/* Like gtk_tree_model_filter_convert_path_to_child_path() */
+static GtkTreePath *
+hildon_touch_selector_column_path_to_child_path (HildonTouchSelectorColumn *column,
+                                                 GtkTreePath *path)
+{
+  GArray *map = NULL;
+  gint index;
+
+  if (column->priv->unfiltered)
+    return gtk_tree_path_copy (path);
+
+  if (gtk_tree_path_get_depth (path) == 1)
+    map = hildon_touch_selector_column_get_visible_map (column);
+
+  if (map == NULL)
+    return gtk_tree_model_filter_convert_path_to_child_path (GTK_TREE_MODEL_FILTER (column->priv->filter),
+                                                             path);
+
+  index = gtk_tree_path_get_indices (path)[0];
+  if (index < 0 || (guint) index >= map->len)
+    return NULL;
+
+  return gtk_tree_path_new_from_indices (g_array_index (map, gint, index), -1);
+}
+
+/* Like gtk_tree_model_filter_convert_iter_to_child_iter() */
+static void
+hildon_touch_selector_column_iter_to_child_iter (HildonTouchSelectorColumn *column,
+                                                 GtkTreeIter *child_iter,
+                                                 GtkTreeIter *iter)
+{
+  if (column->priv->unfiltered)
+    *child_iter = *iter;
+  else
+    gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (column->priv->filter),
+                                                      child_iter, iter);
+}
+
+/* Like gtk_tree_model_filter_convert_child_iter_to_iter() */
+static gboolean
+hildon_touch_selector_column_child_iter_to_iter (HildonTouchSelectorColumn *column,
+                                                 GtkTreeIter *iter,
+                                                 GtkTreeIter *child_iter)
+{
+  if (column->priv->unfiltered) {
+    *iter = *child_iter;
+    return TRUE;
+  }
+
+  return gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (column->priv->filter),
+                                                           iter, child_iter);
+}
+
+/*
+ * Sets the filter of @column for its current model. Virtual columns
+ * have no per-row store, and a GtkTreeModelFilter would keep state
+ * for every row, so unless @needs_filter they show their model
+ * directly until hildon_touch_selector_column_ensure_filter().
+ */
+static void
+hildon_touch_selector_column_create_filter      (HildonTouchSelectorColumn *column,
+                                                 gboolean needs_filter)
+{
+  GtkTreeModel *model = column->priv->model;
+
+  column->priv->unfiltered = !needs_filter &&
+    HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL (model);
+
+  if (column->priv->unfiltered)
+    column->priv->filter = g_object_ref (model);
+  else
+    column->priv->filter = gtk_tree_model_filter_new (model, NULL);
+
+  hildon_touch_selector_column_watch_filter (column);
+}
+
+/*
+ * Gives a real filter to a column showing its model directly. The new
+ * filter shows every row, so the selection, the cursor and the scroll
+ * position are kept as they are.
+ */
+static void
+hildon_touch_selector_column_ensure_filter      (HildonTouchSelectorColumn *column)
+{
+  GtkTreeView *tv = column->priv->tree_view;
+  GtkTreeSelection *selection = gtk_tree_view_get_selection (tv);
+  GtkAdjustment *adj = NULL;
+  GtkTreePath *cursor = NULL;
+  GList *selected = NULL, *l;
+  gdouble value = 0;
+
+  if (!column->priv->unfiltered)
+    return;
+
+  if (column->priv->attached) {
+    selected = gtk_tree_selection_get_selected_rows (selection, NULL);
+    gtk_tree_view_get_cursor (tv, &cursor, NULL);
+    adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (column->priv->panarea));
+    value = gtk_adjustment_get_value (adj);
+  }
+
+  hildon_touch_selector_column_unwatch_filter (column);
+  g_object_unref (column->priv->filter);
+  hildon_touch_selector_column_create_filter (column, TRUE);
+
+  if (column->priv->attached) {
+    gtk_tree_view_set_model (tv, column->priv->filter);
+
+    if (cursor != NULL) {
+      gtk_tree_view_set_cursor (tv, cursor, NULL, FALSE);
+      gtk_tree_path_free (cursor);
+    }
+    for (l = selected; l != NULL; l = l->next)
+      gtk_tree_selection_select_path (selection, l->data);
+    g_list_free_full (selected, (GDestroyNotify) gtk_tree_path_free);
+
+    gtk_adjustment_set_value (adj, value);
+  }
+}
+
+/*
+ * Gives the filter model to the tree view of a lazy column, and moves
+ * its pending selection to the tree view. Does nothing if the column
+ * was already attached.
+ */
+static void
+hildon_touch_selector_column_attach             (HildonTouchSelectorColumn *col)
+{
+  GtkTreePath *path, *filter_path;
+
+  if (col->priv->attached)
+    return;
+
+  col->priv->attached = TRUE;
+  gtk_tree_view_set_model (col->priv->tree_view, col->priv->filter);
+
+  if (col->priv->pending_row != NULL) {
+    path = gtk_tree_row_reference_get_path (col->priv->pending_row);
+    if (path != NULL) {
+      filter_path = hildon_touch_selector_column_child_path_to_path (col, path);
+      if (filter_path != NULL) {
+        gtk_tree_selection_select_path (gtk_tree_view_get_selection (col->priv->tree_view),
+                                        filter_path);
+        gtk_tree_path_free (filter_path);
+      }
+      gtk_tree_path_free (path);
+    }
+    gtk_tree_row_reference_free (col->priv->pending_row);
+    col->priv->pending_row = NULL;
+  }
+}
+
+/* Replaces the pending selection of a lazy column, %NULL unselects */
+static void
+hildon_touch_selector_column_set_pending        (HildonTouchSelectorColumn *col,
+                                                 GtkTreePath *path)
+{
+  if (col->priv->pending_row != NULL)
+    gtk_tree_row_reference_free (col->priv->pending_row);
+
+  col->priv->pending_row = path ?
+    gtk_tree_row_reference_new (col->priv->model, path) : NULL;
+
+  hildon_touch_selector_column_invalidate_print (col);
+}
+
+/* Returns the path of the pending selection of a lazy column, or %NULL */
+static GtkTreePath *
+hildon_touch_selector_column_get_pending        (HildonTouchSelectorColumn *col)
+{
+  if (col->priv->pending_row == NULL)
+    return NULL;
+
+  return gtk_tree_row_reference_get_path (col->priv->pending_row);
+}
+
+static void
+hildon_touch_selector_attach_columns            (HildonTouchSelector *selector)
+{
+  guint i;
+
+  for (i = 0; i < selector->priv->columns->len; i++)
+    hildon_touch_selector_column_attach (NTH_COLUMN (selector, i));
+}
+
+static void
+hildon_touch_selector_map                       (GtkWidget *widget)
+{
+  hildon_touch_selector_attach_columns (HILDON_TOUCH_SELECTOR (widget));
+
+  GTK_WIDGET_CLASS (hildon_touch_selector_parent_class)->map (widget);
+}
+
+static void
+hildon_touch_selector_hierarchy_changed         (GtkWidget *widget,
+                                                 GtkWidget *previous_toplevel)
+{
+  HildonTouchSelector *selector = HILDON_TOUCH_SELECTOR (widget);
+
+  /* The height limit was set by the previous container, if any */
+  selector->priv->height_limit = 0;
+
+  /* Fill the columns before the first size request, so that the
+     window gets the right size */
+  if (hildon_touch_selector_is_anchored (selector))
+    hildon_touch_selector_attach_columns (selector);
+
+  if (GTK_WIDGET_CLASS (hildon_touch_selector_parent_class)->hierarchy_changed)
+    GTK_WIDGET_CLASS (hildon_touch_selector_parent_class)->hierarchy_changed (widget,
+                                                                           previous_toplevel);
+}
+
+static void
+clean_column                                    (HildonTouchSelectorColumn *col,
+                                                 HildonTouchSelector *selector)
+{
+  g_signal_handlers_disconnect_by_func (col->priv->model,
+                                        on_row_changed, selector);
+  g_signal_handlers_disconnect_by_func (col->priv->model,
+                                        on_row_deleted, selector);
+  g_signal_handlers_disconnect_by_func (col->priv->model,
+                                        on_row_changed_invalidate, col);
+  g_signal_handlers_disconnect_by_func (col->priv->model,
+                                        on_rows_reordered_invalidate, col);
+  g_signal_handlers_disconnect_by_func (col->priv->model,
+                                        on_row_inserted_invalidate, col);
+
+  if (col->priv->last_activated != NULL) {
+    gtk_tree_row_reference_free (col->priv->last_activated);
+    col->priv->last_activated = NULL;
+  }
+}
+
+/*
+ * IMPLEMENTATION NOTES:
+ * Some people sent questions regarding the fact that the dispose/finalize functions
+ * doesn't clean the internal widgets that could lead to leak memory, so we will
+ * clarify this topic.
+ *
+ * This is not required as #HildonTouchSelector extends #GtkContainer. When the
+ * widget is freed, the #GtkContainer freeing memory functions are called. This
+ * process includes remove each widget individually, so all the widgets are
+ * properly freed.
+ *
+ * In the same way, this widget redefines gtk_container->remove function, in
+ * order to free the column related information if it is required.
+ *
+ * Please take a look to hildon_touch_selector_remove for more information.
+ */
+
+/*------------------------------ GtkContainer ------------------------------ */
+
+/*
+ * Required in order to free the column at the columns list
+ */
+static void
+hildon_touch_selector_remove (GtkContainer * container, GtkWidget * widget)
+{
+  HildonTouchSelector *selector = NULL;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (container));
+  selector = HILDON_TOUCH_SELECTOR (container);
+
+  /* Remove the extra data related to the columns, if required. */
+  if (widget == selector->priv->hbox) {
+    g_ptr_array_foreach (selector->priv->columns, (GFunc) clean_column, selector);
+    g_ptr_array_foreach (selector->priv->columns, (GFunc) g_object_unref, NULL);
+
+    g_ptr_array_set_size (selector->priv->columns, 0);
+  }
+
+  /* Now remove the widget itself from the container */
+  GTK_CONTAINER_CLASS (hildon_touch_selector_parent_class)->remove (container, widget);
+}
+
+/* ------------------------------ PRIVATE METHODS ---------------------------- */
+void
+hildon_touch_selector_block_changed             (HildonTouchSelector *selector)
+{
+  selector->priv->changed_blocked = TRUE;
+}
+
+void
+hildon_touch_selector_unblock_changed           (HildonTouchSelector *selector)
+{
+  selector->priv->changed_blocked = FALSE;
+}
+
+/* A column is at rest once it has neither changed nor scrolled for
+   this long, in milliseconds */
+#define SETTLE_DELAY 150
+
+/* Longest a burst of changes defers the update, in milliseconds */
+#define SETTLE_MAX_WAIT 600
+
+static gdouble
+hildon_touch_selector_settled_get_value         (HildonTouchSelector *selector)
+{
+  HildonTouchSelectorPrivate *priv = selector->priv;
+  GtkAdjustment *adj;
+
+  if (priv->settled_column < 0 || (guint) priv->settled_column >= priv->columns->len)
+    return 0;
+
+  adj = gtk_scrolled_window_get_vadjustment
+    (GTK_SCROLLED_WINDOW (NTH_COLUMN (selector, priv->settled_column)->priv->panarea));
+
+  return gtk_adjustment_get_value (adj);
+}
+
+static gboolean
+hildon_touch_selector_settled_timeout           (gpointer data)
+{
+  HildonTouchSelector *selector = data;
+  HildonTouchSelectorPrivate *priv = selector->priv;
+  gdouble value = hildon_touch_selector_settled_get_value (selector);
+  guint wait;
+
+  priv->settled_id = 0;
+
+  /* Still scrolling or in a kinetic animation, check again later */
+  if (value != priv->settled_value) {
+    priv->settled_value = value;
+    wait = hildon_settle_wait (priv->settled_first, SETTLE_DELAY, SETTLE_MAX_WAIT);
+    if (wait > 0) {
+      priv->settled_id = gdk_threads_add_timeout (wait, hildon_touch_selector_settled_timeout,
+                                                  selector);
+      return FALSE;
+    }
+  }
+
+  hildon_touch_selector_flush_settled (selector);
+
+  return FALSE;
+}
+
+/* Calls @func once @column has come to rest: when it has not been
+   changed again nor scrolled for a while. Subclasses use it to update
+   the columns which depend on @column, like the days of the month, only
+   once at the end of a burst of changes instead of at every step. The
+   update queued last replaces a different one, which is first run. */
+void
+hildon_touch_selector_queue_settled             (HildonTouchSelector            *selector,
+                                                 gint                            column,
+                                                 HildonTouchSelectorSettledFunc  func,
+                                                 gpointer                        data)
+{
+  HildonTouchSelectorPrivate *priv;
+  guint wait;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (func != NULL);
+
+  priv = selector->priv;
+
+  if (priv->settled_func != NULL &&
+      (priv->settled_func != func || priv->settled_data != data ||
+       priv->settled_column != column))
+    hildon_touch_selector_flush_settled (selector);
+
+  if (priv->settled_func == NULL) {
+    priv->settled_func = func;
+    priv->settled_data = data;
+    priv->settled_column = column;
+    priv->settled_first = g_get_monotonic_time ();
+  }
+
+  if (priv->settled_id != 0)
+    g_source_remove (priv->settled_id);
+
+  priv->settled_value = hildon_touch_selector_settled_get_value (selector);
+  wait = hildon_settle_wait (priv->settled_first, SETTLE_DELAY, SETTLE_MAX_WAIT);
+  priv->settled_id = gdk_threads_add_timeout (MAX (wait, 1), hildon_touch_selector_settled_timeout,
+                                              selector);
+}
+
+/* Runs the update queued with hildon_touch_selector_queue_settled()
+   right away, if any */
+static void
+hildon_touch_selector_flush_settled             (HildonTouchSelector *selector)
+{
+  HildonTouchSelectorPrivate *priv;
+  HildonTouchSelectorSettledFunc func;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+
+  priv = selector->priv;
+
+  if (priv->settled_id != 0) {
+    g_source_remove (priv->settled_id);
+    priv->settled_id = 0;
+  }
+
+  func = priv->settled_func;
+  priv->settled_func = NULL;
+
+  if (func != NULL)
+    func (selector, priv->settled_data);
+}
+
+void
+hildon_touch_selector_column_disable_focus      (HildonTouchSelectorColumn *col)
+{
+    g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (col));
+    gtk_widget_set_can_focus (GTK_WIDGET (col->priv->tree_view), FALSE);
+}
+
+/* Read-only label models (hours, months, years...) are the same for
+   every selector created with the same locale and range, so they are
+   built once and shared. The key must describe everything the rows
+   depend on. */
+static GHashTable *shared_models = NULL;
+
+static void
+purge_shared_models                             (gpointer data)
+{
+  /* The selectors keep their own references */
+  g_hash_table_remove_all (shared_models);
+}
+
+/*
+ * Tells @selector the most height its parent will give it, so that
+ * measuring its natural height can stop there, see
+ * hildon_touch_selector_column_get_bounded_height(). 0 means no
+ * limit. Used by #HildonPickerDialog. The limit is dropped when
+ * @selector moves to another toplevel.
+ */
+void
+hildon_touch_selector_set_height_limit          (HildonTouchSelector *selector,
+                                                 gint                 limit)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+
+  selector->priv->height_limit = MAX (limit, 0);
+}
+
+GtkTreeModel *
+hildon_touch_selector_get_shared_model          (const gchar                  *key,
+                                                 HildonTouchSelectorModelFunc  create,
+                                                 gpointer                      data)
+{
+  GtkTreeModel *model;
+
+  if (G_UNLIKELY (shared_models == NULL)) {
+    shared_models = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, g_object_unref);
+    hildon_add_purge_func (purge_shared_models, NULL);
+  }
+
+  model = g_hash_table_lookup (shared_models, key);
+  if (model == NULL) {
+    model = (* create) (data);
+    g_hash_table_insert (shared_models, g_strdup (key), model);
+  }
+
+  return g_object_ref (model);
+}
+
+static void
+hildon_touch_selector_clean_live_search_map     (HildonTouchSelector *selector)
+{
+  if (hildon_touch_selector_get_column_selection_mode (selector) == HILDON_TOUCH_SELECTOR_SELECTION_MODE_SINGLE &&
+      selector->priv->columns->len > 0) {
+    HildonTouchSelectorColumn *col;
+    col = NTH_COLUMN (selector, 0);
+    if (col->priv->livesearch) {
+      hildon_live_search_clean_selection_map (HILDON_LIVE_SEARCH (col->priv->livesearch));
+    }
+  }
+}
+
+static void
+hildon_touch_selector_column_invalidate_diff   (HildonTouchSelectorColumn *col)
+{
+  if (col->priv->diff_snapshot != NULL) {
+    g_array_free (col->priv->diff_snapshot, TRUE);
+    col->priv->diff_snapshot = NULL;
+  }
+}
+
+/* Emits "selection-diff" for @column, comparing its selection with the
+   one reported last time. Both are sorted, so they are merged once */
+static void
+hildon_touch_selector_emit_selection_diff       (HildonTouchSelector *selector,
+                                                 gint column)
+{
+  HildonTouchSelectorColumn *col;
+  GArray *old, *current, *added, *removed;
+  gint *indices;
+  gint n_indices;
+  guint i, j;
+
+  if (column < 0 || (guint) column >= selector->priv->columns->len)
+    return;
+
+  col = NTH_COLUMN (selector, column);
+
+  /* Nobody listens, don't keep a copy of the selection */
+  if (!g_signal_has_handler_pending (selector, hildon_touch_selector_signals[SELECTION_DIFF],
+                                     0, FALSE)) {
+    hildon_touch_selector_column_invalidate_diff (col);
+    return;
+  }
+
+  indices = hildon_touch_selector_get_selected_indices (selector, column, &n_indices);
+  current = g_array_sized_new (FALSE, FALSE, sizeof (gint), n_indices);
+  g_array_append_vals (current, indices, n_indices);
+  g_free (indices);
+
+  /* A handler could change the selection again */
+  old = col->priv->diff_snapshot;
+  col->priv->diff_snapshot = current;
+
+  if (old == NULL) {
+    g_signal_emit (selector, hildon_touch_selector_signals[SELECTION_DIFF], 0,
+                   column, NULL, NULL);
+    return;
+  }
+
+  added = g_array_new (FALSE, FALSE, sizeof (gint));
+  removed = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  for (i = 0, j = 0; i < old->len || j < current->len;) {
+    if (j == current->len ||
+        (i < old->len && g_array_index (old, gint, i) < g_array_index (current, gint, j))) {
+      g_array_append_val (removed, g_array_index (old, gint, i));
+      i++;
+    } else if (i == old->len ||
+               g_array_index (current, gint, j) < g_array_index (old, gint, i)) {
+      g_array_append_val (added, g_array_index (current, gint, j));
+      j++;
+    } else {
+      i++;
+      j++;
+    }
+  }
+
+  g_array_free (old, TRUE);
+
+  if (added->len > 0 || removed->len > 0) {
+    g_signal_emit (selector, hildon_touch_selector_signals[SELECTION_DIFF], 0,
+                   column, added, removed);
+  }
+
+  g_array_free (added, TRUE);
+  g_array_free (removed, TRUE);
+}
+
+static void
+hildon_touch_selector_emit_value_changed        (HildonTouchSelector *selector,
+                                                 gint column)
+{
+  /* FIXME: it could be good to emit too the GtkTreePath of the element
+     selected, as now it is required to connect to the signal and then ask
+     for the element selected. We can't do this API change, in order to avoid
+     and ABI break */
+  HILDON_PROBE2 (touch_selector__value__changed, selector, column);
+
+  if (!selector->priv->changed_blocked) {
+    if (selector->priv->changed_freeze_count > 0) {
+      /* Just remember the column, hildon_touch_selector_thaw_changed()
+         will emit once for it */
+      if (column >= 0 && column < 64)
+        selector->priv->changed_dirty |= G_GUINT64_CONSTANT (1) << column;
+      else
+        selector->priv->changed_dirty_high = TRUE;
+      return;
+    }
+    hildon_touch_selector_clean_live_search_map (selector);
+    HILDON_PERF (TOUCH_SELECTOR_CHANGED);
+    HILDON_WATCH_ENTER ("touch-selector-changed");
+    hildon_touch_selector_emit_selection_diff (selector, column);
+    g_signal_emit (selector, hildon_touch_selector_signals[CHANGED], 0, column);
+    HILDON_WATCH_LEAVE ("touch-selector-changed");
+  }
+}
+
+static void
+hildon_touch_selector_column_invalidate_print  (HildonTouchSelectorColumn *col)
+{
+  col->priv->print_valid = FALSE;
+  g_free (col->priv->print_text);
+  col->priv->print_text = NULL;
+}
+
+static void
+on_selection_changed_invalidate                 (GtkTreeSelection *selection,
+                                                 gpointer userdata)
+{
+  hildon_touch_selector_column_invalidate_print (HILDON_TOUCH_SELECTOR_COLUMN (userdata));
+}
+
+/*
+ * Prints the selected rows of the first column in multiple selection
+ * mode, as "(A,B,C)". With a summary limit, the walk stops at the last
+ * row printed, and the rest are only counted if there are rows left.
+ */
+static gchar *
+hildon_touch_selector_print_multiple           (HildonTouchSelector *selector,
+                                                HildonTouchSelectorColumn *column)
+{
+  GtkTreeSelection *selection;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  GString *result;
+  gint text_column;
+  gint limit;
+  gint n_printed = 0;
+  gboolean valid;
+
+  hildon_touch_selector_column_attach (column);
+
+  selection = gtk_tree_view_get_selection (column->priv->tree_view);
+  model = column->priv->filter;
+  text_column = hildon_touch_selector_column_get_text_column (column);
+  limit = selector->priv->summary_limit;
+
+  result = g_string_new ("(");
+
+  valid = gtk_tree_model_get_iter_first (model, &iter);
+  while (valid && (limit == 0 || n_printed < limit)) {
+    if (gtk_tree_selection_iter_is_selected (selection, &iter)) {
+      gchar *current_string = NULL;
+
+      if (text_column != -1) {
+        gtk_tree_model_get (model, &iter, text_column, &current_string, -1);
+      }
+
+      n_printed++;
+
+      if (current_string) {
+        if (result->len > 1)
+          g_string_append_c (result, ',');
+        g_string_append (result, current_string);
+        g_free (current_string);
+      }
+    }
+    valid = gtk_tree_model_iter_next (model, &iter);
+  }
+
+  if (valid) {
+    gint n_more = gtk_tree_selection_count_selected_rows (selection) - n_printed;
+
+    if (n_more > 0)
+      g_string_append_printf (result,
+                              dngettext ("hildon-libs", " and %d more", " and %d more", n_more),
+                              n_more);
+  }
+
+  g_string_append_c (result, ')');
+
+  return g_string_free (result, FALSE);
+}
+
+/*
+ * Returns the cached fragment of the default print function output for
+ * the column @i, computing it if it was invalidated. Returns FALSE if
+ * the column has nothing selected.
+ */
+static gboolean
+hildon_touch_selector_get_print_fragment       (HildonTouchSelector *selector,
+                                                gint i,
+                                                gboolean multiple,
+                                                const gchar **text)
+{
+  HildonTouchSelectorColumn *column;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  gint text_column;
+
+  column = NTH_COLUMN (selector, i);
+
+  if (!column->priv->print_valid) {
+    column->priv->print_text = NULL;
+
+    if (multiple) {
+      column->priv->print_selected = TRUE;
+      column->priv->print_text = hildon_touch_selector_print_multiple (selector, column);
+    } else {
+      column->priv->print_selected = hildon_touch_selector_get_selected (selector, i, &iter);
+
+      if (column->priv->print_selected) {
+        model = hildon_touch_selector_get_model (selector, i);
+        text_column = hildon_touch_selector_column_get_text_column (column);
+
+        if (text_column == -1 ) {
+          g_warning ("Trying to use the default print function in HildonTouchSelector, but "
+                     "\"text-column\" property is not set for HildonTouchSelectorColumn %p.", column);
+        } else {
+          gtk_tree_model_get (model, &iter, text_column, &column->priv->print_text, -1);
+        }
+      }
+    }
+
+    column->priv->print_valid = TRUE;
+  }
+
+  *text = column->priv->print_text;
+
+  return column->priv->print_selected;
+}
+
+/**
+ * default_print_func:
+ * @selector: a #HildonTouchSelector
+ *
+ * Default print function. The text of each column is cached until its
+ * selection or its selected row changes, so the cost of a selection
+ * change is proportional to the columns that actually changed.
+ *
+ * Returns: a new string that represents the selected items
+ *
+ * Since: 2.2
+ **/
+static gchar *
+_default_print_func (HildonTouchSelector * selector, gpointer user_data)
+{
+  gchar *result = NULL;
+  gchar *aux = NULL;
+  const gchar *fragment;
+  gint num_columns = 0;
+  gint i;
+  gint initial_value = 0;
+  HildonTouchSelectorSelectionMode mode;
+
+  num_columns = hildon_touch_selector_get_num_columns (selector);
+
+  mode = hildon_touch_selector_get_column_selection_mode (selector);
+
+  if ((mode == HILDON_TOUCH_SELECTOR_SELECTION_MODE_MULTIPLE)
+      && (num_columns > 0)) {
+    /* In this case we get the first column first */
+    hildon_touch_selector_get_print_fragment (selector, 0, TRUE, &fragment);
+    result = g_strdup (fragment);
+    initial_value = 1;
+  } else {
+    initial_value = 0;
+  }
+
+  for (i = initial_value; i < num_columns; i++) {
+    if (hildon_touch_selector_get_print_fragment (selector, i, FALSE, &fragment)) {
+      if (i == 0) {
+        result = g_strdup (fragment);
+      } else {
+        aux = g_strconcat (result, ":", fragment, NULL);
+        g_free (result);
+        result = aux;
+      }
+    }
+  }
+
+  return result;
+}
+
+static void
+hildon_touch_selector_row_activated_cb          (GtkTreeView       *tree_view,
+                                                 GtkTreePath       *path,
+                                                 GtkTreeViewColumn *column,
+                                                 gpointer           user_data)
+{
+  HildonTouchSelectorColumn *selector_column = NULL;
+  GtkTreePath *child_path;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (user_data));
+  selector_column = HILDON_TOUCH_SELECTOR_COLUMN (user_data);
+
+  if (selector_column->priv->last_activated != NULL) {
+    gtk_tree_row_reference_free (selector_column->priv->last_activated);
+  }
+
+  child_path = hildon_touch_selector_column_path_to_child_path (selector_column, path);
+  selector_column->priv->last_activated = gtk_tree_row_reference_new (selector_column->priv->model,
+                                                                      child_path);
+  gtk_tree_path_free (child_path);
+}
+
+/*static void
+_row_tapped_cb (GtkTreeView * tree_view, GtkTreePath * path, gpointer user_data)
+{
+  HildonTouchSelector *selector = NULL;
+  HildonTouchSelectorColumn *column = NULL;
+  gint num_column = -1;
+
+  column = HILDON_TOUCH_SELECTOR_COLUMN (user_data);
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (column->priv->parent));
+
+  selector = column->priv->parent;
+
+  num_column = hildon_touch_selector_column_index (selector, column);
+
+  hildon_touch_selector_emit_value_changed (selector, num_column);
+}*/
+
+
+static HildonTouchSelectorColumn *
+_create_new_column (HildonTouchSelector * selector,
+                    GtkTreeModel * model,
+                    gboolean *emit_changed,
+                    GtkCellRenderer * renderer, va_list args)
 {
   HildonTouchSelectorColumn *new_column = NULL;
   GtkTreeViewColumn *tree_column = NULL;
@@ -810,249 +1812,1145 @@ _create_new_column (HildonTouchSelector * selector,
   gchar *attribute;
   gint value;
 
-  tree_column = gtk_tree_view_column_new ();
+  tree_column = gtk_tree_view_column_new ();
+
+  if (renderer != NULL) {
+    gtk_tree_view_column_pack_start (tree_column, renderer, TRUE);
+
+    attribute = va_arg (args, gchar *);
+    while (attribute != NULL) {
+      value = va_arg (args, gint);
+      gtk_tree_view_column_add_attribute (tree_column, renderer, attribute,
+                                          value);
+      attribute = va_arg (args, gchar *);
+    }
+  }
+
+  tv = GTK_TREE_VIEW (gtk_tree_view_new ());
+
+  gtk_tree_view_set_enable_search (tv, FALSE);
+  gtk_tree_view_set_headers_visible (tv, FALSE);
+
+  new_column = g_object_new (HILDON_TYPE_TOUCH_SELECTOR_COLUMN, NULL);
+  new_column->priv->parent = selector;
+
+  /* The cached normalized text must be dropped before the filter
+     evaluates the changed row, so connect before creating it */
+  g_signal_connect (model, "row-changed",
+                    G_CALLBACK (on_row_changed_invalidate), new_column);
+  g_signal_connect (model, "rows-reordered",
+                    G_CALLBACK (on_rows_reordered_invalidate), new_column);
+  g_signal_connect (model, "row-inserted",
+                    G_CALLBACK (on_row_inserted_invalidate), new_column);
+
+  new_column->priv->model = g_object_ref (model);
+  hildon_touch_selector_column_create_filter (new_column,
+                                              selector->priv->has_live_search);
+  filter = new_column->priv->filter;
+  new_column->priv->attached = !selector->priv->lazy_columns ||
+    hildon_touch_selector_is_anchored (selector);
+  if (new_column->priv->attached)
+    gtk_tree_view_set_model (tv, filter);
+  g_signal_connect (model, "row-changed",
+                    G_CALLBACK (on_row_changed), selector);
+  g_signal_connect_after (model, "row-deleted",
+                          G_CALLBACK (on_row_deleted), selector);
+  //gtk_tree_view_set_rules_hint (tv, TRUE); > This is now theme defined.
+
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tv), tree_column);
+
+  //panarea = hildon_pannable_area_new ();
+  panarea = gtk_scrolled_window_new (NULL, NULL);
+
+  gtk_container_add (GTK_CONTAINER (panarea), GTK_WIDGET (tv));
+
+  new_column->priv->tree_view = tv;
+  new_column->priv->panarea = panarea;
+  new_column->priv->livesearch = NULL;
+
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (tv));
+  gtk_tree_selection_set_mode (selection, GTK_SELECTION_BROWSE);
+  g_signal_connect_object (selection, "changed",
+                           G_CALLBACK (on_selection_changed_invalidate),
+                           new_column, 0);
+
+  /* select the first item */
+  *emit_changed = FALSE;
+  if (gtk_tree_model_get_iter_first (filter, &iter))
+  {
+    if (new_column->priv->attached) {
+      gtk_tree_selection_select_iter (selection, &iter);
+    } else {
+      GtkTreePath *first = gtk_tree_path_new_first ();
+      hildon_touch_selector_column_set_pending (new_column, first);
+      gtk_tree_path_free (first);
+    }
+    *emit_changed = TRUE;
+  }
+
+  /* connect to the hildon-row-tapped signal connection */
+//  g_signal_connect (G_OBJECT (tv), "hildon-row-tapped",
+//                    G_CALLBACK (_row_tapped_cb), new_column);
+
+  g_signal_connect (G_OBJECT (tv), "row-activated",
+                    G_CALLBACK (hildon_touch_selector_row_activated_cb), new_column);
+  g_signal_connect_object (G_OBJECT (tv), "style-updated",
+                           G_CALLBACK (on_tree_view_style_updated), new_column, 0);
+
+  return new_column;
+}
+
+
+/* ------------------------ HildonTouchSelectorColumn implementation ---------------------- */
+G_DEFINE_TYPE_WITH_CODE (HildonTouchSelectorColumn, hildon_touch_selector_column, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_CELL_LAYOUT,
+                                                hildon_touch_selector_column_cell_layout_init))
+
+enum
+{
+  PROP_TEXT_COLUMN = 1,
+  PROP_FIXED_HEIGHT_ROWS,
+  PROP_VISIBLE_ROWS,
+  PROP_CACHE_LAYOUTS
+};
+
+static void
+hildon_touch_selector_column_class_init (HildonTouchSelectorColumnClass *klass);
+
+static void
+hildon_touch_selector_column_get_property (GObject *object, guint property_id,
+                                           GValue *value, GParamSpec *pspec);
+
+static void
+hildon_touch_selector_column_set_property  (GObject *object, guint property_id,
+                                            const GValue *value, GParamSpec *pspec);
+
+static void
+hildon_touch_selector_column_dispose       (GObject *object);
+
+static void
+hildon_touch_selector_column_finalize      (GObject *object);
+
+static void
+hildon_touch_selector_column_class_init (HildonTouchSelectorColumnClass *klass)
+{
+  GObjectClass *gobject_class = NULL;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+
+  g_type_class_add_private (gobject_class, sizeof (HildonTouchSelectorColumnPrivate));
+
+  /* GObject */
+  gobject_class->get_property = hildon_touch_selector_column_get_property;
+  gobject_class->set_property = hildon_touch_selector_column_set_property;
+  gobject_class->dispose      = hildon_touch_selector_column_dispose;
+  gobject_class->finalize     = hildon_touch_selector_column_finalize;
+
+  /**
+   * HildonTouchSelectorColumn:text-column:
+   *
+   * A column in the data source model to get the strings from.
+   *
+   * Since: maemo 2.2
+   **/
+  g_object_class_install_property (G_OBJECT_CLASS(klass),
+                                   PROP_TEXT_COLUMN,
+                                   g_param_spec_int ("text-column",
+                                                     "Text Column",
+                                                     "A column in the data source model to get the strings from.",
+                                                     -1,
+                                                     G_MAXINT,
+                                                     -1,
+                                                     G_PARAM_READWRITE));
+
+  /**
+   * HildonTouchSelectorColumn:fixed-height-rows:
+   *
+   * Whether all the rows of the column have the same height. This
+   * lets the column compute the row positions arithmetically instead
+   * of measuring every row of the model.
+   *
+   * Since: 3.0
+   **/
+  g_object_class_install_property (G_OBJECT_CLASS(klass),
+                                   PROP_FIXED_HEIGHT_ROWS,
+                                   g_param_spec_boolean ("fixed-height-rows",
+                                                         "Fixed height rows",
+                                                         "Whether all the rows have the same height",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonTouchSelectorColumn:visible-rows:
+   *
+   * The number of rows of the model shown by the column, counting from
+   * the first one, or -1 to show all of them.
+   *
+   * Since: 3.0
+   **/
+  g_object_class_install_property (G_OBJECT_CLASS(klass),
+                                   PROP_VISIBLE_ROWS,
+                                   g_param_spec_int ("visible-rows",
+                                                     "Visible rows",
+                                                     "The number of rows shown from the top of the model, or -1 for all",
+                                                     -1,
+                                                     G_MAXINT,
+                                                     -1,
+                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * HildonTouchSelectorColumn:cache-layouts:
+   *
+   * Whether the text cells of the column keep the layouts of the
+   * strings they have drawn, so that panning does not shape the same
+   * strings again on every frame.
+   *
+   * Since: 3.0
+   **/
+  g_object_class_install_property (G_OBJECT_CLASS(klass),
+                                   PROP_CACHE_LAYOUTS,
+                                   g_param_spec_boolean ("cache-layouts",
+                                                         "Cache layouts",
+                                                         "Whether the text cells keep the layouts of their strings",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+hildon_touch_selector_column_init (HildonTouchSelectorColumn *column)
+{
+  column->priv = G_TYPE_INSTANCE_GET_PRIVATE (column, HILDON_TYPE_TOUCH_SELECTOR_COLUMN,
+                                              HildonTouchSelectorColumnPrivate);
+  column->priv->text_column = -1;
+  column->priv->last_activated = NULL;
+  column->priv->allocate_handler = 0;
+  column->priv->initial_path = NULL;
+  column->priv->norm_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                    NULL, g_free);
+  column->priv->print_valid = FALSE;
+  column->priv->print_selected = FALSE;
+  column->priv->print_text = NULL;
+  column->priv->fixed_height_rows = FALSE;
+  column->priv->row_height = 0;
+  column->priv->visible_rows = -1;
+  column->priv->row_filter = NULL;
+  column->priv->row_filter_data = NULL;
+  column->priv->visible_func_set = FALSE;
+  column->priv->attached = TRUE;
+  column->priv->pending_row = NULL;
+  column->priv->visible_map = g_array_new (FALSE, FALSE, sizeof (gint));
+  column->priv->visible_map_valid = FALSE;
+  column->priv->visible_map_n_rows = 0;
+  column->priv->natural_height = -1;
+  column->priv->natural_height_limit = 0;
+}
+
+/*
+ * Returns the text of the row pointed by @iter, normalized with
+ * hildon_helper_normalize_string(). For models with persistent iters
+ * the result is cached per row, so that refiltering does not have to
+ * fetch, convert and free the text of every row on every keystroke.
+ * Otherwise, the string is returned in @to_free and must be freed.
+ */
+static const gchar *
+hildon_touch_selector_column_get_normalized    (HildonTouchSelectorColumn *col,
+                                                GtkTreeModel *model,
+                                                GtkTreeIter *iter,
+                                                gchar **to_free)
+{
+  gpointer cached;
+  const gchar *string;
+  gchar *string_copy, *string_ascii;
+  gboolean cacheable;
+
+  *to_free = NULL;
+
+  cacheable = (gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_ITERS_PERSIST) != 0;
+
+  if (cacheable &&
+      g_hash_table_lookup_extended (col->priv->norm_cache, iter->user_data,
+                                    NULL, &cached))
+    return cached;
+
+  string = hildon_tree_model_peek_string (model, iter, col->priv->text_column, &string_copy);
+  string_ascii = string ? hildon_helper_normalize_string (string) : NULL;
+  g_free (string_copy);
+
+  if (cacheable)
+    g_hash_table_insert (col->priv->norm_cache, iter->user_data, string_ascii);
+  else
+    *to_free = string_ascii;
+
+  return string_ascii;
+}
+
+static void
+hildon_touch_selector_column_clear_normalized  (HildonTouchSelectorColumn *col)
+{
+  g_hash_table_remove_all (col->priv->norm_cache);
+}
+
+static gboolean
+hildon_live_search_visible_func (GtkTreeModel *model,
+                                 GtkTreeIter *iter,
+                                 gchar *prefix,
+                                 gpointer userdata)
+{
+  gboolean visible;
+  const gchar *string_ascii;
+  gchar *to_free;
+  HildonTouchSelectorColumn *col;
+  HildonTouchSelector *selector;
+
+  col = HILDON_TOUCH_SELECTOR_COLUMN (userdata);
+  selector = col->priv->parent;
+
+  if (selector->priv->query == NULL ||
+      hildon_helper_query_is_empty (selector->priv->query))
+    return TRUE;
+
+  string_ascii = hildon_touch_selector_column_get_normalized (col, model, iter, &to_free);
+  visible = (string_ascii != NULL &&
+             hildon_helper_query_match (selector->priv->query, string_ascii));
+
+  g_free (to_free);
+
+  return visible;
+}
+
+static gboolean
+on_live_search_refilter (HildonLiveSearch *livesearch,
+                         gpointer userdata)
+{
+    HildonTouchSelector *selector = HILDON_TOUCH_SELECTOR (userdata);
+
+    if (selector->priv->query != NULL)
+        hildon_helper_query_free (selector->priv->query);
+
+    selector->priv->query = hildon_helper_query_new (hildon_live_search_get_text (livesearch),
+                                                     FALSE);
+
+    return FALSE;
+}
+
+/**
+ * hildon_touch_selector_column_set_text_column:
+ * @column: A #HildonTouchSelectorColumn
+ * @text_column: the index of a model column in the model for @column.
+ *
+ * Sets the model column to be displayed in @column. @text_column must point to a
+ * column in the model used with type %G_TYPE_STRING. Initially, this property
+ * is unset. You should set it before using the #HildonTouchSelector that uses
+ * @column.
+ *
+ * Since: 2.2
+ **/
+void
+hildon_touch_selector_column_set_text_column (HildonTouchSelectorColumn *column,
+                                              gint text_column)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column));
+  g_return_if_fail (text_column >= -1);
+
+  column->priv->text_column = text_column;
+  hildon_touch_selector_column_clear_normalized (column);
+  hildon_touch_selector_column_invalidate_print (column);
+
+  if (column->priv->livesearch) {
+    hildon_live_search_set_visible_func (HILDON_LIVE_SEARCH (column->priv->livesearch),
+                                         hildon_live_search_visible_func,
+                                         column,
+                                         NULL);
+  }
+
+  g_object_notify (G_OBJECT (column), "text-column");
+}
+
+/**
+ * hildon_touch_selector_column_get_text_column:
+ * @column: a #HildonTouchSelectorColumn
+ *
+ * Gets the model column set as the text source for @column.
+ *
+ * Returns: the index of the text column for @column, or -1 if unset.
+ *
+ * Since: 2.2
+ **/
+gint
+hildon_touch_selector_column_get_text_column (HildonTouchSelectorColumn *column)
+{
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column), -1);
+
+  return column->priv->text_column;
+}
+
+/**
+ * hildon_touch_selector_column_set_fixed_height_rows:
+ * @column: a #HildonTouchSelectorColumn
+ * @fixed_height_rows: whether all the rows of @column have the same height
+ *
+ * Tells @column that all its rows have the same height, as it is the
+ * case for single line text rows. The height of one row is then used
+ * for the whole column, so that scrolling to a row and computing the
+ * size of the column do not need to measure every row of the model.
+ * This is recommended for columns with many rows.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_column_set_fixed_height_rows (HildonTouchSelectorColumn *column,
+                                                    gboolean fixed_height_rows)
+{
+  GList *tree_columns, *iter;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column));
+
+  fixed_height_rows = fixed_height_rows ? TRUE : FALSE;
+  if (column->priv->fixed_height_rows == fixed_height_rows)
+    return;
+
+  column->priv->fixed_height_rows = fixed_height_rows;
+  column->priv->row_height = 0;
+
+  if (column->priv->tree_view != NULL) {
+    /* Fixed height mode requires all the columns to be fixed-sized */
+    if (fixed_height_rows) {
+      tree_columns = gtk_tree_view_get_columns (column->priv->tree_view);
+      for (iter = tree_columns; iter; iter = iter->next) {
+        gtk_tree_view_column_set_sizing (GTK_TREE_VIEW_COLUMN (iter->data),
+                                         GTK_TREE_VIEW_COLUMN_FIXED);
+      }
+      g_list_free (tree_columns);
+    }
+    gtk_tree_view_set_fixed_height_mode (column->priv->tree_view,
+                                         fixed_height_rows);
+  }
+
+  g_object_notify (G_OBJECT (column), "fixed-height-rows");
+}
+
+/**
+ * hildon_touch_selector_column_get_fixed_height_rows:
+ * @column: a #HildonTouchSelectorColumn
+ *
+ * Gets whether @column assumes that all its rows have the same height.
+ * See hildon_touch_selector_column_set_fixed_height_rows().
+ *
+ * Returns: %TRUE if the rows of @column have a fixed height
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_touch_selector_column_get_fixed_height_rows (HildonTouchSelectorColumn *column)
+{
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column), FALSE);
+
+  return column->priv->fixed_height_rows;
+}
+
+static gboolean
+hildon_touch_selector_column_visible_func      (GtkTreeModel *model,
+                                                GtkTreeIter  *iter,
+                                                gpointer      data)
+{
+  HildonTouchSelectorColumn *column = HILDON_TOUCH_SELECTOR_COLUMN (data);
+  GtkTreePath *path;
+  gboolean visible;
+
+  if (column->priv->row_filter != NULL &&
+      !column->priv->row_filter (model, iter, column->priv->row_filter_data))
+    return FALSE;
+
+  if (column->priv->visible_rows < 0)
+    return TRUE;
+
+  path = gtk_tree_model_get_path (model, iter);
+  visible = gtk_tree_path_get_indices (path)[0] < column->priv->visible_rows;
+  gtk_tree_path_free (path);
+
+  return visible;
+}
+
+static gboolean
+hildon_touch_selector_column_install_visible_func (HildonTouchSelectorColumn *column)
+{
+  if (!column->priv->visible_func_set && column->priv->filter != NULL) {
+    /* The filter only takes one visible function */
+    g_return_val_if_fail (column->priv->livesearch == NULL, FALSE);
+
+    hildon_touch_selector_column_ensure_filter (column);
+    gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (column->priv->filter),
+                                            hildon_touch_selector_column_visible_func,
+                                            column, NULL);
+    column->priv->visible_func_set = TRUE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * hildon_touch_selector_column_set_visible_rows:
+ * @column: a #HildonTouchSelectorColumn
+ * @visible_rows: the number of rows to show, or -1 to show all of them
+ *
+ * Shows only the first @visible_rows rows of the model of @column. The
+ * other rows are kept in the model, so changing the limit does not
+ * modify the model, and the selection is kept unless the selected row
+ * gets hidden. This is useful for columns whose valid values depend on
+ * another column, like the days of a month.
+ *
+ * This can't be used in columns with live search.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_column_set_visible_rows  (HildonTouchSelectorColumn *column,
+                                                gint visible_rows)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column));
+  g_return_if_fail (visible_rows >= -1);
+
+  if (column->priv->visible_rows == visible_rows)
+    return;
+
+  if (!hildon_touch_selector_column_install_visible_func (column))
+    return;
+
+  column->priv->visible_rows = visible_rows;
+  column->priv->print_valid = FALSE;
+
+  /* Only the rows whose visibility changes are added or removed */
+  if (column->priv->filter != NULL)
+    gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (column->priv->filter));
+
+  g_object_notify (G_OBJECT (column), "visible-rows");
+}
+
+/*
+ * Hides the rows for which @func returns %FALSE, on top of the
+ * HildonTouchSelectorColumn:visible-rows limit, and refilters @col.
+ * Pass %NULL to show all the rows again.
+ */
+void
+hildon_touch_selector_column_set_row_filter    (HildonTouchSelectorColumn *col,
+                                                GtkTreeModelFilterVisibleFunc func,
+                                                gpointer data)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (col));
+
+  if (func == NULL && col->priv->row_filter == NULL)
+    return;
 
-  if (renderer != NULL) {
-    gtk_tree_view_column_pack_start (tree_column, renderer, TRUE);
+  if (!hildon_touch_selector_column_install_visible_func (col))
+    return;
 
-    attribute = va_arg (args, gchar *);
-    while (attribute != NULL) {
-      value = va_arg (args, gint);
-      gtk_tree_view_column_add_attribute (tree_column, renderer, attribute,
-                                          value);
-      attribute = va_arg (args, gchar *);
-    }
-  }
+  col->priv->row_filter = func;
+  col->priv->row_filter_data = data;
+  col->priv->print_valid = FALSE;
 
-  tv = GTK_TREE_VIEW (gtk_tree_view_new ());
+  if (col->priv->filter != NULL)
+    gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (col->priv->filter));
+}
 
-  gtk_tree_view_set_enable_search (tv, FALSE);
-  gtk_tree_view_set_headers_visible (tv, FALSE);
+/**
+ * hildon_touch_selector_column_get_visible_rows:
+ * @column: a #HildonTouchSelectorColumn
+ *
+ * Gets the number of rows shown by @column. See
+ * hildon_touch_selector_column_set_visible_rows().
+ *
+ * Returns: the number of rows shown, or -1 if all the rows are shown
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_touch_selector_column_get_visible_rows  (HildonTouchSelectorColumn *column)
+{
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column), -1);
 
-  filter = gtk_tree_model_filter_new (model, NULL);
-  gtk_tree_view_set_model (tv, filter);
-  g_signal_connect (model, "row-changed",
-                    G_CALLBACK (on_row_changed), selector);
-  g_signal_connect_after (model, "row-deleted",
-                          G_CALLBACK (on_row_deleted), selector);
-  //gtk_tree_view_set_rules_hint (tv, TRUE); > This is now theme defined.
+  return column->priv->visible_rows;
+}
 
-  gtk_tree_view_append_column (GTK_TREE_VIEW (tv), tree_column);
+/*
+ * The text cell of hildon_touch_selector_append_text_column(). While
+ * the layout cache of its column is enabled it keeps the layouts of
+ * the last strings it drew, least recently used first out, so panning
+ * back and forth over the same rows only draws already shaped text.
+ * The layouts are looked up by string, so a row whose text changes
+ * simply gets a new one; all of them are dropped when the font or the
+ * Pango context of the tree view change. Cells with markup, attributes
+ * or any text style of their own are drawn by #GtkCellRendererText.
+ */
+#define HILDON_TOUCH_SELECTOR_LAYOUT_CACHE_SIZE 64
 
-  new_column = g_object_new (HILDON_TYPE_TOUCH_SELECTOR_COLUMN, NULL);
-  new_column->priv->parent = selector;
+typedef struct
+{
+  GtkCellRendererText parent;
 
-  //panarea = hildon_pannable_area_new ();
-  panarea = gtk_scrolled_window_new (NULL, NULL);
+  gboolean cache_layouts;
+  GHashTable *layouts;          /* text -> link in lru */
+  GQueue lru;                   /* PangoLayout, most recently used first */
+  guint serial;                 /* of the Pango context the layouts are for */
+} HildonTouchSelectorTextCell;
 
-  gtk_container_add (GTK_CONTAINER (panarea), GTK_WIDGET (tv));
+typedef GtkCellRendererTextClass HildonTouchSelectorTextCellClass;
 
-  new_column->priv->model = g_object_ref (model);
-  new_column->priv->tree_view = tv;
-  new_column->priv->panarea = panarea;
-  new_column->priv->filter = filter;
-  new_column->priv->livesearch = NULL;
+static GType hildon_touch_selector_text_cell_get_type (void);
 
-  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (tv));
-  gtk_tree_selection_set_mode (selection, GTK_SELECTION_BROWSE);
+G_DEFINE_TYPE (HildonTouchSelectorTextCell, hildon_touch_selector_text_cell, GTK_TYPE_CELL_RENDERER_TEXT)
 
-  /* select the first item */
-  *emit_changed = FALSE;
-  if (gtk_tree_model_get_iter_first (filter, &iter))
-  {
-    gtk_tree_selection_select_iter (selection, &iter);
-    *emit_changed = TRUE;
+#define HILDON_TOUCH_SELECTOR_TEXT_CELL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), hildon_touch_selector_text_cell_get_type (), HildonTouchSelectorTextCell))
+
+#define HILDON_IS_TOUCH_SELECTOR_TEXT_CELL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), hildon_touch_selector_text_cell_get_type ()))
+
+static void
+hildon_touch_selector_text_cell_flush (HildonTouchSelectorTextCell *cell)
+{
+  g_hash_table_remove_all (cell->layouts);
+  g_queue_foreach (&cell->lru, (GFunc) g_object_unref, NULL);
+  g_queue_clear (&cell->lru);
+}
+
+static PangoLayout *
+hildon_touch_selector_text_cell_get_layout (HildonTouchSelectorTextCell *cell,
+                                            GtkWidget                   *widget,
+                                            const gchar                 *text)
+{
+  PangoLayout *layout;
+  GList *link;
+  guint serial = pango_context_get_serial (gtk_widget_get_pango_context (widget));
+
+  if (serial != cell->serial) {
+    hildon_touch_selector_text_cell_flush (cell);
+    cell->serial = serial;
   }
 
-  /* connect to the hildon-row-tapped signal connection */
-//  g_signal_connect (G_OBJECT (tv), "hildon-row-tapped",
-//                    G_CALLBACK (_row_tapped_cb), new_column);
+  link = g_hash_table_lookup (cell->layouts, text);
+  if (link != NULL) {
+    g_queue_unlink (&cell->lru, link);
+    g_queue_push_head_link (&cell->lru, link);
+    return link->data;
+  }
 
-  g_signal_connect (G_OBJECT (tv), "row-activated",
-                    G_CALLBACK (hildon_touch_selector_row_activated_cb), new_column);
+  if (cell->lru.length >= HILDON_TOUCH_SELECTOR_LAYOUT_CACHE_SIZE) {
+    PangoLayout *old = g_queue_pop_tail (&cell->lru);
 
-  return new_column;
-}
+    g_hash_table_remove (cell->layouts, pango_layout_get_text (old));
+    g_object_unref (old);
+  }
 
+  layout = gtk_widget_create_pango_layout (widget, text);
+  g_queue_push_head (&cell->lru, layout);
+  /* The layout owns the copy of the text used as key */
+  g_hash_table_insert (cell->layouts, (gpointer) pango_layout_get_text (layout), cell->lru.head);
 
-/* ------------------------ HildonTouchSelectorColumn implementation ---------------------- */
-G_DEFINE_TYPE_WITH_CODE (HildonTouchSelectorColumn, hildon_touch_selector_column, G_TYPE_OBJECT,
-                         G_IMPLEMENT_INTERFACE (GTK_TYPE_CELL_LAYOUT,
-                                                hildon_touch_selector_column_cell_layout_init))
+  return layout;
+}
 
-enum
+/* Whether @renderer draws its text with nothing but the font of the
+   widget, which is all the cached layouts know about */
+static gboolean
+hildon_touch_selector_text_cell_is_plain (GtkCellRenderer *renderer)
 {
-  PROP_TEXT_COLUMN = 1
-};
+  gboolean family_set, style_set, variant_set, weight_set, stretch_set;
+  gboolean size_set, scale_set, foreground_set, background_set;
+  gboolean ellipsize_set, strikethrough_set, underline_set, rise_set;
+  gboolean language_set, align_set, single_paragraph;
+  PangoAttrList *attributes;
+  gint wrap_width;
+
+  g_object_get (renderer,
+                "attributes", &attributes,
+                "family-set", &family_set,
+                "style-set", &style_set,
+                "variant-set", &variant_set,
+                "weight-set", &weight_set,
+                "stretch-set", &stretch_set,
+                "size-set", &size_set,
+                "scale-set", &scale_set,
+                "foreground-set", &foreground_set,
+                "background-set", &background_set,
+                "ellipsize-set", &ellipsize_set,
+                "strikethrough-set", &strikethrough_set,
+                "underline-set", &underline_set,
+                "rise-set", &rise_set,
+                "language-set", &language_set,
+                "align-set", &align_set,
+                "single-paragraph-mode", &single_paragraph,
+                "wrap-width", &wrap_width,
+                NULL);
 
-static void
-hildon_touch_selector_column_class_init (HildonTouchSelectorColumnClass *klass);
+  /* Markup is kept as attributes too */
+  if (attributes != NULL) {
+    pango_attr_list_unref (attributes);
+    return FALSE;
+  }
+
+  return !(family_set || style_set || variant_set || weight_set ||
+           stretch_set || size_set || scale_set || foreground_set ||
+           background_set || ellipsize_set || strikethrough_set ||
+           underline_set || rise_set || language_set || align_set ||
+           single_paragraph || wrap_width != -1);
+}
 
 static void
-hildon_touch_selector_column_get_property (GObject *object, guint property_id,
-                                           GValue *value, GParamSpec *pspec);
+hildon_touch_selector_text_cell_render (GtkCellRenderer      *renderer,
+                                        cairo_t              *cr,
+                                        GtkWidget            *widget,
+                                        const GdkRectangle   *background_area,
+                                        const GdkRectangle   *cell_area,
+                                        GtkCellRendererState  flags)
+{
+  HildonTouchSelectorTextCell *cell = HILDON_TOUCH_SELECTOR_TEXT_CELL (renderer);
+  GtkStyleContext *context;
+  PangoLayout *layout;
+  PangoRectangle logical;
+  gchar *text = NULL;
+  gfloat xalign, yalign;
+  gint xpad, ypad, x, y;
+
+  /* Styled cells are drawn as usual */
+  if (cell->cache_layouts && hildon_touch_selector_text_cell_is_plain (renderer))
+    g_object_get (renderer, "text", &text, NULL);
+
+  if (text == NULL) {
+    GTK_CELL_RENDERER_CLASS (hildon_touch_selector_text_cell_parent_class)->render
+      (renderer, cr, widget, background_area, cell_area, flags);
+    return;
+  }
+
+  layout = hildon_touch_selector_text_cell_get_layout (cell, widget, text);
+  g_free (text);
+
+  gtk_cell_renderer_get_alignment (renderer, &xalign, &yalign);
+  gtk_cell_renderer_get_padding (renderer, &xpad, &ypad);
+  if (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
+    xalign = 1.0 - xalign;
+
+  pango_layout_get_pixel_extents (layout, NULL, &logical);
+  x = cell_area->x + xpad + xalign * (cell_area->width - 2 * xpad - logical.width) - logical.x;
+  y = cell_area->y + ypad + yalign * (cell_area->height - 2 * ypad - logical.height) - logical.y;
+
+  context = gtk_widget_get_style_context (widget);
+  gtk_style_context_save (context);
+  gtk_style_context_set_state (context, gtk_cell_renderer_get_state (renderer, widget, flags));
+
+  cairo_save (cr);
+  gdk_cairo_rectangle (cr, cell_area);
+  cairo_clip (cr);
+  gtk_render_layout (context, cr, x, y, layout);
+  cairo_restore (cr);
+
+  gtk_style_context_restore (context);
+}
 
 static void
-hildon_touch_selector_column_set_property  (GObject *object, guint property_id,
-                                            const GValue *value, GParamSpec *pspec);
+hildon_touch_selector_text_cell_finalize (GObject *object)
+{
+  HildonTouchSelectorTextCell *cell = HILDON_TOUCH_SELECTOR_TEXT_CELL (object);
+
+  hildon_touch_selector_text_cell_flush (cell);
+  g_hash_table_destroy (cell->layouts);
+
+  G_OBJECT_CLASS (hildon_touch_selector_text_cell_parent_class)->finalize (object);
+}
 
 static void
-hildon_touch_selector_column_dispose       (GObject *object);
+hildon_touch_selector_text_cell_class_init (HildonTouchSelectorTextCellClass *klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = hildon_touch_selector_text_cell_finalize;
+  GTK_CELL_RENDERER_CLASS (klass)->render = hildon_touch_selector_text_cell_render;
+}
 
 static void
-hildon_touch_selector_column_finalize      (GObject *object);
+hildon_touch_selector_text_cell_init (HildonTouchSelectorTextCell *cell)
+{
+  cell->layouts = g_hash_table_new (g_str_hash, g_str_equal);
+  g_queue_init (&cell->lru);
+}
 
 static void
-hildon_touch_selector_column_class_init (HildonTouchSelectorColumnClass *klass)
+hildon_touch_selector_column_update_text_cells (HildonTouchSelectorColumn *column)
 {
-  GObjectClass *gobject_class = NULL;
+  GList *cells, *iter;
 
-  gobject_class = G_OBJECT_CLASS (klass);
+  cells = gtk_cell_layout_get_cells (GTK_CELL_LAYOUT (column));
+  for (iter = cells; iter; iter = iter->next) {
+    if (HILDON_IS_TOUCH_SELECTOR_TEXT_CELL (iter->data)) {
+      HildonTouchSelectorTextCell *cell = iter->data;
 
-  g_type_class_add_private (gobject_class, sizeof (HildonTouchSelectorColumnPrivate));
+      cell->cache_layouts = column->priv->cache_layouts;
+      if (!cell->cache_layouts)
+        hildon_touch_selector_text_cell_flush (cell);
+    }
+  }
+  g_list_free (cells);
+}
 
-  /* GObject */
-  gobject_class->get_property = hildon_touch_selector_column_get_property;
-  gobject_class->set_property = hildon_touch_selector_column_set_property;
-  gobject_class->dispose      = hildon_touch_selector_column_dispose;
-  gobject_class->finalize     = hildon_touch_selector_column_finalize;
+/**
+ * hildon_touch_selector_column_set_cache_layouts:
+ * @column: a #HildonTouchSelectorColumn
+ * @cache_layouts: whether the text cells keep the layouts of their strings
+ *
+ * Makes the text cell of a column created with
+ * hildon_touch_selector_append_text_column() keep the shaped layouts
+ * of the last strings it has drawn. Panning over rows that were
+ * already shown then only draws them, instead of shaping their text
+ * again on every frame. This is worth it for columns whose rows are
+ * plain text that rarely changes. Columns with other cell renderers
+ * are not affected.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_column_set_cache_layouts (HildonTouchSelectorColumn *column,
+                                                gboolean                   cache_layouts)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column));
 
-  /**
-   * HildonTouchSelectorColumn:text-column:
-   *
-   * A column in the data source model to get the strings from.
-   *
-   * Since: maemo 2.2
-   **/
-  g_object_class_install_property (G_OBJECT_CLASS(klass),
-                                   PROP_TEXT_COLUMN,
-                                   g_param_spec_int ("text-column",
-                                                     "Text Column",
-                                                     "A column in the data source model to get the strings from.",
-                                                     -1,
-                                                     G_MAXINT,
-                                                     -1,
-                                                     G_PARAM_READWRITE));
+  cache_layouts = cache_layouts ? TRUE : FALSE;
+  if (column->priv->cache_layouts == cache_layouts)
+    return;
+
+  column->priv->cache_layouts = cache_layouts;
+  hildon_touch_selector_column_update_text_cells (column);
+
+  g_object_notify (G_OBJECT (column), "cache-layouts");
+}
+
+/**
+ * hildon_touch_selector_column_get_cache_layouts:
+ * @column: a #HildonTouchSelectorColumn
+ *
+ * Gets whether the text cells of @column keep the layouts of their
+ * strings. See hildon_touch_selector_column_set_cache_layouts().
+ *
+ * Returns: %TRUE if the layouts are cached
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_touch_selector_column_get_cache_layouts (HildonTouchSelectorColumn *column)
+{
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column), FALSE);
+
+  return column->priv->cache_layouts;
+}
+
+/*
+ * Returns the height of a row of @col, measured once on its first row
+ * and cached, or 0 if @col does not have fixed height rows or the
+ * height can't be known yet.
+ */
+static gint
+hildon_touch_selector_column_get_row_height    (HildonTouchSelectorColumn *col)
+{
+  GtkTreeViewColumn *tree_column;
+  GtkTreeIter iter;
+  gint height = 0;
+  gint separator = 0;
+
+  if (!col->priv->fixed_height_rows)
+    return 0;
+
+  if (col->priv->row_height > 0)
+    return col->priv->row_height;
+
+  tree_column = gtk_tree_view_get_column (col->priv->tree_view, 0);
+  if (tree_column == NULL ||
+      !gtk_tree_model_get_iter_first (col->priv->filter, &iter))
+    return 0;
+
+  gtk_tree_view_column_cell_set_cell_data (tree_column, col->priv->filter,
+                                           &iter, FALSE, FALSE);
+  gtk_tree_view_column_cell_get_size (tree_column, NULL, NULL, NULL,
+                                      NULL, &height);
+  if (height <= 0)
+    return 0;
+
+  gtk_widget_style_get (GTK_WIDGET (col->priv->tree_view),
+                        "vertical-separator", &separator, NULL);
+
+  col->priv->row_height = height + separator;
+
+  return col->priv->row_height;
 }
 
 static void
-hildon_touch_selector_column_init (HildonTouchSelectorColumn *column)
+on_tree_view_style_updated                      (GtkWidget *widget,
+                                                 gpointer userdata)
 {
-  column->priv = G_TYPE_INSTANCE_GET_PRIVATE (column, HILDON_TYPE_TOUCH_SELECTOR_COLUMN,
-                                              HildonTouchSelectorColumnPrivate);
-  column->priv->text_column = -1;
-  column->priv->last_activated = NULL;
-  column->priv->realize_handler = 0;
-  column->priv->initial_path = NULL;
+  /* Fonts or paddings may have changed */
+  HILDON_TOUCH_SELECTOR_COLUMN (userdata)->priv->row_height = 0;
+  HILDON_TOUCH_SELECTOR_COLUMN (userdata)->priv->natural_height = -1;
 }
 
-static gboolean
-hildon_live_search_visible_func (GtkTreeModel *model,
-                                 GtkTreeIter *iter,
-                                 gchar *prefix,
-                                 gpointer userdata)
+/* Rows measured before the height of the rest is estimated from them */
+#define HEIGHT_SAMPLE_ROWS 64
+
+/*
+ * Returns the natural height of @col when no more than @limit pixels
+ * of it can be shown. Rows are measured from the top until they fill
+ * @limit, so a long model costs at most HEIGHT_SAMPLE_ROWS rows: past
+ * that, the height is estimated from the rows measured. The result is
+ * cached until the model or the style changes.
+ */
+static gint
+hildon_touch_selector_column_get_bounded_height (HildonTouchSelectorColumn *col,
+                                                 gint                       limit)
 {
-  gboolean visible = TRUE;
-  gchar *string, *string_ascii;
-  GSList *list_iter;
-  HildonTouchSelectorColumn *col;
-  HildonTouchSelector *selector;
+  GList *tree_columns, *l;
+  GtkTreeIter iter;
+  gboolean valid;
+  gint separator = 0;
+  gint n_rows, measured = 0;
+  gint height = 0;
 
-  col = HILDON_TOUCH_SELECTOR_COLUMN (userdata);
-  selector = col->priv->parent;
-  gint text_column = GPOINTER_TO_INT (col->priv->text_column);
+  if (col->priv->natural_height >= 0 && col->priv->natural_height_limit == limit)
+    return col->priv->natural_height;
+
+  gtk_widget_style_get (GTK_WIDGET (col->priv->tree_view),
+                        "vertical-separator", &separator, NULL);
+  tree_columns = gtk_tree_view_get_columns (col->priv->tree_view);
+  n_rows = gtk_tree_model_iter_n_children (col->priv->filter, NULL);
+
+  valid = gtk_tree_model_get_iter_first (col->priv->filter, &iter);
+  while (valid && height < limit && measured < HEIGHT_SAMPLE_ROWS) {
+    gint row_height = 0;
+
+    for (l = tree_columns; l; l = l->next) {
+      GtkTreeViewColumn *tree_column = GTK_TREE_VIEW_COLUMN (l->data);
+      gint cell_height = 0;
 
-  gtk_tree_model_get (model, iter, text_column, &string, -1);
-  string_ascii = hildon_helper_normalize_string (string);
-  list_iter = selector->priv->norm_tokens;
-  while (visible && list_iter) {
-    visible = (string_ascii != NULL &&
-               hildon_helper_smart_match (string_ascii,
-                                          (const gchar *)list_iter->data));
-    list_iter = list_iter->next;
+      if (!gtk_tree_view_column_get_visible (tree_column))
+        continue;
+
+      gtk_tree_view_column_cell_set_cell_data (tree_column, col->priv->filter,
+                                               &iter, FALSE, FALSE);
+      gtk_tree_view_column_cell_get_size (tree_column, NULL, NULL, NULL,
+                                          NULL, &cell_height);
+      row_height = MAX (row_height, cell_height);
+    }
+
+    height += row_height + separator;
+    measured++;
+    valid = gtk_tree_model_iter_next (col->priv->filter, &iter);
   }
 
-  g_free (string);
-  g_free (string_ascii);
+  g_list_free (tree_columns);
 
-  return visible;
+  /* Not every row fitted in the sample, guess the rest */
+  if (valid && height < limit)
+    height = MIN (limit, (gint) ((gint64) height * n_rows / measured));
+
+  col->priv->natural_height = height;
+  col->priv->natural_height_limit = limit;
+
+  return height;
 }
 
+/* The models the text helpers know how to fill */
 static gboolean
-on_live_search_refilter (HildonLiveSearch *livesearch,
-                         gpointer userdata)
+is_text_store (GtkTreeModel *model)
 {
-    HildonTouchSelector *selector = HILDON_TOUCH_SELECTOR (userdata);
+  return GTK_IS_LIST_STORE (model) || HILDON_IS_TOUCH_SELECTOR_STRING_STORE (model);
+}
+
+static void
+text_store_insert (GtkTreeModel *model,
+                   gint text_column,
+                   gint position,
+                   const gchar *text)
+{
+  if (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (model)) {
+    hildon_touch_selector_string_store_insert (HILDON_TOUCH_SELECTOR_STRING_STORE (model),
+                                               position, text);
+  } else {
+    gtk_list_store_insert_with_values (GTK_LIST_STORE (model), NULL, position,
+                                       text_column, text, -1);
+  }
+}
 
-    gchar **tokens = g_strsplit (hildon_live_search_get_text (livesearch), " ", -1);
-    gchar *token;
-    gint i;
+static void
+text_store_append_array (GtkTreeModel *model,
+                         gint text_column,
+                         const gchar * const *texts,
+                         gint n_texts)
+{
+  gint i;
 
-    if (selector->priv->norm_tokens != NULL) {
-        g_slist_foreach (selector->priv->norm_tokens, (GFunc) g_free, NULL);
-        g_slist_free (selector->priv->norm_tokens);
-        selector->priv->norm_tokens = NULL;
-    }
+  if (HILDON_IS_TOUCH_SELECTOR_STRING_STORE (model)) {
+    hildon_touch_selector_string_store_append_array (HILDON_TOUCH_SELECTOR_STRING_STORE (model),
+                                                     texts, n_texts);
+    return;
+  }
 
-    for (i = 0; tokens [i] != NULL; i++) {
-        token = hildon_helper_normalize_string (tokens[i]);
-        if (token != NULL)
-            selector->priv->norm_tokens = g_slist_prepend (selector->priv->norm_tokens,
-                                                           token);
-    }
+  for (i = 0; i < n_texts; i++) {
+    gtk_list_store_insert_with_values (GTK_LIST_STORE (model), NULL, G_MAXINT,
+                                       text_column, texts[i], -1);
+  }
+}
 
-    g_strfreev (tokens);
+/* Frees @path, a path of the filter of @column, and returns a reference
+   to its row in the model, or %NULL if it has none */
+static gpointer
+text_store_track_path (HildonTouchSelectorColumn *column,
+                       GtkTreePath *path)
+{
+  GtkTreeRowReference *ref = NULL;
+  GtkTreePath *child_path;
 
-    return FALSE;
+  child_path = hildon_touch_selector_column_path_to_child_path (column, path);
+  if (child_path != NULL) {
+    ref = gtk_tree_row_reference_new (column->priv->model, child_path);
+    gtk_tree_path_free (child_path);
+  }
+  gtk_tree_path_free (path);
+
+  return ref;
+}
+
+/* Frees @ref, taken by text_store_track_path(), and returns the path
+   its row has now in the filter of @column, or %NULL if it is gone */
+static gpointer
+text_store_tracked_path (HildonTouchSelectorColumn *column,
+                         GtkTreeRowReference *ref)
+{
+  GtkTreePath *child_path, *path = NULL;
+
+  if (ref == NULL)
+    return NULL;
+
+  child_path = gtk_tree_row_reference_get_path (ref);
+  if (child_path != NULL) {
+    path = hildon_touch_selector_column_child_path_to_path (column, child_path);
+    gtk_tree_path_free (child_path);
+  }
+  gtk_tree_row_reference_free (ref);
+
+  return path;
 }
 
 /**
- * hildon_touch_selector_column_set_text_column:
- * @column: A #HildonTouchSelectorColumn
- * @text_column: the index of a model column in the model for @column.
- *
- * Sets the model column to be displayed in @column. @text_column must point to a
- * column in the model used with type %G_TYPE_STRING. Initially, this property
- * is unset. You should set it before using the #HildonTouchSelector that uses
- * @column.
- *
- * Since: 2.2
+ * hildon_touch_selector_column_append_text_array:
+ * @column: a #HildonTouchSelectorColumn whose model is a #GtkListStore,
+ * or the model of a selector created with
+ * hildon_touch_selector_new_text_compact() or
+ * hildon_touch_selector_new_text_sorted()
+ * @texts: an array of non %NULL text strings
+ * @n_texts: the number of strings in @texts, or -1 if @texts is
+ * %NULL-terminated
+ *
+ * Appends a row for each string in @texts to the model of @column,
+ * setting them in its #HildonTouchSelectorColumn:text-column.
+ *
+ * This is much faster than appending rows one by one while the
+ * column is displayed: the tree view of @column is detached from its
+ * model while the rows are added, so it is only updated once. The
+ * current selection, the cursor and the scroll position are kept, and
+ * no #HildonTouchSelector::changed signal is emitted. In a sorted
+ * selector the selection and the cursor stay on the same rows, even
+ * though the new rows move them.
+ *
+ * Since: 3.0
  **/
 void
-hildon_touch_selector_column_set_text_column (HildonTouchSelectorColumn *column,
-                                              gint text_column)
+hildon_touch_selector_column_append_text_array (HildonTouchSelectorColumn *column,
+                                                const gchar * const *texts,
+                                                gint n_texts)
 {
+  HildonTouchSelectorPrivate *selector_priv;
+  GtkTreeSelection *selection;
+  GList *selected, *iter;
+  GtkTreeModel *store;
+  GtkTreePath *cursor;
+  GtkTreeRowReference *cursor_ref = NULL;
+  GtkAdjustment *adj;
+  gboolean was_blocked;
+  gboolean sorted;
+  gint text_column;
+  gdouble value;
+
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column));
-  g_return_if_fail (text_column >= -1);
+  g_return_if_fail (is_text_store (column->priv->model));
+  g_return_if_fail (column->priv->text_column >= 0);
+  g_return_if_fail (texts != NULL);
+
+  if (n_texts < 0)
+    n_texts = g_strv_length ((gchar **) texts);
+
+  if (n_texts == 0)
+    return;
+
+  store = column->priv->model;
+  text_column = column->priv->text_column;
+  selector_priv = column->priv->parent->priv;
+
+  if (!column->priv->attached) {
+    /* The tree view does not see the model yet, nothing to protect */
+    text_store_append_array (store, text_column, texts, n_texts);
+    return;
+  }
 
-  column->priv->text_column = text_column;
+  /* Unsetting the model drops the selection, the cursor and the scroll
+     position of the tree view, so keep them to put them back */
+  selection = gtk_tree_view_get_selection (column->priv->tree_view);
+  selected = gtk_tree_selection_get_selected_rows (selection, NULL);
+  gtk_tree_view_get_cursor (column->priv->tree_view, &cursor, NULL);
+  adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (column->priv->panarea));
+  value = gtk_adjustment_get_value (adj);
+
+  /* A sorted store merges the new rows in between the old ones, so
+     follow the saved rows in the store itself */
+  sorted = HILDON_IS_TOUCH_SELECTOR_STRING_STORE (store) &&
+    hildon_touch_selector_string_store_get_sorted (HILDON_TOUCH_SELECTOR_STRING_STORE (store));
+  if (sorted) {
+    for (iter = selected; iter != NULL; iter = iter->next)
+      iter->data = text_store_track_path (column, iter->data);
+    if (cursor != NULL)
+      cursor_ref = text_store_track_path (column, cursor);
+    cursor = NULL;
+  }
 
-  if (column->priv->livesearch) {
-    hildon_live_search_set_visible_func (HILDON_LIVE_SEARCH (column->priv->livesearch),
-                                         hildon_live_search_visible_func,
-                                         column,
-                                         NULL);
+  was_blocked = selector_priv->changed_blocked;
+  selector_priv->changed_blocked = TRUE;
+
+  /* The filter keeps listening to the store, but the tree view does not
+     have to process every single row */
+  gtk_tree_view_set_model (column->priv->tree_view, NULL);
+
+  text_store_append_array (store, text_column, texts, n_texts);
+
+  gtk_tree_view_set_model (column->priv->tree_view, column->priv->filter);
+
+  if (sorted) {
+    for (iter = selected; iter != NULL; iter = iter->next)
+      iter->data = text_store_tracked_path (column, iter->data);
+    cursor = text_store_tracked_path (column, cursor_ref);
   }
 
-  g_object_notify (G_OBJECT (column), "text-column");
-}
+  /* In an unsorted store the new rows are at the end, so the saved
+     paths are still valid. The cursor goes first, since moving it can
+     select its row */
+  if (cursor != NULL) {
+    gtk_tree_view_set_cursor (column->priv->tree_view, cursor, NULL, FALSE);
+    gtk_tree_path_free (cursor);
+    gtk_tree_selection_unselect_all (selection);
+  }
 
-/**
- * hildon_touch_selector_column_get_text_column:
- * @column: a #HildonTouchSelectorColumn
- *
- * Gets the model column set as the text source for @column.
- *
- * Returns: the index of the text column for @column, or -1 if unset.
- *
- * Since: 2.2
- **/
-gint
-hildon_touch_selector_column_get_text_column (HildonTouchSelectorColumn *column)
-{
-  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column), -1);
+  for (iter = selected; iter != NULL; iter = iter->next) {
+    if (iter->data == NULL)
+      continue;
+    gtk_tree_selection_select_path (selection, iter->data);
+    gtk_tree_path_free (iter->data);
+  }
+  g_list_free (selected);
 
-  return column->priv->text_column;
+  gtk_adjustment_set_value (adj, value);
+
+  selector_priv->changed_blocked = was_blocked;
 }
 
 static void
@@ -1064,6 +2962,18 @@ hildon_touch_selector_column_get_property (GObject *object, guint property_id,
     g_value_set_int (value,
                      hildon_touch_selector_column_get_text_column (HILDON_TOUCH_SELECTOR_COLUMN (object)));
     break;
+  case PROP_FIXED_HEIGHT_ROWS:
+    g_value_set_boolean (value,
+                         hildon_touch_selector_column_get_fixed_height_rows (HILDON_TOUCH_SELECTOR_COLUMN (object)));
+    break;
+  case PROP_VISIBLE_ROWS:
+    g_value_set_int (value,
+                     hildon_touch_selector_column_get_visible_rows (HILDON_TOUCH_SELECTOR_COLUMN (object)));
+    break;
+  case PROP_CACHE_LAYOUTS:
+    g_value_set_boolean (value,
+                         hildon_touch_selector_column_get_cache_layouts (HILDON_TOUCH_SELECTOR_COLUMN (object)));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -1078,6 +2988,18 @@ hildon_touch_selector_column_set_property (GObject *object, guint property_id,
     hildon_touch_selector_column_set_text_column (HILDON_TOUCH_SELECTOR_COLUMN (object),
                                                   g_value_get_int (value));
     break;
+  case PROP_FIXED_HEIGHT_ROWS:
+    hildon_touch_selector_column_set_fixed_height_rows (HILDON_TOUCH_SELECTOR_COLUMN (object),
+                                                        g_value_get_boolean (value));
+    break;
+  case PROP_VISIBLE_ROWS:
+    hildon_touch_selector_column_set_visible_rows (HILDON_TOUCH_SELECTOR_COLUMN (object),
+                                                   g_value_get_int (value));
+    break;
+  case PROP_CACHE_LAYOUTS:
+    hildon_touch_selector_column_set_cache_layouts (HILDON_TOUCH_SELECTOR_COLUMN (object),
+                                                    g_value_get_boolean (value));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -1095,6 +3017,7 @@ hildon_touch_selector_column_dispose      (GObject *object)
   }
 
   if (priv->filter != NULL) {
+      hildon_touch_selector_column_unwatch_filter (HILDON_TOUCH_SELECTOR_COLUMN (object));
       g_object_unref (priv->filter);
       priv->filter = NULL;
   }
@@ -1111,6 +3034,18 @@ hildon_touch_selector_column_finalize     (GObject *object)
     gtk_tree_path_free (priv->initial_path);
   }
 
+  g_hash_table_destroy (priv->norm_cache);
+  g_free (priv->print_text);
+
+  if (priv->pending_row) {
+    gtk_tree_row_reference_free (priv->pending_row);
+  }
+
+  g_array_free (priv->visible_map, TRUE);
+
+  if (priv->diff_snapshot != NULL)
+    g_array_free (priv->diff_snapshot, TRUE);
+
   G_OBJECT_CLASS (hildon_touch_selector_column_parent_class)->finalize (object);
 }
 
@@ -1302,6 +3237,78 @@ hildon_touch_selector_new_text (void)
   return selector;
 }
 
+/**
+ * hildon_touch_selector_new_text_compact:
+ *
+ * Creates a #HildonTouchSelector with a single text column, like
+ * hildon_touch_selector_new_text(), whose model stores all the texts
+ * packed together in a single block of memory. This uses much less
+ * memory than the #GtkListStore of hildon_touch_selector_new_text()
+ * for columns with many rows, and makes the live search faster.
+ *
+ * The column can only be filled through hildon_touch_selector_append_text(),
+ * hildon_touch_selector_append_text_array(), hildon_touch_selector_prepend_text()
+ * and hildon_touch_selector_insert_text(). Its model is not a #GtkListStore,
+ * and rows cannot be changed or removed once added.
+ *
+ * Returns: A new #HildonTouchSelector
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_touch_selector_new_text_compact (void)
+{
+  GtkWidget *selector;
+  GtkTreeModel *store;
+
+  selector = hildon_touch_selector_new ();
+  store = hildon_touch_selector_string_store_new ();
+
+  hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
+                                            store, TRUE);
+
+  g_object_unref (store);
+
+  return selector;
+}
+
+/**
+ * hildon_touch_selector_new_text_sorted:
+ *
+ * Creates a #HildonTouchSelector like hildon_touch_selector_new_text_compact(),
+ * whose column keeps its texts sorted for the current locale, as by
+ * g_utf8_collate(). The collation key of each text is computed only once,
+ * when it is added, so this is much faster than sorting the model of
+ * hildon_touch_selector_new_text() with a #GtkTreeModelSort, and the
+ * live search shows its matches in the same order.
+ *
+ * Texts are always added at their sorted position: the position given
+ * to hildon_touch_selector_insert_text() and
+ * hildon_touch_selector_prepend_text() is ignored. Adding many texts
+ * at once with hildon_touch_selector_append_text_array() sorts them
+ * only once.
+ *
+ * Returns: A new #HildonTouchSelector
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_touch_selector_new_text_sorted (void)
+{
+  GtkWidget *selector;
+  GtkTreeModel *store;
+
+  selector = hildon_touch_selector_new ();
+  store = hildon_touch_selector_string_store_new_sorted ();
+
+  hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
+                                            store, TRUE);
+
+  g_object_unref (store);
+
+  return selector;
+}
+
 /**
  * hildon_touch_selector_append_text:
  * @selector: A #HildonTouchSelector.
@@ -1323,10 +3330,40 @@ hildon_touch_selector_append_text (HildonTouchSelector * selector,
 
   model = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (selector), 0);
 
-  g_return_if_fail (GTK_IS_LIST_STORE (model));
+  g_return_if_fail (is_text_store (model));
+
+  text_store_insert (model, 0, G_MAXINT, text);
+}
+
+/**
+ * hildon_touch_selector_append_text_array:
+ * @selector: A #HildonTouchSelector.
+ * @texts: an array of non %NULL text strings.
+ * @n_texts: the number of strings in @texts, or -1 if @texts is
+ * %NULL-terminated.
+ *
+ * Appends several entries at once in a #HildonTouchSelector created
+ * with hildon_touch_selector_new_text(). This is much faster than
+ * calling hildon_touch_selector_append_text() for each of them. See
+ * hildon_touch_selector_column_append_text_array().
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_append_text_array (HildonTouchSelector * selector,
+                                         const gchar * const * texts,
+                                         gint n_texts)
+{
+  HildonTouchSelectorColumn *column;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (texts != NULL);
+
+  column = hildon_touch_selector_get_column (selector, 0);
+
+  g_return_if_fail (column != NULL);
 
-  gtk_list_store_insert_with_values (GTK_LIST_STORE (model),
-                                     NULL, G_MAXINT, 0, text, -1);
+  hildon_touch_selector_column_append_text_array (column, texts, n_texts);
 }
 
 /**
@@ -1350,10 +3387,9 @@ hildon_touch_selector_prepend_text (HildonTouchSelector * selector,
 
   model = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (selector), 0);
 
-  g_return_if_fail (GTK_IS_LIST_STORE (model));
+  g_return_if_fail (is_text_store (model));
 
-  gtk_list_store_insert_with_values (GTK_LIST_STORE (model),
-                                     NULL, 0, 0, text, -1);
+  text_store_insert (model, 0, 0, text);
 }
 
 /**
@@ -1379,19 +3415,21 @@ hildon_touch_selector_insert_text (HildonTouchSelector * selector,
 
   model = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (selector), 0);
 
-  g_return_if_fail (GTK_IS_LIST_STORE (model));
+  g_return_if_fail (is_text_store (model));
 
-  gtk_list_store_insert_with_values (GTK_LIST_STORE (model),
-                                     NULL, position, 0, text, -1);
+  text_store_insert (model, 0, position, text);
 }
 
 static void
 hildon_touch_selector_add_live_search (HildonTouchSelector *selector,
                                        HildonTouchSelectorColumn *column)
 {
-  if (column->priv->livesearch == NULL) {
+  /* A column showing only some of its rows already owns the visible
+     function of its filter */
+  if (column->priv->livesearch == NULL && !column->priv->visible_func_set) {
     gint text_column;
 
+    hildon_touch_selector_column_ensure_filter (column);
     column->priv->livesearch = hildon_live_search_new ();
     hildon_live_search_set_filter (HILDON_LIVE_SEARCH (column->priv->livesearch),
                                    GTK_TREE_MODEL_FILTER (column->priv->filter));
@@ -1419,10 +3457,10 @@ hildon_touch_selector_remove_live_search (HildonTouchSelector *selector)
   HildonTouchSelectorColumn *col;
 
   if (selector->priv->has_live_search == FALSE ||
-      selector->priv->columns == NULL)
+      selector->priv->columns->len == 0)
     return;
 
-  col = (HildonTouchSelectorColumn *) selector->priv->columns->data;
+  col = NTH_COLUMN (selector, 0);
 
   if (col->priv->livesearch != NULL) {
     hildon_live_search_widget_unhook (HILDON_LIVE_SEARCH (col->priv->livesearch));
@@ -1495,13 +3533,11 @@ hildon_touch_selector_append_column (HildonTouchSelector * selector,
 
     /* If we already have one column, disable live search */
     if (selector->priv->has_live_search &&
-        selector->priv->columns != NULL &&
-        selector->priv->columns->next == NULL) {
+        selector->priv->columns->len == 1) {
 	    hildon_touch_selector_remove_live_search (selector);
     }
 
-    selector->priv->columns = g_slist_append (selector->priv->columns,
-                                              new_column);
+    g_ptr_array_add (selector->priv->columns, new_column);
 
     new_column->priv->vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
     gtk_box_pack_start (GTK_BOX (new_column->priv->vbox),
@@ -1530,7 +3566,7 @@ hildon_touch_selector_append_column (HildonTouchSelector * selector,
 
   g_signal_emit (selector, hildon_touch_selector_signals[COLUMNS_CHANGED], 0);
   if (emit_changed) {
-    colnum = g_slist_length (selector->priv->columns);
+    colnum = selector->priv->columns->len;
     hildon_touch_selector_emit_value_changed (selector, colnum);
   }
   return new_column;
@@ -1564,7 +3600,7 @@ hildon_touch_selector_append_text_column (HildonTouchSelector * selector,
   g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), NULL);
   g_return_val_if_fail (GTK_IS_TREE_MODEL (model), NULL);
 
-  renderer = gtk_cell_renderer_text_new ();
+  renderer = g_object_new (hildon_touch_selector_text_cell_get_type (), NULL);
 
   g_object_set (renderer,
                 "width", 1,
@@ -1578,6 +3614,355 @@ hildon_touch_selector_append_text_column (HildonTouchSelector * selector,
   return column;
 }
 
+/**
+ * HildonTouchSelectorRowFunc:
+ * @row: the index of a row
+ * @user_data: the data passed to hildon_touch_selector_append_virtual_column()
+ *
+ * Gets the text of a row of a virtual column.
+ *
+ * Returns: a newly allocated string.
+ *
+ * Since: 3.0
+ **/
+
+/**
+ * hildon_touch_selector_append_virtual_column:
+ * @selector: a #HildonTouchSelector
+ * @n_rows: the number of rows of the column
+ * @func: a #HildonTouchSelectorRowFunc giving the text of each row
+ * @user_data: data to pass to @func
+ * @destroy: destroy notifier for @user_data, or %NULL
+ * @center: whether to center the text on the column
+ *
+ * Adds a text column whose rows are not stored anywhere. Only the
+ * row count is kept, and @func is called to get the text of a row
+ * when it is displayed, so that columns with a huge number of items
+ * can be created instantly and without using memory for every item.
+ * All the rows have the same height.
+ *
+ * The model of the column is a list model with a single string
+ * column, whose iters persist, so filtering, live search and
+ * selection work as usual, using the row indices. The tree view
+ * showing the column still keeps a few bytes for every row, and
+ * live search adds a filter model that keeps some more.
+ *
+ * Use hildon_touch_selector_set_virtual_n_rows() to add or remove
+ * rows at the end of the column later.
+ *
+ * Returns: the new column added, %NULL otherwise.
+ *
+ * Since: 3.0
+ **/
+HildonTouchSelectorColumn *
+hildon_touch_selector_append_virtual_column (HildonTouchSelector * selector,
+                                             gint n_rows,
+                                             HildonTouchSelectorRowFunc func,
+                                             gpointer user_data,
+                                             GDestroyNotify destroy,
+                                             gboolean center)
+{
+  GtkTreeModel *model;
+  HildonTouchSelectorColumn *column;
+
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), NULL);
+  g_return_val_if_fail (n_rows >= 0, NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  model = hildon_touch_selector_virtual_model_new (n_rows, func, user_data, destroy);
+  column = hildon_touch_selector_append_text_column (selector, model, center);
+  g_object_unref (model);
+
+  /* Do not measure every row, only the visible ones are ever read */
+  hildon_touch_selector_column_set_fixed_height_rows (column, TRUE);
+
+  return column;
+}
+
+/**
+ * hildon_touch_selector_set_virtual_n_rows:
+ * @selector: a #HildonTouchSelector
+ * @column: the position of a column added with
+ * hildon_touch_selector_append_virtual_column()
+ * @n_rows: the new number of rows
+ *
+ * Changes the number of rows of a virtual column. Rows are added or
+ * removed at the end of the column.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_set_virtual_n_rows (HildonTouchSelector * selector,
+                                          gint column,
+                                          gint n_rows)
+{
+  GtkTreeModel *model;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (n_rows >= 0);
+
+  model = hildon_touch_selector_get_model (selector, column);
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_VIRTUAL_MODEL (model));
+
+  hildon_touch_selector_virtual_model_set_n_rows (HILDON_TOUCH_SELECTOR_VIRTUAL_MODEL (model),
+                                                  n_rows);
+}
+
+/**
+ * HildonTouchSelectorLoadFunc:
+ * @cancellable: a #GCancellable, or %NULL
+ * @user_data: the data passed to hildon_touch_selector_load_text_column_async()
+ *
+ * Produces the rows of a column loaded with
+ * hildon_touch_selector_load_text_column_async(). It is called in a
+ * worker thread, so it must not touch any widget. Long loaders should
+ * check @cancellable from time to time.
+ *
+ * Returns: a newly allocated %NULL-terminated array of strings, or
+ * %NULL for an empty column.
+ *
+ * Since: 3.0
+ **/
+
+typedef struct
+{
+  HildonTouchSelectorColumn *column;
+  HildonTouchSelectorLoadFunc func;
+  gpointer func_data;
+  GDestroyNotify destroy;
+} LoadTextColumnData;
+
+static void
+load_text_column_data_free (LoadTextColumnData *data)
+{
+  if (data->destroy)
+    data->destroy (data->func_data);
+
+  g_clear_object (&data->column);
+  g_slice_free (LoadTextColumnData, data);
+}
+
+static gchar *
+load_text_column_row (gint row,
+                      gpointer user_data)
+{
+  gchar **rows = user_data;
+
+  return g_strdup (rows[row]);
+}
+
+static void
+load_text_column_thread (GTask *task,
+                         gpointer source_object,
+                         gpointer task_data,
+                         GCancellable *cancellable)
+{
+  LoadTextColumnData *data = task_data;
+  gchar **rows;
+
+  rows = data->func (cancellable, data->func_data);
+
+  if (g_task_return_error_if_cancelled (task)) {
+    g_strfreev (rows);
+    return;
+  }
+
+  g_task_return_pointer (task, rows ? rows : g_new0 (gchar *, 1),
+                         (GDestroyNotify) g_strfreev);
+}
+
+/* Runs in the main thread: installs the loaded rows in a single model
+   swap, keeping the selected texts and the scroll position */
+static void
+load_text_column_swap (HildonTouchSelector *selector,
+                       gint column,
+                       gchar **rows)
+{
+  HildonTouchSelectorColumn *current_column;
+  GtkTreeModel *old_model;
+  GtkTreeModel *model;
+  GtkAdjustment *adj;
+  GHashTable *selected;
+  GArray *indices;
+  gint *old_indices;
+  gint n_old_indices;
+  gint text_column;
+  gdouble value;
+  gint i;
+
+  current_column = NTH_COLUMN (selector, column);
+  old_model = current_column->priv->model;
+  text_column = hildon_touch_selector_column_get_text_column (current_column);
+
+  selected = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  old_indices = hildon_touch_selector_get_selected_indices (selector, column,
+                                                            &n_old_indices);
+  for (i = 0; i < n_old_indices && text_column != -1; i++) {
+    GtkTreeIter iter;
+    gchar *text = NULL;
+
+    if (gtk_tree_model_iter_nth_child (old_model, &iter, NULL, old_indices[i]))
+      gtk_tree_model_get (old_model, &iter, text_column, &text, -1);
+    if (text != NULL)
+      g_hash_table_add (selected, text);
+  }
+  g_free (old_indices);
+
+  adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (current_column->priv->panarea));
+  value = gtk_adjustment_get_value (adj);
+
+  hildon_touch_selector_freeze_changed (selector);
+
+  model = hildon_touch_selector_virtual_model_new (g_strv_length (rows),
+                                                   load_text_column_row,
+                                                   rows,
+                                                   (GDestroyNotify) g_strfreev);
+  hildon_touch_selector_set_model (selector, column, model);
+  g_object_unref (model);
+
+  hildon_touch_selector_column_set_text_column (current_column, 0);
+  hildon_touch_selector_column_set_fixed_height_rows (current_column, TRUE);
+
+  indices = g_array_new (FALSE, FALSE, sizeof (gint));
+  for (i = 0; rows[i] != NULL && g_hash_table_size (selected) > 0; i++) {
+    if (g_hash_table_remove (selected, rows[i]))
+      g_array_append_val (indices, i);
+  }
+  hildon_touch_selector_set_selected_indices (selector, column,
+                                              (gint *) indices->data,
+                                              indices->len);
+  g_array_free (indices, TRUE);
+  g_hash_table_unref (selected);
+
+  gtk_adjustment_set_value (adj, value);
+
+  hildon_touch_selector_thaw_changed (selector);
+}
+
+static void
+load_text_column_done (GObject *source_object,
+                       GAsyncResult *result,
+                       gpointer user_data)
+{
+  HildonTouchSelector *selector = HILDON_TOUCH_SELECTOR (source_object);
+  GTask *task = user_data;
+  GTask *worker = G_TASK (result);
+  LoadTextColumnData *data = g_task_get_task_data (worker);
+  GError *error = NULL;
+  gchar **rows;
+  gint column;
+
+  rows = g_task_propagate_pointer (worker, &error);
+
+  /* The column may have been removed, or moved by the removal of
+     another one, while the rows were loading */
+  column = hildon_touch_selector_column_index (selector, data->column);
+  g_clear_object (&data->column);
+
+  if (rows == NULL) {
+    g_task_return_error (task, error);
+  } else if (g_task_return_error_if_cancelled (task)) {
+    g_strfreev (rows);
+  } else if (column == -1) {
+    g_strfreev (rows);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                             "The column was removed while loading");
+  } else {
+    load_text_column_swap (selector, column, rows);
+    g_task_return_boolean (task, TRUE);
+  }
+
+  g_object_unref (task);
+}
+
+/**
+ * hildon_touch_selector_load_text_column_async:
+ * @selector: a #HildonTouchSelector
+ * @column: the position of a text column in @selector
+ * @func: a #HildonTouchSelectorLoadFunc producing the rows
+ * @func_data: data to pass to @func
+ * @destroy: destroy notifier for @func_data, or %NULL
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: (allow-none): a #GAsyncReadyCallback to call when the
+ * column has been loaded
+ * @user_data: data to pass to @callback
+ *
+ * Fills the column @column with the strings returned by @func, which
+ * runs in a worker thread so that big lists do not block the user
+ * interface. When @func is done, the rows replace the model of the
+ * column in one go in the main thread: the column becomes a virtual
+ * column (see hildon_touch_selector_append_virtual_column()), the
+ * rows that had the same text as a selected row are selected again,
+ * and the scroll position of the column is kept.
+ * #HildonTouchSelector::changed is emitted at most once.
+ *
+ * Call hildon_touch_selector_load_text_column_finish() from @callback
+ * to check whether the column was loaded.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_load_text_column_async (HildonTouchSelector *selector,
+                                              gint column,
+                                              HildonTouchSelectorLoadFunc func,
+                                              gpointer func_data,
+                                              GDestroyNotify destroy,
+                                              GCancellable *cancellable,
+                                              GAsyncReadyCallback callback,
+                                              gpointer user_data)
+{
+  LoadTextColumnData *data;
+  GTask *task;
+  GTask *worker;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (column >= 0 && column < hildon_touch_selector_get_num_columns (selector));
+  g_return_if_fail (func != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (selector, cancellable, callback, user_data);
+  g_task_set_source_tag (task, hildon_touch_selector_load_text_column_async);
+
+  data = g_slice_new (LoadTextColumnData);
+  data->column = g_object_ref (NTH_COLUMN (selector, column));
+  data->func = func;
+  data->func_data = func_data;
+  data->destroy = destroy;
+
+  /* The worker task reports back in the main thread, where the model
+     is swapped before @task completes */
+  worker = g_task_new (selector, cancellable, load_text_column_done, task);
+  g_task_set_task_data (worker, data, (GDestroyNotify) load_text_column_data_free);
+  g_task_run_in_thread (worker, load_text_column_thread);
+  g_object_unref (worker);
+}
+
+/**
+ * hildon_touch_selector_load_text_column_finish:
+ * @selector: a #HildonTouchSelector
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes an operation started with
+ * hildon_touch_selector_load_text_column_async().
+ *
+ * Returns: %TRUE if the column was loaded, %FALSE if the load was
+ * cancelled or the column was removed in the meantime.
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_touch_selector_load_text_column_finish (HildonTouchSelector *selector,
+                                               GAsyncResult *result,
+                                               GError **error)
+{
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, selector), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * hildon_touch_selector_remove_column:
  * @selector: a #HildonTouchSelector
@@ -1600,10 +3985,10 @@ hildon_touch_selector_remove_column (HildonTouchSelector * selector, gint column
                         hildon_touch_selector_get_num_columns (selector), FALSE);
 
   priv = HILDON_TOUCH_SELECTOR_GET_PRIVATE (selector);
-  current_column = g_slist_nth_data (priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
 
   gtk_container_remove (GTK_CONTAINER (priv->hbox), current_column->priv->vbox);
-  priv->columns = g_slist_remove (priv->columns, current_column);
+  g_ptr_array_remove_index (priv->columns, column);
   g_object_unref (current_column);
 
   g_signal_emit (selector, hildon_touch_selector_signals[COLUMNS_CHANGED], 0);
@@ -1626,7 +4011,7 @@ hildon_touch_selector_get_num_columns (HildonTouchSelector * selector)
 {
   g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), -1);
 
-  return g_slist_length (selector->priv->columns);
+  return selector->priv->columns->len;
 }
 
 /**
@@ -1652,7 +4037,7 @@ hildon_touch_selector_get_column_selection_mode (HildonTouchSelector * selector)
   g_return_val_if_fail (hildon_touch_selector_get_num_columns (selector) > 0,
                         result);
 
-  column = HILDON_TOUCH_SELECTOR_COLUMN (selector->priv->columns->data);
+  column = NTH_COLUMN (selector, 0);
 
   selection = gtk_tree_view_get_selection (column->priv->tree_view);
   treeview_mode = gtk_tree_selection_get_mode (selection);
@@ -1700,7 +4085,7 @@ hildon_touch_selector_set_column_selection_mode (HildonTouchSelector * selector,
     return;
   }
 
-  column = HILDON_TOUCH_SELECTOR_COLUMN ((g_slist_nth (selector->priv->columns, 0))->data);
+  column = NTH_COLUMN (selector, 0);
   tv = column->priv->tree_view;
 
   if (tv) {
@@ -1713,8 +4098,11 @@ hildon_touch_selector_set_column_selection_mode (HildonTouchSelector * selector,
       break;
     }
 
+    hildon_touch_selector_column_attach (column);
+
     selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (tv));
     gtk_tree_selection_set_mode (selection, treeview_mode);
+    hildon_touch_selector_column_invalidate_print (column);
 
     selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (tv));
     gtk_tree_selection_unselect_all (selection);
@@ -1830,7 +4218,25 @@ hildon_touch_selector_set_active                (HildonTouchSelector *selector,
   mode = hildon_touch_selector_get_column_selection_mode (selector);
   g_return_if_fail (mode == HILDON_TOUCH_SELECTOR_SELECTION_MODE_SINGLE);
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    GtkTreeIter iter;
+
+    if (index == -1) {
+      hildon_touch_selector_column_set_pending (current_column, NULL);
+      hildon_touch_selector_emit_value_changed (selector, column);
+      return;
+    }
+
+    path = gtk_tree_path_new_from_indices (index, -1);
+    if (gtk_tree_model_get_iter (current_column->priv->model, &iter, path)) {
+      hildon_touch_selector_column_set_pending (current_column, path);
+      hildon_touch_selector_emit_value_changed (selector, column);
+    }
+    gtk_tree_path_free (path);
+    return;
+  }
 
   selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (current_column->priv->tree_view));
 
@@ -1841,8 +4247,7 @@ hildon_touch_selector_set_active                (HildonTouchSelector *selector,
   }
 
   path = gtk_tree_path_new_from_indices (index, -1);
-  filter_path = gtk_tree_model_filter_convert_child_path_to_path (
-      GTK_TREE_MODEL_FILTER (current_column->priv->filter), path);
+  filter_path = hildon_touch_selector_column_child_path_to_path (current_column, path);
 
   if (filter_path != NULL) {
       gtk_tree_selection_unselect_all (selection);
@@ -1885,15 +4290,24 @@ hildon_touch_selector_get_active                (HildonTouchSelector *selector,
   mode = hildon_touch_selector_get_column_selection_mode (selector);
   g_return_val_if_fail (mode == HILDON_TOUCH_SELECTOR_SELECTION_MODE_SINGLE, -1);
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    GtkTreePath *path = hildon_touch_selector_column_get_pending (current_column);
+
+    if (path != NULL) {
+      index = (gtk_tree_path_get_indices (path))[0];
+      gtk_tree_path_free (path);
+    }
+    return index;
+  }
 
   selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (current_column->priv->tree_view));
 
   if (gtk_tree_selection_get_selected (selection, NULL, &filter_iter)) {
     GtkTreePath *path;
     GtkTreeIter iter;
-    gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (current_column->priv->filter),
-                                                      &iter, &filter_iter);
+    hildon_touch_selector_column_iter_to_child_iter (current_column, &iter, &filter_iter);
     path = gtk_tree_model_get_path (current_column->priv->model, &iter);
     index = (gtk_tree_path_get_indices (path))[0];
     gtk_tree_path_free (path);
@@ -1944,7 +4358,24 @@ hildon_touch_selector_get_selected (HildonTouchSelector * selector,
      ((mode == HILDON_TOUCH_SELECTOR_SELECTION_MODE_MULTIPLE)&&(column>0)),
      FALSE);
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    GtkTreePath *path = hildon_touch_selector_column_get_pending (current_column);
+    GtkTreeIter child_iter;
+
+    result = path != NULL &&
+      gtk_tree_model_get_iter (current_column->priv->model, &child_iter, path);
+    gtk_tree_path_free (path);
+
+    if (iter) {
+      if (result)
+        *iter = child_iter;
+      else
+        memset (iter, 0, sizeof (GtkTreeIter));
+    }
+    return result;
+  }
 
   selection =
     gtk_tree_view_get_selection (GTK_TREE_VIEW (current_column->priv->tree_view));
@@ -1953,9 +4384,7 @@ hildon_touch_selector_get_selected (HildonTouchSelector * selector,
 
   if (iter) {
     if (result == TRUE) {
-      gtk_tree_model_filter_convert_iter_to_child_iter
-        (GTK_TREE_MODEL_FILTER (current_column->priv->filter),
-         iter, &filter_iter);
+      hildon_touch_selector_column_iter_to_child_iter (current_column, iter, &filter_iter);
     } else {
       memset (iter, 0, sizeof (GtkTreeIter));
     }
@@ -1992,15 +4421,26 @@ hildon_touch_selector_select_iter (HildonTouchSelector * selector,
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
   g_return_if_fail (column < hildon_touch_selector_get_num_columns (selector));
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    /* Lazy columns are single selection, and get scrolled to the
+       selection when they are shown */
+    GtkTreePath *path = gtk_tree_model_get_path (current_column->priv->model, iter);
+
+    hildon_touch_selector_column_set_pending (current_column, path);
+    gtk_tree_path_free (path);
+    hildon_touch_selector_emit_value_changed (selector, column);
+    return;
+  }
 
   tv = current_column->priv->tree_view;
   selection = gtk_tree_view_get_selection (tv);
 
   /* The given iter might be not visible, due to the
      GtkTreeModelFilter we use. If so, don't change the selection. */
-  if (gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (current_column->priv->filter),
-                                                        &filter_iter, iter) == FALSE)
+  if (hildon_touch_selector_column_child_iter_to_iter (current_column,
+                                                       &filter_iter, iter) == FALSE)
           return;
 
   filter_path = gtk_tree_model_get_path (current_column->priv->filter, &filter_iter);
@@ -2038,10 +4478,23 @@ void hildon_touch_selector_unselect_iter (HildonTouchSelector * selector,
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
   g_return_if_fail (column < hildon_touch_selector_get_num_columns (selector));
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    GtkTreePath *pending = hildon_touch_selector_column_get_pending (current_column);
+    GtkTreePath *path = gtk_tree_model_get_path (current_column->priv->model, iter);
+
+    if (pending != NULL && gtk_tree_path_compare (pending, path) == 0)
+      hildon_touch_selector_column_set_pending (current_column, NULL);
+    gtk_tree_path_free (pending);
+    gtk_tree_path_free (path);
+    hildon_touch_selector_emit_value_changed (selector, column);
+    return;
+  }
+
   selection = gtk_tree_view_get_selection (current_column->priv->tree_view);
-  if (gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (current_column->priv->filter),
-                                                        &filter_iter, iter) == FALSE)
+  if (hildon_touch_selector_column_child_iter_to_iter (current_column,
+                                                       &filter_iter, iter) == FALSE)
     return;
 
   gtk_tree_selection_unselect_iter (selection, &filter_iter);
@@ -2067,17 +4520,22 @@ hildon_touch_selector_unselect_all (HildonTouchSelector * selector,
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
   g_return_if_fail (column < hildon_touch_selector_get_num_columns (selector));
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
-  selection = gtk_tree_view_get_selection (current_column->priv->tree_view);
-  gtk_tree_selection_unselect_all (selection);
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    hildon_touch_selector_column_set_pending (current_column, NULL);
+  } else {
+    selection = gtk_tree_view_get_selection (current_column->priv->tree_view);
+    gtk_tree_selection_unselect_all (selection);
+  }
 
   hildon_touch_selector_emit_value_changed (selector, column);
 }
 
 /**
  * hildon_touch_selector_filter_selected_to_child_selected:
- * @filter: 
- * @filter_selected: 
+ * @column: a #HildonTouchSelectorColumn
+ * @filter_selected: paths of the filter of @column
  *
  * Converts a list of #GtkTreePath<!-- -->s from the internal
  * #GtkTreeModelFilter to the child #GtkTreeModel.
@@ -2086,18 +4544,18 @@ hildon_touch_selector_unselect_all (HildonTouchSelector * selector,
  * and paths should be freed when not needed anymore.
  **/
 static GList *
-hildon_touch_selector_filter_selected_to_child_selected (GtkTreeModelFilter *filter,
+hildon_touch_selector_filter_selected_to_child_selected (HildonTouchSelectorColumn *column,
                                                          GList *filter_selected)
 {
     GList *iter;
     GList *child_selected = NULL;
 
     for (iter = filter_selected; iter; iter = iter->next)
-        child_selected = g_list_append (child_selected,
-                                        gtk_tree_model_filter_convert_path_to_child_path (
-                                            filter, (GtkTreePath *)iter->data));
+        child_selected = g_list_prepend (child_selected,
+                                         hildon_touch_selector_column_path_to_child_path (
+                                             column, (GtkTreePath *)iter->data));
 
-    return child_selected;
+    return g_list_reverse (child_selected);
 }
 
 /**
@@ -2129,19 +4587,378 @@ hildon_touch_selector_get_selected_rows (HildonTouchSelector * selector,
   g_return_val_if_fail (column < hildon_touch_selector_get_num_columns (selector),
                         NULL);
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    GtkTreePath *path = hildon_touch_selector_column_get_pending (current_column);
+
+    return path ? g_list_append (NULL, path) : NULL;
+  }
+
   selection = gtk_tree_view_get_selection (current_column->priv->tree_view);
 
   filter_selected = gtk_tree_selection_get_selected_rows (selection, NULL);
   result = hildon_touch_selector_filter_selected_to_child_selected
-      (GTK_TREE_MODEL_FILTER (current_column->priv->filter),
-       filter_selected);
+      (current_column, filter_selected);
   g_list_foreach (filter_selected, (GFunc) gtk_tree_path_free, NULL);
   g_list_free (filter_selected);
 
   return result;
 }
 
+/*
+ * Whether the filter of @column shows every row of its child model, in
+ * which case filter and child indices are the same and paths don't
+ * need to be converted.
+ */
+static gboolean
+hildon_touch_selector_column_filter_is_identity (HildonTouchSelectorColumn *column)
+{
+  return gtk_tree_model_iter_n_children (column->priv->filter, NULL) ==
+    gtk_tree_model_iter_n_children (column->priv->model, NULL);
+}
+
+typedef struct
+{
+  GArray *indices;
+  HildonTouchSelectorColumn *column;
+  gboolean identity;
+} CollectIndicesData;
+
+static void
+collect_selected_index (GtkTreeModel *model,
+                        GtkTreePath *path,
+                        GtkTreeIter *iter,
+                        gpointer userdata)
+{
+  CollectIndicesData *data = userdata;
+  gint index;
+
+  if (data->identity) {
+    index = gtk_tree_path_get_indices (path)[0];
+  } else {
+    GtkTreePath *child_path;
+
+    child_path = hildon_touch_selector_column_path_to_child_path (data->column, path);
+    if (child_path == NULL)
+      return;
+    index = gtk_tree_path_get_indices (child_path)[0];
+    gtk_tree_path_free (child_path);
+  }
+
+  g_array_append_val (data->indices, index);
+}
+
+/**
+ * hildon_touch_selector_get_selected_indices:
+ * @selector: a #HildonTouchSelector
+ * @column: the position of the column to get the selected rows from
+ * @n_indices: (out): return location for the number of indices
+ *
+ * Gets the positions in the model of all the selected rows of the column
+ * @column, which must use a list model. Unlike
+ * hildon_touch_selector_get_selected_rows(), no #GtkTreePath is created
+ * per selected row, which makes this function suitable to save, compare
+ * and restore large selections, see hildon_touch_selector_set_selected_indices().
+ *
+ * Returns: a newly allocated array with the sorted row positions, free it
+ * with g_free(). %NULL if nothing is selected.
+ *
+ * Since: 3.0
+ **/
+gint *
+hildon_touch_selector_get_selected_indices (HildonTouchSelector *selector,
+                                            gint column,
+                                            gint *n_indices)
+{
+  HildonTouchSelectorColumn *current_column;
+  CollectIndicesData data;
+  GtkTreeSelection *selection;
+
+  g_return_val_if_fail (n_indices != NULL, NULL);
+  *n_indices = 0;
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), NULL);
+  g_return_val_if_fail (column >= 0 && column < hildon_touch_selector_get_num_columns (selector),
+                        NULL);
+
+  current_column = NTH_COLUMN (selector, column);
+
+  if (!current_column->priv->attached) {
+    GtkTreePath *path = hildon_touch_selector_column_get_pending (current_column);
+    gint *result;
+
+    if (path == NULL)
+      return NULL;
+
+    result = g_new (gint, 1);
+    result[0] = gtk_tree_path_get_indices (path)[0];
+    *n_indices = 1;
+    gtk_tree_path_free (path);
+
+    return result;
+  }
+
+  selection = gtk_tree_view_get_selection (current_column->priv->tree_view);
+
+  data.indices = g_array_sized_new (FALSE, FALSE, sizeof (gint),
+                                    gtk_tree_selection_count_selected_rows (selection));
+  data.column = current_column;
+  data.identity = hildon_touch_selector_column_filter_is_identity (current_column);
+
+  gtk_tree_selection_selected_foreach (selection, collect_selected_index, &data);
+
+  *n_indices = data.indices->len;
+
+  return (gint *) g_array_free (data.indices, data.indices->len == 0);
+}
+
+/**
+ * hildon_touch_selector_set_selected_indices:
+ * @selector: a #HildonTouchSelector
+ * @column: the position of the column to select rows in
+ * @indices: (array length=n_indices): positions of rows in the model of @column
+ * @n_indices: the number of elements in @indices
+ *
+ * Replaces the selection of the column @column, which must use a list
+ * model, with the rows at the given positions. Positions out of range
+ * or hidden by the live search are ignored. #HildonTouchSelector::changed
+ * is emitted once. In %HILDON_TOUCH_SELECTOR_SELECTION_MODE_SINGLE only
+ * the last index is kept.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_set_selected_indices (HildonTouchSelector *selector,
+                                            gint column,
+                                            const gint *indices,
+                                            gint n_indices)
+{
+  HildonTouchSelectorColumn *current_column;
+  GtkTreeSelection *selection;
+  gboolean identity;
+  gint n_rows;
+  gint i;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (column >= 0 && column < hildon_touch_selector_get_num_columns (selector));
+  g_return_if_fail (n_indices == 0 || indices != NULL);
+
+  current_column = NTH_COLUMN (selector, column);
+  n_rows = gtk_tree_model_iter_n_children (current_column->priv->model, NULL);
+
+  if (!current_column->priv->attached && n_indices <= 1) {
+    GtkTreePath *path = NULL;
+
+    if (n_indices == 1 && indices[0] >= 0 && indices[0] < n_rows)
+      path = gtk_tree_path_new_from_indices (indices[0], -1);
+    hildon_touch_selector_column_set_pending (current_column, path);
+    gtk_tree_path_free (path);
+
+    hildon_touch_selector_emit_value_changed (selector, column);
+    return;
+  }
+
+  hildon_touch_selector_column_attach (current_column);
+
+  selection = gtk_tree_view_get_selection (current_column->priv->tree_view);
+  identity = hildon_touch_selector_column_filter_is_identity (current_column);
+
+  gtk_tree_selection_unselect_all (selection);
+
+  for (i = 0; i < n_indices; i++) {
+    GtkTreePath *path;
+
+    if (indices[i] < 0 || indices[i] >= n_rows)
+      continue;
+
+    path = gtk_tree_path_new_from_indices (indices[i], -1);
+    if (identity) {
+      gtk_tree_selection_select_path (selection, path);
+    } else {
+      GtkTreePath *filter_path;
+
+      filter_path = hildon_touch_selector_column_child_path_to_path (current_column, path);
+      if (filter_path != NULL) {
+        gtk_tree_selection_select_path (selection, filter_path);
+        gtk_tree_path_free (filter_path);
+      }
+    }
+    gtk_tree_path_free (path);
+  }
+
+  hildon_touch_selector_emit_value_changed (selector, column);
+}
+
+/*
+ * Converts the rows @first to @last of the model of @column into the
+ * rows shown by its filter. Returns %FALSE if none of them is shown.
+ */
+static gboolean
+hildon_touch_selector_column_child_range_to_range (HildonTouchSelectorColumn *column,
+                                                   gint *first,
+                                                   gint *last)
+{
+  GArray *map;
+  guint start, end;
+
+  if (hildon_touch_selector_column_filter_is_identity (column))
+    return *first <= *last;
+
+  map = hildon_touch_selector_column_get_visible_map (column);
+  start = visible_map_lower_bound (map, *first);
+  end = visible_map_lower_bound (map, *last + 1);
+
+  if (start >= end)
+    return FALSE;
+
+  *first = start;
+  *last = end - 1;
+
+  return TRUE;
+}
+
+/**
+ * hildon_touch_selector_select_range:
+ * @selector: a #HildonTouchSelector in
+ * %HILDON_TOUCH_SELECTOR_SELECTION_MODE_MULTIPLE
+ * @column: the position of a column using a list model
+ * @first: the position of the first row to select in the model
+ * @last: the position of the last row to select in the model
+ *
+ * Adds the rows from @first to @last, both included, to the selection
+ * of @column. Rows hidden by the live search are left alone. This is
+ * done in one go, and #HildonTouchSelector::changed is only emitted
+ * once, however many rows are selected.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_select_range (HildonTouchSelector *selector,
+                                    gint column,
+                                    gint first,
+                                    gint last)
+{
+  HildonTouchSelectorColumn *current_column;
+  GtkTreePath *start_path, *end_path;
+  gint n_rows;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (column >= 0 && column < hildon_touch_selector_get_num_columns (selector));
+  g_return_if_fail (_hildon_touch_selector_has_multiple_selection (selector));
+
+  current_column = NTH_COLUMN (selector, column);
+
+  g_return_if_fail (gtk_tree_model_get_flags (current_column->priv->model) &
+                    GTK_TREE_MODEL_LIST_ONLY);
+
+  n_rows = gtk_tree_model_iter_n_children (current_column->priv->model, NULL);
+  first = MAX (first, 0);
+  last = MIN (last, n_rows - 1);
+
+  hildon_touch_selector_column_attach (current_column);
+
+  if (!hildon_touch_selector_column_child_range_to_range (current_column, &first, &last))
+    return;
+
+  start_path = gtk_tree_path_new_from_indices (first, -1);
+  end_path = gtk_tree_path_new_from_indices (last, -1);
+  gtk_tree_selection_select_range (gtk_tree_view_get_selection (current_column->priv->tree_view),
+                                   start_path, end_path);
+  gtk_tree_path_free (start_path);
+  gtk_tree_path_free (end_path);
+
+  hildon_touch_selector_emit_value_changed (selector, column);
+}
+
+/**
+ * hildon_touch_selector_select_all:
+ * @selector: a #HildonTouchSelector in
+ * %HILDON_TOUCH_SELECTOR_SELECTION_MODE_MULTIPLE
+ * @column: the position of a column
+ *
+ * Selects all the rows of @column shown by the live search, emitting
+ * #HildonTouchSelector::changed once.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_select_all (HildonTouchSelector *selector,
+                                  gint column)
+{
+  HildonTouchSelectorColumn *current_column;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (column >= 0 && column < hildon_touch_selector_get_num_columns (selector));
+  g_return_if_fail (_hildon_touch_selector_has_multiple_selection (selector));
+
+  current_column = NTH_COLUMN (selector, column);
+
+  hildon_touch_selector_column_attach (current_column);
+  gtk_tree_selection_select_all (gtk_tree_view_get_selection (current_column->priv->tree_view));
+
+  hildon_touch_selector_emit_value_changed (selector, column);
+}
+
+/**
+ * hildon_touch_selector_invert_selection:
+ * @selector: a #HildonTouchSelector in
+ * %HILDON_TOUCH_SELECTOR_SELECTION_MODE_MULTIPLE
+ * @column: the position of a column using a list model
+ *
+ * Selects the rows of @column shown by the live search that are not
+ * selected, and unselects the others. The rows are selected a range
+ * at a time, and #HildonTouchSelector::changed is emitted once.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_invert_selection (HildonTouchSelector *selector,
+                                        gint column)
+{
+  HildonTouchSelectorColumn *current_column;
+  GtkTreeSelection *selection;
+  GList *selected, *l;
+  gint n_rows;
+  gint next = 0;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (column >= 0 && column < hildon_touch_selector_get_num_columns (selector));
+  g_return_if_fail (_hildon_touch_selector_has_multiple_selection (selector));
+
+  current_column = NTH_COLUMN (selector, column);
+
+  g_return_if_fail (gtk_tree_model_get_flags (current_column->priv->model) &
+                    GTK_TREE_MODEL_LIST_ONLY);
+
+  hildon_touch_selector_column_attach (current_column);
+
+  selection = gtk_tree_view_get_selection (current_column->priv->tree_view);
+  n_rows = gtk_tree_model_iter_n_children (current_column->priv->filter, NULL);
+
+  /* The selected rows come in order, select the gaps between them */
+  selected = gtk_tree_selection_get_selected_rows (selection, NULL);
+  gtk_tree_selection_unselect_all (selection);
+
+  for (l = selected; next < n_rows; l = l ? l->next : NULL) {
+    gint end = l ? gtk_tree_path_get_indices (l->data)[0] : n_rows;
+
+    if (end > next) {
+      GtkTreePath *start_path = gtk_tree_path_new_from_indices (next, -1);
+      GtkTreePath *end_path = gtk_tree_path_new_from_indices (end - 1, -1);
+
+      gtk_tree_selection_select_range (selection, start_path, end_path);
+      gtk_tree_path_free (start_path);
+      gtk_tree_path_free (end_path);
+    }
+    next = end + 1;
+  }
+
+  g_list_foreach (selected, (GFunc) gtk_tree_path_free, NULL);
+  g_list_free (selected);
+
+  hildon_touch_selector_emit_value_changed (selector, column);
+}
+
 /**
  * hildon_touch_selector_get_model:
  * @selector: a #HildonTouchSelector
@@ -2162,7 +4979,7 @@ hildon_touch_selector_get_model (HildonTouchSelector * selector, gint column)
   g_return_val_if_fail (column < hildon_touch_selector_get_num_columns (selector),
                         NULL);
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
 
   return current_column->priv->model;
 }
@@ -2177,17 +4994,24 @@ on_row_changed (GtkTreeModel *model,
   HildonTouchSelectorColumn *current_column;
   GtkTreePath *filter_path;
 
-  gint column = 0;
-  GSList *col;
+  guint column;
 
   selector = HILDON_TOUCH_SELECTOR (userdata);
 
-  for (col = selector->priv->columns; col != NULL; col = col->next) {
-    current_column = HILDON_TOUCH_SELECTOR_COLUMN (col->data);
-    if (current_column->priv->model == model) {
-        filter_path =
-            gtk_tree_model_filter_convert_child_path_to_path (GTK_TREE_MODEL_FILTER (current_column->priv->filter),
-                                                              path);
+  /* A live search showing or hiding the row, its value is the same */
+  if (hildon_live_search_is_announcing (model))
+    return;
+
+  for (column = 0; column < selector->priv->columns->len; column++) {
+    current_column = NTH_COLUMN (selector, column);
+    if (current_column->priv->model == model && !current_column->priv->attached) {
+        GtkTreePath *pending = hildon_touch_selector_column_get_pending (current_column);
+
+        if (pending != NULL && gtk_tree_path_compare (pending, path) == 0)
+            hildon_touch_selector_emit_value_changed (selector, column);
+        gtk_tree_path_free (pending);
+    } else if (current_column->priv->model == model) {
+        filter_path = hildon_touch_selector_column_child_path_to_path (current_column, path);
         if (filter_path &&
             gtk_tree_selection_path_is_selected (gtk_tree_view_get_selection (current_column->priv->tree_view),
                                                  filter_path)) {
@@ -2195,25 +5019,78 @@ on_row_changed (GtkTreeModel *model,
         }
         gtk_tree_path_free (filter_path);
     }
-    column ++;
   }
 }
 
+static void
+on_row_changed_invalidate (GtkTreeModel *model,
+                           GtkTreePath *path,
+                           GtkTreeIter *iter,
+                           gpointer userdata)
+{
+  HildonTouchSelectorColumn *column = HILDON_TOUCH_SELECTOR_COLUMN (userdata);
+
+  /* The text of a row a live search shows or hides is the same */
+  if (hildon_live_search_is_announcing (model))
+    return;
+
+  g_hash_table_remove (column->priv->norm_cache, iter->user_data);
+  hildon_touch_selector_column_invalidate_print (column);
+}
+
+static void
+on_rows_reordered_invalidate (GtkTreeModel *model,
+                              GtkTreePath *path,
+                              GtkTreeIter *iter,
+                              gpointer new_order,
+                              gpointer userdata)
+{
+  /* The order of the selected items may have changed */
+  hildon_touch_selector_column_invalidate_print (HILDON_TOUCH_SELECTOR_COLUMN (userdata));
+  hildon_touch_selector_column_invalidate_diff (HILDON_TOUCH_SELECTOR_COLUMN (userdata));
+}
+
+static void
+on_row_inserted_invalidate (GtkTreeModel *model,
+                            GtkTreePath *path,
+                            GtkTreeIter *iter,
+                            gpointer userdata)
+{
+  /* The rows after @path moved down */
+  hildon_touch_selector_column_invalidate_diff (HILDON_TOUCH_SELECTOR_COLUMN (userdata));
+}
+
 static void
 on_row_deleted (GtkTreeModel *model,
                 GtkTreePath *path,
                 gpointer userdata)
 {
   HildonTouchSelector *selector = HILDON_TOUCH_SELECTOR (userdata);
-  gint column = 0;
-  GSList *col = selector->priv->columns;
+  guint column;
 
-  while (col != NULL) {
+  for (column = 0; column < selector->priv->columns->len; column++) {
     HildonTouchSelectorColumn *current_column;
-    current_column = HILDON_TOUCH_SELECTOR_COLUMN (col->data);
+    current_column = NTH_COLUMN (selector, column);
     if (current_column->priv->model == model) {
-      GtkTreeSelection *sel = gtk_tree_view_get_selection (current_column->priv->tree_view);
-      if (gtk_tree_selection_get_mode (sel) == GTK_SELECTION_BROWSE &&
+      GtkTreeSelection *sel;
+
+      /* The iter of the deleted row is gone, and its memory could be
+         reused by a new row, so the whole cache must go */
+      hildon_touch_selector_column_clear_normalized (current_column);
+      hildon_touch_selector_column_invalidate_print (current_column);
+      hildon_touch_selector_column_invalidate_diff (current_column);
+
+      sel = gtk_tree_view_get_selection (current_column->priv->tree_view);
+      if (!current_column->priv->attached) {
+        /* Like the browse mode of the tree view, fall back to the first row */
+        if (current_column->priv->pending_row != NULL &&
+            !gtk_tree_row_reference_valid (current_column->priv->pending_row) &&
+            gtk_tree_model_iter_n_children (model, NULL) > 0) {
+          GtkTreePath *first = gtk_tree_path_new_first ();
+          hildon_touch_selector_column_set_pending (current_column, first);
+          gtk_tree_path_free (first);
+        }
+      } else if (gtk_tree_selection_get_mode (sel) == GTK_SELECTION_BROWSE &&
           gtk_tree_model_iter_n_children (model, NULL) > 0 &&
           gtk_tree_selection_count_selected_rows (sel) == 0) {
         GtkTreeIter iter;
@@ -2226,8 +5103,6 @@ on_row_deleted (GtkTreeModel *model,
       }
       hildon_touch_selector_emit_value_changed (selector, column);
     }
-    col = col->next;
-    column ++;
   }
 }
 
@@ -2238,25 +5113,54 @@ _hildon_touch_selector_set_model (HildonTouchSelector * selector,
   HildonTouchSelectorColumn *current_column = NULL;
 
   current_column =
-    HILDON_TOUCH_SELECTOR_COLUMN (g_slist_nth_data (selector->priv->columns, column));
+    NTH_COLUMN (selector, column);
 
   if (current_column->priv->model) {
     g_signal_handlers_disconnect_by_func (current_column->priv->model,
                                           on_row_changed, selector);
     g_signal_handlers_disconnect_by_func (current_column->priv->model,
                                           on_row_deleted, selector);
+    g_signal_handlers_disconnect_by_func (current_column->priv->model,
+                                          on_row_changed_invalidate, current_column);
+    g_signal_handlers_disconnect_by_func (current_column->priv->model,
+                                          on_rows_reordered_invalidate, current_column);
+    g_signal_handlers_disconnect_by_func (current_column->priv->model,
+                                          on_row_inserted_invalidate, current_column);
     g_object_unref (current_column->priv->model);
   }
 
   current_column->priv->model = g_object_ref (model);
+  hildon_touch_selector_column_clear_normalized (current_column);
+  hildon_touch_selector_column_invalidate_print (current_column);
+  hildon_touch_selector_column_invalidate_diff (current_column);
 
   if (current_column->priv->filter) {
+    hildon_touch_selector_column_unwatch_filter (current_column);
     g_object_unref (current_column->priv->filter);
   }
 
-  current_column->priv->filter = gtk_tree_model_filter_new (model, NULL);
-  gtk_tree_view_set_model (current_column->priv->tree_view,
-                           current_column->priv->filter);
+  g_signal_connect (model, "row-changed",
+                    G_CALLBACK (on_row_changed_invalidate), current_column);
+  g_signal_connect (model, "rows-reordered",
+                    G_CALLBACK (on_rows_reordered_invalidate), current_column);
+  g_signal_connect (model, "row-inserted",
+                    G_CALLBACK (on_row_inserted_invalidate), current_column);
+  hildon_touch_selector_column_create_filter (current_column,
+                                              current_column->priv->livesearch != NULL ||
+                                              current_column->priv->visible_rows >= 0 ||
+                                              current_column->priv->row_filter != NULL);
+
+  /* The visible function belonged to the old filter */
+  current_column->priv->visible_func_set = FALSE;
+  if (current_column->priv->visible_rows >= 0 ||
+      current_column->priv->row_filter != NULL)
+    hildon_touch_selector_column_install_visible_func (current_column);
+  if (current_column->priv->attached) {
+    gtk_tree_view_set_model (current_column->priv->tree_view,
+                             current_column->priv->filter);
+  } else {
+    hildon_touch_selector_column_set_pending (current_column, NULL);
+  }
 
   g_signal_connect (model, "row-changed",
                     G_CALLBACK (on_row_changed), selector);
@@ -2314,87 +5218,174 @@ hildon_touch_selector_get_current_text (HildonTouchSelector * selector)
   return result;
 }
 
-static void
-//search_nearest_element (HildonPannableArea *panarea,
-search_nearest_element (GtkScrolledWindow *panarea,
-                        GtkTreeView *tv,
-                        GList *selected_rows,
-                        GtkTreePath **nearest_path)
+/*
+ * Returns the y coordinate of the row at @path, in tree coordinates.
+ * With fixed height rows in a list, it is computed from the row index
+ * instead of querying the layout of the tree view.
+ */
+static gint
+get_row_y (HildonTouchSelectorColumn *column,
+           GtkTreePath *path)
 {
-  GtkAdjustment *adj = NULL;
-  gdouble target_value = 0;
+  GtkTreeView *tv = column->priv->tree_view;
   GdkRectangle rect;
-  GList *iter = NULL;
-  GtkTreePath *path = NULL;
-  gint y = -1;
-  gdouble nearest_distance = -1;
-  gdouble current_distance = -1;
-  GtkTreePath *result_path = NULL;
+  gint row_height;
+  gint y;
+
+  row_height = hildon_touch_selector_column_get_row_height (column);
+  if (row_height > 0 && gtk_tree_path_get_depth (path) == 1)
+    return gtk_tree_path_get_indices (path)[0] * row_height;
+
+  gtk_tree_view_get_background_area (tv, path, NULL, &rect);
+  gtk_tree_view_convert_bin_window_to_tree_coords (tv, 0, rect.y, NULL, &y);
+
+  return y;
+}
 
-  g_assert (nearest_path != NULL);
+/* Scrolls @column so that the row at @path is in the center */
+static void
+hildon_touch_selector_column_scroll_to_row     (HildonTouchSelectorColumn *column,
+                                                GtkTreePath *path)
+{
+  GtkAdjustment *adj;
+  gint row_height;
+  gint y;
 
-  if (selected_rows == NULL) {
-    *nearest_path = NULL;
+  adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (column->priv->panarea));
+  if (adj == NULL)
     return;
+
+  y = get_row_y (column, path);
+
+  row_height = hildon_touch_selector_column_get_row_height (column);
+  if (row_height == 0) {
+    GdkRectangle rect;
+
+    gtk_tree_view_get_background_area (column->priv->tree_view, path, NULL, &rect);
+    row_height = rect.height;
   }
 
-//  adj = hildon_pannable_area_get_vadjustment (panarea);
+  /* The adjustment clamps the value to the scrollable range */
+  gtk_adjustment_set_value (adj, y + row_height / 2
+                            - gtk_adjustment_get_page_size (adj) / 2);
+}
+
+/*
+ * Finds the selected row nearest to the center of the visible area of
+ * @tv. The row at the center is located once, then the sorted list of
+ * selected rows is bisected around it, so only the two candidates on
+ * each side of the center need their geometry to be queried, instead
+ * of every selected row.
+ *
+ * Returns: a newly allocated #GtkTreePath in @tv model, or %NULL
+ */
+static GtkTreePath *
+search_nearest_element (HildonTouchSelectorColumn *column)
+{
+  GtkScrolledWindow *panarea = GTK_SCROLLED_WINDOW (column->priv->panarea);
+  GtkTreeView *tv = column->priv->tree_view;
+  GtkAdjustment *adj = NULL;
+  GtkTreeSelection *selection;
+  GtkTreePath **selected;
+  GtkTreePath *center_path = NULL;
+  GtkTreePath *result_path = NULL;
+  GList *selected_rows, *iter;
+  gdouble target_value = 0;
+  gint n_selected, lo, hi, bx, by;
+
   adj = gtk_scrolled_window_get_vadjustment (panarea);
-  g_return_if_fail (adj != NULL);
+  g_return_val_if_fail (adj != NULL, NULL);
+
+  selection = gtk_tree_view_get_selection (tv);
+  selected_rows = gtk_tree_selection_get_selected_rows (selection, NULL);
+  if (selected_rows == NULL)
+    return NULL;
+
+  /* The list is in tree order, so it can be bisected as an array */
+  n_selected = g_list_length (selected_rows);
+  selected = g_new (GtkTreePath *, n_selected);
+  for (iter = selected_rows, lo = 0; iter; iter = iter->next, lo++)
+    selected[lo] = iter->data;
+  g_list_free (selected_rows);
 
   /* we add this in order to check the nearest to the center of
      the visible area */
   target_value = gtk_adjustment_get_value (adj)
                + gtk_adjustment_get_page_size (adj)/2;
 
-  path = result_path = selected_rows->data;
-  gtk_tree_view_get_background_area (tv, path, NULL, &rect);
-  gtk_tree_view_convert_bin_window_to_tree_coords (tv, 0, rect.y, NULL, &y);
-  nearest_distance = abs (target_value - y);
-
-  for (iter = selected_rows->next; iter; iter = g_list_next (iter)) {
-    gtk_tree_view_get_background_area (tv, path, NULL, &rect);
-    gtk_tree_view_convert_bin_window_to_tree_coords (tv, 0, rect.y, NULL, &y);
-    current_distance = abs (target_value - y);
-    if (current_distance < nearest_distance) {
-      nearest_distance = current_distance;
-      result_path = path;
+  gtk_tree_view_convert_tree_to_bin_window_coords (tv, 0, (gint) target_value,
+                                                   &bx, &by);
+  if (n_selected == 1 || !gtk_widget_get_realized (GTK_WIDGET (tv))) {
+    /* Nothing to compare with: take the first one */
+    lo = 0;
+  } else if (!gtk_tree_view_get_path_at_pos (tv, bx, by, &center_path,
+                                             NULL, NULL, NULL)) {
+    /* The center is past the last row, so the last one is the nearest */
+    lo = n_selected;
+  } else {
+    /* Find the first selected row at or after the center row */
+    lo = 0;
+    hi = n_selected;
+    while (lo < hi) {
+      gint mid = (lo + hi) / 2;
+
+      if (gtk_tree_path_compare (selected[mid], center_path) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
     }
+    gtk_tree_path_free (center_path);
   }
 
-  *nearest_path = result_path;
+  if (lo == 0) {
+    result_path = selected[0];
+  } else if (lo == n_selected) {
+    result_path = selected[n_selected - 1];
+  } else {
+    gdouble before = target_value - get_row_y (column, selected[lo - 1]);
+    gdouble after = get_row_y (column, selected[lo]) - target_value;
+
+    result_path = (before <= after) ? selected[lo - 1] : selected[lo];
+  }
+
+  for (hi = 0; hi < n_selected; hi++) {
+    if (selected[hi] != result_path)
+      gtk_tree_path_free (selected[hi]);
+  }
+  g_free (selected);
+
+  return result_path;
 }
 
-static gboolean
-on_realize_cb                                  (GtkWidget *widget,
-                                                gpointer data)
+/* The first allocation of the pannable area has just set up the
+   adjustments, and nothing has been drawn yet: scrolling now lets the
+   column show the initial row in its first paint, instead of painting
+   the top rows and then jumping. Rows the tree view did not validate
+   yet are placed at their estimated height. */
+static void
+on_allocate_cb                                 (GtkWidget     *widget,
+                                                GtkAllocation *allocation,
+                                                gpointer       data)
 {
   HildonTouchSelectorColumn *column = NULL;
-  GdkRectangle rect;
-  gint y;
 
   column = HILDON_TOUCH_SELECTOR_COLUMN (data);
 
-  if (column->priv->initial_path) {
-    gtk_tree_view_get_background_area (GTK_TREE_VIEW (column->priv->tree_view),
-                                       column->priv->initial_path, NULL, &rect);
-    gtk_tree_view_convert_bin_window_to_tree_coords
-      (GTK_TREE_VIEW (column->priv->tree_view),
-       0, rect.y, NULL, &y);
-
-//    hildon_pannable_area_scroll_to (HILDON_PANNABLE_AREA (column->priv->panarea),
-//                                    -1, y);
-
-    gtk_tree_path_free (column->priv->initial_path);
+  /* Wait for a real allocation */
+  if (allocation->height <= 1)
+    return;
 
-    column->priv->initial_path = NULL;
+  g_signal_handler_disconnect (column->priv->panarea,
+                               column->priv->allocate_handler);
+  column->priv->allocate_handler = 0;
 
-  }
+  if (column->priv->initial_path) {
+    hildon_touch_selector_column_scroll_to_row (column, column->priv->initial_path);
 
-  g_signal_handler_disconnect (column->priv->panarea,
-                               column->priv->realize_handler);
+    gtk_tree_path_free (column->priv->initial_path);
 
-  return FALSE;
+    column->priv->initial_path = NULL;
+  }
 }
 
 static void
@@ -2402,35 +5393,26 @@ hildon_touch_selector_scroll_to (HildonTouchSelectorColumn *column,
                                  GtkTreeView *tv,
                                  GtkTreePath *path)
 {
-  if (gtk_widget_get_realized (GTK_WIDGET (column->priv->panarea))) {
-    GdkRectangle rect;
-    gint y;
-
-    gtk_tree_view_get_background_area (tv,
-                                       path, NULL, &rect);
-    gtk_tree_view_convert_bin_window_to_tree_coords (tv,
-                                                     0, rect.y, NULL, &y);
-
-//    hildon_pannable_area_scroll_to (HILDON_PANNABLE_AREA
-//                                    (column->priv->panarea), -1, y);
+  GtkWidget *panarea = GTK_WIDGET (column->priv->panarea);
+
+  /* An area that already had a real allocation may not get another
+     one, whether it is realized or not, so scroll it now */
+  if ((gtk_widget_get_realized (panarea) ||
+       gtk_widget_get_allocated_height (panarea) > 1) &&
+      column->priv->allocate_handler == 0) {
+    hildon_touch_selector_column_scroll_to_row (column, path);
   } else {
-    if (column->priv->realize_handler != 0) {
-
-      if (column->priv->initial_path) {
-        gtk_tree_path_free (column->priv->initial_path);
-        column->priv->initial_path = NULL;
-      }
-
-      g_signal_handler_disconnect (column->priv->panarea,
-                                   column->priv->realize_handler);
-      column->priv->realize_handler = 0;
+    if (column->priv->initial_path) {
+      gtk_tree_path_free (column->priv->initial_path);
     }
-
     column->priv->initial_path = gtk_tree_path_copy (path);
-    column->priv->realize_handler =
-      g_signal_connect_after (G_OBJECT (column->priv->panarea), "realize",
-                              G_CALLBACK (on_realize_cb),
-                              column);
+
+    if (column->priv->allocate_handler == 0) {
+      column->priv->allocate_handler =
+        g_signal_connect_after (G_OBJECT (column->priv->panarea), "size-allocate",
+                                G_CALLBACK (on_allocate_cb),
+                                column);
+    }
   }
 }
 
@@ -2446,30 +5428,22 @@ _hildon_touch_selector_center_on_selected_items (HildonTouchSelector *selector,
                                                  HildonTouchSelectorColumn *column)
 {
   GtkTreePath *path = NULL;
-  GList *selected_rows = NULL;
-  gint num_column = -1;
 
-  num_column = g_slist_index (selector->priv->columns, column);
+  hildon_touch_selector_column_attach (column);
 
-  selected_rows = hildon_touch_selector_get_selected_rows (selector, num_column);
-  if (selected_rows) {
-//    search_nearest_element (HILDON_PANNABLE_AREA (column->priv->panarea),
-    search_nearest_element (GTK_SCROLLED_WINDOW (column->priv->panarea),
-                             GTK_TREE_VIEW (column->priv->tree_view),
-                             selected_rows,
-                             &path);
+  if (gtk_tree_selection_count_selected_rows
+      (gtk_tree_view_get_selection (column->priv->tree_view)) == 0)
+    return TRUE;
 
-    if (path != NULL) {
-      hildon_touch_selector_scroll_to (column,
-                                       GTK_TREE_VIEW (column->priv->tree_view),
-                                       path);
-    } else {
-      return FALSE;
-    }
+  path = search_nearest_element (column);
 
-    g_list_foreach (selected_rows, (GFunc) (gtk_tree_path_free), NULL);
-    g_list_free (selected_rows);
-  }
+  if (path == NULL)
+    return FALSE;
+
+  hildon_touch_selector_scroll_to (column,
+                                   GTK_TREE_VIEW (column->priv->tree_view),
+                                   path);
+  gtk_tree_path_free (path);
 
   return TRUE;
 }
@@ -2534,7 +5508,7 @@ hildon_touch_selector_get_column (HildonTouchSelector * selector,
   num_columns = hildon_touch_selector_get_num_columns (selector);
   g_return_val_if_fail (column < num_columns && column >= 0, NULL);
 
-  return g_slist_nth_data (selector->priv->columns, column);
+  return NTH_COLUMN (selector, column);
 }
 
 
@@ -2566,13 +5540,13 @@ hildon_touch_selector_get_column (HildonTouchSelector * selector,
 void
 hildon_touch_selector_center_on_selected         (HildonTouchSelector *selector)
 {
-  GSList *iter = NULL;
+  guint i;
 
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
 
-  for (iter = selector->priv->columns; iter; iter = g_slist_next (iter)) {
+  for (i = 0; i < selector->priv->columns->len; i++) {
     _hildon_touch_selector_center_on_selected_items (selector,
-                                                    HILDON_TOUCH_SELECTOR_COLUMN (iter->data));
+                                                    NTH_COLUMN (selector, i));
   }
 }
 
@@ -2595,18 +5569,22 @@ hildon_touch_selector_get_preferred_height      (GtkWidget *widget,
                                                  gint      *minimal,
                                                  gint      *natural)
 {
-  GSList *iter = NULL;
+  HildonTouchSelector *selector;
+  guint i;
   gint height = 0;
   gint base_height = 0;
 
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (widget));
 
-  iter = HILDON_TOUCH_SELECTOR (widget)->priv->columns;
+  selector = HILDON_TOUCH_SELECTOR (widget);
+
+  /* Normally done already when the selector was added to a window */
+  hildon_touch_selector_attach_columns (selector);
 
   /* Default optimal values are the current ones */
   GTK_WIDGET_CLASS (hildon_touch_selector_parent_class)->get_preferred_height (widget, minimal, natural);
 
-  if (iter == NULL) {
+  if (selector->priv->columns->len == 0) {
     height = *natural;
   } else {
     /* we use the normal requisition as base, as the touch selector can has
@@ -2615,19 +5593,27 @@ hildon_touch_selector_get_preferred_height      (GtkWidget *widget,
   }
 
   /* Compute optimal height for the columns */
-  while (iter) {
+  for (i = 0; i < selector->priv->columns->len; i++) {
     HildonTouchSelectorColumn *column;
     GtkWidget *child;
     gint child_minimal, child_natural;
+    gint row_height;
 
-    column = HILDON_TOUCH_SELECTOR_COLUMN (iter->data);
+    column = NTH_COLUMN (selector, i);
     child = GTK_WIDGET (column->priv->tree_view);
 
-    gtk_widget_get_preferred_height (child, &child_minimal, &child_natural);
+    row_height = hildon_touch_selector_column_get_row_height (column);
+    if (row_height > 0) {
+      child_natural = row_height *
+        gtk_tree_model_iter_n_children (column->priv->filter, NULL);
+    } else if (selector->priv->height_limit > 0) {
+      child_natural = hildon_touch_selector_column_get_bounded_height
+        (column, selector->priv->height_limit);
+    } else {
+      gtk_widget_get_preferred_height (child, &child_minimal, &child_natural);
+    }
 
     height = MAX (height, child_natural);
-
-    iter = g_slist_next (iter);
   }
 
   *natural = base_height + height;
@@ -2708,7 +5694,8 @@ hildon_touch_selector_center_on_index (HildonTouchSelector *selector,
   g_return_if_fail ((column >= 0) && (column < hildon_touch_selector_get_num_columns (selector)));
   g_return_if_fail (index >= 0);
 
-  current_column = g_slist_nth_data (selector->priv->columns, column);
+  current_column = NTH_COLUMN (selector, column);
+  hildon_touch_selector_column_attach (current_column);
 
   path = gtk_tree_path_new_from_indices (index, -1);
 
@@ -2747,10 +5734,9 @@ hildon_touch_selector_set_live_search (HildonTouchSelector *selector,
     return;
 
   if (live_search) {
-    if (selector->priv->columns &&
-        selector->priv->columns->next == NULL) {
+    if (selector->priv->columns->len == 1) {
       /* There is one and only one column already.  */
-      col = (HildonTouchSelectorColumn *) selector->priv->columns->data;
+      col = NTH_COLUMN (selector, 0);
       /* There is already a livesearch widget. Let's hook it up.  */
       if (col->priv->livesearch) {
         hildon_live_search_widget_hook (HILDON_LIVE_SEARCH (col->priv->livesearch),
@@ -2760,16 +5746,14 @@ hildon_touch_selector_set_live_search (HildonTouchSelector *selector,
         /* There is no livesearch widget yet. Create one.  */
         hildon_touch_selector_add_live_search (selector, col);
       }
-    } else if (selector->priv->columns &&
-               selector->priv->columns->next != NULL) {
+    } else if (selector->priv->columns->len > 1) {
       g_critical ("Trying to set HildonTouchSelector::live-search to TRUE "
                   "in a HildonTouchSelector instance with more than one column.");
       return;
     }
   } else {
-    if (selector->priv->columns &&
-        selector->priv->columns->next == NULL) {
-        col = (HildonTouchSelectorColumn *) selector->priv->columns->data;
+    if (selector->priv->columns->len == 1) {
+        col = NTH_COLUMN (selector, 0);
         gtk_widget_hide (col->priv->livesearch);
         hildon_live_search_widget_unhook (HILDON_LIVE_SEARCH (col->priv->livesearch));
     }
@@ -2796,3 +5780,534 @@ hildon_touch_selector_get_live_search (HildonTouchSelector *selector)
 
   return selector->priv->has_live_search;
 }
+
+/**
+ * hildon_touch_selector_freeze_changed:
+ * @selector: a #HildonTouchSelector
+ *
+ * Increases the freeze count on @selector. While the freeze count is
+ * greater than zero, the #HildonTouchSelector::changed signal is not
+ * emitted; instead, the columns that changed are recorded and the
+ * signal is emitted once per changed column when the freeze count
+ * drops back to zero, see hildon_touch_selector_thaw_changed().
+ *
+ * This is useful when changing the selection of many rows at once,
+ * e.g. when restoring a multiple selection, since every emission
+ * makes the listeners (such as #HildonPickerButton) update their
+ * contents. Calls can be nested.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_freeze_changed (HildonTouchSelector *selector)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+
+  selector->priv->changed_freeze_count++;
+}
+
+/**
+ * hildon_touch_selector_thaw_changed:
+ * @selector: a #HildonTouchSelector
+ *
+ * Reverts the effect of a previous call to
+ * hildon_touch_selector_freeze_changed(). When the freeze count
+ * reaches zero, #HildonTouchSelector::changed is emitted once for
+ * each column that changed while @selector was frozen.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_thaw_changed (HildonTouchSelector *selector)
+{
+  HildonTouchSelectorPrivate *priv;
+  guint64 dirty;
+  gboolean dirty_high;
+  guint i;
+
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+
+  priv = selector->priv;
+
+  g_return_if_fail (priv->changed_freeze_count > 0);
+
+  if (--priv->changed_freeze_count > 0)
+    return;
+
+  dirty = priv->changed_dirty;
+  dirty_high = priv->changed_dirty_high;
+  priv->changed_dirty = 0;
+  priv->changed_dirty_high = FALSE;
+
+  if (dirty == 0 && !dirty_high)
+    return;
+
+  g_object_ref (selector);
+
+  hildon_touch_selector_clean_live_search_map (selector);
+
+  for (i = 0; dirty != 0; i++, dirty >>= 1) {
+    if (dirty & 1) {
+      HILDON_PERF (TOUCH_SELECTOR_CHANGED);
+      hildon_touch_selector_emit_selection_diff (selector, i);
+      g_signal_emit (selector, hildon_touch_selector_signals[CHANGED], 0, i);
+    }
+  }
+
+  if (dirty_high) {
+    for (i = 64; i < priv->columns->len; i++) {
+      HILDON_PERF (TOUCH_SELECTOR_CHANGED);
+      hildon_touch_selector_emit_selection_diff (selector, i);
+      g_signal_emit (selector, hildon_touch_selector_signals[CHANGED], 0, i);
+    }
+  }
+
+  g_object_unref (selector);
+}
+
+/**
+ * hildon_touch_selector_set_summary_limit:
+ * @selector: a #HildonTouchSelector
+ * @limit: the maximum number of items to list, or 0 for no limit
+ *
+ * Sets the maximum number of selected items that the default print
+ * function lists in multiple selection mode. When more items are
+ * selected, only the first @limit ones are listed, followed by the
+ * number of remaining items, as in "(A,B,C and 197 more)". This keeps
+ * hildon_touch_selector_get_current_text() from fetching the text of
+ * every selected row.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_set_summary_limit (HildonTouchSelector *selector,
+                                         gint limit)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+  g_return_if_fail (limit >= 0);
+
+  if (selector->priv->summary_limit == limit)
+    return;
+
+  selector->priv->summary_limit = limit;
+
+  if (selector->priv->columns->len > 0)
+    hildon_touch_selector_column_invalidate_print (NTH_COLUMN (selector, 0));
+
+  g_object_notify (G_OBJECT (selector), "summary-limit");
+}
+
+/**
+ * hildon_touch_selector_get_summary_limit:
+ * @selector: a #HildonTouchSelector
+ *
+ * Gets the value set by hildon_touch_selector_set_summary_limit().
+ *
+ * Returns: the maximum number of items listed, or 0 for no limit
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_touch_selector_get_summary_limit (HildonTouchSelector *selector)
+{
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), 0);
+
+  return selector->priv->summary_limit;
+}
+
+/**
+ * hildon_touch_selector_set_lazy_columns:
+ * @selector: a #HildonTouchSelector
+ * @lazy_columns: whether to fill the columns lazily
+ *
+ * Sets whether the columns appended to @selector from now on give
+ * their models to their tree views right away, or only when @selector
+ * is first added to a window. Lazy columns make creating a selector
+ * that may never be shown cheap, which matters for forms holding many
+ * #HildonPickerButton<!-- -->s, since their picker dialogs are only
+ * built when the buttons are clicked.
+ *
+ * The selection, the active item and the models of a lazy column can
+ * still be used normally before it is shown. A lazy column only keeps
+ * a single selected row until it is filled, and functions that need
+ * the tree view, such as hildon_touch_selector_center_on_index(),
+ * fill the column on demand.
+ *
+ * Setting @lazy_columns to %FALSE fills all the columns of @selector.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_set_lazy_columns (HildonTouchSelector *selector,
+                                        gboolean lazy_columns)
+{
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
+
+  lazy_columns = lazy_columns ? TRUE : FALSE;
+  if (selector->priv->lazy_columns == lazy_columns)
+    return;
+
+  selector->priv->lazy_columns = lazy_columns;
+
+  if (!lazy_columns)
+    hildon_touch_selector_attach_columns (selector);
+
+  g_object_notify (G_OBJECT (selector), "lazy-columns");
+}
+
+/**
+ * hildon_touch_selector_get_lazy_columns:
+ * @selector: a #HildonTouchSelector
+ *
+ * Gets the value set by hildon_touch_selector_set_lazy_columns().
+ *
+ * Returns: %TRUE if new columns of @selector are filled lazily
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_touch_selector_get_lazy_columns (HildonTouchSelector *selector)
+{
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), FALSE);
+
+  return selector->priv->lazy_columns;
+}
+
+/*
+ * The selected rows of every column are stored in a single array: for
+ * each row, its depth followed by its indices. For the usual list
+ * models this is two integers per selected row.
+ */
+struct _HildonTouchSelectorSnapshot
+{
+  gint n_columns;
+  gint *offsets;                /* n_columns + 1 offsets into rows */
+  gint *rows;
+};
+
+/**
+ * HildonTouchSelectorSnapshot:
+ *
+ * An opaque structure holding the selected rows of all the columns of
+ * a #HildonTouchSelector, see hildon_touch_selector_get_snapshot().
+ *
+ * Since: 3.0
+ **/
+G_DEFINE_BOXED_TYPE (HildonTouchSelectorSnapshot, hildon_touch_selector_snapshot,
+                     hildon_touch_selector_snapshot_copy,
+                     hildon_touch_selector_snapshot_free)
+
+static HildonTouchSelectorSnapshot *
+snapshot_new_take (GArray *offsets,
+                   GArray *rows)
+{
+  HildonTouchSelectorSnapshot *snapshot = g_slice_new (HildonTouchSelectorSnapshot);
+
+  snapshot->n_columns = offsets->len - 1;
+  snapshot->offsets = (gint *) g_array_free (offsets, FALSE);
+  snapshot->rows = (gint *) g_array_free (rows, FALSE);
+
+  return snapshot;
+}
+
+/**
+ * hildon_touch_selector_get_snapshot:
+ * @selector: a #HildonTouchSelector
+ *
+ * Saves the selected rows of all the columns of @selector. The snapshot
+ * can be applied later with hildon_touch_selector_apply_snapshot(), for
+ * instance to cancel the changes made by the user, and it can be
+ * stored across sessions with hildon_touch_selector_snapshot_to_string().
+ *
+ * Rows are identified by their position in the models, so a snapshot is
+ * only meaningful for models with the same rows.
+ *
+ * Returns: a new #HildonTouchSelectorSnapshot, free it with
+ * hildon_touch_selector_snapshot_free()
+ *
+ * Since: 3.0
+ **/
+HildonTouchSelectorSnapshot *
+hildon_touch_selector_get_snapshot (HildonTouchSelector *selector)
+{
+  GArray *offsets, *rows;
+  gint n_columns;
+  gint i, j;
+
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), NULL);
+
+  n_columns = hildon_touch_selector_get_num_columns (selector);
+  offsets = g_array_sized_new (FALSE, FALSE, sizeof (gint), n_columns + 1);
+  rows = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  for (i = 0; i < n_columns; i++) {
+    GtkTreeModel *model = hildon_touch_selector_get_model (selector, i);
+
+    g_array_append_val (offsets, rows->len);
+
+    if (gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY) {
+      gint *indices;
+      gint n_indices;
+      gint depth = 1;
+
+      indices = hildon_touch_selector_get_selected_indices (selector, i, &n_indices);
+      for (j = 0; j < n_indices; j++) {
+        g_array_append_val (rows, depth);
+        g_array_append_val (rows, indices[j]);
+      }
+      g_free (indices);
+    } else {
+      GList *selected, *iter;
+
+      selected = hildon_touch_selector_get_selected_rows (selector, i);
+      for (iter = selected; iter; iter = iter->next) {
+        gint depth;
+        gint *indices = gtk_tree_path_get_indices_with_depth (iter->data, &depth);
+
+        g_array_append_val (rows, depth);
+        g_array_append_vals (rows, indices, depth);
+        gtk_tree_path_free (iter->data);
+      }
+      g_list_free (selected);
+    }
+  }
+  g_array_append_val (offsets, rows->len);
+
+  return snapshot_new_take (offsets, rows);
+}
+
+/**
+ * hildon_touch_selector_apply_snapshot:
+ * @selector: a #HildonTouchSelector
+ * @snapshot: a #HildonTouchSelectorSnapshot
+ *
+ * Replaces the selection of every column of @selector by the one saved
+ * in @snapshot. #HildonTouchSelector::changed is emitted at most once
+ * per column, after the whole snapshot has been applied. Rows that do
+ * not exist anymore are ignored.
+ *
+ * Returns: %TRUE if @snapshot was applied, %FALSE if it was taken from
+ * a selector with a different number of columns
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_touch_selector_apply_snapshot (HildonTouchSelector *selector,
+                                      const HildonTouchSelectorSnapshot *snapshot)
+{
+  gint i;
+
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), FALSE);
+  g_return_val_if_fail (snapshot != NULL, FALSE);
+
+  if (snapshot->n_columns != hildon_touch_selector_get_num_columns (selector))
+    return FALSE;
+
+  hildon_touch_selector_freeze_changed (selector);
+
+  for (i = 0; i < snapshot->n_columns; i++) {
+    GtkTreeModel *model = hildon_touch_selector_get_model (selector, i);
+    gint start = snapshot->offsets[i];
+    gint end = snapshot->offsets[i + 1];
+    gboolean flat = TRUE;
+    gint pos;
+
+    for (pos = start; pos < end; pos += snapshot->rows[pos] + 1) {
+      if (snapshot->rows[pos] != 1) {
+        flat = FALSE;
+        break;
+      }
+    }
+
+    if (flat && (gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY)) {
+      gint n_indices = (end - start) / 2;
+      gint *indices = g_new (gint, n_indices + 1);
+      gint j;
+
+      for (j = 0; j < n_indices; j++)
+        indices[j] = snapshot->rows[start + 2 * j + 1];
+
+      hildon_touch_selector_set_selected_indices (selector, i, indices, n_indices);
+      g_free (indices);
+    } else {
+      hildon_touch_selector_unselect_all (selector, i);
+
+      for (pos = start; pos < end; pos += snapshot->rows[pos] + 1) {
+        GtkTreePath *path;
+        GtkTreeIter iter;
+
+        path = gtk_tree_path_new_from_indicesv (&snapshot->rows[pos + 1],
+                                                snapshot->rows[pos]);
+        if (gtk_tree_model_get_iter (model, &iter, path))
+          hildon_touch_selector_select_iter (selector, i, &iter, FALSE);
+        gtk_tree_path_free (path);
+      }
+    }
+  }
+
+  hildon_touch_selector_thaw_changed (selector);
+
+  return TRUE;
+}
+
+/**
+ * hildon_touch_selector_snapshot_copy:
+ * @snapshot: a #HildonTouchSelectorSnapshot
+ *
+ * Copies a #HildonTouchSelectorSnapshot.
+ *
+ * Returns: a new #HildonTouchSelectorSnapshot
+ *
+ * Since: 3.0
+ **/
+HildonTouchSelectorSnapshot *
+hildon_touch_selector_snapshot_copy (const HildonTouchSelectorSnapshot *snapshot)
+{
+  HildonTouchSelectorSnapshot *copy;
+
+  g_return_val_if_fail (snapshot != NULL, NULL);
+
+  copy = g_slice_new (HildonTouchSelectorSnapshot);
+  copy->n_columns = snapshot->n_columns;
+  copy->offsets = g_new (gint, snapshot->n_columns + 1);
+  memcpy (copy->offsets, snapshot->offsets,
+          (snapshot->n_columns + 1) * sizeof (gint));
+  copy->rows = g_new (gint, snapshot->offsets[snapshot->n_columns]);
+  memcpy (copy->rows, snapshot->rows,
+          snapshot->offsets[snapshot->n_columns] * sizeof (gint));
+
+  return copy;
+}
+
+/**
+ * hildon_touch_selector_snapshot_free:
+ * @snapshot: a #HildonTouchSelectorSnapshot
+ *
+ * Frees a #HildonTouchSelectorSnapshot.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_touch_selector_snapshot_free (HildonTouchSelectorSnapshot *snapshot)
+{
+  if (snapshot == NULL)
+    return;
+
+  g_free (snapshot->offsets);
+  g_free (snapshot->rows);
+  g_slice_free (HildonTouchSelectorSnapshot, snapshot);
+}
+
+/**
+ * hildon_touch_selector_snapshot_to_string:
+ * @snapshot: a #HildonTouchSelectorSnapshot
+ *
+ * Serializes @snapshot into a string suitable for storing it in a
+ * configuration file. Every column is terminated by a semicolon, and
+ * its rows, written as #GtkTreePath strings, are separated by commas:
+ * "3;0,4,7;" is a snapshot of two columns.
+ *
+ * Returns: a newly allocated string
+ *
+ * Since: 3.0
+ **/
+gchar *
+hildon_touch_selector_snapshot_to_string (const HildonTouchSelectorSnapshot *snapshot)
+{
+  GString *string;
+  gint i, pos, j;
+
+  g_return_val_if_fail (snapshot != NULL, NULL);
+
+  string = g_string_sized_new (snapshot->offsets[snapshot->n_columns] * 2 + snapshot->n_columns);
+
+  for (i = 0; i < snapshot->n_columns; i++) {
+    for (pos = snapshot->offsets[i]; pos < snapshot->offsets[i + 1];
+         pos += snapshot->rows[pos] + 1) {
+      if (pos > snapshot->offsets[i])
+        g_string_append_c (string, ',');
+      for (j = 1; j <= snapshot->rows[pos]; j++) {
+        if (j > 1)
+          g_string_append_c (string, ':');
+        g_string_append_printf (string, "%d", snapshot->rows[pos + j]);
+      }
+    }
+    g_string_append_c (string, ';');
+  }
+
+  return g_string_free (string, FALSE);
+}
+
+/**
+ * hildon_touch_selector_snapshot_new_from_string:
+ * @string: a string returned by hildon_touch_selector_snapshot_to_string()
+ *
+ * Creates a #HildonTouchSelectorSnapshot from its serialized form.
+ *
+ * Returns: a new #HildonTouchSelectorSnapshot, or %NULL if @string is
+ * not a valid serialized snapshot
+ *
+ * Since: 3.0
+ **/
+HildonTouchSelectorSnapshot *
+hildon_touch_selector_snapshot_new_from_string (const gchar *string)
+{
+  GArray *offsets, *rows;
+  const gchar *p;
+  gint zero = 0;
+
+  g_return_val_if_fail (string != NULL, NULL);
+
+  offsets = g_array_new (FALSE, FALSE, sizeof (gint));
+  rows = g_array_new (FALSE, FALSE, sizeof (gint));
+  g_array_append_val (offsets, zero);
+
+  for (p = string; *p != '\0'; p++) {
+    /* A column: rows separated by commas, terminated by a semicolon */
+    while (*p != ';') {
+      guint depth_pos = rows->len;
+
+      g_array_append_val (rows, zero);
+
+      /* A row: indices separated by colons */
+      for (;;) {
+        gchar *end;
+        gint64 value;
+        gint index;
+
+        if (!g_ascii_isdigit (*p))
+          goto error;
+
+        value = g_ascii_strtoll (p, &end, 10);
+        if (value > G_MAXINT)
+          goto error;
+
+        index = (gint) value;
+        g_array_append_val (rows, index);
+        g_array_index (rows, gint, depth_pos)++;
+
+        p = end;
+        if (*p != ':')
+          break;
+        p++;
+      }
+
+      if (*p == ',') {
+        p++;
+        if (!g_ascii_isdigit (*p))
+          goto error;
+      } else if (*p != ';') {
+        goto error;
+      }
+    }
+
+    g_array_append_val (offsets, rows->len);
+  }
+
+  return snapshot_new_take (offsets, rows);
+
+error:
+  g_array_free (offsets, TRUE);
+  g_array_free (rows, TRUE);
+  return NULL;
+}
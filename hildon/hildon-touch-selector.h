@@ -51,10 +51,20 @@ G_BEGIN_DECLS
 typedef struct                                  _HildonTouchSelector HildonTouchSelector;
 typedef struct                                  _HildonTouchSelectorClass HildonTouchSelectorClass;
 typedef struct                                  _HildonTouchSelectorPrivate HildonTouchSelectorPrivate;
+typedef struct                                  _HildonTouchSelectorSnapshot HildonTouchSelectorSnapshot;
+
+#define                                         HILDON_TYPE_TOUCH_SELECTOR_SNAPSHOT \
+                                                (hildon_touch_selector_snapshot_get_type ())
 
 typedef gchar *(*HildonTouchSelectorPrintFunc)  (HildonTouchSelector * selector,
                                                  gpointer user_data);
 
+typedef gchar *(*HildonTouchSelectorRowFunc)    (gint row,
+                                                 gpointer user_data);
+
+typedef gchar **(*HildonTouchSelectorLoadFunc)  (GCancellable *cancellable,
+                                                 gpointer user_data);
+
 struct                                          _HildonTouchSelector
 {
   GtkBox parent_instance;
@@ -103,10 +113,20 @@ hildon_touch_selector_new                       (void);
 GtkWidget *
 hildon_touch_selector_new_text                  (void);
 
+GtkWidget *
+hildon_touch_selector_new_text_compact          (void);
+
+GtkWidget *
+hildon_touch_selector_new_text_sorted           (void);
+
 void
 hildon_touch_selector_append_text               (HildonTouchSelector *selector,
                                                  const gchar         *text);
 void
+hildon_touch_selector_append_text_array         (HildonTouchSelector *selector,
+                                                 const gchar * const *texts,
+                                                 gint                 n_texts);
+void
 hildon_touch_selector_prepend_text              (HildonTouchSelector *selector,
                                                  const gchar         *text);
 void
@@ -126,6 +146,34 @@ hildon_touch_selector_append_column             (HildonTouchSelector *selector,
                                                  GtkCellRenderer     *cell_renderer,
                                                  ...);
 
+HildonTouchSelectorColumn*
+hildon_touch_selector_append_virtual_column     (HildonTouchSelector        *selector,
+                                                 gint                        n_rows,
+                                                 HildonTouchSelectorRowFunc  func,
+                                                 gpointer                    user_data,
+                                                 GDestroyNotify              destroy,
+                                                 gboolean                    center);
+
+void
+hildon_touch_selector_set_virtual_n_rows        (HildonTouchSelector *selector,
+                                                 gint                 column,
+                                                 gint                 n_rows);
+
+void
+hildon_touch_selector_load_text_column_async    (HildonTouchSelector         *selector,
+                                                 gint                         column,
+                                                 HildonTouchSelectorLoadFunc  func,
+                                                 gpointer                     func_data,
+                                                 GDestroyNotify               destroy,
+                                                 GCancellable                *cancellable,
+                                                 GAsyncReadyCallback          callback,
+                                                 gpointer                     user_data);
+
+gboolean
+hildon_touch_selector_load_text_column_finish   (HildonTouchSelector *selector,
+                                                 GAsyncResult        *result,
+                                                 GError             **error);
+
 gboolean
 hildon_touch_selector_remove_column             (HildonTouchSelector *selector,
                                                  gint                 column);
@@ -176,6 +224,31 @@ hildon_touch_selector_unselect_all              (HildonTouchSelector * selector,
 GList *
 hildon_touch_selector_get_selected_rows         (HildonTouchSelector *selector,
                                                  gint                 column);
+
+gint *
+hildon_touch_selector_get_selected_indices      (HildonTouchSelector *selector,
+                                                 gint                 column,
+                                                 gint                *n_indices);
+
+void
+hildon_touch_selector_set_selected_indices      (HildonTouchSelector *selector,
+                                                 gint                 column,
+                                                 const gint          *indices,
+                                                 gint                 n_indices);
+
+void
+hildon_touch_selector_select_range              (HildonTouchSelector *selector,
+                                                 gint                 column,
+                                                 gint                 first,
+                                                 gint                 last);
+
+void
+hildon_touch_selector_select_all                (HildonTouchSelector *selector,
+                                                 gint                 column);
+
+void
+hildon_touch_selector_invert_selection          (HildonTouchSelector *selector,
+                                                 gint                 column);
 /* model  */
 void
 hildon_touch_selector_set_model                 (HildonTouchSelector *selector,
@@ -202,12 +275,55 @@ hildon_touch_selector_set_print_func_full       (HildonTouchSelector          *s
 HildonTouchSelectorPrintFunc
 hildon_touch_selector_get_print_func            (HildonTouchSelector *selector);
 
+void
+hildon_touch_selector_set_summary_limit         (HildonTouchSelector *selector,
+                                                 gint                 limit);
+
+gint
+hildon_touch_selector_get_summary_limit         (HildonTouchSelector *selector);
+
+void
+hildon_touch_selector_set_lazy_columns          (HildonTouchSelector *selector,
+                                                 gboolean             lazy_columns);
+
+gboolean
+hildon_touch_selector_get_lazy_columns          (HildonTouchSelector *selector);
+
+/* selection snapshots */
+GType
+hildon_touch_selector_snapshot_get_type         (void) G_GNUC_CONST;
+
+HildonTouchSelectorSnapshot *
+hildon_touch_selector_get_snapshot              (HildonTouchSelector *selector);
+
+gboolean
+hildon_touch_selector_apply_snapshot            (HildonTouchSelector               *selector,
+                                                 const HildonTouchSelectorSnapshot *snapshot);
+
+HildonTouchSelectorSnapshot *
+hildon_touch_selector_snapshot_copy             (const HildonTouchSelectorSnapshot *snapshot);
+
+void
+hildon_touch_selector_snapshot_free             (HildonTouchSelectorSnapshot *snapshot);
+
+gchar *
+hildon_touch_selector_snapshot_to_string        (const HildonTouchSelectorSnapshot *snapshot);
+
+HildonTouchSelectorSnapshot *
+hildon_touch_selector_snapshot_new_from_string  (const gchar *string);
+
 gboolean
 hildon_touch_selector_has_multiple_selection    (HildonTouchSelector *selector);
 
 void
 hildon_touch_selector_center_on_selected        (HildonTouchSelector *selector);
 
+void
+hildon_touch_selector_freeze_changed            (HildonTouchSelector *selector);
+
+void
+hildon_touch_selector_thaw_changed              (HildonTouchSelector *selector);
+
 void
 hildon_touch_selector_center_on_index           (HildonTouchSelector *selector,
                                                  gint column,
@@ -33,6 +33,17 @@ G_BEGIN_DECLS
 
 typedef struct                                  _HildonWindowPrivate HildonWindowPrivate;
 
+/* Where the parts of the window went the last time it was allocated
+ * in one orientation */
+typedef struct
+{
+    gboolean valid;
+    GtkAllocation window;
+    GtkAllocation edit_toolbar;
+    GtkAllocation toolbars;
+    GtkAllocation child;
+} HildonWindowLayout;
+
 struct                                          _HildonWindowPrivate
 {
     GtkMenu *menu;
@@ -40,9 +51,6 @@ struct                                          _HildonWindowPrivate
     GtkWidget *vbox;
     GtkWidget *edit_toolbar;
 
-    GtkBorder *borders;
-    GtkBorder *toolbar_borders;
-
     GtkAllocation allocation;
 
     gchar *markup;
@@ -52,6 +60,19 @@ struct                                          _HildonWindowPrivate
     gint visible_toolbars;
     gint previous_vbox_y;
 
+    /* Rendered borders and toolbar backgrounds, one
+       HildonWindowChromeStrip each, and what they depend on */
+    GArray *chrome;
+    gint chrome_width;
+    gint chrome_height;
+    gint chrome_box_height;
+    gint chrome_toolbars;
+    guint chrome_fullscreen;
+
+    /* Indexed by whether the window is portrait */
+    guint keep_layouts : 1;
+    HildonWindowLayout layouts[2];
+
     HildonProgram *program;
 };
 
@@ -80,6 +101,19 @@ hildon_window_update_topmost                    (HildonWindow *self,
 Window G_GNUC_INTERNAL
 hildon_window_get_active_window                 (void);
 
+Window G_GNUC_INTERNAL
+hildon_window_get_active_window_group           (void);
+
+typedef void (*HildonActiveWindowFunc)          (gpointer data);
+
+void G_GNUC_INTERNAL
+hildon_window_watch_active_window               (HildonActiveWindowFunc func,
+                                                 gpointer data);
+
+void G_GNUC_INTERNAL
+hildon_window_unwatch_active_window             (HildonActiveWindowFunc func,
+                                                 gpointer data);
+
 void G_GNUC_INTERNAL
 hildon_window_update_title                      (HildonWindow *window);
 
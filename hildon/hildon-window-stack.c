@@ -49,18 +49,53 @@
  * For more complex layout changes, applications can push and/or pop
  * several windows at the same time in a single step. See
  * hildon_window_stack_push(), hildon_window_stack_pop() and
- * hildon_window_stack_pop_and_push() for more details.
+ * hildon_window_stack_pop_and_push() for more details. Arbitrary
+ * sequences of pushes and pops can also be grouped into a single
+ * transition with hildon_window_stack_begin_update() and
+ * hildon_window_stack_commit_update().
+ *
+ * Applications that navigate through many windows can ask a stack to
+ * keep a pool of windows created and realized in advance with
+ * hildon_window_stack_set_pool_size(). hildon_window_stack_new_window()
+ * then hands out one of those windows, and
+ * hildon_window_stack_release_window() returns a window that is no
+ * longer needed to the pool, so pushing a window does not have to wait
+ * for its X window to be created.
+ *
+ * Code that follows the navigation, like breadcrumbs, can connect to
+ * #HildonWindowStack::stack-changed to be told which windows were
+ * pushed and popped, and walk the stack with hildon_window_stack_size()
+ * and hildon_window_stack_get_nth() without copying it.
  */
 
 #include                                        "hildon-window-stack.h"
 #include                                        "hildon-window-stack-private.h"
 #include                                        "hildon-stackable-window-private.h"
+#include                                        "hildon-window-private.h"
+#include                                        "hildon-private.h"
+#include                                        "hildon-marshalers.h"
 
 struct                                          _HildonWindowStackPrivate
 {
-    GList *list;
+    GPtrArray *windows; /* Stacked windows, bottom-most first */
     GtkWindowGroup *group;
     GdkWindow *leader; /* X Window group hint for all windows in a group */
+    guint update_depth;
+    guint relink_from; /* Lowest index whose transient parent may be stale */
+    gint topmost_position; /* Position of the topmost window when the update began */
+    GList *shown; /* Windows pushed during the current update, topmost first */
+    GList *hidden; /* Windows popped during the current update, topmost last */
+    gboolean remapping;
+    GQueue pool; /* Realized, unstacked windows ready to be handed out */
+    guint pool_size;
+    guint pool_fill_id;
+    gboolean destroy_later;
+    GQueue dying; /* Closed windows waiting to be destroyed, oldest first */
+    guint dying_id;
+    guint hibernate_depth;
+    guint hibernate_id;
+    guint changed_from; /* Lowest index changed since "stack-changed", G_MAXUINT if none */
+    GPtrArray *changed_old; /* The windows that were at changed_from and above then */
 };
 
 #define                                         HILDON_WINDOW_STACK_GET_PRIVATE(obj) \
@@ -73,6 +108,13 @@ enum {
     PROP_GROUP = 1,
 };
 
+enum {
+    STACK_CHANGED,
+    LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
 static void
 hildon_window_stack_set_window_group             (HildonWindowStack *stack,
                                                   GtkWindowGroup    *group)
@@ -150,7 +192,7 @@ hildon_window_stack_size                        (HildonWindowStack *stack)
 {
     g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), 0);
 
-    return g_list_length (stack->priv->list);
+    return stack->priv->windows->len;
 }
 
 static GdkWindow *
@@ -191,6 +233,156 @@ hildon_window_stack_window_realized             (GtkWidget         *win,
     gdk_window_set_group (gtk_widget_get_window (win), leader);
 }
 
+/* Hibernates the windows buried at least @depth levels deep */
+static void
+hildon_window_stack_hibernate_below             (HildonWindowStack *stack,
+                                                 guint              depth)
+{
+    GPtrArray *windows = stack->priv->windows;
+    guint i;
+
+    for (i = 0; i + depth < windows->len; i++)
+        hildon_stackable_window_hibernate (g_ptr_array_index (windows, i));
+}
+
+static gboolean
+hildon_window_stack_hibernate_idle              (gpointer data)
+{
+    HildonWindowStack *stack = data;
+
+    stack->priv->hibernate_id = 0;
+    hildon_window_stack_hibernate_below (stack, stack->priv->hibernate_depth);
+
+    return FALSE;
+}
+
+/* Windows are hibernated once the stack has settled, so that the
+ * "hibernate" handlers never delay a transition */
+static void
+hildon_window_stack_queue_hibernate             (HildonWindowStack *stack)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+
+    if (priv->hibernate_depth > 0 && priv->hibernate_depth < priv->windows->len &&
+        priv->hibernate_id == 0)
+        priv->hibernate_id = gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                                        hildon_window_stack_hibernate_idle,
+                                                        stack, NULL);
+}
+
+/* Under memory pressure, hibernate every buried window */
+static void
+hildon_window_stack_purge_buried                (HildonWindowStack *stack)
+{
+    hildon_window_stack_hibernate_below (stack, 1);
+}
+
+/* Remembers the windows at @index and above before they are changed,
+ * the ones above the lowest change already are */
+static void
+hildon_window_stack_record_change               (HildonWindowStack *stack,
+                                                 guint              index)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+    guint upto = MIN (priv->changed_from, priv->windows->len);
+    guint i;
+
+    if (index >= upto) {
+        priv->changed_from = MIN (priv->changed_from, index);
+        return;
+    }
+
+    if (priv->changed_old == NULL)
+        priv->changed_old = g_ptr_array_new_with_free_func (g_object_unref);
+
+    for (i = upto; i > index; i--) {
+        g_ptr_array_insert (priv->changed_old, 0,
+                            g_object_ref (g_ptr_array_index (priv->windows, i - 1)));
+    }
+
+    priv->changed_from = index;
+}
+
+/* Emits "stack-changed" with the windows that differ from the last
+ * emission, skipping the ones that were popped and pushed back */
+static void
+hildon_window_stack_emit_changed                (HildonWindowStack *stack)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+    GPtrArray *old = priv->changed_old;
+    guint from = priv->changed_from;
+    guint i, j;
+
+    if (from == G_MAXUINT)
+        return;
+
+    priv->changed_from = G_MAXUINT;
+    priv->changed_old = NULL;
+
+    for (i = 0; old && i < old->len && from + i < priv->windows->len; i++) {
+        if (g_ptr_array_index (old, i) != g_ptr_array_index (priv->windows, from + i))
+            break;
+    }
+
+    if ((old == NULL || i == old->len) && from + i >= priv->windows->len) {
+        /* Nothing changed in the end */
+    } else if (g_signal_has_handler_pending (stack, signals[STACK_CHANGED], 0, FALSE)) {
+        GPtrArray *popped = g_ptr_array_new ();
+        GPtrArray *pushed = g_ptr_array_new ();
+
+        for (j = i; old && j < old->len; j++)
+            g_ptr_array_add (popped, g_ptr_array_index (old, j));
+        for (j = from + i; j < priv->windows->len; j++)
+            g_ptr_array_add (pushed, g_ptr_array_index (priv->windows, j));
+
+        g_signal_emit (stack, signals[STACK_CHANGED], 0, from + i, popped, pushed);
+
+        g_ptr_array_unref (popped);
+        g_ptr_array_unref (pushed);
+    }
+
+    if (old)
+        g_ptr_array_unref (old);
+}
+
+/* Make every window from @index upwards transient for the one below
+ * it, as the windows in between might have changed. */
+static void
+hildon_window_stack_relink                      (HildonWindowStack *stack)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+    guint i;
+
+    for (i = priv->relink_from; i < priv->windows->len; i++) {
+        GtkWindow *win = g_ptr_array_index (priv->windows, i);
+        GtkWindow *parent = i > 0 ? g_ptr_array_index (priv->windows, i - 1) : NULL;
+
+        if (gtk_window_get_transient_for (win) != parent)
+            gtk_window_set_transient_for (win, parent);
+    }
+
+    /* Only the topmost window is uncovered */
+    for (i = priv->relink_from > 0 ? priv->relink_from - 1 : 0; i < priv->windows->len; i++) {
+        hildon_stackable_window_set_buried (g_ptr_array_index (priv->windows, i),
+                                            i + 1 < priv->windows->len);
+    }
+
+    priv->relink_from = G_MAXUINT;
+
+    hildon_window_stack_queue_hibernate (stack);
+}
+
+static void
+hildon_window_stack_invalidate                  (HildonWindowStack *stack,
+                                                 guint              index)
+{
+    stack->priv->relink_from = MIN (stack->priv->relink_from, index);
+
+    /* Outside an update, apply the change straight away */
+    if (stack->priv->update_depth == 0)
+        hildon_window_stack_relink (stack);
+}
+
 /* Remove a window from its stack, no matter its position */
 void G_GNUC_INTERNAL
 hildon_window_stack_remove                      (HildonStackableWindow *win)
@@ -198,28 +390,35 @@ hildon_window_stack_remove                      (HildonStackableWindow *win)
     HildonWindowStack *stack = hildon_stackable_window_get_stack (win);
 
     /* If the window is stacked */
-    if (stack) {
-        GList *pos;
+    if (stack && !stack->priv->remapping) {
+        GPtrArray *windows = stack->priv->windows;
+        guint index = HILDON_STACKABLE_WINDOW_GET_PRIVATE (win)->stack_index;
+        guint i;
+
+        g_assert (index < windows->len && g_ptr_array_index (windows, index) == win);
+
+        hildon_window_stack_record_change (stack, index);
 
         hildon_stackable_window_set_stack (win, NULL, -1);
+        hildon_stackable_window_set_buried (win, FALSE);
         gtk_window_set_transient_for (GTK_WINDOW (win), NULL);
         if (gtk_widget_get_window (GTK_WIDGET (win))) {
             gdk_window_set_group (gtk_widget_get_window (GTK_WIDGET (win)), NULL);
         }
 
-        /* If the window removed is in the middle of the stack, update
-         * transiency of other windows */
-        pos = g_list_find (stack->priv->list, win);
-        g_assert (pos != NULL);
-        if (pos->prev) {
-            GtkWindow *upper = GTK_WINDOW (pos->prev->data);
-            GtkWindow *lower = pos->next ? GTK_WINDOW (pos->next->data) : NULL;
-            gtk_window_set_transient_for (upper, lower);
+        g_ptr_array_remove_index (windows, index);
+        for (i = index; i < windows->len; i++) {
+            HILDON_STACKABLE_WINDOW_GET_PRIVATE (g_ptr_array_index (windows, i))->stack_index = i;
         }
 
-        stack->priv->list = g_list_remove (stack->priv->list, win);
+        /* If the window removed is in the middle of the stack, update
+         * transiency of other windows */
+        hildon_window_stack_invalidate (stack, index);
 
         g_signal_handlers_disconnect_by_func (win, hildon_window_stack_window_realized, stack);
+
+        if (stack->priv->update_depth == 0)
+            hildon_window_stack_emit_changed (stack);
     }
 }
 
@@ -238,9 +437,16 @@ hildon_window_stack_remove                      (HildonStackableWindow *win)
 GList *
 hildon_window_stack_get_windows                 (HildonWindowStack *stack)
 {
+    GList *list = NULL;
+    guint i;
+
     g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), NULL);
 
-    return g_list_copy (stack->priv->list);
+    for (i = 0; i < stack->priv->windows->len; i++) {
+        list = g_list_prepend (list, g_ptr_array_index (stack->priv->windows, i));
+    }
+
+    return list;
 }
 
 /**
@@ -261,13 +467,44 @@ hildon_window_stack_peek                        (HildonWindowStack *stack)
 
     g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), NULL);
 
-    if (stack->priv->list != NULL) {
-        win = GTK_WIDGET (stack->priv->list->data);
+    if (stack->priv->windows->len > 0) {
+        win = g_ptr_array_index (stack->priv->windows, stack->priv->windows->len - 1);
     }
 
     return win;
 }
 
+/**
+ * hildon_window_stack_get_nth:
+ * @stack: A %HildonWindowStack
+ * @n: the position of the window, from 0 for the topmost one to
+ * hildon_window_stack_size() - 1 for the bottom-most one
+ *
+ * Returns the window at position @n in @stack, counting from the top
+ * like hildon_window_stack_get_windows(). Together with
+ * hildon_window_stack_size(), it walks the stack without copying it.
+ *
+ * Return value: (transfer none): the window at position @n, or %NULL
+ * if @n is out of range.
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_window_stack_get_nth                     (HildonWindowStack *stack,
+                                                 gint               n)
+{
+    GPtrArray *windows;
+
+    g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), NULL);
+
+    windows = stack->priv->windows;
+
+    if (n < 0 || (guint) n >= windows->len)
+        return NULL;
+
+    return g_ptr_array_index (windows, windows->len - 1 - n);
+}
+
 /* This function does everything to push a window to the stack _but_
  * actually calling gtk_widget_show().
  * It's up to each specific push function to decide the order in which
@@ -292,15 +529,16 @@ _hildon_window_stack_do_push                    (HildonWindowStack     *stack,
         }
 
         /* Push the window */
+        hildon_window_stack_record_change (stack, stack->priv->windows->len);
         hildon_stackable_window_set_stack (win, stack, pos);
-        stack->priv->list = g_list_prepend (stack->priv->list, win);
+        HILDON_STACKABLE_WINDOW_GET_PRIVATE (win)->stack_index = stack->priv->windows->len;
+        g_ptr_array_add (stack->priv->windows, win);
 
         /* Make the window part of the same group as its parent */
-        if (parent) {
-            gtk_window_set_transient_for (GTK_WINDOW (win), GTK_WINDOW (parent));
-        } else {
+        if (!parent) {
             gtk_window_group_add_window (stack->priv->group, GTK_WINDOW (win));
         }
+        hildon_window_stack_invalidate (stack, stack->priv->windows->len - 1);
 
         /* Set window group */
         if (gtk_widget_get_realized (GTK_WIDGET (win))) {
@@ -311,6 +549,9 @@ _hildon_window_stack_do_push                    (HildonWindowStack     *stack,
                               stack);
         }
 
+        if (stack->priv->update_depth == 0)
+            hildon_window_stack_emit_changed (stack);
+
         return TRUE;
     } else {
         g_warning ("Trying to push a window that is already on a stack");
@@ -329,6 +570,165 @@ _hildon_window_stack_do_pop                     (HildonWindowStack *stack)
     return win;
 }
 
+/* Pushes @win and shows it when the current update is committed */
+static void
+hildon_window_stack_update_push                 (HildonWindowStack     *stack,
+                                                 HildonStackableWindow *win)
+{
+    HILDON_PROBE2 (window_stack__push, stack, win);
+
+    if (_hildon_window_stack_do_push (stack, win))
+        stack->priv->shown = g_list_prepend (stack->priv->shown, win);
+}
+
+/* Pops the topmost window and hides it when the current update is
+ * committed */
+static GtkWidget *
+hildon_window_stack_update_pop                  (HildonWindowStack *stack)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+    GtkWidget *win = _hildon_window_stack_do_pop (stack);
+
+    HILDON_PROBE2 (window_stack__pop, stack, win);
+
+    if (win) {
+        GList *l = g_list_find (priv->shown, win);
+
+        /* A window pushed during this update has not been shown yet */
+        if (l != NULL) {
+            priv->shown = g_list_delete_link (priv->shown, l);
+        } else if (g_list_find (priv->hidden, win) == NULL) {
+            priv->hidden = g_list_prepend (priv->hidden, win);
+        }
+    }
+
+    return win;
+}
+
+/**
+ * hildon_window_stack_begin_update:
+ * @stack: A %HildonWindowStack
+ *
+ * Starts a group of changes to @stack. Until the matching
+ * hildon_window_stack_commit_update(), windows pushed to or popped
+ * from the stack with the #HildonWindowStack functions are not shown or
+ * hidden, and the transiency of the stacked windows is not updated.
+ * All of that is done once when the update is committed, so any
+ * sequence of pushes and pops is done in a single transition.
+ *
+ * Calls may be nested; the changes are applied when the outermost
+ * update is committed.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_window_stack_begin_update                (HildonWindowStack *stack)
+{
+    HildonWindowStackPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
+
+    priv = stack->priv;
+
+    if (priv->update_depth++ == 0) {
+        GtkWidget *topmost = hildon_window_stack_peek (stack);
+
+        priv->topmost_position = topmost ?
+            HILDON_STACKABLE_WINDOW_GET_PRIVATE (topmost)->stack_position : -1;
+    }
+}
+
+/**
+ * hildon_window_stack_commit_update:
+ * @stack: A %HildonWindowStack
+ *
+ * Ends a group of changes started with
+ * hildon_window_stack_begin_update(). When the outermost update is
+ * committed, the windows pushed since it began are shown (topmost
+ * first), then the popped windows are hidden, so the user will only
+ * see the window that ends up on top of @stack.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_window_stack_commit_update               (HildonWindowStack *stack)
+{
+    HildonWindowStackPrivate *priv;
+    GList *l;
+    GList *shown;
+    GList *hidden;
+
+    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
+
+    priv = stack->priv;
+
+    g_return_if_fail (priv->update_depth > 0);
+
+    if (--priv->update_depth > 0)
+        return;
+
+    HILDON_PROBE1 (window_stack__commit__start, stack);
+    HILDON_WATCH_ENTER ("window-stack-commit");
+
+    shown = priv->shown;
+    hidden = priv->hidden;
+    priv->shown = NULL;
+    priv->hidden = NULL;
+
+    /*
+     * We need to call gdk_flush() because the application that called us might
+     * just shown some of the windows we manipulate, and if the GTK+ has not
+     * processed the MapNotify yet it will end up calling the XWithdrawWindow
+     * when we hide the window (and will actually not unmap it).
+     */
+    if (hidden != NULL)
+        gdk_flush ();
+
+    hildon_window_stack_relink (stack);
+
+    /* Windows that were popped and then pushed back are unmapped and
+       mapped again, so that all the windows that have a changed stack
+       index are mapped with the new one. */
+    priv->remapping = TRUE;
+    for (l = hidden; l != NULL; l = l->next) {
+        if (hildon_stackable_window_get_stack (l->data) == stack) {
+            gtk_widget_hide (GTK_WIDGET (l->data));
+        }
+    }
+    priv->remapping = FALSE;
+
+    if (shown != NULL) {
+        HildonStackableWindowPrivate *topmost;
+
+        /* The WM will be confused if the old topmost window and the new
+         * one have the same index, so make sure that they're different */
+        topmost = HILDON_STACKABLE_WINDOW_GET_PRIVATE (hildon_window_stack_peek (stack));
+        if (topmost->stack_position == priv->topmost_position) {
+            topmost->stack_position++;
+        }
+    }
+
+    /* Show windows in reverse order (topmost first) */
+    for (l = shown; l != NULL; l = l->next) {
+        gtk_widget_show (GTK_WIDGET (l->data));
+    }
+
+    /* Hide windows that are popped but not pushed back (topmost last) */
+    for (l = hidden; l != NULL; l = l->next) {
+        if (hildon_stackable_window_get_stack (l->data) == NULL) {
+            gtk_widget_hide (GTK_WIDGET (l->data));
+        }
+    }
+
+    g_list_free (shown);
+    g_list_free (hidden);
+
+    hildon_window_stack_emit_changed (stack);
+
+    HILDON_WATCH_LEAVE ("window-stack-commit");
+    HILDON_PROBE1 (window_stack__commit__end, stack);
+}
+
 /**
  * hildon_window_stack_push_1:
  * @stack: A %HildonWindowStack
@@ -343,8 +743,11 @@ void
 hildon_window_stack_push_1                      (HildonWindowStack     *stack,
                                                  HildonStackableWindow *win)
 {
-    if (_hildon_window_stack_do_push (stack, win))
-        gtk_widget_show (GTK_WIDGET (win));
+    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
+
+    hildon_window_stack_begin_update (stack);
+    hildon_window_stack_update_push (stack, win);
+    hildon_window_stack_commit_update (stack);
 }
 
 /**
@@ -362,9 +765,14 @@ hildon_window_stack_push_1                      (HildonWindowStack     *stack,
 GtkWidget *
 hildon_window_stack_pop_1                       (HildonWindowStack *stack)
 {
-    GtkWidget *win = _hildon_window_stack_do_pop (stack);
-    if (win)
-        gtk_widget_hide (win);
+    GtkWidget *win;
+
+    g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), NULL);
+
+    hildon_window_stack_begin_update (stack);
+    win = hildon_window_stack_update_pop (stack);
+    hildon_window_stack_commit_update (stack);
+
     return win;
 }
 
@@ -384,27 +792,23 @@ void
 hildon_window_stack_push_list                   (HildonWindowStack *stack,
                                                  GList             *list)
 {
-    HildonStackableWindow *win;
     GList *l;
-    GList *pushed = NULL;
 
     g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
 
+    hildon_window_stack_begin_update (stack);
+
     /* Stack all windows */
     for (l = list; l != NULL; l = g_list_next (l)) {
-        win = HILDON_STACKABLE_WINDOW (l->data);
+        HildonStackableWindow *win = HILDON_STACKABLE_WINDOW (l->data);
         if (win) {
-            _hildon_window_stack_do_push (stack, win);
-            pushed = g_list_prepend (pushed, win);
+            hildon_window_stack_update_push (stack, win);
         } else {
             g_warning ("Trying to stack a non-stackable window!");
         }
     }
 
-    /* Show windows in reverse order (topmost first) */
-    g_list_foreach (pushed, (GFunc) gtk_widget_show, NULL);
-
-    g_list_free (pushed);
+    hildon_window_stack_commit_update (stack);
 }
 
 /**
@@ -464,27 +868,7 @@ hildon_window_stack_pop                         (HildonWindowStack  *stack,
                                                  gint                nwindows,
                                                  GList             **popped_windows)
 {
-    gint i;
-    GList *popped = NULL;
-
-    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
-    g_return_if_fail (nwindows > 0);
-    g_return_if_fail (g_list_length (stack->priv->list) >= nwindows);
-
-    /* Pop windows */
-    for (i = 0; i < nwindows; i++) {
-        GtkWidget *win = _hildon_window_stack_do_pop (stack);
-        popped = g_list_prepend (popped, win);
-    }
-
-    /* Hide windows in reverse order (topmost last) */
-    g_list_foreach (popped, (GFunc) gtk_widget_hide, NULL);
-
-    if (popped_windows) {
-        *popped_windows = popped;
-    } else {
-        g_list_free (popped);
-    }
+    hildon_window_stack_pop_and_push_list (stack, nwindows, popped_windows, NULL);
 }
 
 /**
@@ -511,71 +895,34 @@ hildon_window_stack_pop_and_push_list           (HildonWindowStack  *stack,
                                                  GList             **popped_windows,
                                                  GList              *list)
 {
-    gint i, topmost_index;
+    gint i;
     GList *l;
     GList *popped = NULL;
-    GList *pushed = NULL;
-    HildonStackableWindowPrivate *priv;
 
     g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
     g_return_if_fail (nwindows > 0);
-    g_return_if_fail (g_list_length (stack->priv->list) >= nwindows);
-
-    /*
-     * We need to call gdk_flush() because the application that called us might
-     * just shown some of the windows we manipulate, and if the GTK+ has not
-     * processed the MapNotify yet it will end up calling the XWithdrawWindow
-     * when we hide the window (and will actually not unmap it).
-     */
-    gdk_flush ();
+    g_return_if_fail (hildon_window_stack_size (stack) >= nwindows);
 
-    /* Store the index of the topmost window */
-    priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (hildon_window_stack_peek (stack));
-    topmost_index = priv->stack_position;
+    hildon_window_stack_begin_update (stack);
 
     /* Pop windows */
     for (i = 0; i < nwindows; i++) {
-        GtkWidget *win = _hildon_window_stack_do_pop (stack);
+        GtkWidget *win = hildon_window_stack_update_pop (stack);
         popped = g_list_prepend (popped, win);
-        /* Hide now windows that are popped and then pushed back.
-           This way all the windows that has a changed stack index
-           will be unmapped and mapped again. */
-        if (g_list_find (list, win) != NULL) {
-            gtk_widget_hide (win);
-        }
     }
 
     /* Push windows */
     for (l = list; l != NULL; l = g_list_next (l)) {
         HildonStackableWindow *win = HILDON_STACKABLE_WINDOW (l->data);
         if (win) {
-            _hildon_window_stack_do_push (stack, win);
-            pushed = g_list_prepend (pushed, win);
+            hildon_window_stack_update_push (stack, win);
         } else {
             g_warning ("Trying to stack a non-stackable window!");
         }
     }
 
-    if (pushed != NULL) {
-        /* The WM will be confused if the old topmost window and the new
-         * one have the same index, so make sure that they're different */
-        priv = HILDON_STACKABLE_WINDOW_GET_PRIVATE (hildon_window_stack_peek (stack));
-        if (priv->stack_position == topmost_index) {
-            priv->stack_position++;
-        }
-    }
-
-    /* Show windows in reverse order (topmost first) */
-    g_list_foreach (pushed, (GFunc) gtk_widget_show, NULL);
+    hildon_window_stack_commit_update (stack);
 
-    /* Hide windows that are popped but not pushed back (topmost last) */
-    for (l = popped; l != NULL; l = l->next) {
-        if (g_list_find (list, l->data) == NULL) {
-            gtk_widget_hide (GTK_WIDGET (l->data));
-        }
-    }
-
-    g_list_free (pushed);
     if (popped_windows) {
         *popped_windows = popped;
     } else {
@@ -628,14 +975,407 @@ hildon_window_stack_pop_and_push                (HildonWindowStack      *stack,
     g_list_free (list);
 }
 
+static gboolean
+hildon_window_stack_fill_pool                   (gpointer data)
+{
+    HildonWindowStack *stack = HILDON_WINDOW_STACK (data);
+    HildonWindowStackPrivate *priv = stack->priv;
+
+    if (priv->pool.length < priv->pool_size) {
+        GtkWidget *win = hildon_stackable_window_new ();
+
+        /* Realizing creates the X window and sets all its properties,
+         * but the window stays unmapped until it is pushed */
+        g_object_ref (win);
+        gtk_widget_realize (win);
+        g_queue_push_tail (&priv->pool, win);
+    }
+
+    if (priv->pool.length < priv->pool_size)
+        return TRUE;
+
+    priv->pool_fill_id = 0;
+    return FALSE;
+}
+
+static void
+hildon_window_stack_queue_fill_pool             (HildonWindowStack *stack)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+
+    /* Create one window per idle iteration, so that filling the pool
+     * never delays anything else */
+    if (priv->pool.length < priv->pool_size && priv->pool_fill_id == 0)
+        priv->pool_fill_id = gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                                        hildon_window_stack_fill_pool,
+                                                        stack, NULL);
+}
+
+static void
+hildon_window_stack_empty_pool                  (HildonWindowStack *stack,
+                                                 guint              length)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+
+    while (priv->pool.length > length) {
+        GtkWidget *win = g_queue_pop_tail (&priv->pool);
+        gtk_widget_destroy (win);
+        g_object_unref (win);
+    }
+}
+
+/* Under memory pressure, destroy the pooled windows. The pool is
+ * filled again the next time a window is taken from it. */
+static void
+hildon_window_stack_purge_pool                  (HildonWindowStack *stack)
+{
+    if (stack->priv->pool_fill_id) {
+        g_source_remove (stack->priv->pool_fill_id);
+        stack->priv->pool_fill_id = 0;
+    }
+
+    hildon_window_stack_empty_pool (stack, 0);
+}
+
+/**
+ * hildon_window_stack_set_pool_size:
+ * @stack: A %HildonWindowStack
+ * @size: Number of windows to keep ready
+ *
+ * Sets the number of #HildonStackableWindow<!-- -->s that @stack keeps
+ * created and realized in advance, to be handed out by
+ * hildon_window_stack_new_window(). The pool is filled from an idle
+ * handler, one window at a time. Setting @size to 0 (the default)
+ * destroys all the windows in the pool.
+ *
+ * The windows in the pool are destroyed when
+ * hildon_program_purge_caches() is called, and created again the next
+ * time a window is taken from the pool.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_window_stack_set_pool_size               (HildonWindowStack *stack,
+                                                 guint              size)
+{
+    HildonWindowStackPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
+
+    priv = stack->priv;
+
+    if (priv->pool_size == 0 && size > 0)
+        hildon_add_purge_func ((HildonPurgeFunc) hildon_window_stack_purge_pool, stack);
+    else if (priv->pool_size > 0 && size == 0)
+        hildon_remove_purge_func ((HildonPurgeFunc) hildon_window_stack_purge_pool, stack);
+
+    priv->pool_size = size;
+
+    hildon_window_stack_empty_pool (stack, size);
+    hildon_window_stack_queue_fill_pool (stack);
+}
+
+/**
+ * hildon_window_stack_get_pool_size:
+ * @stack: A %HildonWindowStack
+ *
+ * Returns the number of windows that @stack keeps ready. See
+ * hildon_window_stack_set_pool_size().
+ *
+ * Return value: the size of the pool of windows
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_window_stack_get_pool_size               (HildonWindowStack *stack)
+{
+    g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), 0);
+
+    return stack->priv->pool_size;
+}
+
+/**
+ * hildon_window_stack_new_window:
+ * @stack: A %HildonWindowStack
+ *
+ * Returns an empty #HildonStackableWindow to be pushed to @stack. If
+ * the pool of @stack has a window available, that window is already
+ * realized; otherwise a new window is created, as with
+ * hildon_stackable_window_new().
+ *
+ * Return value: A #HildonStackableWindow
+ *
+ * Since: 3.0
+ **/
+GtkWidget *
+hildon_window_stack_new_window                  (HildonWindowStack *stack)
+{
+    GtkWidget *win;
+
+    g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), NULL);
+
+    win = g_queue_pop_head (&stack->priv->pool);
+
+    if (win) {
+        /* From now on the window is owned by GTK+, like any toplevel */
+        g_object_unref (win);
+    } else {
+        win = hildon_stackable_window_new ();
+    }
+
+    hildon_window_stack_queue_fill_pool (stack);
+
+    return win;
+}
+
+/* Tears down one piece of the oldest closed window per iteration: its
+ * child first, then the window itself, so that no single iteration
+ * destroys a whole widget tree */
+static gboolean
+hildon_window_stack_destroy_dying               (gpointer data)
+{
+    HildonWindowStack *stack = data;
+    HildonWindowStackPrivate *priv = stack->priv;
+    GtkWidget *win = g_queue_peek_head (&priv->dying);
+    GtkWidget *child = gtk_bin_get_child (GTK_BIN (win));
+
+    if (child != NULL) {
+        gtk_widget_destroy (child);
+    } else {
+        g_queue_pop_head (&priv->dying);
+        gtk_widget_destroy (win);
+        g_object_unref (win);
+    }
+
+    if (priv->dying.length > 0)
+        return TRUE;
+
+    priv->dying_id = 0;
+    return FALSE;
+}
+
+/* Destroys @win, at once or in low priority idle iterations depending
+ * on hildon_window_stack_set_destroy_later() */
+void G_GNUC_INTERNAL
+hildon_window_stack_destroy_window              (HildonWindowStack     *stack,
+                                                 HildonStackableWindow *win)
+{
+    HildonWindowStackPrivate *priv = stack->priv;
+
+    if (!priv->destroy_later) {
+        gtk_widget_destroy (GTK_WIDGET (win));
+        return;
+    }
+
+    if (g_queue_find (&priv->dying, win))
+        return;
+
+    /* Hiding a window also removes it from its stack */
+    gtk_widget_hide (GTK_WIDGET (win));
+    g_queue_push_tail (&priv->dying, g_object_ref (win));
+
+    if (priv->dying_id == 0)
+        priv->dying_id = gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                                    hildon_window_stack_destroy_dying,
+                                                    stack, NULL);
+}
+
+/**
+ * hildon_window_stack_set_destroy_later:
+ * @stack: A %HildonWindowStack
+ * @destroy_later: whether to defer destroying closed windows
+ *
+ * Sets whether windows of @stack closed by the user, and windows given
+ * back with hildon_window_stack_release_window() that do not fit in the
+ * pool, are destroyed later instead of right away. Such windows are
+ * hidden at once, so the transition to the previous window starts
+ * immediately, and their widgets are destroyed from low priority idle
+ * iterations, a part at a time, once the transition no longer needs
+ * the CPU.
+ *
+ * The "destroy" signal of those windows is then emitted after the
+ * "delete-event" that closed them has returned.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_window_stack_set_destroy_later           (HildonWindowStack *stack,
+                                                 gboolean           destroy_later)
+{
+    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
+
+    stack->priv->destroy_later = destroy_later ? TRUE : FALSE;
+}
+
+/**
+ * hildon_window_stack_get_destroy_later:
+ * @stack: A %HildonWindowStack
+ *
+ * Returns whether @stack destroys closed windows later. See
+ * hildon_window_stack_set_destroy_later().
+ *
+ * Return value: %TRUE if closed windows are destroyed later
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_window_stack_get_destroy_later           (HildonWindowStack *stack)
+{
+    g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), FALSE);
+
+    return stack->priv->destroy_later;
+}
+
+/**
+ * hildon_window_stack_set_hibernate_depth:
+ * @stack: A %HildonWindowStack
+ * @depth: How deep a window must be buried to be hibernated, or 0
+ *
+ * Lets @stack free the memory used by windows that are buried deep in
+ * it. Once a window has at least @depth windows stacked on top of it,
+ * it gets the #HildonStackableWindow::hibernate signal, from an idle
+ * handler. A window whose handler saves its state has its child
+ * destroyed, and gets #HildonStackableWindow::wake-up to rebuild it
+ * when it is about to be uncovered. When hildon_program_purge_caches()
+ * is called, every buried window of @stack is asked to hibernate.
+ *
+ * Windows without a handler for #HildonStackableWindow::hibernate are
+ * left as they are. Setting @depth to 0 (the default) turns
+ * hibernation off; windows already hibernated wake up as usual.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_window_stack_set_hibernate_depth         (HildonWindowStack *stack,
+                                                 guint              depth)
+{
+    HildonWindowStackPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
+
+    priv = stack->priv;
+
+    if (priv->hibernate_depth == 0 && depth > 0)
+        hildon_add_purge_func ((HildonPurgeFunc) hildon_window_stack_purge_buried, stack);
+    else if (priv->hibernate_depth > 0 && depth == 0)
+        hildon_remove_purge_func ((HildonPurgeFunc) hildon_window_stack_purge_buried, stack);
+
+    priv->hibernate_depth = depth;
+
+    if (depth == 0 && priv->hibernate_id) {
+        g_source_remove (priv->hibernate_id);
+        priv->hibernate_id = 0;
+    }
+
+    hildon_window_stack_queue_hibernate (stack);
+}
+
+/**
+ * hildon_window_stack_get_hibernate_depth:
+ * @stack: A %HildonWindowStack
+ *
+ * Returns how deep windows of @stack must be buried to be hibernated.
+ * See hildon_window_stack_set_hibernate_depth().
+ *
+ * Return value: the hibernation depth, or 0 if it is off
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_window_stack_get_hibernate_depth         (HildonWindowStack *stack)
+{
+    g_return_val_if_fail (HILDON_IS_WINDOW_STACK (stack), 0);
+
+    return stack->priv->hibernate_depth;
+}
+
+/**
+ * hildon_window_stack_release_window:
+ * @stack: A %HildonWindowStack
+ * @win: A %HildonStackableWindow
+ *
+ * Tells @stack that @win is no longer needed. @win is removed from its
+ * stack if it is stacked, and emptied: its child, toolbars, menus and
+ * title are removed. If the pool of @stack is not full, the window is
+ * kept there to be handed out again by hildon_window_stack_new_window();
+ * otherwise it is destroyed. In both cases @win must not be used
+ * anymore after calling this function.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_window_stack_release_window              (HildonWindowStack     *stack,
+                                                 HildonStackableWindow *win)
+{
+    HildonWindowStackPrivate *priv;
+    HildonWindowPrivate *wpriv;
+    GtkWidget *child;
+    GList *toolbars, *l;
+
+    g_return_if_fail (HILDON_IS_WINDOW_STACK (stack));
+    g_return_if_fail (HILDON_IS_STACKABLE_WINDOW (win));
+
+    priv = stack->priv;
+
+    if (priv->pool.length >= priv->pool_size ||
+        !gtk_widget_get_realized (GTK_WIDGET (win))) {
+        hildon_window_stack_destroy_window (stack, win);
+        return;
+    }
+
+    /* Hiding a window also removes it from its stack */
+    gtk_widget_hide (GTK_WIDGET (win));
+
+    child = gtk_bin_get_child (GTK_BIN (win));
+    if (child)
+        gtk_container_remove (GTK_CONTAINER (win), child);
+
+    wpriv = HILDON_WINDOW_GET_PRIVATE (win);
+    toolbars = gtk_container_get_children (GTK_CONTAINER (wpriv->vbox));
+    for (l = toolbars; l != NULL; l = l->next) {
+        if (GTK_IS_TOOLBAR (l->data))
+            hildon_window_remove_toolbar (HILDON_WINDOW (win), GTK_TOOLBAR (l->data));
+    }
+    g_list_free (toolbars);
+
+    hildon_window_set_edit_toolbar (HILDON_WINDOW (win), NULL);
+    hildon_window_set_app_menu (HILDON_WINDOW (win), NULL);
+    hildon_window_set_main_menu (HILDON_WINDOW (win), NULL);
+    hildon_window_set_markup (HILDON_WINDOW (win), NULL);
+    gtk_window_set_title (GTK_WINDOW (win), NULL);
+
+    g_queue_push_tail (&priv->pool, g_object_ref (win));
+}
+
 static void
 hildon_window_stack_finalize (GObject *object)
 {
     HildonWindowStack *stack = HILDON_WINDOW_STACK (object);
 
-    if (stack->priv->list)
+    if (stack->priv->windows->len > 0)
         hildon_window_stack_pop (stack, hildon_window_stack_size (stack), NULL);
 
+    g_ptr_array_free (stack->priv->windows, TRUE);
+
+    if (stack->priv->changed_old)
+        g_ptr_array_unref (stack->priv->changed_old);
+
+    if (stack->priv->pool_fill_id)
+        g_source_remove (stack->priv->pool_fill_id);
+
+    hildon_window_stack_set_pool_size (stack, 0);
+
+    if (stack->priv->dying_id)
+        g_source_remove (stack->priv->dying_id);
+
+    hildon_window_stack_set_hibernate_depth (stack, 0);
+
+    while (stack->priv->dying.length > 0) {
+        GtkWidget *win = g_queue_pop_head (&stack->priv->dying);
+        gtk_widget_destroy (win);
+        g_object_unref (win);
+    }
+
     if (stack->priv->group)
         g_object_unref (stack->priv->group);
 
@@ -704,6 +1444,33 @@ hildon_window_stack_class_init (HildonWindowStackClass *klass)
             GTK_TYPE_WINDOW_GROUP,
             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 
+    /**
+     * HildonWindowStack::stack-changed:
+     * @stack: the #HildonWindowStack that received the signal
+     * @bottom: the number of windows at the bottom of @stack that did
+     * not change
+     * @popped: (element-type HildonStackableWindow): the windows that
+     * were above the first @bottom ones and are not anymore,
+     * bottom-most first
+     * @pushed: (element-type HildonStackableWindow): the windows that
+     * are now above the first @bottom ones, bottom-most first
+     *
+     * The ::stack-changed signal is emitted after windows are pushed to
+     * or popped from @stack, once per transition when they are grouped
+     * with hildon_window_stack_begin_update(). Pushing a window makes it
+     * the window at @bottom counting from the bottom of the stack, so
+     * listeners only need to look at the windows that changed.
+     *
+     * Since: 3.0
+     */
+    signals[STACK_CHANGED] =
+        g_signal_new ("stack-changed",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST, 0,
+                      NULL, NULL,
+                      _hildon_marshal_VOID__INT_BOXED_BOXED, G_TYPE_NONE, 3,
+                      G_TYPE_INT, G_TYPE_PTR_ARRAY, G_TYPE_PTR_ARRAY);
+
     g_type_class_add_private (klass, sizeof (HildonWindowStackPrivate));
 }
 
@@ -714,6 +1481,22 @@ hildon_window_stack_init (HildonWindowStack *self)
 
     priv = self->priv = HILDON_WINDOW_STACK_GET_PRIVATE (self);
 
-    priv->list = NULL;
+    priv->windows = g_ptr_array_new ();
     priv->group = NULL;
+    priv->update_depth = 0;
+    priv->relink_from = G_MAXUINT;
+    priv->topmost_position = -1;
+    priv->shown = NULL;
+    priv->hidden = NULL;
+    priv->remapping = FALSE;
+    g_queue_init (&priv->pool);
+    priv->pool_size = 0;
+    priv->pool_fill_id = 0;
+    priv->destroy_later = FALSE;
+    priv->changed_from = G_MAXUINT;
+    priv->changed_old = NULL;
+    g_queue_init (&priv->dying);
+    priv->dying_id = 0;
+    priv->hibernate_depth = 0;
+    priv->hibernate_id = 0;
 }
@@ -98,6 +98,10 @@ hildon_window_stack_get_windows                 (HildonWindowStack *stack);
 GtkWidget *
 hildon_window_stack_peek                        (HildonWindowStack *stack);
 
+GtkWidget *
+hildon_window_stack_get_nth                     (HildonWindowStack *stack,
+                                                 gint               n);
+
 void
 hildon_window_stack_push                        (HildonWindowStack     *stack,
                                                  HildonStackableWindow *win1,
@@ -132,6 +136,40 @@ hildon_window_stack_pop_and_push_list           (HildonWindowStack  *stack,
                                                  GList             **popped_windows,
                                                  GList              *list);
 
+void
+hildon_window_stack_begin_update                (HildonWindowStack *stack);
+
+void
+hildon_window_stack_commit_update               (HildonWindowStack *stack);
+
+void
+hildon_window_stack_set_pool_size               (HildonWindowStack *stack,
+                                                 guint              size);
+
+guint
+hildon_window_stack_get_pool_size               (HildonWindowStack *stack);
+
+GtkWidget *
+hildon_window_stack_new_window                  (HildonWindowStack *stack);
+
+void
+hildon_window_stack_release_window              (HildonWindowStack     *stack,
+                                                 HildonStackableWindow *win);
+
+void
+hildon_window_stack_set_destroy_later           (HildonWindowStack *stack,
+                                                 gboolean           destroy_later);
+
+gboolean
+hildon_window_stack_get_destroy_later           (HildonWindowStack *stack);
+
+void
+hildon_window_stack_set_hibernate_depth         (HildonWindowStack *stack,
+                                                 guint              depth);
+
+guint
+hildon_window_stack_get_hibernate_depth         (HildonWindowStack *stack);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_WINDOW_STACK_H__ */
@@ -219,17 +219,46 @@ hildon_window_event_filter                      (GdkXEvent *xevent,
                                                  gpointer data);
 
 static void
-hildon_window_get_borders                       (HildonWindow *window);
+hildon_window_active_window_changed             (gpointer data);
+
+typedef struct
+{
+    GtkBorder borders;
+    GtkBorder toolbar_borders;
+    gboolean valid;
+} HildonWindowBorders;
+
+/* A rendered border or toolbar background of the chrome */
+typedef struct
+{
+    cairo_rectangle_int_t rect;
+    cairo_surface_t *surface;
+} HildonWindowChromeStrip;
+
+static const HildonWindowBorders *
+hildon_window_get_borders                       (GtkWidget *widget);
 
 static void
-visible_toolbar                                 (gpointer data, 
-                                                 gpointer user_data);
+paint_toolbar                                   (GtkWidget      *widget,
+                                                 GArray         *strips);
 
 static void
-paint_toolbar                                   (GtkWidget *widget, 
-                                                 GtkBox    *box, 
-                                                 cairo_t   *cr, 
-                                                 gboolean   fullscreen);
+hildon_window_style_updated                     (GtkWidget *widget);
+
+static void
+hildon_window_clear_chrome                      (HildonWindow *window);
+
+static void
+hildon_window_forget_layouts                    (HildonWindow *window);
+
+static void
+hildon_window_track_toolbar                     (HildonWindow *window,
+                                                 GtkWidget    *toolbar);
+
+static void
+vbox_remove                                     (GtkContainer *vbox,
+                                                 GtkWidget    *toolbar,
+                                                 HildonWindow *window);
 
 static void
 paint_edit_toolbar                              (GtkWidget *widget,
@@ -241,7 +270,8 @@ enum
 {
     PROP_0,
     PROP_IS_TOPMOST,
-    PROP_MARKUP
+    PROP_MARKUP,
+    PROP_KEEP_ORIENTATION_LAYOUTS
 };
 
 enum
@@ -276,6 +306,7 @@ hildon_window_class_init                        (HildonWindowClass * window_clas
     widget_class->map                   = hildon_window_map;
     widget_class->unmap                 = hildon_window_unmap;
     widget_class->destroy               = hildon_window_destroy;
+    widget_class->style_updated         = hildon_window_style_updated;
 
     /* now the object stuff */
     object_class->finalize              = hildon_window_finalize;
@@ -306,6 +337,22 @@ hildon_window_class_init                        (HildonWindowClass * window_clas
                 NULL,
                 G_PARAM_READWRITE));
 
+    /**
+     * HildonWindow:keep-orientation-layouts:
+     *
+     * Whether the window remembers its layout in both orientations.
+     * See hildon_window_set_keep_orientation_layouts().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_KEEP_ORIENTATION_LAYOUTS,
+            g_param_spec_boolean ("keep-orientation-layouts",
+                "Keep orientation layouts",
+                "Whether the layout of the window is kept for both "
+                "orientations",
+                FALSE,
+                G_PARAM_READWRITE));
+
     gtk_widget_class_install_style_property (widget_class,
             g_param_spec_boxed ("borders",
                 "Graphical borders",
@@ -339,16 +386,17 @@ hildon_window_init                              (HildonWindow *self)
     priv->vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, TOOLBAR_MIDDLE);
     gtk_box_set_homogeneous(GTK_BOX(priv->vbox), FALSE);
     gtk_widget_set_parent (priv->vbox, GTK_WIDGET(self));
+    g_signal_connect (priv->vbox, "remove", G_CALLBACK (vbox_remove), self);
     priv->menu = NULL;
     priv->app_menu = NULL;
     priv->edit_toolbar = NULL;
     priv->visible_toolbars = 0;
     priv->is_topmost = FALSE;
-    priv->borders = NULL;
-    priv->toolbar_borders = NULL;
+    priv->chrome = NULL;
     priv->markup = NULL;
 
     priv->fullscreen = FALSE;
+    priv->keep_layouts = FALSE;
 
     priv->program = NULL;
 }
@@ -365,11 +413,7 @@ hildon_window_finalize                          (GObject * obj_self)
     
     g_free (priv->markup);
 
-    if (priv->borders)
-        gtk_border_free (priv->borders);
-
-    if (priv->toolbar_borders)
-        gtk_border_free (priv->toolbar_borders);
+    hildon_window_clear_chrome (HILDON_WINDOW (obj_self));
 
     if (G_OBJECT_CLASS (hildon_window_parent_class)->finalize)
         G_OBJECT_CLASS (hildon_window_parent_class)->finalize (obj_self);
@@ -386,6 +430,8 @@ hildon_window_realize                           (GtkWidget *widget)
     Window active_window;
     HildonWindowPrivate *priv;
 
+    hildon_trace_begin ("window-realize");
+
     GTK_WIDGET_CLASS (hildon_window_parent_class)->realize (widget);
 
     priv = HILDON_WINDOW_GET_PRIVATE (widget);
@@ -403,13 +449,15 @@ hildon_window_realize                           (GtkWidget *widget)
     disp = GDK_WINDOW_XDISPLAY (gtk_widget_get_window (widget));
 
     /* Enable custom button that is used for menu */
+    HILDON_PERF (X_ROUND_TRIPS);
     XGetWMProtocols (disp, window, &old_atoms, &atom_count);
     new_atoms = g_new (Atom, atom_count + 1);
 
     memcpy (new_atoms, old_atoms, sizeof(Atom) * atom_count);
 
     new_atoms[atom_count++] =
-        XInternAtom (disp, "_NET_WM_CONTEXT_CUSTOM", False);
+        hildon_get_xatom (gtk_widget_get_display (widget),
+                          HILDON_ATOM_NET_WM_CONTEXT_CUSTOM);
 
     XSetWMProtocols (disp, window, new_atoms, atom_count);
 
@@ -430,8 +478,11 @@ hildon_window_realize                           (GtkWidget *widget)
         hildon_window_update_markup (HILDON_WINDOW (widget));
 
     /* Update the topmost status */
+    hildon_window_watch_active_window (hildon_window_active_window_changed, widget);
     active_window = hildon_window_get_active_window();
     hildon_window_update_topmost (HILDON_WINDOW (widget), active_window);
+
+    hildon_trace_end ("window-realize");
 }
 
 static void
@@ -443,6 +494,7 @@ hildon_window_unrealize                         (GtkWidget *widget)
     gdk_window_remove_filter (gtk_widget_get_window (widget), hildon_window_event_filter,
             widget);
 
+    hildon_window_unwatch_active_window (hildon_window_active_window_changed, widget);
     hildon_window_update_topmost (HILDON_WINDOW (widget), 0);
 
     gtk_widget_unrealize (GTK_WIDGET (priv->vbox));
@@ -450,6 +502,9 @@ hildon_window_unrealize                         (GtkWidget *widget)
     if (priv->edit_toolbar != NULL)
         gtk_widget_unrealize (priv->edit_toolbar);
 
+    /* The cached chrome is similar to the window being dropped */
+    hildon_window_clear_chrome (HILDON_WINDOW (widget));
+
     GTK_WIDGET_CLASS(hildon_window_parent_class)->unrealize(widget);
 }
 
@@ -503,6 +558,10 @@ hildon_window_get_property                      (GObject *object,
             g_value_set_string (value, priv->markup);
             break;
 
+        case PROP_KEEP_ORIENTATION_LAYOUTS:
+            g_value_set_boolean (value, priv->keep_layouts);
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
             break;
@@ -521,87 +580,195 @@ hildon_window_set_property                      (GObject      *object,
             hildon_window_set_markup (HILDON_WINDOW (object), g_value_get_string (value));
             break;
 
+        case PROP_KEEP_ORIENTATION_LAYOUTS:
+            hildon_window_set_keep_orientation_layouts (HILDON_WINDOW (object),
+                                                        g_value_get_boolean (value));
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
     }
 }
 
+static void
+hildon_window_borders_free                      (gpointer data)
+{
+    g_slice_free (HildonWindowBorders, data);
+}
+
+/*
+ * The border geometry only depends on the theme and the window class,
+ * so it is kept once per screen and type instead of in every window
+ */
+static HildonWindowBorders *
+hildon_window_lookup_borders                    (GtkWidget *widget)
+{
+    static GQuark quark = 0;
+    GdkScreen *screen = gtk_widget_get_screen (widget);
+    GHashTable *cache;
+    HildonWindowBorders *borders;
+
+    if (G_UNLIKELY (quark == 0))
+        quark = g_quark_from_static_string ("hildon-window-borders");
+
+    cache = g_object_get_qdata (G_OBJECT (screen), quark);
+    if (cache == NULL) {
+        cache = g_hash_table_new_full (NULL, NULL, NULL, hildon_window_borders_free);
+        g_object_set_qdata_full (G_OBJECT (screen), quark, cache,
+                                 (GDestroyNotify) g_hash_table_destroy);
+    }
+
+    borders = g_hash_table_lookup (cache, GSIZE_TO_POINTER (G_OBJECT_TYPE (widget)));
+    if (borders == NULL) {
+        borders = g_slice_new0 (HildonWindowBorders);
+        g_hash_table_insert (cache, GSIZE_TO_POINTER (G_OBJECT_TYPE (widget)), borders);
+    }
+
+    return borders;
+}
+
 /*
  * Retrieve the graphical borders size used by the themes
  */
-static void
-hildon_window_get_borders                       (HildonWindow *window)
+static const HildonWindowBorders *
+hildon_window_get_borders                       (GtkWidget *widget)
 {
     GtkBorder zero = {0, 0, 0, 0};
-    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
-    g_assert (priv);
-
+    HildonWindowBorders *cached = hildon_window_lookup_borders (widget);
     GtkBorder *borders = NULL;
     GtkBorder *toolbar_borders = NULL;
 
-    if (priv->borders)
-        gtk_border_free (priv->borders);
-    if (priv->toolbar_borders)
-        gtk_border_free (priv->toolbar_borders);
+    if (cached->valid)
+        return cached;
 
-    priv->borders = NULL;
-    priv->toolbar_borders = NULL;
+    /* The first lookup is where the theme gets resolved */
+    hildon_trace_begin ("window-style");
 
-    gtk_widget_style_get (GTK_WIDGET (window), "borders",&borders,
+    gtk_widget_style_get (widget, "borders",&borders,
             "toolbar-borders", &toolbar_borders,
             NULL);
 
-    // We're doing a copy here instead of reusing the pointer, 
-    // as we don't know where it comes from (has it been allocated using 
-    // malloc or slices... and we want to free it sanely. Blowing on 
-    // cold probbably.
+    cached->borders = borders ? *borders : zero;
+    cached->toolbar_borders = toolbar_borders ? *toolbar_borders : zero;
+    cached->valid = TRUE;
 
-    if (borders) {
-        priv->borders = gtk_border_copy (borders);
-        gtk_border_free (borders);
-    } else
-        priv->borders = g_boxed_copy (GTK_TYPE_BORDER, &zero);
+    hildon_trace_end ("window-style");
 
-    if (toolbar_borders) {
-        priv->toolbar_borders = gtk_border_copy (toolbar_borders);
+    if (borders)
+        gtk_border_free (borders);
+    if (toolbar_borders)
         gtk_border_free (toolbar_borders);
-    } else
-        priv->toolbar_borders = g_boxed_copy (GTK_TYPE_BORDER, &zero);
+
+    return cached;
 }
 
-static gboolean
-hildon_window_draw                              (GtkWidget *widget, 
-                                                 cairo_t   *cr)
+static void
+hildon_window_style_updated                     (GtkWidget *widget)
 {
-    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (widget);
-    g_assert (priv);
+    GTK_WIDGET_CLASS (hildon_window_parent_class)->style_updated (widget);
 
-    GtkWidget *bx = priv->vbox;
-    GtkBox *box = GTK_BOX(bx);
-    GtkBorder *b = priv->borders;
-    GtkBorder *tb = priv->toolbar_borders;
-    gint tb_height = 0;
+    /* Borders are fetched again and the chrome rendered again on the
+     * next allocation or draw */
+    hildon_window_lookup_borders (widget)->valid = FALSE;
+    hildon_window_clear_chrome (HILDON_WINDOW (widget));
+    hildon_window_forget_layouts (HILDON_WINDOW (widget));
+}
 
-    if (! priv->borders) {
-        hildon_window_get_borders (HILDON_WINDOW (widget));
-        b = priv->borders;
-        tb = priv->toolbar_borders;
-    }
+static void
+hildon_window_forget_layouts                    (HildonWindow *window)
+{
+    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
 
-    tb_height = gtk_widget_get_allocated_height (bx) + tb->top + tb->bottom;
+    priv->layouts[0].valid = FALSE;
+    priv->layouts[1].valid = FALSE;
+}
 
-    paint_toolbar (widget, box, cr, priv->fullscreen);
+static void
+hildon_window_clear_chrome                      (HildonWindow *window)
+{
+    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
 
-    if (priv->edit_toolbar != NULL)
-    {
-        paint_edit_toolbar (widget, priv->edit_toolbar, cr, priv->fullscreen);
+    if (priv->chrome) {
+        guint i;
+
+        for (i = 0; i < priv->chrome->len; i++)
+            cairo_surface_destroy (g_array_index (priv->chrome,
+                                                  HildonWindowChromeStrip, i).surface);
+        g_array_free (priv->chrome, TRUE);
+        priv->chrome = NULL;
     }
+}
+
+/* Renders a frame into a surface of its own size, added to @strips */
+static void
+render_frame                                    (GtkWidget      *widget,
+                                                 GArray         *strips,
+                                                 gint            x,
+                                                 gint            y,
+                                                 gint            width,
+                                                 gint            height)
+{
+    HildonWindowChromeStrip strip = { { x, y, width, height }, NULL };
+    cairo_t *cr;
+
+    if (width <= 0 || height <= 0)
+        return;
+
+    strip.surface = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                                       CAIRO_CONTENT_COLOR_ALPHA,
+                                                       width, height);
+    cr = cairo_create (strip.surface);
+    cairo_translate (cr, -x, -y);
+    gtk_render_frame (gtk_widget_get_style_context (widget), cr,
+                      x, y, width, height);
+    cairo_destroy (cr);
+
+    g_array_append_val (strips, strip);
+}
+
+/* Renders the window borders and the toolbar backgrounds, each into a
+ * surface of its own, so that the transparent middle of the window
+ * costs no memory. They are kept until the size, the toolbars or the
+ * theme change */
+static void
+hildon_window_update_chrome                     (GtkWidget *widget)
+{
+    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (widget);
+    const HildonWindowBorders *borders = hildon_window_get_borders (widget);
+    const GtkBorder *b = &borders->borders;
+    const GtkBorder *tb = &borders->toolbar_borders;
+    gint width = gtk_widget_get_allocated_width (widget);
+    gint height = gtk_widget_get_allocated_height (widget);
+    gint box_height = gtk_widget_get_allocated_height (priv->vbox);
+    gint tb_height;
+    GArray *strips;
+
+    if (priv->chrome &&
+        priv->chrome_width == width &&
+        priv->chrome_height == height &&
+        priv->chrome_box_height == box_height &&
+        priv->chrome_toolbars == priv->visible_toolbars &&
+        priv->chrome_fullscreen == priv->fullscreen)
+        return;
+
+    hildon_window_clear_chrome (HILDON_WINDOW (widget));
+
+    strips = priv->chrome = g_array_new (FALSE, FALSE, sizeof (HildonWindowChromeStrip));
+    priv->chrome_width = width;
+    priv->chrome_height = height;
+    priv->chrome_box_height = box_height;
+    priv->chrome_toolbars = priv->visible_toolbars;
+    priv->chrome_fullscreen = priv->fullscreen;
+
+    tb_height = box_height + tb->top + tb->bottom;
+
+    paint_toolbar (widget, strips);
 
     if (! priv->fullscreen) {
 
         /* Draw the left and right window border */
-        gint side_borders_height = gtk_widget_get_allocated_height (widget) - b->top;
+        gint side_borders_height = height - b->top;
 
         if (priv->visible_toolbars)
             side_borders_height -= tb_height;
@@ -610,35 +777,60 @@ hildon_window_draw                              (GtkWidget *widget,
 
         if (b->left > 0) 
         {
-            gtk_render_frame (gtk_widget_get_style_context (widget), cr,
-                              0, b->top,
-                              b->left, side_borders_height);
+            render_frame (widget, strips,
+                          0, b->top,
+                          b->left, side_borders_height);
         } 
 
         if (b->right > 0)
         {
-            gtk_render_frame (gtk_widget_get_style_context (widget), cr,
-                              gtk_widget_get_allocated_width (widget) - b->right, b->top,
-                              b->right, side_borders_height);
+            render_frame (widget, strips,
+                          width - b->right, b->top,
+                          b->right, side_borders_height);
         }
 
         /* If no toolbar, draw the bottom window border */
         if (! priv->visible_toolbars && b->bottom > 0)
         {
-            gtk_render_frame (gtk_widget_get_style_context (widget), cr,
-                              0, gtk_widget_get_allocated_height (widget) - b->bottom,
-                              gtk_widget_get_allocated_width (widget), b->bottom);
+            render_frame (widget, strips,
+                          0, height - b->bottom,
+                          width, b->bottom);
         }
 
         /* Draw the top border */
         if (b->top > 0)
         {
-            gtk_render_frame (gtk_widget_get_style_context (widget), cr,
-                              0, 0,
-                              gtk_widget_get_allocated_width (widget), b->top);
+            render_frame (widget, strips,
+                          0, 0,
+                          width, b->top);
         } 
+    }
+}
+
+static gboolean
+hildon_window_draw                              (GtkWidget *widget, 
+                                                 cairo_t   *cr)
+{
+    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (widget);
+    guint i;
+    g_assert (priv);
+
+    hildon_window_update_chrome (widget);
 
+    /* Only the chrome is blitted, not the transparent rest */
+    for (i = 0; i < priv->chrome->len; i++)
+    {
+        const HildonWindowChromeStrip *strip =
+            &g_array_index (priv->chrome, HildonWindowChromeStrip, i);
 
+        cairo_set_source_surface (cr, strip->surface, strip->rect.x, strip->rect.y);
+        gdk_cairo_rectangle (cr, (const GdkRectangle *) &strip->rect);
+        cairo_fill (cr);
+    }
+
+    if (priv->edit_toolbar != NULL)
+    {
+        paint_edit_toolbar (widget, priv->edit_toolbar, cr, priv->fullscreen);
     }
 
     /* don't draw the window stuff as it overwrites our borders with a blank
@@ -659,6 +851,9 @@ hildon_window_get_preferred_width               (GtkWidget *widget,
     gint minimal, natural;
     g_assert (priv);
 
+    /* GTK+ only asks again when a request in the window changed */
+    hildon_window_forget_layouts (HILDON_WINDOW (widget));
+
     child = gtk_bin_get_child (GTK_BIN (widget));
 
     if (child != NULL && gtk_widget_get_visible (child))
@@ -685,6 +880,8 @@ hildon_window_get_preferred_height              (GtkWidget *widget,
     gint minimal, natural;
     g_assert (priv);
 
+    hildon_window_forget_layouts (HILDON_WINDOW (widget));
+
     child = gtk_bin_get_child (GTK_BIN (widget));
 
     if (child != NULL && gtk_widget_get_visible (child))
@@ -717,14 +914,30 @@ hildon_window_size_allocate                     (GtkWidget *widget,
     GtkAllocation alloc = *allocation;
 
     GtkWidget *child = gtk_bin_get_child (GTK_BIN (widget));
-    GtkBorder *tb;
+    const HildonWindowBorders *borders = hildon_window_get_borders (widget);
+    const GtkBorder *tb = &borders->toolbar_borders;
+    HildonWindowLayout *layout = &priv->layouts[allocation->width < allocation->height];
 
-    if (!priv->borders)
-        hildon_window_get_borders (HILDON_WINDOW (widget));
+    GTK_WIDGET_CLASS (hildon_window_parent_class)->size_allocate (widget, allocation);
 
-    tb = priv->toolbar_borders;
+    /* Back in an orientation the window was already laid out in, with
+     * no request changed since: the parts go where they went then */
+    if (priv->keep_layouts && layout->valid &&
+        gdk_rectangle_equal (&layout->window, allocation))
+    {
+        edittb_alloc = layout->edit_toolbar;
+        box_alloc = layout->toolbars;
+        alloc = layout->child;
 
-    GTK_WIDGET_CLASS (hildon_window_parent_class)->size_allocate (widget, allocation);
+        if (edittb_alloc.height > 0)
+            gtk_widget_size_allocate (priv->edit_toolbar, &edittb_alloc);
+        if (box_alloc.height > 0)
+            gtk_widget_size_allocate (priv->vbox, &box_alloc);
+        if (child != NULL && gtk_widget_get_visible (child))
+            gtk_widget_size_allocate (child, &alloc);
+
+        goto out;
+    }
 
     /* Calculate allocation of edit toolbar */
     if (priv->edit_toolbar != NULL && gtk_widget_get_visible (priv->edit_toolbar))
@@ -771,7 +984,7 @@ hildon_window_size_allocate                     (GtkWidget *widget,
 
         if (! priv->fullscreen)
         {
-            GtkBorder *b = priv->borders;
+            const GtkBorder *b = &borders->borders;
             alloc.x += b->left;
             alloc.width -= (b->left + b->right);
 
@@ -790,6 +1003,16 @@ hildon_window_size_allocate                     (GtkWidget *widget,
         gtk_widget_size_allocate (child, &alloc);
     }
 
+    if (priv->keep_layouts)
+    {
+        layout->valid = TRUE;
+        layout->window = *allocation;
+        layout->edit_toolbar = edittb_alloc;
+        layout->toolbars = box_alloc;
+        layout->child = alloc;
+    }
+
+out:
     if (priv->previous_vbox_y != box_alloc.y)
     {
         /* The size of the VBox has changed, we need to redraw part
@@ -866,6 +1089,7 @@ hildon_window_destroy                           (GtkWidget *obj)
             }
         }
 
+        g_signal_handlers_disconnect_by_func (priv->vbox, vbox_remove, self);
         gtk_widget_unparent (priv->vbox);
         priv->vbox = NULL;    
 
@@ -938,41 +1162,28 @@ hildon_window_notify                            (GObject *gobject,
 
 
 static void
-visible_toolbar                                 (gpointer data, 
-                                                 gpointer user_data)
-{
-    if (gtk_widget_get_visible ((GtkWidget *)data))
-        (*((gint *)user_data))++;
-}
-
-static void
-paint_toolbar                                   (GtkWidget *widget, 
-                                                 GtkBox    *box, 
-                                                 cairo_t   *cr, 
-                                                 gboolean   fullscreen)
+paint_toolbar                                   (GtkWidget      *widget,
+                                                 GArray         *strips)
 {
-    gint toolbar_num = 0; 
+    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (widget);
+    gint box_height = gtk_widget_get_allocated_height (priv->vbox);
+    gint width = gtk_widget_get_allocated_width (widget);
     gint count;
 
-    /* collect info to help on painting the boxes */
-    g_list_foreach (gtk_container_get_children (GTK_CONTAINER (box)),
-                    visible_toolbar, (gpointer) &toolbar_num);
-
-    if(toolbar_num <= 0)
+    if (priv->visible_toolbars <= 0)
         return;
 
     /*top most toolbar painting*/
-    gtk_render_frame (gtk_widget_get_style_context (widget), cr,
-                      0, gtk_widget_get_allocated_height (GTK_WIDGET(box)),
-                      gtk_widget_get_allocated_width (widget), TOOLBAR_HEIGHT);
+    render_frame (widget, strips,
+                  0, box_height,
+                  width, TOOLBAR_HEIGHT);
 
     /*multi toolbar painting*/
-    for (count = 0; count < toolbar_num - 1; count++)
+    for (count = 0; count < priv->visible_toolbars - 1; count++)
     {
-        gtk_render_frame (gtk_widget_get_style_context (widget), cr,
-                          0, gtk_widget_get_allocated_height (GTK_WIDGET(box)) +
-                          (1 + count) * (TOOLBAR_HEIGHT),
-                          gtk_widget_get_allocated_width (widget), TOOLBAR_HEIGHT);
+        render_frame (widget, strips,
+                      0, box_height + (1 + count) * (TOOLBAR_HEIGHT),
+                      width, TOOLBAR_HEIGHT);
     }
 }
 
@@ -982,25 +1193,25 @@ paint_edit_toolbar                              (GtkWidget *widget,
                                                  cairo_t   *cr,
                                                  gboolean   fullscreen)
 {
-    GtkAllocation *toolbar_allocation = NULL;
+    GtkAllocation toolbar_allocation;
 
     if (!gtk_widget_get_visible (toolbar))
         return;
 
-    gtk_widget_get_allocation (toolbar, toolbar_allocation);
+    gtk_widget_get_allocation (toolbar, &toolbar_allocation);
 
     gtk_render_frame (gtk_widget_get_style_context (widget), cr,
-                      toolbar_allocation->x,
-                      toolbar_allocation->y,
-                      toolbar_allocation->width,
-                      toolbar_allocation->height);
+                      toolbar_allocation.x,
+                      toolbar_allocation.y,
+                      toolbar_allocation.width,
+                      toolbar_allocation.height);
 }
 
 /*
  * Checks the root window to know which is the topped window
  */
-Window
-hildon_window_get_active_window                 (void)
+static Window
+hildon_window_fetch_active_window               (void)
 {
     Atom realtype;
     gint xerror;
@@ -1014,11 +1225,13 @@ hildon_window_get_active_window                 (void)
         Window *win;
         unsigned char *char_pointer;
     } win;
-    Atom active_app_atom = 
-        XInternAtom (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()), "_MB_CURRENT_APP_WINDOW", False);
+    Atom active_app_atom =
+        hildon_get_xatom (gdk_display_get_default (), HILDON_ATOM_MB_CURRENT_APP_WINDOW);
 
     win.win = NULL;
 
+    HILDON_PERF (X_ROUND_TRIPS);
+
     gdk_error_trap_push ();
     status = XGetWindowProperty (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()),
             GDK_ROOT_WINDOW(),
@@ -1044,12 +1257,234 @@ hildon_window_get_active_window                 (void)
     return (ret != 0xFFFFFFFF) ? ret : None;
 }
 
+/*
+ * The _MB_CURRENT_APP_WINDOW property is watched with a single filter on
+ * the root window, shared by all the windows and the program. The active
+ * window is fetched once per change and handed to every watcher from the
+ * cache below, so a task switch costs the same however many windows the
+ * application has.
+ */
+typedef struct
+{
+    HildonActiveWindowFunc func;
+    gpointer data;
+} HildonActiveWindowWatch;
+
+static GSList *active_window_watches = NULL;
+static Window active_window_cache = None;
+static Window active_group_cache = None;
+static gboolean active_group_valid = FALSE;
+
+static Window
+hildon_window_fetch_window_group                (Window window)
+{
+    XWMHints *wm_hints;
+    Window group = None;
+
+    if (!window)
+        return None;
+
+    HILDON_PERF (X_ROUND_TRIPS);
+
+    gdk_error_trap_push ();
+    wm_hints = XGetWMHints (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()), window);
+    gdk_error_trap_pop_ignored ();
+
+    if (wm_hints)
+    {
+        if (wm_hints->flags & WindowGroupHint)
+            group = wm_hints->window_group;
+        XFree (wm_hints);
+    }
+
+    return group;
+}
+
+static void
+hildon_window_notify_active_window_watches      (void)
+{
+    GSList *watches, *iter;
+
+    /* Watchers may come and go from their callbacks */
+    watches = g_slist_copy (active_window_watches);
+    for (iter = watches; iter; iter = iter->next)
+    {
+        HildonActiveWindowWatch *watch = iter->data;
+
+        if (g_slist_find (active_window_watches, watch))
+            watch->func (watch->data);
+    }
+    g_slist_free (watches);
+}
+
+static void
+hildon_window_active_group_reply                (GObject                  *owner,
+                                                 xcb_get_property_reply_t *reply,
+                                                 gpointer                  data)
+{
+    active_group_cache = None;
+
+    /* WM_HINTS is 9 CARD32s, the flags first and the group last */
+    if (reply && reply->format == 32 && reply->value_len >= 9)
+    {
+        guint32 *hints = xcb_get_property_value (reply);
+
+        if (hints[0] & WindowGroupHint)
+            active_group_cache = hints[8];
+    }
+
+    active_group_valid = TRUE;
+
+    hildon_window_notify_active_window_watches ();
+}
+
+static void
+hildon_window_active_window_reply               (GObject                  *owner,
+                                                 xcb_get_property_reply_t *reply,
+                                                 gpointer                  data)
+{
+    active_window_cache = None;
+
+    if (reply && reply->type == XA_WINDOW && reply->format == 32 &&
+        reply->value_len == 1)
+    {
+        Window window = *(guint32 *) xcb_get_property_value (reply);
+
+        /* 0xFFFFFFFF is not an actual window ID, but a magic value to
+         * indicate that the task switcher is visible */
+        if (window != 0xFFFFFFFF)
+            active_window_cache = window;
+    }
+
+    if (active_window_cache)
+    {
+        hildon_get_property_async (GDK_DISPLAY (owner), active_window_cache,
+                                   XA_WM_HINTS, XA_WM_HINTS, 9, owner,
+                                   hildon_window_active_group_reply, NULL);
+        return;
+    }
+
+    active_group_cache = None;
+    active_group_valid = TRUE;
+
+    hildon_window_notify_active_window_watches ();
+}
+
+static GdkFilterReturn
+hildon_window_root_event_filter                 (GdkXEvent *xevent,
+                                                 GdkEvent *event,
+                                                 gpointer data)
+{
+    XAnyEvent *eventti = xevent;
+
+    if (eventti->type == PropertyNotify)
+    {
+        XPropertyEvent *pevent = xevent;
+        Atom active_app_atom =
+            hildon_get_xatom (gdk_display_get_default (),
+                              HILDON_ATOM_MB_CURRENT_APP_WINDOW);
+
+        if (pevent->atom == active_app_atom)
+        {
+            GdkDisplay *display = gdk_display_get_default ();
+
+            /* Don't block the main loop on the server: the watchers are
+             * notified when both replies are in. */
+            hildon_get_property_async (display, GDK_ROOT_WINDOW (),
+                                       active_app_atom, XA_WINDOW, 16,
+                                       G_OBJECT (display),
+                                       hildon_window_active_window_reply,
+                                       NULL);
+        }
+    }
+
+    return GDK_FILTER_CONTINUE;
+}
+
+/*
+ * Calls @func whenever the active window changes. Until the last watch
+ * is removed, hildon_window_get_active_window() and
+ * hildon_window_get_active_window_group() answer from the cache.
+ */
+void
+hildon_window_watch_active_window               (HildonActiveWindowFunc func,
+                                                 gpointer data)
+{
+    HildonActiveWindowWatch *watch;
+
+    if (active_window_watches == NULL)
+    {
+        GdkWindow *root = gdk_get_default_root_window ();
+
+        gdk_window_set_events (root,
+                               gdk_window_get_events (root) | GDK_PROPERTY_CHANGE_MASK);
+        gdk_window_add_filter (root, hildon_window_root_event_filter, NULL);
+
+        active_window_cache = hildon_window_fetch_active_window ();
+        active_group_valid = FALSE;
+    }
+
+    watch = g_slice_new (HildonActiveWindowWatch);
+    watch->func = func;
+    watch->data = data;
+    active_window_watches = g_slist_append (active_window_watches, watch);
+}
+
+void
+hildon_window_unwatch_active_window             (HildonActiveWindowFunc func,
+                                                 gpointer data)
+{
+    GSList *iter;
+
+    for (iter = active_window_watches; iter; iter = iter->next)
+    {
+        HildonActiveWindowWatch *watch = iter->data;
+
+        if (watch->func == func && watch->data == data)
+        {
+            active_window_watches = g_slist_delete_link (active_window_watches, iter);
+            g_slice_free (HildonActiveWindowWatch, watch);
+            break;
+        }
+    }
+
+    if (active_window_watches == NULL)
+        gdk_window_remove_filter (gdk_get_default_root_window (),
+                                  hildon_window_root_event_filter, NULL);
+}
+
+Window
+hildon_window_get_active_window                 (void)
+{
+    if (active_window_watches)
+        return active_window_cache;
+
+    return hildon_window_fetch_active_window ();
+}
+
+/*
+ * Returns the window group WM hint of the active window
+ */
+Window
+hildon_window_get_active_window_group           (void)
+{
+    if (!active_window_watches)
+        return hildon_window_fetch_window_group (hildon_window_fetch_active_window ());
+
+    if (!active_group_valid)
+    {
+        active_group_cache = hildon_window_fetch_window_group (active_window_cache);
+        active_group_valid = TRUE;
+    }
+
+    return active_group_cache;
+}
+
 static int
 xclient_message_type_check                      (XClientMessageEvent *cm, 
-                                                 const gchar *name)
+                                                 HildonAtom atom)
 {
-    return cm->message_type == XInternAtom(
-            GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()), name, FALSE);
+    return cm->message_type == hildon_get_xatom (gdk_display_get_default (), atom);
 }
 
 /*
@@ -1067,29 +1502,13 @@ hildon_window_event_filter                      (GdkXEvent *xevent,
     {
         XClientMessageEvent *cm = xevent;
 
-        if (xclient_message_type_check (cm, "_MB_GRAB_TRANSFER"))
+        if (xclient_message_type_check (cm, HILDON_ATOM_MB_GRAB_TRANSFER))
         {
             hildon_window_toggle_menu (HILDON_WINDOW ( data ), cm->data.l[2], cm->data.l[0]);
             return GDK_FILTER_REMOVE;
         }
     }
 
-    if (eventti->type == PropertyNotify)
-    {
-        XPropertyEvent *pevent = xevent;
-        Atom active_app_atom = 
-            XInternAtom (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()),
-                         "_MB_CURRENT_APP_WINDOW", False);
-
-        if (pevent->atom == active_app_atom)
-        {
-            HildonWindow *window = HILDON_WINDOW (data);
-            Window active_window = hildon_window_get_active_window();
-
-            hildon_window_update_topmost (window, active_window);
-        }
-    }
-
     return GDK_FILTER_CONTINUE;
 }
 
@@ -1124,8 +1543,10 @@ hildon_window_window_state_event                (GtkWidget *widget,
     HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (widget);
     g_assert (priv != NULL);
 
-    if (event->changed_mask & GDK_WINDOW_STATE_FULLSCREEN)
+    if (event->changed_mask & GDK_WINDOW_STATE_FULLSCREEN) {
         priv->fullscreen = event->new_window_state & GDK_WINDOW_STATE_FULLSCREEN;
+        hildon_window_forget_layouts (HILDON_WINDOW (widget));
+    }
 
     if (GTK_WIDGET_CLASS (hildon_window_parent_class)->window_state_event)
     {
@@ -1343,17 +1764,10 @@ hildon_window_set_can_hibernate_property        (HildonWindow *self,
 
     killable_atom = gdk_atom_intern (CAN_HIBERNATE_PROPERTY, FALSE);
 
-    if (can_hibernate)
-    {
-        gdk_property_change (gtk_widget_get_window (GTK_WIDGET (self)), killable_atom,
-                (GdkAtom)31/* XA_STRING */, 8,
-                GDK_PROP_MODE_REPLACE, (const guchar *)CAN_HIBERNATE,
-                CAN_HIBERNATE_LENGTH);
-    }
-    else
-    {
-        gdk_property_delete (gtk_widget_get_window (GTK_WIDGET (self)), killable_atom);
-    }
+    hildon_gtk_window_queue_property (GTK_WINDOW (self), killable_atom,
+                                      (GdkAtom)31/* XA_STRING */, 8,
+                                      can_hibernate ? CAN_HIBERNATE : NULL,
+                                      CAN_HIBERNATE_LENGTH);
 
 }
 
@@ -1391,7 +1805,7 @@ hildon_window_take_common_toolbar               (HildonWindow *self)
 
                 gtk_widget_set_size_request (common_toolbar, -1, TOOLBAR_HEIGHT);
 
-                gtk_widget_show  (priv->vbox);
+                hildon_window_track_toolbar (self, common_toolbar);
             }
         }
     }
@@ -1438,6 +1852,13 @@ hildon_window_update_topmost                    (HildonWindow *self,
     }
 }
 
+static void
+hildon_window_active_window_changed             (gpointer data)
+{
+    hildon_window_update_topmost (HILDON_WINDOW (data),
+                                  hildon_window_get_active_window ());
+}
+
 static void
 detach_menu_func                                (GtkWidget *attach_widget, 
                                                  GtkMenu *menu)
@@ -1657,14 +2078,6 @@ hildon_window_add_with_scrollbar                (HildonWindow *self,
     gtk_container_add (GTK_CONTAINER (self), GTK_WIDGET (scrolledw));
 }
 
-static void
-calculate_visible_toolbars                      (gpointer data,
-                                                 gpointer user_data)
-{
-  if (gtk_widget_get_visible ((GtkWidget *)data))
-    (*((gint *)user_data)) ++;
-}
-
 static void
 toolbar_visible_notify                          (GtkWidget *toolbar, GParamSpec *pspec,
                                                  HildonWindow *window)
@@ -1673,11 +2086,10 @@ toolbar_visible_notify                          (GtkWidget *toolbar, GParamSpec
 
   g_assert (priv);
 
-  /* Recalculate from scratch the value just in case */
-  priv->visible_toolbars = 0;
-
-  g_list_foreach (gtk_container_get_children (GTK_CONTAINER (priv->vbox)),
-                  calculate_visible_toolbars, &priv->visible_toolbars);
+  if (gtk_widget_get_visible (toolbar))
+    priv->visible_toolbars++;
+  else if (priv->visible_toolbars > 0)
+    priv->visible_toolbars--;
 
   if (priv->visible_toolbars == 0)
     gtk_widget_hide (priv->vbox);
@@ -1685,6 +2097,40 @@ toolbar_visible_notify                          (GtkWidget *toolbar, GParamSpec
     gtk_widget_show (priv->vbox);
 }
 
+/* Starts counting @toolbar, just packed in the toolbar box, among the
+ * visible toolbars. vbox_remove() stops it when it leaves the box. */
+static void
+hildon_window_track_toolbar                     (HildonWindow *window,
+                                                 GtkWidget    *toolbar)
+{
+  HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
+
+  g_signal_connect (G_OBJECT (toolbar), "notify::visible",
+                    G_CALLBACK (toolbar_visible_notify), window);
+
+  if (gtk_widget_get_visible (toolbar))
+    {
+      priv->visible_toolbars++;
+      gtk_widget_show (priv->vbox);
+    }
+}
+
+static void
+vbox_remove                                     (GtkContainer *vbox,
+                                                 GtkWidget    *toolbar,
+                                                 HildonWindow *window)
+{
+  HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
+
+  g_signal_handlers_disconnect_by_func (toolbar, toolbar_visible_notify, window);
+
+  if (gtk_widget_get_visible (toolbar) && priv->visible_toolbars > 0)
+    {
+      if (--(priv->visible_toolbars) == 0 && priv->vbox != NULL)
+        gtk_widget_hide (priv->vbox);
+    }
+}
+
 /**
  * hildon_window_add_toolbar:
  * @self: A #HildonWindow
@@ -1714,14 +2160,7 @@ hildon_window_add_toolbar                       (HildonWindow *self,
     gtk_box_reorder_child (vbox, GTK_WIDGET (toolbar), 0);
     gtk_widget_set_size_request (GTK_WIDGET (toolbar), -1, TOOLBAR_HEIGHT);
 
-    g_signal_connect (G_OBJECT (toolbar), "notify::visible",
-                      G_CALLBACK (toolbar_visible_notify), self);
-
-    if (gtk_widget_get_visible (GTK_WIDGET (toolbar)))
-      {
-        priv->visible_toolbars++;
-        gtk_widget_show (priv->vbox);
-      }
+    hildon_window_track_toolbar (self, GTK_WIDGET (toolbar));
 
     gtk_widget_queue_resize (GTK_WIDGET (self));
 }
@@ -1745,14 +2184,7 @@ hildon_window_remove_toolbar                    (HildonWindow *self,
     
     priv = HILDON_WINDOW_GET_PRIVATE (self);
 
-    if (gtk_widget_get_visible (GTK_WIDGET (toolbar)))
-      {
-        if (--(priv->visible_toolbars) == 0)
-          gtk_widget_hide (priv->vbox);
-      }
-
-    g_signal_handlers_disconnect_by_func (toolbar, toolbar_visible_notify, self);
-
+    /* vbox_remove() takes care of the visible toolbar count */
     gtk_container_remove (GTK_CONTAINER (priv->vbox), GTK_WIDGET (toolbar));
 }
 
@@ -2009,15 +2441,10 @@ hildon_window_update_markup                     (HildonWindow *window)
     HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
     GdkAtom markup_atom = gdk_atom_intern ("_HILDON_WM_NAME", FALSE);
     GdkAtom utf8_atom = gdk_atom_intern ("UTF8_STRING", FALSE);
-    GdkWindow *gdkwin = gtk_widget_get_window (GTK_WIDGET (window));
 
-    if (priv->markup) {
-        gdk_property_change (gdkwin, markup_atom, utf8_atom, 8,
-                             GDK_PROP_MODE_REPLACE, (const guchar *) priv->markup,
-                             strlen (priv->markup));
-    } else {
-        gdk_property_delete (gdkwin, markup_atom);
-    }
+    hildon_gtk_window_queue_property (GTK_WINDOW (window), markup_atom, utf8_atom, 8,
+                                      priv->markup,
+                                      priv->markup ? strlen (priv->markup) : 0);
 }
 
 /**
@@ -2080,3 +2507,58 @@ hildon_window_set_markup                        (HildonWindow *window,
 
     g_object_notify (G_OBJECT (window), "markup");
 }
+
+/**
+ * hildon_window_set_keep_orientation_layouts:
+ * @window: a #HildonWindow
+ * @keep: whether to keep the layouts
+ *
+ * Sets whether @window remembers where its toolbars and child were
+ * allocated in each orientation. When it is rotated back to an
+ * orientation it was already laid out in, and no size request in the
+ * window changed in the meantime, the parts are given their previous
+ * allocation right away instead of being measured and laid out again.
+ * Any change of size request in the window forgets both layouts, so
+ * they are revalidated on the next allocation.
+ *
+ * This is useful for windows that are rotated often, whose toolbars
+ * are expensive to measure.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_window_set_keep_orientation_layouts      (HildonWindow *window,
+                                                 gboolean      keep)
+{
+    HildonWindowPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_WINDOW (window));
+
+    priv = HILDON_WINDOW_GET_PRIVATE (window);
+
+    keep = keep ? TRUE : FALSE;
+    if (priv->keep_layouts == keep)
+        return;
+
+    priv->keep_layouts = keep;
+    hildon_window_forget_layouts (window);
+
+    g_object_notify (G_OBJECT (window), "keep-orientation-layouts");
+}
+
+/**
+ * hildon_window_get_keep_orientation_layouts:
+ * @window: a #HildonWindow
+ *
+ * Returns: whether @window remembers its layout in both orientations.
+ * See hildon_window_set_keep_orientation_layouts().
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_window_get_keep_orientation_layouts      (HildonWindow *window)
+{
+    g_return_val_if_fail (HILDON_IS_WINDOW (window), FALSE);
+
+    return HILDON_WINDOW_GET_PRIVATE (window)->keep_layouts;
+}
@@ -118,6 +118,13 @@ void
 hildon_window_set_markup                        (HildonWindow *window,
                                                  const gchar  *markup);
 
+void
+hildon_window_set_keep_orientation_layouts      (HildonWindow *window,
+                                                 gboolean      keep);
+
+gboolean
+hildon_window_get_keep_orientation_layouts      (HildonWindow *window);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_WINDOW_H__ */
@@ -44,6 +44,13 @@ struct                                          _HildonWizardDialogPrivate
     HildonWizardDialogPageFunc forward_function;
     gpointer forward_function_data;
     GDestroyNotify forward_data_destroy;
+
+    HildonWizardDialogAsyncPageFunc async_forward_function;
+    gpointer async_forward_function_data;
+    GDestroyNotify async_forward_data_destroy;
+    GCancellable *forward_cancellable;
+
+    gint lazy_page_window;
 };
 
 G_END_DECLS
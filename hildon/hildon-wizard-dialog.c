@@ -43,7 +43,16 @@
  *
  * It is possible to determinate whether users can go to the next page
  * by setting a #HildonWizardDialogPageFunc function with
- * hildon_wizard_dialog_set_forward_page_func()
+ * hildon_wizard_dialog_set_forward_page_func(). Checks that take
+ * time, like looking an account up on the network, can be done without
+ * blocking the dialog with hildon_wizard_dialog_set_async_forward_page_func().
+ *
+ * Wizards with many pages don't need to build all of them before the
+ * dialog is shown: pages added with hildon_wizard_dialog_append_lazy_page()
+ * are built by a #HildonWizardDialogPageBuilder the first time they are
+ * shown. The #HildonWizardDialog:lazy-page-window property makes the
+ * wizard also destroy these pages when the user moves far enough away
+ * from them; they are built again if the user comes back.
  */
 
 #ifdef                                          HAVE_CONFIG_H
@@ -56,6 +65,7 @@
 #include                                        "hildon-defines.h"
 #include                                        "hildon-wizard-dialog-private.h"
 #include                                        "hildon-stock.h"
+#include                                        "hildon-gtk.h"
 
 #define                                         _(String) dgettext("hildon-libs", String)
 
@@ -104,9 +114,22 @@ enum
     PROP_0,
     PROP_NAME,
     PROP_NOTEBOOK,
-    PROP_AUTOTITLE
+    PROP_AUTOTITLE,
+    PROP_LAZY_PAGE_WINDOW
 };
 
+/* What hildon_wizard_dialog_append_lazy_page() needs to build a page,
+ * attached to the empty box that holds its place in the notebook */
+typedef struct
+{
+    HildonWizardDialogPageBuilder builder;
+    gpointer data;
+    GDestroyNotify destroy;
+    GtkWidget *child;
+} HildonWizardLazyPage;
+
+#define                                         LAZY_PAGE_KEY "hildon-wizard-dialog-lazy-page"
+
 /**
  * hildon_wizard_dialog_get_type:
  *
@@ -198,6 +221,24 @@ hildon_wizard_dialog_class_init                 (HildonWizardDialogClass *wizard
              "If the wizard should autotitle itself",
              TRUE, 
              G_PARAM_READWRITE));
+
+    /**
+     * HildonWizardDialog:lazy-page-window:
+     *
+     * How many pages built by a #HildonWizardDialogPageBuilder are kept on
+     * each side of the current page. Pages further away are destroyed,
+     * and built again when they are shown. With -1, built pages are
+     * never destroyed.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_LAZY_PAGE_WINDOW,
+            g_param_spec_int
+            ("lazy-page-window",
+             "Lazy page window",
+             "How many lazily built pages to keep around the current one",
+             -1, G_MAXINT, -1,
+             G_PARAM_READWRITE));
 }
 
 static void 
@@ -231,6 +272,9 @@ destroy                                         (GtkWidget *object)
       priv->forward_function_data = NULL;
       priv->forward_data_destroy = NULL;
     }
+
+    hildon_wizard_dialog_set_async_forward_page_func (HILDON_WIZARD_DIALOG (object),
+                                                      NULL, NULL, NULL);
 }
 
 /* Disable or enable the Previous, Next and Finish buttons */
@@ -271,6 +315,13 @@ hildon_wizard_dialog_init                       (HildonWizardDialog *wizard_dial
     priv->forward_function_data = NULL;
     priv->forward_data_destroy = NULL;
 
+    priv->async_forward_function = NULL;
+    priv->async_forward_function_data = NULL;
+    priv->async_forward_data_destroy = NULL;
+    priv->forward_cancellable = NULL;
+
+    priv->lazy_page_window = -1;
+
     /* Add response buttons: finish, previous, next */
     gtk_dialog_add_button (dialog, HILDON_STOCK_FINISH, HILDON_WIZARD_DIALOG_FINISH);
     gtk_dialog_add_button (dialog, HILDON_STOCK_PREVIOUS, HILDON_WIZARD_DIALOG_PREVIOUS);
@@ -287,6 +338,67 @@ hildon_wizard_dialog_init                       (HildonWizardDialog *wizard_dial
             G_CALLBACK (response), NULL);
 }
 
+static void
+lazy_page_free                                  (gpointer data)
+{
+    HildonWizardLazyPage *lazy = data;
+
+    if (lazy->destroy)
+        lazy->destroy (lazy->data);
+
+    g_slice_free (HildonWizardLazyPage, lazy);
+}
+
+static void
+lazy_page_build                                 (HildonWizardDialog *wizard_dialog,
+                                                 GtkWidget *page,
+                                                 gint page_num)
+{
+    HildonWizardLazyPage *lazy = g_object_get_data (G_OBJECT (page), LAZY_PAGE_KEY);
+
+    if (lazy == NULL || lazy->child != NULL)
+        return;
+
+    lazy->child = lazy->builder (wizard_dialog, page_num, lazy->data);
+    g_return_if_fail (GTK_IS_WIDGET (lazy->child));
+
+    gtk_box_pack_start (GTK_BOX (page), lazy->child, TRUE, TRUE, 0);
+    gtk_widget_show (lazy->child);
+}
+
+/* Destroys the built lazy pages out of the window around @current */
+static void
+lazy_pages_prune                                (HildonWizardDialog *wizard_dialog,
+                                                 gint current)
+{
+    HildonWizardDialogPrivate *priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+    gint i, n;
+
+    if (priv->lazy_page_window < 0 || priv->notebook == NULL || current < 0)
+        return;
+
+    n = gtk_notebook_get_n_pages (priv->notebook);
+    for (i = 0; i < n; i++) {
+        GtkWidget *page = gtk_notebook_get_nth_page (priv->notebook, i);
+        HildonWizardLazyPage *lazy = g_object_get_data (G_OBJECT (page), LAZY_PAGE_KEY);
+
+        if (lazy && lazy->child && ABS (i - current) > priv->lazy_page_window) {
+            gtk_widget_destroy (lazy->child);
+            lazy->child = NULL;
+        }
+    }
+}
+
+static void
+notebook_switch_page                            (GtkNotebook *notebook,
+                                                 GtkWidget *page,
+                                                 guint page_num,
+                                                 HildonWizardDialog *wizard_dialog)
+{
+    lazy_page_build (wizard_dialog, page, page_num);
+    lazy_pages_prune (wizard_dialog, page_num);
+}
+
 static void
 hildon_wizard_dialog_set_property               (GObject *object, 
                                                  guint property_id,
@@ -312,6 +424,11 @@ hildon_wizard_dialog_set_property               (GObject *object,
                 gtk_window_set_title (GTK_WINDOW (object), priv->wizard_name);
             break;
 
+        case PROP_LAZY_PAGE_WINDOW:
+            hildon_wizard_dialog_set_lazy_page_window (HILDON_WIZARD_DIALOG (object),
+                                                       g_value_get_int (value));
+            break;
+
         case PROP_NAME: 
 
             /* Set new wizard name. This name will appear in titlebar */
@@ -341,6 +458,8 @@ hildon_wizard_dialog_set_property               (GObject *object,
              * and remove borders) to make it look like a nice wizard widget */
             gtk_notebook_set_show_tabs (priv->notebook, FALSE);
             gtk_notebook_set_show_border (priv->notebook, FALSE);
+            g_signal_connect_object (book, "switch-page",
+                                     G_CALLBACK (notebook_switch_page), object, 0);
             gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (dialog)), GTK_WIDGET (priv->notebook), TRUE, TRUE, 0);
 
             /* Show the notebook so that a gtk_widget_show on the dialog is
@@ -378,6 +497,10 @@ hildon_wizard_dialog_get_property               (GObject *object,
             g_value_set_object (value, priv->notebook);
             break;
 
+        case PROP_LAZY_PAGE_WINDOW:
+            g_value_set_int (value, priv->lazy_page_window);
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -425,6 +548,38 @@ create_title                                    (HildonWizardDialog *wizard_dial
     g_free (str);
 }
 
+/* Moves to the page after the current one */
+static void
+next_page                                       (HildonWizardDialog *wizard_dialog)
+{
+    HildonWizardDialogPrivate *priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+    GtkNotebook *notebook = priv->notebook;
+    gint current = gtk_notebook_get_current_page (notebook) + 1;
+    gint last = gtk_notebook_get_n_pages (notebook) - 1;
+    gboolean is_first = (current == 0);
+    gboolean is_last = (current == last);
+
+    make_buttons_sensitive (wizard_dialog, !is_first, !is_first, !is_last);
+    gtk_notebook_next_page (notebook);
+}
+
+/* Cancels the asynchronous forward check in progress, if any */
+static void
+cancel_forward_check                            (HildonWizardDialog *wizard_dialog)
+{
+    HildonWizardDialogPrivate *priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+    GCancellable *cancellable = priv->forward_cancellable;
+
+    if (cancellable == NULL)
+        return;
+
+    priv->forward_cancellable = NULL;
+    hildon_gtk_window_set_progress_indicator (GTK_WINDOW (wizard_dialog), 0);
+
+    g_cancellable_cancel (cancellable);
+    g_object_unref (cancellable);
+}
+
 /* Response signal handler. This function is needed because GtkDialog's 
  * handler for this signal closes the dialog and we don't want that, we 
  * want to change pages and, dimm certain response buttons. Overriding the 
@@ -449,6 +604,7 @@ response                                        (HildonWizardDialog *wizard_dial
     switch (response_id) {
 
         case HILDON_WIZARD_DIALOG_PREVIOUS:
+            cancel_forward_check (wizard_dialog);
             --current;
             is_last = (current == last);
             is_first = (current == 0);
@@ -459,20 +615,40 @@ response                                        (HildonWizardDialog *wizard_dial
 
         case HILDON_WIZARD_DIALOG_NEXT:
 
-          if (!priv->forward_function ||
-                (*priv->forward_function) (priv->notebook, current, priv->forward_function_data)) {
-              ++current;
-              is_last = (current == last);
-              is_first = (current == 0);
-              make_buttons_sensitive (wizard_dialog,
-                                      !is_first, !is_first, !is_last);
-              gtk_notebook_next_page (notebook); /* go to next page */
+            /* Presses while a check is in progress are ignored */
+            if (priv->forward_cancellable)
+                break;
+
+            if (priv->forward_function &&
+                !(*priv->forward_function) (priv->notebook, current, priv->forward_function_data))
+                break;
+
+            if (priv->async_forward_function) {
+                GCancellable *cancellable = g_cancellable_new ();
+
+                priv->forward_cancellable = cancellable;
+                hildon_gtk_window_set_progress_indicator (GTK_WINDOW (wizard_dialog), 1);
+
+                /* The dialog may be finished before this returns */
+                g_object_ref (cancellable);
+                (*priv->async_forward_function) (wizard_dialog, current, cancellable,
+                                                 priv->async_forward_function_data);
+                g_object_unref (cancellable);
+                break;
             }
+
+            next_page (wizard_dialog);
             break;
 
         case HILDON_WIZARD_DIALOG_FINISH:
+            cancel_forward_check (wizard_dialog);
             return;
 
+        default:
+            /* Cancel, or the dialog was closed */
+            cancel_forward_check (wizard_dialog);
+            break;
+
     }
 
     current = gtk_notebook_get_current_page (notebook);
@@ -550,3 +726,200 @@ hildon_wizard_dialog_set_forward_page_func      (HildonWizardDialog *wizard_dial
   priv->forward_function_data = data;
   priv->forward_data_destroy = destroy;
 }
+
+/**
+ * hildon_wizard_dialog_set_async_forward_page_func:
+ * @wizard_dialog: a #HildonWizardDialog
+ * @page_func: the #HildonWizardDialogAsyncPageFunc, or %NULL
+ * @data: user data for @page_func
+ * @destroy: destroy notifier for @data
+ *
+ * Sets a function that checks, without blocking the dialog, whether it
+ * is possible to go to the next page when the user presses the forward
+ * button. While the check is in progress, the progress indicator of the
+ * dialog is shown, and further presses of the forward button are
+ * ignored. Going back to the previous page, closing the dialog or
+ * setting another function cancels the check.
+ *
+ * A function set with hildon_wizard_dialog_set_forward_page_func() is
+ * still called first; @page_func is only called if it allows going
+ * forward.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_wizard_dialog_set_async_forward_page_func (HildonWizardDialog *wizard_dialog,
+                                                 HildonWizardDialogAsyncPageFunc page_func,
+                                                 gpointer data,
+                                                 GDestroyNotify destroy)
+{
+    HildonWizardDialogPrivate *priv;
+    GDestroyNotify old_destroy;
+    gpointer old_data;
+
+    g_return_if_fail (HILDON_IS_WIZARD_DIALOG (wizard_dialog));
+
+    priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+
+    cancel_forward_check (wizard_dialog);
+
+    old_destroy = priv->async_forward_data_destroy;
+    old_data = priv->async_forward_function_data;
+
+    priv->async_forward_function = page_func;
+    priv->async_forward_function_data = data;
+    priv->async_forward_data_destroy = destroy;
+
+    if (old_destroy && old_data)
+        (*old_destroy) (old_data);
+}
+
+/**
+ * hildon_wizard_dialog_forward_page_finished:
+ * @wizard_dialog: a #HildonWizardDialog
+ * @cancellable: the #GCancellable given to the
+ *               #HildonWizardDialogAsyncPageFunc
+ * @forward: whether the user can go to the next page
+ *
+ * Tells @wizard_dialog that the check started for @cancellable is
+ * done. If @forward is %TRUE, the wizard moves to the next page.
+ * Cancelled checks are ignored.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_wizard_dialog_forward_page_finished      (HildonWizardDialog *wizard_dialog,
+                                                 GCancellable *cancellable,
+                                                 gboolean forward)
+{
+    HildonWizardDialogPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_WIZARD_DIALOG (wizard_dialog));
+    g_return_if_fail (G_IS_CANCELLABLE (cancellable));
+
+    priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+
+    if (cancellable != priv->forward_cancellable)
+        return;
+
+    priv->forward_cancellable = NULL;
+    hildon_gtk_window_set_progress_indicator (GTK_WINDOW (wizard_dialog), 0);
+    g_object_unref (cancellable);
+
+    if (!forward)
+        return;
+
+    next_page (wizard_dialog);
+
+    if (priv->autotitle)
+        create_title (wizard_dialog);
+}
+
+/**
+ * hildon_wizard_dialog_append_lazy_page:
+ * @wizard_dialog: a #HildonWizardDialog
+ * @title: the title of the page, used as its notebook tab label, or %NULL
+ * @builder: the #HildonWizardDialogPageBuilder that builds the page
+ * @data: user data for @builder
+ * @destroy: destroy notifier for @data
+ *
+ * Appends a page to the notebook of @wizard_dialog without building it.
+ * @builder is called the first time the page is shown, so only the
+ * pages the user visits are ever built. If
+ * #HildonWizardDialog:lazy-page-window is set, the page may be destroyed
+ * when the user moves away from it, and @builder is called again when it
+ * is shown next. Any state that must survive this belongs in @data.
+ *
+ * @title is shown in the dialog title when the page is current, like the
+ * tab labels of the pages of the notebook.
+ *
+ * Returns: the number of the new page in the notebook, or -1 on error
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_wizard_dialog_append_lazy_page           (HildonWizardDialog *wizard_dialog,
+                                                 const gchar *title,
+                                                 HildonWizardDialogPageBuilder builder,
+                                                 gpointer data,
+                                                 GDestroyNotify destroy)
+{
+    HildonWizardDialogPrivate *priv;
+    HildonWizardLazyPage *lazy;
+    GtkWidget *page;
+
+    g_return_val_if_fail (HILDON_IS_WIZARD_DIALOG (wizard_dialog), -1);
+    g_return_val_if_fail (builder != NULL, -1);
+
+    priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+    g_return_val_if_fail (priv->notebook != NULL, -1);
+
+    lazy = g_slice_new0 (HildonWizardLazyPage);
+    lazy->builder = builder;
+    lazy->data = data;
+    lazy->destroy = destroy;
+
+    /* The page itself is an empty box, which holds the built widget */
+    page = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+    g_object_set_data_full (G_OBJECT (page), LAZY_PAGE_KEY, lazy, lazy_page_free);
+    gtk_widget_show (page);
+
+    /* Appending the first page makes it current, which builds it */
+    return gtk_notebook_append_page (priv->notebook, page,
+                                     title ? gtk_label_new (title) : NULL);
+}
+
+/**
+ * hildon_wizard_dialog_set_lazy_page_window:
+ * @wizard_dialog: a #HildonWizardDialog
+ * @window: the number of pages to keep on each side of the current
+ * page, or -1
+ *
+ * Sets the #HildonWizardDialog:lazy-page-window property.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_wizard_dialog_set_lazy_page_window       (HildonWizardDialog *wizard_dialog,
+                                                 gint window)
+{
+    HildonWizardDialogPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_WIZARD_DIALOG (wizard_dialog));
+    g_return_if_fail (window >= -1);
+
+    priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+
+    if (priv->lazy_page_window == window)
+        return;
+
+    priv->lazy_page_window = window;
+
+    if (priv->notebook)
+        lazy_pages_prune (wizard_dialog, gtk_notebook_get_current_page (priv->notebook));
+
+    g_object_notify (G_OBJECT (wizard_dialog), "lazy-page-window");
+}
+
+/**
+ * hildon_wizard_dialog_get_lazy_page_window:
+ * @wizard_dialog: a #HildonWizardDialog
+ *
+ * Gets the #HildonWizardDialog:lazy-page-window property.
+ *
+ * Returns: the number of lazily built pages kept on each side of the
+ * current page, or -1 if they are never destroyed
+ *
+ * Since: 3.0
+ **/
+gint
+hildon_wizard_dialog_get_lazy_page_window       (HildonWizardDialog *wizard_dialog)
+{
+    HildonWizardDialogPrivate *priv;
+
+    g_return_val_if_fail (HILDON_IS_WIZARD_DIALOG (wizard_dialog), -1);
+
+    priv = HILDON_WIZARD_DIALOG_GET_PRIVATE (wizard_dialog);
+
+    return priv->lazy_page_window;
+}
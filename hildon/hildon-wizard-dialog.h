@@ -90,6 +90,38 @@ struct                                          _HildonWizardDialogClass
 
 typedef gboolean (*HildonWizardDialogPageFunc) (GtkNotebook *notebook, gint current_page, gpointer data);
 
+/**
+ * HildonWizardDialogAsyncPageFunc:
+ * @wizard_dialog: the #HildonWizardDialog
+ * @current_page: the number of the current page
+ * @cancellable: a #GCancellable, cancelled when the result is not needed
+ * anymore
+ * @data: the data passed to hildon_wizard_dialog_set_async_forward_page_func()
+ *
+ * Starts checking whether the user can go past @current_page. The
+ * function must return right away, and call
+ * hildon_wizard_dialog_forward_page_finished() with @cancellable once
+ * the check is done.
+ *
+ * Since: 3.0
+ **/
+typedef void (*HildonWizardDialogAsyncPageFunc) (HildonWizardDialog *wizard_dialog, gint current_page, GCancellable *cancellable, gpointer data);
+
+/**
+ * HildonWizardDialogPageBuilder:
+ * @wizard_dialog: the #HildonWizardDialog
+ * @page_num: the number of the page in the notebook
+ * @data: the data passed to hildon_wizard_dialog_append_lazy_page()
+ *
+ * Builds the contents of a page added with
+ * hildon_wizard_dialog_append_lazy_page().
+ *
+ * Returns: a new widget, which the wizard shows on the page
+ *
+ * Since: 3.0
+ **/
+typedef GtkWidget* (*HildonWizardDialogPageBuilder) (HildonWizardDialog *wizard_dialog, gint page_num, gpointer data);
+
 GType G_GNUC_CONST
 hildon_wizard_dialog_get_type                   (void);
 
@@ -104,6 +136,31 @@ hildon_wizard_dialog_set_forward_page_func      (HildonWizardDialog *wizard_dial
                                                  gpointer data,
                                                  GDestroyNotify destroy);
 
+void
+hildon_wizard_dialog_set_async_forward_page_func (HildonWizardDialog *wizard_dialog,
+                                                 HildonWizardDialogAsyncPageFunc page_func,
+                                                 gpointer data,
+                                                 GDestroyNotify destroy);
+
+void
+hildon_wizard_dialog_forward_page_finished      (HildonWizardDialog *wizard_dialog,
+                                                 GCancellable *cancellable,
+                                                 gboolean forward);
+
+gint
+hildon_wizard_dialog_append_lazy_page           (HildonWizardDialog *wizard_dialog,
+                                                 const gchar *title,
+                                                 HildonWizardDialogPageBuilder builder,
+                                                 gpointer data,
+                                                 GDestroyNotify destroy);
+
+void
+hildon_wizard_dialog_set_lazy_page_window       (HildonWizardDialog *wizard_dialog,
+                                                 gint window);
+
+gint
+hildon_wizard_dialog_get_lazy_page_window       (HildonWizardDialog *wizard_dialog);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_WIZARD_DIALOG_H__ */
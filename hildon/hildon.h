@@ -49,12 +49,18 @@
 #include                                        "hildon-stackable-window.h"
 #include                                        "hildon-window-stack.h"
 #include                                        "hildon-animation-actor.h"
+#include                                        "hildon-animation-group.h"
 #include                                        "hildon-wizard-dialog.h"
 #include                                        "hildon-pannable-area.h"
 #include                                        "hildon-entry.h"
 #include                                        "hildon-text-view.h"
 #include                                        "hildon-app-menu.h"
 #include                                        "hildon-button.h"
+#include                                        "hildon-cell-renderer-button.h"
+#include                                        "hildon-cell-renderer-check.h"
+#include                                        "hildon-thumbnail-loader.h"
+#include                                        "hildon-recycler-list.h"
+#include                                        "hildon-tile-grid.h"
 #include                                        "hildon-check-button.h"
 #include                                        "hildon-gtk.h"
 #include                                        "hildon-main.h"
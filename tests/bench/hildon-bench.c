@@ -0,0 +1,555 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Benchmarks for libhildon hot paths, run with "make bench".
+ *
+ * Every benchmark works on data generated from a fixed seed, so runs
+ * are comparable between releases. Results are printed on stdout as a
+ * JSON object with one entry per benchmark. The benchmarks that need a
+ * display are reported as skipped when there is none; "make bench"
+ * runs the program under xvfb-run when $DISPLAY is not set.
+ *
+ * Usage: hildon-bench [-n ITERATIONS] [-f FILTER]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include <hildon/hildon.h>
+
+#define BENCH_SEED 20090601
+
+typedef void (*BenchFunc) (gpointer data);
+
+static gint n_iterations = 20;
+static const gchar *filter = NULL;
+static gboolean have_display = FALSE;
+static gboolean first_result = TRUE;
+
+/* -------------------- Corpus -------------------- */
+
+static const gchar *syllables[] = {
+  "an", "ber", "ca", "dé", "el", "fi", "gö", "ha", "in", "jo", "ka", "lä",
+  "mi", "no", "ös", "pe", "qu", "ri", "sa", "to", "ür", "va", "wi", "xe",
+  "ya", "zo", "ñe", "ça", "ři", "ły"
+};
+
+/* A contact-list like corpus: one to three capitalized words made of
+ * latin syllables, some of them accented */
+static gchar **
+make_corpus                                     (guint n)
+{
+  GRand *rand = g_rand_new_with_seed (BENCH_SEED);
+  gchar **corpus = g_new0 (gchar *, n + 1);
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    GString *s = g_string_new (NULL);
+    gint words = g_rand_int_range (rand, 1, 4);
+    gint w;
+
+    for (w = 0; w < words; w++) {
+      gint len = g_rand_int_range (rand, 2, 5);
+      const gchar *first;
+      gint k;
+
+      if (w > 0)
+        g_string_append_c (s, ' ');
+
+      /* Capitalize the first syllable the UTF-8 way */
+      first = syllables[g_rand_int_range (rand, 0, G_N_ELEMENTS (syllables))];
+      g_string_append_unichar (s, g_unichar_toupper (g_utf8_get_char (first)));
+      g_string_append (s, g_utf8_next_char (first));
+
+      for (k = 1; k < len; k++)
+        g_string_append (s, syllables[g_rand_int_range (rand, 0, G_N_ELEMENTS (syllables))]);
+    }
+
+    corpus[i] = g_string_free (s, FALSE);
+  }
+
+  g_rand_free (rand);
+
+  return corpus;
+}
+
+static GtkListStore *
+make_store                                      (gchar **corpus)
+{
+  GtkListStore *store = gtk_list_store_new (1, G_TYPE_STRING);
+  GtkTreeIter iter;
+  gint i;
+
+  for (i = 0; corpus[i] != NULL; i++)
+    gtk_list_store_insert_with_values (store, &iter, -1, 0, corpus[i], -1);
+
+  return store;
+}
+
+static void
+flush_events                                    (void)
+{
+  gdk_display_sync (gdk_display_get_default ());
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+/* -------------------- Runner -------------------- */
+
+static gint
+compare_times                                   (gconstpointer a,
+                                                 gconstpointer b)
+{
+  gint64 ta = *(const gint64 *) a;
+  gint64 tb = *(const gint64 *) b;
+
+  return ta < tb ? -1 : ta > tb;
+}
+
+static void
+print_header                                    (const gchar *name)
+{
+  g_print ("%s\n    {\"name\": \"%s\", ", first_result ? "" : ",", name);
+  first_result = FALSE;
+}
+
+static void
+report_skipped                                  (const gchar *name,
+                                                 const gchar *reason)
+{
+  print_header (name);
+  g_print ("\"skipped\": \"%s\"}", reason);
+}
+
+/* Runs @func once to warm caches up, then @n_iterations times, and
+ * reports the time per iteration */
+static void
+run_bench                                       (const gchar *name,
+                                                 gboolean     needs_display,
+                                                 BenchFunc    func,
+                                                 gpointer     data)
+{
+  gint64 *times;
+  gint64 total = 0;
+  gint i;
+
+  if (filter && strstr (name, filter) == NULL)
+    return;
+
+  if (needs_display && !have_display) {
+    report_skipped (name, "no display");
+    return;
+  }
+
+  func (data);
+
+  times = g_new (gint64, n_iterations);
+  for (i = 0; i < n_iterations; i++) {
+    gint64 start = g_get_monotonic_time ();
+    func (data);
+    times[i] = g_get_monotonic_time () - start;
+    total += times[i];
+  }
+
+  qsort (times, n_iterations, sizeof (gint64), compare_times);
+
+  print_header (name);
+  g_print ("\"iterations\": %d, \"min_us\": %lld, \"median_us\": %lld, "
+           "\"mean_us\": %lld, \"max_us\": %lld}",
+           n_iterations, (long long) times[0],
+           (long long) times[n_iterations / 2],
+           (long long) (total / n_iterations),
+           (long long) times[n_iterations - 1]);
+
+  g_free (times);
+}
+
+/* -------------------- Helper benchmarks -------------------- */
+
+static const gchar *needles[] = { "a", "ber", "de", "kal", "ño", "sa to", "zzz" };
+
+static void
+bench_smart_match                               (gpointer data)
+{
+  gchar **corpus = data;
+  guint i, n;
+
+  for (n = 0; n < G_N_ELEMENTS (needles); n++)
+    for (i = 0; corpus[i] != NULL; i++)
+      g_free (hildon_helper_smart_match (corpus[i], needles[n]));
+}
+
+static void
+bench_smart_match_needle                        (gpointer data)
+{
+  gchar **corpus = data;
+  guint i, n;
+
+  for (n = 0; n < G_N_ELEMENTS (needles); n++) {
+    HildonHelperNeedle *needle = hildon_helper_needle_new (needles[n]);
+
+    for (i = 0; corpus[i] != NULL; i++)
+      g_free (hildon_helper_smart_match_needle (corpus[i], needle));
+
+    hildon_helper_needle_free (needle);
+  }
+}
+
+static void
+bench_strip_string                              (gpointer data)
+{
+  gchar **corpus = data;
+  guint i;
+
+  for (i = 0; corpus[i] != NULL; i++)
+    g_free (hildon_helper_strip_string (corpus[i]));
+}
+
+/* -------------------- Live search -------------------- */
+
+typedef struct
+{
+  HildonLiveSearch *live_search;
+  GtkTreeModel *filter;
+} LiveSearchBench;
+
+static LiveSearchBench *
+live_search_bench_new                           (guint n_rows)
+{
+  LiveSearchBench *bench = g_new0 (LiveSearchBench, 1);
+  gchar **corpus = make_corpus (n_rows);
+  GtkListStore *store = make_store (corpus);
+
+  g_strfreev (corpus);
+
+  bench->filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  g_object_unref (store);
+
+  bench->live_search = HILDON_LIVE_SEARCH (hildon_live_search_new ());
+  g_object_ref_sink (bench->live_search);
+  hildon_live_search_set_filter (bench->live_search,
+                                 GTK_TREE_MODEL_FILTER (bench->filter));
+  hildon_live_search_set_text_column (bench->live_search, 0);
+
+  return bench;
+}
+
+static void
+live_search_bench_free                          (LiveSearchBench *bench)
+{
+  gtk_widget_destroy (GTK_WIDGET (bench->live_search));
+  g_object_unref (bench->live_search);
+  g_object_unref (bench->filter);
+  g_free (bench);
+}
+
+/* Types a name one letter at a time and erases it again */
+static void
+bench_live_search                               (gpointer data)
+{
+  LiveSearchBench *bench = data;
+  const gchar *typed[] = { "b", "be", "ber", "berk", "ber", "be", "b", "" };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (typed); i++)
+    hildon_live_search_set_text (bench->live_search, typed[i]);
+}
+
+static void
+run_live_search_bench                           (const gchar *name,
+                                                 guint        n_rows)
+{
+  LiveSearchBench *bench;
+
+  if (filter && strstr (name, filter) == NULL)
+    return;
+
+  if (!have_display) {
+    report_skipped (name, "no display");
+    return;
+  }
+
+  bench = live_search_bench_new (n_rows);
+  run_bench (name, TRUE, bench_live_search, bench);
+  live_search_bench_free (bench);
+}
+
+/* -------------------- Touch selector -------------------- */
+
+static void
+bench_selector_populate                         (gpointer data)
+{
+  gchar **corpus = data;
+  GtkWidget *selector = hildon_touch_selector_new_text ();
+  gint i;
+
+  g_object_ref_sink (selector);
+  for (i = 0; corpus[i] != NULL; i++)
+    hildon_touch_selector_append_text (HILDON_TOUCH_SELECTOR (selector), corpus[i]);
+
+  gtk_widget_destroy (selector);
+  g_object_unref (selector);
+}
+
+static void
+bench_selector_populate_sorted                  (gpointer data)
+{
+  gchar **corpus = data;
+  GtkWidget *selector = hildon_touch_selector_new_text_sorted ();
+
+  g_object_ref_sink (selector);
+  hildon_touch_selector_append_text_array (HILDON_TOUCH_SELECTOR (selector),
+                                           (const gchar * const *) corpus, -1);
+
+  gtk_widget_destroy (selector);
+  g_object_unref (selector);
+}
+
+static gint
+collate_rows                                    (GtkTreeModel *model,
+                                                 GtkTreeIter  *a,
+                                                 GtkTreeIter  *b,
+                                                 gpointer      data)
+{
+  gchar *text_a, *text_b;
+  gint result;
+
+  gtk_tree_model_get (model, a, 0, &text_a, -1);
+  gtk_tree_model_get (model, b, 0, &text_b, -1);
+  result = g_utf8_collate (text_a, text_b);
+  g_free (text_a);
+  g_free (text_b);
+
+  return result;
+}
+
+/* What applications do without hildon_touch_selector_new_text_sorted() */
+static void
+bench_tree_model_sort_collate                   (gpointer data)
+{
+  GtkListStore *store = make_store (data);
+  GtkTreeModel *sort = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+  GtkTreeIter iter;
+
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (sort), 0,
+                                   collate_rows, NULL, NULL);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort), 0,
+                                        GTK_SORT_ASCENDING);
+
+  /* The sort model builds, and sorts, its rows on first access */
+  gtk_tree_model_get_iter_first (sort, &iter);
+
+  g_object_unref (sort);
+  g_object_unref (store);
+}
+
+typedef struct
+{
+  GtkWidget *window;
+  HildonTouchSelector *selector;
+  gint n_rows;
+  gint row;
+} SelectorBench;
+
+static void
+bench_center_on_selected                        (gpointer data)
+{
+  SelectorBench *bench = data;
+
+  bench->row = (bench->row + bench->n_rows / 7) % bench->n_rows;
+  hildon_touch_selector_set_active (bench->selector, 0, bench->row);
+  hildon_touch_selector_center_on_selected (bench->selector);
+  flush_events ();
+}
+
+static void
+run_center_on_selected_bench                    (const gchar  *name,
+                                                 gchar       **corpus)
+{
+  SelectorBench bench = { NULL, NULL, 0, 0 };
+  gint i;
+
+  if (filter && strstr (name, filter) == NULL)
+    return;
+
+  if (!have_display) {
+    report_skipped (name, "no display");
+    return;
+  }
+
+  bench.window = hildon_window_new ();
+  bench.selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+  for (i = 0; corpus[i] != NULL; i++)
+    hildon_touch_selector_append_text (bench.selector, corpus[i]);
+  bench.n_rows = i;
+
+  gtk_container_add (GTK_CONTAINER (bench.window), GTK_WIDGET (bench.selector));
+  gtk_widget_show_all (bench.window);
+  flush_events ();
+
+  run_bench (name, TRUE, bench_center_on_selected, &bench);
+
+  gtk_widget_destroy (bench.window);
+}
+
+/* -------------------- Picker dialog -------------------- */
+
+static void
+bench_picker_button_open                        (gpointer data)
+{
+  GtkWidget *button = data;
+  GtkWidget *toplevel;
+
+  gtk_button_clicked (GTK_BUTTON (button));
+  flush_events ();
+
+  /* The dialog is on top of the window group, close it as the user would */
+  toplevel = gtk_widget_get_toplevel (GTK_WIDGET (hildon_picker_button_get_selector
+                                                  (HILDON_PICKER_BUTTON (button))));
+  if (GTK_IS_DIALOG (toplevel))
+    gtk_dialog_response (GTK_DIALOG (toplevel), GTK_RESPONSE_DELETE_EVENT);
+  flush_events ();
+}
+
+static void
+run_picker_dialog_bench                         (const gchar  *name,
+                                                 gchar       **corpus)
+{
+  GtkWidget *window, *button;
+  HildonTouchSelector *selector;
+  gint i;
+
+  if (filter && strstr (name, filter) == NULL)
+    return;
+
+  if (!have_display) {
+    report_skipped (name, "no display");
+    return;
+  }
+
+  window = hildon_window_new ();
+  button = hildon_picker_button_new (HILDON_SIZE_FINGER_HEIGHT,
+                                     HILDON_BUTTON_ARRANGEMENT_VERTICAL);
+  hildon_button_set_title (HILDON_BUTTON (button), "Contact");
+
+  selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+  for (i = 0; corpus[i] != NULL; i++)
+    hildon_touch_selector_append_text (selector, corpus[i]);
+  hildon_picker_button_set_selector (HILDON_PICKER_BUTTON (button), selector);
+
+  gtk_container_add (GTK_CONTAINER (window), button);
+  gtk_widget_show_all (window);
+  flush_events ();
+
+  run_bench (name, TRUE, bench_picker_button_open, button);
+
+  gtk_widget_destroy (window);
+}
+
+/* -------------------- Window stack -------------------- */
+
+#define STACK_DEPTH 5
+
+static void
+bench_window_stack                              (gpointer data)
+{
+  HildonWindowStack *stack = hildon_window_stack_get_default ();
+  gint i;
+
+  for (i = 0; i < STACK_DEPTH; i++) {
+    GtkWidget *win = hildon_stackable_window_new ();
+    gtk_container_add (GTK_CONTAINER (win), gtk_label_new ("Window"));
+    gtk_widget_show_all (win);
+    flush_events ();
+  }
+
+  for (i = 0; i < STACK_DEPTH; i++) {
+    gtk_widget_destroy (hildon_window_stack_pop_1 (stack));
+    flush_events ();
+  }
+}
+
+/* -------------------- Main -------------------- */
+
+int
+main                                            (int    argc,
+                                                 char **argv)
+{
+  GOptionEntry entries[] = {
+    { "iterations", 'n', 0, G_OPTION_ARG_INT, &n_iterations,
+      "Number of timed runs per benchmark", "N" },
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+      "Only run the benchmarks whose name contains TEXT", "TEXT" },
+    { NULL }
+  };
+  GOptionContext *context;
+  GError *error = NULL;
+  gchar **corpus_1k, **corpus_10k;
+
+  context = g_option_context_new ("- run the libhildon benchmarks");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (n_iterations < 1)
+    n_iterations = 1;
+
+  have_display = gtk_init_check (&argc, &argv);
+  if (have_display)
+    hildon_init ();
+
+  corpus_1k = make_corpus (1000);
+  corpus_10k = make_corpus (10000);
+
+  g_print ("{\n  \"version\": \"%d.%d.%d\",\n  \"iterations\": %d,\n"
+           "  \"display\": %s,\n  \"benchmarks\": [",
+           HILDON_MAJOR_VERSION, HILDON_MINOR_VERSION, HILDON_MICRO_VERSION,
+           n_iterations, have_display ? "true" : "false");
+
+  run_bench ("helper/smart-match/10k", FALSE, bench_smart_match, corpus_10k);
+  run_bench ("helper/smart-match-needle/10k", FALSE, bench_smart_match_needle, corpus_10k);
+  run_bench ("helper/strip-string/10k", FALSE, bench_strip_string, corpus_10k);
+
+  run_live_search_bench ("live-search/refilter/1k", 1000);
+  run_live_search_bench ("live-search/refilter/10k", 10000);
+  run_live_search_bench ("live-search/refilter/100k", 100000);
+
+  run_bench ("touch-selector/populate/1k", TRUE, bench_selector_populate, corpus_1k);
+  run_bench ("touch-selector/populate-sorted/10k", TRUE, bench_selector_populate_sorted, corpus_10k);
+  run_bench ("touch-selector/tree-model-sort-collate/10k", FALSE, bench_tree_model_sort_collate, corpus_10k);
+  run_center_on_selected_bench ("touch-selector/center-on-selected/1k", corpus_1k);
+
+  run_picker_dialog_bench ("picker-dialog/open-close/1k", corpus_1k);
+
+  run_bench ("window-stack/push-pop/5", TRUE, bench_window_stack, NULL);
+
+  g_print ("\n  ]\n}\n");
+
+  g_strfreev (corpus_1k);
+  g_strfreev (corpus_10k);
+
+  return 0;
+}
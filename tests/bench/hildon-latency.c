@@ -0,0 +1,570 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * End-to-end input latency of a few interactions, run with
+ * "make latency".
+ *
+ * Each scenario sets up the same widgets as one of the programs in
+ * examples/, then sends real input events through the XTest extension:
+ * taps on a picker button, letters typed into a live search, a tap
+ * that pushes a stackable window. The latency is the time from sending
+ * an event to the end of the first frame painted after the widgets
+ * reacted to it, measured with the GdkFrameClock of the window that
+ * displays the result. As with hildon-bench, the data comes from a
+ * fixed seed and the results are printed as JSON, so runs of different
+ * builds can be compared. "make latency" runs the program under
+ * xvfb-run when $DISPLAY is not set.
+ *
+ * Usage: hildon-latency [-n ITERATIONS] [-f FILTER]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+#include <gdk/gdkkeysyms.h>
+#include <X11/extensions/XTest.h>
+#include <hildon/hildon.h>
+
+#define LATENCY_SEED 20090601
+
+/* Give up on an event when nothing was painted after this long */
+#define LATENCY_TIMEOUT_US (2 * G_USEC_PER_SEC)
+
+static gint n_iterations = 20;
+static const gchar *filter = NULL;
+static gboolean first_result = TRUE;
+
+/* -------------------- Input and frames -------------------- */
+
+typedef struct
+{
+  gint64 sent;
+  gint64 painted;
+  gboolean reacted;
+  GtkWidget *frame_widget;
+  GdkFrameClock *clock;
+  gulong paint_id;
+} Measure;
+
+static Measure measure;
+
+static void
+flush_events                                    (void)
+{
+  gdk_display_sync (gdk_display_get_default ());
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+static void
+on_after_paint                                  (GdkFrameClock *clock,
+                                                 gpointer       data)
+{
+  if (measure.painted == 0)
+    measure.painted = g_get_monotonic_time ();
+}
+
+/* Called by the scenarios when the widgets reacted to the input. The
+ * next frame painted for @widget ends the measure */
+static void
+measure_reacted                                 (GtkWidget *widget)
+{
+  if (measure.reacted)
+    return;
+
+  measure.reacted = TRUE;
+  measure.frame_widget = widget;
+}
+
+static void
+measure_begin                                   (void)
+{
+  memset (&measure, 0, sizeof (Measure));
+  measure.sent = g_get_monotonic_time ();
+}
+
+/* Runs the main loop until a frame was painted after the reaction.
+ * Returns the latency in microseconds, or -1 on timeout */
+static gint64
+measure_end                                     (void)
+{
+  gint64 deadline = measure.sent + LATENCY_TIMEOUT_US;
+
+  while (measure.painted == 0 && g_get_monotonic_time () < deadline) {
+    if (measure.reacted && measure.clock == NULL) {
+      measure.clock = gtk_widget_get_frame_clock (measure.frame_widget);
+      if (measure.clock) {
+        measure.paint_id = g_signal_connect (measure.clock, "after-paint",
+                                             G_CALLBACK (on_after_paint), NULL);
+        /* The reaction may not have queued any drawing */
+        gtk_widget_queue_draw (measure.frame_widget);
+      }
+    }
+
+    if (gtk_events_pending ())
+      gtk_main_iteration ();
+    else
+      g_usleep (200);
+  }
+
+  if (measure.clock)
+    g_signal_handler_disconnect (measure.clock, measure.paint_id);
+
+  return measure.painted ? measure.painted - measure.sent : -1;
+}
+
+static Display *
+xdisplay                                        (void)
+{
+  return GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+}
+
+/* Moves the pointer to the middle of @widget and taps it */
+static void
+send_tap                                        (GtkWidget *widget)
+{
+  GtkWidget *toplevel = gtk_widget_get_toplevel (widget);
+  GtkAllocation allocation;
+  gint x, y, ox, oy;
+
+  gtk_widget_get_allocation (widget, &allocation);
+  gtk_widget_translate_coordinates (widget, toplevel,
+                                    allocation.width / 2, allocation.height / 2,
+                                    &x, &y);
+  gdk_window_get_origin (gtk_widget_get_window (toplevel), &ox, &oy);
+
+  XTestFakeMotionEvent (xdisplay (), -1, ox + x, oy + y, CurrentTime);
+  XSync (xdisplay (), False);
+  flush_events ();
+
+  measure_begin ();
+  XTestFakeButtonEvent (xdisplay (), 1, True, CurrentTime);
+  XTestFakeButtonEvent (xdisplay (), 1, False, CurrentTime);
+  XFlush (xdisplay ());
+}
+
+static void
+send_key                                        (GtkWidget *toplevel,
+                                                 guint      keyval)
+{
+  KeyCode keycode = XKeysymToKeycode (xdisplay (), keyval);
+
+  gdk_window_focus (gtk_widget_get_window (toplevel), GDK_CURRENT_TIME);
+  flush_events ();
+
+  measure_begin ();
+  XTestFakeKeyEvent (xdisplay (), keycode, True, CurrentTime);
+  XTestFakeKeyEvent (xdisplay (), keycode, False, CurrentTime);
+  XFlush (xdisplay ());
+}
+
+static void
+show_and_wait                                   (GtkWidget *window)
+{
+  gtk_widget_show_all (window);
+  while (!gtk_widget_get_mapped (window))
+    gtk_main_iteration ();
+  flush_events ();
+}
+
+/* -------------------- Runner -------------------- */
+
+typedef gint64 (*ScenarioFunc) (gpointer data);
+
+static gint
+compare_times                                   (gconstpointer a,
+                                                 gconstpointer b)
+{
+  gint64 ta = *(const gint64 *) a;
+  gint64 tb = *(const gint64 *) b;
+
+  return ta < tb ? -1 : ta > tb;
+}
+
+static void
+print_header                                    (const gchar *name)
+{
+  g_print ("%s\n    {\"name\": \"%s\", ", first_result ? "" : ",", name);
+  first_result = FALSE;
+}
+
+static gboolean
+scenario_selected                               (const gchar *name)
+{
+  return filter == NULL || strstr (name, filter) != NULL;
+}
+
+/* Runs @func once as a warm up, then @n_iterations times, and reports
+ * the latencies of the runs that did not time out */
+static void
+run_scenario                                    (const gchar  *name,
+                                                 ScenarioFunc  func,
+                                                 gpointer      data)
+{
+  gint64 *times;
+  gint64 total = 0;
+  gint n = 0;
+  gint timeouts = 0;
+  gint i;
+
+  func (data);
+
+  times = g_new (gint64, n_iterations);
+  for (i = 0; i < n_iterations; i++) {
+    gint64 latency = func (data);
+
+    if (latency < 0) {
+      timeouts++;
+    } else {
+      times[n++] = latency;
+      total += latency;
+    }
+  }
+
+  print_header (name);
+
+  if (n == 0) {
+    g_print ("\"iterations\": %d, \"timeouts\": %d}", n_iterations, timeouts);
+    g_free (times);
+    return;
+  }
+
+  qsort (times, n, sizeof (gint64), compare_times);
+
+  g_print ("\"iterations\": %d, \"timeouts\": %d, \"min_us\": %lld, "
+           "\"median_us\": %lld, \"p90_us\": %lld, \"mean_us\": %lld, "
+           "\"max_us\": %lld}",
+           n_iterations, timeouts, (long long) times[0],
+           (long long) times[n / 2], (long long) times[(n * 9) / 10],
+           (long long) (total / n), (long long) times[n - 1]);
+
+  g_free (times);
+}
+
+static gchar **
+make_corpus                                     (guint n)
+{
+  static const gchar *syllables[] = {
+    "an", "ber", "ca", "de", "el", "fi", "go", "ha", "in", "jo", "ka", "la",
+    "mi", "no", "os", "pe", "qu", "ri", "sa", "to", "ur", "va", "wi", "xe"
+  };
+  GRand *rand = g_rand_new_with_seed (LATENCY_SEED);
+  gchar **corpus = g_new0 (gchar *, n + 1);
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    GString *s = g_string_new (NULL);
+    gint len = g_rand_int_range (rand, 2, 6);
+    gint k;
+
+    for (k = 0; k < len; k++)
+      g_string_append (s, syllables[g_rand_int_range (rand, 0, G_N_ELEMENTS (syllables))]);
+
+    corpus[i] = g_string_free (s, FALSE);
+  }
+
+  g_rand_free (rand);
+
+  return corpus;
+}
+
+/* -------------------- Picker button tap -------------------- */
+
+/* As in hildon-picker-button-example: the time until the picker
+ * dialog painted its first frame */
+
+static void
+on_picker_clicked                               (GtkWidget *button,
+                                                 gpointer   data)
+{
+  GtkWidget *selector = GTK_WIDGET (hildon_picker_button_get_selector
+                                    (HILDON_PICKER_BUTTON (button)));
+
+  measure_reacted (gtk_widget_get_toplevel (selector));
+}
+
+static gint64
+scenario_picker_tap                             (gpointer data)
+{
+  GtkWidget *button = data;
+  GtkWidget *toplevel;
+  gint64 latency;
+
+  send_tap (button);
+  latency = measure_end ();
+
+  toplevel = gtk_widget_get_toplevel (GTK_WIDGET (hildon_picker_button_get_selector
+                                                  (HILDON_PICKER_BUTTON (button))));
+  if (GTK_IS_DIALOG (toplevel))
+    gtk_dialog_response (GTK_DIALOG (toplevel), GTK_RESPONSE_DELETE_EVENT);
+  flush_events ();
+
+  return latency;
+}
+
+static void
+run_picker_tap                                  (const gchar  *name,
+                                                 gchar       **corpus)
+{
+  GtkWidget *window, *button;
+  HildonTouchSelector *selector;
+  gint i;
+
+  if (!scenario_selected (name))
+    return;
+
+  window = hildon_window_new ();
+  button = hildon_picker_button_new (HILDON_SIZE_FINGER_HEIGHT,
+                                     HILDON_BUTTON_ARRANGEMENT_VERTICAL);
+  hildon_button_set_title (HILDON_BUTTON (button), "Contact");
+
+  selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+  for (i = 0; corpus[i] != NULL; i++)
+    hildon_touch_selector_append_text (selector, corpus[i]);
+  hildon_picker_button_set_selector (HILDON_PICKER_BUTTON (button), selector);
+
+  g_signal_connect_after (button, "clicked", G_CALLBACK (on_picker_clicked), NULL);
+
+  gtk_container_add (GTK_CONTAINER (window), button);
+  show_and_wait (window);
+
+  run_scenario (name, scenario_picker_tap, button);
+
+  gtk_widget_destroy (window);
+  flush_events ();
+}
+
+/* -------------------- Live search typing -------------------- */
+
+/* As in hildon-live-search-example: the time from a key press until
+ * the filtered list was painted */
+
+typedef struct
+{
+  GtkWidget *window;
+  HildonLiveSearch *live;
+  guint next;
+} LiveSearchScenario;
+
+static gboolean
+on_refilter                                     (HildonLiveSearch *live,
+                                                 gpointer          data)
+{
+  LiveSearchScenario *scenario = data;
+
+  measure_reacted (scenario->window);
+
+  return FALSE;
+}
+
+static gint64
+scenario_live_search_type                       (gpointer data)
+{
+  static const guint keys[] = { GDK_KEY_b, GDK_KEY_e, GDK_KEY_r, GDK_KEY_a };
+  LiveSearchScenario *scenario = data;
+  gint64 latency;
+
+  /* Type one more letter of the same word, starting over after four */
+  if (scenario->next == G_N_ELEMENTS (keys)) {
+    hildon_live_search_set_text (scenario->live, "");
+    scenario->next = 0;
+    flush_events ();
+  }
+
+  send_key (scenario->window, keys[scenario->next++]);
+  latency = measure_end ();
+  flush_events ();
+
+  return latency;
+}
+
+static void
+run_live_search_type                            (const gchar  *name,
+                                                 gchar       **corpus)
+{
+  LiveSearchScenario scenario = { NULL, NULL, 0 };
+  GtkWidget *panarea, *vbox, *treeview;
+  GtkListStore *store;
+  GtkTreeModel *model;
+  gint i;
+
+  if (!scenario_selected (name))
+    return;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; corpus[i] != NULL; i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, corpus[i], -1);
+  model = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  g_object_unref (store);
+
+  treeview = gtk_tree_view_new_with_model (model);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (treeview), 0, "Name",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0, NULL);
+
+  scenario.window = hildon_window_new ();
+  scenario.live = HILDON_LIVE_SEARCH (hildon_live_search_new ());
+  hildon_live_search_set_filter (scenario.live, GTK_TREE_MODEL_FILTER (model));
+  hildon_live_search_set_text_column (scenario.live, 0);
+  hildon_live_search_widget_hook (scenario.live, scenario.window, treeview);
+  g_object_unref (model);
+
+  g_signal_connect_after (scenario.live, "refilter", G_CALLBACK (on_refilter), &scenario);
+
+  vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  panarea = hildon_pannable_area_new ();
+  gtk_container_add (GTK_CONTAINER (panarea), treeview);
+  gtk_box_pack_start (GTK_BOX (vbox), panarea, TRUE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (vbox), GTK_WIDGET (scenario.live), FALSE, FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (scenario.window), vbox);
+  show_and_wait (scenario.window);
+
+  run_scenario (name, scenario_live_search_type, &scenario);
+
+  gtk_widget_destroy (scenario.window);
+  flush_events ();
+}
+
+/* -------------------- Stackable window push -------------------- */
+
+/* As in hildon-stackable-window-example: the time from tapping a
+ * button until the pushed window painted its first frame */
+
+static GtkWidget *pushed_window = NULL;
+
+static void
+on_push_clicked                                 (GtkWidget *button,
+                                                 gpointer   data)
+{
+  pushed_window = hildon_stackable_window_new ();
+  gtk_container_add (GTK_CONTAINER (pushed_window), gtk_label_new ("Pushed window"));
+  gtk_widget_show_all (pushed_window);
+
+  measure_reacted (pushed_window);
+}
+
+static gint64
+scenario_window_push                            (gpointer data)
+{
+  GtkWidget *button = data;
+  gint64 latency;
+
+  send_tap (button);
+  latency = measure_end ();
+
+  if (pushed_window) {
+    gtk_widget_destroy (pushed_window);
+    pushed_window = NULL;
+  }
+  flush_events ();
+
+  return latency;
+}
+
+static void
+run_window_push                                 (const gchar *name)
+{
+  GtkWidget *window, *button;
+
+  if (!scenario_selected (name))
+    return;
+
+  window = hildon_stackable_window_new ();
+  button = hildon_button_new_with_text (HILDON_SIZE_FINGER_HEIGHT,
+                                        HILDON_BUTTON_ARRANGEMENT_VERTICAL,
+                                        "Push", NULL);
+  g_signal_connect (button, "clicked", G_CALLBACK (on_push_clicked), NULL);
+
+  gtk_container_add (GTK_CONTAINER (window), button);
+  show_and_wait (window);
+
+  run_scenario (name, scenario_window_push, button);
+
+  gtk_widget_destroy (window);
+  flush_events ();
+}
+
+/* -------------------- Main -------------------- */
+
+int
+main                                            (int    argc,
+                                                 char **argv)
+{
+  GOptionEntry entries[] = {
+    { "iterations", 'n', 0, G_OPTION_ARG_INT, &n_iterations,
+      "Number of measured events per scenario", "N" },
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+      "Only run the scenarios whose name contains TEXT", "TEXT" },
+    { NULL }
+  };
+  GOptionContext *context;
+  GError *error = NULL;
+  gchar **corpus_1k, **corpus_10k;
+  int event_base, error_base, major, minor;
+
+  context = g_option_context_new ("- measure libhildon input latency");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (n_iterations < 1)
+    n_iterations = 1;
+
+  /* Input is sent to X windows, this program needs an X display */
+  gdk_set_allowed_backends ("x11");
+
+  if (!gtk_init_check (&argc, &argv)) {
+    g_printerr ("Cannot open the display\n");
+    return 1;
+  }
+  hildon_init ();
+
+  if (!XTestQueryExtension (xdisplay (), &event_base, &error_base, &major, &minor)) {
+    g_printerr ("The X server does not support the XTest extension\n");
+    return 1;
+  }
+
+  corpus_1k = make_corpus (1000);
+  corpus_10k = make_corpus (10000);
+
+  g_print ("{\n  \"version\": \"%d.%d.%d\",\n  \"iterations\": %d,\n"
+           "  \"scenarios\": [",
+           HILDON_MAJOR_VERSION, HILDON_MINOR_VERSION, HILDON_MICRO_VERSION,
+           n_iterations);
+
+  run_picker_tap ("picker-button/tap/1k", corpus_1k);
+  run_live_search_type ("live-search/type/1k", corpus_1k);
+  run_live_search_type ("live-search/type/10k", corpus_10k);
+  run_window_push ("stackable-window/push");
+
+  g_print ("\n  ]\n}\n");
+
+  g_strfreev (corpus_1k);
+  g_strfreev (corpus_10k);
+
+  return 0;
+}
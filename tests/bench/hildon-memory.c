@@ -0,0 +1,409 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Memory footprint of the libhildon widgets, run with "make memory".
+ *
+ * For each widget type, N instances are created, then realized and
+ * mapped: the widgets inside one window, the windows each on their
+ * own. The heap in use (from mallinfo2) and the resident set size
+ * (from /proc/self/statm) are sampled before and after each phase, and
+ * the growth is reported per instance. Every type is created, mapped
+ * and destroyed once before measuring, so class, style and theme data
+ * shared by all the instances is not counted. As with hildon-bench,
+ * the results are printed as JSON so runs of different builds can be
+ * compared. "make memory" runs the program under xvfb-run when
+ * $DISPLAY is not set, with G_SLICE=always-malloc so that the heap
+ * statistics see every allocation. GLib reads G_SLICE when it is
+ * loaded, so it has to be set in the environment of the program.
+ *
+ * Usage: hildon-memory [-n INSTANCES] [-f FILTER]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <gtk/gtk.h>
+#include <hildon/hildon.h>
+
+#define MEMORY_SEED 20090601
+
+#define SELECTOR_ROWS 1000
+
+typedef GtkWidget *(*WidgetFunc) (void);
+
+typedef struct
+{
+  gsize heap;
+  gsize rss;
+} MemorySample;
+
+static gint n_instances = 100;
+static const gchar *filter = NULL;
+static gboolean first_result = TRUE;
+static gchar **corpus = NULL;
+
+/* -------------------- Corpus -------------------- */
+
+static gchar **
+make_corpus                                     (guint n)
+{
+  static const gchar *syllables[] = {
+    "an", "ber", "ca", "de", "el", "fi", "go", "ha", "in", "jo", "ka", "la",
+    "mi", "no", "os", "pe", "qu", "ri", "sa", "to", "ur", "va", "wi", "xe"
+  };
+  GRand *rand = g_rand_new_with_seed (MEMORY_SEED);
+  gchar **words = g_new0 (gchar *, n + 1);
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    GString *s = g_string_new (NULL);
+    gint len = g_rand_int_range (rand, 2, 6);
+    gint k;
+
+    for (k = 0; k < len; k++)
+      g_string_append (s, syllables[g_rand_int_range (rand, 0, G_N_ELEMENTS (syllables))]);
+
+    words[i] = g_string_free (s, FALSE);
+  }
+
+  g_rand_free (rand);
+
+  return words;
+}
+
+/* -------------------- Sampling -------------------- */
+
+static void
+flush_events                                    (void)
+{
+  gdk_display_sync (gdk_display_get_default ());
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+/* Bytes of heap in use, mmapped chunks included, or 0 if it can't be
+ * known */
+static gsize
+heap_in_use                                     (void)
+{
+#if defined (__GLIBC__) && __GLIBC_PREREQ (2, 33)
+  struct mallinfo2 info = mallinfo2 ();
+
+  return info.uordblks + info.hblkhd;
+#elif defined (__GLIBC__)
+  struct mallinfo info = mallinfo ();
+
+  return (guint) info.uordblks + (guint) info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+/* Resident set size in bytes, or 0 if it can't be known */
+static gsize
+resident_set_size                               (void)
+{
+  gchar *contents;
+  gulong size, resident = 0;
+
+  if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    return 0;
+
+  if (sscanf (contents, "%lu %lu", &size, &resident) != 2)
+    resident = 0;
+  g_free (contents);
+
+  return (gsize) resident * sysconf (_SC_PAGESIZE);
+}
+
+static void
+sample                                          (MemorySample *s)
+{
+  flush_events ();
+  s->heap = heap_in_use ();
+  s->rss = resident_set_size ();
+}
+
+/* Growth per instance from @before to @after, which can be negative
+ * when memory was given back */
+static long long
+per_instance                                    (gsize before,
+                                                 gsize after)
+{
+  return ((long long) after - (long long) before) / n_instances;
+}
+
+/* -------------------- Runner -------------------- */
+
+static void
+print_header                                    (const gchar *name)
+{
+  g_print ("%s\n    {\"name\": \"%s\", ", first_result ? "" : ",", name);
+  first_result = FALSE;
+}
+
+/* Shows @widgets, inside a window unless they are windows themselves */
+static GtkWidget *
+map_widgets                                     (GtkWidget **widgets,
+                                                 gint        n,
+                                                 gboolean    toplevel)
+{
+  GtkWidget *window, *fixed;
+  gint i;
+
+  if (toplevel) {
+    for (i = 0; i < n; i++)
+      gtk_widget_show_all (widgets[i]);
+    return NULL;
+  }
+
+  /* All the widgets are put on top of each other, so the window does
+   * not grow with the number of instances */
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  fixed = gtk_fixed_new ();
+  gtk_container_add (GTK_CONTAINER (window), fixed);
+  for (i = 0; i < n; i++)
+    gtk_fixed_put (GTK_FIXED (fixed), widgets[i], 0, 0);
+  gtk_widget_show_all (window);
+
+  return window;
+}
+
+static void
+destroy_widgets                                 (GtkWidget **widgets,
+                                                 gint        n,
+                                                 GtkWidget  *window)
+{
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    gtk_widget_destroy (widgets[i]);
+    g_object_unref (widgets[i]);
+  }
+
+  if (window)
+    gtk_widget_destroy (window);
+
+  flush_events ();
+}
+
+/* Reports the memory used by each of n_instances widgets made by
+ * @create, unmapped and then mapped. Set @toplevel for windows. */
+static void
+run_memory_bench                                (const gchar *name,
+                                                 WidgetFunc   create,
+                                                 gboolean     toplevel)
+{
+  GtkWidget **widgets, *window;
+  MemorySample start, created, mapped;
+  gint i;
+
+  if (filter && strstr (name, filter) == NULL)
+    return;
+
+  widgets = g_new (GtkWidget *, n_instances);
+
+  /* Let the class, style and theme data be created first */
+  widgets[0] = g_object_ref_sink (create ());
+  window = map_widgets (widgets, 1, toplevel);
+  destroy_widgets (widgets, 1, window);
+
+  sample (&start);
+
+  for (i = 0; i < n_instances; i++)
+    widgets[i] = g_object_ref_sink (create ());
+  sample (&created);
+
+  window = map_widgets (widgets, n_instances, toplevel);
+  sample (&mapped);
+
+  print_header (name);
+  g_print ("\"instances\": %d, "
+           "\"heap_per_instance\": %lld, "
+           "\"mapped_heap_per_instance\": %lld, "
+           "\"mapped_rss_per_instance\": %lld}",
+           n_instances,
+           per_instance (start.heap, created.heap),
+           per_instance (start.heap, mapped.heap),
+           per_instance (start.rss, mapped.rss));
+
+  destroy_widgets (widgets, n_instances, window);
+  g_free (widgets);
+}
+
+/* -------------------- Widgets -------------------- */
+
+static GtkWidget *
+create_button                                   (void)
+{
+  return hildon_button_new_with_text (HILDON_SIZE_FINGER_HEIGHT,
+                                      HILDON_BUTTON_ARRANGEMENT_VERTICAL,
+                                      "Title", "Value");
+}
+
+static GtkWidget *
+create_check_button                             (void)
+{
+  return hildon_check_button_new (HILDON_SIZE_FINGER_HEIGHT);
+}
+
+static GtkWidget *
+create_entry                                    (void)
+{
+  return hildon_entry_new (HILDON_SIZE_FINGER_HEIGHT);
+}
+
+static GtkWidget *
+create_text_view                                (void)
+{
+  return hildon_text_view_new ();
+}
+
+static GtkWidget *
+create_caption                                  (void)
+{
+  return hildon_caption_new (NULL, "Caption", gtk_label_new ("Value"),
+                             NULL, HILDON_CAPTION_OPTIONAL);
+}
+
+static GtkWidget *
+create_date_button                              (void)
+{
+  return hildon_date_button_new (HILDON_SIZE_FINGER_HEIGHT,
+                                 HILDON_BUTTON_ARRANGEMENT_VERTICAL);
+}
+
+static GtkWidget *
+create_touch_selector                           (void)
+{
+  GtkWidget *selector = hildon_touch_selector_new_text ();
+  gint i;
+
+  for (i = 0; corpus[i] != NULL; i++)
+    hildon_touch_selector_append_text (HILDON_TOUCH_SELECTOR (selector), corpus[i]);
+
+  return selector;
+}
+
+static GtkWidget *
+create_pannable_area                            (void)
+{
+  GtkWidget *area = hildon_pannable_area_new ();
+
+  gtk_container_add (GTK_CONTAINER (area), gtk_tree_view_new ());
+
+  return area;
+}
+
+static GtkWidget *
+create_live_search                              (void)
+{
+  return hildon_live_search_new ();
+}
+
+static GtkWidget *
+create_find_toolbar                             (void)
+{
+  return hildon_find_toolbar_new ("Find");
+}
+
+static GtkWidget *
+create_edit_toolbar                             (void)
+{
+  return hildon_edit_toolbar_new_with_text ("Select items", "Delete");
+}
+
+static GtkWidget *
+create_stackable_window                         (void)
+{
+  return hildon_stackable_window_new ();
+}
+
+/* -------------------- Main -------------------- */
+
+int
+main                                            (int    argc,
+                                                 char **argv)
+{
+  GOptionEntry entries[] = {
+    { "instances", 'n', 0, G_OPTION_ARG_INT, &n_instances,
+      "Number of instances of each widget", "N" },
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+      "Only measure the widgets whose name contains TEXT", "TEXT" },
+    { NULL }
+  };
+  GOptionContext *context;
+  GError *error = NULL;
+
+  context = g_option_context_new ("- measure the memory used by libhildon widgets");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (n_instances < 1)
+    n_instances = 1;
+
+  if (!gtk_init_check (&argc, &argv)) {
+    g_printerr ("Cannot open the display\n");
+    return 1;
+  }
+  hildon_init ();
+
+  if (heap_in_use () == 0) {
+    g_printerr ("Heap statistics are not available on this system\n");
+    return 1;
+  }
+
+  corpus = make_corpus (SELECTOR_ROWS);
+
+  g_print ("{\n  \"version\": \"%d.%d.%d\",\n  \"instances\": %d,\n"
+           "  \"widgets\": [",
+           HILDON_MAJOR_VERSION, HILDON_MINOR_VERSION, HILDON_MICRO_VERSION,
+           n_instances);
+
+  run_memory_bench ("button", create_button, FALSE);
+  run_memory_bench ("check-button", create_check_button, FALSE);
+  run_memory_bench ("entry", create_entry, FALSE);
+  run_memory_bench ("text-view", create_text_view, FALSE);
+  run_memory_bench ("caption", create_caption, FALSE);
+  run_memory_bench ("date-button", create_date_button, FALSE);
+  run_memory_bench ("touch-selector/1k", create_touch_selector, FALSE);
+  run_memory_bench ("pannable-area", create_pannable_area, FALSE);
+  run_memory_bench ("live-search", create_live_search, FALSE);
+  run_memory_bench ("find-toolbar", create_find_toolbar, FALSE);
+  run_memory_bench ("edit-toolbar", create_edit_toolbar, FALSE);
+  run_memory_bench ("stackable-window", create_stackable_window, TRUE);
+
+  g_print ("\n  ]\n}\n");
+
+  g_strfreev (corpus);
+
+  return 0;
+}
@@ -0,0 +1,384 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * X requests and round-trips made by a few scenarios, run with
+ * "make xrequests".
+ *
+ * Each scenario does what an application does at one point: start and
+ * show its main window, push three stackable windows, open the
+ * application menu, animate an actor. The protocol requests are
+ * counted with the Xlib request sequence, and the round-trips, which
+ * block the client until the server answers, with the counter of
+ * xrequests-shim.c, preloaded by "make xrequests". Both include what
+ * GDK does in reaction, up to when the main loop goes idle. The counts
+ * are printed as JSON and checked against the budgets in
+ * xrequests-budgets.ini: the program fails if a scenario goes over one,
+ * or has none.
+ * With --record the budgets are replaced by the counts instead.
+ * "make xrequests" runs the program under xvfb-run when $DISPLAY is
+ * not set.
+ *
+ * Usage: hildon-xrequests [-f FILTER] [-b BUDGETS] [--record]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+#include <hildon/hildon.h>
+
+/* The main loop is idle once nothing happened for this long */
+#define SETTLE_QUIET_US (50 * 1000)
+
+/* Defined by the preloaded shim, if any */
+extern unsigned long xrequests_round_trips __attribute__ ((weak));
+
+static const gchar *filter = NULL;
+static const gchar *budgets_file = XREQUESTS_BUDGETS_FILE;
+static gboolean record = FALSE;
+static gboolean first_result = TRUE;
+static gboolean over_budget = FALSE;
+static gboolean missing_budget = FALSE;
+static GKeyFile *budgets = NULL;
+
+typedef struct
+{
+  const gchar *name;
+  gulong requests;
+  gulong round_trips;
+} Measure;
+
+/* -------------------- Counting -------------------- */
+
+static Display *
+xdisplay                                        (void)
+{
+  return GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+}
+
+static gulong
+round_trips                                     (void)
+{
+  if (&xrequests_round_trips == NULL)
+    return 0;
+
+  return __atomic_load_n (&xrequests_round_trips, __ATOMIC_RELAXED);
+}
+
+/* Syncs with the server and runs the main loop until it stays idle,
+ * so the work triggered by replies and events is done too. Returns
+ * how many times it synced. */
+static gint
+settle                                          (void)
+{
+  gboolean busy;
+  gint n_syncs = 0;
+
+  do {
+    gint64 quiet_until;
+
+    XSync (xdisplay (), False);
+    n_syncs++;
+
+    busy = FALSE;
+    quiet_until = g_get_monotonic_time () + SETTLE_QUIET_US;
+    while (g_get_monotonic_time () < quiet_until) {
+      if (g_main_context_iteration (NULL, FALSE))
+        busy = TRUE;
+      else
+        g_usleep (1000);
+    }
+  } while (busy);
+
+  return n_syncs;
+}
+
+static void
+measure_begin                                   (Measure     *m,
+                                                 const gchar *name)
+{
+  settle ();
+
+  m->name = name;
+  m->requests = XNextRequest (xdisplay ());
+  m->round_trips = round_trips ();
+}
+
+/* Each XSync of settle() is one request and one round-trip, they are
+ * not counted */
+static void
+measure_end                                     (Measure *m)
+{
+  gint n_syncs = settle ();
+
+  m->requests = XNextRequest (xdisplay ()) - m->requests - n_syncs;
+  m->round_trips = round_trips () - m->round_trips - n_syncs;
+}
+
+/* -------------------- Budgets -------------------- */
+
+/* Checks @count against its budget in @group and prints the result,
+ * or records it */
+static void
+check_budget                                    (const gchar *group,
+                                                 const gchar *key,
+                                                 const gchar *name,
+                                                 gulong       count)
+{
+  GError *error = NULL;
+  gint64 budget;
+
+  g_print (", \"%s\": %lu", key, count);
+
+  if (record) {
+    g_key_file_set_int64 (budgets, group, name, count);
+    return;
+  }
+
+  /* A scenario without a budget would never fail */
+  budget = g_key_file_get_int64 (budgets, group, name, &error);
+  if (error) {
+    g_print (", \"%s_budget\": null", key);
+    g_printerr ("%s: no %s budget in %s, record it with --record\n",
+                name, group, budgets_file);
+    missing_budget = TRUE;
+    g_error_free (error);
+    return;
+  }
+
+  g_print (", \"%s_budget\": %" G_GINT64_FORMAT, key, budget);
+  if ((gint64) count > budget) {
+    g_print (", \"over_budget\": true");
+    over_budget = TRUE;
+  }
+}
+
+static void
+report                                          (Measure *m)
+{
+  g_print ("%s\n    {\"name\": \"%s\"", first_result ? "" : ",", m->name);
+  first_result = FALSE;
+
+  check_budget ("requests", "requests", m->name, m->requests);
+  if (&xrequests_round_trips != NULL)
+    check_budget ("round-trips", "round_trips", m->name, m->round_trips);
+
+  g_print ("}");
+}
+
+static gboolean
+wanted                                          (const gchar *name)
+{
+  return filter == NULL || strstr (name, filter) != NULL;
+}
+
+/* -------------------- Scenarios -------------------- */
+
+static GtkWidget *
+create_window                                   (const gchar *title)
+{
+  GtkWidget *window = hildon_stackable_window_new ();
+
+  gtk_window_set_title (GTK_WINDOW (window), title);
+  gtk_container_add (GTK_CONTAINER (window), gtk_label_new (title));
+
+  return window;
+}
+
+static void
+run_app_start                                   (const gchar *name)
+{
+  Measure m;
+  GtkWidget *window;
+
+  if (!wanted (name))
+    return;
+
+  measure_begin (&m, name);
+  window = create_window ("Main");
+  hildon_program_add_window (hildon_program_get_instance (), HILDON_WINDOW (window));
+  gtk_widget_show_all (window);
+  measure_end (&m);
+
+  report (&m);
+
+  gtk_widget_destroy (window);
+}
+
+static void
+run_window_push                                 (const gchar *name)
+{
+  HildonWindowStack *stack = hildon_window_stack_get_default ();
+  GtkWidget *main_window;
+  Measure m;
+  gint i;
+
+  if (!wanted (name))
+    return;
+
+  main_window = create_window ("Main");
+  gtk_widget_show_all (main_window);
+
+  measure_begin (&m, name);
+  for (i = 0; i < 3; i++)
+    gtk_widget_show_all (create_window ("Pushed"));
+  measure_end (&m);
+
+  report (&m);
+
+  for (i = 0; i < 3; i++)
+    gtk_widget_destroy (hildon_window_stack_pop_1 (stack));
+  gtk_widget_destroy (main_window);
+}
+
+static void
+run_app_menu_open                               (const gchar *name)
+{
+  GtkWidget *window;
+  HildonAppMenu *menu;
+  Measure m;
+  gint i;
+
+  if (!wanted (name))
+    return;
+
+  window = create_window ("Main");
+  menu = HILDON_APP_MENU (hildon_app_menu_new ());
+  for (i = 0; i < 4; i++) {
+    gchar *label = g_strdup_printf ("Item %d", i + 1);
+    GtkWidget *button = hildon_gtk_button_new (HILDON_SIZE_AUTO);
+
+    gtk_button_set_label (GTK_BUTTON (button), label);
+    hildon_app_menu_append (menu, GTK_BUTTON (button));
+    g_free (label);
+  }
+  gtk_widget_show_all (GTK_WIDGET (menu));
+  hildon_window_set_app_menu (HILDON_WINDOW (window), menu);
+  gtk_widget_show_all (window);
+
+  measure_begin (&m, name);
+  hildon_app_menu_popup (menu, GTK_WINDOW (window));
+  measure_end (&m);
+
+  report (&m);
+
+  gtk_widget_hide (GTK_WIDGET (menu));
+  gtk_widget_destroy (window);
+}
+
+static void
+run_actor_animate                               (const gchar *name)
+{
+  GtkWidget *window, *actor;
+  Measure m;
+  gint i;
+
+  if (!wanted (name))
+    return;
+
+  window = create_window ("Main");
+  gtk_widget_show_all (window);
+
+  actor = hildon_animation_actor_new ();
+  gtk_container_add (GTK_CONTAINER (actor), gtk_label_new ("Actor"));
+  hildon_animation_actor_set_parent (HILDON_ANIMATION_ACTOR (actor), GTK_WINDOW (window));
+  gtk_widget_show_all (actor);
+
+  /* Ten frames, each moving, fading and scaling the actor */
+  measure_begin (&m, name);
+  for (i = 0; i < 10; i++) {
+    HildonAnimationActor *a = HILDON_ANIMATION_ACTOR (actor);
+
+    hildon_animation_actor_set_position (a, 10 * i, 10 * i);
+    hildon_animation_actor_set_opacity (a, 255 - 10 * i);
+    hildon_animation_actor_set_scale (a, 1.0 + i / 10.0, 1.0 + i / 10.0);
+  }
+  measure_end (&m);
+
+  report (&m);
+
+  gtk_widget_destroy (actor);
+  gtk_widget_destroy (window);
+}
+
+/* -------------------- Main -------------------- */
+
+int
+main                                            (int    argc,
+                                                 char **argv)
+{
+  GOptionEntry entries[] = {
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+      "Only run the scenarios whose name contains TEXT", "TEXT" },
+    { "budgets", 'b', 0, G_OPTION_ARG_FILENAME, &budgets_file,
+      "Read the budgets from FILE", "FILE" },
+    { "record", 0, 0, G_OPTION_ARG_NONE, &record,
+      "Save the counts as the new budgets", NULL },
+    { NULL }
+  };
+  GOptionContext *context;
+  GError *error = NULL;
+
+  context = g_option_context_new ("- count the X requests of libhildon scenarios");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  /* The requests are counted on the X connection */
+  gdk_set_allowed_backends ("x11");
+
+  if (!gtk_init_check (&argc, &argv)) {
+    g_printerr ("Cannot open the display\n");
+    return 1;
+  }
+  hildon_init ();
+
+  if (&xrequests_round_trips == NULL)
+    g_printerr ("The round-trip counter is not preloaded, only the requests are counted\n");
+
+  budgets = g_key_file_new ();
+  g_key_file_load_from_file (budgets, budgets_file, G_KEY_FILE_KEEP_COMMENTS, NULL);
+
+  g_print ("{\n  \"version\": \"%d.%d.%d\",\n  \"scenarios\": [",
+           HILDON_MAJOR_VERSION, HILDON_MINOR_VERSION, HILDON_MICRO_VERSION);
+
+  /* First, so that it pays for the atoms and the settings like a real
+   * application start */
+  run_app_start ("app-start");
+  run_window_push ("window-stack/push-3");
+  run_app_menu_open ("app-menu/open");
+  run_actor_animate ("animation-actor/animate-10");
+
+  g_print ("\n  ]\n}\n");
+
+  if (record && !g_key_file_save_to_file (budgets, budgets_file, &error)) {
+    g_printerr ("%s: %s\n", budgets_file, error->message);
+    return 1;
+  }
+  g_key_file_free (budgets);
+
+  return over_budget || missing_budget ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Round-trip counter preloaded by "make xrequests".
+ *
+ * Xlib and xcb wait for every reply of the X server in
+ * xcb_wait_for_reply(), so wrapping it counts the round-trips made by
+ * the whole process, GDK and libhildon alike. The count is kept in
+ * xrequests_round_trips, which hildon-xrequests finds at run time.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <dlfcn.h>
+#include <xcb/xcb.h>
+
+unsigned long xrequests_round_trips = 0;
+
+#define COUNT() __atomic_fetch_add (&xrequests_round_trips, 1, __ATOMIC_RELAXED)
+
+void *
+xcb_wait_for_reply (xcb_connection_t      *c,
+                    unsigned int           request,
+                    xcb_generic_error_t  **e)
+{
+  static void *(*real) (xcb_connection_t *, unsigned int, xcb_generic_error_t **);
+
+  if (real == NULL)
+    real = dlsym (RTLD_NEXT, "xcb_wait_for_reply");
+
+  COUNT ();
+  return real (c, request, e);
+}
+
+void *
+xcb_wait_for_reply64 (xcb_connection_t      *c,
+                      uint64_t               request,
+                      xcb_generic_error_t  **e)
+{
+  static void *(*real) (xcb_connection_t *, uint64_t, xcb_generic_error_t **);
+
+  if (real == NULL)
+    real = dlsym (RTLD_NEXT, "xcb_wait_for_reply64");
+
+  COUNT ();
+  return real (c, request, e);
+}
@@ -0,0 +1,206 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <check.h>
+#include "test_suites.h"
+#include "check_utils.h"
+#include "check_alloc.h"
+#include <hildon/hildon.h>
+
+#define N_ROWS 1000
+
+static GtkWindow *window = NULL;
+
+static gchar *
+row_text (gint i)
+{
+  static const gchar *words[] = { "kal", "mar", "nor", "pel", "sal", "tor" };
+
+  return g_strdup_printf ("%s %s %d", words[i % G_N_ELEMENTS (words)],
+                          words[(i / 7) % G_N_ELEMENTS (words)], i);
+}
+
+static void
+fx_setup ()
+{
+  int argc = 0;
+
+  gtk_init (&argc, NULL);
+
+  window = GTK_WINDOW (create_test_window ());
+
+  fail_if (!HILDON_IS_WINDOW (window),
+           "hildon-alloc: Window creation failed.");
+}
+
+static void
+fx_teardown ()
+{
+  gtk_widget_destroy (GTK_WIDGET (window));
+}
+
+/* ------------------------- Live search ------------------------- */
+
+static void
+live_search_keystroke (gpointer data)
+{
+  HildonLiveSearch *livesearch = data;
+
+  hildon_live_search_set_text (livesearch, "ka");
+  hildon_live_search_set_text (livesearch, "k");
+}
+
+/**
+   Purpose: allocations made while typing into a live search filtering
+   N_ROWS rows. Each run types a letter and erases it.
+*/
+START_TEST (test_alloc_live_search_keystroke)
+{
+  GtkListStore *store = gtk_list_store_new (1, G_TYPE_STRING);
+  GtkTreeModel *filter;
+  GtkWidget *box, *view, *livesearch;
+  gint i;
+
+  for (i = 0; i < N_ROWS; i++)
+    {
+      gchar *text = row_text (i);
+
+      gtk_list_store_insert_with_values (store, NULL, -1, 0, text, -1);
+      g_free (text);
+    }
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  view = gtk_tree_view_new_with_model (filter);
+  livesearch = hildon_live_search_new ();
+  hildon_live_search_set_filter (HILDON_LIVE_SEARCH (livesearch),
+                                 GTK_TREE_MODEL_FILTER (filter));
+  hildon_live_search_set_text_column (HILDON_LIVE_SEARCH (livesearch), 0);
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  gtk_box_pack_start (GTK_BOX (box), view, TRUE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (box), livesearch, FALSE, FALSE, 0);
+  gtk_container_add (GTK_CONTAINER (window), box);
+  show_all_test_window (GTK_WIDGET (window));
+
+  hildon_live_search_set_text (HILDON_LIVE_SEARCH (livesearch), "k");
+
+  check_alloc_assert_budget ("live-search/keystroke/1k",
+                             check_alloc_measure (live_search_keystroke, livesearch));
+
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+END_TEST
+
+/* ------------------------ Touch selector ----------------------- */
+
+typedef struct
+{
+  HildonTouchSelector *selector;
+  GtkTreeIter first;
+  GtkTreeIter middle;
+} SelectIterData;
+
+static void
+touch_selector_select_iter (gpointer data)
+{
+  SelectIterData *d = data;
+
+  hildon_touch_selector_select_iter (d->selector, 0, &d->middle, FALSE);
+  hildon_touch_selector_select_iter (d->selector, 0, &d->first, FALSE);
+}
+
+/**
+   Purpose: allocations made when selecting rows of a touch selector
+   with N_ROWS rows. Each run selects two rows.
+*/
+START_TEST (test_alloc_touch_selector_select_iter)
+{
+  SelectIterData d;
+  GtkTreeModel *model;
+  gint i;
+
+  d.selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+  for (i = 0; i < N_ROWS; i++)
+    {
+      gchar *text = row_text (i);
+
+      hildon_touch_selector_append_text (d.selector, text);
+      g_free (text);
+    }
+
+  gtk_container_add (GTK_CONTAINER (window), GTK_WIDGET (d.selector));
+  show_all_test_window (GTK_WIDGET (window));
+
+  model = hildon_touch_selector_get_model (d.selector, 0);
+  fail_if (!gtk_tree_model_get_iter_first (model, &d.first),
+           "hildon-alloc: the selector has no rows");
+  fail_if (!gtk_tree_model_iter_nth_child (model, &d.middle, NULL, N_ROWS / 2),
+           "hildon-alloc: the selector has too few rows");
+
+  check_alloc_assert_budget ("touch-selector/select-iter/1k",
+                             check_alloc_measure (touch_selector_select_iter, &d));
+}
+END_TEST
+
+/* ---------------------------- Banner --------------------------- */
+
+static void
+banner_show (gpointer data)
+{
+  GtkWidget *banner;
+
+  banner = hildon_banner_show_information (GTK_WIDGET (data), NULL, "Saved");
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+  gtk_widget_destroy (banner);
+}
+
+/**
+   Purpose: allocations made to show an information banner and destroy
+   it.
+*/
+START_TEST (test_alloc_banner_show)
+{
+  show_test_window (GTK_WIDGET (window));
+
+  check_alloc_assert_budget ("banner/show-information",
+                             check_alloc_measure (banner_show, window));
+}
+END_TEST
+
+/* ------------------------- Suite creation ---------------------- */
+
+Suite *create_hildon_alloc_suite (void)
+{
+  Suite *s = suite_create ("HildonAlloc");
+
+  TCase *tc1 = tcase_create ("hildon_alloc");
+  tcase_add_checked_fixture (tc1, fx_setup, fx_teardown);
+  tcase_add_test (tc1, test_alloc_live_search_keystroke);
+  tcase_add_test (tc1, test_alloc_touch_selector_select_iter);
+  tcase_add_test (tc1, test_alloc_banner_show);
+  suite_add_tcase (s, tc1);
+
+  return s;
+}
@@ -0,0 +1,131 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <check.h>
+#include "test_suites.h"
+#include "check_utils.h"
+#include <hildon/hildon.h>
+
+static GtkWidget *window = NULL;
+static HildonAppMenu *menu = NULL;
+static GLogLevelFlags old_fatal_mask;
+
+static void
+fx_setup ()
+{
+    int argc = 0;
+
+    gtk_init (&argc, NULL);
+
+    /* Warnings from the intruder check must not go unnoticed */
+    old_fatal_mask = g_log_set_always_fatal (G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING);
+
+    window = create_test_window ();
+    show_test_window (window);
+
+    menu = HILDON_APP_MENU (hildon_app_menu_new ());
+    hildon_app_menu_append (menu, GTK_BUTTON (gtk_button_new_with_label ("Item")));
+}
+
+static void
+fx_teardown ()
+{
+    gtk_widget_destroy (GTK_WIDGET (menu));
+    gtk_widget_destroy (window);
+
+    g_log_set_always_fatal (old_fatal_mask);
+}
+
+static gboolean
+quit_loop (gpointer data)
+{
+    g_main_loop_quit (data);
+
+    return FALSE;
+}
+
+/* Runs the main loop for long enough for the intruder check to run */
+static void
+wait_for_intruder_check (void)
+{
+    GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+
+    g_timeout_add (300, quit_loop, loop);
+    g_main_loop_run (loop);
+    g_main_loop_unref (loop);
+}
+
+/**
+   Purpose: test that the app menu follows the modal state of the other
+   windows while it is open.
+
+   Checks for:
+
+   - Making a mapped window modal while the menu is open is checked
+     without warnings.
+   - A modal change after the menu is hidden is harmless.
+
+*/
+START_TEST (test_hildon_app_menu_modal_toggle)
+{
+    GtkWidget *other = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+
+    show_test_window (other);
+
+    hildon_app_menu_popup (menu, GTK_WINDOW (window));
+    wait_for_intruder_check ();
+
+    fail_if (!gtk_widget_get_mapped (GTK_WIDGET (menu)),
+             "hildon-app-menu: The menu was not shown");
+
+    gtk_window_set_modal (GTK_WINDOW (other), TRUE);
+    wait_for_intruder_check ();
+    gtk_window_set_modal (GTK_WINDOW (other), FALSE);
+    wait_for_intruder_check ();
+
+    gtk_widget_hide (GTK_WIDGET (menu));
+
+    /* Nothing is checked for a hidden menu, so it stays hidden */
+    gtk_window_set_modal (GTK_WINDOW (other), TRUE);
+    wait_for_intruder_check ();
+
+    fail_if (gtk_widget_get_visible (GTK_WIDGET (menu)),
+             "hildon-app-menu: A hidden menu was shown again");
+
+    gtk_widget_destroy (other);
+}
+END_TEST
+
+/* ---------- Suite creation ---------- */
+
+Suite *create_hildon_app_menu_suite (void)
+{
+    Suite *s = suite_create ("HildonAppMenu");
+
+    TCase *tc1 = tcase_create ("hildon_app_menu_intruders");
+    tcase_add_checked_fixture (tc1, fx_setup, fx_teardown);
+    tcase_add_test (tc1, test_hildon_app_menu_modal_toggle);
+    suite_add_tcase (s, tc1);
+
+    return s;
+}
@@ -28,6 +28,7 @@
 #include "check_utils.h"
 #include <string.h>
 
+#include <glib/gstdio.h>
 #include <hildon/hildon-find-toolbar.h>
 #include <hildon/hildon-window.h>
 
@@ -101,6 +102,114 @@ fx_teardown_find_toolbar()
   
 }
 
+/* Same as HISTORY_FILE_MAGIC in hildon-find-toolbar.c */
+#define HISTORY_MAGIC "HILDON-FIND-HISTORY 1\n"
+
+static gchar *history_dir = NULL;
+static gchar *history_path = NULL;
+
+static void
+fx_setup_history_find_toolbar ()
+{
+  int argc = 0;
+  gtk_init(&argc, NULL);
+
+  history_dir = g_dir_make_tmp ("check-hildon-find-toolbar-XXXXXX", NULL);
+  fail_if (history_dir == NULL,
+           "hildon-find-toolbar: Cannot create a temporary directory");
+  history_path = g_build_filename (history_dir, "history", NULL);
+
+  find_toolbar = HILDON_FIND_TOOLBAR(hildon_find_toolbar_new(TEST_STRING));
+  g_object_ref_sink (find_toolbar);
+}
+
+static void
+fx_teardown_history_find_toolbar ()
+{
+  gtk_widget_destroy (GTK_WIDGET (find_toolbar));
+  g_object_unref (find_toolbar);
+
+  g_unlink (history_path);
+  g_rmdir (history_dir);
+  g_free (history_path);
+  g_free (history_dir);
+}
+
+/* Writes @len bytes of @contents to the history file */
+static void
+write_history (const gchar *contents, gsize len)
+{
+  fail_if (!g_file_set_contents (history_path, contents, len, NULL),
+           "hildon-find-toolbar: Cannot write %s", history_path);
+}
+
+/* Checks that the history file holds the @len bytes of @expected */
+static void
+check_history_file (const gchar *expected, gsize len)
+{
+  gchar *contents;
+  gsize length;
+
+  fail_if (!g_file_get_contents (history_path, &contents, &length, NULL),
+           "hildon-find-toolbar: Cannot read %s", history_path);
+  fail_if (length != len || memcmp (contents, expected, len) != 0,
+           "hildon-find-toolbar: The history file does not hold the expected records");
+  g_free (contents);
+}
+
+/* Checks that the history list holds @expected, oldest first */
+static void
+check_history_list (const gchar * const *expected)
+{
+  GtkListStore *list = NULL;
+  GtkTreeIter iter;
+  gboolean valid = FALSE;
+  gint i;
+
+  g_object_get (find_toolbar, "list", &list, NULL);
+  if (list != NULL)
+    valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (list), &iter);
+
+  for (i = 0; expected[i] != NULL; i++)
+    {
+      gchar *text;
+
+      fail_if (!valid,
+               "hildon-find-toolbar: History entry %d (%s) is missing", i, expected[i]);
+
+      gtk_tree_model_get (GTK_TREE_MODEL (list), &iter, 0, &text, -1);
+      fail_if (strcmp (text, expected[i]) != 0,
+               "hildon-find-toolbar: History entry %d is %s instead of %s",
+               i, text, expected[i]);
+      g_free (text);
+
+      valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (list), &iter);
+    }
+
+  fail_if (valid, "hildon-find-toolbar: There are more than %d history entries", i);
+
+  if (list != NULL)
+    g_object_unref (list);
+}
+
+/* Runs the idles that save the history file */
+static void
+flush_history (void)
+{
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
+/* Searches for @prefix, adding it to the history */
+static void
+search (const gchar *prefix)
+{
+  gboolean ret;
+
+  g_object_set (find_toolbar, "prefix", prefix, NULL);
+  g_signal_emit_by_name (find_toolbar, "history-append", &ret);
+}
+
 /* -------------------- Test cases -------------------- */
 
 /* ----- Test case for set/get_property "label"  -----*/
@@ -159,6 +268,144 @@ START_TEST (test_set_get_property_label_invalid)
 }
 END_TEST
 
+/* ----- Test case for the history file -----*/
+
+/**
+ * Purpose: Check that a search that was not completely written is dropped
+ * Cases considered:
+ *    - The last record of the file has no terminating NUL
+ */
+START_TEST (test_history_file_truncated)
+{
+  const gchar contents[] = HISTORY_MAGIC "alpha\0beta\0gam";
+  const gchar expected[] = HISTORY_MAGIC "alpha\0beta\0";
+  const gchar *list[] = { "alpha", "beta", NULL };
+
+  write_history (contents, sizeof (contents) - 1);
+  hildon_find_toolbar_set_history_file (find_toolbar, history_path);
+  flush_history ();
+
+  check_history_list (list);
+  check_history_file (expected, sizeof (expected) - 1);
+}
+END_TEST
+
+/**
+ * Purpose: Check that repeated searches are loaded once
+ * Cases considered:
+ *    - The newest copy of a search is kept, the older one is dropped
+ *      from the list and from the file
+ */
+START_TEST (test_history_file_dedupe)
+{
+  const gchar contents[] = HISTORY_MAGIC "alpha\0beta\0alpha\0";
+  const gchar expected[] = HISTORY_MAGIC "beta\0alpha\0";
+  const gchar *list[] = { "beta", "alpha", NULL };
+
+  write_history (contents, sizeof (contents) - 1);
+  hildon_find_toolbar_set_history_file (find_toolbar, history_path);
+  flush_history ();
+
+  check_history_list (list);
+  check_history_file (expected, sizeof (expected) - 1);
+}
+END_TEST
+
+/**
+ * Purpose: Check that a burst of searches is saved once it is over
+ * Cases considered:
+ *    - Searching does not write the file right away
+ *    - The file then holds the last "history-limit" searches
+ */
+START_TEST (test_history_file_save)
+{
+  const gchar expected[] = HISTORY_MAGIC "s4\0s5\0";
+
+  g_object_set (find_toolbar, "history-limit", 2, NULL);
+  hildon_find_toolbar_set_history_file (find_toolbar, history_path);
+
+  search ("s1");
+  search ("s2");
+  search ("s3");
+  search ("s4");
+  search ("s5");
+  fail_if (g_file_test (history_path, G_FILE_TEST_EXISTS),
+           "hildon-find-toolbar: The history file was written during the searches");
+
+  flush_history ();
+  check_history_file (expected, sizeof (expected) - 1);
+}
+END_TEST
+
+/**
+ * Purpose: Check that a saved history is loaded back
+ * Cases considered:
+ *    - Searches pending when the toolbar is destroyed are saved
+ *    - A new toolbar shows them in the same order
+ */
+START_TEST (test_history_file_round_trip)
+{
+  const gchar *list[] = { "alpha", "beta", "gamma", NULL };
+
+  hildon_find_toolbar_set_history_file (find_toolbar, history_path);
+  search ("alpha");
+  search ("beta");
+  search ("gamma");
+
+  gtk_widget_destroy (GTK_WIDGET (find_toolbar));
+  g_object_unref (find_toolbar);
+
+  find_toolbar = HILDON_FIND_TOOLBAR (hildon_find_toolbar_new (TEST_STRING));
+  g_object_ref_sink (find_toolbar);
+  hildon_find_toolbar_set_history_file (find_toolbar, history_path);
+
+  check_history_list (list);
+}
+END_TEST
+
+/**
+ * Purpose: Check that files not written by HildonFindToolbar are kept
+ * Cases considered:
+ *    - Loading leaves the file alone
+ *    - Searching does not write to it
+ */
+START_TEST (test_history_file_foreign)
+{
+  const gchar contents[] = "not a history file\n";
+
+  write_history (contents, sizeof (contents) - 1);
+  hildon_find_toolbar_set_history_file (find_toolbar, history_path);
+  search ("alpha");
+
+  check_history_file (contents, sizeof (contents) - 1);
+}
+END_TEST
+
+/**
+ * Purpose: Check that a history limit of 0 keeps the saved history
+ * Cases considered:
+ *    - Loading shows nothing and leaves the records in the file
+ *    - Searching leaves the file alone
+ */
+START_TEST (test_history_file_no_limit)
+{
+  const gchar contents[] = HISTORY_MAGIC "alpha\0beta\0alpha\0";
+  const gchar *list[] = { NULL };
+
+  g_object_set (find_toolbar, "history-limit", 0, NULL);
+  write_history (contents, sizeof (contents) - 1);
+  hildon_find_toolbar_set_history_file (find_toolbar, history_path);
+
+  check_history_list (list);
+  check_history_file (contents, sizeof (contents) - 1);
+
+  /* Searching with the history hidden does not touch the file */
+  search ("gamma");
+  flush_history ();
+  check_history_file (contents, sizeof (contents) - 1);
+}
+END_TEST
+
 /* ---------- Suite creation ---------- */
 
 Suite *create_hildon_find_toolbar_suite()
@@ -169,6 +416,7 @@ Suite *create_hildon_find_toolbar_suite()
   /* Create test cases */
   TCase *tc1 = tcase_create("set_get_property_label");
   TCase *tc2 = tcase_create("model_set_get_property_label");
+  TCase *tc3 = tcase_create("history_file");
 
   /* Create unit tests for set/get of property "label" and add it to the suite */
   tcase_add_checked_fixture(tc1, fx_setup_default_find_toolbar, fx_teardown_find_toolbar);
@@ -182,6 +430,16 @@ Suite *create_hildon_find_toolbar_suite()
   tcase_add_test(tc2, test_set_get_property_label_invalid);
   suite_add_tcase (s, tc2);
 
+  /* Create unit tests for the history file and add it to the suite */
+  tcase_add_checked_fixture(tc3, fx_setup_history_find_toolbar, fx_teardown_history_find_toolbar);
+  tcase_add_test(tc3, test_history_file_truncated);
+  tcase_add_test(tc3, test_history_file_dedupe);
+  tcase_add_test(tc3, test_history_file_save);
+  tcase_add_test(tc3, test_history_file_round_trip);
+  tcase_add_test(tc3, test_history_file_foreign);
+  tcase_add_test(tc3, test_history_file_no_limit);
+  suite_add_tcase (s, tc3);
+
   /* Return created suite */
   return s;
 }
@@ -23,6 +23,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <gtk/gtk.h>
 #include "test_suites.h"
@@ -160,6 +161,251 @@ START_TEST (test_hildon_helper_set_logical_color_invalid)
 END_TEST
 
 
+/* ----- Test case for hildon_helper_strip_strings -----*/
+
+/**
+ * Purpose: test that stripping a batch of strings gives the same
+ * result as stripping them one by one
+ * Cases considered:
+ *    - Strip ASCII, Latin, Greek and Cyrillic strings
+ *    - Strip an empty string
+ */
+START_TEST (test_hildon_helper_strip_strings_regular)
+{
+  const gchar *strings[] = { "Abasto", "\303\211l\303\250ve", "\316\221\316\270\316\256\316\275\316\261",
+                             "\320\234\320\276\321\201\320\272\320\262\320\260", "", NULL };
+  gunichar **stripped;
+  gint i;
+
+  stripped = hildon_helper_strip_strings (strings);
+
+  for (i = 0; strings[i] != NULL; i++) {
+    gunichar *single = hildon_helper_strip_string (strings[i]);
+    gint j = 0;
+
+    fail_if (stripped[i] == NULL,
+             "hildon-helper: stripped string %d is NULL", i);
+
+    if (single != NULL) {
+      while (single[j] != 0 && single[j] == stripped[i][j])
+        j++;
+      fail_if (single[j] != stripped[i][j],
+               "hildon-helper: batch and single strip differ for string %d", i);
+      g_free (single);
+    } else {
+      fail_if (stripped[i][0] != 0,
+               "hildon-helper: stripped empty string %d is not empty", i);
+    }
+  }
+
+  fail_if (stripped[i] != NULL,
+           "hildon-helper: stripped array is not NULL-terminated");
+
+  fail_if (stripped[0][0] != 'a',
+           "hildon-helper: 'A' was not folded to 'a'");
+  fail_if (stripped[1][0] != 'e',
+           "hildon-helper: accentuation mark was not stripped");
+
+  g_free (stripped);
+}
+END_TEST
+
+
+/* ----- Test case for hildon_helper_normalize_strings -----*/
+
+static const gchar *normalize_strings[] = { "Abasto", "\303\211l\303\250ve", "Stra\303\237e",
+                                            "\342\200\234Quoted\342\200\235", "", "\377", NULL };
+
+static gpointer
+normalize_strings_thread (gpointer data)
+{
+  gboolean same = TRUE;
+  gint round;
+
+  for (round = 0; round < 1000 && same; round++) {
+    gchar **normalized = hildon_helper_normalize_strings (normalize_strings);
+    gint i;
+
+    for (i = 0; normalize_strings[i] != NULL; i++) {
+      gchar *single = hildon_helper_normalize_string (normalize_strings[i]);
+      same = same && strcmp (single ? single : "", normalized[i]) == 0;
+      g_free (single);
+    }
+    g_free (normalized);
+  }
+
+  return GINT_TO_POINTER (same);
+}
+
+/**
+ * Purpose: test that normalizing a batch of strings gives the same
+ * result as normalizing them one by one, from any thread
+ * Cases considered:
+ *    - Normalize ASCII, Latin and punctuation strings
+ *    - Normalize an empty string and invalid UTF-8
+ *    - Normalize from several threads at once
+ */
+START_TEST (test_hildon_helper_normalize_strings_regular)
+{
+  GThread *threads[4];
+  gchar **normalized;
+  gint i;
+
+  normalized = hildon_helper_normalize_strings (normalize_strings);
+
+  fail_if (strcmp (normalized[1], "Eleve") != 0,
+           "hildon-helper: \"%s\" should be \"Eleve\"", normalized[1]);
+  fail_if (strcmp (normalized[2], "Strasse") != 0,
+           "hildon-helper: \"%s\" should be \"Strasse\"", normalized[2]);
+  fail_if (normalized[5][0] != '\0',
+           "hildon-helper: invalid UTF-8 did not give an empty string");
+  fail_if (normalized[6] != NULL,
+           "hildon-helper: normalized array is not NULL-terminated");
+  g_free (normalized);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("normalize", normalize_strings_thread, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    fail_if (!GPOINTER_TO_INT (g_thread_join (threads[i])),
+             "hildon-helper: batch and single normalization differ in thread %d", i);
+}
+END_TEST
+
+
+/* ----- Test case for hildon_helper_query_match -----*/
+
+/**
+ * Purpose: test matching multi-token queries
+ * Cases considered:
+ *    - Every token must match the start of a word
+ *    - Tokens must match distinct words when requested
+ *    - An empty query matches everything
+ */
+START_TEST (test_hildon_helper_query_match_regular)
+{
+  HildonHelperQuery *query;
+
+  query = hildon_helper_query_new ("jo sm", FALSE);
+  fail_if (!hildon_helper_query_match (query, "John Smith"),
+           "hildon-helper: \"jo sm\" should match \"John Smith\"");
+  fail_if (hildon_helper_query_match (query, "John Jones"),
+           "hildon-helper: \"jo sm\" should not match \"John Jones\"");
+  hildon_helper_query_free (query);
+
+  query = hildon_helper_query_new ("jo jo", FALSE);
+  fail_if (!hildon_helper_query_match (query, "John Smith"),
+           "hildon-helper: \"jo jo\" should match \"John Smith\"");
+  hildon_helper_query_free (query);
+
+  query = hildon_helper_query_new ("jo jo", TRUE);
+  fail_if (hildon_helper_query_match (query, "John Smith"),
+           "hildon-helper: distinct \"jo jo\" should not match \"John Smith\"");
+  fail_if (!hildon_helper_query_match (query, "John Jones"),
+           "hildon-helper: distinct \"jo jo\" should match \"John Jones\"");
+  hildon_helper_query_free (query);
+
+  query = hildon_helper_query_new ("aa a", TRUE);
+  fail_if (hildon_helper_query_match (query, "Aaa"),
+           "hildon-helper: distinct \"aa a\" should not match \"Aaa\"");
+  fail_if (!hildon_helper_query_match (query, "Aaa Ab"),
+           "hildon-helper: distinct \"aa a\" should match \"Aaa Ab\"");
+  hildon_helper_query_free (query);
+
+  query = hildon_helper_query_new ("", FALSE);
+  fail_if (!hildon_helper_query_is_empty (query),
+           "hildon-helper: the empty query has tokens");
+  fail_if (!hildon_helper_query_match (query, "Anything"),
+           "hildon-helper: the empty query should match everything");
+  hildon_helper_query_free (query);
+}
+END_TEST
+
+/* ----- Test case for hildon_format_file_size_* -----*/
+
+/* Checks that @size is formatted with the message @msgid. Without the
+   Maemo translations the message id is printed as is. */
+static void
+check_file_size_unit (goffset size, const gchar *msgid)
+{
+  const gchar *format = g_dgettext ("hildon-fm", msgid);
+  gchar *text = hildon_format_file_size_for_display (size);
+
+  fail_if (text == NULL || *text == '\0',
+           "hildon-helper: Nothing was formatted for %" G_GINT64_FORMAT " bytes",
+           (gint64) size);
+  fail_if (strcmp (format, msgid) == 0 && strcmp (text, msgid) != 0,
+           "hildon-helper: %" G_GINT64_FORMAT " bytes were formatted as \"%s\" "
+           "instead of \"%s\"", (gint64) size, text, msgid);
+  fail_if (hildon_format_file_size_to_buffer (size, NULL, 0) != (gint) strlen (text),
+           "hildon-helper: The length of %" G_GINT64_FORMAT " bytes is wrong",
+           (gint64) size);
+
+  g_free (text);
+}
+
+/**
+ * Purpose: test formatting file sizes with each unit
+ * Cases considered:
+ *    - Every range of sizes uses its own message
+ */
+START_TEST (test_hildon_format_file_size_units)
+{
+  check_file_size_unit (0, "ckdg_va_properties_size_kb");
+  check_file_size_unit (1023, "ckdg_va_properties_size_kb");
+  check_file_size_unit (1024, "ckdg_va_properties_size_1kb_99kb");
+  check_file_size_unit (100 * 1024, "ckdg_va_properties_size_100kb_1mb");
+  check_file_size_unit (1024 * 1024, "ckdg_va_properties_size_1mb_10mb");
+  check_file_size_unit (10 * 1024 * 1024, "ckdg_va_properties_size_10mb_1gb");
+  check_file_size_unit (G_GINT64_CONSTANT (1024) * 1024 * 1024,
+                        "ckdg_va_properties_size_1gb_or_greater");
+  check_file_size_unit (G_GINT64_CONSTANT (5000) * 1024 * 1024 * 1024,
+                        "ckdg_va_properties_size_1gb_or_greater");
+}
+END_TEST
+
+/**
+ * Purpose: test formatting file sizes into buffers that are too small
+ * Cases considered:
+ *    - The result is truncated and nul-terminated
+ *    - The length of the whole result is returned
+ *    - The allocated result is never truncated
+ */
+START_TEST (test_hildon_format_file_size_truncate)
+{
+  gchar *text = hildon_format_file_size_for_display (2048);
+  gint length = strlen (text);
+  gchar buffer[8];
+  gint i;
+
+  fail_if (length < (gint) sizeof (buffer),
+           "hildon-helper: \"%s\" is too short to test truncation", text);
+
+  memset (buffer, 'x', sizeof (buffer));
+  fail_if (hildon_format_file_size_to_buffer (2048, buffer, sizeof (buffer)) != length,
+           "hildon-helper: The truncated size does not return the whole length");
+  fail_if (buffer[sizeof (buffer) - 1] != '\0',
+           "hildon-helper: The truncated size is not nul-terminated");
+  fail_if (strncmp (buffer, text, sizeof (buffer) - 1) != 0,
+           "hildon-helper: The truncated size \"%s\" is not a prefix of \"%s\"",
+           buffer, text);
+
+  /* Every buffer size up to the whole length */
+  for (i = 1; i <= length + 1; i++) {
+    gchar *part = g_malloc (i);
+
+    fail_if (hildon_format_file_size_to_buffer (2048, part, i) != length,
+             "hildon-helper: A %d byte buffer does not return the whole length", i);
+    fail_if (strlen (part) != (gsize) MIN (i - 1, length),
+             "hildon-helper: A %d byte buffer was not filled", i);
+    g_free (part);
+  }
+
+  g_free (text);
+}
+END_TEST
+
+
 
 /* ---------- Suite creation ---------- */
 
@@ -171,6 +417,8 @@ Suite *create_hildon_helper_suite()
   /* Create test cases */
   TCase *tc1 = tcase_create("hildon_helper_set_logical_font");
   TCase *tc2 = tcase_create("hildon_helper_set_logical_color");
+  TCase *tc3 = tcase_create("hildon_helper_string_matching");
+  TCase *tc4 = tcase_create("hildon_format_file_size");
 
   /* Create test case for set_logical_font and add it to the suite */
   tcase_add_checked_fixture(tc1, fx_setup_default_helper, fx_teardown_default_helper);
@@ -184,6 +432,17 @@ Suite *create_hildon_helper_suite()
   tcase_add_test(tc2, test_hildon_helper_set_logical_color_invalid);
   suite_add_tcase (s, tc2);
 
+  /* Create test case for string matching and add it to the suite */
+  tcase_add_test(tc3, test_hildon_helper_strip_strings_regular);
+  tcase_add_test(tc3, test_hildon_helper_normalize_strings_regular);
+  tcase_add_test(tc3, test_hildon_helper_query_match_regular);
+  suite_add_tcase (s, tc3);
+
+  /* Create test case for file sizes and add it to the suite */
+  tcase_add_test(tc4, test_hildon_format_file_size_units);
+  tcase_add_test(tc4, test_hildon_format_file_size_truncate);
+  suite_add_tcase (s, tc4);
+
   /* Return created suite */
   return s;             
 }
@@ -110,6 +110,100 @@ START_TEST (test_hildon_picker_button_value)
 }
 END_TEST
 
+static void
+count_changed (HildonTouchSelector *selector, gint column, gpointer data)
+{
+    (*(gint *) data)++;
+}
+
+/**
+   Purpose: test that selection changes made while the selector is
+   frozen are reported once, when it is thawed.
+
+   Checks for:
+
+   - No "changed" emission and no value update while frozen.
+   - A single "changed" emission after thawing, with the last value shown.
+
+*/
+START_TEST (test_hildon_picker_button_freeze_changed)
+{
+    const gchar *value;
+    gint n_changed = 0;
+
+    g_signal_connect (selector, "changed",
+                      G_CALLBACK (count_changed), &n_changed);
+
+    hildon_touch_selector_freeze_changed (selector);
+    hildon_touch_selector_set_active (selector, 0, 1);
+    hildon_touch_selector_set_active (selector, 0, 2);
+    hildon_touch_selector_set_active (selector, 0, 3);
+
+    /* Test 1: nothing is emitted while frozen. */
+    value = hildon_button_get_value (button);
+    fail_if (n_changed != 0 || strcmp (value, "") != 0,
+             "hildon-picker-button: frozen selector emitted %d changes, "
+             "button displays `%s'.", n_changed, value);
+
+    /* Test 2: thawing emits once and updates the button. */
+    hildon_touch_selector_thaw_changed (selector);
+    value = hildon_button_get_value (button);
+    fail_if (n_changed != 1,
+             "hildon-picker-button: thawed selector emitted %d changes, "
+             "expected 1.", n_changed);
+    fail_if (strcmp (value, "Row four") != 0,
+             "hildon-picker-button: after thawing button displays `%s'.",
+             value);
+}
+END_TEST
+
+/**
+   Purpose: test that a selection snapshot survives serialization and
+   restores the selection.
+
+   Checks for:
+
+   - The serialized form of a single column snapshot.
+   - Applying a deserialized snapshot restores the selected row.
+   - Malformed strings are rejected.
+
+*/
+START_TEST (test_hildon_picker_button_snapshot)
+{
+    HildonTouchSelectorSnapshot *snapshot, *parsed;
+    gchar *string;
+
+    hildon_touch_selector_set_active (selector, 0, 2);
+
+    /* Test 1: serializing. */
+    snapshot = hildon_touch_selector_get_snapshot (selector);
+    string = hildon_touch_selector_snapshot_to_string (snapshot);
+    fail_if (strcmp (string, "2;") != 0,
+             "hildon-picker-button: snapshot serialized as `%s'.", string);
+
+    /* Test 2: restoring a parsed snapshot. */
+    parsed = hildon_touch_selector_snapshot_new_from_string (string);
+    fail_if (parsed == NULL,
+             "hildon-picker-button: could not parse snapshot `%s'.", string);
+    hildon_touch_selector_set_active (selector, 0, 0);
+    fail_if (!hildon_touch_selector_apply_snapshot (selector, parsed),
+             "hildon-picker-button: snapshot could not be applied.");
+    fail_if (hildon_touch_selector_get_active (selector, 0) != 2,
+             "hildon-picker-button: snapshot restored row %d instead of 2.",
+             hildon_touch_selector_get_active (selector, 0));
+
+    /* Test 3: malformed strings. */
+    fail_if (hildon_touch_selector_snapshot_new_from_string ("1,;") != NULL ||
+             hildon_touch_selector_snapshot_new_from_string ("1") != NULL ||
+             hildon_touch_selector_snapshot_new_from_string ("a;") != NULL,
+             "hildon-picker-button: malformed snapshots were accepted.");
+
+    g_free (string);
+    hildon_touch_selector_snapshot_free (snapshot);
+    hildon_touch_selector_snapshot_free (parsed);
+}
+END_TEST
+
 Suite *create_hildon_picker_button_suite (void)
 {
     Suite *s = suite_create ("HildonPickerButton");
@@ -117,6 +211,8 @@ Suite *create_hildon_picker_button_suite (void)
     TCase *tc1 = tcase_create ("hildon_picker_button");
     tcase_add_checked_fixture (tc1, fx_setup, fx_teardown);
     tcase_add_test (tc1, test_hildon_picker_button_value);
+    tcase_add_test (tc1, test_hildon_picker_button_freeze_changed);
+    tcase_add_test (tc1, test_hildon_picker_button_snapshot);
     suite_add_tcase (s, tc1);
 
     return s;
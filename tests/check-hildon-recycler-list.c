@@ -0,0 +1,305 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include "test_suites.h"
+#include "check_utils.h"
+#include <hildon/hildon.h>
+
+#define N_ROWS      1000
+#define ROW_HEIGHT  20
+#define VIEW_HEIGHT 200
+
+static GtkWidget *window = NULL;
+static GtkListStore *store = NULL;
+static HildonRecyclerList *list = NULL;
+static gint created = 0;
+static gint bound = 0;
+
+static GtkWidget *
+create_row (HildonRecyclerList *list,
+            gpointer            data)
+{
+    created++;
+
+    return gtk_label_new (NULL);
+}
+
+static void
+bind_row (HildonRecyclerList *list,
+          GtkWidget          *row,
+          GtkTreeModel       *model,
+          GtkTreeIter        *iter,
+          gpointer            data)
+{
+    gchar *text;
+
+    bound++;
+
+    gtk_tree_model_get (model, iter, 0, &text, -1);
+    gtk_label_set_text (GTK_LABEL (row), text);
+    g_free (text);
+}
+
+static void
+process_events (void)
+{
+    while (gtk_events_pending ())
+        gtk_main_iteration ();
+}
+
+static void
+fx_setup_default_recycler_list ()
+{
+    int argc = 0;
+    GtkWidget *scroller;
+    gint i;
+
+    gtk_init (&argc, NULL);
+
+    store = gtk_list_store_new (1, G_TYPE_STRING);
+    for (i = 0; i < N_ROWS; i++) {
+        gchar *text = g_strdup_printf ("Row %d", i);
+
+        gtk_list_store_insert_with_values (store, NULL, -1, 0, text, -1);
+        g_free (text);
+    }
+
+    created = bound = 0;
+    list = HILDON_RECYCLER_LIST (hildon_recycler_list_new (GTK_TREE_MODEL (store),
+                                                            ROW_HEIGHT));
+    hildon_recycler_list_set_row_funcs (list, create_row, bind_row, NULL, NULL);
+
+    scroller = gtk_scrolled_window_new (NULL, NULL);
+    gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scroller),
+                                    GTK_POLICY_NEVER, GTK_POLICY_ALWAYS);
+    gtk_widget_set_size_request (scroller, 200, VIEW_HEIGHT);
+    gtk_container_add (GTK_CONTAINER (scroller), GTK_WIDGET (list));
+
+    window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+    gtk_container_add (GTK_CONTAINER (window), scroller);
+    show_all_test_window (window);
+}
+
+static void
+fx_teardown_default_recycler_list ()
+{
+    gtk_widget_destroy (window);
+    g_object_unref (store);
+}
+
+/* Returns the text shown for the row at @index, or NULL if the row has
+ * no widget */
+static const gchar *
+row_text (gint index)
+{
+    GtkTreePath *path = gtk_tree_path_new_from_indices (index, -1);
+    GtkWidget *row = hildon_recycler_list_get_row_widget (list, path);
+
+    gtk_tree_path_free (path);
+
+    return row ? gtk_label_get_text (GTK_LABEL (row)) : NULL;
+}
+
+static void
+scroll_to_row (gint index)
+{
+    GtkAdjustment *vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (list));
+
+    gtk_adjustment_set_value (vadjustment, index * ROW_HEIGHT);
+    process_events ();
+}
+
+/* ----- Test case for the row widgets ----- */
+
+/**
+   Purpose: test that only the rows near the viewport get a widget,
+   and that they show the right rows.
+
+   Checks for:
+
+   - Far fewer widgets than rows are created.
+   - The first rows are bound to their model rows.
+   - A row far outside the viewport has no widget.
+
+*/
+START_TEST (test_hildon_recycler_list_viewport_rows)
+{
+    const gchar *text;
+
+    fail_if (created == 0,
+             "hildon-recycler-list: No row widget was created");
+    fail_if (created > VIEW_HEIGHT / ROW_HEIGHT + 10,
+             "hildon-recycler-list: %d row widgets were created for a %d rows viewport",
+             created, VIEW_HEIGHT / ROW_HEIGHT);
+
+    text = row_text (0);
+    fail_if (text == NULL || strcmp (text, "Row 0") != 0,
+             "hildon-recycler-list: The first row shows \"%s\"", text);
+
+    text = row_text (5);
+    fail_if (text == NULL || strcmp (text, "Row 5") != 0,
+             "hildon-recycler-list: The sixth row shows \"%s\"", text);
+
+    fail_if (row_text (N_ROWS / 2) != NULL,
+             "hildon-recycler-list: A row far from the viewport has a widget");
+}
+END_TEST
+
+/**
+   Purpose: test that scrolling reuses the row widgets.
+
+   Checks for:
+
+   - No widget is created when scrolling.
+   - The rows in the new viewport are bound to their model rows.
+   - The rows that left the viewport no longer have a widget.
+
+*/
+START_TEST (test_hildon_recycler_list_scroll)
+{
+    gint before = created;
+    const gchar *text;
+
+    scroll_to_row (N_ROWS / 2);
+
+    fail_if (created != before,
+             "hildon-recycler-list: Scrolling created %d row widgets", created - before);
+
+    text = row_text (N_ROWS / 2);
+    fail_if (text == NULL || strcmp (text, "Row 500") != 0,
+             "hildon-recycler-list: The scrolled to row shows \"%s\"", text);
+
+    fail_if (row_text (0) != NULL,
+             "hildon-recycler-list: A row scrolled out of view still has a widget");
+
+    scroll_to_row (N_ROWS);
+    text = row_text (N_ROWS - 1);
+    fail_if (text == NULL || strcmp (text, "Row 999") != 0,
+             "hildon-recycler-list: The last row shows \"%s\"", text);
+}
+END_TEST
+
+/**
+   Purpose: test that the row widgets follow the changes of the model.
+
+   Checks for:
+
+   - A changed row in the viewport is bound again.
+   - A changed row outside the viewport isn't bound.
+   - Appended and removed rows change the natural height.
+
+*/
+START_TEST (test_hildon_recycler_list_model_changes)
+{
+    GtkTreeIter iter;
+    gint before, natural;
+    const gchar *text;
+
+    gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 1);
+    gtk_list_store_set (store, &iter, 0, "Changed", -1);
+
+    text = row_text (1);
+    fail_if (text == NULL || strcmp (text, "Changed") != 0,
+             "hildon-recycler-list: A changed row shows \"%s\"", text);
+
+    before = bound;
+    gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, N_ROWS / 2);
+    gtk_list_store_set (store, &iter, 0, "Changed", -1);
+    fail_if (bound != before,
+             "hildon-recycler-list: A row outside the viewport was bound");
+
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, "Appended", -1);
+    gtk_widget_get_preferred_height (GTK_WIDGET (list), NULL, &natural);
+    fail_if (natural != (N_ROWS + 1) * ROW_HEIGHT,
+             "hildon-recycler-list: The natural height is %d after an append", natural);
+
+    gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+    gtk_list_store_remove (store, &iter);
+    gtk_list_store_remove (store, &iter);
+    gtk_widget_get_preferred_height (GTK_WIDGET (list), NULL, &natural);
+    fail_if (natural != (N_ROWS - 1) * ROW_HEIGHT,
+             "hildon-recycler-list: The natural height is %d after two removals", natural);
+
+    process_events ();
+    text = row_text (0);
+    fail_if (text == NULL || strcmp (text, "Row 2") != 0,
+             "hildon-recycler-list: The first row shows \"%s\" after two removals", text);
+}
+END_TEST
+
+/**
+   Purpose: test the model and row-height properties.
+
+   Checks for:
+
+   - get_model returns the model set.
+   - get_row_height returns the height set.
+   - A new row height changes the natural height.
+   - A NULL model removes every row widget.
+
+*/
+START_TEST (test_hildon_recycler_list_properties)
+{
+    gint natural;
+
+    fail_if (hildon_recycler_list_get_model (list) != GTK_TREE_MODEL (store),
+             "hildon-recycler-list: get_model doesn't return the model");
+    fail_if (hildon_recycler_list_get_row_height (list) != ROW_HEIGHT,
+             "hildon-recycler-list: get_row_height doesn't return the row height");
+
+    hildon_recycler_list_set_row_height (list, ROW_HEIGHT * 2);
+    fail_if (hildon_recycler_list_get_row_height (list) != ROW_HEIGHT * 2,
+             "hildon-recycler-list: The row height was not changed");
+    gtk_widget_get_preferred_height (GTK_WIDGET (list), NULL, &natural);
+    fail_if (natural != N_ROWS * ROW_HEIGHT * 2,
+             "hildon-recycler-list: The natural height is %d for a doubled row height",
+             natural);
+
+    hildon_recycler_list_set_model (list, NULL);
+    process_events ();
+    fail_if (hildon_recycler_list_get_model (list) != NULL,
+             "hildon-recycler-list: The model was not unset");
+    fail_if (row_text (0) != NULL,
+             "hildon-recycler-list: A row has a widget without a model");
+}
+END_TEST
+
+/* ---------- Suite creation ---------- */
+
+Suite *create_hildon_recycler_list_suite (void)
+{
+    Suite *s = suite_create ("HildonRecyclerList");
+
+    TCase *tc1 = tcase_create ("hildon_recycler_list_rows");
+    tcase_add_checked_fixture (tc1, fx_setup_default_recycler_list,
+                               fx_teardown_default_recycler_list);
+    tcase_add_test (tc1, test_hildon_recycler_list_viewport_rows);
+    tcase_add_test (tc1, test_hildon_recycler_list_scroll);
+    tcase_add_test (tc1, test_hildon_recycler_list_model_changes);
+    tcase_add_test (tc1, test_hildon_recycler_list_properties);
+    suite_add_tcase (s, tc1);
+
+    return s;
+}
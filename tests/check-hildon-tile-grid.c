@@ -0,0 +1,333 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <check.h>
+#include "test_suites.h"
+#include "check_utils.h"
+#include <hildon/hildon.h>
+
+#define N_ITEMS     25
+#define TILE_WIDTH  100
+#define TILE_HEIGHT 50
+
+static GtkWidget *window = NULL;
+static GtkListStore *store = NULL;
+static HildonTileGrid *grid = NULL;
+
+static void
+process_events (void)
+{
+    while (gtk_events_pending ())
+        gtk_main_iteration ();
+}
+
+static void
+fx_setup_default_tile_grid ()
+{
+    int argc = 0;
+    GtkWidget *scroller;
+    gint i;
+
+    gtk_init (&argc, NULL);
+
+    store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
+    for (i = 0; i < N_ITEMS; i++) {
+        gchar *text = g_strdup_printf ("Item %d", i);
+
+        gtk_list_store_insert_with_values (store, NULL, -1, 1, text, -1);
+        g_free (text);
+    }
+
+    grid = HILDON_TILE_GRID (hildon_tile_grid_new (GTK_TREE_MODEL (store),
+                                                   TILE_WIDTH, TILE_HEIGHT));
+
+    scroller = gtk_scrolled_window_new (NULL, NULL);
+    gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scroller),
+                                    GTK_POLICY_NEVER, GTK_POLICY_ALWAYS);
+    gtk_widget_set_size_request (scroller, 3 * TILE_WIDTH + 50, 4 * TILE_HEIGHT);
+    gtk_container_add (GTK_CONTAINER (scroller), GTK_WIDGET (grid));
+
+    window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+    gtk_container_add (GTK_CONTAINER (window), scroller);
+    show_all_test_window (window);
+}
+
+static void
+fx_teardown_default_tile_grid ()
+{
+    gtk_widget_destroy (window);
+    g_object_unref (store);
+}
+
+/* The tiles in a row, for the width the grid was given */
+static gint
+n_columns (void)
+{
+    return MAX (1, gtk_widget_get_allocated_width (GTK_WIDGET (grid)) / TILE_WIDTH);
+}
+
+/* The width of a column, tiles are centered in theirs */
+static gint
+cell_width (void)
+{
+    return gtk_widget_get_allocated_width (GTK_WIDGET (grid)) / n_columns ();
+}
+
+/* Index of the item at @x, @y, or -1 */
+static gint
+index_at_pos (gint x, gint y)
+{
+    GtkTreePath *path = hildon_tile_grid_get_path_at_pos (grid, x, y);
+    gint index;
+
+    if (path == NULL)
+        return -1;
+
+    index = gtk_tree_path_get_indices (path)[0];
+    gtk_tree_path_free (path);
+
+    return index;
+}
+
+static void
+send_button_event (GdkEventType type, gint x, gint y)
+{
+    GdkEvent *event = gdk_event_new (type);
+
+    event->button.window = g_object_ref (gtk_widget_get_window (GTK_WIDGET (grid)));
+    event->button.button = 1;
+    event->button.x = x;
+    event->button.y = y;
+    gtk_widget_event (GTK_WIDGET (grid), event);
+    gdk_event_free (event);
+}
+
+static void
+item_activated (HildonTileGrid *grid,
+                GtkTreePath    *path,
+                gint           *activated)
+{
+    *activated = gtk_tree_path_get_indices (path)[0];
+}
+
+/* ----- Test case for the tile layout ----- */
+
+/**
+   Purpose: test that the items are laid out in rows of tiles.
+
+   Checks for:
+
+   - The column of the first row maps to the first items.
+   - A point in a later row maps to the item of that row and column.
+   - A point past the last item, or outside the grid, maps to no item.
+   - The natural height has one tile per row of items.
+
+*/
+START_TEST (test_hildon_tile_grid_layout)
+{
+    gint columns = n_columns ();
+    gint last_row = (N_ITEMS - 1) / columns;
+    gint width = gtk_widget_get_allocated_width (GTK_WIDGET (grid));
+    gint cell = cell_width ();
+    gint natural;
+
+    fail_if (columns < 2,
+             "hildon-tile-grid: The grid has %d columns", columns);
+
+    fail_if (index_at_pos (0, 0) != 0,
+             "hildon-tile-grid: The first tile is not at the origin");
+    fail_if (index_at_pos (cell + cell / 2, 0) != 1,
+             "hildon-tile-grid: The second tile is not next to the first");
+    fail_if (index_at_pos (cell + cell / 2, TILE_HEIGHT + 10) != columns + 1,
+             "hildon-tile-grid: The tiles of the second row are misplaced");
+    fail_if (index_at_pos (cell / 2, last_row * TILE_HEIGHT + 10) != last_row * columns,
+             "hildon-tile-grid: The tiles of the last row are misplaced");
+
+    fail_if (index_at_pos (cell / 2, (last_row + 1) * TILE_HEIGHT + 10) >= 0,
+             "hildon-tile-grid: A point past the last item maps to an item");
+    fail_if (index_at_pos (-1, 0) >= 0,
+             "hildon-tile-grid: A point outside the grid maps to an item");
+
+    gtk_widget_get_preferred_height_for_width (GTK_WIDGET (grid), width, NULL, &natural);
+    fail_if (natural != (last_row + 1) * TILE_HEIGHT,
+             "hildon-tile-grid: The natural height is %d for %d rows", natural, last_row + 1);
+}
+END_TEST
+
+/**
+   Purpose: test that scrolling moves the tiles under the points.
+
+   Checks for:
+
+   - After scrolling two rows down, the origin maps to the first item
+     of the third row.
+
+*/
+START_TEST (test_hildon_tile_grid_scroll)
+{
+    GtkAdjustment *vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (grid));
+
+    gtk_adjustment_set_value (vadjustment, 2 * TILE_HEIGHT);
+    process_events ();
+
+    fail_if (index_at_pos (0, 0) != 2 * n_columns (),
+             "hildon-tile-grid: The origin maps to item %d after scrolling",
+             index_at_pos (0, 0));
+}
+END_TEST
+
+/**
+   Purpose: test that the grid follows the changes of the model.
+
+   Checks for:
+
+   - Appended items add rows to the natural height.
+   - Removed items take them away again.
+
+*/
+START_TEST (test_hildon_tile_grid_model_changes)
+{
+    gint columns = n_columns ();
+    gint width = gtk_widget_get_allocated_width (GTK_WIDGET (grid));
+    gint n_items = N_ITEMS + columns;
+    gint natural, i;
+
+    for (i = 0; i < columns; i++)
+        gtk_list_store_insert_with_values (store, NULL, -1, 1, "Appended", -1);
+
+    gtk_widget_get_preferred_height_for_width (GTK_WIDGET (grid), width, NULL, &natural);
+    fail_if (natural != (n_items + columns - 1) / columns * TILE_HEIGHT,
+             "hildon-tile-grid: The natural height is %d after an append", natural);
+
+    gtk_list_store_clear (store);
+
+    gtk_widget_get_preferred_height_for_width (GTK_WIDGET (grid), width, NULL, &natural);
+    fail_if (natural != 0,
+             "hildon-tile-grid: The natural height is %d without items", natural);
+
+    process_events ();
+    fail_if (index_at_pos (0, 0) >= 0,
+             "hildon-tile-grid: A point maps to an item of an empty model");
+}
+END_TEST
+
+/**
+   Purpose: test that a tap on a tile activates its item.
+
+   Checks for:
+
+   - A press and a release on the same tile emit item-activated.
+   - A release on another tile doesn't.
+
+*/
+START_TEST (test_hildon_tile_grid_item_activated)
+{
+    gint cell = cell_width ();
+    gint activated = -1;
+
+    g_signal_connect (grid, "item-activated", G_CALLBACK (item_activated), &activated);
+
+    send_button_event (GDK_BUTTON_PRESS, cell + cell / 2, 10);
+    send_button_event (GDK_BUTTON_RELEASE, cell + cell / 2 + 5, 20);
+    fail_if (activated != 1,
+             "hildon-tile-grid: A tap on the second tile activated item %d", activated);
+
+    activated = -1;
+    send_button_event (GDK_BUTTON_PRESS, cell / 2, 10);
+    send_button_event (GDK_BUTTON_RELEASE, cell + cell / 2, TILE_HEIGHT + 10);
+    fail_if (activated != -1,
+             "hildon-tile-grid: A press and a release on different tiles activated item %d",
+             activated);
+}
+END_TEST
+
+/**
+   Purpose: test the accessors of the grid.
+
+   Checks for:
+
+   - The model, tile size, columns and thumbnail loader set are returned.
+   - The columns default to -1.
+
+*/
+START_TEST (test_hildon_tile_grid_properties)
+{
+    HildonThumbnailLoader *loader;
+    gint width, height;
+
+    fail_if (hildon_tile_grid_get_model (grid) != GTK_TREE_MODEL (store),
+             "hildon-tile-grid: get_model doesn't return the model");
+
+    hildon_tile_grid_get_tile_size (grid, &width, &height);
+    fail_if (width != TILE_WIDTH || height != TILE_HEIGHT,
+             "hildon-tile-grid: The tile size is %dx%d", width, height);
+
+    hildon_tile_grid_set_tile_size (grid, TILE_WIDTH / 2, TILE_HEIGHT * 2);
+    hildon_tile_grid_get_tile_size (grid, &width, &height);
+    fail_if (width != TILE_WIDTH / 2 || height != TILE_HEIGHT * 2,
+             "hildon-tile-grid: The tile size is %dx%d after a change", width, height);
+
+    fail_if (hildon_tile_grid_get_filename_column (grid) != -1 ||
+             hildon_tile_grid_get_text_column (grid) != -1,
+             "hildon-tile-grid: The columns are set by default");
+
+    hildon_tile_grid_set_filename_column (grid, 0);
+    hildon_tile_grid_set_text_column (grid, 1);
+    fail_if (hildon_tile_grid_get_filename_column (grid) != 0,
+             "hildon-tile-grid: The filename column was not set");
+    fail_if (hildon_tile_grid_get_text_column (grid) != 1,
+             "hildon-tile-grid: The text column was not set");
+
+    loader = hildon_thumbnail_loader_new (TILE_HEIGHT, 1024 * 1024);
+    hildon_tile_grid_set_thumbnail_loader (grid, loader);
+    fail_if (hildon_tile_grid_get_thumbnail_loader (grid) != loader,
+             "hildon-tile-grid: The thumbnail loader was not set");
+    process_events ();
+
+    hildon_tile_grid_set_thumbnail_loader (grid, NULL);
+    g_object_unref (loader);
+
+    hildon_tile_grid_set_model (grid, NULL);
+    fail_if (hildon_tile_grid_get_model (grid) != NULL,
+             "hildon-tile-grid: The model was not unset");
+}
+END_TEST
+
+/* ---------- Suite creation ---------- */
+
+Suite *create_hildon_tile_grid_suite (void)
+{
+    Suite *s = suite_create ("HildonTileGrid");
+
+    TCase *tc1 = tcase_create ("hildon_tile_grid_tiles");
+    tcase_add_checked_fixture (tc1, fx_setup_default_tile_grid,
+                               fx_teardown_default_tile_grid);
+    tcase_add_test (tc1, test_hildon_tile_grid_layout);
+    tcase_add_test (tc1, test_hildon_tile_grid_scroll);
+    tcase_add_test (tc1, test_hildon_tile_grid_model_changes);
+    tcase_add_test (tc1, test_hildon_tile_grid_item_activated);
+    tcase_add_test (tc1, test_hildon_tile_grid_properties);
+    suite_add_tcase (s, tc1);
+
+    return s;
+}
@@ -0,0 +1,462 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include "test_suites.h"
+#include "check_utils.h"
+#include <hildon/hildon.h>
+
+static HildonTouchSelector *selector = NULL;
+static GtkTreeModel *model = NULL;
+
+static void
+fx_setup ()
+{
+    int argc = 0;
+
+    gtk_init (&argc, NULL);
+
+    selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text_sorted ());
+    g_object_ref_sink (selector);
+
+    model = hildon_touch_selector_get_model (selector, 0);
+}
+
+static void
+fx_setup_compact ()
+{
+    int argc = 0;
+
+    gtk_init (&argc, NULL);
+
+    selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text_compact ());
+    g_object_ref_sink (selector);
+
+    model = hildon_touch_selector_get_model (selector, 0);
+}
+
+static void
+fx_teardown ()
+{
+    gtk_widget_destroy (GTK_WIDGET (selector));
+    g_object_unref (selector);
+}
+
+/* Checks that the rows of the model are @expected, in that order */
+static void
+check_rows (const gchar * const *expected)
+{
+    GtkTreeIter iter;
+    gboolean valid;
+    gint i;
+
+    valid = gtk_tree_model_get_iter_first (model, &iter);
+    for (i = 0; expected[i] != NULL; i++) {
+        gchar *text;
+
+        fail_if (!valid,
+                 "hildon-touch-selector: Row %d (%s) is missing", i, expected[i]);
+
+        gtk_tree_model_get (model, &iter, 0, &text, -1);
+        fail_if (strcmp (text, expected[i]) != 0,
+                 "hildon-touch-selector: Row %d is %s instead of %s",
+                 i, text, expected[i]);
+        g_free (text);
+
+        valid = gtk_tree_model_iter_next (model, &iter);
+    }
+
+    fail_if (valid, "hildon-touch-selector: There are more than %d rows", i);
+}
+
+static void
+row_inserted_cb (GtkTreeModel *tree_model,
+                 GtkTreePath  *path,
+                 GtkTreeIter  *iter,
+                 gpointer      data)
+{
+    *(gint *) data = gtk_tree_path_get_indices (path)[0];
+}
+
+static void
+count_rows_cb (GtkTreeModel *tree_model,
+               GtkTreePath  *path,
+               GtkTreeIter  *iter,
+               gpointer      data)
+{
+    (*(gint *) data)++;
+}
+
+static void
+rows_reordered_cb (GtkTreeModel *tree_model,
+                   GtkTreePath  *path,
+                   GtkTreeIter  *iter,
+                   gint         *new_order,
+                   gpointer      data)
+{
+    gint n_rows = gtk_tree_model_iter_n_children (tree_model, NULL);
+    gint *copy = g_new (gint, n_rows);
+
+    memcpy (copy, new_order, n_rows * sizeof (gint));
+    *(gint **) data = copy;
+}
+
+/**
+   Purpose: test that a sorted text selector keeps its rows in
+   collation order.
+
+   Checks for:
+
+   - Appending texts one by one sorts them.
+   - The position given to hildon_touch_selector_insert_text() and
+     hildon_touch_selector_prepend_text() is ignored.
+
+*/
+START_TEST (test_hildon_touch_selector_sorted_order)
+{
+    const gchar *expected[] = { "apple", "banana", "cherry", "damson", NULL };
+
+    hildon_touch_selector_append_text (selector, "cherry");
+    hildon_touch_selector_append_text (selector, "apple");
+    hildon_touch_selector_insert_text (selector, 0, "damson");
+    hildon_touch_selector_prepend_text (selector, "banana");
+
+    check_rows (expected);
+}
+END_TEST
+
+/**
+   Purpose: test that rows with the same text stay in the order they
+   were added.
+
+   Checks for:
+
+   - A text equal to an existing one is inserted after it, whatever
+     position is asked for.
+
+*/
+START_TEST (test_hildon_touch_selector_sorted_stable)
+{
+    const gchar *expected[] = { "a", "b", "b", "c", NULL };
+    gint position = -1;
+
+    hildon_touch_selector_append_text (selector, "c");
+    hildon_touch_selector_append_text (selector, "b");
+    hildon_touch_selector_append_text (selector, "a");
+
+    g_signal_connect (model, "row-inserted", G_CALLBACK (row_inserted_cb), &position);
+    hildon_touch_selector_insert_text (selector, 0, "b");
+    g_signal_handlers_disconnect_by_func (model, row_inserted_cb, &position);
+
+    fail_if (position != 2,
+             "hildon-touch-selector: The second \"b\" was inserted at %d instead of 2",
+             position);
+
+    check_rows (expected);
+}
+END_TEST
+
+/**
+   Purpose: test that appending an array to a sorted selector merges
+   it with the rows it already has.
+
+   Checks for:
+
+   - Every new row is announced as appended, then a single reorder
+     moves the rows to their sorted positions.
+   - Existing rows come before the new rows with the same text.
+
+*/
+START_TEST (test_hildon_touch_selector_sorted_merge)
+{
+    const gchar *texts[] = { "b", "a", NULL };
+    const gchar *expected[] = { "a", "a", "b", "b", "c", NULL };
+    /* After the append the rows are a, b, c, b, a */
+    const gint expected_order[] = { 0, 4, 1, 3, 2 };
+    gint *new_order = NULL;
+    gint position = -1;
+    gint i;
+
+    hildon_touch_selector_append_text (selector, "c");
+    hildon_touch_selector_append_text (selector, "a");
+    hildon_touch_selector_append_text (selector, "b");
+
+    g_signal_connect (model, "row-inserted", G_CALLBACK (row_inserted_cb), &position);
+    g_signal_connect (model, "rows-reordered", G_CALLBACK (rows_reordered_cb), &new_order);
+    hildon_touch_selector_append_text_array (selector, texts, -1);
+    g_signal_handlers_disconnect_by_func (model, row_inserted_cb, &position);
+    g_signal_handlers_disconnect_by_func (model, rows_reordered_cb, &new_order);
+
+    fail_if (position != 4,
+             "hildon-touch-selector: The last new row was announced at %d instead of 4",
+             position);
+    fail_if (new_order == NULL,
+             "hildon-touch-selector: The rows were not reordered");
+
+    for (i = 0; i < (gint) G_N_ELEMENTS (expected_order); i++)
+        fail_if (new_order[i] != expected_order[i],
+                 "hildon-touch-selector: Row %d comes from row %d instead of %d",
+                 i, new_order[i], expected_order[i]);
+    g_free (new_order);
+
+    check_rows (expected);
+}
+END_TEST
+
+/**
+   Purpose: test that appending to a shown sorted text selector keeps
+   its selection on the same row.
+
+   Checks for:
+
+   - The selected row is still selected after new rows are merged in
+     before it.
+   - The new rows are not selected.
+
+*/
+START_TEST (test_hildon_touch_selector_sorted_append_selected)
+{
+    const gchar *texts[] = { "b", NULL };
+    gchar *text;
+    gint active;
+
+    hildon_touch_selector_append_text (selector, "a");
+    hildon_touch_selector_append_text (selector, "c");
+
+    /* Centering gives the model to the tree view of the column */
+    hildon_touch_selector_center_on_index (selector, 0, 0);
+    hildon_touch_selector_set_active (selector, 0, 1);
+
+    hildon_touch_selector_append_text_array (selector, texts, -1);
+
+    active = hildon_touch_selector_get_active (selector, 0);
+    fail_if (active != 2,
+             "hildon-touch-selector: Row %d is active instead of 2", active);
+
+    text = hildon_touch_selector_get_current_text (selector);
+    fail_if (g_strcmp0 (text, "c") != 0,
+             "hildon-touch-selector: The active row shows \"%s\" instead of \"c\"",
+             text);
+    g_free (text);
+}
+END_TEST
+
+/**
+   Purpose: test that a compact text selector keeps its rows in the
+   order they were added.
+
+   Checks for:
+
+   - Appended, prepended and inserted texts are at their positions.
+   - Each new row is announced at its position.
+   - The model has a single string column.
+
+*/
+START_TEST (test_hildon_touch_selector_compact_order)
+{
+    const gchar *expected[] = { "banana", "damson", "apple", "cherry", NULL };
+    gint position = -1;
+
+    fail_if (gtk_tree_model_get_n_columns (model) != 1 ||
+             gtk_tree_model_get_column_type (model, 0) != G_TYPE_STRING,
+             "hildon-touch-selector: The compact model doesn't have a string column");
+    fail_if (!(gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY),
+             "hildon-touch-selector: The compact model is not a list");
+
+    hildon_touch_selector_append_text (selector, "apple");
+    hildon_touch_selector_append_text (selector, "cherry");
+
+    g_signal_connect (model, "row-inserted", G_CALLBACK (row_inserted_cb), &position);
+    hildon_touch_selector_prepend_text (selector, "banana");
+    fail_if (position != 0,
+             "hildon-touch-selector: A prepended row was announced at %d", position);
+    hildon_touch_selector_insert_text (selector, 1, "damson");
+    fail_if (position != 1,
+             "hildon-touch-selector: A row inserted at 1 was announced at %d", position);
+    g_signal_handlers_disconnect_by_func (model, row_inserted_cb, &position);
+
+    check_rows (expected);
+}
+END_TEST
+
+/**
+   Purpose: test that arrays of texts are appended to a compact text
+   selector in order.
+
+   Checks for:
+
+   - A %NULL-terminated array and an array with a length are appended.
+   - Only the given number of texts is appended.
+   - Each appended row is announced.
+
+*/
+START_TEST (test_hildon_touch_selector_compact_array)
+{
+    const gchar *texts[] = { "c", "b", "a", NULL };
+    const gchar *expected[] = { "c", "b", "a", "c", "b", NULL };
+    gint n_inserted = 0;
+
+    g_signal_connect (model, "row-inserted", G_CALLBACK (count_rows_cb), &n_inserted);
+    hildon_touch_selector_append_text_array (selector, texts, -1);
+    hildon_touch_selector_append_text_array (selector, texts, 2);
+    g_signal_handlers_disconnect_by_func (model, count_rows_cb, &n_inserted);
+
+    fail_if (n_inserted != 5,
+             "hildon-touch-selector: %d rows were announced instead of 5", n_inserted);
+
+    check_rows (expected);
+}
+END_TEST
+
+/**
+   Purpose: test that a compact text selector holds many rows.
+
+   Checks for:
+
+   - Every row keeps its text after the store grows.
+   - An iter stays valid when rows are appended.
+   - The text of the active row is returned.
+
+*/
+START_TEST (test_hildon_touch_selector_compact_many)
+{
+    GtkTreeIter iter;
+    gchar *text;
+    gint i;
+
+    for (i = 0; i < 1000; i++) {
+        text = g_strdup_printf ("Row %d", i);
+        hildon_touch_selector_append_text (selector, text);
+        g_free (text);
+    }
+
+    fail_if (!gtk_tree_model_iter_nth_child (model, &iter, NULL, 10),
+             "hildon-touch-selector: Row 10 is missing");
+
+    for (i = 1000; i < 5000; i++) {
+        text = g_strdup_printf ("Row %d", i);
+        hildon_touch_selector_append_text (selector, text);
+        g_free (text);
+    }
+
+    fail_if (gtk_tree_model_iter_n_children (model, NULL) != 5000,
+             "hildon-touch-selector: The compact model has %d rows instead of 5000",
+             gtk_tree_model_iter_n_children (model, NULL));
+
+    gtk_tree_model_get (model, &iter, 0, &text, -1);
+    fail_if (g_strcmp0 (text, "Row 10") != 0,
+             "hildon-touch-selector: An iter shows \"%s\" after an append", text);
+    g_free (text);
+
+    fail_if (!gtk_tree_model_iter_nth_child (model, &iter, NULL, 4999),
+             "hildon-touch-selector: Row 4999 is missing");
+    gtk_tree_model_get (model, &iter, 0, &text, -1);
+    fail_if (g_strcmp0 (text, "Row 4999") != 0,
+             "hildon-touch-selector: The last row is \"%s\"", text);
+    g_free (text);
+
+    hildon_touch_selector_set_active (selector, 0, 2500);
+    text = hildon_touch_selector_get_current_text (selector);
+    fail_if (g_strcmp0 (text, "Row 2500") != 0,
+             "hildon-touch-selector: The active row shows \"%s\" instead of \"Row 2500\"",
+             text);
+    g_free (text);
+}
+END_TEST
+
+static gchar *
+virtual_row_text (gint row, gpointer data)
+{
+    return g_strdup_printf ("Row %d", row);
+}
+
+/**
+   Purpose: test that a virtual column keeps its selection when live
+   search is turned on.
+
+   Checks for:
+
+   - The active row of a virtual column can be set and read back.
+   - Turning live search on keeps the active row and its text.
+
+*/
+START_TEST (test_hildon_touch_selector_virtual_live_search)
+{
+    HildonTouchSelector *virtual;
+    gchar *text;
+
+    virtual = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new ());
+    g_object_ref_sink (virtual);
+
+    hildon_touch_selector_append_virtual_column (virtual, 1000, virtual_row_text,
+                                                 NULL, NULL, FALSE);
+    hildon_touch_selector_set_active (virtual, 0, 500);
+
+    fail_if (hildon_touch_selector_get_active (virtual, 0) != 500,
+             "hildon-touch-selector: The virtual column did not select row 500");
+
+    hildon_touch_selector_set_live_search (virtual, TRUE);
+
+    fail_if (hildon_touch_selector_get_active (virtual, 0) != 500,
+             "hildon-touch-selector: Live search lost the selection of the virtual column");
+
+    text = hildon_touch_selector_get_current_text (virtual);
+    fail_if (g_strcmp0 (text, "Row 500") != 0,
+             "hildon-touch-selector: The virtual column shows \"%s\" instead of \"Row 500\"",
+             text);
+    g_free (text);
+
+    gtk_widget_destroy (GTK_WIDGET (virtual));
+    g_object_unref (virtual);
+}
+END_TEST
+
+/* ---------- Suite creation ---------- */
+
+Suite *create_hildon_touch_selector_suite (void)
+{
+    Suite *s = suite_create ("HildonTouchSelector");
+
+    TCase *tc1 = tcase_create ("hildon_touch_selector_sorted");
+    tcase_add_checked_fixture (tc1, fx_setup, fx_teardown);
+    tcase_add_test (tc1, test_hildon_touch_selector_sorted_order);
+    tcase_add_test (tc1, test_hildon_touch_selector_sorted_stable);
+    tcase_add_test (tc1, test_hildon_touch_selector_sorted_merge);
+    tcase_add_test (tc1, test_hildon_touch_selector_sorted_append_selected);
+    suite_add_tcase (s, tc1);
+
+    TCase *tc2 = tcase_create ("hildon_touch_selector_virtual");
+    tcase_add_checked_fixture (tc2, fx_setup, fx_teardown);
+    tcase_add_test (tc2, test_hildon_touch_selector_virtual_live_search);
+    suite_add_tcase (s, tc2);
+
+    TCase *tc3 = tcase_create ("hildon_touch_selector_compact");
+    tcase_add_checked_fixture (tc3, fx_setup_compact, fx_teardown);
+    tcase_add_test (tc3, test_hildon_touch_selector_compact_order);
+    tcase_add_test (tc3, test_hildon_touch_selector_compact_array);
+    tcase_add_test (tc3, test_hildon_touch_selector_compact_many);
+    suite_add_tcase (s, tc3);
+
+    return s;
+}
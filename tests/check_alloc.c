@@ -0,0 +1,169 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+/*
+ * Allocation budgets of the check_test scenarios.
+ *
+ * When check_test runs with the allocation counter of
+ * check-alloc-shim.c preloaded ("make check-alloc"), the scenarios of
+ * check-hildon-alloc.c count the heap allocations they make and fail
+ * when they make more than recorded in alloc-budgets.ini, or when no
+ * budget is recorded for them. Setting
+ * HILDON_ALLOC_RECORD saves the counts as the new budgets instead;
+ * that is done after an allocation elimination lands, and the updated
+ * file is committed with it. HILDON_ALLOC_BUDGETS can point to another
+ * budget file.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+#include <check.h>
+
+#include "check_alloc.h"
+
+#define CHECK_ALLOC_GROUP "budgets"
+
+/* Each scenario is repeated, and the lowest count is kept, so that
+ * allocations made only once, like caches being filled, don't count */
+#define CHECK_ALLOC_RUNS 3
+
+/* Defined by the preloaded shim, if any. It is looked up at run time:
+ * a weak reference can be resolved to zero at link time and then never
+ * see the preloaded definition */
+static unsigned long *
+check_alloc_counter (void)
+{
+  static unsigned long *counter = NULL;
+  static gboolean looked_up = FALSE;
+
+  if (!looked_up)
+    {
+      counter = dlsym (RTLD_DEFAULT, "check_alloc_counter");
+      looked_up = TRUE;
+    }
+
+  return counter;
+}
+
+static gulong
+check_alloc_count (void)
+{
+  return __atomic_load_n (check_alloc_counter (), __ATOMIC_RELAXED);
+}
+
+static void
+flush_events (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+static const gchar *
+budgets_file (void)
+{
+  const gchar *file = g_getenv ("HILDON_ALLOC_BUDGETS");
+
+  return file ? file : ALLOC_BUDGETS_FILE;
+}
+
+/**
+ * Whether the allocation counter is preloaded
+ */
+gboolean
+check_alloc_enabled (void)
+{
+  return check_alloc_counter () != NULL;
+}
+
+/**
+ * Runs @func once to warm up, then returns the lowest number of
+ * allocations of CHECK_ALLOC_RUNS runs, idles run after it included
+ */
+gulong
+check_alloc_measure (CheckAllocFunc func,
+                     gpointer       data)
+{
+  gulong best = G_MAXULONG;
+  gint i;
+
+  func (data);
+  flush_events ();
+
+  for (i = 0; i < CHECK_ALLOC_RUNS; i++)
+    {
+      gulong before = check_alloc_count ();
+
+      func (data);
+      flush_events ();
+      best = MIN (best, check_alloc_count () - before);
+    }
+
+  return best;
+}
+
+/**
+ * Fails if @count is over the budget recorded for @scenario, or
+ * records it when HILDON_ALLOC_RECORD is set. A scenario with no
+ * budget fails
+ */
+void
+check_alloc_assert_budget (const gchar *scenario,
+                           gulong       count)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  GError *error = NULL;
+  gint64 budget;
+  gboolean recorded;
+
+  g_key_file_load_from_file (key_file, budgets_file (), G_KEY_FILE_KEEP_COMMENTS, NULL);
+
+  if (g_getenv ("HILDON_ALLOC_RECORD"))
+    {
+      g_key_file_set_int64 (key_file, CHECK_ALLOC_GROUP, scenario, count);
+      if (!g_key_file_save_to_file (key_file, budgets_file (), &error))
+        {
+          g_printerr ("%s: %s\n", budgets_file (), error->message);
+          g_error_free (error);
+        }
+      g_key_file_free (key_file);
+      return;
+    }
+
+  budget = g_key_file_get_int64 (key_file, CHECK_ALLOC_GROUP, scenario, &error);
+  g_key_file_free (key_file);
+  recorded = error == NULL;
+  g_clear_error (&error);
+
+  /* A scenario without a budget would never fail, so it must be
+     recorded before it is committed */
+  fail_if (!recorded,
+           "%s: %lu allocations, no budget in %s; record it with "
+           "HILDON_ALLOC_RECORD=1", scenario, count, budgets_file ());
+
+  fail_if (count > budget,
+           "%s: %lu allocations, the budget is %" G_GINT64_FORMAT,
+           scenario, count, budget);
+}
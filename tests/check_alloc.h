@@ -0,0 +1,37 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+#ifndef _CHECK_ALLOC_H_
+#define _CHECK_ALLOC_H_
+
+#include <glib.h>
+
+typedef void (*CheckAllocFunc) (gpointer data);
+
+gboolean check_alloc_enabled       (void);
+gulong   check_alloc_measure       (CheckAllocFunc func,
+                                    gpointer       data);
+void     check_alloc_assert_budget (const gchar   *scenario,
+                                    gulong         count);
+
+#endif
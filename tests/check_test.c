@@ -30,6 +30,7 @@
 #include <gconf/gconf-client.h>
 
 #include "test_suites.h"
+#include "check_alloc.h"
 
 /* Define environment checking results defines */
 #define ENVIRONMENT_X_ERROR       1
@@ -60,6 +61,15 @@ configure_tests(gint environment)
   srunner_add_suite(sr, create_hildon_window_suite());
   srunner_add_suite(sr, create_hildon_helper_suite());
   srunner_add_suite(sr, create_hildon_picker_button_suite());
+  srunner_add_suite(sr, create_hildon_touch_selector_suite());
+  srunner_add_suite(sr, create_hildon_app_menu_suite());
+  srunner_add_suite(sr, create_hildon_recycler_list_suite());
+  srunner_add_suite(sr, create_hildon_tile_grid_suite());
+
+  /* The allocation budgets are only checked with the counter preloaded,
+     see "make check-alloc" */
+  if (check_alloc_enabled ())
+    srunner_add_suite(sr, create_hildon_alloc_suite());
 
   /* Disable tests that need maemo environment to be up if it is not running */
   if (environment != ENVIRONMENT_MAEMO_ERROR)
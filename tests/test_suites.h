@@ -58,5 +58,10 @@ Suite *create_hildon_window_suite(void);
 Suite *create_hildon_program_suite(void);
 Suite *create_hildon_composite_widget_suite(void);
 Suite *create_hildon_picker_button_suite (void);
+Suite *create_hildon_touch_selector_suite (void);
+Suite *create_hildon_alloc_suite (void);
+Suite *create_hildon_app_menu_suite (void);
+Suite *create_hildon_recycler_list_suite (void);
+Suite *create_hildon_tile_grid_suite (void);
 
 #endif